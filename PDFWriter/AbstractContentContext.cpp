@@ -30,6 +30,7 @@
 #include "OutputStreamTraits.h"
 #include "IContentContextListener.h"
 #include "DocumentContext.h"
+#include "ObjectsContext.h"
 #include <ctype.h>
 #include <algorithm>
 
@@ -239,6 +240,9 @@ unsigned long AbstractContentContext::ColorValueForName(const std::string& inCol
 AbstractContentContext::AbstractContentContext(PDFHummus::DocumentContext* inDocumentContext)
 {
 	mDocumentContext = inDocumentContext;
+	// content uses the document real numbers precision
+	if(mDocumentContext && mDocumentContext->GetObjectsContext())
+		mPrimitiveWriter.SetDecimalPlaces(mDocumentContext->GetObjectsContext()->GetDecimalPlaces());
 }
 
 AbstractContentContext::~AbstractContentContext(void)
@@ -980,15 +984,14 @@ EStatusCode AbstractContentContext::WriteTextCommandWithEncoding(const std::stri
 		return PDFHummus::eFailure;
 	}
 
-	GlyphUnicodeMappingList glyphsAndUnicode;
-	EStatusCode encodingStatus = currentFont->TranslateStringToGlyphs(inUnicodeText,glyphsAndUnicode);
+	EStatusCode encodingStatus = currentFont->TranslateStringToGlyphs(inUnicodeText,mTextRun);
 
 	// encoding returns false if was unable to encode some of the glyphs. will display as missing characters
 	if(encodingStatus != PDFHummus::eSuccess)
 		TRACE_LOG("AbstractContextContext::WriteTextCommandWithEncoding, was unable to find glyphs for all characters, some will appear as missing");
 
 
-	return WriteTextCommandWithDirectGlyphSelection(glyphsAndUnicode,inTextCommand);
+	return WriteTextCommandWithDirectGlyphSelection(mTextRun,inTextCommand);
 }
 
 class TjCommand : public ITextCommand
@@ -1087,6 +1090,16 @@ EStatusCode AbstractContentContext::Tj(const GlyphUnicodeMappingList& inText)
 }
 
 EStatusCode AbstractContentContext::WriteTextCommandWithDirectGlyphSelection(const GlyphUnicodeMappingList& inText,ITextCommand* inTextCommand)
+{
+	GlyphRun glyphs;
+	GlyphUnicodeMappingList::const_iterator it = inText.begin();
+
+	for(; it != inText.end(); ++it)
+		glyphs.AddGlyph(*it);
+	return WriteTextCommandWithDirectGlyphSelection(glyphs,inTextCommand);
+}
+
+EStatusCode AbstractContentContext::WriteTextCommandWithDirectGlyphSelection(const GlyphRun& inText,ITextCommand* inTextCommand)
 {
 	PDFUsedFont* currentFont = mGraphicStack.GetCurrentState().mFont;
 	if(!currentFont)
@@ -1096,17 +1109,16 @@ EStatusCode AbstractContentContext::WriteTextCommandWithDirectGlyphSelection(con
 	}
 
 	ObjectIDType fontObjectID;
-	UShortList encodedCharactersList;
 	bool writeAsCID;	
 
-	if(currentFont->EncodeStringForShowing(inText,fontObjectID,encodedCharactersList,writeAsCID) != PDFHummus::eSuccess)
+	if(currentFont->EncodeStringForShowing(inText,fontObjectID,mEncodedCharacters,writeAsCID) != PDFHummus::eSuccess)
 	{
 		TRACE_LOG("AbstractcontextContext::WriteTextCommandWithDirectGlyphSelection, Unexepcted failure, Cannot encode characters");
 		return PDFHummus::eFailure;
 	}
 	
 	// skip if there's no text going to be written (also means no font ID)
-	if(encodedCharactersList.empty() || 0 == fontObjectID)
+	if(mEncodedCharacters.empty() || 0 == fontObjectID)
 		return PDFHummus::eSuccess;
 
 	// Write the font reference (only if required)
@@ -1116,31 +1128,22 @@ EStatusCode AbstractContentContext::WriteTextCommandWithDirectGlyphSelection(con
 		mGraphicStack.GetCurrentState().mPlacedFontSize != mGraphicStack.GetCurrentState().mFontSize)
 		TfLow(fontName,mGraphicStack.GetCurrentState().mFontSize);
 	
-	// Now write the string using the text command
-	OutputStringBufferStream stringStream;
-	char formattingBuffer[5];
-	UShortList::iterator it = encodedCharactersList.begin();
+	// Now write the string using the text command. CID characters are written as 2 bytes, big endian
+	mEncodedString.clear();
 	if(writeAsCID)
 	{
-		for(;it!= encodedCharactersList.end();++it)
+		for(size_t i=0;i<mEncodedCharacters.size();++i)
 		{
-			formattingBuffer[0] = ((*it) >> 8) & 0x00ff;
-			stringStream.Write((const Byte*)formattingBuffer, 1);
-			formattingBuffer[0] = (*it) & 0x00ff;
-			stringStream.Write((const Byte*)formattingBuffer, 1);
-			//SAFE_SPRINTF_2(formattingBuffer,5,"%02x%02x",((*it)>>8) & 0x00ff,(*it) & 0x00ff);
-			//stringStream.Write((const Byte*)formattingBuffer,4);
+			mEncodedString.push_back((char)((mEncodedCharacters[i] >> 8) & 0x00ff));
+			mEncodedString.push_back((char)(mEncodedCharacters[i] & 0x00ff));
 		}
-		inTextCommand->WriteHexStringCommand(stringStream.ToString());
+		inTextCommand->WriteHexStringCommand(mEncodedString);
 	}
 	else
 	{
-		for(;it!= encodedCharactersList.end();++it)
-		{
-			formattingBuffer[0] = (*it) & 0x00ff;
-			stringStream.Write((const Byte*)formattingBuffer,1);
-		}
-		inTextCommand->WriteLiteralStringCommand(stringStream.ToString());	
+		for(size_t i=0;i<mEncodedCharacters.size();++i)
+			mEncodedString.push_back((char)(mEncodedCharacters[i] & 0x00ff));
+		inTextCommand->WriteLiteralStringCommand(mEncodedString);	
 	}
 	return PDFHummus::eSuccess;
 }
@@ -1157,6 +1160,24 @@ EStatusCode AbstractContentContext::DoubleQuote(double inWordSpacing, double inC
 	return WriteTextCommandWithDirectGlyphSelection(inText,&command);
 }
 
+EStatusCode AbstractContentContext::Tj(const GlyphRun& inText)
+{
+	TjCommand command(this);
+	return WriteTextCommandWithDirectGlyphSelection(inText,&command);
+}
+
+EStatusCode AbstractContentContext::Quote(const GlyphRun& inText)
+{
+	QuoteCommand command(this);
+	return WriteTextCommandWithDirectGlyphSelection(inText,&command);
+}
+
+EStatusCode AbstractContentContext::DoubleQuote(double inWordSpacing, double inCharacterSpacing, const GlyphRun& inText)
+{
+	DoubleQuoteCommand command(this,inWordSpacing,inCharacterSpacing);
+	return WriteTextCommandWithDirectGlyphSelection(inText,&command);
+}
+
 EStatusCode AbstractContentContext::TJ(const GlyphUnicodeMappingListOrDoubleList& inStringsAndSpacing)
 {
 	PDFUsedFont* currentFont = mGraphicStack.GetCurrentState().mFont;
@@ -307,6 +307,12 @@ public:
 	PDFHummus::EStatusCode DoubleQuote(double inWordSpacing, double inCharacterSpacing, const GlyphUnicodeMappingList& inText);
 	PDFHummus::EStatusCode TJ(const GlyphUnicodeMappingListOrDoubleList& inStringsAndSpacing); 
 
+	// same, with glyph runs. runs keep glyphs contiguous, and may be reused between calls, so prefer
+	// them when writing many strings. to create a run from UTF8 text use PDFUsedFont::TranslateStringToGlyphs
+	PDFHummus::EStatusCode Tj(const GlyphRun& inText);
+	PDFHummus::EStatusCode Quote(const GlyphRun& inText);
+	PDFHummus::EStatusCode DoubleQuote(double inWordSpacing, double inCharacterSpacing, const GlyphRun& inText);
+
 	//
 	// Text showing operators overriding library behavior
 	//
@@ -368,6 +374,12 @@ private:
 
 	PDFHummus::EStatusCode WriteTextCommandWithEncoding(const std::string& inUnicodeText,ITextCommand* inTextCommand);
 	PDFHummus::EStatusCode WriteTextCommandWithDirectGlyphSelection(const GlyphUnicodeMappingList& inText,ITextCommand* inTextCommand);
+	PDFHummus::EStatusCode WriteTextCommandWithDirectGlyphSelection(const GlyphRun& inText,ITextCommand* inTextCommand);
+
+	// buffers for text writing, reused between text commands
+	GlyphRun mTextRun;
+	UShortVector mEncodedCharacters;
+	std::string mEncodedString;
 
 
 	void SetupColor(const GraphicOptions& inOptions);
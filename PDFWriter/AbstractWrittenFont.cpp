@@ -29,6 +29,7 @@
 #include "PDFArray.h"
 #include "PDFInteger.h"
 #include "PDFIndirectObjectReference.h"
+#include "FreeTypeFaceWrapper.h"
 
 #include <list>
 
@@ -110,22 +111,89 @@ void AbstractWrittenFont::AppendGlyphs(
 	outEncodingIsMultiByte = true;
 }
 
+void AbstractWrittenFont::AppendGlyphs(
+						  const GlyphRun& inGlyphs,
+						  UShortVector& outEncodedCharacters,
+						  bool& outEncodingIsMultiByte,
+						  ObjectIDType &outFontObjectID)
+{
+	// most strings use glyphs that are already in a representation, so check for these with no allocations
+	if(mCIDRepresentation && CanEncodeWithIncludedChars(mCIDRepresentation,inGlyphs,outEncodedCharacters))
+	{
+		outFontObjectID = mCIDRepresentation->mWrittenObjectID;
+		outEncodingIsMultiByte = true;
+		return;
+	}
+
+	if(mANSIRepresentation && CanEncodeWithIncludedChars(mANSIRepresentation,inGlyphs,outEncodedCharacters))
+	{
+		outFontObjectID = mANSIRepresentation->mWrittenObjectID;
+		outEncodingIsMultiByte = false;
+		return;
+	}
+
+	// glyphs need to be added, which is the same as with lists
+	GlyphUnicodeMappingList glyphsList;
+	UShortList encodedCharactersList;
+
+	inGlyphs.ToList(glyphsList);
+	AppendGlyphs(glyphsList,encodedCharactersList,outEncodingIsMultiByte,outFontObjectID);
+	outEncodedCharacters.assign(encodedCharactersList.begin(),encodedCharactersList.end());
+}
+
+void AbstractWrittenFont::ReserveFontPrograms(FreeTypeFaceWrapper& inFontInfo)
+{
+	std::string postscriptFontName = inFontInfo.GetPostscriptName();
+
+	// font writing fails with no postscript name, before getting to subset names. so there's nothing to reserve
+	if(postscriptFontName.length() == 0)
+		return;
+
+	// same conditions and order as for writing the font definition
+	if(mANSIRepresentation && !mANSIRepresentation->isEmpty() && mANSIRepresentation->mWrittenObjectID != 0)
+		ReserveFontProgram(mANSIRepresentation,postscriptFontName);
+
+	if(mCIDRepresentation && !mCIDRepresentation->isEmpty() && mCIDRepresentation->mWrittenObjectID != 0)
+		ReserveFontProgram(mCIDRepresentation,postscriptFontName);
+}
+
+static const std::string scPlus = "+";
+void AbstractWrittenFont::ReserveFontProgram(WrittenFontRepresentation* inRepresentation,const std::string& inPostscriptFontName)
+{
+	delete inRepresentation->mPreparedFontProgram;
+	inRepresentation->mPreparedFontProgram = new PreparedFontProgram(mObjectsContext->GenerateSubsetFontPrefix() + scPlus + inPostscriptFontName);
+}
+
+void AbstractWrittenFont::ReleasePreparedFontPrograms()
+{
+	if(mANSIRepresentation)
+	{
+		delete mANSIRepresentation->mPreparedFontProgram;
+		mANSIRepresentation->mPreparedFontProgram = NULL;
+	}
+
+	if(mCIDRepresentation)
+	{
+		delete mCIDRepresentation->mPreparedFontProgram;
+		mCIDRepresentation->mPreparedFontProgram = NULL;
+	}
+}
+
 bool AbstractWrittenFont::CanEncodeWithIncludedChars(WrittenFontRepresentation* inRepresentation, 
 													 const GlyphUnicodeMappingList& inGlyphsList,
 													 UShortList& outEncodedCharacters)
 {
 	UShortList candidateEncoding;
 	GlyphUnicodeMappingList::const_iterator it=inGlyphsList.begin();
-	UIntToGlyphEncodingInfoMap::iterator itEncoding;
+	unsigned short encodedCharacter;
 	bool allIncluded = true;
 
 	for(; it != inGlyphsList.end() && allIncluded; ++it)
 	{
-		itEncoding = inRepresentation->mGlyphIDToEncodedChar.find(it->mGlyphCode);
-		if(itEncoding == inRepresentation->mGlyphIDToEncodedChar.end())
+		if(!inRepresentation->FindEncodedChar(it->mGlyphCode,encodedCharacter))
 			allIncluded = false;
 		else
-			candidateEncoding.push_back(itEncoding->second.mEncodedCharacter);
+			candidateEncoding.push_back(encodedCharacter);
 	}
 
 	if(allIncluded)
@@ -133,6 +201,22 @@ bool AbstractWrittenFont::CanEncodeWithIncludedChars(WrittenFontRepresentation*
 	return allIncluded;
 }
 
+bool AbstractWrittenFont::CanEncodeWithIncludedChars(WrittenFontRepresentation* inRepresentation, 
+													 const GlyphRun& inGlyphs,
+													 UShortVector& outEncodedCharacters)
+{
+	outEncodedCharacters.resize(inGlyphs.GetGlyphsCount());
+	for(size_t i=0;i<inGlyphs.GetGlyphsCount();++i)
+	{
+		if(!inRepresentation->FindEncodedChar(inGlyphs.mGlyphs[i],outEncodedCharacters[i]))
+		{
+			outEncodedCharacters.clear();
+			return false;
+		}
+	}
+	return true;
+}
+
 void AbstractWrittenFont::AddToCIDRepresentation(const GlyphUnicodeMappingList& inGlyphsList,
 												 UShortList& outEncodedCharacters)
 {
@@ -141,7 +225,7 @@ void AbstractWrittenFont::AddToCIDRepresentation(const GlyphUnicodeMappingList&
 
 	// for the first time, add also 0,0 mapping
 	if(mCIDRepresentation->mGlyphIDToEncodedChar.size() == 0)
-		mCIDRepresentation->mGlyphIDToEncodedChar.insert(UIntToGlyphEncodingInfoMap::value_type(0,GlyphEncodingInfo(EncodeCIDGlyph(0),0)));
+		mCIDRepresentation->AddGlyph(0,GlyphEncodingInfo(EncodeCIDGlyph(0),0));
 
 
 	GlyphUnicodeMappingList::const_iterator it=inGlyphsList.begin();
@@ -152,8 +236,7 @@ void AbstractWrittenFont::AddToCIDRepresentation(const GlyphUnicodeMappingList&
 		itEncoding = mCIDRepresentation->mGlyphIDToEncodedChar.find(it->mGlyphCode);
 		if(itEncoding == mCIDRepresentation->mGlyphIDToEncodedChar.end())
 		{
-			itEncoding = mCIDRepresentation->mGlyphIDToEncodedChar.insert(
-				UIntToGlyphEncodingInfoMap::value_type(it->mGlyphCode,GlyphEncodingInfo(EncodeCIDGlyph(it->mGlyphCode),it->mUnicodeValues))).first;
+			itEncoding = mCIDRepresentation->AddGlyph(it->mGlyphCode,GlyphEncodingInfo(EncodeCIDGlyph(it->mGlyphCode),it->mUnicodeValues));
 
 		}
 		outEncodedCharacters.push_back(itEncoding->second.mEncodedCharacter);
@@ -236,7 +319,7 @@ bool AbstractWrittenFont::CanEncodeWithIncludedChars(	WrittenFontRepresentation*
 	UShortList candidateEncoding;
 	GlyphUnicodeMappingListList::const_iterator it=inGlyphsList.begin();
 	GlyphUnicodeMappingList::const_iterator itGlyphs;
-	UIntToGlyphEncodingInfoMap::iterator itEncoding;
+	unsigned short encodedCharacter;
 	bool allIncluded = true;
 
 	for(; it != inGlyphsList.end() && allIncluded; ++it)
@@ -244,11 +327,10 @@ bool AbstractWrittenFont::CanEncodeWithIncludedChars(	WrittenFontRepresentation*
 		itGlyphs = it->begin();
 		for(; itGlyphs != it->end() && allIncluded; ++itGlyphs)
 		{
-			itEncoding = inRepresentation->mGlyphIDToEncodedChar.find(itGlyphs->mGlyphCode);
-			if(itEncoding == inRepresentation->mGlyphIDToEncodedChar.end())
+			if(!inRepresentation->FindEncodedChar(itGlyphs->mGlyphCode,encodedCharacter))
 				allIncluded = false;
 			else
-				candidateEncoding.push_back(itEncoding->second.mEncodedCharacter);
+				candidateEncoding.push_back(encodedCharacter);
 		}
 		candidateEncodingList.push_back(candidateEncoding);
 		candidateEncoding.clear();
@@ -267,7 +349,7 @@ void AbstractWrittenFont::AddToCIDRepresentation(	const GlyphUnicodeMappingListL
 
 	// for the first time, add also 0,0 mapping
 	if(mCIDRepresentation->mGlyphIDToEncodedChar.size() == 0)
-		mCIDRepresentation->mGlyphIDToEncodedChar.insert(UIntToGlyphEncodingInfoMap::value_type(0,GlyphEncodingInfo(EncodeCIDGlyph(0),0)));
+		mCIDRepresentation->AddGlyph(0,GlyphEncodingInfo(EncodeCIDGlyph(0),0));
 
 
 	GlyphUnicodeMappingListList::const_iterator itList = inGlyphsList.begin();
@@ -283,8 +365,7 @@ void AbstractWrittenFont::AddToCIDRepresentation(	const GlyphUnicodeMappingListL
 			itEncoding = mCIDRepresentation->mGlyphIDToEncodedChar.find(it->mGlyphCode);
 			if(itEncoding == mCIDRepresentation->mGlyphIDToEncodedChar.end())
 			{
-				itEncoding = mCIDRepresentation->mGlyphIDToEncodedChar.insert(
-					UIntToGlyphEncodingInfoMap::value_type(it->mGlyphCode,GlyphEncodingInfo(EncodeCIDGlyph(it->mGlyphCode),it->mUnicodeValues))).first;
+				itEncoding = mCIDRepresentation->AddGlyph(it->mGlyphCode,GlyphEncodingInfo(EncodeCIDGlyph(it->mGlyphCode),it->mUnicodeValues));
 			}
 			encodedCharacters.push_back(itEncoding->second.mEncodedCharacter);
 		}
@@ -451,7 +532,7 @@ void AbstractWrittenFont::ReadWrittenFontState(PDFParser* inStateReader,PDFDicti
 	PDFObjectCastPtr<PDFInteger> firstState;
 	PDFObjectCastPtr<PDFIndirectObjectReference> secondState;
 
-	inRepresentation->mGlyphIDToEncodedChar.clear();
+	inRepresentation->ClearGlyphs();
 
 	while(it.MoveNext())
 	{
@@ -461,7 +542,7 @@ void AbstractWrittenFont::ReadWrittenFontState(PDFParser* inStateReader,PDFDicti
 
 		GlyphEncodingInfo glyphEncodingInfo;		
 		ReadGlyphEncodingInfoState(inStateReader,secondState->mObjectID,glyphEncodingInfo);
-		inRepresentation->mGlyphIDToEncodedChar.insert(UIntToGlyphEncodingInfoMap::value_type((unsigned int)firstState->GetValue(),glyphEncodingInfo));
+		inRepresentation->AddGlyph((unsigned int)firstState->GetValue(),glyphEncodingInfo);
 	}
 
 	PDFObjectCastPtr<PDFInteger> writtenObjectIDState(inState->QueryDirectObject("mWrittenObjectID"));
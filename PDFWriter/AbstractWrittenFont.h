@@ -43,6 +43,12 @@ public:
 							  UShortListList& outEncodedCharacters,
 							  bool& outEncodingIsMultiByte,
 							  ObjectIDType &outFontObjectID);
+	virtual void AppendGlyphs(const GlyphRun& inGlyphs,
+							  UShortVector& outEncodedCharacters,
+							  bool& outEncodingIsMultiByte,
+							  ObjectIDType &outFontObjectID);
+
+	virtual void ReserveFontPrograms(FreeTypeFaceWrapper& inFontInfo);
 protected:
 	WrittenFontRepresentation* mCIDRepresentation;
 	WrittenFontRepresentation* mANSIRepresentation;
@@ -51,18 +57,25 @@ protected:
 	PDFHummus::EStatusCode WriteStateInDictionary(ObjectsContext* inStateWriter,DictionaryContext* inDerivedObjectDictionary);
 	PDFHummus::EStatusCode WriteStateAfterDictionary(ObjectsContext* inStateWriter);
 	PDFHummus::EStatusCode ReadStateFromObject(PDFParser* inStateReader,PDFDictionary* inState);
+	// call when done writing the font definitions, to free the prepared font programs
+	void ReleasePreparedFontPrograms();
 
 private:
 	ObjectIDType mCidRepresentationObjectStateID;
 	ObjectIDType mAnsiRepresentationObjectStateID;
 
 
+	void ReserveFontProgram(WrittenFontRepresentation* inRepresentation,const std::string& inPostscriptFontName);
+
 	bool CanEncodeWithIncludedChars(WrittenFontRepresentation* inRepresentation, 
 									const GlyphUnicodeMappingList& inGlyphsList,
 									UShortList& outEncodedCharacters);
 	bool CanEncodeWithIncludedChars(WrittenFontRepresentation* inRepresentation, 
 									const GlyphUnicodeMappingListList& inGlyphsList,
 									UShortListList& outEncodedCharacters);
+	bool CanEncodeWithIncludedChars(WrittenFontRepresentation* inRepresentation, 
+									const GlyphRun& inGlyphs,
+									UShortVector& outEncodedCharacters);
 
 	void AddToCIDRepresentation(const GlyphUnicodeMappingList& inGlyphsList,UShortList& outEncodedCharacters);
 	void AddToCIDRepresentation(const GlyphUnicodeMappingListList& inGlyphsList,UShortListList& outEncodedCharacters);
@@ -68,7 +68,9 @@ EStatusCode CFFANSIFontWriter::WriteFont(	FreeTypeFaceWrapper& inFontInfo,
 
 	if (inEmbedFont)
 	{
-		fontName = inObjectsContext->GenerateSubsetFontPrefix() + scPlus + postscriptFontName;
+		// the font program may have been subset ahead, with its name reserved then
+		PreparedFontProgram* preparedFontProgram = inFontOccurrence->mPreparedFontProgram;
+		fontName = preparedFontProgram ? preparedFontProgram->mSubsetFontName : (inObjectsContext->GenerateSubsetFontPrefix() + scPlus + postscriptFontName);
 		const char* fontType = inFontInfo.GetTypeString();
 
 		EStatusCode status;
@@ -76,23 +78,35 @@ EStatusCode CFFANSIFontWriter::WriteFont(	FreeTypeFaceWrapper& inFontInfo,
 		{
 			Type1ToCFFEmbeddedFontWriter embeddedFontWriter;
 
-			status = embeddedFontWriter.WriteEmbeddedFont(inFontInfo,
-				inFontOccurrence->GetGlyphIDsAsOrderedVector(),
-				scType1C,
-				fontName,
-				inObjectsContext,
-				mEmbeddedFontFileObjectID);
+			if(preparedFontProgram)
+				status = embeddedFontWriter.WriteEmbeddedFont(*preparedFontProgram,
+					scType1C,
+					inObjectsContext,
+					mEmbeddedFontFileObjectID);
+			else
+				status = embeddedFontWriter.WriteEmbeddedFont(inFontInfo,
+					inFontOccurrence->GetGlyphIDsAsOrderedVector(),
+					scType1C,
+					fontName,
+					inObjectsContext,
+					mEmbeddedFontFileObjectID);
 		}
 		else if (strcmp(scCFF, fontType) == 0)
 		{
 			CFFEmbeddedFontWriter embeddedFontWriter;
 
-			status = embeddedFontWriter.WriteEmbeddedFont(inFontInfo,
-				inFontOccurrence->GetGlyphIDsAsOrderedVector(),
-				scType1C,
-				fontName,
-				inObjectsContext,
-				mEmbeddedFontFileObjectID);
+			if(preparedFontProgram)
+				status = embeddedFontWriter.WriteEmbeddedFont(*preparedFontProgram,
+					scType1C,
+					inObjectsContext,
+					mEmbeddedFontFileObjectID);
+			else
+				status = embeddedFontWriter.WriteEmbeddedFont(inFontInfo,
+					inFontOccurrence->GetGlyphIDsAsOrderedVector(),
+					scType1C,
+					fontName,
+					inObjectsContext,
+					mEmbeddedFontFileObjectID);
 		}
 		else
 		{
@@ -111,6 +125,25 @@ EStatusCode CFFANSIFontWriter::WriteFont(	FreeTypeFaceWrapper& inFontInfo,
 	return fontWriter.WriteFont(inFontInfo, inFontOccurrence, inObjectsContext, this, fontName);
 }
 
+void CFFANSIFontWriter::PrepareEmbeddedFont(FreeTypeFaceWrapper& inFontInfo,WrittenFontRepresentation* inFontOccurrence)
+{
+	const char* fontType = inFontInfo.GetTypeString();
+
+	// with other types writing the font fails, so there's nothing to prepare
+	if (strcmp(scType1Type, fontType) == 0)
+	{
+		Type1ToCFFEmbeddedFontWriter embeddedFontWriter;
+
+		embeddedFontWriter.PrepareEmbeddedFont(inFontInfo,inFontOccurrence->GetGlyphIDsAsOrderedVector(),*(inFontOccurrence->mPreparedFontProgram));
+	}
+	else if (strcmp(scCFF, fontType) == 0)
+	{
+		CFFEmbeddedFontWriter embeddedFontWriter;
+
+		embeddedFontWriter.PrepareEmbeddedFont(inFontInfo,inFontOccurrence->GetGlyphIDsAsOrderedVector(),NULL,*(inFontOccurrence->mPreparedFontProgram));
+	}
+}
+
 static const char* scType1 = "Type1";
 void CFFANSIFontWriter::WriteSubTypeValue(DictionaryContext* inDictionary)
 {
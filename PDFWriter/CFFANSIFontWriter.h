@@ -41,6 +41,9 @@ public:
 							ObjectsContext* inObjectsContext,
 							bool inEmbedFont);
 
+	// subset the embedded font program of inFontOccurrence ahead of writing, into its reserved prepared font program
+	static void PrepareEmbeddedFont(FreeTypeFaceWrapper& inFontInfo,WrittenFontRepresentation* inFontOccurrence);
+
 	// IANSIFontWriterHelper implementation
 	virtual void WriteSubTypeValue(DictionaryContext* inDictionary);
 	virtual IFontDescriptorHelper* GetCharsetWriter();
@@ -29,8 +29,9 @@
 
 using namespace PDFHummus;
 
-CFFDescendentFontWriter::CFFDescendentFontWriter(void)
+CFFDescendentFontWriter::CFFDescendentFontWriter(PreparedFontProgram* inPreparedFontProgram)
 {
+	mPreparedFontProgram = inPreparedFontProgram;
 }
 
 CFFDescendentFontWriter::~CFFDescendentFontWriter(void)
@@ -42,8 +43,45 @@ CFFDescendentFontWriter::~CFFDescendentFontWriter(void)
 	return inLeft.first < inRight.first;
 }*/
 
-static const std::string scCIDFontType0C = "CIDFontType0C";
 static const char* scType1 = "Type 1";
+
+static void GetSubsetGlyphs(const UIntAndGlyphEncodingInfoVector& inEncodedGlyphs,UIntVector& outOrderedGlyphs,UShortVector& outCIDMapping)
+{
+	UIntAndGlyphEncodingInfoVector encodedGlyphs = inEncodedGlyphs;
+
+	// Gal: the following sort completely ruins everything.
+	// the order of the glyphs should be maintained per the ENCODED characthers
+	// which is how the input is recieved. IMPORTANT - the order is critical
+	// for the success of the embedding, as the order determines the order of the glyphs
+	// in the subset font and so their GID which MUST match the encoded char.
+	//sort(encodedGlyphs.begin(), encodedGlyphs.end(), sEncodedGlypsSort);
+
+	for (UIntAndGlyphEncodingInfoVector::const_iterator it = encodedGlyphs.begin();
+		it != encodedGlyphs.end();
+		++it)
+	{
+		outOrderedGlyphs.push_back(it->first);
+		outCIDMapping.push_back(it->second.mEncodedCharacter);
+	}
+}
+
+void CFFDescendentFontWriter::PrepareEmbeddedFont(FreeTypeFaceWrapper& inFontInfo,
+												const UIntAndGlyphEncodingInfoVector& inEncodedGlyphs,
+												PreparedFontProgram& outFontProgram)
+{
+	// type 1 CIDs are not supported, and fail when writing. so nothing to prepare
+	if(strcmp(scType1,inFontInfo.GetTypeString()) == 0)
+		return;
+
+	CFFEmbeddedFontWriter embeddedFontWriter;
+	UIntVector orderedGlyphs;
+	UShortVector cidMapping;
+
+	GetSubsetGlyphs(inEncodedGlyphs,orderedGlyphs,cidMapping);
+	embeddedFontWriter.PrepareEmbeddedFont(inFontInfo,orderedGlyphs,&cidMapping,outFontProgram);
+}
+
+static const std::string scCIDFontType0C = "CIDFontType0C";
 EStatusCode CFFDescendentFontWriter::WriteFont(	ObjectIDType inDecendentObjectID, 
 														const std::string& inFontName,
 														FreeTypeFaceWrapper& inFontInfo,
@@ -69,31 +107,29 @@ EStatusCode CFFDescendentFontWriter::WriteFont(	ObjectIDType inDecendentObjectID
 	if (inEmbedFont)
 	{
 		CFFEmbeddedFontWriter embeddedFontWriter;
-		UIntAndGlyphEncodingInfoVector encodedGlyphs = inEncodedGlyphs;
-		UIntVector orderedGlyphs;
-		UShortVector cidMapping;
-
-		// Gal: the following sort completely ruins everything.
-		// the order of the glyphs should be maintained per the ENCODED characthers
-		// which is how the input is recieved. IMPORTANT - the order is critical
-		// for the success of the embedding, as the order determines the order of the glyphs
-		// in the subset font and so their GID which MUST match the encoded char.
-		//sort(encodedGlyphs.begin(), encodedGlyphs.end(), sEncodedGlypsSort);
-
-		for (UIntAndGlyphEncodingInfoVector::const_iterator it = encodedGlyphs.begin();
-			it != encodedGlyphs.end();
-			++it)
+		EStatusCode status;
+
+		if(mPreparedFontProgram)
+		{
+			status = embeddedFontWriter.WriteEmbeddedFont(*mPreparedFontProgram,
+				scCIDFontType0C,
+				inObjectsContext,
+				mEmbeddedFontFileObjectID);
+		}
+		else
 		{
-			orderedGlyphs.push_back(it->first);
-			cidMapping.push_back(it->second.mEncodedCharacter);
+			UIntVector orderedGlyphs;
+			UShortVector cidMapping;
+
+			GetSubsetGlyphs(inEncodedGlyphs,orderedGlyphs,cidMapping);
+			status = embeddedFontWriter.WriteEmbeddedFont(inFontInfo,
+				orderedGlyphs,
+				scCIDFontType0C,
+				inFontName,
+				inObjectsContext,
+				&cidMapping,
+				mEmbeddedFontFileObjectID);
 		}
-		EStatusCode status = embeddedFontWriter.WriteEmbeddedFont(inFontInfo,
-			orderedGlyphs,
-			scCIDFontType0C,
-			inFontName,
-			inObjectsContext,
-			&cidMapping,
-			mEmbeddedFontFileObjectID);
 		if (status != PDFHummus::eSuccess)
 			return status;
 	}
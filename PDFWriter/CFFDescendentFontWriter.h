@@ -24,9 +24,15 @@
 class CFFDescendentFontWriter: public IDescendentFontWriter
 {
 public:
-	CFFDescendentFontWriter(void);
+	// pass a font program prepared with PrepareEmbeddedFont, to write it instead of subsetting the font when writing
+	CFFDescendentFontWriter(PreparedFontProgram* inPreparedFontProgram = NULL);
 	~CFFDescendentFontWriter(void);
 
+	// subset the embedded font program ahead of writing. inEncodedGlyphs are as passed to WriteFont
+	static void PrepareEmbeddedFont(FreeTypeFaceWrapper& inFontInfo,
+									const UIntAndGlyphEncodingInfoVector& inEncodedGlyphs,
+									PreparedFontProgram& outFontProgram);
+
 	// IDescendentFontWriter implementation [used also as helper for the DescendentFontWriter]
 	virtual PDFHummus::EStatusCode WriteFont(	ObjectIDType inDecendentObjectID, 
 									const std::string& inFontName,
@@ -40,6 +46,7 @@ public:
 									ObjectsContext* inObjectsContext);
 
 private:
+	PreparedFontProgram* mPreparedFontProgram;
 	ObjectIDType mEmbeddedFontFileObjectID;
 
 };
\ No newline at end of file
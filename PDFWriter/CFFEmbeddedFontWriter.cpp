@@ -39,6 +39,7 @@ using namespace PDFHummus;
 
 CFFEmbeddedFontWriter::CFFEmbeddedFontWriter(void)
 {
+	mOpenTypeStream = NULL;
 }
 
 CFFEmbeddedFontWriter::~CFFEmbeddedFontWriter(void)
@@ -67,22 +68,50 @@ EStatusCode CFFEmbeddedFontWriter::WriteEmbeddedFont(
 	UShortVector* inCIDMapping,
 	ObjectIDType& outEmbeddedFontObjectID)
 {
-	MyStringBuf rawFontProgram; 
-	bool notEmbedded;
+	PreparedFontProgram fontProgram(inSubsetFontName);
+
+	PrepareEmbeddedFont(inFontInfo,inSubsetGlyphIDs,inCIDMapping,fontProgram);
+	return WriteEmbeddedFont(fontProgram,inFontFile3SubType,inObjectsContext,outEmbeddedFontObjectID);
+}
+
+void CFFEmbeddedFontWriter::PrepareEmbeddedFont(
+	FreeTypeFaceWrapper& inFontInfo,
+	const UIntVector& inSubsetGlyphIDs,
+	UShortVector* inCIDMapping,
+	PreparedFontProgram& outFontProgram)
+{
+	SharedFontsCache* fontsCache = inFontInfo.GetFontsCache();
+	FontProgramKey key(inFontInfo.GetFontFilePath(),inFontInfo.GetFontIndex(),outFontProgram.mSubsetFontName,inSubsetGlyphIDs);
+	if(inCIDMapping)
+		key.mCIDMapping = *inCIDMapping;
+	if(fontsCache && outFontProgram.GetFromFontsCache(fontsCache,key))
+		return;
+
 		// as oppose to true type, the reason for using a memory stream here is mainly peformance - i don't want to start
 		// setting file pointers and move in a file stream
+	outFontProgram.mStatus = CreateCFFSubset(inFontInfo,inSubsetGlyphIDs,inCIDMapping,outFontProgram.mSubsetFontName,outFontProgram.mNotEmbedded,outFontProgram.mFontProgram);
+	if(fontsCache)
+		outFontProgram.AddToFontsCache(fontsCache,key);
+}
+
+EStatusCode CFFEmbeddedFontWriter::WriteEmbeddedFont(
+	PreparedFontProgram& inFontProgram,
+	const std::string& inFontFile3SubType,
+	ObjectsContext* inObjectsContext,
+	ObjectIDType& outEmbeddedFontObjectID)
+{
 	EStatusCode status;
 
 	do
 	{
-		status = CreateCFFSubset(inFontInfo,inSubsetGlyphIDs,inCIDMapping,inSubsetFontName,notEmbedded,rawFontProgram);
+		status = inFontProgram.mStatus;
 		if(status != PDFHummus::eSuccess)
 		{
 			TRACE_LOG("CFFEmbeddedFontWriter::WriteEmbeddedFont, failed to write embedded font program");
 			break;
 		}	
 
-		if(notEmbedded)
+		if(inFontProgram.mNotEmbedded)
 		{
 			// can't embed. mark succesful, and go back empty
 			outEmbeddedFontObjectID = 0;
@@ -94,26 +123,15 @@ EStatusCode CFFEmbeddedFontWriter::WriteEmbeddedFont(
 		
 		DictionaryContext* fontProgramDictionaryContext = inObjectsContext->StartDictionary();
 
-		rawFontProgram.pubseekoff(0,std::ios_base::beg);
-
 		fontProgramDictionaryContext->WriteKey(scSubtype);
 		fontProgramDictionaryContext->WriteNameValue(inFontFile3SubType);
-		PDFStream* pdfStream = inObjectsContext->StartPDFStream(fontProgramDictionaryContext);
 
-
-		// now copy the created font program to the output stream
-		InputStringBufferStream fontProgramStream(&rawFontProgram);
-		OutputStreamTraits streamCopier(pdfStream->GetWriteStream());
-		status = streamCopier.CopyToOutputStream(&fontProgramStream);
+		status = inFontProgram.WriteFontProgramStream(inObjectsContext,fontProgramDictionaryContext);
 		if(status != PDFHummus::eSuccess)
 		{
 			TRACE_LOG("CFFEmbeddedFontWriter::WriteEmbeddedFont, failed to copy font program into pdf stream");
 			break;
 		}
-
-
-		inObjectsContext->EndPDFStream(pdfStream);
-		delete pdfStream;
 	}while(false);
 
 	return status;	
@@ -133,14 +151,11 @@ EStatusCode CFFEmbeddedFontWriter::CreateCFFSubset(
 	do
 	{
 
-		status = mOpenTypeFile.OpenFile(inFontInfo.GetFontFilePath());
+		status = OpenFontFile(inFontInfo);
 		if(status != PDFHummus::eSuccess)
-		{
-			TRACE_LOG1("CFFEmbeddedFontWriter::CreateCFFSubset, cannot open type font file at %s",inFontInfo.GetFontFilePath().c_str());
 			break;
-		}
 
-		status = mOpenTypeInput.ReadOpenTypeFile(mOpenTypeFile.GetInputStream(),(unsigned short)inFontInfo.GetFontIndex());
+		status = mOpenTypeInput.ReadOpenTypeFile(mOpenTypeStream,(unsigned short)inFontInfo.GetFontIndex());
 		if(status != PDFHummus::eSuccess)
 		{
 			TRACE_LOG("CFFEmbeddedFontWriter::CreateCFFSubset, failed to read true type file");
@@ -268,10 +283,43 @@ EStatusCode CFFEmbeddedFontWriter::CreateCFFSubset(
 		}
 	}while(false);
 
-	mOpenTypeFile.CloseFile();
+	CloseFontFile();
+	return status;
+}
+
+EStatusCode CFFEmbeddedFontWriter::OpenFontFile(FreeTypeFaceWrapper& inFontInfo)
+{
+	SharedFontsCache* fontsCache = inFontInfo.GetFontsCache();
+
+	if(fontsCache)
+	{
+		mOpenTypeFileContent = fontsCache->GetFontFileContent(inFontInfo.GetFontFilePath());
+		if(mOpenTypeFileContent)
+		{
+			mOpenTypeFileContentStream.Assign(mOpenTypeFileContent->size() > 0 ? (IOBasicTypes::Byte*)&((*mOpenTypeFileContent)[0]) : NULL,mOpenTypeFileContent->size());
+			mOpenTypeStream = &mOpenTypeFileContentStream;
+			return PDFHummus::eSuccess;
+		}
+	}
+
+	EStatusCode status = mOpenTypeFile.OpenFile(inFontInfo.GetFontFilePath());
+	if(status != PDFHummus::eSuccess)
+	{
+		TRACE_LOG1("CFFEmbeddedFontWriter::OpenFontFile, cannot open type font file at %s",inFontInfo.GetFontFilePath().c_str());
+		return status;
+	}
+	mOpenTypeStream = mOpenTypeFile.GetInputStream();
 	return status;
 }
 
+void CFFEmbeddedFontWriter::CloseFontFile()
+{
+	mOpenTypeFile.CloseFile();
+	mOpenTypeFileContentStream.Assign(NULL,0);
+	mOpenTypeFileContent.reset();
+	mOpenTypeStream = NULL;
+}
+
 EStatusCode CFFEmbeddedFontWriter::AddDependentGlyphs(UIntVector& ioSubsetGlyphIDs)
 {
 	EStatusCode status = PDFHummus::eSuccess;
@@ -336,8 +384,8 @@ EStatusCode CFFEmbeddedFontWriter::WriteCFFHeader()
 	 // i'll probably just set it to something.
 	
 	OutputStreamTraits streamCopier(&mFontFileStream);
-	mOpenTypeFile.GetInputStream()->SetPosition(mOpenTypeInput.mCFF.mCFFOffset);
-	return streamCopier.CopyToOutputStream(mOpenTypeFile.GetInputStream(),mOpenTypeInput.mCFF.mHeader.hdrSize);
+	mOpenTypeStream->SetPosition(mOpenTypeInput.mCFF.mCFFOffset);
+	return streamCopier.CopyToOutputStream(mOpenTypeStream,mOpenTypeInput.mCFF.mHeader.hdrSize);
 }
 
 EStatusCode CFFEmbeddedFontWriter::WriteName(const std::string& inSubsetFontName)
@@ -535,8 +583,8 @@ EStatusCode CFFEmbeddedFontWriter::WriteStringIndex()
 		// starting position is equal to the strings end position. hence length is...
 
 		OutputStreamTraits streamCopier(&mFontFileStream);
-		mOpenTypeFile.GetInputStream()->SetPosition(mOpenTypeInput.mCFF.mCFFOffset + mOpenTypeInput.mCFF.mStringIndexPosition);
-		return streamCopier.CopyToOutputStream(mOpenTypeFile.GetInputStream(),
+		mOpenTypeStream->SetPosition(mOpenTypeInput.mCFF.mCFFOffset + mOpenTypeInput.mCFF.mStringIndexPosition);
+		return streamCopier.CopyToOutputStream(mOpenTypeStream,
 												(LongBufferSizeType)(mOpenTypeInput.mCFF.mGlobalSubrsPosition -
 												mOpenTypeInput.mCFF.mStringIndexPosition));
 	}
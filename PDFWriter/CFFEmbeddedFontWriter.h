@@ -24,7 +24,10 @@
 #include "ObjectsBasicTypes.h"
 #include "OpenTypeFileInput.h"
 #include "MyStringBuf.h"
+#include "PreparedFontProgram.h"
 #include "InputFile.h"
+#include "InputByteArrayStream.h"
+#include "SharedFontsCache.h"
 #include "CFFPrimitiveWriter.h"
 #include "OutputStringBufferStream.h"
 #include "IOBasicTypes.h"
@@ -82,10 +85,26 @@ public:
 									UShortVector* inCIDMapping,
 									ObjectIDType& outEmbeddedFontObjectID);
 
+	// same, in two steps. PrepareEmbeddedFont subsets the font into outFontProgram, named per its subset font name, and may run
+	// on a worker thread (as long as the font is not used elsewhere meanwhile). WriteEmbeddedFont then writes it
+	void PrepareEmbeddedFont(	FreeTypeFaceWrapper& inFontInfo,
+								const UIntVector& inSubsetGlyphIDs,
+								UShortVector* inCIDMapping,
+								PreparedFontProgram& outFontProgram);
+	PDFHummus::EStatusCode WriteEmbeddedFont(	PreparedFontProgram& inFontProgram,
+									const std::string& inFontFile3SubType,
+									ObjectsContext* inObjectsContext,
+									ObjectIDType& outEmbeddedFontObjectID);
+
 
 private:
 	OpenTypeFileInput mOpenTypeInput;
+	// the font file, either the file itself or its content in the fonts cache of the font. the CFF parse is
+	// changed while subsetting, so unlike true type tables it's not shared, and is parsed per font
+	IByteReaderWithPosition* mOpenTypeStream;
 	InputFile mOpenTypeFile;
+	SharedFontFileContent mOpenTypeFileContent;
+	InputByteArrayStream mOpenTypeFileContentStream;
 	CFFPrimitiveWriter mPrimitivesWriter;
 	OutputStringBufferStream mFontFileStream;
 	bool mIsCID;
@@ -114,6 +133,8 @@ private:
 					const std::string& inSubsetFontName,
 					bool& outNotEmbedded,
 					MyStringBuf& outFontProgram);
+	PDFHummus::EStatusCode OpenFontFile(FreeTypeFaceWrapper& inFontInfo);
+	void CloseFontFile();
 	PDFHummus::EStatusCode AddDependentGlyphs(UIntVector& ioSubsetGlyphIDs);
 	PDFHummus::EStatusCode AddComponentGlyphs(unsigned int inGlyphID,UIntSet& ioComponents,bool &outFoundComponents);
 	PDFHummus::EStatusCode WriteCFFHeader();
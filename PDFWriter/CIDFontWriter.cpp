@@ -90,7 +90,12 @@ EStatusCode CIDFontWriter::WriteFont(FreeTypeFaceWrapper& inFontInfo,
 			status = PDFHummus::eFailure;
 			break;
 		}
-		std::string fontName = inEmbedFont ? (inObjectsContext->GenerateSubsetFontPrefix() + scPlus + postscriptFontName) : postscriptFontName;
+		// when the font program was subset ahead, the subset name was reserved then
+		std::string fontName = inEmbedFont ? 
+									(inFontOccurrence->mPreparedFontProgram ? 
+										inFontOccurrence->mPreparedFontProgram->mSubsetFontName :
+										(inObjectsContext->GenerateSubsetFontPrefix() + scPlus + postscriptFontName)) : 
+									postscriptFontName;
 		fontContext->WriteNameValue(fontName);
 
 		WriteEncoding(fontContext);
@@ -155,14 +160,19 @@ static bool sUShortSort(const UIntAndGlyphEncodingInfo& inLeft, const UIntAndGly
 }
 
 void CIDFontWriter::CalculateCharacterEncodingArray()
+{
+	CalculateCharacterEncodingArray(mFontOccurrence,mCharactersVector);
+}
+
+void CIDFontWriter::CalculateCharacterEncodingArray(WrittenFontRepresentation* inFontOccurrence,UIntAndGlyphEncodingInfoVector& outCharactersVector)
 {
 	// first we need to sort the fonts charachters by character code
-	UIntToGlyphEncodingInfoMap::iterator it = mFontOccurrence->mGlyphIDToEncodedChar.begin();
+	UIntToGlyphEncodingInfoMap::iterator it = inFontOccurrence->mGlyphIDToEncodedChar.begin();
 
-	for(; it != mFontOccurrence->mGlyphIDToEncodedChar.end();++it)
-		mCharactersVector.push_back(UIntAndGlyphEncodingInfo(it->first,it->second));
+	for(; it != inFontOccurrence->mGlyphIDToEncodedChar.end();++it)
+		outCharactersVector.push_back(UIntAndGlyphEncodingInfo(it->first,it->second));
 
-	std::sort(mCharactersVector.begin(),mCharactersVector.end(),sUShortSort);
+	std::sort(outCharactersVector.begin(),outCharactersVector.end(),sUShortSort);
 }
 
 
@@ -50,6 +50,9 @@ public:
 							IDescendentFontWriter* inDescendentFontWriter,
 							bool inEmbedFont);
 
+	// the font characters ordered by their encoding, which is how they are passed to the descendent font writer
+	static void CalculateCharacterEncodingArray(WrittenFontRepresentation* inFontOccurrence,UIntAndGlyphEncodingInfoVector& outCharactersVector);
+
 private:
 
 	FreeTypeFaceWrapper* mFontInfo;
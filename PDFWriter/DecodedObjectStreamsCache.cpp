@@ -0,0 +1,99 @@
+/*
+   Source File : DecodedObjectStreamsCache.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "DecodedObjectStreamsCache.h"
+
+using namespace IOBasicTypes;
+
+DecodedObjectStreamsCache::DecodedObjectStreamsCache(void)
+{
+	mBudget = 0;
+	mCachedSize = 0;
+}
+
+DecodedObjectStreamsCache::~DecodedObjectStreamsCache(void)
+{
+	Reset();
+}
+
+void DecodedObjectStreamsCache::SetBudget(LongBufferSizeType inBudget)
+{
+	mBudget = inBudget;
+	EvictTillSize(mBudget);
+}
+
+LongBufferSizeType DecodedObjectStreamsCache::GetBudget()
+{
+	return mBudget;
+}
+
+LongBufferSizeType DecodedObjectStreamsCache::GetCachedSize()
+{
+	return mCachedSize;
+}
+
+DecodedObjectStream* DecodedObjectStreamsCache::Find(ObjectIDType inObjectStreamID)
+{
+	ObjectIDTypeToDecodedObjectStreamAndUsagePositionMap::iterator it = mDecodedStreams.find(inObjectStreamID);
+	if(it == mDecodedStreams.end())
+		return NULL;
+
+	// move to front of usage order
+	mUsageOrder.splice(mUsageOrder.begin(),mUsageOrder,it->second.second);
+	return it->second.first;
+}
+
+bool DecodedObjectStreamsCache::Insert(ObjectIDType inObjectStreamID,DecodedObjectStream* inDecodedStream)
+{
+	LongBufferSizeType streamSize = inDecodedStream->mData.size();
+
+	if(streamSize > mBudget || mDecodedStreams.find(inObjectStreamID) != mDecodedStreams.end())
+		return false;
+
+	EvictTillSize(mBudget - streamSize);
+
+	mUsageOrder.push_front(inObjectStreamID);
+	mDecodedStreams.insert(ObjectIDTypeToDecodedObjectStreamAndUsagePositionMap::value_type(
+								inObjectStreamID,DecodedObjectStreamAndUsagePosition(inDecodedStream,mUsageOrder.begin())));
+	mCachedSize+= streamSize;
+	return true;
+}
+
+void DecodedObjectStreamsCache::EvictTillSize(LongBufferSizeType inSize)
+{
+	while(mCachedSize > inSize && mUsageOrder.size() > 0)
+	{
+		ObjectIDTypeToDecodedObjectStreamAndUsagePositionMap::iterator it = mDecodedStreams.find(mUsageOrder.back());
+		mCachedSize-= it->second.first->mData.size();
+		delete it->second.first;
+		mDecodedStreams.erase(it);
+		mUsageOrder.pop_back();
+	}
+}
+
+void DecodedObjectStreamsCache::Reset()
+{
+	ObjectIDTypeToDecodedObjectStreamAndUsagePositionMap::iterator it = mDecodedStreams.begin();
+	for(; it != mDecodedStreams.end(); ++it)
+		delete it->second.first;
+	mDecodedStreams.clear();
+	mUsageOrder.clear();
+	mCachedSize = 0;
+}
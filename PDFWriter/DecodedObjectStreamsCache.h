@@ -0,0 +1,81 @@
+/*
+   Source File : DecodedObjectStreamsCache.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "ObjectsBasicTypes.h"
+#include "IOBasicTypes.h"
+
+#include <list>
+#include <map>
+#include <vector>
+#include <utility>
+
+/*
+	Memory bounded LRU cache of decoded object streams, keyed by object stream ID.
+	PDFParser uses it to parse objects that are placed in object streams straight out of the decoded bytes,
+	instead of decoding the object stream from its start for every object that's fetched from it.
+*/
+
+struct DecodedObjectStream
+{
+	// object stream content, fully decoded
+	std::vector<IOBasicTypes::Byte> mData;
+	// the stream /N value - number of objects in the stream
+	ObjectIDType mObjectsCount;
+	// the stream /First value - position of the first object, right after the stream header
+	IOBasicTypes::LongFilePositionType mFirstObjectPosition;
+};
+
+typedef std::list<ObjectIDType> ObjectIDTypeList;
+typedef std::pair<DecodedObjectStream*,ObjectIDTypeList::iterator> DecodedObjectStreamAndUsagePosition;
+typedef std::map<ObjectIDType,DecodedObjectStreamAndUsagePosition> ObjectIDTypeToDecodedObjectStreamAndUsagePositionMap;
+
+class DecodedObjectStreamsCache
+{
+public:
+	DecodedObjectStreamsCache(void);
+	~DecodedObjectStreamsCache(void);
+
+	// budget is the total size in bytes of decoded content that the cache may hold. 0 disables caching.
+	// lowering the budget evicts streams as required
+	void SetBudget(IOBasicTypes::LongBufferSizeType inBudget);
+	IOBasicTypes::LongBufferSizeType GetBudget();
+	IOBasicTypes::LongBufferSizeType GetCachedSize();
+
+	// returns the decoded object stream, marking it as most recently used, or NULL if it's not in the cache.
+	// the returned pointer is owned by the cache, and is valid till the next call to Insert, SetBudget or Reset
+	DecodedObjectStream* Find(ObjectIDType inObjectStreamID);
+
+	// pass a decoded object stream to the cache. least recently used streams are evicted to make room for it.
+	// if the stream alone is larger than the budget it is not kept, false is returned, and ownership remains with the caller
+	bool Insert(ObjectIDType inObjectStreamID,DecodedObjectStream* inDecodedStream);
+
+	void Reset();
+
+private:
+	IOBasicTypes::LongBufferSizeType mBudget;
+	IOBasicTypes::LongBufferSizeType mCachedSize;
+	// usage order. most recently used in front
+	ObjectIDTypeList mUsageOrder;
+	ObjectIDTypeToDecodedObjectStreamAndUsagePositionMap mDecodedStreams;
+
+	void EvictTillSize(IOBasicTypes::LongBufferSizeType inSize);
+};
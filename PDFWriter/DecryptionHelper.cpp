@@ -288,11 +288,17 @@ bool DecryptionHelper::DidSucceedOwnerPasswordVerification() const {
 
 static const string scEcnryptionKeyMetadataKey = "DecryptionHelper.EncryptionKey";
 
+// keys and names for finding stream crypt filters, interned once as they're looked up for every stream read
+static const PDFNameAtom scFilterKey = PDFNameAtoms::Intern("Filter");
+static const PDFNameAtom scDecodeParmsKey = PDFNameAtoms::Intern("DecodeParms");
+static const PDFNameAtom scNameKey = PDFNameAtoms::Intern("Name");
+static const PDFNameAtom scCryptName = PDFNameAtoms::Intern("Crypt");
+
 bool HasCryptFilterDefinition(PDFParser* inParser, PDFStreamInput* inStream) {
 	RefCountPtr<PDFDictionary> streamDictionary(inStream->QueryStreamDictionary());
 
 	// check if stream has a crypt filter
-	RefCountPtr<PDFObject> filterObject(inParser->QueryDictionaryObject(streamDictionary.GetPtr(), "Filter"));
+	RefCountPtr<PDFObject> filterObject(inParser->QueryDictionaryObject(streamDictionary.GetPtr(), scFilterKey));
 	if (!filterObject)
 	{
 		// no filter, so stop here
@@ -311,13 +317,13 @@ bool HasCryptFilterDefinition(PDFParser* inParser, PDFStreamInput* inStream) {
 				// error
 				break;
 			}
-			foundCrypt = filterObjectItem->GetValue() == "Crypt";
+			foundCrypt = filterObjectItem->GetAtom() == scCryptName;
 		}
 		return foundCrypt;
 	}
 	else if (filterObject->GetType() == PDFObject::ePDFObjectName)
 	{
-		return ((PDFName*)(filterObject.GetPtr()))->GetValue() == "Crypt";
+		return ((PDFName*)(filterObject.GetPtr()))->GetAtom() == scCryptName;
 	}
 	else
 		return false; //???
@@ -395,7 +401,7 @@ XCryptionCommon* DecryptionHelper::GetCryptForStream(PDFStreamInput* inStream) {
 		// find position of crypt filter, and get the name of the crypt filter from the decodeParams
 		RefCountPtr<PDFDictionary> streamDictionary(inStream->QueryStreamDictionary());
 
-		RefCountPtr<PDFObject> filterObject(mParser->QueryDictionaryObject(streamDictionary.GetPtr(), "Filter"));
+		RefCountPtr<PDFObject> filterObject(mParser->QueryDictionaryObject(streamDictionary.GetPtr(), scFilterKey));
 		if (filterObject->GetType() == PDFObject::ePDFObjectArray)
 		{
 			PDFArray* filterObjectArray = (PDFArray*)filterObject.GetPtr();
@@ -403,11 +409,11 @@ XCryptionCommon* DecryptionHelper::GetCryptForStream(PDFStreamInput* inStream) {
 			for (; i < filterObjectArray->GetLength(); ++i)
 			{
 				PDFObjectCastPtr<PDFName> filterObjectItem(filterObjectArray->QueryObject(i));
-				if (filterObjectItem->GetValue() == "Crypt")
+				if (filterObjectItem->GetAtom() == scCryptName)
 					break;
 			}
 			if (i < filterObjectArray->GetLength()) {
-				PDFObjectCastPtr<PDFArray> decodeParams(mParser->QueryDictionaryObject(streamDictionary.GetPtr(), "DecodeParms"));
+				PDFObjectCastPtr<PDFArray> decodeParams(mParser->QueryDictionaryObject(streamDictionary.GetPtr(), scDecodeParmsKey));
 				if (!decodeParams)
 					return mXcryptStreams;
 				// got index, look for the name in the decode params array
@@ -415,7 +421,7 @@ XCryptionCommon* DecryptionHelper::GetCryptForStream(PDFStreamInput* inStream) {
 				if (!decodeParamsItem)
 					return mXcryptStreams;
 
-				PDFObjectCastPtr<PDFName> cryptFilterName(mParser->QueryDictionaryObject(decodeParamsItem.GetPtr(), "Name"));
+				PDFObjectCastPtr<PDFName> cryptFilterName(mParser->QueryDictionaryObject(decodeParamsItem.GetPtr(), scNameKey));
 				return GetFilterForName(mXcrypts, cryptFilterName->GetValue());
 
 			}
@@ -425,11 +431,11 @@ XCryptionCommon* DecryptionHelper::GetCryptForStream(PDFStreamInput* inStream) {
 		else if (filterObject->GetType() == PDFObject::ePDFObjectName)
 		{
 			// has to be crypt filter, look for the name in decode params
-			PDFObjectCastPtr<PDFDictionary> decodeParamsItem((mParser->QueryDictionaryObject(streamDictionary.GetPtr(), "DecodeParms")));
+			PDFObjectCastPtr<PDFDictionary> decodeParamsItem((mParser->QueryDictionaryObject(streamDictionary.GetPtr(), scDecodeParmsKey)));
 			if (!decodeParamsItem)
 				return mXcryptStreams;
 
-			PDFObjectCastPtr<PDFName> cryptFilterName(mParser->QueryDictionaryObject(decodeParamsItem.GetPtr(), "Name"));
+			PDFObjectCastPtr<PDFName> cryptFilterName(mParser->QueryDictionaryObject(decodeParamsItem.GetPtr(), scNameKey));
 			return GetFilterForName(mXcrypts, cryptFilterName->GetValue());
 		}
 		else
@@ -66,6 +66,11 @@ DocumentContext::~DocumentContext(void)
     Cleanup();
 }
 
+ObjectsContext* DocumentContext::GetObjectsContext()
+{
+	return mObjectsContext;
+}
+
 void DocumentContext::SetObjectsContext(ObjectsContext* inObjectsContext)
 {
 	mObjectsContext = inObjectsContext;
@@ -84,6 +89,14 @@ void DocumentContext::SetEmbedFonts(bool inEmbedFonts) {
 	mUsedFontsRepository.SetEmbedFonts(inEmbedFonts);
 }
 
+void DocumentContext::SetFontsCache(SharedFontsCache* inFontsCache) {
+	mUsedFontsRepository.SetFontsCache(inFontsCache);
+}
+
+void DocumentContext::SetParallelFontSubsetting(bool inParallelFontSubsetting,unsigned int inThreadsCount) {
+	mUsedFontsRepository.SetParallelFontSubsetting(inParallelFontSubsetting,inThreadsCount);
+}
+
 void DocumentContext::SetOutputFileInformation(OutputFile* inOutputFile)
 {
 	// just save the output file path for the ID generation in the end
@@ -215,13 +228,27 @@ EStatusCode	DocumentContext::FinalizeNewPDF()
 		// write encryption dictionary, if encrypting
 		WriteEncryptionDictionary();
 
-		status = mObjectsContext->WriteXrefTable(xrefTablePosition);
-		if(status != 0)
-			break;
+		if(mObjectsContext->IsWritingObjectStreams())
+		{
+			// object streams members can only be referenced by an xref stream, which also serves as the trailer
+			status = mObjectsContext->FlushObjectStream();
+			if(status != 0)
+				break;
 
-		status = WriteTrailerDictionary();
-		if(status != 0)
-			break;
+			status = WriteXrefStream(xrefTablePosition);
+			if(status != 0)
+				break;
+		}
+		else
+		{
+			status = mObjectsContext->WriteXrefTable(xrefTablePosition);
+			if(status != 0)
+				break;
+
+			status = WriteTrailerDictionary();
+			if(status != 0)
+				break;
+		}
 
 		WriteXrefReference(xrefTablePosition);
 		WriteFinalEOF();
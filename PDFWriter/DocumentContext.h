@@ -59,6 +59,7 @@ class PageContentContext;
 class ResourcesDictionary;
 class PDFFormXObject;
 class PDFTiledPattern;
+class SharedFontsCache;
 class PDFRectangle;
 class PDFImageXObject;
 class PDFUsedFont;
@@ -111,8 +112,11 @@ namespace PDFHummus
 		~DocumentContext();
 
 		void SetObjectsContext(ObjectsContext* inObjectsContext);
+		ObjectsContext* GetObjectsContext();
 		void SetOutputFileInformation(OutputFile* inOutputFile);
 		void SetEmbedFonts(bool inEmbedFonts);
+		void SetFontsCache(SharedFontsCache* inFontsCache);
+		void SetParallelFontSubsetting(bool inParallelFontSubsetting,unsigned int inThreadsCount = 0);
 		PDFHummus::EStatusCode	WriteHeader(EPDFVersion inPDFVersion);
 		PDFHummus::EStatusCode	FinalizeNewPDF();
         PDFHummus::EStatusCode	FinalizeModifiedPDF(PDFParser* inModifiedFileParser,EPDFVersion inModifiedPDFVersion);
@@ -0,0 +1,47 @@
+/*
+   Source File : FlateEncodingOptions.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+/*
+	Flate compression parameters, as passed to zlib deflateInit2.
+	Level is 0 (no compression) to 9 (best compression), or -1 for zlib default (6). lower levels are faster, at the cost of bigger output.
+	Strategy is one of the zlib strategies - 0 default, 1 filtered, 2 huffman only, 3 rle, 4 fixed.
+	MemoryLevel is 1 to 9, 8 being zlib default. higher uses more memory for better speed and compression.
+*/
+
+struct FlateEncodingOptions
+{
+	int Level;
+	int Strategy;
+	int MemoryLevel;
+
+	FlateEncodingOptions(int inLevel = -1,int inStrategy = 0,int inMemoryLevel = 8) {
+		Level = inLevel;
+		Strategy = inStrategy;
+		MemoryLevel = inMemoryLevel;
+	}
+
+	bool operator==(const FlateEncodingOptions& inOther) const {
+		return Level == inOther.Level && Strategy == inOther.Strategy && MemoryLevel == inOther.MemoryLevel;
+	}
+
+	static const FlateEncodingOptions& DefaultFlateEncodingOptions();
+};
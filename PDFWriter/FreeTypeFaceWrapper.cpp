@@ -26,12 +26,14 @@
 #include "BetweenIncluding.h"
 #include "WrittenFontCFF.h"
 #include "WrittenFontTrueType.h"
+#include "SharedFontsCache.h"
 
 #include <math.h>
 
 #include FT_XFREE86_H 
 #include FT_CID_H 
 #include FT_OUTLINE_H
+#include FT_GLYPH_H
 
 
 using namespace PDFHummus;
@@ -42,6 +44,7 @@ FreeTypeFaceWrapper::FreeTypeFaceWrapper(FT_Face inFace,const std::string& inFon
 	mFontFilePath = inFontFilePath;
 	mFontIndex = inFontIndex;
 	mDoesOwn = inDoOwn;
+	mFontsCache = NULL;
 	mGlyphIsLoaded = false;
 	SetupFormatSpecificExtender(inFontFilePath, "");
 	SelectDefaultEncoding();
@@ -53,6 +56,7 @@ FreeTypeFaceWrapper::FreeTypeFaceWrapper(FT_Face inFace,const std::string& inFon
 	mFontFilePath = inFontFilePath;
     mFontIndex = inFontIndex;
 	mDoesOwn = inDoOwn;
+	mFontsCache = NULL;
 	mGlyphIsLoaded = false;
 	std::string fileExtension = GetExtension(inPFMFilePath);
 	if (fileExtension == "PFM" || fileExtension == "pfm") // just don't bother if it's not PFM
@@ -154,6 +158,16 @@ const char* FreeTypeFaceWrapper::GetTypeString()
 }
 
 
+void FreeTypeFaceWrapper::SetFontsCache(SharedFontsCache* inFontsCache)
+{
+	mFontsCache = inFontsCache;
+}
+
+SharedFontsCache* FreeTypeFaceWrapper::GetFontsCache()
+{
+	return mFontsCache;
+}
+
 FT_Face FreeTypeFaceWrapper::operator->()
 {
 	return mFace;
@@ -173,10 +187,16 @@ FT_Error FreeTypeFaceWrapper::DoneFace()
 {
 	if(mFace)
 	{
-		FT_Error status = FT_Done_Face(mFace);
+		FT_Error status = 0;
+		if(mFontsCache)
+			mFontsCache->ReleaseFace(mFace);
+		else
+			status = FT_Done_Face(mFace);
 		mFace = NULL;
 		delete mFormatParticularWrapper;
 		mFormatParticularWrapper = NULL;
+		mCharactersToGlyphs.Clear();
+		mGlyphsMetrics.Clear();
 		return status;
 	}
 	else
@@ -583,31 +603,37 @@ EStatusCode FreeTypeFaceWrapper::GetGlyphsForUnicodeText(const ULongList& inUnic
 {
 	if(mFace)
 	{
-		FT_UInt glyphIndex;
 		EStatusCode status = PDFHummus::eSuccess;
+		bool found;
 
 		outGlyphs.clear();
 
 		ULongList::const_iterator it = inUnicodeCharacters.begin();
 		for(; it != inUnicodeCharacters.end(); ++it)
 		{
-			if ( mFormatParticularWrapper && mFormatParticularWrapper->HasPrivateEncoding() ) {
-					glyphIndex = mFormatParticularWrapper->GetGlyphForUnicodeChar(*it);
-				// glyphIndex == 0 is allowed in some Type1 fonts with custom encoding
-			}
-			else
-			{
-				FT_ULong charCode = *it;
-				if (mUsePUACodes &&  charCode <= 0xff) // move charcode to pua are in case we should use pua and they are in plain ascii range
-					charCode = 0xF000 | charCode;
-				glyphIndex =  FT_Get_Char_Index(mFace,charCode);
-				if(0 == glyphIndex)
-				{
-					TRACE_LOG1("FreeTypeFaceWrapper::GetGlyphsForUnicodeText, failed to find glyph for charachter 0x%04x",*it);
-					status = PDFHummus::eFailure;
-				}
-			}
-			outGlyphs.push_back(glyphIndex);
+			outGlyphs.push_back(GetGlyphForUnicodeChar(*it,found));
+			if(!found)
+				status = PDFHummus::eFailure;
+		}
+
+		return status;
+	}
+	else
+		return PDFHummus::eFailure;
+}
+
+EStatusCode FreeTypeFaceWrapper::GetGlyphsForUnicodeText(const unsigned long* inUnicodeCharacters,size_t inCount,unsigned int* outGlyphs)
+{
+	if(mFace)
+	{
+		EStatusCode status = PDFHummus::eSuccess;
+		bool found;
+
+		for(size_t i=0;i<inCount;++i)
+		{
+			outGlyphs[i] = GetGlyphForUnicodeChar(inUnicodeCharacters[i],found);
+			if(!found)
+				status = PDFHummus::eFailure;
 		}
 
 		return status;
@@ -616,6 +642,35 @@ EStatusCode FreeTypeFaceWrapper::GetGlyphsForUnicodeText(const ULongList& inUnic
 		return PDFHummus::eFailure;
 }
 
+unsigned int FreeTypeFaceWrapper::GetGlyphForUnicodeChar(unsigned long inUnicodeCharacter,bool& outFound)
+{
+	unsigned int glyphIndex = mCharactersToGlyphs.Get(inUnicodeCharacter);
+
+	if(UnicodeToGlyphTable::scUnresolved == glyphIndex)
+	{
+		glyphIndex = LookupGlyphForUnicodeChar(inUnicodeCharacter);
+		mCharactersToGlyphs.Set(inUnicodeCharacter,glyphIndex);
+	}
+
+	// glyphIndex == 0 is allowed in some Type1 fonts with custom encoding
+	outFound = glyphIndex != 0 || (mFormatParticularWrapper && mFormatParticularWrapper->HasPrivateEncoding());
+	return glyphIndex;
+}
+
+unsigned int FreeTypeFaceWrapper::LookupGlyphForUnicodeChar(unsigned long inUnicodeCharacter)
+{
+	if(mFormatParticularWrapper && mFormatParticularWrapper->HasPrivateEncoding())
+		return mFormatParticularWrapper->GetGlyphForUnicodeChar(inUnicodeCharacter);
+
+	FT_ULong charCode = inUnicodeCharacter;
+	if (mUsePUACodes &&  charCode <= 0xff) // move charcode to pua are in case we should use pua and they are in plain ascii range
+		charCode = 0xF000 | charCode;
+	FT_UInt glyphIndex = FT_Get_Char_Index(mFace,charCode);
+	if(0 == glyphIndex) // logged once per character, as later lookups are from the table
+		TRACE_LOG1("FreeTypeFaceWrapper::GetGlyphsForUnicodeText, failed to find glyph for charachter 0x%04x",inUnicodeCharacter);
+	return glyphIndex;
+}
+
 EStatusCode FreeTypeFaceWrapper::GetGlyphsForUnicodeText(const ULongListList& inUnicodeCharacters,UIntListList& outGlyphs)
 {
 	UIntList glyphs;
@@ -716,10 +771,78 @@ FT_Pos FreeTypeFaceWrapper::GetInPDFMeasurements(FT_Pos inFontMeasurement)
 
 FT_Pos FreeTypeFaceWrapper::GetGlyphWidth(unsigned int inGlyphIndex)
 {
-	if (LoadGlyph(inGlyphIndex))
-		return 0;
-	else
-		return GetInPDFMeasurements(mFace->glyph->metrics.horiAdvance);
+	GlyphMetrics uncachedMetrics;
+	GlyphMetrics* metrics = GetGlyphMetrics(inGlyphIndex,uncachedMetrics);
+
+	if(!metrics->mHasAdvance)
+		LoadGlyphMetrics(inGlyphIndex,*metrics);
+	return metrics->mAdvance;
+}
+
+void FreeTypeFaceWrapper::GetGlyphsWidths(const unsigned int* inGlyphs,size_t inCount,FT_Pos* outWidths)
+{
+	for(size_t i=0;i<inCount;++i)
+	{
+		GlyphMetrics* metrics = mGlyphsMetrics.Find(inGlyphs[i]);
+		outWidths[i] = (metrics && metrics->mHasAdvance) ? metrics->mAdvance : GetGlyphWidth(inGlyphs[i]);
+	}
+}
+
+bool FreeTypeFaceWrapper::GetGlyphBBox(unsigned int inGlyphIndex,FT_BBox& outBBox)
+{
+	GlyphMetrics uncachedMetrics;
+	GlyphMetrics* metrics = GetGlyphMetrics(inGlyphIndex,uncachedMetrics);
+
+	if(!metrics->mHasBBox)
+		LoadGlyphMetrics(inGlyphIndex,*metrics);
+	outBBox = metrics->mBBox;
+	return !metrics->mBBoxFailed;
+}
+
+GlyphMetrics* FreeTypeFaceWrapper::GetGlyphMetrics(unsigned int inGlyphIndex,GlyphMetrics& ioUncachedMetrics)
+{
+	if(!mFace || !GlyphMetricsTable::IsInRange(inGlyphIndex))
+	{
+		// not kept, so the caller's metrics are used
+		ioUncachedMetrics.mHasAdvance = false;
+		ioUncachedMetrics.mHasBBox = false;
+		ioUncachedMetrics.mBBoxFailed = false;
+		return &ioUncachedMetrics;
+	}
+
+	return mGlyphsMetrics.Get(inGlyphIndex);
+}
+
+void FreeTypeFaceWrapper::LoadGlyphMetrics(unsigned int inGlyphIndex,GlyphMetrics& ioMetrics)
+{
+	FT_Glyph aGlyph;
+
+	ioMetrics.mHasBBox = true;
+	if(!mFace || LoadGlyph(inGlyphIndex) != 0 || FT_Get_Glyph(mFace->glyph,&aGlyph) != 0)
+	{
+		if(!ioMetrics.mHasAdvance)
+		{
+			ioMetrics.mAdvance = 0;
+			ioMetrics.mHasAdvance = true;
+		}
+		ioMetrics.mBBox.xMin = ioMetrics.mBBox.yMin = ioMetrics.mBBox.xMax = ioMetrics.mBBox.yMax = 0;
+		ioMetrics.mBBoxFailed = true;
+		return;
+	}
+
+	// loaded anyways, so keep both the advance and the box
+	if(!ioMetrics.mHasAdvance)
+	{
+		ioMetrics.mAdvance = GetInPDFMeasurements(mFace->glyph->metrics.horiAdvance);
+		ioMetrics.mHasAdvance = true;
+	}
+	FT_Glyph_Get_CBox(aGlyph,FT_GLYPH_BBOX_UNSCALED,&ioMetrics.mBBox);
+	FT_Done_Glyph(aGlyph);
+	ioMetrics.mBBox.xMin = GetInPDFMeasurements(ioMetrics.mBBox.xMin);
+	ioMetrics.mBBox.xMax = GetInPDFMeasurements(ioMetrics.mBBox.xMax);
+	ioMetrics.mBBox.yMin = GetInPDFMeasurements(ioMetrics.mBBox.yMin);
+	ioMetrics.mBBox.yMax = GetInPDFMeasurements(ioMetrics.mBBox.yMax);
+	ioMetrics.mBBoxFailed = false;
 }
 
 unsigned int FreeTypeFaceWrapper::GetGlyphIndexInFreeTypeIndexes(unsigned int inGlyphIndex)
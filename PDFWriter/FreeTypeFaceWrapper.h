@@ -22,6 +22,7 @@
 
 #include "EFontStretch.h"
 #include "EStatusCode.h"
+#include "GlyphLookupTables.h"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -34,6 +35,7 @@
 class IFreeTypeFaceExtender;
 class IWrittenFont;
 class ObjectsContext;
+class SharedFontsCache;
 
 
 
@@ -63,6 +65,10 @@ public:
 
 	FT_Error DoneFace();
 
+	// when the face was acquired from a fonts cache, set it here so the face is returned to the cache instead of being done with
+	void SetFontsCache(SharedFontsCache* inFontsCache);
+	SharedFontsCache* GetFontsCache();
+
 	FT_Face operator->();
 	operator FT_Face();
 
@@ -70,6 +76,8 @@ public:
 
 	PDFHummus::EStatusCode GetGlyphsForUnicodeText(const ULongList& inUnicodeCharacters,UIntList& outGlyphs);
 	PDFHummus::EStatusCode GetGlyphsForUnicodeText(const ULongListList& inUnicodeCharacters,UIntListList& outGlyphs);
+	// array form, for text layout. characters are looked up once per face, and later found in a table
+	PDFHummus::EStatusCode GetGlyphsForUnicodeText(const unsigned long* inUnicodeCharacters,size_t inCount,unsigned int* outGlyphs);
 
 	std::string GetPostscriptName();
 	double GetItalicAngle();
@@ -83,6 +91,10 @@ public:
 	const char* GetTypeString();
 	std::string GetGlyphName(unsigned int inGlyphIndex, bool safe= false);
     FT_Pos GetGlyphWidth(unsigned int inGlyphIndex);
+	// widths of multiple glyphs, and a glyph unscaled control box. both aligned to pdf metrics. the metrics are kept per face,
+	// so a glyph is loaded once for both. GetGlyphBBox returns false if the glyph can't be loaded
+	void GetGlyphsWidths(const unsigned int* inGlyphs,size_t inCount,FT_Pos* outWidths);
+	bool GetGlyphBBox(unsigned int inGlyphIndex,FT_BBox& outBBox);
 	bool GetGlyphOutline(unsigned int inGlyphIndex, IOutlineEnumerator& inEnumerator);
 
 	// Create the written font object, matching to write this font in the best way.
@@ -131,6 +143,9 @@ private:
 	unsigned int mCurrentGlyph;
 	bool mDoesOwn;
 	bool mUsePUACodes;
+	SharedFontsCache* mFontsCache;
+	UnicodeToGlyphTable mCharactersToGlyphs;
+	GlyphMetricsTable mGlyphsMetrics;
 
 	BoolAndFTShort GetCapHeightInternal(); 
 	BoolAndFTShort GetxHeightInternal(); 
@@ -138,6 +153,10 @@ private:
 
 
 	std::string GetExtension(const std::string& inFilePath);
+	unsigned int GetGlyphForUnicodeChar(unsigned long inUnicodeCharacter,bool& outFound);
+	unsigned int LookupGlyphForUnicodeChar(unsigned long inUnicodeCharacter);
+	GlyphMetrics* GetGlyphMetrics(unsigned int inGlyphIndex,GlyphMetrics& ioUncachedMetrics);
+	void LoadGlyphMetrics(unsigned int inGlyphIndex,GlyphMetrics& ioMetrics);
 	void SetupFormatSpecificExtender(const std::string& inFilePath, const std::string& inPFMFilePath);
 	BoolAndFTShort CapHeightFromHHeight();
 	BoolAndFTShort XHeightFromLowerXHeight();
@@ -0,0 +1,92 @@
+/*
+   Source File : GlyphLookupTables.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "GlyphLookupTables.h"
+
+#define PAGE_SIZE (256)
+
+UnicodeToGlyphTable::UnicodeToGlyphTable(void)
+{
+}
+
+UnicodeToGlyphTable::~UnicodeToGlyphTable(void)
+{
+	Clear();
+}
+
+void UnicodeToGlyphTable::Set(unsigned long inCharacter,unsigned int inGlyph)
+{
+	if(!IsInRange(inCharacter))
+		return;
+
+	unsigned long pageIndex = inCharacter >> 8;
+	if(pageIndex >= mPages.size())
+		mPages.resize(pageIndex + 1,NULL);
+	if(!mPages[pageIndex])
+	{
+		mPages[pageIndex] = new unsigned int[PAGE_SIZE];
+		for(int i=0;i<PAGE_SIZE;++i)
+			mPages[pageIndex][i] = scUnresolved;
+	}
+	mPages[pageIndex][inCharacter & 0xFF] = inGlyph;
+}
+
+void UnicodeToGlyphTable::Clear()
+{
+	std::vector<unsigned int*>::iterator it = mPages.begin();
+	for(; it != mPages.end(); ++it)
+		delete[] *it;
+	mPages.clear();
+}
+
+GlyphMetricsTable::GlyphMetricsTable(void)
+{
+}
+
+GlyphMetricsTable::~GlyphMetricsTable(void)
+{
+	Clear();
+}
+
+GlyphMetrics* GlyphMetricsTable::Get(unsigned int inGlyphIndex)
+{
+	unsigned int pageIndex = inGlyphIndex >> 8;
+	if(pageIndex >= mPages.size())
+		mPages.resize(pageIndex + 1,NULL);
+	if(!mPages[pageIndex])
+	{
+		mPages[pageIndex] = new GlyphMetrics[PAGE_SIZE];
+		for(int i=0;i<PAGE_SIZE;++i)
+		{
+			mPages[pageIndex][i].mHasAdvance = false;
+			mPages[pageIndex][i].mHasBBox = false;
+			mPages[pageIndex][i].mBBoxFailed = false;
+		}
+	}
+	return mPages[pageIndex] + (inGlyphIndex & 0xFF);
+}
+
+void GlyphMetricsTable::Clear()
+{
+	std::vector<GlyphMetrics*>::iterator it = mPages.begin();
+	for(; it != mPages.end(); ++it)
+		delete[] *it;
+	mPages.clear();
+}
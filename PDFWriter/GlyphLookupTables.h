@@ -0,0 +1,95 @@
+/*
+   Source File : GlyphLookupTables.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_IMAGE_H
+
+/*
+	Lookup tables for a face, so text layout doesn't go to FreeType for every character and glyph.
+	Both are two level tables of 256 entries pages, and pages are allocated when first written to, so
+	a face only holds pages for the characters and glyphs actually used.
+	The tables only store. FreeTypeFaceWrapper fills them as characters and glyphs are first asked for.
+*/
+
+// unicode characters to glyph indexes
+class UnicodeToGlyphTable
+{
+public:
+	// entries value till set
+	static const unsigned int scUnresolved = 0xFFFFFFFF;
+
+	UnicodeToGlyphTable(void);
+	~UnicodeToGlyphTable(void);
+
+	// false for characters outside of the unicode range, which the table doesn't hold
+	static bool IsInRange(unsigned long inCharacter) {return inCharacter <= 0x10FFFF;}
+
+	// glyph for the character, scUnresolved if not set yet
+	unsigned int Get(unsigned long inCharacter) const
+	{
+		unsigned long pageIndex = inCharacter >> 8;
+		return (pageIndex < mPages.size() && mPages[pageIndex]) ? mPages[pageIndex][inCharacter & 0xFF] : scUnresolved;
+	}
+	void Set(unsigned long inCharacter,unsigned int inGlyph);
+
+	void Clear();
+
+private:
+	std::vector<unsigned int*> mPages;
+};
+
+struct GlyphMetrics
+{
+	FT_Pos mAdvance; // aligned to pdf metrics
+	FT_BBox mBBox; // unscaled control box, aligned to pdf metrics
+	bool mHasAdvance;
+	bool mHasBBox;
+	bool mBBoxFailed; // glyph failed to load, so no box
+};
+
+// glyph indexes to metrics
+class GlyphMetricsTable
+{
+public:
+	GlyphMetricsTable(void);
+	~GlyphMetricsTable(void);
+
+	// false for glyph indexes beyond 16 bits, which the table doesn't hold
+	static bool IsInRange(unsigned int inGlyphIndex) {return inGlyphIndex <= 0xFFFF;}
+
+	// metrics of the glyph, NULL if the glyph page wasn't created yet
+	GlyphMetrics* Find(unsigned int inGlyphIndex)
+	{
+		unsigned int pageIndex = inGlyphIndex >> 8;
+		return (pageIndex < mPages.size() && mPages[pageIndex]) ? mPages[pageIndex] + (inGlyphIndex & 0xFF) : NULL;
+	}
+	// metrics of the glyph, creating its page [with no advances or boxes] if not there yet
+	GlyphMetrics* Get(unsigned int inGlyphIndex);
+
+	void Clear();
+
+private:
+	std::vector<GlyphMetrics*> mPages;
+};
@@ -22,6 +22,7 @@
 
 #include <vector>
 #include <list>
+#include <stddef.h>
 
 
 
@@ -50,4 +51,56 @@ struct GlyphUnicodeMapping
 	unsigned short mGlyphCode;	
 };
 
-typedef std::list<GlyphUnicodeMapping> GlyphUnicodeMappingList;
\ No newline at end of file
+typedef std::list<GlyphUnicodeMapping> GlyphUnicodeMappingList;
+
+typedef std::vector<unsigned short> UShortVector;
+
+/*
+	Contiguous form of GlyphUnicodeMappingList, for writing text without allocating per character.
+	glyph i represents the unicode values from mUnicodeValues[mUnicodeOffsets[i]] up to mUnicodeValues[mUnicodeOffsets[i+1]].
+	Clear keeps the allocated memory, so a run may be reused for many strings.
+*/
+struct GlyphRun
+{
+	GlyphRun(){mUnicodeOffsets.push_back(0);}
+
+	UShortVector mGlyphs;
+	ULongVector mUnicodeValues;
+	std::vector<size_t> mUnicodeOffsets;
+
+	void Clear()
+	{
+		mGlyphs.clear();
+		mUnicodeValues.clear();
+		mUnicodeOffsets.clear();
+		mUnicodeOffsets.push_back(0);
+	}
+
+	void AddGlyph(unsigned short inGlyphCode,unsigned long inUnicodeValue)
+	{
+		mGlyphs.push_back(inGlyphCode);
+		mUnicodeValues.push_back(inUnicodeValue);
+		mUnicodeOffsets.push_back(mUnicodeValues.size());
+	}
+
+	void AddGlyph(const GlyphUnicodeMapping& inGlyph)
+	{
+		mGlyphs.push_back(inGlyph.mGlyphCode);
+		mUnicodeValues.insert(mUnicodeValues.end(),inGlyph.mUnicodeValues.begin(),inGlyph.mUnicodeValues.end());
+		mUnicodeOffsets.push_back(mUnicodeValues.size());
+	}
+
+	bool IsEmpty() const {return mGlyphs.empty();}
+	size_t GetGlyphsCount() const {return mGlyphs.size();}
+
+	ULongVector GetUnicodeValues(size_t inGlyphIndex) const
+	{
+		return ULongVector(mUnicodeValues.begin() + mUnicodeOffsets[inGlyphIndex],mUnicodeValues.begin() + mUnicodeOffsets[inGlyphIndex + 1]);
+	}
+
+	void ToList(GlyphUnicodeMappingList& outGlyphs) const
+	{
+		for(size_t i=0;i<mGlyphs.size();++i)
+			outGlyphs.push_back(GlyphUnicodeMapping(mGlyphs[i],GetUnicodeValues(i)));
+	}
+};
\ No newline at end of file
@@ -52,5 +52,22 @@ public:
 	*/
 	virtual void Skip(LongBufferSizeType inSkipSize) = 0;
 
+	/*
+		Optional direct access for readers that hold their whole content in memory (memory mapped files, byte arrays).
+		returns a pointer to the content at the current read position, and in outSpanSize the amount of bytes available from it
+		till the end. the pointer remains valid for as long as the reader content does, and reading through it does not move the
+		read position [use Skip or SetPosition for that].
+		default implementation returns NULL, meaning that direct access is not available and Read should be used.
+	*/
+	virtual const Byte* GetContiguousSpan(LongBufferSizeType& outSpanSize) {outSpanSize = 0; return NULL;}
+
+	/*
+		Optional direct access for short term use, say by a tokenizer that wants to scan without copying. like GetContiguousSpan,
+		but may provide just part of the content [such as what's left in a read buffer], and the pointer is valid only till the next
+		call to any of the reader methods. may return an empty span if nothing is available without blocking on more reading.
+		default implementation returns GetContiguousSpan result
+	*/
+	virtual const Byte* GetTransientSpan(LongBufferSizeType& outSpanSize) {return GetContiguousSpan(outSpanSize);}
+
 
 };
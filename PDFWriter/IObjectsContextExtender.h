@@ -20,6 +20,8 @@
 */
 #pragma once
 
+#include "FlateEncodingOptions.h"
+
 class IByteWriter;
 class IByteWriterWithPosition;
 
@@ -46,4 +48,10 @@ public:
 	// this would allow the PDFStream to calculate the extent on the actual write stream (given as input for GetCompressionWriteStream).
 	virtual void FinalizeCompressedStreamWrite(IByteWriter* inCompressedStream) = 0;
 
+	// GetStreamFlateEncodingOptions is called when PDFStream Object is created, and allows choosing flate compression parameters
+	// per stream (for instance, fast compression for content streams and best compression for fonts). input is the document
+	// options (see PDFCreationSettings), output is the options to use for this stream. not used if OverridesStreamCompression returns true.
+	// optional, the default keeps the document options.
+	virtual FlateEncodingOptions GetStreamFlateEncodingOptions(const FlateEncodingOptions& inDocumentOptions) {return inDocumentOptions;}
+
 };
\ No newline at end of file
@@ -58,11 +58,25 @@ public:
 							  bool& outEncodingIsMultiByte,
 							  ObjectIDType &outFontObjectID) = 0;
 
+	// contiguous form, for writing many strings. outEncodedCharacters is cleared first
+	virtual void AppendGlyphs(const GlyphRun& inGlyphs,
+							  UShortVector& outEncodedCharacters,
+							  bool& outEncodingIsMultiByte,
+							  ObjectIDType &outFontObjectID) = 0;
+
 	/*
 		Write a font definition using the glyphs appended.
 	*/
 	virtual PDFHummus::EStatusCode WriteFontDefinition(FreeTypeFaceWrapper& inFontInfo,bool inEmbedFont) = 0;
 
+	/*
+		Subset the embedded font programs ahead of WriteFontDefinition, which then writes them [see UsedFontsRepository::WriteUsedFontsDefinitions].
+		ReserveFontPrograms reserves the subset fonts names, so call it in the order of writing the fonts definitions.
+		PrepareFontPrograms subsets the fonts, and may run on a worker thread.
+	*/
+	virtual void ReserveFontPrograms(FreeTypeFaceWrapper& inFontInfo) = 0;
+	virtual void PrepareFontPrograms(FreeTypeFaceWrapper& inFontInfo) = 0;
+
 	// state read and write
 	virtual PDFHummus::EStatusCode WriteState(ObjectsContext* inStateWriter,ObjectIDType inObjectID) = 0;
 	virtual PDFHummus::EStatusCode ReadState(PDFParser* inStateReader,ObjectIDType inObjectID) = 0;
@@ -48,6 +48,8 @@ void IndirectObjectsReferenceRegistry::SetupInitialFreeObject()
     singleFreeObjectInformation.mIsDirty = true;
     singleFreeObjectInformation.mGenerationNumber = 65535;
     singleFreeObjectInformation.mWritePosition = 0;
+    singleFreeObjectInformation.mObjectStreamID = 0;
+    singleFreeObjectInformation.mObjectStreamIndex = 0;
 	mObjectsWritesRegistry.push_back(singleFreeObjectInformation);
 }
 
@@ -65,6 +67,9 @@ ObjectIDType IndirectObjectsReferenceRegistry::AllocateNewObjectID()
 	newObjectInformation.mObjectReferenceType = ObjectWriteInformation::Used;
     newObjectInformation.mGenerationNumber = 0;
     newObjectInformation.mIsDirty = true;
+    newObjectInformation.mWritePosition = 0;
+    newObjectInformation.mObjectStreamID = 0;
+    newObjectInformation.mObjectStreamIndex = 0;
 	
 	mObjectsWritesRegistry.push_back(newObjectInformation);
 	return newObjectID;
@@ -94,6 +99,29 @@ EStatusCode IndirectObjectsReferenceRegistry::MarkObjectAsWritten(ObjectIDType i
 
     mObjectsWritesRegistry[inObjectID].mIsDirty = true;
 	mObjectsWritesRegistry[inObjectID].mWritePosition = inWritePosition;
+	mObjectsWritesRegistry[inObjectID].mObjectStreamID = 0;
+	mObjectsWritesRegistry[inObjectID].mObjectWritten = true;
+	return PDFHummus::eSuccess;
+}
+
+EStatusCode IndirectObjectsReferenceRegistry::MarkObjectAsWrittenInObjectStream(ObjectIDType inObjectID,ObjectIDType inObjectStreamID,unsigned long inObjectStreamIndex)
+{
+	if(mObjectsWritesRegistry.size() <= inObjectID)
+	{
+		TRACE_LOG1("IndirectObjectsReferenceRegistry::MarkObjectAsWrittenInObjectStream, Out of range failure. An Object ID is marked as written, which was not allocated before. ID = %ld",inObjectID);
+		return PDFHummus::eFailure; 
+	}
+
+	if(mObjectsWritesRegistry[inObjectID].mObjectWritten)
+	{
+		TRACE_LOG1("IndirectObjectsReferenceRegistry::MarkObjectAsWrittenInObjectStream, Object rewrite failure. The object %ld was already marked as written",inObjectID);
+		return PDFHummus::eFailure;
+	}
+
+    mObjectsWritesRegistry[inObjectID].mIsDirty = true;
+	mObjectsWritesRegistry[inObjectID].mWritePosition = 0;
+	mObjectsWritesRegistry[inObjectID].mObjectStreamID = inObjectStreamID;
+	mObjectsWritesRegistry[inObjectID].mObjectStreamIndex = inObjectStreamIndex;
 	mObjectsWritesRegistry[inObjectID].mObjectWritten = true;
 	return PDFHummus::eSuccess;
 }
@@ -164,6 +192,7 @@ PDFHummus::EStatusCode IndirectObjectsReferenceRegistry::MarkObjectAsUpdated(Obj
     
     mObjectsWritesRegistry[inObjectID].mIsDirty = true;
     mObjectsWritesRegistry[inObjectID].mWritePosition = inNewWritePosition;
+    mObjectsWritesRegistry[inObjectID].mObjectStreamID = 0;
     mObjectsWritesRegistry[inObjectID].mObjectReferenceType = ObjectWriteInformation::Used;
 
     return PDFHummus::eSuccess;
@@ -219,6 +248,15 @@ EStatusCode IndirectObjectsReferenceRegistry::WriteState(ObjectsContext* inState
 		{
 			registryDictionary->WriteKey("mWritePosition");
 			registryDictionary->WriteIntegerValue(it->mWritePosition);
+
+			if(it->mObjectStreamID != 0)
+			{
+				registryDictionary->WriteKey("mObjectStreamID");
+				registryDictionary->WriteIntegerValue(it->mObjectStreamID);
+
+				registryDictionary->WriteKey("mObjectStreamIndex");
+				registryDictionary->WriteIntegerValue(it->mObjectStreamIndex);
+			}
 		}
 
 		registryDictionary->WriteKey("mObjectReferenceType");
@@ -256,11 +294,22 @@ EStatusCode IndirectObjectsReferenceRegistry::ReadState(PDFParser* inStateReader
 		PDFObjectCastPtr<PDFBoolean> objectWritten(objectWriteInformationDictionary->QueryDirectObject("mObjectWritten"));
 
 		newObjectInformation.mObjectWritten = objectWritten->GetValue();
+		newObjectInformation.mObjectStreamID = 0;
+		newObjectInformation.mObjectStreamIndex = 0;
 
 		if(newObjectInformation.mObjectWritten)
 		{
 			PDFObjectCastPtr<PDFInteger> writePosition(objectWriteInformationDictionary->QueryDirectObject("mWritePosition"));
 			newObjectInformation.mWritePosition = writePosition->GetValue();
+
+			// object stream entries only exist for objects written into object streams (and in newer state files)
+			PDFObjectCastPtr<PDFInteger> objectStreamID(objectWriteInformationDictionary->QueryDirectObject("mObjectStreamID"));
+			if(!!objectStreamID)
+			{
+				PDFObjectCastPtr<PDFInteger> objectStreamIndex(objectWriteInformationDictionary->QueryDirectObject("mObjectStreamIndex"));
+				newObjectInformation.mObjectStreamID = (ObjectIDType)objectStreamID->GetValue();
+				newObjectInformation.mObjectStreamIndex = (unsigned long)objectStreamIndex->GetValue();
+			}
 		}
 
 		PDFObjectCastPtr<PDFInteger> objectReferenceType(objectWriteInformationDictionary->QueryDirectObject("mObjectReferenceType"));
@@ -298,6 +347,8 @@ void IndirectObjectsReferenceRegistry::AppendExistingItem(
     newObjectInformation.mGenerationNumber = inGenerationNumber;
     newObjectInformation.mIsDirty = false;
     newObjectInformation.mWritePosition = (inObjectReferenceType == ObjectWriteInformation::Used) ? inWritePosition:0;
+    newObjectInformation.mObjectStreamID = 0;
+    newObjectInformation.mObjectStreamIndex = 0;
 	
 	mObjectsWritesRegistry.push_back(newObjectInformation);
     
@@ -309,11 +360,11 @@ void IndirectObjectsReferenceRegistry::SetupXrefFromModifiedFile(PDFParser* inMo
     // kind of easy, just read the xref from the parer into the existing parser [skip first element, which is the free element]
     for(ObjectIDType i = 1; i < inModifiedFileParser->GetXrefSize(); ++i)
     {
-        XrefEntryInput* anEntry = inModifiedFileParser->GetXrefEntry(i);
+        XrefEntryInput anEntry = inModifiedFileParser->GetXrefEntry(i);
         AppendExistingItem(
-            anEntry->mType != eXrefEntryDelete ? ObjectWriteInformation::Used : ObjectWriteInformation::Free,
-                           anEntry->mType != eXrefEntryStreamObject ? anEntry->mRivision:0,
-            anEntry->mObjectPosition);       
+            anEntry.mType != eXrefEntryDelete ? ObjectWriteInformation::Used : ObjectWriteInformation::Free,
+                           anEntry.mType != eXrefEntryStreamObject ? anEntry.mRivision:0,
+            anEntry.mObjectPosition);       
     }
     
 }
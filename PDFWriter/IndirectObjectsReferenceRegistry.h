@@ -56,6 +56,10 @@ struct ObjectWriteInformation
 	EObjectReferenceType mObjectReferenceType;
     // object generation number
     unsigned long mGenerationNumber;
+    // for objects written into an object stream (PDF 1.5) - the containing object stream ID and the object index in it.
+    // mObjectStreamID is 0 for objects written directly to the file, in which case mWritePosition holds their position
+    ObjectIDType mObjectStreamID;
+    unsigned long mObjectStreamIndex;
 };
 
 typedef std::pair<bool,ObjectWriteInformation> GetObjectWriteInformationResult;
@@ -70,6 +74,7 @@ public:
 	ObjectIDType AllocateNewObjectID();
 	
 	PDFHummus::EStatusCode MarkObjectAsWritten(ObjectIDType inObjectID,LongFilePositionType inWritePosition);
+	PDFHummus::EStatusCode MarkObjectAsWrittenInObjectStream(ObjectIDType inObjectID,ObjectIDType inObjectStreamID,unsigned long inObjectStreamIndex);
 	GetObjectWriteInformationResult GetObjectWriteInformation(ObjectIDType inObjectID) const;
 
 	ObjectIDType GetObjectsCount() const;
@@ -139,6 +139,16 @@ void InputBufferedStream::Skip(LongBufferSizeType inSkipSize)
 
 void InputBufferedStream::SetPosition(LongFilePositionType inOffsetFromStart)
 {
+	// if the new position is within what's already buffered, just move there. saves re-reading the buffer
+	// when jumping around a small area, which is common when parsing objects
+	LongFilePositionType bufferEndPosition = mSourceStream->GetCurrentPosition();
+	LongFilePositionType bufferStartPosition = bufferEndPosition - (mLastAvailableIndex - mBuffer);
+	if(mLastAvailableIndex != mBuffer && inOffsetFromStart >= bufferStartPosition && inOffsetFromStart <= bufferEndPosition)
+	{
+		mCurrentBufferIndex = mBuffer + (inOffsetFromStart - bufferStartPosition);
+		return;
+	}
+
 	mLastAvailableIndex = mCurrentBufferIndex = mBuffer;
 	mSourceStream->SetPosition(inOffsetFromStart);
 }
@@ -159,4 +169,23 @@ LongFilePositionType InputBufferedStream::GetCurrentPosition()
 	// when reading the current position is the current stream position minus how much is left
 	// to read from the buffer
 	return mSourceStream->GetCurrentPosition() - (mLastAvailableIndex - mCurrentBufferIndex);
-}
\ No newline at end of file
+}
+
+const Byte* InputBufferedStream::GetTransientSpan(LongBufferSizeType& outSpanSize)
+{
+	if(!mSourceStream)
+	{
+		outSpanSize = 0;
+		return NULL;
+	}
+
+	// fill the buffer if it's all read, so there's something to provide
+	if(mCurrentBufferIndex == mLastAvailableIndex && mSourceStream->NotEnded())
+	{
+		mLastAvailableIndex = mBuffer + mSourceStream->Read(mBuffer,mBufferSize);
+		mCurrentBufferIndex = mBuffer;
+	}
+
+	outSpanSize = mLastAvailableIndex - mCurrentBufferIndex;
+	return mCurrentBufferIndex;
+}
@@ -62,6 +62,7 @@ public:
 	virtual void SetPosition(LongFilePositionType inOffsetFromStart);
 	virtual void SetPositionFromEnd(LongFilePositionType inOffsetFromEnd);
 	virtual LongFilePositionType GetCurrentPosition();
+	virtual const Byte* GetTransientSpan(LongBufferSizeType& outSpanSize);
 
 	IByteReaderWithPosition* GetSourceStream();
 
@@ -85,3 +85,15 @@ LongFilePositionType InputByteArrayStream::GetCurrentPosition()
 {
 	return mCurrentPosition;
 }
+
+const Byte* InputByteArrayStream::GetContiguousSpan(LongBufferSizeType& outSpanSize)
+{
+	if(!mByteArray)
+	{
+		outSpanSize = 0;
+		return NULL;
+	}
+
+	outSpanSize = (LongBufferSizeType)(mArrayLength-mCurrentPosition);
+	return mByteArray+mCurrentPosition;
+}
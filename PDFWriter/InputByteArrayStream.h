@@ -38,6 +38,7 @@ public:
 	virtual void SetPosition(LongFilePositionType inOffsetFromStart);
 	virtual void SetPositionFromEnd(LongFilePositionType inOffsetFromEnd);
 	virtual LongFilePositionType GetCurrentPosition();
+	virtual const IOBasicTypes::Byte* GetContiguousSpan(LongBufferSizeType& outSpanSize);
 
 private:
 
@@ -21,6 +21,7 @@
 #include "InputFile.h"
 #include "InputBufferedStream.h"
 #include "InputFileStream.h"
+#include "InputMemoryMappedFileStream.h"
 #include "Trace.h"
 
 using namespace PDFHummus;
@@ -29,6 +30,7 @@ InputFile::InputFile(void)
 {
 	mInputStream = NULL;
 	mFileStream = NULL;
+	mMappedFileStream = NULL;
 }
 
 InputFile::~InputFile(void)
@@ -36,7 +38,7 @@ InputFile::~InputFile(void)
 	CloseFile();
 }
 
-EStatusCode InputFile::OpenFile(const std::string& inFilePath)
+EStatusCode InputFile::OpenFile(const std::string& inFilePath,bool inMemoryMap)
 {
 	EStatusCode status;
 	do
@@ -47,6 +49,21 @@ EStatusCode InputFile::OpenFile(const std::string& inFilePath)
 			TRACE_LOG1("InputFile::OpenFile, Unexpected Failure. Couldn't close previously open file - %s",mFilePath.c_str());
 			break;
 		}
+
+		if(inMemoryMap)
+		{
+			InputMemoryMappedFileStream* mappedFileStream = new InputMemoryMappedFileStream();
+			if(mappedFileStream->Open(inFilePath) == PDFHummus::eSuccess)
+			{
+				// no buffering required, reads are already from memory
+				mInputStream = mappedFileStream;
+				mMappedFileStream = mappedFileStream;
+				mFilePath = inFilePath;
+				break;
+			}
+			delete mappedFileStream;
+			// fallback to regular reading
+		}
 	
 		InputFileStream* inputFileStream = new InputFileStream();
 		status = inputFileStream->Open(inFilePath); // explicitly open, so status may be retrieved
@@ -72,11 +89,12 @@ EStatusCode InputFile::CloseFile()
 	}
 	else
 	{
-		EStatusCode status = mFileStream->Close(); // explicitly close, so status may be retrieved
+		EStatusCode status = mMappedFileStream ? mMappedFileStream->Close() : mFileStream->Close(); // explicitly close, so status may be retrieved
 
 		delete mInputStream; // will delete the referenced file stream as well
 		mInputStream = NULL;
 		mFileStream = NULL;
+		mMappedFileStream = NULL;
 		return status;
 	}
 }
@@ -94,12 +112,10 @@ const std::string& InputFile::GetFilePath()
 
 LongFilePositionType InputFile::GetFileSize()
 {
-	if(mInputStream)
-	{
-		InputFileStream* inputFileStream = (InputFileStream*)mInputStream->GetSourceStream();
-
-		return inputFileStream->GetFileSize();
-	}
+	if(mMappedFileStream)
+		return mMappedFileStream->GetFileSize();
+	else if(mFileStream)
+		return mFileStream->GetFileSize();
 	else
 		return 0;
 }
\ No newline at end of file
@@ -26,6 +26,7 @@
 
 class InputBufferedStream;
 class InputFileStream;
+class InputMemoryMappedFileStream;
 
 
 
@@ -35,16 +36,19 @@ public:
 	InputFile(void);
 	~InputFile(void);
 
-	PDFHummus::EStatusCode OpenFile(const std::string& inFilePath);
+	// pass true for inMemoryMap to map the file to memory instead of reading it through a buffered file stream.
+	// faster for large files. if mapping fails [e.g. empty file] the file is opened as a regular file
+	PDFHummus::EStatusCode OpenFile(const std::string& inFilePath,bool inMemoryMap = false);
 	PDFHummus::EStatusCode CloseFile();
 
-	IByteReaderWithPosition* GetInputStream(); // returns buffered input stream
+	IByteReaderWithPosition* GetInputStream(); // returns buffered input stream, or the memory mapped stream if mapped
 	const std::string& GetFilePath();
 	
 	LongFilePositionType GetFileSize();
 
 private:
 	std::string mFilePath;
-	InputBufferedStream* mInputStream;
+	IByteReaderWithPosition* mInputStream;
 	InputFileStream* mFileStream;
+	InputMemoryMappedFileStream* mMappedFileStream;
 };
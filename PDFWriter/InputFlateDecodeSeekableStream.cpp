@@ -0,0 +1,408 @@
+/*
+   Source File : InputFlateDecodeSeekableStream.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "InputFlateDecodeSeekableStream.h"
+
+#include "Trace.h"
+#include "zlib.h"
+
+#include <string.h>
+#include <algorithm>
+
+#define INPUT_BUFFER_SIZE (16*1024)
+// deflate's maximum back reference distance
+#define WINDOW_SIZE (32*1024)
+
+using namespace IOBasicTypes;
+
+FlateDecodeIndex::FlateDecodeIndex(LongBufferSizeType inCheckpointsInterval)
+{
+	mCheckpointsInterval = inCheckpointsInterval;
+	mIndexedPosition = 0;
+}
+
+FlateDecodeIndex::~FlateDecodeIndex(void)
+{
+	std::vector<FlateDecodeCheckpoint*>::iterator it = mCheckpoints.begin();
+	for(; it != mCheckpoints.end(); ++it)
+		delete *it;
+}
+
+LongBufferSizeType FlateDecodeIndex::GetCheckpointsInterval() const
+{
+	return mCheckpointsInterval;
+}
+
+static bool CheckpointBefore(LongFilePositionType inDecodedPosition, const FlateDecodeCheckpoint* inCheckpoint)
+{
+	return inDecodedPosition < inCheckpoint->mDecodedPosition;
+}
+
+const FlateDecodeCheckpoint* FlateDecodeIndex::FindCheckpoint(LongFilePositionType inDecodedPosition) const
+{
+	// checkpoints are sorted by decoded position. find the first one after the position, and step back
+	std::vector<FlateDecodeCheckpoint*>::const_iterator it = std::upper_bound(mCheckpoints.begin(),mCheckpoints.end(),inDecodedPosition,CheckpointBefore);
+	if(it == mCheckpoints.begin())
+		return NULL;
+	--it;
+	return *it;
+}
+
+FlateDecodeCheckpoint* FlateDecodeIndex::AddCheckpoint()
+{
+	FlateDecodeCheckpoint* checkpoint = new FlateDecodeCheckpoint();
+	mCheckpoints.push_back(checkpoint);
+	return checkpoint;
+}
+
+LongFilePositionType FlateDecodeIndex::GetIndexedPosition() const
+{
+	return mIndexedPosition;
+}
+
+void FlateDecodeIndex::SetIndexedPosition(LongFilePositionType inDecodedPosition)
+{
+	if(inDecodedPosition > mIndexedPosition)
+		mIndexedPosition = inDecodedPosition;
+}
+
+size_t FlateDecodeIndex::GetCheckpointsCount() const
+{
+	return mCheckpoints.size();
+}
+
+LongBufferSizeType FlateDecodeIndex::GetMemorySize() const
+{
+	LongBufferSizeType result = 0;
+	std::vector<FlateDecodeCheckpoint*>::const_iterator it = mCheckpoints.begin();
+	for(; it != mCheckpoints.end(); ++it)
+		result += sizeof(FlateDecodeCheckpoint) + (*it)->mWindow.size();
+	return result;
+}
+
+InputFlateDecodeSeekableStream::InputFlateDecodeSeekableStream(IByteReaderWithPosition* inSource,
+																LongFilePositionType inEncodedStart,
+																LongBufferSizeType inEncodedLength,
+																FlateDecodeIndex* inIndex)
+{
+	mSource = inSource;
+	mEncodedStart = inEncodedStart;
+	mEncodedLength = inEncodedLength;
+	mIndex = inIndex;
+	mZLibState = new z_stream;
+	mZLibStateActive = false;
+	mInputBuffer = new Byte[INPUT_BUFFER_SIZE];
+	mWindow = new Byte[WINDOW_SIZE];
+	mRestartsCount = 0;
+	mDecodedBytesCount = 0;
+
+	Restart(NULL);
+}
+
+InputFlateDecodeSeekableStream::~InputFlateDecodeSeekableStream(void)
+{
+	EndZLibState();
+	delete mZLibState;
+	delete[] mInputBuffer;
+	delete[] mWindow;
+}
+
+void InputFlateDecodeSeekableStream::EndZLibState()
+{
+	if(mZLibStateActive)
+	{
+		inflateEnd(mZLibState);
+		mZLibStateActive = false;
+	}
+}
+
+bool InputFlateDecodeSeekableStream::Restart(const FlateDecodeCheckpoint* inCheckpoint)
+{
+	EndZLibState();
+
+	mZLibState->zalloc = Z_NULL;
+	mZLibState->zfree = Z_NULL;
+	mZLibState->opaque = Z_NULL;
+	mZLibState->avail_in = 0;
+	mZLibState->next_in = Z_NULL;
+	mEnded = false;
+	mFailed = true;
+	mWindowWritePosition = 0;
+
+	int inflateStatus;
+	if(!inCheckpoint)
+	{
+		// from the start, including the zlib header
+		mEncodedPosition = 0;
+		mDecodedPosition = 0;
+		mReadPosition = 0;
+		inflateStatus = inflateInit(mZLibState);
+		if(inflateStatus != Z_OK)
+		{
+			TRACE_LOG1("InputFlateDecodeSeekableStream::Restart, Unexpected failure in initializating flate library. status code = %d",inflateStatus);
+			return false;
+		}
+		mZLibStateActive = true;
+		mFailed = false;
+		return true;
+	}
+
+	// from a checkpoint. checkpoints are at deflate block boundaries, so decode raw deflate data from there on
+	inflateStatus = inflateInit2(mZLibState,-15);
+	if(inflateStatus != Z_OK)
+	{
+		TRACE_LOG1("InputFlateDecodeSeekableStream::Restart, Unexpected failure in initializating flate library. status code = %d",inflateStatus);
+		return false;
+	}
+	mZLibStateActive = true;
+
+	if(inCheckpoint->mBits != 0)
+	{
+		// the block starts in the middle of the previous byte. feed the decoder its remaining bits
+		Byte partialByte;
+		mSource->SetPosition(mEncodedStart + inCheckpoint->mEncodedPosition - 1);
+		if(mSource->Read(&partialByte,1) != 1)
+		{
+			TRACE_LOG("InputFlateDecodeSeekableStream::Restart, failed to read from source stream");
+			return false;
+		}
+		inflatePrime(mZLibState,inCheckpoint->mBits,partialByte >> (8 - inCheckpoint->mBits));
+	}
+	inflateStatus = inflateSetDictionary(mZLibState,(const Bytef*)&(inCheckpoint->mWindow[0]),(uInt)inCheckpoint->mWindow.size());
+	if(inflateStatus != Z_OK)
+	{
+		TRACE_LOG1("InputFlateDecodeSeekableStream::Restart, failed to set decoding window. status code = %d",inflateStatus);
+		return false;
+	}
+
+	// the window is the history of the decoded data, keep it for reading back
+	memcpy(mWindow,&(inCheckpoint->mWindow[0]),inCheckpoint->mWindow.size());
+	mWindowWritePosition = inCheckpoint->mWindow.size() % WINDOW_SIZE;
+	mEncodedPosition = inCheckpoint->mEncodedPosition;
+	mDecodedPosition = inCheckpoint->mDecodedPosition;
+	mReadPosition = mDecodedPosition;
+	mFailed = false;
+	return true;
+}
+
+bool InputFlateDecodeSeekableStream::FillInput()
+{
+	if(mEncodedPosition >= (LongFilePositionType)mEncodedLength)
+		return false;
+
+	// others may have moved the source since the last read
+	LongBufferSizeType readSize = std::min<LongBufferSizeType>(INPUT_BUFFER_SIZE,mEncodedLength - (LongBufferSizeType)mEncodedPosition);
+	mSource->SetPosition(mEncodedStart + mEncodedPosition);
+	LongBufferSizeType readAmount = mSource->Read(mInputBuffer,readSize);
+	if(0 == readAmount)
+		return false;
+
+	mEncodedPosition += readAmount;
+	mZLibState->avail_in = (uInt)readAmount;
+	mZLibState->next_in = (Bytef*)mInputBuffer;
+	return true;
+}
+
+LongBufferSizeType InputFlateDecodeSeekableStream::GetHistorySize() const
+{
+	return mDecodedPosition < WINDOW_SIZE ? (LongBufferSizeType)mDecodedPosition : WINDOW_SIZE;
+}
+
+void InputFlateDecodeSeekableStream::RecordCheckpoint()
+{
+	FlateDecodeCheckpoint* checkpoint = mIndex->AddCheckpoint();
+
+	checkpoint->mDecodedPosition = mDecodedPosition;
+	// position of the first byte not fully consumed. when bits are left over from the previous byte, it's the one after it
+	checkpoint->mEncodedPosition = mEncodedPosition - mZLibState->avail_in;
+	checkpoint->mBits = mZLibState->data_type & 7;
+
+	// the window, oldest byte first
+	LongBufferSizeType historySize = GetHistorySize();
+	checkpoint->mWindow.resize(historySize);
+	if(historySize < WINDOW_SIZE)
+	{
+		memcpy(&(checkpoint->mWindow[0]),mWindow,historySize);
+	}
+	else
+	{
+		memcpy(&(checkpoint->mWindow[0]),mWindow + mWindowWritePosition,WINDOW_SIZE - mWindowWritePosition);
+		if(mWindowWritePosition > 0)
+			memcpy(&(checkpoint->mWindow[WINDOW_SIZE - mWindowWritePosition]),mWindow,mWindowWritePosition);
+	}
+}
+
+bool InputFlateDecodeSeekableStream::DecodeMore()
+{
+	if(mEnded || mFailed)
+		return false;
+
+	// decode into the window, after the pending bytes, without overwriting them
+	LongBufferSizeType pendingSize = (LongBufferSizeType)(mDecodedPosition - mReadPosition);
+	LongBufferSizeType freeSize = std::min<LongBufferSizeType>(WINDOW_SIZE - mWindowWritePosition,WINDOW_SIZE - pendingSize);
+	if(0 == freeSize)
+		return false;
+
+	// note that inflate is called even when there's no more input, as it may still hold decoded data that
+	// didn't fit the previous call. Z_BUF_ERROR will signal that there's nothing more to get
+	if(0 == mZLibState->avail_in)
+		FillInput();
+
+	// when decoding data not indexed yet, stop at block boundaries to allow recording checkpoints
+	bool indexing = mIndex && mIndex->GetCheckpointsInterval() > 0 && mDecodedPosition >= mIndex->GetIndexedPosition();
+
+	mZLibState->avail_out = (uInt)freeSize;
+	mZLibState->next_out = (Bytef*)(mWindow + mWindowWritePosition);
+	int inflateResult = inflate(mZLibState,indexing ? Z_BLOCK : Z_NO_FLUSH);
+	if(Z_STREAM_ERROR == inflateResult ||
+	   Z_NEED_DICT == inflateResult ||
+	   Z_DATA_ERROR == inflateResult ||
+	   Z_MEM_ERROR == inflateResult)
+	{
+		TRACE_LOG1("InputFlateDecodeSeekableStream::DecodeMore, failed to read zlib information. returned error code = %d",inflateResult);
+		EndZLibState();
+		mFailed = true;
+		return false;
+	}
+
+	LongBufferSizeType decodedSize = freeSize - mZLibState->avail_out;
+	mWindowWritePosition = (mWindowWritePosition + decodedSize) % WINDOW_SIZE;
+	mDecodedPosition += decodedSize;
+	mDecodedBytesCount += decodedSize;
+
+	if(Z_STREAM_END == inflateResult)
+	{
+		mEnded = true;
+	}
+	else if(Z_BUF_ERROR == inflateResult)
+	{
+		// input ended before the end of compression was marked. take what's there
+		mEnded = true;
+	}
+	else if(indexing && (mZLibState->data_type & 128) && !(mZLibState->data_type & 64))
+	{
+		// at a block boundary, not after the last block. record a checkpoint if enough decoded data passed since the last one
+		const FlateDecodeCheckpoint* lastCheckpoint = mIndex->FindCheckpoint(mDecodedPosition);
+		LongFilePositionType lastCheckpointPosition = lastCheckpoint ? lastCheckpoint->mDecodedPosition : 0;
+		if(mDecodedPosition > mIndex->GetIndexedPosition() &&
+			mDecodedPosition - lastCheckpointPosition >= (LongFilePositionType)mIndex->GetCheckpointsInterval())
+			RecordCheckpoint();
+	}
+
+	if(indexing)
+		mIndex->SetIndexedPosition(mDecodedPosition);
+
+	if(mEnded)
+		EndZLibState();
+	return decodedSize > 0 || !mEnded;
+}
+
+LongBufferSizeType InputFlateDecodeSeekableStream::Read(Byte* inBuffer,LongBufferSizeType inBufferSize)
+{
+	LongBufferSizeType readSize = 0;
+
+	while(readSize < inBufferSize)
+	{
+		LongBufferSizeType pendingSize = (LongBufferSizeType)(mDecodedPosition - mReadPosition);
+		if(0 == pendingSize)
+		{
+			if(!DecodeMore())
+				break;
+			continue;
+		}
+
+		// copy pending bytes from the window, up to its end [the rest will be copied in the next round]
+		LongBufferSizeType pendingStart = (mWindowWritePosition + WINDOW_SIZE - pendingSize) % WINDOW_SIZE;
+		LongBufferSizeType copySize = std::min(std::min(pendingSize,WINDOW_SIZE - pendingStart),inBufferSize - readSize);
+		memcpy(inBuffer + readSize,mWindow + pendingStart,copySize);
+		readSize += copySize;
+		mReadPosition += copySize;
+	}
+
+	return readSize;
+}
+
+bool InputFlateDecodeSeekableStream::NotEnded()
+{
+	return mReadPosition < mDecodedPosition || (!mEnded && !mFailed);
+}
+
+void InputFlateDecodeSeekableStream::DecodeForwardTo(LongFilePositionType inDecodedPosition)
+{
+	// decode and drop everything up to the position
+	while(mDecodedPosition < inDecodedPosition)
+	{
+		mReadPosition = mDecodedPosition;
+		if(!DecodeMore())
+			break;
+	}
+	mReadPosition = std::min(inDecodedPosition,mDecodedPosition);
+}
+
+void InputFlateDecodeSeekableStream::SetPosition(LongFilePositionType inOffsetFromStart)
+{
+	// still in the window
+	if(inOffsetFromStart <= mDecodedPosition && mDecodedPosition - inOffsetFromStart <= (LongFilePositionType)GetHistorySize())
+	{
+		mReadPosition = inOffsetFromStart;
+		return;
+	}
+
+	// jump to the nearest checkpoint, if decoding from the current position would take longer
+	const FlateDecodeCheckpoint* checkpoint = mIndex ? mIndex->FindCheckpoint(inOffsetFromStart) : NULL;
+	if(inOffsetFromStart < mDecodedPosition || mFailed || (checkpoint && checkpoint->mDecodedPosition > mDecodedPosition))
+	{
+		++mRestartsCount;
+		if(!Restart(checkpoint))
+			return;
+	}
+
+	DecodeForwardTo(inOffsetFromStart);
+}
+
+void InputFlateDecodeSeekableStream::SetPositionFromEnd(LongFilePositionType inOffsetFromEnd)
+{
+	// the decoded length is only known by decoding all of it
+	do
+	{
+		mReadPosition = mDecodedPosition;
+	} while(DecodeMore());
+	SetPosition(inOffsetFromEnd > mDecodedPosition ? 0 : mDecodedPosition - inOffsetFromEnd);
+}
+
+void InputFlateDecodeSeekableStream::Skip(LongBufferSizeType inSkipSize)
+{
+	SetPosition(mReadPosition + inSkipSize);
+}
+
+LongFilePositionType InputFlateDecodeSeekableStream::GetCurrentPosition()
+{
+	return mReadPosition;
+}
+
+unsigned long InputFlateDecodeSeekableStream::GetRestartsCount() const
+{
+	return mRestartsCount;
+}
+
+LongBufferSizeType InputFlateDecodeSeekableStream::GetDecodedBytesCount() const
+{
+	return mDecodedBytesCount;
+}
@@ -0,0 +1,135 @@
+/*
+   Source File : InputFlateDecodeSeekableStream.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "IByteReaderWithPosition.h"
+
+#include <vector>
+
+struct z_stream_s;
+typedef z_stream_s z_stream;
+
+/*
+	Flate decoding with random access, following zlib's zran example.
+	InputFlateDecodeSeekableStream decodes flate [zlib] encoded data from a source that allows moving around in it. While
+	decoding, it records checkpoints in a FlateDecodeIndex, at the first deflate block boundary after every so many bytes of decoded
+	data - the decoder state [position in the encoded data, including the bit offset] and the last 32KB of decoded data [the decoding
+	window]. deflate blocks of highly compressed data may decode to a few hundred KBs, so checkpoints may be further apart.
+	Setting the position of the stream then resumes decoding from the nearest checkpoint before the requested position, instead of
+	decoding from the start. Moving forward a short distance just decodes forward.
+	The index is not owned by the stream, so it may be kept and used by later streams over the same data [PDFParser keeps
+	indexes of large object streams this way]. Each checkpoint holds up to 32KB, so pick the interval with memory in mind.
+*/
+
+struct FlateDecodeCheckpoint
+{
+	// position in the decoded data
+	IOBasicTypes::LongFilePositionType mDecodedPosition;
+	// position in the encoded data, of the first byte that wasn't fully consumed, and how many of its bits were consumed
+	// [the decoder resumes with its remaining bits]
+	IOBasicTypes::LongFilePositionType mEncodedPosition;
+	int mBits;
+	// decoded data before mDecodedPosition, up to 32KB
+	std::vector<IOBasicTypes::Byte> mWindow;
+};
+
+class FlateDecodeIndex
+{
+public:
+	FlateDecodeIndex(IOBasicTypes::LongBufferSizeType inCheckpointsInterval);
+	~FlateDecodeIndex(void);
+
+	IOBasicTypes::LongBufferSizeType GetCheckpointsInterval() const;
+
+	// the last checkpoint at or before inDecodedPosition, NULL if none
+	const FlateDecodeCheckpoint* FindCheckpoint(IOBasicTypes::LongFilePositionType inDecodedPosition) const;
+
+	// checkpoints are added in order of decoded position, while decoding beyond the recently indexed position
+	FlateDecodeCheckpoint* AddCheckpoint();
+	IOBasicTypes::LongFilePositionType GetIndexedPosition() const;
+	void SetIndexedPosition(IOBasicTypes::LongFilePositionType inDecodedPosition);
+
+	size_t GetCheckpointsCount() const;
+	IOBasicTypes::LongBufferSizeType GetMemorySize() const;
+
+private:
+	IOBasicTypes::LongBufferSizeType mCheckpointsInterval;
+	std::vector<FlateDecodeCheckpoint*> mCheckpoints;
+	// decoded data up to this position was already indexed
+	IOBasicTypes::LongFilePositionType mIndexedPosition;
+};
+
+class InputFlateDecodeSeekableStream : public IByteReaderWithPosition
+{
+public:
+	// decode inEncodedLength bytes of inSource starting at inEncodedStart. the source is not owned, and may be moved by others
+	// between reads [the stream sets its position before reading from it]. inIndex is not owned either
+	InputFlateDecodeSeekableStream(IByteReaderWithPosition* inSource,
+									IOBasicTypes::LongFilePositionType inEncodedStart,
+									IOBasicTypes::LongBufferSizeType inEncodedLength,
+									FlateDecodeIndex* inIndex);
+	virtual ~InputFlateDecodeSeekableStream(void);
+
+	// IByteReaderWithPosition implementation. positions are in the decoded data
+	virtual IOBasicTypes::LongBufferSizeType Read(IOBasicTypes::Byte* inBuffer,IOBasicTypes::LongBufferSizeType inBufferSize);
+	virtual bool NotEnded();
+	virtual void Skip(IOBasicTypes::LongBufferSizeType inSkipSize);
+	virtual void SetPosition(IOBasicTypes::LongFilePositionType inOffsetFromStart);
+	virtual void SetPositionFromEnd(IOBasicTypes::LongFilePositionType inOffsetFromEnd);
+	virtual IOBasicTypes::LongFilePositionType GetCurrentPosition();
+
+	// statistics. decoding restarts [from the start or from a checkpoint], and how many bytes were decoded overall
+	unsigned long GetRestartsCount() const;
+	IOBasicTypes::LongBufferSizeType GetDecodedBytesCount() const;
+
+private:
+	IByteReaderWithPosition* mSource;
+	IOBasicTypes::LongFilePositionType mEncodedStart;
+	IOBasicTypes::LongBufferSizeType mEncodedLength;
+	FlateDecodeIndex* mIndex;
+
+	z_stream* mZLibState;
+	bool mZLibStateActive;
+	bool mEnded;
+	bool mFailed;
+
+	// encoded data read buffer, and the position of its end in the encoded data
+	IOBasicTypes::Byte* mInputBuffer;
+	IOBasicTypes::LongFilePositionType mEncodedPosition;
+
+	// the last 32KB of decoded data, cyclic. the decoder writes to it, and reads copy from it
+	IOBasicTypes::Byte* mWindow;
+	IOBasicTypes::LongBufferSizeType mWindowWritePosition;
+	// position of the next byte to return from Read, and of the next byte the decoder will produce. bytes between are pending in the window
+	IOBasicTypes::LongFilePositionType mReadPosition;
+	IOBasicTypes::LongFilePositionType mDecodedPosition;
+
+	unsigned long mRestartsCount;
+	IOBasicTypes::LongBufferSizeType mDecodedBytesCount;
+
+	bool Restart(const FlateDecodeCheckpoint* inCheckpoint);
+	bool DecodeMore();
+	bool FillInput();
+	void RecordCheckpoint();
+	IOBasicTypes::LongBufferSizeType GetHistorySize() const;
+	void EndZLibState();
+	void DecodeForwardTo(IOBasicTypes::LongFilePositionType inDecodedPosition);
+};
@@ -23,13 +23,22 @@
 #include "Trace.h"
 #include "zlib.h"
 
+#include <limits.h>
+
+#define INPUT_BUFFER_SIZE (64*1024)
+// largest first guess of the decoded size of a buffer. larger outputs grow as they are decoded
+#define DECODED_SIZE_GUESS_LIMIT (64*1024*1024)
+
+using namespace IOBasicTypes;
 
 InputFlateDecodeStream::InputFlateDecodeStream(void)
 {
+	mInputBuffer = new IOBasicTypes::Byte[INPUT_BUFFER_SIZE];
 	mZLibState = new z_stream;
 	mSourceStream = NULL;
 	mCurrentlyEncoding = false;
 	mEndOfCompressionEoncountered = false;
+	mOutputPending = false;
 }
 
 InputFlateDecodeStream::~InputFlateDecodeStream(void)
@@ -38,6 +47,7 @@ InputFlateDecodeStream::~InputFlateDecodeStream(void)
 		FinalizeEncoding();
 	if(mSourceStream)
 		delete mSourceStream;
+	delete[] mInputBuffer;
 	delete mZLibState;
 }
 
@@ -50,9 +60,12 @@ void InputFlateDecodeStream::FinalizeEncoding()
 
 InputFlateDecodeStream::InputFlateDecodeStream(IByteReader* inSourceReader)
 {
+	mInputBuffer = new IOBasicTypes::Byte[INPUT_BUFFER_SIZE];
 	mZLibState = new z_stream;
 	mSourceStream = NULL;
 	mCurrentlyEncoding = false;
+	mEndOfCompressionEoncountered = false;
+	mOutputPending = false;
 
 	Assign(inSourceReader);
 }
@@ -72,6 +85,7 @@ void InputFlateDecodeStream::StartEncoding()
 	mZLibState->avail_in = 0;
 	mZLibState->next_in = Z_NULL;
 	mEndOfCompressionEoncountered = false;
+	mOutputPending = false;
 
 
     int inflateStatus = inflateInit(mZLibState);
@@ -98,32 +112,16 @@ IOBasicTypes::LongBufferSizeType InputFlateDecodeStream::DecodeBufferAndRead(con
 
 	int inflateResult = Z_OK;
 
-	do
-	{
-		mZLibState->avail_out = (uInt)inSize;
-		mZLibState->next_out = (Bytef*)inBuffer;
-
-		// first, flush whatever is already available
-		while(mZLibState->avail_in != 0 && mZLibState->avail_out != 0)
-		{
-			inflateResult = inflate(mZLibState,Z_NO_FLUSH);
-			if(Z_STREAM_ERROR == inflateResult ||
-			   Z_NEED_DICT == inflateResult ||
-			   Z_DATA_ERROR == inflateResult ||
-			   Z_MEM_ERROR == inflateResult)
-			{
-				TRACE_LOG1("InputFlateDecodeStream::DecodeBufferAndRead, failed to read zlib information. returned error code = %d",inflateResult);
-				inflateEnd(mZLibState);
-				break;
-			}
-		}
-		if(Z_OK != inflateResult && Z_STREAM_END != inflateResult)
-			break;
+	mZLibState->avail_out = (uInt)inSize;
+	mZLibState->next_out = (Bytef*)inBuffer;
 
-		// if not finished read buffer, repeatedly read from input stream, and inflate till done
-		while((0 < mZLibState->avail_out) && mSourceStream->NotEnded())
+	while(mZLibState->avail_out != 0 && !mEndOfCompressionEoncountered)
+	{
+		// refill the input window once inflate consumed all of it
+		if(0 == mZLibState->avail_in && mSourceStream->NotEnded())
 		{
-			if(mSourceStream->Read(&mBuffer,1) != 1)
+			LongBufferSizeType readAmount = mSourceStream->Read(mInputBuffer,INPUT_BUFFER_SIZE);
+			if(0 == readAmount)
 			{
 				TRACE_LOG("InputFlateDecodeStream::DecodeBufferAndRead, failed to read from source stream");
 				inflateEnd(mZLibState);
@@ -132,30 +130,32 @@ IOBasicTypes::LongBufferSizeType InputFlateDecodeStream::DecodeBufferAndRead(con
 				break;
 			}
 
-			mZLibState->avail_in = 1; 
-			mZLibState->next_in = (Bytef*)&mBuffer;
+			mZLibState->avail_in = (uInt)readAmount;
+			mZLibState->next_in = (Bytef*)mInputBuffer;
+		}
 
-			while(mZLibState->avail_in != 0 && mZLibState->avail_out != 0 && inflateResult != Z_STREAM_END)
-			{
-				inflateResult = inflate(mZLibState,Z_NO_FLUSH);
-				if(Z_STREAM_ERROR == inflateResult ||
-				   Z_NEED_DICT == inflateResult ||
-				   Z_DATA_ERROR == inflateResult ||
-				   Z_MEM_ERROR == inflateResult)
-				{
-					TRACE_LOG1("InputFlateDecodeStream::DecodeBufferAndRead, failed to read zlib information. returned error code = %d",inflateResult);
-					inflateEnd(mZLibState);
-					break;
-				}
-			}
-			if(Z_OK != inflateResult && Z_STREAM_END != inflateResult)
-				break;
+		// note that inflate is called even when there's no more input, as it may still hold decoded data that
+		// didn't fit the previous output buffer. Z_BUF_ERROR will signal that there's nothing more to get
+		inflateResult = inflate(mZLibState,Z_NO_FLUSH);
+		if(Z_STREAM_ERROR == inflateResult ||
+		   Z_NEED_DICT == inflateResult ||
+		   Z_DATA_ERROR == inflateResult ||
+		   Z_MEM_ERROR == inflateResult)
+		{
+			TRACE_LOG1("InputFlateDecodeStream::DecodeBufferAndRead, failed to read zlib information. returned error code = %d",inflateResult);
+			inflateEnd(mZLibState);
+			break;
 		}
-	} while(false);
 
-	// should be that at the last buffer we'll get here a nice Z_STREAM_END
-	mEndOfCompressionEoncountered = (Z_STREAM_END == inflateResult);
-	if(Z_OK == inflateResult || mEndOfCompressionEoncountered)
+		mEndOfCompressionEoncountered = (Z_STREAM_END == inflateResult);
+		if(Z_BUF_ERROR == inflateResult)
+			break;
+	}
+
+	// if the output buffer got filled, inflate may have more to give even with no more input
+	mOutputPending = (0 == mZLibState->avail_out) && !mEndOfCompressionEoncountered;
+
+	if(Z_OK == inflateResult || Z_BUF_ERROR == inflateResult || mEndOfCompressionEoncountered)
 		return inSize - mZLibState->avail_out;
 	else
 		return 0;
@@ -164,7 +164,90 @@ IOBasicTypes::LongBufferSizeType InputFlateDecodeStream::DecodeBufferAndRead(con
 bool InputFlateDecodeStream::NotEnded()
 {
 	if(mSourceStream)
-		return (mSourceStream->NotEnded() || mZLibState->avail_in != 0) && !mEndOfCompressionEoncountered;
+		return (mSourceStream->NotEnded() || mZLibState->avail_in != 0 || mOutputPending) && !mEndOfCompressionEoncountered;
 	else
 		return mZLibState->avail_in != 0 && mEndOfCompressionEoncountered;
-}
\ No newline at end of file
+}
+
+static const IOBasicTypes::LongBufferSizeType scMaxZLibChunk = UINT_MAX;
+
+PDFHummus::EStatusCode InputFlateDecodeStream::DecodeBuffer(const IOBasicTypes::Byte* inEncodedBuffer,
+															 IOBasicTypes::LongBufferSizeType inEncodedSize,
+															 ByteVector& outDecoded)
+{
+	if(0 == inEncodedSize)
+		return PDFHummus::eSuccess;
+
+	z_stream zlibState;
+	zlibState.zalloc = Z_NULL;
+	zlibState.zfree = Z_NULL;
+	zlibState.opaque = Z_NULL;
+	zlibState.avail_in = 0;
+	zlibState.next_in = Z_NULL;
+
+	int inflateResult = inflateInit(&zlibState);
+	if(inflateResult != Z_OK)
+	{
+		TRACE_LOG1("InputFlateDecodeStream::DecodeBuffer, Unexpected failure in initializating flate library. status code = %d",inflateResult);
+		return PDFHummus::eFailure;
+	}
+
+	// all input is available, so output is the only thing to manage. start with a fair guess of the decoded size
+	// and grow when inflate runs out of room. zlib counts in uInt, so input and output are passed in chunks of at most scMaxZLibChunk
+	LongBufferSizeType decodedStart = outDecoded.size();
+	LongBufferSizeType decodedSize = 0;
+	LongBufferSizeType remainingInput = inEncodedSize;
+	const IOBasicTypes::Byte* nextInput = inEncodedBuffer;
+	// the guess is 4 times the input. clamp before multiplying, so large inputs can't wrap it around
+	LongBufferSizeType decodedSizeGuess;
+	if(inEncodedSize < INPUT_BUFFER_SIZE)
+		decodedSizeGuess = INPUT_BUFFER_SIZE;
+	else if(inEncodedSize > DECODED_SIZE_GUESS_LIMIT/4)
+		decodedSizeGuess = DECODED_SIZE_GUESS_LIMIT;
+	else
+		decodedSizeGuess = inEncodedSize*4;
+	outDecoded.resize(decodedStart + decodedSizeGuess);
+
+	do
+	{
+		if(0 == zlibState.avail_in && remainingInput > 0)
+		{
+			zlibState.avail_in = (uInt)(remainingInput > scMaxZLibChunk ? scMaxZLibChunk : remainingInput);
+			zlibState.next_in = (Bytef*)nextInput;
+			nextInput += zlibState.avail_in;
+			remainingInput -= zlibState.avail_in;
+		}
+
+		if(decodedStart + decodedSize == outDecoded.size())
+		{
+			if(outDecoded.size() > outDecoded.max_size()/2)
+			{
+				TRACE_LOG("InputFlateDecodeStream::DecodeBuffer, decoded data is too large");
+				inflateResult = Z_MEM_ERROR;
+				break;
+			}
+			outDecoded.resize(outDecoded.size()*2);
+		}
+
+		LongBufferSizeType room = outDecoded.size() - decodedStart - decodedSize;
+		uInt availableOutput = (uInt)(room > scMaxZLibChunk ? scMaxZLibChunk : room);
+		zlibState.avail_out = availableOutput;
+		zlibState.next_out = (Bytef*)&outDecoded[decodedStart + decodedSize];
+
+		inflateResult = inflate(&zlibState,remainingInput > 0 ? Z_NO_FLUSH : Z_FINISH);
+		decodedSize += availableOutput - zlibState.avail_out;
+	}while((Z_OK == inflateResult || Z_BUF_ERROR == inflateResult) && (zlibState.avail_out == 0 || remainingInput > 0));
+
+	inflateEnd(&zlibState);
+	outDecoded.resize(decodedStart + decodedSize);
+
+	if(inflateResult != Z_STREAM_END && inflateResult != Z_BUF_ERROR && inflateResult != Z_OK)
+	{
+		TRACE_LOG1("InputFlateDecodeStream::DecodeBuffer, failed to decode zlib information. returned error code = %d",inflateResult);
+		return PDFHummus::eFailure;
+	}
+
+	// Z_BUF_ERROR with room to spare means the input ended before the end of compression. keep what got decoded,
+	// same as the streaming interface does for truncated streams
+	return PDFHummus::eSuccess;
+}
@@ -23,9 +23,13 @@
 #include "EStatusCode.h"
 #include "IByteReader.h"
 
+#include <vector>
+
 struct z_stream_s;
 typedef z_stream_s z_stream;
 
+typedef std::vector<IOBasicTypes::Byte> ByteVector;
+
 class InputFlateDecodeStream : public IByteReader
 {
 public:
@@ -37,6 +41,8 @@ public:
 
 	// Assigning passes ownership of the input stream to the decoder stream. 
 	// if you don't care for that, then after finishing with the decode, Assign(NULL).
+	// Note that the decoder reads ahead from the source in blocks, so the source should be limited to the encoded
+	// data (which is what the parser does with an InputLimitedStream on the stream /Length)
 	void Assign(IByteReader* inSourceReader);
 
 	// IByteReader implementation. note that "inBufferSize" determines how many
@@ -46,12 +52,21 @@ public:
 
 	virtual bool NotEnded();
 
+	// One-shot decoding, for when the whole encoded data is already in memory (say, a stream with a known /Length that was
+	// read or mapped in full). inflates the complete input in a single pass and appends the decoded bytes to outDecoded,
+	// skipping the per-read state keeping of the streaming interface.
+	static PDFHummus::EStatusCode DecodeBuffer(const IOBasicTypes::Byte* inEncodedBuffer,
+												IOBasicTypes::LongBufferSizeType inEncodedSize,
+												ByteVector& outDecoded);
+
 private:
-	IOBasicTypes::Byte mBuffer;
+	// input window. compressed data is read from the source into it in large blocks, and inflated from there
+	IOBasicTypes::Byte* mInputBuffer;
 	IByteReader* mSourceStream;
 	z_stream* mZLibState;
 	bool mCurrentlyEncoding;
 	bool mEndOfCompressionEoncountered;
+	bool mOutputPending;
 
 	void FinalizeEncoding();
 	IOBasicTypes::LongBufferSizeType DecodeBufferAndRead(const IOBasicTypes::Byte* inBuffer,IOBasicTypes::LongBufferSizeType inSize);
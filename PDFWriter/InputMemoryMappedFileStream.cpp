@@ -0,0 +1,219 @@
+/*
+   Source File : InputMemoryMappedFileStream.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "InputMemoryMappedFileStream.h"
+#include "SafeBufferMacrosDefs.h"
+
+#include <string.h>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace PDFHummus;
+
+InputMemoryMappedFileStream::InputMemoryMappedFileStream(void)
+{
+	mData = NULL;
+	mFileSize = 0;
+	mCurrentPosition = 0;
+#ifdef WIN32
+	mFileHandle = NULL;
+	mMappingHandle = NULL;
+#endif
+}
+
+InputMemoryMappedFileStream::~InputMemoryMappedFileStream(void)
+{
+	if(mData)
+		Close();
+}
+
+InputMemoryMappedFileStream::InputMemoryMappedFileStream(const std::string& inFilePath)
+{
+	mData = NULL;
+	mFileSize = 0;
+	mCurrentPosition = 0;
+#ifdef WIN32
+	mFileHandle = NULL;
+	mMappingHandle = NULL;
+#endif
+	Open(inFilePath);
+}
+
+#ifdef WIN32
+
+EStatusCode InputMemoryMappedFileStream::Open(const std::string& inFilePath)
+{
+	HANDLE fileHandle = CreateFileW(UTF8ToUTF16Wide(inFilePath).c_str(),GENERIC_READ,FILE_SHARE_READ | FILE_SHARE_WRITE,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+	if(INVALID_HANDLE_VALUE == fileHandle)
+		return eFailure;
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(fileHandle,&fileSize) || 0 == fileSize.QuadPart)
+	{
+		CloseHandle(fileHandle);
+		return eFailure;
+	}
+
+	HANDLE mappingHandle = CreateFileMappingW(fileHandle,NULL,PAGE_READONLY,0,0,NULL);
+	if(NULL == mappingHandle)
+	{
+		CloseHandle(fileHandle);
+		return eFailure;
+	}
+
+	void* data = MapViewOfFile(mappingHandle,FILE_MAP_READ,0,0,0);
+	if(NULL == data)
+	{
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return eFailure;
+	}
+
+	mFileHandle = fileHandle;
+	mMappingHandle = mappingHandle;
+	mData = (Byte*)data;
+	mFileSize = fileSize.QuadPart;
+	mCurrentPosition = 0;
+	return eSuccess;
+}
+
+EStatusCode InputMemoryMappedFileStream::Close()
+{
+	if(!mData)
+		return eSuccess;
+
+	EStatusCode result = UnmapViewOfFile(mData) ? eSuccess:eFailure;
+	CloseHandle((HANDLE)mMappingHandle);
+	CloseHandle((HANDLE)mFileHandle);
+
+	mData = NULL;
+	mMappingHandle = NULL;
+	mFileHandle = NULL;
+	mFileSize = 0;
+	mCurrentPosition = 0;
+	return result;
+}
+
+#else
+
+EStatusCode InputMemoryMappedFileStream::Open(const std::string& inFilePath)
+{
+	int fileDescriptor = open(inFilePath.c_str(),O_RDONLY);
+	if(-1 == fileDescriptor)
+		return eFailure;
+
+	struct stat fileStatus;
+	if(fstat(fileDescriptor,&fileStatus) != 0 || 0 == fileStatus.st_size)
+	{
+		close(fileDescriptor);
+		return eFailure;
+	}
+
+	void* data = mmap(NULL,(size_t)fileStatus.st_size,PROT_READ,MAP_PRIVATE,fileDescriptor,0);
+	// the mapping keeps its own reference to the file, so the descriptor is not needed anymore
+	close(fileDescriptor);
+	if(MAP_FAILED == data)
+		return eFailure;
+
+	// parsing jumps around the file a lot [xref, then objects as they are referenced], so don't read ahead too much
+	madvise(data,(size_t)fileStatus.st_size,MADV_RANDOM);
+
+	mData = (Byte*)data;
+	mFileSize = fileStatus.st_size;
+	mCurrentPosition = 0;
+	return eSuccess;
+}
+
+EStatusCode InputMemoryMappedFileStream::Close()
+{
+	if(!mData)
+		return eSuccess;
+
+	EStatusCode result = munmap(mData,(size_t)mFileSize) == 0 ? eSuccess:eFailure;
+
+	mData = NULL;
+	mFileSize = 0;
+	mCurrentPosition = 0;
+	return result;
+}
+
+#endif
+
+LongBufferSizeType InputMemoryMappedFileStream::Read(Byte* inBuffer,LongBufferSizeType inBufferSize)
+{
+	if(mCurrentPosition >= mFileSize)
+		return 0;
+
+	LongBufferSizeType amountToRead = (LongFilePositionType)inBufferSize < mFileSize - mCurrentPosition ? 
+										inBufferSize : 
+										(LongBufferSizeType)(mFileSize - mCurrentPosition);
+	memcpy(inBuffer,mData + mCurrentPosition,amountToRead);
+	mCurrentPosition+=amountToRead;
+	return amountToRead;
+}
+
+bool InputMemoryMappedFileStream::NotEnded()
+{
+	return mCurrentPosition < mFileSize;
+}
+
+void InputMemoryMappedFileStream::Skip(LongBufferSizeType inSkipSize)
+{
+	mCurrentPosition = (LongFilePositionType)inSkipSize < mFileSize - mCurrentPosition ? mCurrentPosition + inSkipSize : mFileSize;
+}
+
+void InputMemoryMappedFileStream::SetPosition(LongFilePositionType inOffsetFromStart)
+{
+	mCurrentPosition = inOffsetFromStart < 0 ? 0 : (inOffsetFromStart > mFileSize ? mFileSize : inOffsetFromStart);
+}
+
+void InputMemoryMappedFileStream::SetPositionFromEnd(LongFilePositionType inOffsetFromEnd)
+{
+	// like the file stream, seeking before the start places at the start
+	mCurrentPosition = inOffsetFromEnd > mFileSize ? 0 : mFileSize - inOffsetFromEnd;
+}
+
+LongFilePositionType InputMemoryMappedFileStream::GetCurrentPosition()
+{
+	return mCurrentPosition;
+}
+
+const Byte* InputMemoryMappedFileStream::GetContiguousSpan(LongBufferSizeType& outSpanSize)
+{
+	if(!mData)
+	{
+		outSpanSize = 0;
+		return NULL;
+	}
+
+	outSpanSize = (LongBufferSizeType)(mFileSize - mCurrentPosition);
+	return mData + mCurrentPosition;
+}
+
+LongFilePositionType InputMemoryMappedFileStream::GetFileSize()
+{
+	return mFileSize;
+}
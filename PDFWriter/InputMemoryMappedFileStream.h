@@ -0,0 +1,68 @@
+/*
+   Source File : InputMemoryMappedFileStream.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "EStatusCode.h"
+#include "IByteReaderWithPosition.h"
+
+#include <string>
+
+/*
+	Input file stream that maps the whole file to memory, instead of reading it with fread.
+	Reads are plain copies from the mapped pages, and GetContiguousSpan provides direct access to them
+	so readers that know how to use it can skip copying altogether.
+	Use when parsing large files. Mapping empty files is not possible, Open will fail for them.
+*/
+
+class InputMemoryMappedFileStream : public IByteReaderWithPosition
+{
+public:
+	InputMemoryMappedFileStream(void);
+	virtual ~InputMemoryMappedFileStream(void);
+
+	// input file path is in UTF8
+	InputMemoryMappedFileStream(const std::string& inFilePath);
+
+	// input file path is in UTF8
+	PDFHummus::EStatusCode Open(const std::string& inFilePath);
+	PDFHummus::EStatusCode Close();
+
+	// IByteReaderWithPosition implementation
+	virtual LongBufferSizeType Read(Byte* inBuffer,LongBufferSizeType inBufferSize);
+	virtual bool NotEnded();
+	virtual void Skip(LongBufferSizeType inSkipSize);
+	virtual void SetPosition(LongFilePositionType inOffsetFromStart);
+	virtual void SetPositionFromEnd(LongFilePositionType inOffsetFromEnd);
+	virtual LongFilePositionType GetCurrentPosition();
+	virtual const Byte* GetContiguousSpan(LongBufferSizeType& outSpanSize);
+
+	LongFilePositionType GetFileSize();
+
+private:
+
+	Byte* mData;
+	LongFilePositionType mFileSize;
+	LongFilePositionType mCurrentPosition;
+#ifdef WIN32
+	void* mFileHandle;
+	void* mMappingHandle;
+#endif
+};
@@ -311,7 +311,8 @@ PDFFormXObject* JPEGImageHandler::CreateFormXObjectFromJPGFile(const std::string
 		}
 
 		// Write Image XObject
-		imageXObject = CreateAndWriteImageXObjectFromJPGInformation(inJPGFilePath,mObjectsContext->GetInDirectObjectsRegistry().AllocateNewObjectID(),imageInformationResult.second);
+		ObjectIDType imageXObjectID = StartImageXObjectDeduplication();
+		imageXObject = EndImageXObjectDeduplication(CreateAndWriteImageXObjectFromJPGInformation(inJPGFilePath,imageXObjectID,imageInformationResult.second),imageXObjectID);
 		if(!imageXObject)
 		{
 			TRACE_LOG1("JPEGImageHandler::CreateFormXObjectFromJPGFile, unable to create image xobject for %s",inJPGFilePath.c_str());
@@ -449,7 +450,8 @@ PDFImageXObject* JPEGImageHandler::CreateImageXObjectFromJPGFile(const std::stri
 		return NULL;
 	}
 
-	return CreateImageXObjectFromJPGFile(inJPGFilePath,mObjectsContext->GetInDirectObjectsRegistry().AllocateNewObjectID());
+	ObjectIDType imageXObjectID = StartImageXObjectDeduplication();
+	return EndImageXObjectDeduplication(CreateImageXObjectFromJPGFile(inJPGFilePath,imageXObjectID),imageXObjectID);
 }
 
 PDFFormXObject* JPEGImageHandler::CreateFormXObjectFromJPGFile(const std::string& inJPGFilePath)
@@ -472,7 +474,8 @@ PDFImageXObject* JPEGImageHandler::CreateImageXObjectFromJPGStream(IByteReaderWi
 		return NULL;
 	}
 
-	return CreateImageXObjectFromJPGStream(inJPGStream,mObjectsContext->GetInDirectObjectsRegistry().AllocateNewObjectID());
+	ObjectIDType imageXObjectID = StartImageXObjectDeduplication();
+	return EndImageXObjectDeduplication(CreateImageXObjectFromJPGStream(inJPGStream,imageXObjectID),imageXObjectID);
 }
 
 PDFImageXObject* JPEGImageHandler::CreateImageXObjectFromJPGStream(IByteReaderWithPosition* inJPGStream,ObjectIDType inImageXObjectID)
@@ -549,7 +552,8 @@ PDFFormXObject* JPEGImageHandler::CreateFormXObjectFromJPGStream(IByteReaderWith
 		// reset image position after parsing header, for later content copying
 		inJPGStream->SetPosition(recordedPosition);
 
-		imageXObject = CreateAndWriteImageXObjectFromJPGInformation(inJPGStream,mObjectsContext->GetInDirectObjectsRegistry().AllocateNewObjectID(),imageInformation);
+		ObjectIDType imageXObjectID = StartImageXObjectDeduplication();
+		imageXObject = EndImageXObjectDeduplication(CreateAndWriteImageXObjectFromJPGInformation(inJPGStream,imageXObjectID,imageInformation),imageXObjectID);
 		if(!imageXObject)
 		{
 			TRACE_LOG("JPEGImageHandler::CreateFormXObjectFromJPGStream, unable to create image xobject");
@@ -570,6 +574,28 @@ PDFFormXObject* JPEGImageHandler::CreateFormXObjectFromJPGStream(IByteReaderWith
 	return imageFormXObject;  
 }
 
+ObjectIDType JPEGImageHandler::StartImageXObjectDeduplication()
+{
+	ObjectIDType imageXObjectID = mObjectsContext->GetInDirectObjectsRegistry().AllocateNewObjectID();
+	mObjectsContext->StartStreamDeduplication(imageXObjectID);
+	return imageXObjectID;
+}
+
+PDFImageXObject* JPEGImageHandler::EndImageXObjectDeduplication(PDFImageXObject* inImageXObject,ObjectIDType inImageXObjectID)
+{
+	ObjectIDType imageXObjectID = mObjectsContext->EndStreamDeduplication(inImageXObjectID);
+	if(!inImageXObject || imageXObjectID == inImageXObjectID)
+		return inImageXObject;
+
+	// identical image was written before, use it
+	PDFImageXObject* imageXObject = new PDFImageXObject(imageXObjectID);
+	StringList::const_iterator it = inImageXObject->GetRequiredProcsetResourceNames().begin();
+	for(; it != inImageXObject->GetRequiredProcsetResourceNames().end(); ++it)
+		imageXObject->AddRequiredProcset(*it);
+	delete inImageXObject;
+	return imageXObject;
+}
+
 int JPEGImageHandler::GetColorComponents(const JPEGImageInformation& inJPGImageInformation)
 {
 	return inJPGImageInformation.ColorComponentsCount;
@@ -92,5 +92,9 @@ private:
 	PDFImageXObject* CreateAndWriteImageXObjectFromJPGInformation(const std::string& inJPGFilePath,ObjectIDType inImageXObjectID, const JPEGImageInformation& inJPGImageInformation);
 	PDFImageXObject* CreateAndWriteImageXObjectFromJPGInformation(IByteReaderWithPosition* inJPGImageStream,ObjectIDType inImageXObjectID, const JPEGImageInformation& inJPGImageInformation);
 	PDFFormXObject* CreateImageFormXObjectFromImageXObject(PDFImageXObject* inImageXObject,ObjectIDType inFormXObjectID, const JPEGImageInformation& inJPGImageInformation);
+	// for images with internally allocated IDs, allow reusing an identical image written earlier (if streams deduplication is on).
+	// Start allocates the image ID, End returns the image xobject to use
+	ObjectIDType StartImageXObjectDeduplication();
+	PDFImageXObject* EndImageXObjectDeduplication(PDFImageXObject* inImageXObject,ObjectIDType inImageXObjectID);
 
 };
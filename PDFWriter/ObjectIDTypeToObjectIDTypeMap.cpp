@@ -0,0 +1,285 @@
+/*
+   Source File : ObjectIDTypeToObjectIDTypeMap.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ObjectIDTypeToObjectIDTypeMap.h"
+
+static const ObjectIDType scNoTarget = (ObjectIDType)-1;
+
+ObjectIDTypeToObjectIDTypeMap::const_iterator::const_iterator()
+{
+	mTargets = NULL;
+	mSparseTargets = NULL;
+	mDenseSourceObjectID = 0;
+	mCurrent.first = 0;
+	mCurrent.second = scNoTarget;
+}
+
+ObjectIDTypeToObjectIDTypeMap::const_iterator::const_iterator(const std::vector<ObjectIDType>* inTargets,
+																const ObjectIDTypeToObjectIDTypeSparseMap* inSparseTargets,
+																ObjectIDType inDenseSourceObjectID,
+																ObjectIDTypeToObjectIDTypeSparseMap::const_iterator inSparseIterator)
+{
+	mTargets = inTargets;
+	mSparseTargets = inSparseTargets;
+	mDenseSourceObjectID = inDenseSourceObjectID;
+	mSparseIterator = inSparseIterator;
+	SkipMissing();
+}
+
+void ObjectIDTypeToObjectIDTypeMap::const_iterator::SkipMissing()
+{
+	while(mDenseSourceObjectID < mTargets->size() && (*mTargets)[mDenseSourceObjectID] == scNoTarget)
+		++mDenseSourceObjectID;
+
+	if(mDenseSourceObjectID < mTargets->size())
+	{
+		mCurrent.first = mDenseSourceObjectID;
+		mCurrent.second = (*mTargets)[mDenseSourceObjectID];
+	}
+	else if(mSparseIterator != mSparseTargets->end())
+	{
+		mCurrent = *mSparseIterator;
+	}
+	else
+	{
+		mCurrent.first = mDenseSourceObjectID;
+		mCurrent.second = scNoTarget;
+	}
+}
+
+const ObjectIDTypeToObjectIDTypeMap::value_type& ObjectIDTypeToObjectIDTypeMap::const_iterator::operator*() const
+{
+	return mCurrent;
+}
+
+const ObjectIDTypeToObjectIDTypeMap::value_type* ObjectIDTypeToObjectIDTypeMap::const_iterator::operator->() const
+{
+	return &mCurrent;
+}
+
+ObjectIDTypeToObjectIDTypeMap::const_iterator& ObjectIDTypeToObjectIDTypeMap::const_iterator::operator++()
+{
+	if(mDenseSourceObjectID < mTargets->size())
+		++mDenseSourceObjectID;
+	else
+		++mSparseIterator;
+	SkipMissing();
+	return *this;
+}
+
+ObjectIDTypeToObjectIDTypeMap::const_iterator ObjectIDTypeToObjectIDTypeMap::const_iterator::operator++(int)
+{
+	const_iterator result = *this;
+	++(*this);
+	return result;
+}
+
+bool ObjectIDTypeToObjectIDTypeMap::const_iterator::operator==(const const_iterator& inOther) const
+{
+	return mTargets == inOther.mTargets &&
+			mDenseSourceObjectID == inOther.mDenseSourceObjectID &&
+			(!mSparseTargets || mSparseIterator == inOther.mSparseIterator);
+}
+
+bool ObjectIDTypeToObjectIDTypeMap::const_iterator::operator!=(const const_iterator& inOther) const
+{
+	return !(*this == inOther);
+}
+
+ObjectIDTypeToObjectIDTypeMap::ObjectIDTypeToObjectIDTypeMap()
+{
+	mDenseRange = 0;
+	mSize = 0;
+}
+
+ObjectIDTypeToObjectIDTypeMap::const_iterator ObjectIDTypeToObjectIDTypeMap::begin() const
+{
+	return const_iterator(&mTargets,&mSparseTargets,0,mSparseTargets.begin());
+}
+
+ObjectIDTypeToObjectIDTypeMap::const_iterator ObjectIDTypeToObjectIDTypeMap::end() const
+{
+	return const_iterator(&mTargets,&mSparseTargets,(ObjectIDType)mTargets.size(),mSparseTargets.end());
+}
+
+bool ObjectIDTypeToObjectIDTypeMap::IsDense(ObjectIDType inSourceObjectID) const
+{
+	return inSourceObjectID < mDenseRange;
+}
+
+ObjectIDTypeToObjectIDTypeMap::const_iterator ObjectIDTypeToObjectIDTypeMap::find(ObjectIDType inSourceObjectID) const
+{
+	if(IsDense(inSourceObjectID))
+	{
+		if(inSourceObjectID < mTargets.size() && mTargets[inSourceObjectID] != scNoTarget)
+			return const_iterator(&mTargets,&mSparseTargets,inSourceObjectID,mSparseTargets.begin());
+		else
+			return end();
+	}
+	else
+	{
+		return const_iterator(&mTargets,&mSparseTargets,(ObjectIDType)mTargets.size(),mSparseTargets.find(inSourceObjectID));
+	}
+}
+
+size_t ObjectIDTypeToObjectIDTypeMap::count(ObjectIDType inSourceObjectID) const
+{
+	if(IsDense(inSourceObjectID))
+		return (inSourceObjectID < mTargets.size() && mTargets[inSourceObjectID] != scNoTarget) ? 1 : 0;
+	else
+		return mSparseTargets.count(inSourceObjectID);
+}
+
+size_t ObjectIDTypeToObjectIDTypeMap::size() const
+{
+	return mSize + mSparseTargets.size();
+}
+
+bool ObjectIDTypeToObjectIDTypeMap::empty() const
+{
+	return 0 == size();
+}
+
+void ObjectIDTypeToObjectIDTypeMap::GrowFor(ObjectIDType inSourceObjectID)
+{
+	if(inSourceObjectID < mTargets.size())
+		return;
+
+	// grow geometrically, but not beyond the dense range
+	size_t newSize = mTargets.size() * 2;
+	if(newSize <= inSourceObjectID)
+		newSize = inSourceObjectID + 1;
+	if(newSize > mDenseRange)
+		newSize = mDenseRange;
+	mTargets.resize(newSize,scNoTarget);
+}
+
+std::pair<ObjectIDTypeToObjectIDTypeMap::const_iterator,bool> ObjectIDTypeToObjectIDTypeMap::insert(const value_type& inMapping)
+{
+	if(!IsDense(inMapping.first))
+	{
+		std::pair<ObjectIDTypeToObjectIDTypeSparseMap::iterator,bool> result = mSparseTargets.insert(inMapping);
+		return std::pair<const_iterator,bool>(const_iterator(&mTargets,&mSparseTargets,(ObjectIDType)mTargets.size(),result.first),result.second);
+	}
+
+	GrowFor(inMapping.first);
+
+	bool inserted = (mTargets[inMapping.first] == scNoTarget);
+	if(inserted)
+	{
+		mTargets[inMapping.first] = inMapping.second;
+		++mSize;
+	}
+	return std::pair<const_iterator,bool>(const_iterator(&mTargets,&mSparseTargets,inMapping.first,mSparseTargets.begin()),inserted);
+}
+
+ObjectIDType& ObjectIDTypeToObjectIDTypeMap::operator[](ObjectIDType inSourceObjectID)
+{
+	if(!IsDense(inSourceObjectID))
+		return mSparseTargets[inSourceObjectID];
+
+	GrowFor(inSourceObjectID);
+
+	// as with std::map, a missing key is added with a default value
+	if(mTargets[inSourceObjectID] == scNoTarget)
+	{
+		mTargets[inSourceObjectID] = 0;
+		++mSize;
+	}
+	return mTargets[inSourceObjectID];
+}
+
+size_t ObjectIDTypeToObjectIDTypeMap::erase(ObjectIDType inSourceObjectID)
+{
+	if(!IsDense(inSourceObjectID))
+		return mSparseTargets.erase(inSourceObjectID);
+
+	if(0 == count(inSourceObjectID))
+		return 0;
+
+	mTargets[inSourceObjectID] = scNoTarget;
+	--mSize;
+	return 1;
+}
+
+void ObjectIDTypeToObjectIDTypeMap::clear()
+{
+	mTargets.clear();
+	mSparseTargets.clear();
+	mDenseRange = 0;
+	mSize = 0;
+}
+
+void ObjectIDTypeToObjectIDTypeMap::SetDenseRange(ObjectIDType inSourceObjectsCount)
+{
+	if(inSourceObjectsCount <= mDenseRange)
+		return;
+
+	mDenseRange = inSourceObjectsCount;
+
+	// sparse mappings now in the dense range move to dense storage, so that sparse IDs are all beyond the dense ones
+	ObjectIDTypeToObjectIDTypeSparseMap::iterator it = mSparseTargets.begin();
+	while(it != mSparseTargets.end() && it->first < mDenseRange)
+	{
+		GrowFor(it->first);
+		mTargets[it->first] = it->second;
+		++mSize;
+		mSparseTargets.erase(it++);
+	}
+}
+
+ObjectIDTypeBitmap::ObjectIDTypeBitmap(ObjectIDType inDenseRange)
+{
+	mDenseRange = inDenseRange;
+}
+
+bool ObjectIDTypeBitmap::Contains(ObjectIDType inObjectID) const
+{
+	if(inObjectID < mDenseRange)
+		return inObjectID < mBits.size() && mBits[inObjectID];
+	else
+		return mSparseIDs.find(inObjectID) != mSparseIDs.end();
+}
+
+bool ObjectIDTypeBitmap::Insert(ObjectIDType inObjectID)
+{
+	if(inObjectID >= mDenseRange)
+		return mSparseIDs.insert(inObjectID).second;
+
+	if(inObjectID >= mBits.size())
+	{
+		size_t newSize = mBits.size() * 2;
+		if(newSize <= inObjectID)
+			newSize = inObjectID + 1;
+		if(newSize > mDenseRange)
+			newSize = mDenseRange;
+		mBits.resize(newSize,false);
+	}
+	if(mBits[inObjectID])
+		return false;
+	mBits[inObjectID] = true;
+	return true;
+}
+
+void ObjectIDTypeBitmap::Clear()
+{
+	mBits.clear();
+	mSparseIDs.clear();
+}
@@ -0,0 +1,129 @@
+/*
+   Source File : ObjectIDTypeToObjectIDTypeMap.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "ObjectsBasicTypes.h"
+
+#include <stddef.h>
+#include <utility>
+#include <vector>
+#include <map>
+#include <set>
+
+/*
+	Mapping of source object IDs to target object IDs, for copying objects between documents.
+	source object IDs are mostly bounded by the source document xref size, so rather than a tree the mapping of IDs in that dense
+	range is a vector indexed by the source object ID, and lookups are plain array accesses. the copying context sets the dense range
+	to the source xref size. IDs outside of it [references to objects that are not in the xref, say] are kept in a sparse map, so an
+	arbitrary ID doesn't allocate storage for all IDs below it. with no dense range set the mapping is all sparse, like std::map.
+	the interface is the subset of std::map that copying uses [and users of PDFDocumentCopyingContext::ReplaceSourceObjects may use
+	to build a mapping], and iteration is in source ID order, as with std::map, so MapIterator works with it.
+	note that iterators are read only, and that values are copies - setting a target goes through operator[] or insert.
+*/
+
+typedef std::map<ObjectIDType,ObjectIDType> ObjectIDTypeToObjectIDTypeSparseMap;
+
+class ObjectIDTypeToObjectIDTypeMap
+{
+public:
+	typedef ObjectIDType key_type;
+	typedef ObjectIDType mapped_type;
+	typedef std::pair<ObjectIDType,ObjectIDType> value_type;
+
+	class const_iterator
+	{
+	public:
+		const_iterator();
+		const_iterator(const std::vector<ObjectIDType>* inTargets,
+						const ObjectIDTypeToObjectIDTypeSparseMap* inSparseTargets,
+						ObjectIDType inDenseSourceObjectID,
+						ObjectIDTypeToObjectIDTypeSparseMap::const_iterator inSparseIterator);
+
+		const value_type& operator*() const;
+		const value_type* operator->() const;
+		const_iterator& operator++();
+		const_iterator operator++(int);
+		bool operator==(const const_iterator& inOther) const;
+		bool operator!=(const const_iterator& inOther) const;
+
+	private:
+		const std::vector<ObjectIDType>* mTargets;
+		const ObjectIDTypeToObjectIDTypeSparseMap* mSparseTargets;
+		// dense IDs are iterated first, then sparse ones [which are all beyond the dense range]
+		ObjectIDType mDenseSourceObjectID;
+		ObjectIDTypeToObjectIDTypeSparseMap::const_iterator mSparseIterator;
+		value_type mCurrent;
+
+		void SkipMissing();
+	};
+	typedef const_iterator iterator;
+
+	ObjectIDTypeToObjectIDTypeMap();
+
+	const_iterator begin() const;
+	const_iterator end() const;
+	const_iterator find(ObjectIDType inSourceObjectID) const;
+	size_t count(ObjectIDType inSourceObjectID) const;
+	size_t size() const;
+	bool empty() const;
+
+	// insert does not override an existing mapping, as with std::map
+	std::pair<const_iterator,bool> insert(const value_type& inMapping);
+	ObjectIDType& operator[](ObjectIDType inSourceObjectID);
+	size_t erase(ObjectIDType inSourceObjectID);
+	// clears mappings and the dense range
+	void clear();
+
+	// keep source object IDs below inSourceObjectsCount in dense storage. storage grows as IDs are added, up to this count.
+	// the range only grows
+	void SetDenseRange(ObjectIDType inSourceObjectsCount);
+
+private:
+	// target object ID per dense source object ID, or scNoTarget when not mapped
+	std::vector<ObjectIDType> mTargets;
+	ObjectIDTypeToObjectIDTypeSparseMap mSparseTargets;
+	ObjectIDType mDenseRange;
+	size_t mSize;
+
+	bool IsDense(ObjectIDType inSourceObjectID) const;
+	void GrowFor(ObjectIDType inSourceObjectID);
+};
+
+/*
+	Set of source object IDs, as a bitmap indexed by the object ID. for tracking objects already copied.
+	as with the mapping, IDs beyond the dense range are kept in a sparse set
+*/
+
+class ObjectIDTypeBitmap
+{
+public:
+	ObjectIDTypeBitmap(ObjectIDType inDenseRange = 0);
+
+	bool Contains(ObjectIDType inObjectID) const;
+	// returns false if already in the set
+	bool Insert(ObjectIDType inObjectID);
+	void Clear();
+
+private:
+	std::vector<bool> mBits;
+	std::set<ObjectIDType> mSparseIDs;
+	ObjectIDType mDenseRange;
+};
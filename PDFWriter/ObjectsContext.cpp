@@ -31,18 +31,37 @@
 #include "PDFDictionary.h"
 #include "PDFIndirectObjectReference.h"
 #include "PDFBoolean.h"
+#include "PDFInteger.h"
 #include "PDFLiteralString.h"
 #include "EncryptionHelper.h"
 #include "PDFObjectParser.h"
+#include "MD5Generator.h"
+#include "BoxingBase.h"
+#include "IObjectsContextExtender.h"
+
+#include <algorithm>
 
 using namespace PDFHummus;
 
 ObjectsContext::ObjectsContext(void)
 {
 	mOutputStream = NULL;
+	mTargetOutputStream = NULL;
 	mCompressStreams = true;
 	mExtender = NULL;
 	mEncryptionHelper = NULL;
+	mWriteObjectStreams = false;
+	mCurrentStream = NULL;
+	mIsBufferingObject = false;
+	mBufferedObjectID = 0;
+	mObjectStreamID = 0;
+	mDeferStreamCompression = false;
+	mStreamCompressionThreads = 0;
+	mDeduplicateStreams = false;
+	mIsCapturingStream = false;
+	mCapturedObjectID = 0;
+	mCapturedObjectStarted = false;
+	mCaptureSavedOutputStream = NULL;
 }
 
 ObjectsContext::~ObjectsContext(void)
@@ -54,8 +73,45 @@ ObjectsContext::~ObjectsContext(void)
 
 void ObjectsContext::SetOutputStream(IByteWriterWithPosition* inOutputStream)
 {
-	mOutputStream = inOutputStream;
-	mPrimitiveWriter.SetStreamForWriting(inOutputStream);
+	mTargetOutputStream = inOutputStream;
+	SetupOutputStream();
+}
+
+void ObjectsContext::SetDeferredStreamCompression(bool inDeferStreamCompression,unsigned int inThreadsCount)
+{
+	mDeferStreamCompression = inDeferStreamCompression;
+	mStreamCompressionThreads = inThreadsCount;
+	if(mTargetOutputStream)
+		SetupOutputStream();
+}
+
+bool ObjectsContext::IsDeferringStreamCompression()
+{
+	return mDeferStreamCompression;
+}
+
+void ObjectsContext::SetupOutputStream()
+{
+	// complete anything pending on the previous output, before switching
+	if(mDeferredOutputStream.HasPendingWork())
+		mDeferredOutputStream.Flush();
+
+	if(mDeferStreamCompression && mTargetOutputStream)
+	{
+		mDeferredOutputStream.Assign(mTargetOutputStream,&mReferencesRegistry,mStreamCompressionThreads);
+		mOutputStream = &mDeferredOutputStream;
+	}
+	else
+	{
+		mDeferredOutputStream.Assign(NULL,NULL);
+		mOutputStream = mTargetOutputStream;
+	}
+
+	if(!mIsBufferingObject)
+	{
+		mCurrentStream = mOutputStream;
+		mPrimitiveWriter.SetStreamForWriting(mOutputStream);
+	}
 }
 
 void ObjectsContext::SetEncryptionHelper(EncryptionHelper* inEncryptionHelper) 
@@ -70,8 +126,8 @@ bool ObjectsContext::IsEncrypting() {
 static const IOBasicTypes::Byte scComment[1] = {'%'};
 void ObjectsContext::WriteComment(const std::string& inCommentText)
 {
-	mOutputStream->Write(scComment,1);
-	mOutputStream->Write((const IOBasicTypes::Byte *)inCommentText.c_str(),inCommentText.size());
+	mCurrentStream->Write(scComment,1);
+	mCurrentStream->Write((const IOBasicTypes::Byte *)inCommentText.c_str(),inCommentText.size());
 	EndLine();
 }
 
@@ -130,13 +186,13 @@ void ObjectsContext::WriteIndirectObjectReference(ObjectIDType inIndirectObjectI
 {
 	mPrimitiveWriter.WriteInteger(inIndirectObjectID);
 	mPrimitiveWriter.WriteInteger(inGenerationNumber);
-	mOutputStream->Write(scR,1);
+	mCurrentStream->Write(scR,1);
 	mPrimitiveWriter.WriteTokenSeparator(inSeparate);
 }
 
 IByteWriterWithPosition* ObjectsContext::StartFreeContext()
 {
-	return mOutputStream;
+	return mCurrentStream;
 }
 
 void ObjectsContext::EndFreeContext()
@@ -157,6 +213,11 @@ static const IOBasicTypes::Byte scXref[] = {'x','r','e','f'};
 EStatusCode ObjectsContext::WriteXrefTable(LongFilePositionType& outWritePosition)
 {
 	EStatusCode status = PDFHummus::eSuccess;
+	if(mDeferredOutputStream.Flush() != PDFHummus::eSuccess)
+	{
+		TRACE_LOG("ObjectsContext::WriteXrefTable, failed in deferred streams compression");
+		return PDFHummus::eFailure;
+	}
 	outWritePosition = mOutputStream->GetCurrentPosition();
 	
 	// write xref keyword
@@ -193,7 +254,13 @@ EStatusCode ObjectsContext::WriteXrefTable(LongFilePositionType& outWritePositio
             {
                 // used object
                 
-                if(objectReference.mObjectWritten)
+                if(objectReference.mObjectWritten && objectReference.mObjectStreamID != 0)
+                {
+                    // object streams members can only be referenced from xref streams
+                    status = PDFHummus::eFailure;
+                    TRACE_LOG1("ObjectsContext::WriteXrefTable, Unexpected Failure. Object of ID = %ld was written into an object stream, and cannot be represented in an xref table. use an xref stream",i);
+                }
+                else if(objectReference.mObjectWritten)
                 {
                     SAFE_SPRINTF_2(entryBuffer,21,"%010lld %05ld n\r\n",objectReference.mWritePosition,objectReference.mGenerationNumber);
                     mOutputStream->Write((const IOBasicTypes::Byte *)entryBuffer,20);
@@ -317,21 +384,43 @@ static const std::string scObj = "obj";
 ObjectIDType ObjectsContext::StartNewIndirectObject()
 {
 	ObjectIDType newObjectID = mReferencesRegistry.AllocateNewObjectID();
-	mReferencesRegistry.MarkObjectAsWritten(newObjectID,mOutputStream->GetCurrentPosition());
-	mPrimitiveWriter.WriteInteger(newObjectID);
-	mPrimitiveWriter.WriteInteger(0);
-	mPrimitiveWriter.WriteKeyword(scObj);
+	StartNewIndirectObject(newObjectID);
+	return newObjectID;
+}
+
+void ObjectsContext::StartNewIndirectObject(ObjectIDType inObjectID)
+{
+	if(mIsCapturingStream)
+	{
+		// the captured object header is written only if it ends up being written to the output
+		if(inObjectID == mCapturedObjectID && !mCapturedObjectStarted)
+		{
+			mCapturedObjectStarted = true;
+			return;
+		}
 
-	if(IsEncrypting()) {
-		mEncryptionHelper->OnObjectStart((long long)newObjectID, 0);
+		// some other object is written while capturing, so can't deduplicate. just write what's captured so far
+		TRACE_LOG2("ObjectsContext::StartNewIndirectObject, object %ld started while capturing stream object %ld for deduplication. stream will not be deduplicated",inObjectID,mCapturedObjectID);
+		StopStreamCapture();
 	}
 
-	return newObjectID;
+	// an object started while another is buffered (should not normally happen). just write the buffered one as is
+	if(mIsBufferingObject)
+		WriteBufferedObjectDirectly();
+
+	if(ShouldBufferObject())
+		StartBufferedObject(inObjectID);
+	else
+		WriteIndirectObjectHeader(inObjectID);
 }
 
-void ObjectsContext::StartNewIndirectObject(ObjectIDType inObjectID)
+void ObjectsContext::WriteIndirectObjectHeader(ObjectIDType inObjectID)
 {
-	mReferencesRegistry.MarkObjectAsWritten(inObjectID,mOutputStream->GetCurrentPosition());
+	// with deferred compression the position may not be known yet, so let the output stream mark it when it is
+	if(mOutputStream == &mDeferredOutputStream)
+		mDeferredOutputStream.MarkObjectAsWritten(inObjectID);
+	else
+		mReferencesRegistry.MarkObjectAsWritten(inObjectID,mOutputStream->GetCurrentPosition());
 	mPrimitiveWriter.WriteInteger(inObjectID);
 	mPrimitiveWriter.WriteInteger(0);
 	mPrimitiveWriter.WriteKeyword(scObj);
@@ -356,6 +445,13 @@ void ObjectsContext::StartModifiedIndirectObject(ObjectIDType inObjectID)
 static const std::string scEndObj = "endobj";
 void ObjectsContext::EndIndirectObject()
 {
+	if(mIsBufferingObject)
+	{
+		if(EndBufferedObject() != eSuccess)
+			TRACE_LOG1("ObjectsContext::EndIndirectObject, failed to write object stream when ending object %ld",mBufferedObjectID);
+		return;
+	}
+
 	mPrimitiveWriter.WriteKeyword(scEndObj);
 
 	if (IsEncrypting()) {
@@ -378,6 +474,35 @@ void ObjectsContext::SetCompressStreams(bool inCompressStreams)
 	mCompressStreams = inCompressStreams;
 }
 
+void ObjectsContext::SetFlateEncodingOptions(const FlateEncodingOptions& inFlateEncodingOptions)
+{
+	mFlateEncodingOptions = inFlateEncodingOptions;
+}
+
+const FlateEncodingOptions& ObjectsContext::GetFlateEncodingOptions()
+{
+	return mFlateEncodingOptions;
+}
+
+bool ObjectsContext::IsFlateEncodingStreams()
+{
+	if(!mCompressStreams)
+		return false;
+
+	return !mExtender ||
+			(!mExtender->OverridesStreamCompression() && mExtender->GetStreamFlateEncodingOptions(mFlateEncodingOptions) == mFlateEncodingOptions);
+}
+
+void ObjectsContext::SetDecimalPlaces(unsigned short inDecimalPlaces)
+{
+	mPrimitiveWriter.SetDecimalPlaces(inDecimalPlaces);
+}
+
+unsigned short ObjectsContext::GetDecimalPlaces()
+{
+	return mPrimitiveWriter.GetDecimalPlaces();
+}
+
 static const std::string scLength = "Length";
 static const std::string scStream = "stream";
 static const std::string scEndStream = "endstream";
@@ -386,6 +511,10 @@ static const std::string scFlateDecode = "FlateDecode";
 
 PDFStream* ObjectsContext::StartPDFStream(DictionaryContext* inStreamDictionary,bool inForceDirectExtentObject)
 {
+	// streams cannot be placed in object streams. if the stream object is buffered, write it directly to the file
+	if(mIsBufferingObject)
+		WriteBufferedObjectDirectly();
+
 	// write stream header and allocate PDF stream.
 	// PDF stream will take care of maintaining state for the stream till writing is finished
 
@@ -401,7 +530,8 @@ PDFStream* ObjectsContext::StartPDFStream(DictionaryContext* inStreamDictionary,
 	}
 
 	PDFStream* result = NULL;
-    if(!inForceDirectExtentObject)
+	// captured streams are held in memory anyways, so have their length written directly, to keep them self contained
+    if(!inForceDirectExtentObject && !mIsCapturingStream)
     {
     
         // Length (write as an indirect object)
@@ -415,10 +545,11 @@ PDFStream* ObjectsContext::StartPDFStream(DictionaryContext* inStreamDictionary,
         // Write Stream Content
         WriteKeyword(scStream);
         
-		result = new PDFStream(mCompressStreams,mOutputStream, mEncryptionHelper,lengthObjectID,mExtender);
+		result = new PDFStream(mCompressStreams,mOutputStream, mEncryptionHelper,lengthObjectID,mExtender,
+								mOutputStream == &mDeferredOutputStream ? &mDeferredOutputStream : NULL,mFlateEncodingOptions);
     }
     else
-		result = new PDFStream(mCompressStreams,mOutputStream, mEncryptionHelper,streamDictionaryContext,mExtender);
+		result = new PDFStream(mCompressStreams,mOutputStream, mEncryptionHelper,streamDictionaryContext,mExtender,mFlateEncodingOptions);
 
 	// break encryption, if any, when writing a stream, cause if encryption is desired, only top level elements should be encrypted. hence - the stream itself is, but its contents do not re-encrypt
 	if (mEncryptionHelper)
@@ -429,6 +560,10 @@ PDFStream* ObjectsContext::StartPDFStream(DictionaryContext* inStreamDictionary,
 
 PDFStream* ObjectsContext::StartUnfilteredPDFStream(DictionaryContext* inStreamDictionary)
 {
+	// streams cannot be placed in object streams. if the stream object is buffered, write it directly to the file
+	if(mIsBufferingObject)
+		WriteBufferedObjectDirectly();
+
 	// write stream header and allocate PDF stream.
 	// PDF stream will take care of maintaining state for the stream till writing is finished
 
@@ -436,18 +571,28 @@ PDFStream* ObjectsContext::StartUnfilteredPDFStream(DictionaryContext* inStreamD
 	// Write Stream Dictionary (note that inStreamDictionary is optionally used)
 	DictionaryContext* streamDictionaryContext = (NULL == inStreamDictionary ? StartDictionary() : inStreamDictionary);
 
-	// Length (write as an indirect object)
-	streamDictionaryContext->WriteKey(scLength);
-	ObjectIDType lengthObjectID = mReferencesRegistry.AllocateNewObjectID();
-	streamDictionaryContext->WriteNewObjectReferenceValue(lengthObjectID);
-		
-	EndDictionary(streamDictionaryContext);
-
-	// Write Stream Content
-	WriteKeyword(scStream);
-
-	// now begin the stream itself
-	PDFStream* result = new PDFStream(false,mOutputStream, mEncryptionHelper,lengthObjectID,NULL);
+	PDFStream* result;
+	if(mIsCapturingStream)
+	{
+		// captured streams have their length written directly (see StartPDFStream)
+		result = new PDFStream(false,mOutputStream, mEncryptionHelper,streamDictionaryContext,NULL);
+	}
+	else
+	{
+		// Length (write as an indirect object)
+		streamDictionaryContext->WriteKey(scLength);
+		ObjectIDType lengthObjectID = mReferencesRegistry.AllocateNewObjectID();
+		streamDictionaryContext->WriteNewObjectReferenceValue(lengthObjectID);
+			
+		EndDictionary(streamDictionaryContext);
+
+		// Write Stream Content
+		WriteKeyword(scStream);
+
+		// now begin the stream itself
+		result = new PDFStream(false,mOutputStream, mEncryptionHelper,lengthObjectID,NULL,
+								mOutputStream == &mDeferredOutputStream ? &mDeferredOutputStream : NULL);
+	}
 
 	// break encryption, if any, when writing a stream, cause if encryption is desired, only top level elements should be encrypted. hence - the stream itself is, but its contents do not re-encrypt
 	if(mEncryptionHelper)
@@ -503,11 +648,110 @@ void ObjectsContext::WritePDFStreamEndWithoutExtent()
 
 void ObjectsContext::WritePDFStreamExtent(PDFStream* inStream)
 {
+	if(inStream->IsLengthDeferred())
+	{
+		// length will be known only when compression completes, so can't go into an object stream. write directly
+		if(mIsBufferingObject)
+			WriteBufferedObjectDirectly();
+		WriteIndirectObjectHeader(inStream->GetExtentObjectID());
+		mDeferredOutputStream.WriteEncodedLength(inStream->GetDeferredEncodingID());
+		EndLine();
+		EndIndirectObject();
+		return;
+	}
+
 	StartNewIndirectObject(inStream->GetExtentObjectID());
 	WriteInteger(inStream->GetLength(),eTokenSeparatorEndLine);
 	EndIndirectObject();
 }
 
+void ObjectsContext::SetDeduplicateStreams(bool inDeduplicateStreams)
+{
+	mDeduplicateStreams = inDeduplicateStreams;
+}
+
+bool ObjectsContext::IsDeduplicatingStreams()
+{
+	return mDeduplicateStreams && !IsEncrypting();
+}
+
+void ObjectsContext::StartStreamDeduplication(ObjectIDType inObjectID)
+{
+	// nested deduplication is not supported, the inner object is simply captured as part of the outer one
+	if(!IsDeduplicatingStreams() || mIsCapturingStream)
+		return;
+
+	if(mIsBufferingObject)
+		WriteBufferedObjectDirectly();
+
+	mIsCapturingStream = true;
+	mCapturedObjectID = inObjectID;
+	mCapturedObjectStarted = false;
+	mCapturedStream.Reset();
+	mCaptureSavedOutputStream = mOutputStream;
+	mOutputStream = &mCapturedStream;
+	mCurrentStream = &mCapturedStream;
+	mPrimitiveWriter.SetStreamForWriting(&mCapturedStream);
+}
+
+void ObjectsContext::StopStreamCapture()
+{
+	mIsCapturingStream = false;
+	mOutputStream = mCaptureSavedOutputStream;
+	mCurrentStream = mOutputStream;
+	mPrimitiveWriter.SetStreamForWriting(mOutputStream);
+	mCaptureSavedOutputStream = NULL;
+
+	// write the captured object, if there's any
+	if(mCapturedObjectStarted)
+	{
+		std::string capturedObject = mCapturedStream.ToString();
+		WriteIndirectObjectHeader(mCapturedObjectID);
+		mOutputStream->Write((const IOBasicTypes::Byte*)capturedObject.c_str(),capturedObject.size());
+	}
+	mCapturedStream.Reset();
+}
+
+ObjectIDType ObjectsContext::EndStreamDeduplication(ObjectIDType inObjectID)
+{
+	if(!mIsCapturingStream || mCapturedObjectID != inObjectID)
+		return inObjectID;
+
+	if(!mCapturedObjectStarted)
+	{
+		StopStreamCapture();
+		return inObjectID;
+	}
+
+	// identify the stream by the hash of its content (which excludes the object header, so it's the same for identical streams)
+	std::string capturedObject = mCapturedStream.ToString();
+	MD5Generator md5;
+	md5.Accumulate(capturedObject);
+	std::string streamKey = md5.ToStringAsString() + Long((long)capturedObject.size()).ToString();
+
+	// a matching hash is only a candidate. compare the content in full, so a colliding stream is never taken for another one
+	std::pair<StringToStringAndObjectIDTypeMultimap::iterator,StringToStringAndObjectIDTypeMultimap::iterator> range = mWrittenStreams.equal_range(streamKey);
+	StringToStringAndObjectIDTypeMultimap::iterator it = range.first;
+	for(; it != range.second; ++it)
+	{
+		if(it->second.first == capturedObject)
+			break;
+	}
+
+	if(it == range.second)
+	{
+		StopStreamCapture();
+		mWrittenStreams.insert(StringToStringAndObjectIDTypeMultimap::value_type(streamKey,StringAndObjectIDType(capturedObject,inObjectID)));
+		return inObjectID;
+	}
+
+	// identical stream already written. drop the captured one, and free its ID
+	mCapturedObjectStarted = false;
+	StopStreamCapture();
+	mReferencesRegistry.DeleteObject(inObjectID);
+	return it->second.second;
+}
+
 void ObjectsContext::SetObjectsContextExtender(IObjectsContextExtender* inExtender)
 {
 	mExtender = inExtender;
@@ -524,6 +768,16 @@ EStatusCode ObjectsContext::WriteState(ObjectsContext* inStateWriter,ObjectIDTyp
 		
 	do
 	{
+		// complete any pending object stream, so that the registry state is final
+		status = FlushObjectStream();
+		if(status != PDFHummus::eSuccess)
+			break;
+
+		// and complete deferred compression, for the same reason
+		status = mDeferredOutputStream.Flush();
+		if(status != PDFHummus::eSuccess)
+			break;
+
 		inStateWriter->StartNewIndirectObject(inObjectID);
 
 		ObjectIDType referencesRegistryObjectID = inStateWriter->GetInDirectObjectsRegistry().AllocateNewObjectID();
@@ -540,6 +794,30 @@ EStatusCode ObjectsContext::WriteState(ObjectsContext* inStateWriter,ObjectIDTyp
 		objectsContextDict->WriteKey("mCompressStreams");
 		objectsContextDict->WriteBooleanValue(mCompressStreams);
 
+		objectsContextDict->WriteKey("mWriteObjectStreams");
+		objectsContextDict->WriteBooleanValue(mWriteObjectStreams);
+
+		objectsContextDict->WriteKey("mFlateLevel");
+		objectsContextDict->WriteIntegerValue(mFlateEncodingOptions.Level);
+
+		objectsContextDict->WriteKey("mFlateStrategy");
+		objectsContextDict->WriteIntegerValue(mFlateEncodingOptions.Strategy);
+
+		objectsContextDict->WriteKey("mFlateMemoryLevel");
+		objectsContextDict->WriteIntegerValue(mFlateEncodingOptions.MemoryLevel);
+
+		objectsContextDict->WriteKey("mDeduplicateStreams");
+		objectsContextDict->WriteBooleanValue(mDeduplicateStreams);
+
+		objectsContextDict->WriteKey("mDeferStreamCompression");
+		objectsContextDict->WriteBooleanValue(mDeferStreamCompression);
+
+		objectsContextDict->WriteKey("mStreamCompressionThreads");
+		objectsContextDict->WriteIntegerValue(mStreamCompressionThreads);
+
+		objectsContextDict->WriteKey("mDecimalPlaces");
+		objectsContextDict->WriteIntegerValue(mPrimitiveWriter.GetDecimalPlaces());
+
 		objectsContextDict->WriteKey("mSubsetFontsNamesSequance");
 		objectsContextDict->WriteNewObjectReferenceValue(subsetFontsNameSequanceID);
 
@@ -578,6 +856,28 @@ EStatusCode ObjectsContext::ReadState(PDFParser* inStateReader,ObjectIDType inOb
 	PDFObjectCastPtr<PDFBoolean> compressStreams(objectsContext->QueryDirectObject("mCompressStreams"));
 	mCompressStreams = compressStreams->GetValue();
 
+	PDFObjectCastPtr<PDFBoolean> writeObjectStreams(objectsContext->QueryDirectObject("mWriteObjectStreams"));
+	mWriteObjectStreams = !!writeObjectStreams && writeObjectStreams->GetValue();
+
+	PDFObjectCastPtr<PDFInteger> flateLevel(objectsContext->QueryDirectObject("mFlateLevel"));
+	PDFObjectCastPtr<PDFInteger> flateStrategy(objectsContext->QueryDirectObject("mFlateStrategy"));
+	PDFObjectCastPtr<PDFInteger> flateMemoryLevel(objectsContext->QueryDirectObject("mFlateMemoryLevel"));
+	if(!!flateLevel && !!flateStrategy && !!flateMemoryLevel)
+		mFlateEncodingOptions = FlateEncodingOptions((int)flateLevel->GetValue(),(int)flateStrategy->GetValue(),(int)flateMemoryLevel->GetValue());
+	else
+		mFlateEncodingOptions = FlateEncodingOptions::DefaultFlateEncodingOptions();
+
+	PDFObjectCastPtr<PDFBoolean> deduplicateStreams(objectsContext->QueryDirectObject("mDeduplicateStreams"));
+	mDeduplicateStreams = !!deduplicateStreams && deduplicateStreams->GetValue();
+
+	PDFObjectCastPtr<PDFBoolean> deferStreamCompression(objectsContext->QueryDirectObject("mDeferStreamCompression"));
+	PDFObjectCastPtr<PDFInteger> streamCompressionThreads(objectsContext->QueryDirectObject("mStreamCompressionThreads"));
+	SetDeferredStreamCompression(!!deferStreamCompression && deferStreamCompression->GetValue(),
+								!streamCompressionThreads ? 0 : (unsigned int)streamCompressionThreads->GetValue());
+
+	PDFObjectCastPtr<PDFInteger> decimalPlaces(objectsContext->QueryDirectObject("mDecimalPlaces"));
+	mPrimitiveWriter.SetDecimalPlaces(!decimalPlaces ? PrimitiveObjectsWriter::scDefaultDecimalPlaces : (unsigned short)decimalPlaces->GetValue());
+
 	PDFObjectCastPtr<PDFDictionary> subsetFontsNamesSequance(inStateReader->QueryDictionaryObject(objectsContext.GetPtr(),"mSubsetFontsNamesSequance"));
 	PDFObjectCastPtr<PDFLiteralString> sequanceString(subsetFontsNamesSequance->QueryDirectObject("mSequanceString"));
 	mSubsetFontsNamesSequance.SetSequanceString(sequanceString->GetValue());
@@ -590,10 +890,27 @@ EStatusCode ObjectsContext::ReadState(PDFParser* inStateReader,ObjectIDType inOb
 
 void ObjectsContext::Cleanup()
 {
+	mDeferredOutputStream.Assign(NULL,NULL);
+	mDeferStreamCompression = false;
+	mStreamCompressionThreads = 0;
+	mTargetOutputStream = NULL;
 	mOutputStream = NULL;
 	mCompressStreams = true;
+	mFlateEncodingOptions = FlateEncodingOptions::DefaultFlateEncodingOptions();
+	mDeduplicateStreams = false;
+	mIsCapturingStream = false;
+	mCapturedObjectID = 0;
+	mCapturedObjectStarted = false;
+	mCaptureSavedOutputStream = NULL;
+	mCapturedStream.Reset();
+	mWrittenStreams.clear();
 	mExtender = NULL;
 	mEncryptionHelper = NULL;
+	mWriteObjectStreams = false;
+	mCurrentStream = NULL;
+	mIsBufferingObject = false;
+	ResetObjectStreamState();
+	mPrimitiveWriter.SetDecimalPlaces(PrimitiveObjectsWriter::scDefaultDecimalPlaces);
 
 	mSubsetFontsNamesSequance.Reset();
 	mReferencesRegistry.Reset();
@@ -608,6 +925,12 @@ EStatusCode ObjectsContext::WriteXrefStream(DictionaryContext* inDictionaryConte
 {
     // k. complement input dictionary with the relevant entries - W and Index
     // then continue with a regular stream, forced to have "length" as direct object
+
+	if(mDeferredOutputStream.Flush() != PDFHummus::eSuccess)
+	{
+		TRACE_LOG("ObjectsContext::WriteXrefStream, failed in deferred streams compression");
+		return PDFHummus::eFailure;
+	}
     
     // write Index entry
     inDictionaryContext->WriteKey("Index");
@@ -640,11 +963,39 @@ EStatusCode ObjectsContext::WriteXrefStream(DictionaryContext* inDictionaryConte
     EndArray();
     EndLine();
     
-    // write W entry, which is going to be 1 sizeof(long long) and sizeof(unsigned long), per the types i'm using
+    // write W entry. use the minimal widths that can hold the largest position (or object stream ID) and generation (or object stream index).
+    // note that this xref stream object itself may not be marked as written yet (if it is buffered), so consider the current position as well
     
+    LongFilePositionType maxLocation = std::max<LongFilePositionType>(mOutputStream->GetCurrentPosition(),mReferencesRegistry.GetObjectsCount());
+    LongFilePositionType maxGeneration = 0;
+    for(ObjectIDType i = 0; i < mReferencesRegistry.GetObjectsCount();++i)
+    {
+        const ObjectWriteInformation& objectReference = mReferencesRegistry.GetNthObjectReference(i);
+        if(!objectReference.mIsDirty)
+            continue;
+        if(objectReference.mObjectReferenceType == ObjectWriteInformation::Free)
+        {
+            maxGeneration = std::max<LongFilePositionType>(maxGeneration,objectReference.mGenerationNumber);
+        }
+        else if(!objectReference.mObjectWritten)
+        {
+            // not written yet, nothing to consider
+        }
+        else if(objectReference.mObjectStreamID != 0)
+        {
+            maxLocation = std::max<LongFilePositionType>(maxLocation,objectReference.mObjectStreamID);
+            maxGeneration = std::max<LongFilePositionType>(maxGeneration,objectReference.mObjectStreamIndex);
+        }
+        else
+        {
+            maxLocation = std::max<LongFilePositionType>(maxLocation,objectReference.mWritePosition);
+            maxGeneration = std::max<LongFilePositionType>(maxGeneration,objectReference.mGenerationNumber);
+        }
+    }
+
     size_t typeSize = 1;
-    size_t locationSize = sizeof(LongFilePositionType);
-    size_t generationSize = sizeof(unsigned long);
+    size_t locationSize = GetXrefNumberSize(maxLocation);
+    size_t generationSize = GetXrefNumberSize(maxGeneration);
     
     inDictionaryContext->WriteKey("W");
     StartArray();
@@ -674,7 +1025,14 @@ EStatusCode ObjectsContext::WriteXrefStream(DictionaryContext* inDictionaryConte
             {
                 // used object
                 
-                if(objectReference.mObjectWritten)
+                if(objectReference.mObjectWritten && objectReference.mObjectStreamID != 0)
+                {
+                    // compressed object, in object stream
+                    WriteXrefNumber(aStream->GetWriteStream(),2,typeSize);
+                    WriteXrefNumber(aStream->GetWriteStream(),objectReference.mObjectStreamID,locationSize);
+                    WriteXrefNumber(aStream->GetWriteStream(),objectReference.mObjectStreamIndex,generationSize);
+                }
+                else if(objectReference.mObjectWritten)
                 {
                     WriteXrefNumber(aStream->GetWriteStream(),1,typeSize);
                     WriteXrefNumber(aStream->GetWriteStream(),objectReference.mWritePosition,locationSize);
@@ -735,3 +1093,130 @@ void ObjectsContext::WriteXrefNumber(IByteWriter* inStream,LongFilePositionType
     inStream->Write(buffer,inElementSize);
 	delete[] buffer;
 }
+
+size_t ObjectsContext::GetXrefNumberSize(LongFilePositionType inMaxElement)
+{
+    size_t result = 1;
+    
+    while(inMaxElement > 0xff)
+    {
+        inMaxElement = inMaxElement >> 8;
+        ++result;
+    }
+    return result;
+}
+
+void ObjectsContext::SetWriteObjectStreams(bool inWriteObjectStreams)
+{
+	mWriteObjectStreams = inWriteObjectStreams;
+}
+
+bool ObjectsContext::IsWritingObjectStreams()
+{
+	return mWriteObjectStreams;
+}
+
+bool ObjectsContext::ShouldBufferObject()
+{
+	// encrypted documents don't use object streams. strings in them would need to be encrypted per the containing stream
+	return mWriteObjectStreams && (!mEncryptionHelper || !mEncryptionHelper->IsDocumentEncrypted());
+}
+
+void ObjectsContext::StartBufferedObject(ObjectIDType inObjectID)
+{
+	mIsBufferingObject = true;
+	mBufferedObjectID = inObjectID;
+	mBufferedObject.Reset();
+	mCurrentStream = &mBufferedObject;
+	mPrimitiveWriter.SetStreamForWriting(&mBufferedObject);
+}
+
+void ObjectsContext::WriteBufferedObjectDirectly()
+{
+	std::string objectContent = mBufferedObject.ToString();
+
+	mIsBufferingObject = false;
+	mCurrentStream = mOutputStream;
+	mPrimitiveWriter.SetStreamForWriting(mOutputStream);
+
+	WriteIndirectObjectHeader(mBufferedObjectID);
+	mOutputStream->Write((const IOBasicTypes::Byte*)objectContent.c_str(),objectContent.size());
+}
+
+static const size_t scMaxObjectsInObjectStream = 100;
+
+EStatusCode ObjectsContext::EndBufferedObject()
+{
+	std::string objectContent = mBufferedObject.ToString();
+
+	mIsBufferingObject = false;
+	mCurrentStream = mOutputStream;
+	mPrimitiveWriter.SetStreamForWriting(mOutputStream);
+
+	if(0 == mObjectStreamID)
+		mObjectStreamID = mReferencesRegistry.AllocateNewObjectID();
+
+	EStatusCode status = mReferencesRegistry.MarkObjectAsWrittenInObjectStream(mBufferedObjectID,mObjectStreamID,(unsigned long)mObjectStreamEntries.size());
+	if(status != eSuccess)
+		return status;
+
+	mObjectStreamEntries.push_back(ObjectIDTypeAndOffset(mBufferedObjectID,mObjectStreamData.size()));
+	mObjectStreamData.append(objectContent);
+	// make sure objects are separated
+	if(objectContent.size() == 0 || (objectContent[objectContent.size()-1] != '\n' && objectContent[objectContent.size()-1] != '\r'))
+		mObjectStreamData.push_back('\n');
+
+	if(mObjectStreamEntries.size() >= scMaxObjectsInObjectStream)
+		status = FlushObjectStream();
+
+	return status;
+}
+
+static const std::string scType = "Type";
+static const std::string scObjStm = "ObjStm";
+static const std::string scN = "N";
+static const std::string scFirst = "First";
+
+EStatusCode ObjectsContext::FlushObjectStream()
+{
+	if(mObjectStreamEntries.size() == 0)
+		return eSuccess;
+
+	// the object stream starts with pairs of object number and offset (relative to the first object), followed by the objects themselves
+	OutputStringBufferStream headerStream;
+	PrimitiveObjectsWriter headerWriter(&headerStream);
+	ObjectIDTypeAndOffsetVector::iterator it = mObjectStreamEntries.begin();
+	for(; it != mObjectStreamEntries.end(); ++it)
+	{
+		headerWriter.WriteInteger(it->first);
+		headerWriter.WriteInteger(it->second);
+	}
+	headerWriter.EndLine();
+	std::string header = headerStream.ToString();
+
+	// the object stream length has to be a direct object, as it cannot be placed in an object stream
+	WriteIndirectObjectHeader(mObjectStreamID);
+	DictionaryContext* objectStreamDictionary = StartDictionary();
+	objectStreamDictionary->WriteKey(scType);
+	objectStreamDictionary->WriteNameValue(scObjStm);
+	objectStreamDictionary->WriteKey(scN);
+	objectStreamDictionary->WriteIntegerValue(mObjectStreamEntries.size());
+	objectStreamDictionary->WriteKey(scFirst);
+	objectStreamDictionary->WriteIntegerValue(header.size());
+
+	PDFStream* objectStream = StartPDFStream(objectStreamDictionary,true);
+	objectStream->GetWriteStream()->Write((const IOBasicTypes::Byte*)header.c_str(),header.size());
+	objectStream->GetWriteStream()->Write((const IOBasicTypes::Byte*)mObjectStreamData.c_str(),mObjectStreamData.size());
+	EndPDFStream(objectStream);
+	delete objectStream;
+
+	ResetObjectStreamState();
+	return eSuccess;
+}
+
+void ObjectsContext::ResetObjectStreamState()
+{
+	mObjectStreamID = 0;
+	mObjectStreamData.clear();
+	mObjectStreamEntries.clear();
+}
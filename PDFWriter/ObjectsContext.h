@@ -25,8 +25,14 @@
 #include "ETokenSeparator.h"
 #include "PrimitiveObjectsWriter.h"
 #include "UppercaseSequance.h"
+#include "OutputStringBufferStream.h"
+#include "OutputDeferredCompressionStream.h"
+#include "FlateEncodingOptions.h"
 #include <string>
 #include <list>
+#include <vector>
+#include <utility>
+#include <map>
 
 
 
@@ -39,6 +45,10 @@ class PDFParser;
 class EncryptionHelper;
 
 typedef std::list<DictionaryContext*> DictionaryContextList;
+typedef std::pair<ObjectIDType,LongFilePositionType> ObjectIDTypeAndOffset;
+typedef std::vector<ObjectIDTypeAndOffset> ObjectIDTypeAndOffsetVector;
+typedef std::pair<std::string,ObjectIDType> StringAndObjectIDType;
+typedef std::multimap<std::string,StringAndObjectIDType> StringToStringAndObjectIDTypeMultimap;
 
 class ObjectsContext
 {
@@ -55,8 +65,17 @@ public:
 
 	// pre 1.5 xref writing
 	PDFHummus::EStatusCode WriteXrefTable(LongFilePositionType& outWritePosition);
-    // post 1.5 xref writing (only used now for modified files)
+    // post 1.5 xref writing (used for modified files, and for new files when writing object streams)
     PDFHummus::EStatusCode WriteXrefStream(DictionaryContext* inDictionaryContext);
+
+	// Object streams (PDF 1.5). when on, non-stream indirect objects are packed into /ObjStm containers (compressed
+	// per the compress streams setting) instead of being written to the file directly. objects that turn out to be streams
+	// are written directly. files with object streams must end with an xref stream, so finish with WriteXrefStream.
+	// object streams are not used when the document is encrypted.
+	void SetWriteObjectStreams(bool inWriteObjectStreams);
+	bool IsWritingObjectStreams();
+	// write the currently accumulated object stream, if any. must be called prior to writing the xref
+	PDFHummus::EStatusCode FlushObjectStream();
     
 	// Free Context, for direct writing to output stream
 	IByteWriterWithPosition* StartFreeContext();
@@ -115,6 +134,34 @@ public:
 	// Sets whether streams created by the objects context will be compressed (with flate) or not
 	void SetCompressStreams(bool inCompressStreams);
 
+	// Sets the flate compression parameters for streams created by the objects context. an extender may adjust them per stream
+	void SetFlateEncodingOptions(const FlateEncodingOptions& inFlateEncodingOptions);
+	const FlateEncodingOptions& GetFlateEncodingOptions();
+	// whether streams started with StartPDFStream are flate encoded with GetFlateEncodingOptions as is, with no extender compression or options
+	// of its own. data encoded ahead with these options may then be written with StartUnfilteredPDFStream and a FlateDecode filter, for the same result
+	bool IsFlateEncodingStreams();
+
+	// Sets whether flate compression of streams is deferred to worker threads (inThreadsCount of 0 means using the machine cores count).
+	// output is identical to regular writing, it's just done in parallel to writing the rest of the document. call before SetOutputStream
+	// (or set the output stream again after)
+	void SetDeferredStreamCompression(bool inDeferStreamCompression,unsigned int inThreadsCount = 0);
+	bool IsDeferringStreamCompression();
+
+	// Streams deduplication. when on, stream objects written between StartStreamDeduplication and EndStreamDeduplication
+	// are held in memory, and if an identical stream (dictionary and data, compared in full) was already written, it is not written again.
+	// written streams content is kept in memory for the comparison.
+	// EndStreamDeduplication returns the ID to use for the stream, which is the ID of the earlier identical stream in that case
+	// (inObjectID then becomes a free object). Use only for objects that were not referenced yet.
+	// not used when encrypting, as encrypted streams are never identical
+	void SetDeduplicateStreams(bool inDeduplicateStreams);
+	bool IsDeduplicatingStreams();
+	void StartStreamDeduplication(ObjectIDType inObjectID);
+	ObjectIDType EndStreamDeduplication(ObjectIDType inObjectID);
+
+	// Sets the number of decimal places for writing real numbers, here and in content streams created for the document
+	void SetDecimalPlaces(unsigned short inDecimalPlaces);
+	unsigned short GetDecimalPlaces();
+
 	// Create PDF stream and write it's header. note that stream are written with indirect object for Length, to allow one pass writing.
 	// inStreamDictionary can be passed in order to include stream generic information in an already written stream dictionary
 	// that is type specific. [the method will take care of closing the dictionary.
@@ -140,14 +187,53 @@ public:
 private:
 	IObjectsContextExtender* mExtender;
 	IByteWriterWithPosition* mOutputStream;
+	IByteWriterWithPosition* mTargetOutputStream;
 	IndirectObjectsReferenceRegistry mReferencesRegistry;
 	PrimitiveObjectsWriter mPrimitiveWriter;
 	bool mCompressStreams;
+	FlateEncodingOptions mFlateEncodingOptions;
 	UppercaseSequance mSubsetFontsNamesSequance;
 	EncryptionHelper* mEncryptionHelper;
 
 	DictionaryContextList mDictionaryStack;
 
+	// object streams writing state. when an object is being buffered, tokens are written to mBufferedObject
+	// (mCurrentStream points to it) and collected into mObjectStreamData on EndIndirectObject
+	bool mWriteObjectStreams;
+	IByteWriterWithPosition* mCurrentStream;
+	bool mIsBufferingObject;
+	ObjectIDType mBufferedObjectID;
+	OutputStringBufferStream mBufferedObject;
+	ObjectIDType mObjectStreamID;
+	std::string mObjectStreamData;
+	ObjectIDTypeAndOffsetVector mObjectStreamEntries;
+
+	bool ShouldBufferObject();
+	void WriteIndirectObjectHeader(ObjectIDType inObjectID);
+	void StartBufferedObject(ObjectIDType inObjectID);
+	void WriteBufferedObjectDirectly();
+	PDFHummus::EStatusCode EndBufferedObject();
+	void ResetObjectStreamState();
+	size_t GetXrefNumberSize(LongFilePositionType inMaxElement);
+
+	// deferred stream compression. when on, mOutputStream is mDeferredOutputStream, which writes to mTargetOutputStream
+	bool mDeferStreamCompression;
+	unsigned int mStreamCompressionThreads;
+	OutputDeferredCompressionStream mDeferredOutputStream;
+	void SetupOutputStream();
+
+	// streams deduplication. while capturing, mOutputStream is mCapturedStream, and the captured object header is not written.
+	// mWrittenStreams maps content hashes of written streams to their content and object IDs. the content is kept so that
+	// a hash match is verified byte by byte before reusing an object, as MD5 collisions are easy to construct
+	bool mDeduplicateStreams;
+	bool mIsCapturingStream;
+	ObjectIDType mCapturedObjectID;
+	bool mCapturedObjectStarted;
+	IByteWriterWithPosition* mCaptureSavedOutputStream;
+	OutputStringBufferStream mCapturedStream;
+	StringToStringAndObjectIDTypeMultimap mWrittenStreams;
+	void StopStreamCapture();
+
 	void WritePDFStreamEndWithoutExtent();
 	void WritePDFStreamExtent(PDFStream* inStream);
     void WriteXrefNumber(IByteWriter* inStream,LongFilePositionType inElement, size_t inElementSize);
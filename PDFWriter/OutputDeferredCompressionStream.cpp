@@ -0,0 +1,344 @@
+/*
+   Source File : OutputDeferredCompressionStream.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "OutputDeferredCompressionStream.h"
+#include "IndirectObjectsReferenceRegistry.h"
+#include "Trace.h"
+
+using namespace IOBasicTypes;
+using namespace PDFHummus;
+
+enum EDeferredOutputSegmentType
+{
+	eDeferredOutputLiteral,
+	eDeferredOutputFlateEncoding,
+	eDeferredOutputEncodedLength,
+	eDeferredOutputObjectPosition
+};
+
+struct DeferredOutputSegment
+{
+	DeferredOutputSegment(EDeferredOutputSegmentType inType) {mType = inType; mEncodingID = 0; mObjectID = 0; mDone = false; mStatus = eSuccess;}
+
+	EDeferredOutputSegmentType mType;
+	// literal bytes, or data to encode (replaced with the encoded data when done)
+	ByteVector mData;
+	unsigned long mEncodingID;
+	ObjectIDType mObjectID;
+	FlateEncodingOptions mOptions;
+	// encodings only. guarded by the stream lock
+	bool mDone;
+	EStatusCode mStatus;
+};
+
+OutputDeferredCompressionStream::OutputDeferredCompressionStream(void)
+{
+	mTargetStream = NULL;
+	mObjectsRegistry = NULL;
+	mWorkersCount = 0;
+	mStatus = eSuccess;
+	mNextEncodingID = 1;
+	mQueuedEncodingsCount = 0;
+	mQueuedLiteralsSize = 0;
+	mStopWorkers = false;
+}
+
+OutputDeferredCompressionStream::~OutputDeferredCompressionStream(void)
+{
+	Reset();
+}
+
+void OutputDeferredCompressionStream::Assign(IByteWriterWithPosition* inTargetStream,IndirectObjectsReferenceRegistry* inObjectsRegistry,unsigned int inWorkersCount)
+{
+	Reset();
+	mTargetStream = inTargetStream;
+	mObjectsRegistry = inObjectsRegistry;
+	mWorkersCount = inWorkersCount > 0 ? inWorkersCount : std::thread::hardware_concurrency();
+	if(0 == mWorkersCount)
+		mWorkersCount = 1;
+}
+
+void OutputDeferredCompressionStream::Reset()
+{
+	StopWorkers();
+
+	DeferredOutputSegmentDeque::iterator it = mSegments.begin();
+	for(; it != mSegments.end(); ++it)
+		delete *it;
+	mSegments.clear();
+	mPendingEncodings.clear();
+	mEncodedLengths.clear();
+	mQueuedEncodingsCount = 0;
+	mQueuedLiteralsSize = 0;
+	mStatus = eSuccess;
+}
+
+void OutputDeferredCompressionStream::StartWorkers()
+{
+	mStopWorkers = false;
+	for(unsigned int i = 0; i < mWorkersCount; ++i)
+		mWorkers.push_back(std::thread(&OutputDeferredCompressionStream::WorkerLoop,this));
+}
+
+void OutputDeferredCompressionStream::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(mLock);
+		mStopWorkers = true;
+	}
+	mEncodingsAvailable.notify_all();
+
+	ThreadVector::iterator it = mWorkers.begin();
+	for(; it != mWorkers.end(); ++it)
+		it->join();
+	mWorkers.clear();
+}
+
+void OutputDeferredCompressionStream::WorkerLoop()
+{
+	for(;;)
+	{
+		DeferredOutputSegment* segment;
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+			while(!mStopWorkers && mPendingEncodings.empty())
+				mEncodingsAvailable.wait(lock);
+			if(mStopWorkers)
+				break;
+			segment = mPendingEncodings.front();
+			mPendingEncodings.pop_front();
+		}
+
+		// the segment is owned by the main thread, but its data is not touched there till it's marked as done
+		ByteVector encoded;
+		EStatusCode status = segment->mData.size() > 0 ?
+								OutputFlateEncodeStream::EncodeBuffer(&segment->mData[0],segment->mData.size(),encoded,segment->mOptions) :
+								OutputFlateEncodeStream::EncodeBuffer(NULL,0,encoded,segment->mOptions);
+
+		{
+			std::lock_guard<std::mutex> lock(mLock);
+			segment->mData.swap(encoded);
+			segment->mStatus = status;
+			segment->mDone = true;
+		}
+		mEncodingDone.notify_all();
+	}
+}
+
+LongBufferSizeType OutputDeferredCompressionStream::Write(const Byte* inBuffer,LongBufferSizeType inSize)
+{
+	if(mSegments.empty())
+		return mTargetStream->Write(inBuffer,inSize);
+
+	if(mSegments.back()->mType != eDeferredOutputLiteral)
+		mSegments.push_back(new DeferredOutputSegment(eDeferredOutputLiteral));
+	mSegments.back()->mData.insert(mSegments.back()->mData.end(),inBuffer,inBuffer + inSize);
+	mQueuedLiteralsSize += inSize;
+	return inSize;
+}
+
+LongFilePositionType OutputDeferredCompressionStream::GetCurrentPosition()
+{
+	LongFilePositionType position = mTargetStream->GetCurrentPosition() + mQueuedLiteralsSize;
+	if(0 == mQueuedEncodingsCount)
+		return position;
+
+	// add the sizes of the queued encodings, and of their lengths, which are known once the encodings complete.
+	// lengths of encodings that are not queued anymore are in mEncodedLengths
+	ULongToLongBufferSizeTypeMap queuedLengths;
+	DeferredOutputSegmentDeque::iterator it = mSegments.begin();
+	for(; it != mSegments.end(); ++it)
+	{
+		DeferredOutputSegment* segment = *it;
+		if(eDeferredOutputFlateEncoding == segment->mType)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mLock);
+				while(!segment->mDone)
+					mEncodingDone.wait(lock);
+			}
+			position += segment->mData.size();
+			queuedLengths.insert(ULongToLongBufferSizeTypeMap::value_type(segment->mEncodingID,segment->mData.size()));
+		}
+		else if(eDeferredOutputEncodedLength == segment->mType)
+		{
+			ULongToLongBufferSizeTypeMap::iterator itLength = queuedLengths.find(segment->mEncodingID);
+			if(itLength == queuedLengths.end())
+			{
+				itLength = mEncodedLengths.find(segment->mEncodingID);
+				if(itLength == mEncodedLengths.end())
+					continue;
+			}
+			position += GetDecimalLength(itLength->second);
+		}
+	}
+	return position;
+}
+
+unsigned long OutputDeferredCompressionStream::QueueFlateEncoding(ByteVector& ioData,const FlateEncodingOptions& inOptions)
+{
+	if(mWorkers.empty())
+		StartWorkers();
+
+	DeferredOutputSegment* segment = new DeferredOutputSegment(eDeferredOutputFlateEncoding);
+	segment->mEncodingID = mNextEncodingID++;
+	segment->mOptions = inOptions;
+	segment->mData.swap(ioData);
+	mSegments.push_back(segment);
+	++mQueuedEncodingsCount;
+
+	{
+		std::lock_guard<std::mutex> lock(mLock);
+		mPendingEncodings.push_back(segment);
+	}
+	mEncodingsAvailable.notify_one();
+
+	// write whatever is ready. limit the amount of queued encodings (and so memory), by waiting for the
+	// first one when there's too many
+	WriteReadySegments(false);
+	while(mQueuedEncodingsCount > mWorkersCount * 4)
+		WriteReadySegments(true);
+
+	return segment->mEncodingID;
+}
+
+void OutputDeferredCompressionStream::WriteEncodedLength(unsigned long inEncodingID)
+{
+	ULongToLongBufferSizeTypeMap::iterator it = mEncodedLengths.find(inEncodingID);
+	if(it != mEncodedLengths.end())
+	{
+		// already known
+		WriteDecimal(this,it->second);
+		mEncodedLengths.erase(it);
+	}
+	else
+	{
+		DeferredOutputSegment* segment = new DeferredOutputSegment(eDeferredOutputEncodedLength);
+		segment->mEncodingID = inEncodingID;
+		mSegments.push_back(segment);
+	}
+}
+
+void OutputDeferredCompressionStream::MarkObjectAsWritten(ObjectIDType inObjectID)
+{
+	if(mSegments.empty())
+	{
+		mObjectsRegistry->MarkObjectAsWritten(inObjectID,mTargetStream->GetCurrentPosition());
+	}
+	else
+	{
+		DeferredOutputSegment* segment = new DeferredOutputSegment(eDeferredOutputObjectPosition);
+		segment->mObjectID = inObjectID;
+		mSegments.push_back(segment);
+	}
+}
+
+bool OutputDeferredCompressionStream::HasPendingWork()
+{
+	return !mSegments.empty();
+}
+
+EStatusCode OutputDeferredCompressionStream::Flush()
+{
+	while(!mSegments.empty())
+		WriteReadySegments(true);
+	return mStatus;
+}
+
+void OutputDeferredCompressionStream::WriteReadySegments(bool inWaitForFirstEncoding)
+{
+	while(!mSegments.empty())
+	{
+		DeferredOutputSegment* segment = mSegments.front();
+
+		if(eDeferredOutputFlateEncoding == segment->mType)
+		{
+			std::unique_lock<std::mutex> lock(mLock);
+			if(!segment->mDone)
+			{
+				if(!inWaitForFirstEncoding)
+					break;
+				while(!segment->mDone)
+					mEncodingDone.wait(lock);
+			}
+			inWaitForFirstEncoding = false;
+		}
+
+		// pop before writing, so that writes go directly to the target
+		mSegments.pop_front();
+
+		switch(segment->mType)
+		{
+			case eDeferredOutputLiteral:
+				if(segment->mData.size() > 0)
+					mTargetStream->Write(&segment->mData[0],segment->mData.size());
+				mQueuedLiteralsSize -= segment->mData.size();
+				break;
+			case eDeferredOutputFlateEncoding:
+				if(segment->mStatus != eSuccess)
+				{
+					TRACE_LOG1("OutputDeferredCompressionStream::WriteReadySegments, failed to flate encode stream data for encoding %ld",segment->mEncodingID);
+					mStatus = eFailure;
+				}
+				if(segment->mData.size() > 0)
+					mTargetStream->Write(&segment->mData[0],segment->mData.size());
+				mEncodedLengths.insert(ULongToLongBufferSizeTypeMap::value_type(segment->mEncodingID,segment->mData.size()));
+				--mQueuedEncodingsCount;
+				break;
+			case eDeferredOutputEncodedLength:
+			{
+				// the encoding always precedes its length, so it's known by now
+				ULongToLongBufferSizeTypeMap::iterator it = mEncodedLengths.find(segment->mEncodingID);
+				WriteDecimal(mTargetStream,it == mEncodedLengths.end() ? 0 : it->second);
+				if(it != mEncodedLengths.end())
+					mEncodedLengths.erase(it);
+				break;
+			}
+			case eDeferredOutputObjectPosition:
+				if(mObjectsRegistry->MarkObjectAsWritten(segment->mObjectID,mTargetStream->GetCurrentPosition()) != eSuccess)
+					mStatus = eFailure;
+				break;
+		}
+		delete segment;
+	}
+}
+
+void OutputDeferredCompressionStream::WriteDecimal(IByteWriter* inStream,LongBufferSizeType inValue)
+{
+	Byte buffer[24];
+	Byte* start = buffer + sizeof(buffer);
+	do
+	{
+		*(--start) = (Byte)('0' + inValue % 10);
+		inValue /= 10;
+	} while(inValue != 0);
+	inStream->Write(start,buffer + sizeof(buffer) - start);
+}
+
+LongBufferSizeType OutputDeferredCompressionStream::GetDecimalLength(LongBufferSizeType inValue)
+{
+	LongBufferSizeType length = 1;
+	while(inValue >= 10)
+	{
+		inValue /= 10;
+		++length;
+	}
+	return length;
+}
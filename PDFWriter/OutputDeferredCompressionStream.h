@@ -0,0 +1,113 @@
+/*
+   Source File : OutputDeferredCompressionStream.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+/*
+	OutputDeferredCompressionStream is an output stream that allows compressing streams on worker threads while
+	the document writing continues. Streams data is queued with QueueFlateEncoding, and anything written after it is
+	queued in order behind it, so the final output is exactly the same as if everything was written sequentially.
+	When nothing is pending, writes go directly to the target stream.
+
+	Positions of the queued content are not known until the pending compressions complete, so objects positions are
+	recorded via MarkObjectAsWritten, and streams lengths via WriteEncodedLength. GetCurrentPosition computes the
+	position that the content written so far will end at, without writing the queued content. it does have to wait
+	for queued compressions to complete to know their sizes, so use it sparingly.
+*/
+
+#include "EStatusCode.h"
+#include "IByteWriterWithPosition.h"
+#include "ObjectsBasicTypes.h"
+#include "OutputFlateEncodeStream.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+class IndirectObjectsReferenceRegistry;
+
+struct DeferredOutputSegment;
+typedef std::deque<DeferredOutputSegment*> DeferredOutputSegmentDeque;
+typedef std::map<unsigned long,IOBasicTypes::LongBufferSizeType> ULongToLongBufferSizeTypeMap;
+typedef std::vector<std::thread> ThreadVector;
+
+class OutputDeferredCompressionStream : public IByteWriterWithPosition
+{
+public:
+	OutputDeferredCompressionStream(void);
+	virtual ~OutputDeferredCompressionStream(void);
+
+	// not taking ownership of either target stream or registry. inWorkersCount of 0 means using the machine cores count.
+	// assigning discards any pending work, so Flush before that if it's required
+	void Assign(IByteWriterWithPosition* inTargetStream,IndirectObjectsReferenceRegistry* inObjectsRegistry,unsigned int inWorkersCount = 0);
+
+	// IByteWriter implementation
+	virtual IOBasicTypes::LongBufferSizeType Write(const IOBasicTypes::Byte* inBuffer,IOBasicTypes::LongBufferSizeType inSize);
+
+	// IByteWriterWithPosition implementation. the target stream position plus the size of the queued content. waits for
+	// queued encodings to complete, but doesn't write them
+	virtual IOBasicTypes::LongFilePositionType GetCurrentPosition();
+
+	// queue data for flate encoding on a worker thread. the data is taken from ioData (which is left empty).
+	// returns an encoding ID, to use with WriteEncodedLength
+	unsigned long QueueFlateEncoding(ByteVector& ioData,const FlateEncodingOptions& inOptions = FlateEncodingOptions::DefaultFlateEncodingOptions());
+
+	// write the length of the encoded data of a queued encoding, in decimal, once it's known
+	void WriteEncodedLength(unsigned long inEncodingID);
+
+	// mark the object as written at the current position in the registry, once it's known
+	void MarkObjectAsWritten(ObjectIDType inObjectID);
+
+	bool HasPendingWork();
+
+	// wait for all pending work and write it to the target stream
+	PDFHummus::EStatusCode Flush();
+
+private:
+	IByteWriterWithPosition* mTargetStream;
+	IndirectObjectsReferenceRegistry* mObjectsRegistry;
+	unsigned int mWorkersCount;
+	PDFHummus::EStatusCode mStatus;
+
+	// main thread state
+	DeferredOutputSegmentDeque mSegments;
+	ULongToLongBufferSizeTypeMap mEncodedLengths;
+	unsigned long mNextEncodingID;
+	size_t mQueuedEncodingsCount;
+	IOBasicTypes::LongBufferSizeType mQueuedLiteralsSize;
+
+	// shared with workers
+	std::mutex mLock;
+	std::condition_variable mEncodingsAvailable;
+	std::condition_variable mEncodingDone;
+	DeferredOutputSegmentDeque mPendingEncodings;
+	bool mStopWorkers;
+	ThreadVector mWorkers;
+
+	void StartWorkers();
+	void StopWorkers();
+	void WorkerLoop();
+	void WriteReadySegments(bool inWaitForFirstEncoding);
+	void WriteDecimal(IByteWriter* inStream,IOBasicTypes::LongBufferSizeType inValue);
+	IOBasicTypes::LongBufferSizeType GetDecimalLength(IOBasicTypes::LongBufferSizeType inValue);
+	void Reset();
+};
@@ -23,15 +23,18 @@
 #include "zlib.h"
 
 #define BUFFER_SIZE 256*1024
+// streams up to this size are deflated in a single call when done, rather than as written
+#define ONE_SHOT_MAX_SIZE (64*1024)
 
 using namespace IOBasicTypes;
 
 OutputFlateEncodeStream::OutputFlateEncodeStream(void)
 {
-	mBuffer = new IOBasicTypes::Byte[BUFFER_SIZE];
+	mBuffer = NULL;
 	mZLibState = new z_stream;
 	mTargetStream = NULL;
 	mCurrentlyEncoding = false;
+	mDeflateStarted = false;
 }
 
 OutputFlateEncodeStream::~OutputFlateEncodeStream(void)
@@ -46,6 +49,13 @@ OutputFlateEncodeStream::~OutputFlateEncodeStream(void)
 
 void OutputFlateEncodeStream::FinalizeEncoding()
 {
+	mCurrentlyEncoding = false;
+	if(!mDeflateStarted)
+	{
+		WriteOneShotEncoding();
+		return;
+	}
+
 	// flush leftovers by repeatedly calling with Z_FINISH parameter
 	int deflateResult;
 
@@ -75,30 +85,67 @@ void OutputFlateEncodeStream::FinalizeEncoding()
 		}
 	}while(Z_OK == deflateResult); // waiting for either an error, or Z_STREAM_END
 	deflateEnd(mZLibState);
-	mCurrentlyEncoding = false;
+	mDeflateStarted = false;
+}
+
+void OutputFlateEncodeStream::WriteOneShotEncoding()
+{
+	ByteVector encoded;
+	if(EncodeBuffer(mPendingInput.size() > 0 ? &mPendingInput[0] : NULL,mPendingInput.size(),encoded,mOptions) != PDFHummus::eSuccess)
+	{
+		TRACE_LOG("OutputFlateEncodeStream::WriteOneShotEncoding, failed to encode data");
+	}
+	else if(encoded.size() > 0)
+	{
+		LongBufferSizeType writtenBytes = mTargetStream->Write(&encoded[0],encoded.size());
+		if(writtenBytes != encoded.size())
+			TRACE_LOG2("OutputFlateEncodeStream::WriteOneShotEncoding, Failed to write the desired amount of zlib bytes to underlying stream. supposed to write %lld, wrote %lld",
+							encoded.size(),writtenBytes);
+	}
+	mPendingInput.clear();
 }
 
 OutputFlateEncodeStream::OutputFlateEncodeStream(IByteWriterWithPosition* inTargetWriter, bool inInitiallyOn)
 {
-	mBuffer = new IOBasicTypes::Byte[BUFFER_SIZE];
+	mBuffer = NULL;
 	mZLibState = new z_stream;
 	mTargetStream = NULL;
 	mCurrentlyEncoding = false;
+	mDeflateStarted = false;
 
 	Assign(inTargetWriter,inInitiallyOn);
 }
 
 void OutputFlateEncodeStream::StartEncoding()
+{
+	// the zlib stream is initialized only once there's enough input, till then input is just collected
+	mPendingInput.clear();
+	mDeflateStarted = false;
+	mCurrentlyEncoding = true;
+}
+
+bool OutputFlateEncodeStream::StartDeflate()
 {
 	mZLibState->zalloc = Z_NULL;
     mZLibState->zfree = Z_NULL;
     mZLibState->opaque = Z_NULL;
 
-    int deflateStatus = deflateInit(mZLibState, Z_DEFAULT_COMPRESSION);
+    int deflateStatus = deflateInit2(mZLibState,mOptions.Level,Z_DEFLATED,MAX_WBITS,mOptions.MemoryLevel,mOptions.Strategy);
     if (deflateStatus != Z_OK)
-		TRACE_LOG1("OutputFlateEncodeStream::StartEncoding, Unexpected failure in initializating flate library. status code = %d",deflateStatus);
-	else
-		mCurrentlyEncoding = true;
+	{
+		TRACE_LOG1("OutputFlateEncodeStream::StartDeflate, Unexpected failure in initializating flate library. status code = %d",deflateStatus);
+		return false;
+	}
+
+	if(!mBuffer)
+		mBuffer = new IOBasicTypes::Byte[BUFFER_SIZE];
+	mDeflateStarted = true;
+	return true;
+}
+
+void OutputFlateEncodeStream::SetEncodingOptions(const FlateEncodingOptions& inOptions)
+{
+	mOptions = inOptions;
 }
 
 
@@ -116,7 +163,32 @@ void OutputFlateEncodeStream::Assign(IByteWriterWithPosition* inWriter,bool inIn
 LongBufferSizeType OutputFlateEncodeStream::Write(const IOBasicTypes::Byte* inBuffer,LongBufferSizeType inSize)
 {
 	if(mCurrentlyEncoding)
+	{
+		if(mDeflateStarted)
+			return EncodeBufferAndWrite(inBuffer,inSize);
+
+		if(mPendingInput.size() + inSize <= ONE_SHOT_MAX_SIZE)
+		{
+			mPendingInput.insert(mPendingInput.end(),inBuffer,inBuffer + inSize);
+			return inSize;
+		}
+
+		// too big for one shot. start deflating, beginning with what was collected so far
+		if(!StartDeflate())
+		{
+			mCurrentlyEncoding = false;
+			return 0;
+		}
+		if(mPendingInput.size() > 0)
+		{
+			LongBufferSizeType pendingSize = mPendingInput.size();
+			LongBufferSizeType encodedSize = EncodeBufferAndWrite(&mPendingInput[0],pendingSize);
+			mPendingInput.clear();
+			if(encodedSize != pendingSize)
+				return 0;
+		}
 		return EncodeBufferAndWrite(inBuffer,inSize);
+	}
 	else if(mTargetStream)
 		return mTargetStream->Write(inBuffer,inSize);
 	else
@@ -151,6 +223,7 @@ LongBufferSizeType OutputFlateEncodeStream::EncodeBufferAndWrite(const IOBasicTy
 				deflateEnd(mZLibState);
 				deflateResult = Z_STREAM_ERROR;
 				mCurrentlyEncoding = false;
+				mDeflateStarted = false;
 				break;
 			}
 		}
@@ -181,3 +254,32 @@ void OutputFlateEncodeStream::TurnOffEncoding()
 	if(mCurrentlyEncoding)
 		FinalizeEncoding();
 }
+
+PDFHummus::EStatusCode OutputFlateEncodeStream::EncodeBuffer(const IOBasicTypes::Byte* inBuffer,
+															 IOBasicTypes::LongBufferSizeType inSize,
+															 ByteVector& outEncoded,
+															 const FlateEncodingOptions& inOptions)
+{
+	z_stream zlibState;
+	zlibState.zalloc = Z_NULL;
+	zlibState.zfree = Z_NULL;
+	zlibState.opaque = Z_NULL;
+
+	if(deflateInit2(&zlibState,inOptions.Level,Z_DEFLATED,MAX_WBITS,inOptions.MemoryLevel,inOptions.Strategy) != Z_OK)
+		return PDFHummus::eFailure;
+
+	// deflateBound provides enough room to complete in one go
+	LongBufferSizeType encodedStart = outEncoded.size();
+	outEncoded.resize(encodedStart + deflateBound(&zlibState,(uLong)inSize));
+
+	zlibState.avail_in = (uInt)inSize;
+	zlibState.next_in = (Bytef*)inBuffer;
+	zlibState.avail_out = (uInt)(outEncoded.size() - encodedStart);
+	zlibState.next_out = (Bytef*)&outEncoded[encodedStart];
+
+	int deflateResult = deflate(&zlibState,Z_FINISH);
+	outEncoded.resize(encodedStart + zlibState.total_out);
+	deflateEnd(&zlibState);
+
+	return Z_STREAM_END == deflateResult ? PDFHummus::eSuccess : PDFHummus::eFailure;
+}
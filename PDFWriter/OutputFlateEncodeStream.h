@@ -19,11 +19,17 @@
    
 */
 #pragma once
+#include "EStatusCode.h"
 #include "IByteWriterWithPosition.h"
+#include "FlateEncodingOptions.h"
+
+#include <vector>
 
 struct z_stream_s;
 typedef z_stream_s z_stream;
 
+typedef std::vector<IOBasicTypes::Byte> ByteVector;
+
 class OutputFlateEncodeStream : public IByteWriterWithPosition
 {
 public:
@@ -36,19 +42,37 @@ public:
 	// Assing makes OutputFlateEncodeStream the owner of inWriter, so if you don't want the class to delete it upon destructions - use Assign(NULL)
 	void Assign(IByteWriterWithPosition* inWriter,bool inInitiallyOn = true);
 
+	// compression parameters for the following encodings (on next Assign or TurnOnEncoding)
+	void SetEncodingOptions(const FlateEncodingOptions& inOptions);
+
 	virtual IOBasicTypes::LongBufferSizeType Write(const IOBasicTypes::Byte* inBuffer,IOBasicTypes::LongBufferSizeType inSize);
 	virtual IOBasicTypes::LongFilePositionType GetCurrentPosition();
 
 	void TurnOnEncoding();
 	void TurnOffEncoding();
 
+	// One-shot encoding, for when the whole data is already in memory. deflates the input in a single call
+	// and appends the encoded bytes to outEncoded. does not log, so it's safe to use from worker threads.
+	static PDFHummus::EStatusCode EncodeBuffer(const IOBasicTypes::Byte* inBuffer,
+												IOBasicTypes::LongBufferSizeType inSize,
+												ByteVector& outEncoded,
+												const FlateEncodingOptions& inOptions = FlateEncodingOptions::DefaultFlateEncodingOptions());
+
 private:
 	IOBasicTypes::Byte* mBuffer;
 	IByteWriterWithPosition* mTargetStream;
 	bool mCurrentlyEncoding;
 	z_stream* mZLibState;
+	FlateEncodingOptions mOptions;
+
+	// small streams are collected here, and deflated in one go when finalized. only when the input grows beyond
+	// the one shot limit, the zlib stream is initialized (mDeflateStarted) and the input is deflated as it comes
+	ByteVector mPendingInput;
+	bool mDeflateStarted;
 
 	void FinalizeEncoding();
 	void StartEncoding();
+	bool StartDeflate();
+	void WriteOneShotEncoding();
 	IOBasicTypes::LongBufferSizeType EncodeBufferAndWrite(const IOBasicTypes::Byte* inBuffer,IOBasicTypes::LongBufferSizeType inSize);
 };
@@ -0,0 +1,691 @@
+/*
+   Source File : PDFContentStreamReader.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "PDFContentStreamReader.h"
+#include "IByteReader.h"
+#include "Trace.h"
+
+#include <string.h>
+
+using namespace IOBasicTypes;
+
+#define CONTENT_STREAM_READ_BUFFER_SIZE (64*1024)
+// inline image data length comes from the content, so don't reserve more than this ahead. longer data still grows as it's read
+#define CONTENT_STREAM_INLINE_IMAGE_RESERVE_LIMIT (64*1024)
+
+struct OperatorNameAndCode
+{
+	const char* mName;
+	EContentStreamOperator mCode;
+};
+
+// sorted by name [byte order], for binary search
+static const OperatorNameAndCode scOperators[] =
+{
+	{"\"",eContentStreamOperatorNextLineSpacingShowText},
+	{"'",eContentStreamOperatorNextLineShowText},
+	{"B",eContentStreamOperatorFillStroke},
+	{"B*",eContentStreamOperatorFillStrokeEvenOdd},
+	{"BDC",eContentStreamOperatorBeginMarkedContentWithProperties},
+	{"BI",eContentStreamOperatorInlineImage},
+	{"BMC",eContentStreamOperatorBeginMarkedContent},
+	{"BT",eContentStreamOperatorBeginText},
+	{"BX",eContentStreamOperatorBeginCompatibility},
+	{"CS",eContentStreamOperatorSetStrokeColorSpace},
+	{"DP",eContentStreamOperatorMarkPointWithProperties},
+	{"Do",eContentStreamOperatorPaintXObject},
+	{"EMC",eContentStreamOperatorEndMarkedContent},
+	{"ET",eContentStreamOperatorEndText},
+	{"EX",eContentStreamOperatorEndCompatibility},
+	{"F",eContentStreamOperatorFillObsolete},
+	{"G",eContentStreamOperatorSetStrokeGray},
+	{"J",eContentStreamOperatorSetLineCap},
+	{"K",eContentStreamOperatorSetStrokeCMYK},
+	{"M",eContentStreamOperatorSetMiterLimit},
+	{"MP",eContentStreamOperatorMarkPoint},
+	{"Q",eContentStreamOperatorRestore},
+	{"RG",eContentStreamOperatorSetStrokeRGB},
+	{"S",eContentStreamOperatorStroke},
+	{"SC",eContentStreamOperatorSetStrokeColor},
+	{"SCN",eContentStreamOperatorSetStrokeColorN},
+	{"T*",eContentStreamOperatorNextLine},
+	{"TD",eContentStreamOperatorMoveTextSetLeading},
+	{"TJ",eContentStreamOperatorShowTextArray},
+	{"TL",eContentStreamOperatorSetLeading},
+	{"Tc",eContentStreamOperatorSetCharSpacing},
+	{"Td",eContentStreamOperatorMoveText},
+	{"Tf",eContentStreamOperatorSetFont},
+	{"Tj",eContentStreamOperatorShowText},
+	{"Tm",eContentStreamOperatorSetTextMatrix},
+	{"Tr",eContentStreamOperatorSetTextRenderingMode},
+	{"Ts",eContentStreamOperatorSetTextRise},
+	{"Tw",eContentStreamOperatorSetWordSpacing},
+	{"Tz",eContentStreamOperatorSetHorizontalScaling},
+	{"W",eContentStreamOperatorClip},
+	{"W*",eContentStreamOperatorClipEvenOdd},
+	{"b",eContentStreamOperatorCloseFillStroke},
+	{"b*",eContentStreamOperatorCloseFillStrokeEvenOdd},
+	{"c",eContentStreamOperatorCurveTo},
+	{"cm",eContentStreamOperatorConcatMatrix},
+	{"cs",eContentStreamOperatorSetFillColorSpace},
+	{"d",eContentStreamOperatorSetDash},
+	{"d0",eContentStreamOperatorSetCharWidth},
+	{"d1",eContentStreamOperatorSetCacheDevice},
+	{"f",eContentStreamOperatorFill},
+	{"f*",eContentStreamOperatorFillEvenOdd},
+	{"g",eContentStreamOperatorSetFillGray},
+	{"gs",eContentStreamOperatorSetGraphicsState},
+	{"h",eContentStreamOperatorClosePath},
+	{"i",eContentStreamOperatorSetFlatness},
+	{"j",eContentStreamOperatorSetLineJoin},
+	{"k",eContentStreamOperatorSetFillCMYK},
+	{"l",eContentStreamOperatorLineTo},
+	{"m",eContentStreamOperatorMoveTo},
+	{"n",eContentStreamOperatorEndPath},
+	{"q",eContentStreamOperatorSave},
+	{"re",eContentStreamOperatorRectangle},
+	{"rg",eContentStreamOperatorSetFillRGB},
+	{"ri",eContentStreamOperatorSetRenderingIntent},
+	{"s",eContentStreamOperatorCloseStroke},
+	{"sc",eContentStreamOperatorSetFillColor},
+	{"scn",eContentStreamOperatorSetFillColorN},
+	{"sh",eContentStreamOperatorShade},
+	{"v",eContentStreamOperatorCurveToV},
+	{"w",eContentStreamOperatorSetLineWidth},
+	{"y",eContentStreamOperatorCurveToY}
+};
+static const size_t scOperatorsCount = sizeof(scOperators)/sizeof(OperatorNameAndCode);
+
+static const std::string scTrue = "true";
+static const std::string scFalse = "false";
+static const std::string scNull = "null";
+static const std::string scID = "ID";
+static const std::string scEI = "EI";
+// largest number operand that's taken as a length [2^53, where doubles still hold every integer]. also rules out nan and infinity
+static const double scMaxLengthOperand = 9007199254740992.0;
+
+PDFContentStreamReader::PDFContentStreamReader(void)
+{
+	mStream = NULL;
+	mOwnsStream = false;
+	mBuffer = new Byte[CONTENT_STREAM_READ_BUFFER_SIZE];
+	mBufferPosition = 0;
+	mBufferEnd = 0;
+	mOperator = eContentStreamOperatorUnknown;
+	mOperandsCount = 0;
+	mOperandsOverflowed = false;
+}
+
+PDFContentStreamReader::~PDFContentStreamReader(void)
+{
+	if(mOwnsStream)
+		delete mStream;
+	delete[] mBuffer;
+}
+
+void PDFContentStreamReader::SetReadStream(IByteReader* inSourceStream,bool inOwnsStream)
+{
+	if(mOwnsStream)
+		delete mStream;
+	mStream = inSourceStream;
+	mOwnsStream = inOwnsStream;
+	mBufferPosition = 0;
+	mBufferEnd = 0;
+}
+
+bool PDFContentStreamReader::FillBuffer()
+{
+	if(!mStream || !mStream->NotEnded())
+		return false;
+
+	mBufferPosition = 0;
+	mBufferEnd = mStream->Read(mBuffer,CONTENT_STREAM_READ_BUFFER_SIZE);
+	return mBufferEnd > 0;
+}
+
+bool PDFContentStreamReader::GetByte(Byte& outByte)
+{
+	if(mBufferPosition == mBufferEnd && !FillBuffer())
+		return false;
+	outByte = mBuffer[mBufferPosition++];
+	return true;
+}
+
+bool PDFContentStreamReader::PeekByte(Byte& outByte)
+{
+	if(mBufferPosition == mBufferEnd && !FillBuffer())
+		return false;
+	outByte = mBuffer[mBufferPosition];
+	return true;
+}
+
+bool PDFContentStreamReader::IsWhiteSpace(Byte inByte)
+{
+	return inByte == 0x20 || inByte == 0xA || inByte == 0xD || inByte == 0x9 || inByte == 0xC || inByte == 0;
+}
+
+bool PDFContentStreamReader::IsDelimiter(Byte inByte)
+{
+	return inByte == '(' || inByte == ')' || inByte == '<' || inByte == '>' || inByte == '[' || inByte == ']' ||
+			inByte == '{' || inByte == '}' || inByte == '/' || inByte == '%';
+}
+
+bool PDFContentStreamReader::SkipWhiteSpacesAndComments()
+{
+	Byte aByte;
+
+	while(PeekByte(aByte))
+	{
+		if(IsWhiteSpace(aByte))
+		{
+			++mBufferPosition;
+		}
+		else if(aByte == '%')
+		{
+			while(GetByte(aByte) && aByte != 0xA && aByte != 0xD);
+		}
+		else
+			return true;
+	}
+	return false;
+}
+
+bool PDFContentStreamReader::ReadNextOperation()
+{
+	mOperator = eContentStreamOperatorUnknown;
+	mOperatorName.clear();
+	mOperandsCount = 0;
+	mOperandsOverflowed = false;
+	mText.clear();
+	mInlineImageData.clear();
+
+	if(!ReadOperandsTillOperator())
+		return false;
+
+	SetOperator(mToken);
+	if(eContentStreamOperatorInlineImage == mOperator)
+		ReadInlineImage();
+	return true;
+}
+
+bool PDFContentStreamReader::ReadOperandsTillOperator()
+{
+	Byte aByte;
+
+	while(SkipWhiteSpacesAndComments())
+	{
+		GetByte(aByte);
+		switch(aByte)
+		{
+			case '/':
+				ReadName();
+				break;
+			case '(':
+				ReadLiteralString();
+				break;
+			case '<':
+				if(PeekByte(aByte) && aByte == '<')
+				{
+					++mBufferPosition;
+					PushOperand(eContentStreamOperandDictionaryStart);
+				}
+				else
+					ReadHexString();
+				break;
+			case '>':
+				if(PeekByte(aByte) && aByte == '>')
+				{
+					++mBufferPosition;
+					PushOperand(eContentStreamOperandDictionaryEnd);
+				}
+				break;
+			case '[':
+				PushOperand(eContentStreamOperandArrayStart);
+				break;
+			case ']':
+				PushOperand(eContentStreamOperandArrayEnd);
+				break;
+			case ')':
+			case '{':
+			case '}':
+				// not expected in content streams, skip
+				break;
+			default:
+			{
+				ReadRegularToken(aByte);
+				if((mToken[0] >= '0' && mToken[0] <= '9') || mToken[0] == '-' || mToken[0] == '+' || mToken[0] == '.')
+				{
+					ReadNumber(mToken);
+				}
+				else if(mToken == scTrue || mToken == scFalse)
+				{
+					ContentStreamOperand* operand = PushOperand(eContentStreamOperandBoolean);
+					if(operand)
+						operand->mNumber = (mToken == scTrue) ? 1 : 0;
+				}
+				else if(mToken == scNull)
+				{
+					PushOperand(eContentStreamOperandNull);
+				}
+				else
+				{
+					// operator
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+ContentStreamOperand* PDFContentStreamReader::PushOperand(EContentStreamOperandType inType)
+{
+	if(mOperandsCount == CONTENT_STREAM_OPERANDS_STACK_SIZE)
+	{
+		if(!mOperandsOverflowed)
+			TRACE_LOG1("PDFContentStreamReader::PushOperand, more than %d operands for an operator. dropping extra operands",CONTENT_STREAM_OPERANDS_STACK_SIZE);
+		mOperandsOverflowed = true;
+		return NULL;
+	}
+
+	ContentStreamOperand* operand = mOperands + mOperandsCount++;
+	operand->mType = inType;
+	operand->mNumber = 0;
+	operand->mIsInteger = false;
+	operand->mTextStart = 0;
+	operand->mTextLength = 0;
+	return operand;
+}
+
+static int HexDigitValue(Byte inByte)
+{
+	if(inByte >= '0' && inByte <= '9')
+		return inByte - '0';
+	if(inByte >= 'A' && inByte <= 'F')
+		return inByte - 'A' + 10;
+	if(inByte >= 'a' && inByte <= 'f')
+		return inByte - 'a' + 10;
+	return -1;
+}
+
+void PDFContentStreamReader::ReadName()
+{
+	size_t textStart = mText.size();
+	Byte aByte;
+
+	while(PeekByte(aByte) && !IsWhiteSpace(aByte) && !IsDelimiter(aByte))
+	{
+		++mBufferPosition;
+		if(aByte == '#')
+		{
+			// #xx hex escape
+			Byte high,low;
+			if(PeekByte(high) && HexDigitValue(high) >= 0)
+			{
+				++mBufferPosition;
+				if(PeekByte(low) && HexDigitValue(low) >= 0)
+				{
+					++mBufferPosition;
+					mText.push_back((char)(HexDigitValue(high)*16 + HexDigitValue(low)));
+				}
+				else
+				{
+					mText.push_back('#');
+					mText.push_back((char)high);
+				}
+				continue;
+			}
+		}
+		mText.push_back((char)aByte);
+	}
+
+	ContentStreamOperand* operand = PushOperand(eContentStreamOperandName);
+	if(operand)
+	{
+		operand->mTextStart = textStart;
+		operand->mTextLength = mText.size() - textStart;
+	}
+	else
+		mText.resize(textStart);
+}
+
+void PDFContentStreamReader::ReadLiteralString()
+{
+	size_t textStart = mText.size();
+	int depth = 1;
+	Byte aByte;
+
+	while(GetByte(aByte))
+	{
+		if(aByte == '\\')
+		{
+			if(!GetByte(aByte))
+				break;
+			switch(aByte)
+			{
+				case 'n': mText.push_back('\n'); break;
+				case 'r': mText.push_back('\r'); break;
+				case 't': mText.push_back('\t'); break;
+				case 'b': mText.push_back('\b'); break;
+				case 'f': mText.push_back('\f'); break;
+				case 0xD:
+					// line continuation
+					if(PeekByte(aByte) && aByte == 0xA)
+						++mBufferPosition;
+					break;
+				case 0xA:
+					break;
+				default:
+					if(aByte >= '0' && aByte <= '7')
+					{
+						// up to 3 octal digits
+						int value = aByte - '0';
+						for(int i=0;i<2 && PeekByte(aByte) && aByte >= '0' && aByte <= '7';++i)
+						{
+							++mBufferPosition;
+							value = value*8 + (aByte - '0');
+						}
+						mText.push_back((char)(value & 0xFF));
+					}
+					else
+					{
+						// escaped parentheses and backslash, and ignored backslashes
+						mText.push_back((char)aByte);
+					}
+			}
+		}
+		else if(aByte == '(')
+		{
+			++depth;
+			mText.push_back('(');
+		}
+		else if(aByte == ')')
+		{
+			if(--depth == 0)
+				break;
+			mText.push_back(')');
+		}
+		else if(aByte == 0xD)
+		{
+			// end of line markers are read as a line feed
+			if(PeekByte(aByte) && aByte == 0xA)
+				++mBufferPosition;
+			mText.push_back('\n');
+		}
+		else
+			mText.push_back((char)aByte);
+	}
+
+	ContentStreamOperand* operand = PushOperand(eContentStreamOperandLiteralString);
+	if(operand)
+	{
+		operand->mTextStart = textStart;
+		operand->mTextLength = mText.size() - textStart;
+	}
+	else
+		mText.resize(textStart);
+}
+
+void PDFContentStreamReader::ReadHexString()
+{
+	size_t textStart = mText.size();
+	int high = -1;
+	Byte aByte;
+
+	while(GetByte(aByte) && aByte != '>')
+	{
+		int value = HexDigitValue(aByte);
+		if(value < 0)
+			continue; // white spaces [and garbage]
+		if(high < 0)
+		{
+			high = value;
+		}
+		else
+		{
+			mText.push_back((char)(high*16 + value));
+			high = -1;
+		}
+	}
+	// odd number of digits, last one is as if followed by 0
+	if(high >= 0)
+		mText.push_back((char)(high*16));
+
+	ContentStreamOperand* operand = PushOperand(eContentStreamOperandHexString);
+	if(operand)
+	{
+		operand->mTextStart = textStart;
+		operand->mTextLength = mText.size() - textStart;
+	}
+	else
+		mText.resize(textStart);
+}
+
+void PDFContentStreamReader::ReadRegularToken(Byte inFirstByte)
+{
+	mToken.assign(1,(char)inFirstByte);
+
+	for(;;)
+	{
+		if(mBufferPosition == mBufferEnd && !FillBuffer())
+			break;
+
+		// take as much of the token as is available in the buffer in one go
+		LongBufferSizeType tokenEnd = mBufferPosition;
+		while(tokenEnd < mBufferEnd && !IsWhiteSpace(mBuffer[tokenEnd]) && !IsDelimiter(mBuffer[tokenEnd]))
+			++tokenEnd;
+		mToken.append((const char*)(mBuffer + mBufferPosition),(size_t)(tokenEnd - mBufferPosition));
+		mBufferPosition = tokenEnd;
+		if(tokenEnd < mBufferEnd)
+			break;
+	}
+}
+
+void PDFContentStreamReader::ReadNumber(const std::string& inToken)
+{
+	ContentStreamOperand* operand = PushOperand(eContentStreamOperandNumber);
+	if(!operand)
+		return;
+
+	// parsing here, and not with strtod, so the decimal point does not depend on the locale
+	std::string::const_iterator it = inToken.begin();
+	bool negative = false;
+	double value = 0;
+	bool isInteger = true;
+
+	// some writers double the sign. take the last one
+	while(it != inToken.end() && (*it == '-' || *it == '+'))
+	{
+		negative = (*it == '-');
+		++it;
+	}
+	for(; it != inToken.end() && *it >= '0' && *it <= '9'; ++it)
+		value = value*10 + (*it - '0');
+	if(it != inToken.end() && *it == '.')
+	{
+		isInteger = false;
+		double scale = 0.1;
+		for(++it; it != inToken.end() && *it >= '0' && *it <= '9'; ++it)
+		{
+			value += (*it - '0')*scale;
+			scale /= 10;
+		}
+	}
+
+	operand->mNumber = negative ? -value : value;
+	operand->mIsInteger = isInteger;
+}
+
+void PDFContentStreamReader::SetOperator(const std::string& inName)
+{
+	mOperatorName = inName;
+	mOperator = eContentStreamOperatorUnknown;
+
+	size_t low = 0;
+	size_t high = scOperatorsCount;
+	while(low < high)
+	{
+		size_t middle = (low + high) / 2;
+		int comparison = strcmp(scOperators[middle].mName,inName.c_str());
+		if(comparison == 0)
+		{
+			mOperator = scOperators[middle].mCode;
+			break;
+		}
+		else if(comparison < 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+}
+
+void PDFContentStreamReader::ReadInlineImage()
+{
+	// the image dictionary entries, up to ID, are the operation operands
+	while(ReadOperandsTillOperator())
+	{
+		if(mToken == scID)
+		{
+			// a single white space separates ID from the data
+			Byte aByte;
+			if(PeekByte(aByte) && IsWhiteSpace(aByte))
+				++mBufferPosition;
+			ReadInlineImageData();
+			return;
+		}
+		TRACE_LOG1("PDFContentStreamReader::ReadInlineImage, unexpected operator in inline image dictionary - %s",mToken.substr(0,MAX_TRACE_SIZE - 200).c_str());
+	}
+	TRACE_LOG("PDFContentStreamReader::ReadInlineImage, stream ended before inline image data");
+}
+
+void PDFContentStreamReader::ReadInlineImageData()
+{
+	Byte aByte;
+	LongBufferSizeType length;
+
+	// PDF 2.0 allows specifying the data length. when it's there, take it
+	if(FindOperandNumber("L","Length",length))
+	{
+		mInlineImageData.reserve((size_t)(length < CONTENT_STREAM_INLINE_IMAGE_RESERVE_LIMIT ? length : CONTENT_STREAM_INLINE_IMAGE_RESERVE_LIMIT));
+		for(LongBufferSizeType i=0;i<length && GetByte(aByte);++i)
+			mInlineImageData.push_back(aByte);
+		if(SkipWhiteSpacesAndComments() && GetByte(aByte))
+		{
+			ReadRegularToken(aByte);
+			if(mToken == scEI)
+				return;
+		}
+		TRACE_LOG("PDFContentStreamReader::ReadInlineImageData, inline image data of specified length not followed by EI");
+		return;
+	}
+
+	// otherwise, data ends with a white space and EI, that's followed by a white space, a delimiter or the stream end
+	while(GetByte(aByte))
+	{
+		mInlineImageData.push_back(aByte);
+		size_t size = mInlineImageData.size();
+		if(size >= 2 && mInlineImageData[size-1] == 'I' && mInlineImageData[size-2] == 'E' &&
+			(size == 2 || IsWhiteSpace(mInlineImageData[size-3])))
+		{
+			Byte nextByte;
+			if(!PeekByte(nextByte) || IsWhiteSpace(nextByte) || IsDelimiter(nextByte))
+			{
+				mInlineImageData.resize(size == 2 ? 0 : size - 3);
+				return;
+			}
+		}
+	}
+	TRACE_LOG("PDFContentStreamReader::ReadInlineImageData, stream ended before inline image end");
+}
+
+bool PDFContentStreamReader::FindOperandNumber(const std::string& inKey,const std::string& inAlternativeKey,LongBufferSizeType& outValue)
+{
+	int depth = 0;
+
+	for(size_t i=0;i<mOperandsCount;++i)
+	{
+		const ContentStreamOperand& operand = mOperands[i];
+		if(operand.mType == eContentStreamOperandArrayStart || operand.mType == eContentStreamOperandDictionaryStart)
+		{
+			++depth;
+		}
+		else if(operand.mType == eContentStreamOperandArrayEnd || operand.mType == eContentStreamOperandDictionaryEnd)
+		{
+			--depth;
+		}
+		else if(0 == depth && operand.mType == eContentStreamOperandName && i + 1 < mOperandsCount &&
+				mOperands[i+1].mType == eContentStreamOperandNumber && mOperands[i+1].mNumber >= 0 && mOperands[i+1].mNumber < scMaxLengthOperand)
+		{
+			std::string key = mText.substr(operand.mTextStart,operand.mTextLength);
+			if(key == inKey || key == inAlternativeKey)
+			{
+				outValue = (LongBufferSizeType)mOperands[i+1].mNumber;
+				return true;
+			}
+			++i; // skip the value
+		}
+	}
+	return false;
+}
+
+EContentStreamOperator PDFContentStreamReader::GetOperator() const
+{
+	return mOperator;
+}
+
+const std::string& PDFContentStreamReader::GetOperatorName() const
+{
+	return mOperatorName;
+}
+
+size_t PDFContentStreamReader::GetOperandsCount() const
+{
+	return mOperandsCount;
+}
+
+const ContentStreamOperand& PDFContentStreamReader::GetOperand(size_t inIndex) const
+{
+	return mOperands[inIndex];
+}
+
+std::string PDFContentStreamReader::GetOperandText(size_t inIndex) const
+{
+	return mText.substr(mOperands[inIndex].mTextStart,mOperands[inIndex].mTextLength);
+}
+
+const char* PDFContentStreamReader::GetOperandTextBytes(size_t inIndex) const
+{
+	return mText.c_str() + mOperands[inIndex].mTextStart;
+}
+
+bool PDFContentStreamReader::OperandsOverflowed() const
+{
+	return mOperandsOverflowed;
+}
+
+const Byte* PDFContentStreamReader::GetInlineImageData() const
+{
+	return mInlineImageData.empty() ? NULL : &(mInlineImageData[0]);
+}
+
+LongBufferSizeType PDFContentStreamReader::GetInlineImageDataLength() const
+{
+	return mInlineImageData.size();
+}
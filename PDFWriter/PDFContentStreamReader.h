@@ -0,0 +1,216 @@
+/*
+   Source File : PDFContentStreamReader.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "IOBasicTypes.h"
+
+#include <string>
+#include <vector>
+
+class IByteReader;
+
+/*
+	Streaming content stream reader. Reads a content stream operation by operation - an operator code and its operands -
+	without creating PDF objects. Operands are kept in a fixed size stack that's reused for all operations, and names and
+	strings are decoded to a text buffer that's reused as well, so reading a stream makes practically no allocations.
+	Useful where only the operators and their operands are needed [text extraction, resources names rewriting] and
+	PDFObjectParser is too heavy.
+	Arrays and dictionaries operands [TJ arrays, marked content properties] are flattened to the stack, between
+	start and end markers operands.
+	Inline images are read as a single eContentStreamOperatorInlineImage operation [named BI], where the operands are
+	the image dictionary entries [keys and values] and the image data is available through GetInlineImageData.
+	Use with PDFParser::StartReadingContentFromStream(s), or with any content stream through SetReadStream.
+*/
+
+enum EContentStreamOperator
+{
+	eContentStreamOperatorUnknown, // not a content stream operator [see GetOperatorName]
+	eContentStreamOperatorCloseFillStroke, // b
+	eContentStreamOperatorFillStroke, // B
+	eContentStreamOperatorCloseFillStrokeEvenOdd, // b*
+	eContentStreamOperatorFillStrokeEvenOdd, // B*
+	eContentStreamOperatorBeginMarkedContentWithProperties, // BDC
+	eContentStreamOperatorInlineImage, // BI, through ID and EI
+	eContentStreamOperatorBeginMarkedContent, // BMC
+	eContentStreamOperatorBeginText, // BT
+	eContentStreamOperatorBeginCompatibility, // BX
+	eContentStreamOperatorCurveTo, // c
+	eContentStreamOperatorConcatMatrix, // cm
+	eContentStreamOperatorSetStrokeColorSpace, // CS
+	eContentStreamOperatorSetFillColorSpace, // cs
+	eContentStreamOperatorSetDash, // d
+	eContentStreamOperatorSetCharWidth, // d0
+	eContentStreamOperatorSetCacheDevice, // d1
+	eContentStreamOperatorPaintXObject, // Do
+	eContentStreamOperatorMarkPointWithProperties, // DP
+	eContentStreamOperatorEndMarkedContent, // EMC
+	eContentStreamOperatorEndText, // ET
+	eContentStreamOperatorEndCompatibility, // EX
+	eContentStreamOperatorFill, // f
+	eContentStreamOperatorFillObsolete, // F
+	eContentStreamOperatorFillEvenOdd, // f*
+	eContentStreamOperatorSetStrokeGray, // G
+	eContentStreamOperatorSetFillGray, // g
+	eContentStreamOperatorSetGraphicsState, // gs
+	eContentStreamOperatorClosePath, // h
+	eContentStreamOperatorSetFlatness, // i
+	eContentStreamOperatorSetLineJoin, // j
+	eContentStreamOperatorSetLineCap, // J
+	eContentStreamOperatorSetStrokeCMYK, // K
+	eContentStreamOperatorSetFillCMYK, // k
+	eContentStreamOperatorLineTo, // l
+	eContentStreamOperatorMoveTo, // m
+	eContentStreamOperatorSetMiterLimit, // M
+	eContentStreamOperatorMarkPoint, // MP
+	eContentStreamOperatorEndPath, // n
+	eContentStreamOperatorSave, // q
+	eContentStreamOperatorRestore, // Q
+	eContentStreamOperatorRectangle, // re
+	eContentStreamOperatorSetStrokeRGB, // RG
+	eContentStreamOperatorSetFillRGB, // rg
+	eContentStreamOperatorSetRenderingIntent, // ri
+	eContentStreamOperatorCloseStroke, // s
+	eContentStreamOperatorStroke, // S
+	eContentStreamOperatorSetStrokeColor, // SC
+	eContentStreamOperatorSetFillColor, // sc
+	eContentStreamOperatorSetStrokeColorN, // SCN
+	eContentStreamOperatorSetFillColorN, // scn
+	eContentStreamOperatorShade, // sh
+	eContentStreamOperatorNextLine, // T*
+	eContentStreamOperatorSetCharSpacing, // Tc
+	eContentStreamOperatorMoveText, // Td
+	eContentStreamOperatorMoveTextSetLeading, // TD
+	eContentStreamOperatorSetFont, // Tf
+	eContentStreamOperatorShowText, // Tj
+	eContentStreamOperatorShowTextArray, // TJ
+	eContentStreamOperatorSetLeading, // TL
+	eContentStreamOperatorSetTextMatrix, // Tm
+	eContentStreamOperatorSetTextRenderingMode, // Tr
+	eContentStreamOperatorSetTextRise, // Ts
+	eContentStreamOperatorSetWordSpacing, // Tw
+	eContentStreamOperatorSetHorizontalScaling, // Tz
+	eContentStreamOperatorCurveToV, // v
+	eContentStreamOperatorSetLineWidth, // w
+	eContentStreamOperatorClip, // W
+	eContentStreamOperatorClipEvenOdd, // W*
+	eContentStreamOperatorCurveToY, // y
+	eContentStreamOperatorNextLineShowText, // '
+	eContentStreamOperatorNextLineSpacingShowText // "
+};
+
+enum EContentStreamOperandType
+{
+	eContentStreamOperandNumber,
+	eContentStreamOperandBoolean,
+	eContentStreamOperandNull,
+	eContentStreamOperandName,
+	eContentStreamOperandLiteralString,
+	eContentStreamOperandHexString,
+	eContentStreamOperandArrayStart,
+	eContentStreamOperandArrayEnd,
+	eContentStreamOperandDictionaryStart,
+	eContentStreamOperandDictionaryEnd
+};
+
+struct ContentStreamOperand
+{
+	EContentStreamOperandType mType;
+	// value of numbers, and of booleans [0 or 1]
+	double mNumber;
+	// numbers without a decimal point
+	bool mIsInteger;
+	// names [without the slash] and strings decoded values, in the operation text. see PDFContentStreamReader::GetOperandText
+	size_t mTextStart;
+	size_t mTextLength;
+};
+
+// operands beyond this count are dropped [see PDFContentStreamReader::OperandsOverflowed]
+#define CONTENT_STREAM_OPERANDS_STACK_SIZE 1024
+
+class PDFContentStreamReader
+{
+public:
+	PDFContentStreamReader(void);
+	~PDFContentStreamReader(void);
+
+	// assign the stream to read from. with inOwnsStream the reader deletes the stream when done with it
+	void SetReadStream(IByteReader* inSourceStream,bool inOwnsStream = false);
+
+	// read the next operation. returns false when there are no more operations [operands at the end of the stream
+	// with no operator after them are ignored]
+	bool ReadNextOperation();
+
+	// the operation that was just read
+	EContentStreamOperator GetOperator() const;
+	const std::string& GetOperatorName() const;
+	size_t GetOperandsCount() const;
+	const ContentStreamOperand& GetOperand(size_t inIndex) const;
+	// decoded value of a name or string operand. GetOperandText allocates a string, GetOperandTextBytes doesn't [length is in the operand]
+	std::string GetOperandText(size_t inIndex) const;
+	const char* GetOperandTextBytes(size_t inIndex) const;
+	// true if the operation had more operands than the stack holds. extra operands are dropped
+	bool OperandsOverflowed() const;
+	// image data of an inline image operation
+	const IOBasicTypes::Byte* GetInlineImageData() const;
+	IOBasicTypes::LongBufferSizeType GetInlineImageDataLength() const;
+
+private:
+	IByteReader* mStream;
+	bool mOwnsStream;
+
+	// read buffer
+	IOBasicTypes::Byte* mBuffer;
+	IOBasicTypes::LongBufferSizeType mBufferPosition;
+	IOBasicTypes::LongBufferSizeType mBufferEnd;
+
+	// recent operation
+	EContentStreamOperator mOperator;
+	std::string mOperatorName;
+	ContentStreamOperand mOperands[CONTENT_STREAM_OPERANDS_STACK_SIZE];
+	size_t mOperandsCount;
+	bool mOperandsOverflowed;
+	std::string mText;
+	std::vector<IOBasicTypes::Byte> mInlineImageData;
+
+	// token being read
+	std::string mToken;
+
+	bool FillBuffer();
+	bool GetByte(IOBasicTypes::Byte& outByte);
+	bool PeekByte(IOBasicTypes::Byte& outByte);
+	bool SkipWhiteSpacesAndComments();
+
+	// reads operands to the stack till an operator, which is left in mToken. returns false if the stream ended before that
+	bool ReadOperandsTillOperator();
+	ContentStreamOperand* PushOperand(EContentStreamOperandType inType);
+	void ReadName();
+	void ReadLiteralString();
+	void ReadHexString();
+	void ReadRegularToken(IOBasicTypes::Byte inFirstByte);
+	void ReadNumber(const std::string& inToken);
+	void ReadInlineImage();
+	void ReadInlineImageData();
+	bool FindOperandNumber(const std::string& inKey,const std::string& inAlternativeKey,IOBasicTypes::LongBufferSizeType& outValue);
+	void SetOperator(const std::string& inName);
+
+	bool IsWhiteSpace(IOBasicTypes::Byte inByte);
+	bool IsDelimiter(IOBasicTypes::Byte inByte);
+};
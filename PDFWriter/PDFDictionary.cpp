@@ -35,10 +35,16 @@ PDFDictionary::~PDFDictionary(void)
 	}
 }
 
-PDFObject* PDFDictionary::QueryDirectObject(std::string inName)
+PDFObject* PDFDictionary::QueryDirectObject(const std::string& inName)
 {
-	PDFName key(inName);
-	PDFNameToPDFObjectMap::iterator it = mValues.find(&key);
+	PDFNameAtom key = PDFNameAtoms::Find(inName);
+
+	return key ? QueryDirectObject(key) : NULL;
+}
+
+PDFObject* PDFDictionary::QueryDirectObject(PDFNameAtom inName)
+{
+	PDFNameToPDFObjectMap::iterator it = mValues.find(inName);
 
 	if(it == mValues.end())
 	{
@@ -53,20 +59,82 @@ PDFObject* PDFDictionary::QueryDirectObject(std::string inName)
 
 void PDFDictionary::Insert(PDFName* inKeyObject, PDFObject* inValueObject)
 {
-	inKeyObject->AddRef();
-	inValueObject->AddRef();
-
-	mValues.insert(PDFNameToPDFObjectMap::value_type(inKeyObject,inValueObject));
+	if(mValues.insert(PDFNameToPDFObjectMap::value_type(inKeyObject,inValueObject)))
+	{
+		inKeyObject->AddRef();
+		inValueObject->AddRef();
+	}
 }
 
 
-bool PDFDictionary::Exists(std::string inName)
+bool PDFDictionary::Exists(const std::string& inName)
+{
+	PDFNameAtom key = PDFNameAtoms::Find(inName);
+
+	return key && Exists(key);
+}
+
+bool PDFDictionary::Exists(PDFNameAtom inName)
 {
-	PDFName key(inName);
-	return mValues.find(&key) != mValues.end();
+	return mValues.find(inName) != mValues.end();
 }
 
 MapIterator<PDFNameToPDFObjectMap> PDFDictionary::GetIterator()
 {
 	return MapIterator<PDFNameToPDFObjectMap>(mValues);
-}
\ No newline at end of file
+}
+
+// up to this many entries, scanning and comparing atoms is faster than binary searching and comparing strings
+#define DICTIONARY_SCAN_ENTRIES_LIMIT 16
+
+PDFNameToPDFObjectMap::iterator PDFNameToPDFObjectMap::find(PDFNameAtom inKey)
+{
+	if(mEntries.size() <= DICTIONARY_SCAN_ENTRIES_LIMIT)
+	{
+		iterator it = mEntries.begin();
+		for(; it != mEntries.end(); ++it)
+			if(it->first->GetAtom() == inKey)
+				return it;
+		return mEntries.end();
+	}
+	else
+	{
+		iterator it = LowerBound(*inKey);
+		return (it != mEntries.end() && it->first->GetAtom() == inKey) ? it : mEntries.end();
+	}
+}
+
+bool PDFNameToPDFObjectMap::insert(const value_type& inEntry)
+{
+	iterator it = LowerBound(inEntry.first->GetValue());
+	if(it != mEntries.end() && it->first->GetAtom() == inEntry.first->GetAtom())
+		return false;
+
+	mEntries.insert(it,inEntry);
+	return true;
+}
+
+PDFNameToPDFObjectMap::iterator PDFNameToPDFObjectMap::LowerBound(const std::string& inKeyValue)
+{
+	// entries are mostly inserted in order [parsed dictionaries are usually written sorted], so check the end first
+	if(mEntries.empty() || mEntries.back().first->GetValue() < inKeyValue)
+		return mEntries.end();
+
+	iterator low = mEntries.begin();
+	size_t count = mEntries.size();
+	while(count > 0)
+	{
+		size_t step = count / 2;
+		iterator middle = low + step;
+		if(middle->first->GetValue() < inKeyValue)
+		{
+			low = middle + 1;
+			count -= step + 1;
+		}
+		else
+		{
+			count = step;
+		}
+	}
+	return low;
+}
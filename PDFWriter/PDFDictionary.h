@@ -24,7 +24,8 @@
 #include "MapIterator.h"
 
 #include <map>
-
+#include <utility>
+#include <vector>
 
 
 struct PDFNameLess
@@ -36,7 +37,36 @@ struct PDFNameLess
 	}
 };
 
-typedef std::map<PDFName*,PDFObject*,PDFNameLess> PDFNameToPDFObjectMap;
+/*
+	Dictionary entries. A flat map - a vector of entries ordered by key value, as the std::map that it replaces [so iterating
+	dictionaries keeps the same order]. Finding an entry is by the key atom [see PDFNameAtoms]: small dictionaries, which are
+	most of them, are scanned comparing atoms, larger ones are binary searched.
+*/
+class PDFNameToPDFObjectMap
+{
+public:
+	typedef PDFName* key_type;
+	typedef PDFObject* mapped_type;
+	typedef std::pair<PDFName*,PDFObject*> value_type;
+	typedef std::vector<value_type>::iterator iterator;
+	typedef std::vector<value_type>::const_iterator const_iterator;
+
+	iterator begin() {return mEntries.begin();}
+	iterator end() {return mEntries.end();}
+	const_iterator begin() const {return mEntries.begin();}
+	const_iterator end() const {return mEntries.end();}
+	size_t size() const {return mEntries.size();}
+	bool empty() const {return mEntries.empty();}
+
+	iterator find(PDFNameAtom inKey);
+	// inserts the entry if there's no entry with the same key yet. returns whether inserted
+	bool insert(const value_type& inEntry);
+
+private:
+	std::vector<value_type> mEntries;
+
+	iterator LowerBound(const std::string& inKeyValue);
+};
 
 class PDFDictionary : public PDFObject
 {
@@ -50,11 +80,15 @@ public:
 	PDFDictionary(void);
 	virtual ~PDFDictionary(void);
 
-	// AddRefs on both
+	// AddRefs on both. ignored if the dictionary already has inKeyObject key
 	void Insert(PDFName* inKeyObject, PDFObject* inValueObject);
 
-    bool Exists(std::string inName);
-	PDFObject* QueryDirectObject(std::string inName);
+    bool Exists(const std::string& inName);
+	PDFObject* QueryDirectObject(const std::string& inName);
+
+	// lookups with interned keys. prefer for keys that are looked up often [intern them once]
+	bool Exists(PDFNameAtom inName);
+	PDFObject* QueryDirectObject(PDFNameAtom inName);
 
 	MapIterator<PDFNameToPDFObjectMap> GetIterator();
 
@@ -49,6 +49,7 @@
 #include "PDFPageInput.h"
 #include "IndirectObjectsReferenceRegistry.h"
 #include "SimpleStringTokenizer.h"
+#include "ParseSession.h"
 
 using namespace PDFHummus;
 
@@ -59,6 +60,7 @@ PDFDocumentHandler::PDFDocumentHandler(void)
 	mWrittenPage = NULL;
     mParser = NULL;
     mParserOwned = false;
+	mUseParseSessions = false;
 
 }
 
@@ -271,6 +273,7 @@ PDFFormXObject* PDFDocumentHandler::CreatePDFFormXObjectForPage(unsigned long in
 																const double* inTransformationMatrix,
 																ObjectIDType inPredefinedFormId)
 {
+	ParseSession pageSession(mUseParseSessions);
 	RefCountPtr<PDFDictionary> pageObject = mParser->ParsePage(inPageIndex);
 
 	if(!pageObject)
@@ -394,6 +397,7 @@ PDFFormXObject* PDFDocumentHandler::CreatePDFFormXObjectForPage(unsigned long in
 																const double* inTransformationMatrix,
 																ObjectIDType inPredefinedFormId)
 {
+	ParseSession pageSession(mUseParseSessions);
 	RefCountPtr<PDFDictionary> pageObject = mParser->ParsePage(inPageIndex);
 
 	if(!pageObject)
@@ -496,13 +500,13 @@ EStatusCode PDFDocumentHandler::CopyResourcesIndirectObjects(PDFDictionary* inPa
 
 EStatusCode PDFDocumentHandler::WriteNewObjects(const ObjectIDTypeList& inSourceObjectIDs)
 {
-	ObjectIDTypeSet writtenObjects;
+	ObjectIDTypeBitmap writtenObjects(mParser->GetXrefSize());
 	// note that any objects in inSourceObjectIDs are trusted for not having been copied yet!
 	return WriteNewObjects(inSourceObjectIDs,writtenObjects);
 }
 
 
-EStatusCode PDFDocumentHandler::WriteNewObjects(const ObjectIDTypeList& inSourceObjectIDs,ObjectIDTypeSet& ioCopiedObjects)
+EStatusCode PDFDocumentHandler::WriteNewObjects(const ObjectIDTypeList& inSourceObjectIDs,ObjectIDTypeBitmap& ioCopiedObjects)
 {
 
 	ObjectIDTypeList::const_iterator itNewObjects = inSourceObjectIDs.begin();
@@ -512,7 +516,7 @@ EStatusCode PDFDocumentHandler::WriteNewObjects(const ObjectIDTypeList& inSource
 	{
 		// theoretically speaking, it could be that while one object was copied, another one in this array is already
 		// copied, so make sure to check that these objects are still required for copying
-		if(ioCopiedObjects.find(*itNewObjects) == ioCopiedObjects.end())
+		if(ioCopiedObjects.Insert(*itNewObjects))
 		{
 			ObjectIDTypeToObjectIDTypeMap::iterator it = mSourceToTarget.find(*itNewObjects);
 			if(it == mSourceToTarget.end())
@@ -520,7 +524,6 @@ EStatusCode PDFDocumentHandler::WriteNewObjects(const ObjectIDTypeList& inSource
 				ObjectIDType newObjectID = mObjectsContext->GetInDirectObjectsRegistry().AllocateNewObjectID();
 				it = mSourceToTarget.insert(ObjectIDTypeToObjectIDTypeMap::value_type(*itNewObjects,newObjectID)).first;
 			}
-			ioCopiedObjects.insert(*itNewObjects);
 			status = CopyInDirectObject(*itNewObjects,it->second,ioCopiedObjects);
 		}
 	}
@@ -576,12 +579,12 @@ void PDFDocumentHandler::RegisterInDirectObjects(PDFArray* inArray,ObjectIDTypeL
 
 EStatusCode PDFDocumentHandler::CopyInDirectObject(ObjectIDType inSourceObjectID,ObjectIDType inTargetObjectID)
 {
-	ObjectIDTypeSet ioCopiedObjects;
+	ObjectIDTypeBitmap ioCopiedObjects(mParser->GetXrefSize());
 	return CopyInDirectObject(inSourceObjectID,inTargetObjectID,ioCopiedObjects);
 }
 
 
-EStatusCode PDFDocumentHandler::CopyInDirectObject(ObjectIDType inSourceObjectID,ObjectIDType inTargetObjectID,ObjectIDTypeSet& ioCopiedObjects)
+EStatusCode PDFDocumentHandler::CopyInDirectObject(ObjectIDType inSourceObjectID,ObjectIDType inTargetObjectID,ObjectIDTypeBitmap& ioCopiedObjects)
 {
 	// CopyInDirectObject will do this (lissen up)
 	// Start a new object with the input ID
@@ -595,8 +598,7 @@ EStatusCode PDFDocumentHandler::CopyInDirectObject(ObjectIDType inSourceObjectID
 	RefCountPtr<PDFObject> sourceObject = mParser->ParseNewObject(inSourceObjectID);
 	if(!sourceObject)
 	{
-		XrefEntryInput* xrefEntry = mParser->GetXrefEntry(inSourceObjectID);
-		if (xrefEntry->mType == eXrefEntryDelete) {
+		if (mParser->GetXrefEntry(inSourceObjectID).mType == eXrefEntryDelete) {
 			// if the object is deleted, replace with a deleted object
 			mObjectsContext->GetInDirectObjectsRegistry().DeleteObject(inTargetObjectID);
 			return PDFHummus::eSuccess;
@@ -757,6 +759,7 @@ EStatusCodeAndObjectIDTypeList PDFDocumentHandler::AppendPDFPagesFromPDFInContex
 
 EStatusCodeAndObjectIDType PDFDocumentHandler::CreatePDFPageForPage(unsigned long inPageIndex)
 {
+	ParseSession pageSession(mUseParseSessions);
 	RefCountPtr<PDFDictionary> pageObject = mParser->ParsePage(inPageIndex);
 	EStatusCodeAndObjectIDType result;
 	result.first = PDFHummus::eFailure;
@@ -961,7 +964,7 @@ EStatusCode PDFDocumentHandler::WritePDFStreamInputToContentContext(PageContentC
 
 EStatusCode PDFDocumentHandler::StartFileCopyingContext(const std::string& inPDFFilePath, const PDFParsingOptions& inOptions)
 {
-	if(mPDFFile.OpenFile(inPDFFilePath) != PDFHummus::eSuccess)
+	if(mPDFFile.OpenFile(inPDFFilePath,inOptions.MemoryMapInputFile) != PDFHummus::eSuccess)
 	{
 		TRACE_LOG1("PDFDocumentHandler::StartFileCopyingContext, unable to open file for reading in %s",inPDFFilePath.c_str());
 		return PDFHummus::eFailure;
@@ -981,6 +984,8 @@ EStatusCode PDFDocumentHandler::StartCopyingContext(PDFParser* inPDFParser)
         mParserOwned = false;
         mParser = inPDFParser;
 		mPDFStream = inPDFParser->GetParserStream();
+		// source IDs are mostly bounded by the xref size, so keep IDs in that range in dense storage
+		mSourceToTarget.SetDenseRange(mParser->GetXrefSize());
         
 		if(mParser->IsEncrypted() && !mParser->IsEncryptionSupported())
 		{
@@ -1004,6 +1009,7 @@ EStatusCode PDFDocumentHandler::StartCopyingContext(IByteReaderWithPosition* inP
             mParser = new PDFParser();
 		mPDFStream = inPDFStream;
         mParserOwned = true;
+		mUseParseSessions = inOptions.UseParseSessions;
 
 		status = mParser->StartPDFParsing(inPDFStream, inOptions);
 		if(status != PDFHummus::eSuccess)
@@ -1019,6 +1025,8 @@ EStatusCode PDFDocumentHandler::StartCopyingContext(IByteReaderWithPosition* inP
 			break;
 		}
 
+		mSourceToTarget.SetDenseRange(mParser->GetXrefSize());
+
 	}while(false);
 
 	return status;
@@ -1177,6 +1185,7 @@ void PDFDocumentHandler::StopCopyingContext()
         mParser = NULL;
         mParserOwned = false;
     }
+	mUseParseSessions = false;
 
 }
 
@@ -1284,6 +1293,7 @@ EStatusCode PDFDocumentHandler::MergePDFPagesToPageInContext(PDFPage* inPage,
 
 EStatusCode PDFDocumentHandler::MergePDFPageForPage(PDFPage* inTargetPage,unsigned long inSourcePageIndex)
 {
+	ParseSession pageSession(mUseParseSessions);
 	RefCountPtr<PDFDictionary> pageObject = mParser->ParsePage(inSourcePageIndex);
 	EStatusCode status  = PDFHummus::eSuccess;
 
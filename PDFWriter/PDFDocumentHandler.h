@@ -29,6 +29,7 @@
 #include "DocumentContextExtenderAdapter.h"
 #include "MapIterator.h"
 #include "PDFParsingOptions.h"
+#include "ObjectIDTypeToObjectIDTypeMap.h"
 
 #include <map>
 #include <list>
@@ -56,7 +57,6 @@ namespace PDFHummus
 }
 
 using namespace PDFHummus;
-typedef std::map<ObjectIDType,ObjectIDType> ObjectIDTypeToObjectIDTypeMap;
 typedef std::map<std::string,std::string> StringToStringMap;
 typedef std::set<ObjectIDType> ObjectIDTypeSet;
 typedef std::set<IDocumentContextExtender*> IDocumentContextExtenderSet;
@@ -238,6 +238,8 @@ private:
 	IByteReaderWithPosition* mPDFStream;
 	PDFParser* mParser;
     bool mParserOwned;
+	// parse the objects of each copied page in a parse session [PDFParsingOptions::UseParseSessions]
+	bool mUseParseSessions;
 	ObjectIDTypeToObjectIDTypeMap mSourceToTarget;
 	PDFDictionary* mWrittenPage;
 	
@@ -249,8 +251,8 @@ private:
 	void RegisterInDirectObjects(PDFDictionary* inDictionary,ObjectIDTypeList& outNewObjects);
 	void RegisterInDirectObjects(PDFArray* inArray,ObjectIDTypeList& outNewObjects);
 	PDFHummus::EStatusCode WriteNewObjects(const ObjectIDTypeList& inSourceObjectIDs);
-	PDFHummus::EStatusCode WriteNewObjects(const ObjectIDTypeList& inSourceObjectIDs,ObjectIDTypeSet& ioCopiedObjects);
-	PDFHummus::EStatusCode CopyInDirectObject(ObjectIDType inSourceObjectID,ObjectIDType inTargetObjectID,ObjectIDTypeSet& ioCopiedObjects);
+	PDFHummus::EStatusCode WriteNewObjects(const ObjectIDTypeList& inSourceObjectIDs,ObjectIDTypeBitmap& ioCopiedObjects);
+	PDFHummus::EStatusCode CopyInDirectObject(ObjectIDType inSourceObjectID,ObjectIDType inTargetObjectID,ObjectIDTypeBitmap& ioCopiedObjects);
 	EStatusCodeAndObjectIDTypeList CreateFormXObjectsFromPDF(const std::string& inPDFFilePath,
 															const PDFParsingOptions& inParsingOptions,
 															const PDFPageRange& inPageRange,
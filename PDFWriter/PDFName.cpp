@@ -22,19 +22,25 @@
 
 PDFName::PDFName(const std::string& inValue) : PDFObject(eType)
 {
-	mValue = inValue;
+	mAtom = PDFNameAtoms::Acquire(inValue);
 }
 
 PDFName::~PDFName(void)
 {
+	PDFNameAtoms::Release(mAtom);
 }
 
 const std::string& PDFName::GetValue() const
 {
-	return mValue;
+	return *mAtom;
 }
 
 PDFName::operator std::string() const
 {
-	return mValue;
+	return *mAtom;
+}
+
+PDFNameAtom PDFName::GetAtom() const
+{
+	return mAtom;
 }
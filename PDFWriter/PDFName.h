@@ -20,6 +20,7 @@
 */
 #pragma once
 #include "PDFObject.h"
+#include "PDFNameAtoms.h"
 
 #include <string>
 
@@ -41,7 +42,14 @@ public:
 	const std::string& GetValue() const;
 	operator std::string() const;
 
+	// interned value. names with equal values have the same atom
+	PDFNameAtom GetAtom() const;
+
 private:
 
-	std::string mValue;
+	PDFNameAtom mAtom;
+
+	// names hold a reference to their atom, so they're not copied
+	PDFName(const PDFName&);
+	PDFName& operator=(const PDFName&);
 };
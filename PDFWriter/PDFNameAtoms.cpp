@@ -0,0 +1,149 @@
+/*
+   Source File : PDFNameAtoms.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "PDFNameAtoms.h"
+
+#include <mutex>
+#include <unordered_map>
+
+// the table is split to shards by value hash, each with its own lock, so threads parsing at the same time rarely wait on each other
+#define PDF_NAME_ATOMS_SHARDS_COUNT 16
+
+// a kept value. the atom is the address of the value, so entries derive from the string
+struct AtomEntry : public std::string
+{
+	AtomEntry(const std::string& inValue,size_t inHash) : std::string(inValue) {mHash = inHash; mReferences = 0; mIsPermanent = false;}
+
+	size_t mHash;
+	// guarded by the shard lock
+	unsigned long mReferences;
+	bool mIsPermanent;
+};
+
+typedef std::unordered_multimap<size_t,AtomEntry*> SizeTToAtomEntryMultimap;
+
+struct AtomsShard
+{
+	std::mutex mLock;
+	// entries by value hash. the hash is kept with the entry, so releasing doesn't hash again
+	SizeTToAtomEntryMultimap mEntries;
+};
+
+static AtomsShard* GetShards()
+{
+	// never deleted, so atoms are valid also while static objects are destroyed
+	static AtomsShard* shards = new AtomsShard[PDF_NAME_ATOMS_SHARDS_COUNT];
+	return shards;
+}
+
+static AtomsShard& GetShardFor(size_t inHash)
+{
+	return GetShards()[inHash % PDF_NAME_ATOMS_SHARDS_COUNT];
+}
+
+// call with the shard locked
+static AtomEntry* FindEntry(AtomsShard& inShard,const std::string& inValue,size_t inHash)
+{
+	std::pair<SizeTToAtomEntryMultimap::iterator,SizeTToAtomEntryMultimap::iterator> range = inShard.mEntries.equal_range(inHash);
+	for(SizeTToAtomEntryMultimap::iterator it = range.first; it != range.second; ++it)
+		if(*(it->second) == inValue)
+			return it->second;
+	return NULL;
+}
+
+// call with the shard locked
+static AtomEntry* FindOrAddEntry(AtomsShard& inShard,const std::string& inValue,size_t inHash)
+{
+	AtomEntry* entry = FindEntry(inShard,inValue,inHash);
+	if(!entry)
+	{
+		entry = new AtomEntry(inValue,inHash);
+		inShard.mEntries.insert(SizeTToAtomEntryMultimap::value_type(inHash,entry));
+	}
+	return entry;
+}
+
+PDFNameAtom PDFNameAtoms::Intern(const std::string& inValue)
+{
+	size_t hash = std::hash<std::string>()(inValue);
+	AtomsShard& shard = GetShardFor(hash);
+	std::lock_guard<std::mutex> lock(shard.mLock);
+
+	AtomEntry* entry = FindOrAddEntry(shard,inValue,hash);
+	entry->mIsPermanent = true;
+	return entry;
+}
+
+PDFNameAtom PDFNameAtoms::Acquire(const std::string& inValue)
+{
+	size_t hash = std::hash<std::string>()(inValue);
+	AtomsShard& shard = GetShardFor(hash);
+	std::lock_guard<std::mutex> lock(shard.mLock);
+
+	AtomEntry* entry = FindOrAddEntry(shard,inValue,hash);
+	++entry->mReferences;
+	return entry;
+}
+
+void PDFNameAtoms::Release(PDFNameAtom inAtom)
+{
+	if(!inAtom)
+		return;
+
+	AtomEntry* entry = (AtomEntry*)static_cast<const AtomEntry*>(inAtom);
+	AtomsShard& shard = GetShardFor(entry->mHash);
+	std::lock_guard<std::mutex> lock(shard.mLock);
+
+	if(--entry->mReferences > 0 || entry->mIsPermanent)
+		return;
+
+	std::pair<SizeTToAtomEntryMultimap::iterator,SizeTToAtomEntryMultimap::iterator> range = shard.mEntries.equal_range(entry->mHash);
+	for(SizeTToAtomEntryMultimap::iterator it = range.first; it != range.second; ++it)
+	{
+		if(it->second == entry)
+		{
+			shard.mEntries.erase(it);
+			break;
+		}
+	}
+	delete entry;
+}
+
+PDFNameAtom PDFNameAtoms::Find(const std::string& inValue)
+{
+	size_t hash = std::hash<std::string>()(inValue);
+	AtomsShard& shard = GetShardFor(hash);
+	std::lock_guard<std::mutex> lock(shard.mLock);
+
+	return FindEntry(shard,inValue,hash);
+}
+
+unsigned long PDFNameAtoms::GetAtomsCount()
+{
+	unsigned long result = 0;
+	AtomsShard* shards = GetShards();
+
+	for(int i=0;i<PDF_NAME_ATOMS_SHARDS_COUNT;++i)
+	{
+		std::lock_guard<std::mutex> lock(shards[i].mLock);
+		result += (unsigned long)shards[i].mEntries.size();
+	}
+	return result;
+}
@@ -0,0 +1,54 @@
+/*
+   Source File : PDFNameAtoms.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include <string>
+
+/*
+	Interned PDF names. Each distinct name value is kept once, in a global table, and an atom identifies it - the address of
+	the kept value. Two names are equal if and only if their atoms are equal, so comparing names is comparing pointers, and
+	PDFName objects share the kept value instead of holding a copy of it.
+	The table is safe to use from multiple threads. Values are reference counted - PDFName objects Acquire the atom of their
+	value and Release it when destroyed, and a value is dropped from the table once no name holds it. So names parsed from
+	files stay in the table only while they're in use.
+	Interned values are permanent. For keys that are looked up often, intern once [say, in a file level static] and use the
+	atom overloads of PDFDictionary and PDFParser queries.
+*/
+
+typedef const std::string* PDFNameAtom;
+
+class PDFNameAtoms
+{
+public:
+
+	// returns the atom of inValue, adding it to the table if it's not there yet. the value is kept for the whole run
+	static PDFNameAtom Intern(const std::string& inValue);
+
+	// returns the atom of inValue, adding it to the table if it's not there yet, with a reference that's dropped with Release.
+	// the atom remains valid till then
+	static PDFNameAtom Acquire(const std::string& inValue);
+	static void Release(PDFNameAtom inAtom);
+
+	// returns the atom of inValue, or NULL if it was never interned [in which case no name has this value]
+	static PDFNameAtom Find(const std::string& inValue);
+
+	static unsigned long GetAtomsCount();
+};
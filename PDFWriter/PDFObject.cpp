@@ -19,6 +19,7 @@
    
 */
 #include "PDFObject.h"
+#include "ParseSession.h"
 
 const char* PDFObject::scPDFObjectTypeLabel(int index) 
 {
@@ -97,3 +98,13 @@ void PDFObject::DeleteMetadata(const std::string& inKey) {
 	void* result = DetachMetadata(inKey);
 	delete result;
 }
+
+void* PDFObject::operator new(size_t inSize)
+{
+	return ParseSession::AllocateObject(inSize);
+}
+
+void PDFObject::operator delete(void* inMemory)
+{
+	ParseSession::FreeObject(inMemory);
+}
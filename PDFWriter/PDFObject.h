@@ -24,6 +24,7 @@
 
 #include <string>
 #include <map>
+#include <stddef.h>
 
 typedef std::map<std::string, void*> StringToVoidP;
 
@@ -64,6 +65,10 @@ public:
 	void* DetachMetadata(const std::string& inKey);
 	void DeleteMetadata(const std::string& inKey);
 
+	// objects are allocated from the active parse session on the creating thread, if any [see ParseSession]
+	static void* operator new(size_t inSize);
+	static void operator delete(void* inMemory);
+
 
 private:
 	EPDFObjectType mType;
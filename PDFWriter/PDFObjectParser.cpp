@@ -36,6 +36,7 @@
 #include "BoxingBase.h"
 #include "PDFStream.h"
 #include "IByteReader.h"
+#include "IByteReaderWithPosition.h"
 #include "RefCountPtr.h"
 #include "PDFObjectCast.h"
 #include "IPDFParserExtender.h"
@@ -74,6 +75,21 @@ void PDFObjectParser::SetReadStream(IByteReader* inSourceStream,
 	ResetReadState();
 }
 
+void PDFObjectParser::SetReadStream(IByteReaderWithPosition* inSourceStream,
+									IReadPositionProvider* inCurrentPositionProvider,
+									bool inOwnsStream)
+{
+	if(mOwnsStream) {
+		delete mStream;
+	}
+
+	mStream = inSourceStream;
+	mOwnsStream = inOwnsStream;
+	mTokenizer.SetReadStream(inSourceStream);
+	mCurrentPositionProvider = inCurrentPositionProvider;
+	ResetReadState();
+}
+
 void PDFObjectParser::ResetReadState()
 {
 	mTokenBuffer.clear();
@@ -238,7 +254,7 @@ bool PDFObjectParser::GetNextToken(std::string& outToken)
 {
 	if(mTokenBuffer.size() > 0)
 	{
-		outToken = mTokenBuffer.front();
+		outToken.swap(mTokenBuffer.front());
 		mTokenBuffer.pop_front();
 		return true;
 	}
@@ -252,7 +268,7 @@ bool PDFObjectParser::GetNextToken(std::string& outToken)
 			tokenizerResult = mTokenizer.GetNextToken();
 			if(tokenizerResult.first && !IsComment(tokenizerResult.second))
 			{
-				outToken = tokenizerResult.second;
+				outToken.swap(tokenizerResult.second);
 				break;
 			}
 		}while(tokenizerResult.first);
@@ -552,13 +568,30 @@ bool PDFObjectParser::IsNumber(const std::string& inToken)
 
 typedef BoxingBaseWithRW<long long> LongLong;
 
+// long long holds any 18 digits integer, so up to that the direct parsing can't overflow
+#define MAX_DIRECT_PARSE_DIGITS 18
+
 PDFObject* PDFObjectParser::ParseNumber(const std::string& inToken)
 {
 	// once we know this is a number, then parsing is easy. just determine if it's a real or integer, so as to separate classes for better accuracy
 	if(inToken.find(scDot) != inToken.npos)
 		return new PDFReal(Double(inToken));
-	else
+
+	// integers are the most common tokens [object numbers, references, lengths], so parse them directly rather than with a string stream.
+	// IsNumber already verified the format, leaving just the sign and digits
+	std::string::const_iterator it = inToken.begin();
+	bool isNegative = (scMinus == *it);
+	if(scMinus == *it || scPlus == *it)
+		++it;
+
+	// longer integers, found in damaged files, are left to the stream parsing, which handles overflow
+	if(inToken.end() - it > MAX_DIRECT_PARSE_DIGITS)
 		return new PDFInteger(LongLong(inToken));
+
+	long long value = 0;
+	for(; it != inToken.end(); ++it)
+		value = value*10 + (*it - scZero);
+	return new PDFInteger(isNegative ? -value : value);
 }
 
 static const std::string scLeftSquare = "[";
@@ -31,6 +31,7 @@
 
 class PDFObject;
 class IByteReader;
+class IByteReaderWithPosition;
 class IPDFParserExtender;
 class DecryptionHelper;
 
@@ -48,6 +49,8 @@ public:
 	
 	// Assign the stream to read from (does not take ownership of the stream, unless told so)
 	void SetReadStream(IByteReader* inSourceStream,IReadPositionProvider* inCurrentPositionProvider,bool inOwnsStream=false);
+	// same, for streams with position. tokenizing can then scan directly on the stream content, if available
+	void SetReadStream(IByteReaderWithPosition* inSourceStream,IReadPositionProvider* inCurrentPositionProvider,bool inOwnsStream=false);
 
 	PDFObject* ParseNewObject();
 
@@ -26,6 +26,17 @@
 #include "PDFName.h"
 #include "ParsedPrimitiveHelper.h"
 
+// page keys, interned once as boxes are queried for every copied page
+static const PDFNameAtom scTypeKey = PDFNameAtoms::Intern("Type");
+static const PDFNameAtom scPageName = PDFNameAtoms::Intern("Page");
+static const PDFNameAtom scRotateKey = PDFNameAtoms::Intern("Rotate");
+static const PDFNameAtom scMediaBoxKey = PDFNameAtoms::Intern("MediaBox");
+static const PDFNameAtom scCropBoxKey = PDFNameAtoms::Intern("CropBox");
+static const PDFNameAtom scTrimBoxKey = PDFNameAtoms::Intern("TrimBox");
+static const PDFNameAtom scBleedBoxKey = PDFNameAtoms::Intern("BleedBox");
+static const PDFNameAtom scArtBoxKey = PDFNameAtoms::Intern("ArtBox");
+static const PDFNameAtom scParentKey = PDFNameAtoms::Intern("Parent");
+
 PDFPageInput::PDFPageInput(PDFParser* inParser,PDFObject* inPageObject):mPageObject(inPageObject)
 {
     mParser = inParser;
@@ -37,8 +48,8 @@ void PDFPageInput::AssertPageObjectValid()
     if(!mPageObject)
         TRACE_LOG("PDFPageInput::AssertPageObjectValid, null page object or not a dictionary");
     
-    PDFObjectCastPtr<PDFName> typeObject = mPageObject->QueryDirectObject("Type");
-    if(!typeObject || typeObject->GetValue() != "Page")
+    PDFObjectCastPtr<PDFName> typeObject = mPageObject->QueryDirectObject(scTypeKey);
+    if(!typeObject || typeObject->GetAtom() != scPageName)
     {
         TRACE_LOG("PDFPageInput::AssertPageObjectValid, dictionar object provided is NOT a page object");
         mPageObject = NULL;
@@ -78,7 +89,7 @@ bool PDFPageInput::operator!()
 int PDFPageInput::GetRotate()
 {
 	int result = 0;
-    RefCountPtr<PDFObject> rotation(QueryInheritedValue(mPageObject.GetPtr(),"Rotate"));
+    RefCountPtr<PDFObject> rotation(QueryInheritedValue(mPageObject.GetPtr(),scRotateKey));
 	if (!rotation)
 		return result;
 
@@ -103,7 +114,7 @@ PDFRectangle PDFPageInput::GetMediaBox()
 {
     PDFRectangle result;
     
-    PDFObjectCastPtr<PDFArray> mediaBox(QueryInheritedValue(mPageObject.GetPtr(),"MediaBox"));
+    PDFObjectCastPtr<PDFArray> mediaBox(QueryInheritedValue(mPageObject.GetPtr(),scMediaBoxKey));
     if(!mediaBox || mediaBox->GetLength() != 4)
     {
         TRACE_LOG("PDFPageInput::GetMediaBox, Exception, pdf page does not have correct media box. defaulting to A4");
@@ -120,7 +131,7 @@ PDFRectangle PDFPageInput::GetMediaBox()
 PDFRectangle PDFPageInput::GetCropBox()
 {
     PDFRectangle result;
-    PDFObjectCastPtr<PDFArray> cropBox(QueryInheritedValue(mPageObject.GetPtr(),"CropBox"));
+    PDFObjectCastPtr<PDFArray> cropBox(QueryInheritedValue(mPageObject.GetPtr(),scCropBoxKey));
     
     if(!cropBox || cropBox->GetLength() != 4)
         result = GetMediaBox();
@@ -131,10 +142,10 @@ PDFRectangle PDFPageInput::GetCropBox()
 
 PDFRectangle PDFPageInput::GetTrimBox()
 {
-    return GetBoxAndDefaultWithCrop("TrimBox");
+    return GetBoxAndDefaultWithCrop(scTrimBoxKey);
 }
 
-PDFRectangle PDFPageInput::GetBoxAndDefaultWithCrop(const std::string& inBoxName)
+PDFRectangle PDFPageInput::GetBoxAndDefaultWithCrop(PDFNameAtom inBoxName)
 {
     PDFRectangle result;
     PDFObjectCastPtr<PDFArray> aBox(QueryInheritedValue(mPageObject.GetPtr(),inBoxName));
@@ -148,25 +159,24 @@ PDFRectangle PDFPageInput::GetBoxAndDefaultWithCrop(const std::string& inBoxName
 
 PDFRectangle PDFPageInput::GetBleedBox()
 {
-    return GetBoxAndDefaultWithCrop("BleedBox");
+    return GetBoxAndDefaultWithCrop(scBleedBoxKey);
 }
 
 PDFRectangle PDFPageInput::GetArtBox()
 {
-    return GetBoxAndDefaultWithCrop("ArtBox");
+    return GetBoxAndDefaultWithCrop(scArtBoxKey);
 }
 
 
-static const std::string scParent = "Parent";
-PDFObject* PDFPageInput::QueryInheritedValue(PDFDictionary* inDictionary,const std::string& inName)
+PDFObject* PDFPageInput::QueryInheritedValue(PDFDictionary* inDictionary,PDFNameAtom inName)
 {
 	if(inDictionary->Exists(inName))
 	{
 		return mParser->QueryDictionaryObject(inDictionary,inName);
 	}
-	else if(inDictionary->Exists(scParent))
+	else if(inDictionary->Exists(scParentKey))
 	{
-		PDFObjectCastPtr<PDFDictionary> parent(mParser->QueryDictionaryObject(inDictionary,scParent));
+		PDFObjectCastPtr<PDFDictionary> parent(mParser->QueryDictionaryObject(inDictionary,scParentKey));
 		if(!parent)
 			return NULL;
 		return QueryInheritedValue(parent.GetPtr(),inName);
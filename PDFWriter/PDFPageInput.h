@@ -69,11 +69,11 @@ private:
     PDFParser* mParser;
     PDFObjectCastPtr<PDFDictionary> mPageObject;
     
-	PDFObject* QueryInheritedValue(PDFDictionary* inDictionary,const std::string& inName);
+	PDFObject* QueryInheritedValue(PDFDictionary* inDictionary,PDFNameAtom inName);
     void SetPDFRectangleFromPDFArray(PDFArray* inPDFArray,PDFRectangle& outPDFRectangle);
     
     void AssertPageObjectValid();
-    PDFRectangle GetBoxAndDefaultWithCrop(const std::string& inBoxName);
+    PDFRectangle GetBoxAndDefaultWithCrop(PDFNameAtom inBoxName);
 
 
 };
@@ -31,11 +31,15 @@
 #include "PDFIndirectObjectReference.h"
 #include "PDFName.h"
 #include "PDFArray.h"
+#include "PDFLiteralString.h"
+#include "PDFHexString.h"
 #include "RefCountPtr.h"
 #include "PDFObjectCast.h"
 #include "PDFStreamInput.h"
 #include "InputLimitedStream.h"
+#include "InputByteArrayStream.h"
 #include "InputFlateDecodeStream.h"
+#include "InputFlateDecodeSeekableStream.h"
 #include "InputStreamSkipperStream.h"
 #include "InputPredictorPNGOptimumStream.h"
 #include "InputPredictorTIFFSubStream.h"
@@ -44,16 +48,29 @@
 #include "IPDFParserExtender.h"
 #include "InputDCTDecodeStream.h"
 #include "ArrayOfInputStreamsStream.h"
+#include "PDFContentStreamReader.h"
+#include "XrefReconstructionScanner.h"
+#include "ParseSession.h"
 
 #include  <algorithm>
+#include <set>
+#include <sstream>
 using namespace PDFHummus;
 
 PDFParser::PDFParser(void)
 {
 	mStream = NULL;
 	mTrailer = NULL;
-	mXrefTable = NULL;
 	mPagesObjectIDs = NULL;
+	mLazyPagesIndexing = false;
+	mPagesRootObjectID = 0;
+	mXrefReconstructed = false;
+	mTrailerPosition = 0;
+	mTrailerIsXrefStream = false;
+	mParseIndexCache = NULL;
+	mCursorStream = NULL;
+	mFlateCheckpointsInterval = 0;
+	mXrefTable.reset(new ParsedXrefTable());
 	mParserExtender = NULL;
     mAllowExtendingSegments = true; // Gal 19.9.2013: here's some policy changer. basically i'm supposed to ignore all segments that declare objects past the trailer
                                     // declared size. but i would like to allow files that do extend. as this is incompatible with the specs, i'll make
@@ -68,22 +85,49 @@ PDFParser::~PDFParser(void)
 
 void PDFParser::ResetParser()
 {
+	// object streams headers that were read while parsing, go to the parse index
+	if(mParseIndexCache && !mParseIndexKey.empty() && !mNewObjectStreamsHeaders.empty())
+		mParseIndexCache->AddObjectStreamsHeaders(mParseIndexKey,mNewObjectStreamsHeaders);
+	mNewObjectStreamsHeaders.clear();
+	mParseIndexCache = NULL;
+	mParseIndexKey.clear();
+	mTrailerPosition = 0;
+	mTrailerIsXrefStream = false;
+
 	mTrailer = NULL;
-	delete[] mXrefTable;
-	mXrefTable = NULL;
+	mXrefTable.reset(new ParsedXrefTable());
 	delete[] mPagesObjectIDs;
 	mPagesObjectIDs = NULL;
+	mPagesRootObjectID = 0;
+	mPageTreeNodes.clear();
+	mXrefReconstructed = false;
+	mReconstructedObjectStreams.clear();
 	mStream = NULL;
 	mCurrentPositionProvider.Assign(NULL);
+	delete mCursorStream;
+	mCursorStream = NULL;
+	mPassword.clear();
 
 	ObjectIDTypeToObjectStreamHeaderEntryMap::iterator it = mObjectStreamsCache.begin();
 	for(; it != mObjectStreamsCache.end();++it)
 		delete[] it->second;
 	mObjectStreamsCache.clear();
+	mDecodedObjectStreams.Reset();
+	ResetFlateDecodeIndexes();
+	mParsedObjects.Reset();
 	mDecryptionHelper.Reset();
 
 }
 
+void PDFParser::ResetFlateDecodeIndexes()
+{
+	ObjectIDTypeToFlateDecodeIndexMap::iterator it = mFlateDecodeIndexes.begin();
+	for(; it != mFlateDecodeIndexes.end();++it)
+		delete it->second;
+	mFlateDecodeIndexes.clear();
+	mOversizedObjectStreams.clear();
+}
+
 EStatusCode PDFParser::StartPDFParsing(IByteReaderWithPosition* inSourceStream, const PDFParsingOptions& inOptions)
 {
 	EStatusCode status;
@@ -93,6 +137,10 @@ EStatusCode PDFParser::StartPDFParsing(IByteReaderWithPosition* inSourceStream,
 	mStream = inSourceStream;
 	mCurrentPositionProvider.Assign(mStream);
 	mObjectParser.SetReadStream(inSourceStream,&mCurrentPositionProvider);
+	mDecodedObjectStreams.SetBudget(inOptions.DecodedObjectStreamsCacheBudget);
+	mFlateCheckpointsInterval = inOptions.FlateCheckpointsInterval;
+	mLazyPagesIndexing = inOptions.LazyPagesIndexing;
+	mPassword = inOptions.Password;
 
 	do
 	{
@@ -100,48 +148,568 @@ EStatusCode PDFParser::StartPDFParsing(IByteReaderWithPosition* inSourceStream,
 		if(status != PDFHummus::eSuccess)
 			break;
 
+		// with a parse index for this file, skip right to setting up the document structure
+		bool loadedParseIndex = false;
+		if(inOptions.SharedParseIndexCache)
+		{
+			mParseIndexCache = inOptions.SharedParseIndexCache;
+			mParseIndexKey = ComputeParseIndexKey();
+			loadedParseIndex = LoadParseIndex();
+		}
+
 		// initialize reading from end
 		mLastReadPositionFromEnd = 0;
 		mEncounteredFileStart = false;
-		mLastAvailableIndex = mCurrentBufferIndex = mLinesBuffer;
+		mCurrentBufferStart = mLastAvailableIndex = mCurrentBufferIndex = mLinesBuffer;
 
-		status = ParseEOFLine();
-		if(status != PDFHummus::eSuccess)
-			break;
+		if(!loadedParseIndex)
+		{
+			status = ParseEOFLine();
+			if(status == PDFHummus::eSuccess)
+				status = ParseLastXrefPosition();
+			if(status == PDFHummus::eSuccess)
+				status = ParseFileDirectory(); // that would be the xref and trailer
+		}
 
-		status = ParseLastXrefPosition();
 		if(status != PDFHummus::eSuccess)
-			break;
+		{
+			if(!inOptions.ReconstructBrokenXref)
+				break;
 
-		status = ParseFileDirectory(); // that would be the xref and trailer
-		if(status != PDFHummus::eSuccess)
-			break;
+			TRACE_LOG("PDFParser::StartPDFParsing, failed to read xref and trailer. reconstructing them by scanning the file");
+			status = ReconstructXref(inOptions.XrefReconstructionThreads);
+			if(status != PDFHummus::eSuccess)
+				break;
+		}
 
-		status = SetupDecryptionHelper(inOptions.Password);
-		if (status != PDFHummus::eSuccess)
-			break;
+		status = SetupDocumentStructure(inOptions);
 
-		if (IsEncrypted() && !IsEncryptionSupported())
+		// the xref may be read fine, and still point to the wrong places. so if the document structure can't be read, try also with reconstruction
+		if(status != PDFHummus::eSuccess && inOptions.ReconstructBrokenXref && !mXrefReconstructed)
 		{
-			// not parsing pages for encrypted docs that the lib cant decrypt.
-			// not commiting..and there's a practical reason.
-			// lower level objects will be in object streams (for those PDFs that have them)
-			// and the may not be accessed
-			mPagesCount = 0;
-			mPagesObjectIDs = NULL;
+			TRACE_LOG("PDFParser::StartPDFParsing, failed to read document structure. reconstructing xref and trailer by scanning the file");
+			status = ReconstructXref(inOptions.XrefReconstructionThreads);
+			if(status != PDFHummus::eSuccess)
+				break;
+			status = SetupDocumentStructure(inOptions);
+			if(status != PDFHummus::eSuccess)
+				break;
 		}
-		else
+
+		if(status == PDFHummus::eSuccess && mParseIndexCache && !loadedParseIndex && !mXrefReconstructed)
+			StoreParseIndex();
+	}while(false);
+
+	return status;
+}
+
+EStatusCode PDFParser::StartPDFParsingCursor(PDFParser* inSourceParser,IByteReaderWithPosition* inSourceStream,const PDFParsingOptions& inOptions)
+{
+	ResetParser();
+
+	if(inSourceParser->mXrefReconstructed)
+	{
+		TRACE_LOG("PDFParser::StartPDFParsingCursor, cursors are not available for files with a reconstructed xref");
+		return PDFHummus::eFailure;
+	}
+
+	if(!inSourceStream)
+	{
+		// read straight from the source stream content
+		IByteReaderWithPosition* sourceStream = inSourceParser->mStream;
+		LongFilePositionType sourcePosition = sourceStream->GetCurrentPosition();
+		LongBufferSizeType contentSize;
+		sourceStream->SetPosition(0);
+		const Byte* content = sourceStream->GetContiguousSpan(contentSize);
+		sourceStream->SetPosition(sourcePosition);
+		if(!content)
+		{
+			TRACE_LOG("PDFParser::StartPDFParsingCursor, source stream does not provide direct access to its content. provide a stream for the cursor");
+			return PDFHummus::eFailure;
+		}
+		mCursorStream = new InputByteArrayStream((Byte*)content,contentSize);
+		inSourceStream = mCursorStream;
+	}
+
+	mStream = inSourceStream;
+	mCurrentPositionProvider.Assign(mStream);
+	mObjectParser.SetReadStream(inSourceStream,&mCurrentPositionProvider);
+	mDecodedObjectStreams.SetBudget(inOptions.DecodedObjectStreamsCacheBudget);
+	mFlateCheckpointsInterval = inOptions.FlateCheckpointsInterval;
+
+	// take what the source has already read
+	mPDFLevel = inSourceParser->mPDFLevel;
+	mXrefTable = inSourceParser->mXrefTable;
+	mLastXrefPosition = inSourceParser->mLastXrefPosition;
+	mTrailerPosition = inSourceParser->mTrailerPosition;
+	mTrailerIsXrefStream = inSourceParser->mTrailerIsXrefStream;
+	mPassword = inSourceParser->mPassword;
+	mLazyPagesIndexing = inSourceParser->mLazyPagesIndexing;
+	if(inSourceParser->mPagesObjectIDs)
+	{
+		mPagesCount = inSourceParser->mPagesCount;
+		mPagesObjectIDs = new ObjectIDType[mPagesCount];
+		std::copy(inSourceParser->mPagesObjectIDs,inSourceParser->mPagesObjectIDs + mPagesCount,mPagesObjectIDs);
+	}
+
+	// the trailer is read again, rather than shared, so that each cursor has its own objects
+	if(!ReadTrailerAt(mTrailerPosition,mTrailerIsXrefStream))
+	{
+		TRACE_LOG("PDFParser::StartPDFParsingCursor, failed to read trailer");
+		return PDFHummus::eFailure;
+	}
+
+	PDFParsingOptions options = inOptions;
+	options.Password = mPassword;
+	return SetupDocumentStructure(options);
+}
+
+std::string PDFParser::ComputeParseIndexKey()
+{
+	// the file size and its last bytes. these have the last xref position, so any update to the file changes them
+	LongFilePositionType streamSize = GetStreamSize();
+	LongBufferSizeType tailSize = streamSize < LINE_BUFFER_SIZE ? (LongBufferSizeType)streamSize : LINE_BUFFER_SIZE;
+	Byte tail[LINE_BUFFER_SIZE];
+
+	mStream->SetPositionFromEnd(tailSize);
+	tailSize = mStream->Read(tail,tailSize);
+
+	std::stringstream key;
+	key<<streamSize<<":";
+	return key.str().append((const char*)tail,tailSize);
+}
+
+static const std::string scObj = "obj";
+bool PDFParser::ReadTrailerAt(LongFilePositionType inTrailerPosition,bool inIsXrefStream)
+{
+	// read a trailer that was already found. for an xref stream, parse just the stream dictionary
+	MovePositionInStream(inTrailerPosition);
+	if(inIsXrefStream)
+	{
+		PDFObjectCastPtr<PDFInteger> objectID(mObjectParser.ParseNewObject());
+		PDFObjectCastPtr<PDFInteger> versionObject(mObjectParser.ParseNewObject());
+		PDFObjectCastPtr<PDFSymbol> objKeyword(mObjectParser.ParseNewObject());
+		if(!objectID || !versionObject || !objKeyword || objKeyword->GetValue() != scObj)
 		{
-			status = ParsePagesObjectIDs();
-			if (status != PDFHummus::eSuccess)
-				break;
+			TRACE_LOG("PDFParser::ReadTrailerAt, failed to read xref stream object declaration");
+			return false;
+		}
+
+		NotifyIndirectObjectStart(objectID->GetValue(),versionObject->GetValue());
+		PDFObjectCastPtr<PDFStreamInput> xrefStream(mObjectParser.ParseNewObject());
+		NotifyIndirectObjectEnd(xrefStream.GetPtr());
+		if(!xrefStream)
+		{
+			TRACE_LOG("PDFParser::ReadTrailerAt, failed to read xref stream");
+			return false;
+		}
+		RefCountPtr<PDFDictionary> xrefDictionary(xrefStream->QueryStreamDictionary());
+		mTrailer = xrefDictionary;
+	}
+	else
+	{
+		PDFObjectCastPtr<PDFDictionary> trailerDictionary(mObjectParser.ParseNewObject());
+		if(!trailerDictionary)
+		{
+			TRACE_LOG("PDFParser::ReadTrailerAt, failed to read trailer dictionary");
+			return false;
+		}
+		mTrailer = trailerDictionary;
+	}
+
+	return true;
+}
+
+bool PDFParser::LoadParseIndex()
+{
+	ParseIndex parseIndex;
+	if(!mParseIndexCache->Find(mParseIndexKey,parseIndex))
+		return false;
+
+	if(!ReadTrailerAt(parseIndex.mTrailerPosition,parseIndex.mTrailerIsXrefStream))
+	{
+		TRACE_LOG("PDFParser::LoadParseIndex, failed to read trailer. ignoring parse index");
+		return false;
+	}
+
+	// size and last bytes may be the same for a different file [e.g. with an xref stream, whose trailer is not in
+	// the last bytes], so make sure that the trailer ID is the same as well
+	if(GetTrailerDocumentID() != parseIndex.mDocumentID)
+	{
+		TRACE_LOG("PDFParser::LoadParseIndex, trailer ID is different than the parse index one. ignoring parse index");
+		return false;
+	}
+	mParseIndexCache->RecordHit();
+
+	*mXrefTable = parseIndex.mXrefTable;
+	mLastXrefPosition = parseIndex.mLastXrefPosition;
+	mTrailerPosition = parseIndex.mTrailerPosition;
+	mTrailerIsXrefStream = parseIndex.mTrailerIsXrefStream;
+
+	// pages that were indexed in full are used as is, even when lazy indexing is asked for
+	if(!parseIndex.mPagesObjectIDs.empty())
+	{
+		mPagesCount = (unsigned long)parseIndex.mPagesObjectIDs.size();
+		mPagesObjectIDs = new ObjectIDType[mPagesCount];
+		std::copy(parseIndex.mPagesObjectIDs.begin(),parseIndex.mPagesObjectIDs.end(),mPagesObjectIDs);
+		mLazyPagesIndexing = false;
+	}
+
+	ObjectIDTypeToObjectStreamHeaderEntryVectorMap::iterator it = parseIndex.mObjectStreamsHeaders.begin();
+	for(; it != parseIndex.mObjectStreamsHeaders.end(); ++it)
+	{
+		ObjectStreamHeaderEntry* objectStreamHeader = new ObjectStreamHeaderEntry[it->second.size()];
+		std::copy(it->second.begin(),it->second.end(),objectStreamHeader);
+		mObjectStreamsCache.insert(ObjectIDTypeToObjectStreamHeaderEntryMap::value_type(it->first,objectStreamHeader));
+	}
+
+	return true;
+}
+
+void PDFParser::StoreParseIndex()
+{
+	ParseIndex parseIndex;
+
+	parseIndex.mXrefTable = *mXrefTable;
+	parseIndex.mLastXrefPosition = mLastXrefPosition;
+	parseIndex.mTrailerPosition = mTrailerPosition;
+	parseIndex.mTrailerIsXrefStream = mTrailerIsXrefStream;
+	parseIndex.mDocumentID = GetTrailerDocumentID();
+	if(mPagesObjectIDs)
+		parseIndex.mPagesObjectIDs.assign(mPagesObjectIDs,mPagesObjectIDs + mPagesCount);
+	// object streams headers read so far go in here. later ones are added when done parsing
+	parseIndex.mObjectStreamsHeaders.swap(mNewObjectStreamsHeaders);
+
+	mParseIndexCache->Store(mParseIndexKey,parseIndex);
+}
+
+std::string PDFParser::GetTrailerDocumentID()
+{
+	std::string documentID;
+	PDFObjectCastPtr<PDFArray> idArray(QueryDictionaryObject(mTrailer.GetPtr(),"ID"));
+	if(!idArray)
+		return documentID;
+
+	SingleValueContainerIterator<PDFObjectVector> it = idArray->GetIterator();
+	while(it.MoveNext())
+	{
+		if(it.GetItem()->GetType() == PDFObject::ePDFObjectLiteralString)
+			documentID.append(((PDFLiteralString*)it.GetItem())->GetValue());
+		else if(it.GetItem()->GetType() == PDFObject::ePDFObjectHexString)
+			documentID.append(((PDFHexString*)it.GetItem())->GetValue());
+		// separate the strings, so that different splits of the same bytes don't match
+		documentID.push_back('\0');
+	}
+	return documentID;
+}
+
+void PDFParser::RecordObjectStreamHeader(ObjectIDType inObjectStreamID,const ObjectStreamHeaderEntry* inHeader,ObjectIDType inObjectsCount)
+{
+	if(!mParseIndexCache || mParseIndexKey.empty())
+		return;
+
+	mNewObjectStreamsHeaders[inObjectStreamID].assign(inHeader,inHeader + inObjectsCount);
+}
+
+EStatusCode PDFParser::SetupDocumentStructure(const PDFParsingOptions& inOptions)
+{
+	EStatusCode status = SetupDecryptionHelper(inOptions.Password);
+	if (status != PDFHummus::eSuccess)
+		return status;
+
+	// objects in object streams are found only now, when the object streams can be decrypted
+	if(mXrefReconstructed)
+		AddReconstructedObjectStreamsEntries();
+
+	// start caching parsed objects only now, when decryption is setup, so that cached objects are decrypted ones
+	mParsedObjects.SetEvictionPolicy(inOptions.ParsedObjectsCacheEvictionPolicy);
+	mParsedObjects.SetBudget(inOptions.ParsedObjectsCacheBudget);
+
+	if (IsEncrypted() && !IsEncryptionSupported())
+	{
+		// not parsing pages for encrypted docs that the lib cant decrypt.
+		// not commiting..and there's a practical reason.
+		// lower level objects will be in object streams (for those PDFs that have them)
+		// and the may not be accessed
+		mPagesCount = 0;
+		mPagesObjectIDs = NULL;
+	}
+	else if(!mPagesObjectIDs) // may be there already, from a parse index
+		status = ParsePagesObjectIDs();
+
+	return status;
+}
+
+static void InsertToDictionary(PDFDictionary* inDictionary,const std::string& inKey,PDFObject* inValue)
+{
+	RefCountPtr<PDFName> key(new PDFName(inKey));
+	inDictionary->Insert(key.GetPtr(),inValue);
+}
+
+static bool ScannedObjectHeaderPositionLess(const ScannedObjectHeader& inLeft,const ScannedObjectHeader& inRight)
+{
+	return inLeft.mPosition < inRight.mPosition;
+}
+
+ObjectIDType PDFParser::FindReconstructedObjectAt(const ScannedObjectHeaderVector& inObjectHeaders,LongFilePositionType inPosition)
+{
+	// the object containing a position is the last one starting before it. consider it only if it's the object that
+	// the xref points to [and not an older version of it]
+	ScannedObjectHeader key;
+	key.mPosition = inPosition;
+	ScannedObjectHeaderVector::const_iterator it = std::upper_bound(inObjectHeaders.begin(),inObjectHeaders.end(),key,ScannedObjectHeaderPositionLess);
+	if(it == inObjectHeaders.begin())
+		return 0;
+	--it;
+	if(mXrefTable->GetType(it->mObjectID) != eXrefEntryExisting || mXrefTable->GetPosition(it->mObjectID) != it->mPosition)
+		return 0;
+	return it->mObjectID;
+}
+
+EStatusCode PDFParser::ReconstructXref(unsigned int inThreadsCount)
+{
+	// 1. scan the file for object headers, trailers, and markers of xref streams, object streams and catalogs
+	// 2. build the xref from the objects headers. when an object appears more than once, the last one wins, as with incremental updates
+	// 3. take the trailer from the last trailer or xref stream that has a Root. if there's none, look for a catalog
+	// objects in object streams are added later, after decryption is setup [see AddReconstructedObjectStreamsEntries]
+
+	EStatusCode status = PDFHummus::eSuccess;
+
+	// drop whatever was read till now
+	mTrailer = NULL;
+	mParsedObjects.SetBudget(0);
+	mParsedObjects.Reset();
+	mDecodedObjectStreams.Reset();
+	ResetFlateDecodeIndexes();
+	ObjectIDTypeToObjectStreamHeaderEntryMap::iterator itStreams = mObjectStreamsCache.begin();
+	for(; itStreams != mObjectStreamsCache.end();++itStreams)
+		delete[] itStreams->second;
+	mObjectStreamsCache.clear();
+	mDecryptionHelper.Reset();
+	delete[] mPagesObjectIDs;
+	mPagesObjectIDs = NULL;
+	mPagesCount = 0;
+	mPageTreeNodes.clear();
+	mReconstructedObjectStreams.clear();
+	mLastXrefPosition = 0;
+	mXrefReconstructed = true;
+	// there's no trailer position to keep in a parse index, so don't keep one
+	mNewObjectStreamsHeaders.clear();
+	mParseIndexKey.clear();
+
+	do
+	{
+		// scan straight from the stream content when it provides direct access to it [say, memory mapped files]. otherwise read it to memory
+		LongFilePositionType streamSize = GetStreamSize();
+		std::vector<Byte> streamContent;
+		mStream->SetPosition(0);
+		LongBufferSizeType spanSize;
+		const Byte* data = mStream->GetContiguousSpan(spanSize);
+		if(!data || spanSize < (LongBufferSizeType)streamSize)
+		{
+			streamContent.resize((size_t)streamSize);
+			LongBufferSizeType readSize = 0;
+			while(readSize < streamContent.size() && mStream->NotEnded())
+			{
+				LongBufferSizeType readNow = mStream->Read(&streamContent[(size_t)readSize],streamContent.size() - readSize);
+				if(0 == readNow)
+					break;
+				readSize += readNow;
+			}
+			streamContent.resize((size_t)readSize);
+			data = streamContent.size() > 0 ? &streamContent[0] : NULL;
+			spanSize = readSize;
+		}
+
+		XrefReconstructionScanResults scanResults;
+		XrefReconstructionScanner scanner;
+		scanner.SetThreadsCount(inThreadsCount);
+		if(data)
+			scanner.Scan(data,spanSize,scanResults);
+
+		if(scanResults.mObjectHeaders.empty())
+		{
+			TRACE_LOG("PDFParser::ReconstructXref, no objects found in file");
+			status = PDFHummus::eFailure;
+			break;
+		}
+
+		ObjectIDType xrefSize = 0;
+		ScannedObjectHeaderVector::iterator it = scanResults.mObjectHeaders.begin();
+		for(; it != scanResults.mObjectHeaders.end(); ++it)
+			if(it->mObjectID >= xrefSize)
+				xrefSize = it->mObjectID + 1;
+
+		mXrefTable->Reset(xrefSize,streamSize);
+		for(it = scanResults.mObjectHeaders.begin(); it != scanResults.mObjectHeaders.end(); ++it)
+			mXrefTable->SetEntry(it->mObjectID,it->mPosition,it->mGeneration,eXrefEntryExisting);
+
+		// object streams are read later, but find them now
+		LongFilePositionTypeVector::iterator itMarkers = scanResults.mObjectStreamMarkers.begin();
+		for(; itMarkers != scanResults.mObjectStreamMarkers.end(); ++itMarkers)
+		{
+			ObjectIDType objectStreamID = FindReconstructedObjectAt(scanResults.mObjectHeaders,*itMarkers);
+			if(objectStreamID != 0 && (mReconstructedObjectStreams.empty() || mReconstructedObjectStreams.back() != objectStreamID))
+				mReconstructedObjectStreams.push_back(objectStreamID);
 		}
 
+		status = ReconstructTrailer(scanResults);
 	}while(false);
 
 	return status;
 }
 
+static bool IsLaterTrailerCandidate(const std::pair<LongFilePositionType,PDFDictionary*>& inLeft,const std::pair<LongFilePositionType,PDFDictionary*>& inRight)
+{
+	return inLeft.first > inRight.first;
+}
+
+static const std::string scTrailer = "trailer";
+EStatusCode PDFParser::ReconstructTrailer(const XrefReconstructionScanResults& inScanResults)
+{
+	// collect trailers - both regular trailers and xref streams dictionaries, and use the last one that has a Root
+	typedef std::pair<LongFilePositionType,PDFDictionary*> LongFilePositionTypeAndPDFDictionary;
+	std::vector<LongFilePositionTypeAndPDFDictionary> candidates;
+
+	LongFilePositionTypeVector::const_iterator itMarkers = inScanResults.mTrailers.begin();
+	for(; itMarkers != inScanResults.mTrailers.end(); ++itMarkers)
+	{
+		MovePositionInStream(*itMarkers);
+		PDFObjectCastPtr<PDFSymbol> trailerKeyword(mObjectParser.ParseNewObject());
+		if(!trailerKeyword || trailerKeyword->GetValue() != scTrailer)
+			continue;
+		PDFObjectCastPtr<PDFDictionary> trailerDictionary(mObjectParser.ParseNewObject());
+		if(!trailerDictionary)
+			continue;
+		trailerDictionary->AddRef();
+		candidates.push_back(LongFilePositionTypeAndPDFDictionary(*itMarkers,trailerDictionary.GetPtr()));
+	}
+
+	for(itMarkers = inScanResults.mXrefStreamMarkers.begin(); itMarkers != inScanResults.mXrefStreamMarkers.end(); ++itMarkers)
+	{
+		ObjectIDType xrefStreamID = FindReconstructedObjectAt(inScanResults.mObjectHeaders,*itMarkers);
+		if(0 == xrefStreamID)
+			continue;
+		PDFObjectCastPtr<PDFStreamInput> xrefStream(ParseNewObject(xrefStreamID));
+		if(!xrefStream)
+			continue;
+		PDFDictionary* xrefStreamDictionary = xrefStream->QueryStreamDictionary();
+		PDFObjectCastPtr<PDFName> typeObject(xrefStreamDictionary->QueryDirectObject("Type"));
+		if(!typeObject || typeObject->GetValue() != "XRef")
+		{
+			xrefStreamDictionary->Release();
+			continue;
+		}
+		candidates.push_back(LongFilePositionTypeAndPDFDictionary(mXrefTable->GetPosition(xrefStreamID),xrefStreamDictionary));
+	}
+
+	std::stable_sort(candidates.begin(),candidates.end(),IsLaterTrailerCandidate);
+
+	RefCountPtr<PDFDictionary> newTrailer(new PDFDictionary());
+	RefCountPtr<PDFObject> sizeObject(new PDFInteger(mXrefTable->GetSize()));
+	InsertToDictionary(newTrailer.GetPtr(),"Size",sizeObject.GetPtr());
+
+	bool foundRoot = false;
+	std::vector<LongFilePositionTypeAndPDFDictionary>::iterator itCandidates = candidates.begin();
+	for(; itCandidates != candidates.end() && !foundRoot; ++itCandidates)
+	{
+		PDFObjectCastPtr<PDFIndirectObjectReference> rootReference(itCandidates->second->QueryDirectObject("Root"));
+		if(!rootReference)
+			continue;
+		foundRoot = true;
+
+		// keep what's required for reading the document. the rest of the trailer refers to the broken xref
+		InsertToDictionary(newTrailer.GetPtr(),"Root",rootReference.GetPtr());
+		const char* keys[] = {"Info","ID","Encrypt"};
+		for(size_t i=0; i < sizeof(keys)/sizeof(const char*); ++i)
+		{
+			RefCountPtr<PDFObject> value(itCandidates->second->QueryDirectObject(keys[i]));
+			if(!!value)
+				InsertToDictionary(newTrailer.GetPtr(),keys[i],value.GetPtr());
+		}
+	}
+
+	for(itCandidates = candidates.begin(); itCandidates != candidates.end(); ++itCandidates)
+		itCandidates->second->Release();
+
+	// no trailer to use, look for the last catalog
+	LongFilePositionTypeVector::const_reverse_iterator itCatalogs = inScanResults.mCatalogMarkers.rbegin();
+	for(; itCatalogs != inScanResults.mCatalogMarkers.rend() && !foundRoot; ++itCatalogs)
+	{
+		ObjectIDType catalogID = FindReconstructedObjectAt(inScanResults.mObjectHeaders,*itCatalogs);
+		if(0 == catalogID)
+			continue;
+		PDFObjectCastPtr<PDFDictionary> catalog(ParseNewObject(catalogID));
+		if(!catalog)
+			continue;
+		PDFObjectCastPtr<PDFName> typeObject(catalog->QueryDirectObject("Type"));
+		if(!typeObject || typeObject->GetValue() != "Catalog")
+			continue;
+
+		foundRoot = true;
+		RefCountPtr<PDFObject> rootReference(new PDFIndirectObjectReference(catalogID,mXrefTable->GetRevision(catalogID)));
+		InsertToDictionary(newTrailer.GetPtr(),"Root",rootReference.GetPtr());
+	}
+
+	if(!foundRoot)
+	{
+		TRACE_LOG("PDFParser::ReconstructTrailer, could not find a trailer or a catalog in file");
+		return PDFHummus::eFailure;
+	}
+
+	mTrailer = newTrailer;
+	return PDFHummus::eSuccess;
+}
+
+void PDFParser::AddReconstructedObjectStreamsEntries()
+{
+	// objects in object streams override objects that appear earlier in the file. object streams are sorted by position, so
+	// objects of later object streams also override those of earlier ones
+	ObjectIDTypeVector::iterator it = mReconstructedObjectStreams.begin();
+	for(; it != mReconstructedObjectStreams.end(); ++it)
+	{
+		LongFilePositionType objectStreamPosition = mXrefTable->GetPosition(*it);
+
+		{
+			PDFObjectCastPtr<PDFStreamInput> objectStream(ParseNewObject(*it));
+			if(!objectStream)
+				continue;
+			RefCountPtr<PDFDictionary> streamDictionary(objectStream->QueryStreamDictionary());
+			PDFObjectCastPtr<PDFName> typeObject(streamDictionary->QueryDirectObject("Type"));
+			if(!typeObject || typeObject->GetValue() != "ObjStm")
+				continue;
+		}
+
+		DecodedObjectStream* decodedStream = DecodeObjectStream(*it);
+		if(!decodedStream)
+			continue;
+
+		InputByteArrayStream decodedStreamReader(decodedStream->mData.size() > 0 ? &(decodedStream->mData[0]) : NULL,decodedStream->mData.size());
+		AdapterIByteReaderWithPositionToIReadPositionProvider decodedStreamPositionProvider(&decodedStreamReader);
+		mObjectParser.SetReadStream(&decodedStreamReader,&decodedStreamPositionProvider);
+
+		ObjectStreamHeaderEntry* objectStreamHeader = new ObjectStreamHeaderEntry[decodedStream->mObjectsCount];
+		if(ParseObjectStreamHeader(objectStreamHeader,decodedStream->mObjectsCount) == PDFHummus::eSuccess)
+		{
+			for(ObjectIDType i = 0; i < decodedStream->mObjectsCount; ++i)
+			{
+				ObjectIDType objectID = objectStreamHeader[i].mObjectNumber;
+				if(objectID == *it)
+					continue;
+				EXrefEntryType currentType = mXrefTable->GetType(objectID);
+				if(eXrefEntryExisting == currentType && mXrefTable->GetPosition(objectID) > objectStreamPosition)
+					continue;
+				mXrefTable->ExtendToSize(objectID + 1);
+				mXrefTable->SetEntry(objectID,*it,(unsigned long)i,eXrefEntryStreamObject);
+			}
+		}
+		delete[] objectStreamHeader;
+
+		mObjectParser.SetReadStream(mStream,&mCurrentPositionProvider);
+		delete decodedStream;
+	}
+}
+
 PDFObjectParser& PDFParser::GetObjectParser()
 {
 	return mObjectParser;
@@ -212,7 +780,7 @@ EStatusCode PDFParser::ParseEOFLine()
 
 LongBufferSizeType PDFParser::GetCurrentPositionFromEnd()
 {
-	return mLastReadPositionFromEnd-(mCurrentBufferIndex-mLinesBuffer);
+	return mLastReadPositionFromEnd-(mCurrentBufferIndex-mCurrentBufferStart);
 }
 
 bool PDFParser::GoBackTillToken()
@@ -275,7 +843,7 @@ bool PDFParser::ReadBack(Byte& outValue)
 	if(IsBeginOfFile())
 		return false;
 
-	if(mCurrentBufferIndex > mLinesBuffer)
+	if(mCurrentBufferIndex > mCurrentBufferStart)
 	{
 		--mCurrentBufferIndex;
 		outValue = *mCurrentBufferIndex;
@@ -284,7 +852,7 @@ bool PDFParser::ReadBack(Byte& outValue)
 	else
 	{
 		ReadNextBufferFromEnd(); // must be able to read...but could be 0 bytes
-		if(mCurrentBufferIndex > mLinesBuffer)
+		if(mCurrentBufferIndex > mCurrentBufferStart)
 		{
 			--mCurrentBufferIndex;
 			outValue = *mCurrentBufferIndex;
@@ -305,6 +873,23 @@ bool PDFParser::ReadNextBufferFromEnd()
 	{
 		mStream->SetPositionFromEnd(mLastReadPositionFromEnd); // last known position that worked.
 		LongFilePositionType positionBefore = mStream->GetCurrentPosition();
+
+		// if the stream provides direct access to its content, no need to copy. just take all that's left till the file start
+		if(positionBefore > 0)
+		{
+			LongBufferSizeType spanSize;
+			mStream->SetPosition(0);
+			const Byte* span = mStream->GetContiguousSpan(spanSize);
+			if(span && spanSize >= (LongBufferSizeType)positionBefore)
+			{
+				mEncounteredFileStart = true;
+				mCurrentBufferStart = span;
+				mLastAvailableIndex = mCurrentBufferIndex = span + positionBefore;
+				mLastReadPositionFromEnd+= positionBefore;
+				return true;
+			}
+		}
+
 		mStream->SetPositionFromEnd(mLastReadPositionFromEnd + LINE_BUFFER_SIZE); // try earlier one
 		LongFilePositionType positionAfter = mStream->GetCurrentPosition();
 		LongBufferSizeType readAmount = positionBefore - positionAfter; // check if got to start by testing position
@@ -313,6 +898,7 @@ bool PDFParser::ReadNextBufferFromEnd()
 		mEncounteredFileStart = readAmount < LINE_BUFFER_SIZE;
 		if(0 == readAmount)
 			return false;
+		mCurrentBufferStart = mLinesBuffer;
 		mLastAvailableIndex = mLinesBuffer + readAmount;
 		mCurrentBufferIndex = mLastAvailableIndex;
 		mLastReadPositionFromEnd+= readAmount;
@@ -322,7 +908,7 @@ bool PDFParser::ReadNextBufferFromEnd()
 
 bool PDFParser::IsBeginOfFile()
 {
-	return mEncounteredFileStart && (mCurrentBufferIndex == mLinesBuffer);
+	return mEncounteredFileStart && (mCurrentBufferIndex == mCurrentBufferStart);
 }
 
 static const std::string scStartxref = "startxref";
@@ -410,7 +996,6 @@ EStatusCode PDFParser::ParseLastXrefPosition()
 
 }
 
-static const std::string scTrailer = "trailer";
 EStatusCode PDFParser::ParseTrailerDictionary()
 {
 
@@ -439,6 +1024,8 @@ EStatusCode PDFParser::ParseTrailerDictionary()
 		}
 
 		// k. now that all is well, just parse the damn dictionary, which is actually...the easiest part.
+		mTrailerPosition = mStream->GetCurrentPosition() - aTokenizer.GetReadBufferSize();
+		mTrailerIsXrefStream = false;
 		mObjectParser.ResetReadState(aTokenizer);
 		PDFObjectCastPtr<PDFDictionary> dictionaryObject(mObjectParser.ParseNewObject());
 		if(!dictionaryObject)
@@ -460,10 +1047,6 @@ EStatusCode PDFParser::BuildXrefTableFromTable()
 
 	do
 	{
-		status = DetermineXrefSize();
-		if(status != PDFHummus::eSuccess)
-			break;
-
 		status = InitializeXref();
 		if(status != PDFHummus::eSuccess)
 			break;
@@ -475,61 +1058,45 @@ EStatusCode PDFParser::BuildXrefTableFromTable()
 				break;
 		}
 
-        XrefEntryInput* extendedTable = NULL;
-        ObjectIDType extendedTableSize;
-		status = ParseXrefFromXrefTable(mXrefTable,mXrefSize,mLastXrefPosition,&extendedTable,&extendedTableSize);
+		status = ParseXrefFromXrefTable(*mXrefTable,mLastXrefPosition);
 		if(status != PDFHummus::eSuccess)
 			break;
 
-        // Table may have been extended, in which case replace the pointer and current size
-        if(extendedTable)
-        {
-            mXrefSize = extendedTableSize;
-            delete[] mXrefTable;
-            mXrefTable = extendedTable;
-        }
-
 		// For hybrids, check also XRefStm entry
 		PDFObjectCastPtr<PDFInteger> xrefStmReference(mTrailer->QueryDirectObject("XRefStm"));
 		if(!xrefStmReference)
 			break;
 		// if exists, merge update xref
-		status = ParseXrefFromXrefStream(mXrefTable,mXrefSize,xrefStmReference->GetValue(),&extendedTable,&extendedTableSize);
+		status = ParseXrefFromXrefStream(*mXrefTable,xrefStmReference->GetValue());
 		if(status != PDFHummus::eSuccess)
 		{
 			TRACE_LOG("PDFParser::ParseDirectory, failure to parse xref in hybrid mode");
 			break;
 		}
-        if(extendedTable)
-        {
-            mXrefSize = extendedTableSize;
-            delete[] mXrefTable;
-            mXrefTable = extendedTable;
-        }
 	}while(false);
 
 	return status;
 }
 
-EStatusCode PDFParser::DetermineXrefSize()
+EStatusCode PDFParser::InitializeXref()
 {
 	PDFObjectCastPtr<PDFInteger> aSize(mTrailer->QueryDirectObject("Size"));
 
 	if(!aSize)
-	{
 		return PDFHummus::eFailure;
-	}
-	else
-	{
-		mXrefSize = (ObjectIDType)aSize->GetValue();
-		return PDFHummus::eSuccess;
-	}
+
+	// file size determines the width of positions in the xref table
+	mXrefTable->Reset((ObjectIDType)aSize->GetValue(),GetStreamSize());
+	return PDFHummus::eSuccess;
 }
 
-EStatusCode PDFParser::InitializeXref()
+LongFilePositionType PDFParser::GetStreamSize()
 {
-	mXrefTable = new XrefEntryInput[mXrefSize];
-	return PDFHummus::eSuccess;
+	LongFilePositionType currentPosition = mStream->GetCurrentPosition();
+	mStream->SetPositionFromEnd(0);
+	LongFilePositionType streamSize = mStream->GetCurrentPosition();
+	mStream->SetPosition(currentPosition);
+	return streamSize;
 }
 
 typedef BoxingBaseWithRW<ObjectIDType> ObjectIDTypeBox;
@@ -537,11 +1104,8 @@ typedef BoxingBaseWithRW<unsigned long> ULong;
 typedef BoxingBaseWithRW<LongFilePositionType> LongFilePositionTypeBox;
 
 static const std::string scXref = "xref";
-EStatusCode PDFParser::ParseXrefFromXrefTable(XrefEntryInput* inXrefTable,
-                                              ObjectIDType inXrefSize,
-                                              LongFilePositionType inXrefPosition,
-                                              XrefEntryInput** outExtendedTable,
-                                              ObjectIDType* outExtendedTableSize)
+EStatusCode PDFParser::ParseXrefFromXrefTable(ParsedXrefTable& ioXrefTable,
+                                              LongFilePositionType inXrefPosition)
 {
 	// K. cross ref starts at  xref position
 	// and ends with trailer (or when exahausted the number of objects...whichever first)
@@ -552,8 +1116,6 @@ EStatusCode PDFParser::ParseXrefFromXrefTable(XrefEntryInput* inXrefTable,
 	ObjectIDType firstNonSectionObject;
 	Byte entry[20];
 
-    *outExtendedTable = NULL;
-
 	tokenizer.SetReadStream(mStream);
 	MovePositionInStream(inXrefPosition);
 
@@ -601,15 +1163,8 @@ EStatusCode PDFParser::ParseXrefFromXrefTable(XrefEntryInput* inXrefTable,
 			firstNonSectionObject = currentObject + ObjectIDTypeBox(token.second);
 
             // if the segment declared objects above the xref size, consult policy on what to do
-            if(firstNonSectionObject > inXrefSize && mAllowExtendingSegments)
-            {
-                inXrefTable = ExtendXrefTableToSize(inXrefTable,inXrefSize,firstNonSectionObject);
-                inXrefSize = firstNonSectionObject;
-                if(*outExtendedTable)
-                    delete[] *outExtendedTable;
-                *outExtendedTable = inXrefTable;
-                *outExtendedTableSize = firstNonSectionObject;
-            }
+            if(firstNonSectionObject > ioXrefTable.GetSize() && mAllowExtendingSegments)
+                ioXrefTable.ExtendToSize(firstNonSectionObject);
 
 			// now parse the section.
 			while(currentObject < firstNonSectionObject)
@@ -617,11 +1172,12 @@ EStatusCode PDFParser::ParseXrefFromXrefTable(XrefEntryInput* inXrefTable,
 				status = ReadNextXrefEntry(entry);
 				if (status != eSuccess)
 					break;
-				if(currentObject < inXrefSize)
+				if(currentObject < ioXrefTable.GetSize())
 				{
-					inXrefTable[currentObject].mObjectPosition = LongFilePositionTypeBox(std::string((const char*)entry, 10));
-					inXrefTable[currentObject].mRivision = ULong(std::string((const char*)(entry + 11), 5));
-					inXrefTable[currentObject].mType = entry[17] == 'n' ? eXrefEntryExisting:eXrefEntryDelete;
+					ioXrefTable.SetEntry(currentObject,
+										LongFilePositionTypeBox(std::string((const char*)entry, 10)),
+										ULong(std::string((const char*)(entry + 11), 5)),
+										entry[17] == 'n' ? eXrefEntryExisting:eXrefEntryDelete);
 				}
 				++currentObject;
 			}
@@ -664,15 +1220,6 @@ EStatusCode PDFParser::ReadNextXrefEntry(Byte inBuffer[20]) {
 	return status;
 }
 
-XrefEntryInput* PDFParser::ExtendXrefTableToSize(XrefEntryInput* inXrefTable,ObjectIDType inOldSize,ObjectIDType inNewSize)
-{
-    XrefEntryInput* newTable = new XrefEntryInput[inNewSize];
-
-	for(ObjectIDType i = 0; i < inOldSize; ++i)
-        newTable[i] =	inXrefTable[i];
-    return newTable;
-}
-
 PDFDictionary* PDFParser::GetTrailer()
 {
 	return mTrailer.GetPtr();
@@ -685,15 +1232,32 @@ double PDFParser::GetPDFLevel()
 
 PDFObject* PDFParser::ParseNewObject(ObjectIDType inObjectId)
 {
-	if(inObjectId >= mXrefSize)
-	{
+	if(inObjectId >= mXrefTable->GetSize())
 		return NULL;
+
+	if(mParsedObjects.GetBudget() == 0)
+		return ParseNewObjectFromFile(inObjectId);
+
+	PDFObject* anObject = mParsedObjects.Find(inObjectId);
+	if(!anObject)
+	{
+		// cached objects outlive any parse session, so don't allocate them from one
+		ParseSessionSuspension sessionSuspension;
+		anObject = ParseNewObjectFromFile(inObjectId);
+		if(anObject)
+			mParsedObjects.Insert(inObjectId,anObject);
 	}
-	else if(eXrefEntryExisting == mXrefTable[inObjectId].mType)
+	return anObject;
+}
+
+PDFObject* PDFParser::ParseNewObjectFromFile(ObjectIDType inObjectId)
+{
+	EXrefEntryType entryType = mXrefTable->GetType(inObjectId);
+	if(eXrefEntryExisting == entryType)
 	{
 		return ParseExistingInDirectObject(inObjectId);
 	}
-	else if(eXrefEntryStreamObject == mXrefTable[inObjectId].mType)
+	else if(eXrefEntryStreamObject == entryType)
 	{
 		return ParseExistingInDirectStreamObject(inObjectId);
 	}
@@ -701,17 +1265,31 @@ PDFObject* PDFParser::ParseNewObject(ObjectIDType inObjectId)
 		return NULL;
 }
 
+ParsedObjectsCache& PDFParser::GetParsedObjectsCache()
+{
+	return mParsedObjects;
+}
+
+const ParsedXrefTable& PDFParser::GetXrefTable()
+{
+	return *mXrefTable;
+}
+
+bool PDFParser::IsXrefReconstructed()
+{
+	return mXrefReconstructed;
+}
+
 ObjectIDType PDFParser::GetObjectsCount()
 {
-	return mXrefSize;
+	return mXrefTable->GetSize();
 }
 
-static const std::string scObj = "obj";
 PDFObject* PDFParser::ParseExistingInDirectObject(ObjectIDType inObjectID)
 {
 	PDFObject* readObject = NULL;
 
-	MovePositionInStream(mXrefTable[inObjectID].mObjectPosition);
+	MovePositionInStream(mXrefTable->GetPosition(inObjectID));
 
 	do
 	{
@@ -743,10 +1321,10 @@ PDFObject* PDFParser::ParseExistingInDirectObject(ObjectIDType inObjectID)
 			break;
 		}
 
-		if((unsigned long)versionObject->GetValue() != mXrefTable[inObjectID].mRivision)
+		if((unsigned long)versionObject->GetValue() != mXrefTable->GetRevision(inObjectID))
 		{
 			TRACE_LOG2("PDFParser::ParseExistingInDirectObject, failed to read object declaration, exepected version = %ld, found %ld",
-				mXrefTable[inObjectID].mRivision,versionObject->GetValue());
+				mXrefTable->GetRevision(inObjectID),versionObject->GetValue());
 			break;
 		}
 
@@ -830,6 +1408,14 @@ EStatusCode PDFParser::ParsePagesObjectIDs()
 		}
 
 		mPagesCount = (unsigned long)totalPagesCount->GetValue();
+
+		// lazy indexing. pages are located when asked for, by descending the tree
+		if(mLazyPagesIndexing)
+		{
+			mPagesRootObjectID = pagesReference->mObjectID;
+			break;
+		}
+
 		mPagesObjectIDs = new ObjectIDType[mPagesCount];
 
 		// now iterate through pages objects, and fill up the IDs [don't really need the object ID for the root pages tree...but whatever
@@ -944,7 +1530,181 @@ ObjectIDType PDFParser::GetPageObjectID(unsigned long inPageIndex)
 	if(mPagesCount <= inPageIndex)
 		return 0;
 
-	return mPagesObjectIDs[inPageIndex];
+	return mLazyPagesIndexing ? LocatePageObjectID(inPageIndex) : mPagesObjectIDs[inPageIndex];
+}
+
+static bool PageTreeKidStartsAfter(unsigned long inPageIndex,const PageTreeKid& inKid)
+{
+	return inPageIndex < inKid.mFirstPageIndex;
+}
+
+ObjectIDType PDFParser::LocatePageObjectID(unsigned long inPageIndex)
+{
+	// descend from the root, each time going to the kid whose pages range holds the page index. visited nodes
+	// are kept, so repeated access doesn't parse again
+	ObjectIDType nodeObjectID = mPagesRootObjectID;
+	unsigned long pageIndexInNode = inPageIndex;
+	std::set<ObjectIDType> visitedNodes;
+
+	while(true)
+	{
+		if(!visitedNodes.insert(nodeObjectID).second)
+		{
+			TRACE_LOG1("PDFParser::LocatePageObjectID, pages tree loops at node %ld",nodeObjectID);
+			return 0;
+		}
+
+		PageTreeNode* node = GetPageTreeNode(nodeObjectID);
+		if(!node)
+			return 0;
+
+		const PageTreeKid* kid = LocatePageTreeKid(node,pageIndexInNode);
+		if(!kid)
+		{
+			TRACE_LOG1("PDFParser::LocatePageObjectID, page index %ld is not found in pages tree",inPageIndex);
+			return 0;
+		}
+		if(pageIndexInNode - kid->mFirstPageIndex >= kid->mPagesCount)
+		{
+			TRACE_LOG1("PDFParser::LocatePageObjectID, page index %ld is not found in pages tree. pages count is probably wrong",inPageIndex);
+			return 0;
+		}
+
+		if(!kid->mIsPagesNode)
+			return kid->mObjectID;
+
+		pageIndexInNode -= kid->mFirstPageIndex;
+		nodeObjectID = kid->mObjectID;
+	}
+}
+
+PageTreeNode* PDFParser::GetPageTreeNode(ObjectIDType inNodeObjectID)
+{
+	ObjectIDTypeToPageTreeNodeMap::iterator itNode = mPageTreeNodes.find(inNodeObjectID);
+	if(itNode != mPageTreeNodes.end())
+		return &(itNode->second);
+
+	// only the node itself is parsed here. kids are resolved when pages under them are located
+	PDFObjectCastPtr<PDFDictionary> pageNode(ParseNewObject(inNodeObjectID));
+	if(!pageNode)
+	{
+		TRACE_LOG1("PDFParser::GetPageTreeNode, unable to parse pages node %ld",inNodeObjectID);
+		return NULL;
+	}
+
+	PDFObjectCastPtr<PDFArray> kidsObject(QueryDictionaryObject(pageNode.GetPtr(),"Kids"));
+	if(!kidsObject)
+	{
+		TRACE_LOG1("PDFParser::GetPageTreeNode, unable to find page kids array for pages node %ld",inNodeObjectID);
+		return NULL;
+	}
+
+	PageTreeNode node;
+	node.mResolvedKidsCount = 0;
+	node.mResolvedPagesCount = 0;
+	SingleValueContainerIterator<PDFObjectVector> it = kidsObject->GetIterator();
+
+	while(it.MoveNext())
+	{
+		PageTreeKid kid;
+		kid.mObjectID = 0;
+		kid.mFirstPageIndex = (unsigned long)node.mKids.size();
+		kid.mPagesCount = 1;
+		kid.mIsPagesNode = false;
+
+		// null pointer. same as with full indexing, counts as an empty page
+		if(it.GetItem()->GetType() != PDFObject::ePDFObjectNull)
+		{
+			if(it.GetItem()->GetType() != PDFObject::ePDFObjectIndirectObjectReference)
+			{
+				TRACE_LOG1("PDFParser::GetPageTreeNode, unexpected type for a Kids array object, type = %s",PDFObject::scPDFObjectTypeLabel(it.GetItem()->GetType()));
+				return NULL;
+			}
+			kid.mObjectID = ((PDFIndirectObjectReference*)it.GetItem())->mObjectID;
+		}
+		kid.mIsResolved = (0 == kid.mObjectID);
+		node.mKids.push_back(kid);
+	}
+
+	PDFObjectCastPtr<PDFInteger> nodePagesCount(QueryDictionaryObject(pageNode.GetPtr(),"Count"));
+	node.mKidsArePages = nodePagesCount.GetPtr() != NULL && nodePagesCount->GetValue() == (long long)node.mKids.size();
+
+	return &(mPageTreeNodes.insert(ObjectIDTypeToPageTreeNodeMap::value_type(inNodeObjectID,node)).first->second);
+}
+
+const PageTreeKid* PDFParser::LocatePageTreeKid(PageTreeNode* inNode,unsigned long inPageIndexInNode)
+{
+	if(inNode->mKidsArePages && inPageIndexInNode < inNode->mKids.size())
+	{
+		PageTreeKid& kid = inNode->mKids[inPageIndexInNode];
+		if(!kid.mIsResolved && ResolvePageTreeKid(kid) != eSuccess)
+			return NULL;
+		if(!kid.mIsPagesNode)
+			return &kid;
+
+		// not all kids are pages after all, so their ranges are not known. resolve them in order
+		inNode->mKidsArePages = false;
+	}
+
+	while(inNode->mResolvedKidsCount < inNode->mKids.size() && inPageIndexInNode >= inNode->mResolvedPagesCount)
+	{
+		PageTreeKid& kid = inNode->mKids[inNode->mResolvedKidsCount];
+		if(!kid.mIsResolved && ResolvePageTreeKid(kid) != eSuccess)
+			return NULL;
+		kid.mFirstPageIndex = inNode->mResolvedPagesCount;
+		inNode->mResolvedPagesCount += kid.mPagesCount;
+		++inNode->mResolvedKidsCount;
+	}
+
+	// empty pages nodes take no pages, so look for the last kid that starts at or before the page index
+	PageTreeKidVector::iterator resolvedEnd = inNode->mKids.begin() + inNode->mResolvedKidsCount;
+	PageTreeKidVector::iterator it = std::upper_bound(inNode->mKids.begin(),resolvedEnd,inPageIndexInNode,PageTreeKidStartsAfter);
+	if(it == inNode->mKids.begin())
+		return NULL;
+	--it;
+	return &(*it);
+}
+
+EStatusCode PDFParser::ResolvePageTreeKid(PageTreeKid& ioKid)
+{
+	PDFObjectCastPtr<PDFDictionary> kidObject(ParseNewObject(ioKid.mObjectID));
+	if(!kidObject)
+	{
+		TRACE_LOG1("PDFParser::ResolvePageTreeKid, unable to parse page node object %ld from kids reference",ioKid.mObjectID);
+		return eFailure;
+	}
+
+	PDFObjectCastPtr<PDFName> objectType(kidObject->QueryDirectObject("Type"));
+	if(!objectType)
+	{
+		TRACE_LOG("PDFParser::ResolvePageTreeKid, can't read object type");
+		return eFailure;
+	}
+
+	if(scPages == objectType->GetValue())
+	{
+		PDFObjectCastPtr<PDFInteger> kidPagesCount(QueryDictionaryObject(kidObject.GetPtr(),"Count"));
+		if(!kidPagesCount || kidPagesCount->GetValue() < 0)
+		{
+			TRACE_LOG1("PDFParser::ResolvePageTreeKid, failed to read pages count for pages node %ld",ioKid.mObjectID);
+			return eFailure;
+		}
+		ioKid.mPagesCount = (unsigned long)kidPagesCount->GetValue();
+		ioKid.mIsPagesNode = true;
+	}
+	else if(scPage == objectType->GetValue())
+	{
+		ioKid.mPagesCount = 1;
+		ioKid.mIsPagesNode = false;
+	}
+	else
+	{
+		TRACE_LOG1("PDFParser::ResolvePageTreeKid, unexpected object type. should be either Page or Pages, found %s",objectType->GetValue().substr(0, MAX_TRACE_SIZE - 200).c_str());
+		return eFailure;
+	}
+
+	ioKid.mIsResolved = true;
+	return eSuccess;
 }
 
 
@@ -953,12 +1713,13 @@ PDFDictionary* PDFParser::ParsePage(unsigned long inPageIndex)
 	if(mPagesCount <= inPageIndex)
 		return NULL;
 
-	if (mPagesObjectIDs[inPageIndex] == 0) {
+	ObjectIDType pageObjectID = GetPageObjectID(inPageIndex);
+	if (pageObjectID == 0) {
 		TRACE_LOG1("PDFParser::ParsePage, page marked as null at index %ld", inPageIndex);
 		return NULL;
 	}
 
-	PDFObjectCastPtr<PDFDictionary> pageObject(ParseNewObject(mPagesObjectIDs[inPageIndex]));
+	PDFObjectCastPtr<PDFDictionary> pageObject(ParseNewObject(pageObjectID));
 
 	if(!pageObject)
 	{
@@ -981,6 +1742,13 @@ PDFDictionary* PDFParser::ParsePage(unsigned long inPageIndex)
 }
 
 PDFObject* PDFParser::QueryDictionaryObject(PDFDictionary* inDictionary,const std::string& inName)
+{
+	PDFNameAtom key = PDFNameAtoms::Find(inName);
+
+	return key ? QueryDictionaryObject(inDictionary,key) : NULL;
+}
+
+PDFObject* PDFParser::QueryDictionaryObject(PDFDictionary* inDictionary,PDFNameAtom inName)
 {
 	RefCountPtr<PDFObject> anObject(inDictionary->QueryDirectObject(inName));
 
@@ -1030,14 +1798,15 @@ EStatusCode PDFParser::ParsePreviousXrefs(PDFDictionary* inTrailer)
 
 	EStatusCode status;
 
-	XrefEntryInput* aTable = new XrefEntryInput[mXrefSize];
+	// the section is read to a table of its own, which is then merged over older sections. the table is sparse,
+	// so this costs in proportion to the section size, not the whole table size
+	ParsedXrefTable aTable;
+	aTable.Reset(mXrefTable->GetSize(),GetStreamSize());
 	do
 	{
 		PDFDictionary* trailerP = NULL;
 
-        XrefEntryInput* extendedTable = NULL;
-        ObjectIDType extendedTableSize;
-		status = ParseDirectory(previousPosition->GetValue(),aTable,mXrefSize,&trailerP,&extendedTable,&extendedTableSize);
+		status = ParseDirectory(previousPosition->GetValue(),aTable,&trailerP);
 		if(status != PDFHummus::eSuccess)
 			break;
 		RefCountPtr<PDFDictionary> trailer(trailerP);
@@ -1049,31 +1818,16 @@ EStatusCode PDFParser::ParsePreviousXrefs(PDFDictionary* inTrailer)
 				break;
 		}
 
-
-        // Table may have been extended, in which case replace the pointer and current size
-        ObjectIDType newTableSize;
-        if(extendedTable)
-        {
-            newTableSize = extendedTableSize;
-            delete[] aTable;
-            aTable = extendedTable;
-        }
-        else
-            newTableSize = mXrefSize;
-        MergeXrefWithMainXref(aTable,newTableSize);
+		mXrefTable->Merge(aTable);
 	}
 	while(false);
 
-	delete[] aTable;
 	return status;
 }
 
 EStatusCode PDFParser::ParseDirectory(LongFilePositionType inXrefPosition,
-									  XrefEntryInput* inXrefTable,
-									  ObjectIDType inXrefSize,
-									  PDFDictionary** outTrailer,
-                                      XrefEntryInput** outExtendedTable,
-                                      ObjectIDType* outExtendedTableSize)
+									  ParsedXrefTable& ioXrefTable,
+									  PDFDictionary** outTrailer)
 {
 	EStatusCode status = PDFHummus::eSuccess;
 
@@ -1095,19 +1849,13 @@ EStatusCode PDFParser::ParseDirectory(LongFilePositionType inXrefPosition,
 			// i already have a limit of Xrefsize (which is determined by the main trailer Size entry)
 			// so i don't have to parse the trailer in advance, but rather just read the file in the natural order:
 			// first - the xref then the trailer.
-			status = ParseXrefFromXrefTable(inXrefTable,inXrefSize,inXrefPosition,outExtendedTable,outExtendedTableSize);
+			status = ParseXrefFromXrefTable(ioXrefTable,inXrefPosition);
 			if(status != PDFHummus::eSuccess)
 			{
 				TRACE_LOG1("PDFParser::ParseDirectory, failed to parse xref table in %ld",inXrefPosition);
 				break;
 			}
 
-            if(*outExtendedTable)
-            {
-                inXrefTable = *outExtendedTable;
-                inXrefSize = *outExtendedTableSize;
-            }
-
 			// at this point we should be after the token of the "trailer"
 			PDFObjectCastPtr<PDFDictionary> trailerDictionary(mObjectParser.ParseNewObject());
 			if(!trailerDictionary)
@@ -1122,7 +1870,7 @@ EStatusCode PDFParser::ParseDirectory(LongFilePositionType inXrefPosition,
 			if(xrefStmReference.GetPtr())
 			{
 				// if exists, merge update xref
-				status = ParseXrefFromXrefStream(inXrefTable,inXrefSize,xrefStmReference->GetValue(),outExtendedTable,outExtendedTableSize);
+				status = ParseXrefFromXrefStream(ioXrefTable,xrefStmReference->GetValue());
 				if(status != PDFHummus::eSuccess)
 				{
 					TRACE_LOG("PDFParser::ParseDirectory, failure to parse xref in hybrid mode");
@@ -1177,7 +1925,7 @@ EStatusCode PDFParser::ParseDirectory(LongFilePositionType inXrefPosition,
 
 			*outTrailer = xrefStream->QueryStreamDictionary();
 
-			status = ParseXrefFromXrefStream(inXrefTable,inXrefSize,xrefStream.GetPtr(),outExtendedTable,outExtendedTableSize);
+			status = ParseXrefFromXrefStream(ioXrefTable,xrefStream.GetPtr());
 			if(status != PDFHummus::eSuccess)
 				break;
 		}
@@ -1190,23 +1938,6 @@ EStatusCode PDFParser::ParseDirectory(LongFilePositionType inXrefPosition,
 	return status;
 }
 
-void PDFParser::MergeXrefWithMainXref(XrefEntryInput* inTableToMerge,ObjectIDType inMergedTableSize)
-{
-    if(inMergedTableSize > mXrefSize)
-    {
-        XrefEntryInput* newTable = ExtendXrefTableToSize(mXrefTable, mXrefSize, inMergedTableSize);
-        mXrefSize = inMergedTableSize;
-        delete[] mXrefTable;
-        mXrefTable = newTable;
-    }
-
-	for(ObjectIDType i = 0; i < mXrefSize; ++i)
-	{
-		if(inTableToMerge[i].mType != eXrefEntryUndefined)
-			mXrefTable[i] =	inTableToMerge[i];
-	}
-}
-
 
 EStatusCode PDFParser::ParseFileDirectory()
 {
@@ -1313,10 +2044,8 @@ EStatusCode PDFParser::BuildXrefTableAndTrailerFromXrefStream(long long inXrefSt
 
 		RefCountPtr<PDFDictionary> xrefDictionary(xrefStream->QueryStreamDictionary());
 		mTrailer = xrefDictionary;
-
-		status = DetermineXrefSize();
-		if(status != PDFHummus::eSuccess)
-			break;
+		mTrailerPosition = mLastXrefPosition;
+		mTrailerIsXrefStream = true;
 
 		status = InitializeXref();
 		if(status != PDFHummus::eSuccess)
@@ -1329,31 +2058,18 @@ EStatusCode PDFParser::BuildXrefTableAndTrailerFromXrefStream(long long inXrefSt
 				break;
 		}
 
-        XrefEntryInput* extendedTable = NULL;
-        ObjectIDType extendedTableSize;
-		status = ParseXrefFromXrefStream(mXrefTable,mXrefSize,xrefStream.GetPtr(),&extendedTable,&extendedTableSize);
+		status = ParseXrefFromXrefStream(*mXrefTable,xrefStream.GetPtr());
 		if(status != PDFHummus::eSuccess)
 			break;
 
-        // Table may have been extended, in which case replace the pointer and current size
-        if(extendedTable)
-        {
-            mXrefSize = extendedTableSize;
-            delete[] mXrefTable;
-            mXrefTable = extendedTable;
-        }
-
 	}while(false);
 
 	return status;
 
 }
 
-EStatusCode PDFParser::ParseXrefFromXrefStream(XrefEntryInput* inXrefTable,
-                                               ObjectIDType inXrefSize,
-                                               LongFilePositionType inXrefPosition,
-                                               XrefEntryInput** outExtendedTable,
-                                               ObjectIDType* outExtendedTableSize)
+EStatusCode PDFParser::ParseXrefFromXrefStream(ParsedXrefTable& ioXrefTable,
+                                               LongFilePositionType inXrefPosition)
 {
 	EStatusCode status = PDFHummus::eSuccess;
 
@@ -1408,16 +2124,13 @@ EStatusCode PDFParser::ParseXrefFromXrefStream(XrefEntryInput* inXrefTable,
 
 		NotifyIndirectObjectEnd(xrefStream.GetPtr());
 
-		status = ParseXrefFromXrefStream(inXrefTable,inXrefSize,xrefStream.GetPtr(),outExtendedTable,outExtendedTableSize);
+		status = ParseXrefFromXrefStream(ioXrefTable,xrefStream.GetPtr());
 	}while(false);
 	return status;
 }
 
-EStatusCode PDFParser::ParseXrefFromXrefStream(XrefEntryInput* inXrefTable,
-                                               ObjectIDType inXrefSize,
-                                               PDFStreamInput* inXrefStream,
-                                               XrefEntryInput** outExtendedTable,
-                                               ObjectIDType* outExtendedTableSize)
+EStatusCode PDFParser::ParseXrefFromXrefStream(ParsedXrefTable& ioXrefTable,
+                                               PDFStreamInput* inXrefStream)
 {
 	// 1. Setup the stream to read from the stream start location
 	// 2. Set it up with an input stream to decode if required
@@ -1427,8 +2140,6 @@ EStatusCode PDFParser::ParseXrefFromXrefStream(XrefEntryInput* inXrefTable,
 
 	EStatusCode status = PDFHummus::eSuccess;
 
-    outExtendedTable = NULL;
-
 	IByteReader* xrefStreamSource = CreateInputStreamReader(inXrefStream);
 	int* widthsArray = NULL;
 
@@ -1482,21 +2193,14 @@ EStatusCode PDFParser::ParseXrefFromXrefStream(XrefEntryInput* inXrefTable,
 
             // if reading objects past expected range interesting consult policy
             ObjectIDType readXrefSize = (ObjectIDType)xrefSize->GetValue();
-            if(readXrefSize > inXrefSize)
+            if(readXrefSize > ioXrefTable.GetSize())
             {
                 if(mAllowExtendingSegments)
-                {
-                    inXrefTable = ExtendXrefTableToSize(inXrefTable,inXrefSize,readXrefSize);
-                    inXrefSize = readXrefSize;
-                    if(*outExtendedTable)
-                        delete[] *outExtendedTable;
-                    *outExtendedTable = inXrefTable;
-                    *outExtendedTableSize = readXrefSize;
-                }
+                    ioXrefTable.ExtendToSize(readXrefSize);
                 else
                     break;
             }
-			status = ReadXrefStreamSegment(inXrefTable,0,readXrefSize,xrefStreamSource,widthsArray,wArray->GetLength());
+			status = ReadXrefStreamSegment(ioXrefTable,0,readXrefSize,xrefStreamSource,widthsArray,wArray->GetLength());
 		}
 		else
 		{
@@ -1528,21 +2232,14 @@ EStatusCode PDFParser::ParseXrefFromXrefStream(XrefEntryInput* inXrefTable,
 				}
 				ObjectIDType objectsCount = (ObjectIDType)segmentValue->GetValue();
 				// if reading objects past expected range interesting consult policy
-				if(startObject +  objectsCount > inXrefSize)
+				if(startObject +  objectsCount > ioXrefTable.GetSize())
                 {
                     if(mAllowExtendingSegments)
-                    {
-                        inXrefTable = ExtendXrefTableToSize(inXrefTable,inXrefSize,startObject +  objectsCount);
-                        inXrefSize = startObject +  objectsCount;
-                        if(*outExtendedTable)
-                            delete[] *outExtendedTable;
-                        *outExtendedTable = inXrefTable;
-                        *outExtendedTableSize = startObject +  objectsCount;
-                    }
+                        ioXrefTable.ExtendToSize(startObject +  objectsCount);
                     else
                         break;
                 }
-				status = ReadXrefStreamSegment(inXrefTable,startObject,std::min<ObjectIDType>(objectsCount,inXrefSize - startObject),xrefStreamSource,widthsArray,wArray->GetLength());
+				status = ReadXrefStreamSegment(ioXrefTable,startObject,std::min<ObjectIDType>(objectsCount,ioXrefTable.GetSize() - startObject),xrefStreamSource,widthsArray,wArray->GetLength());
 			}
 		}
 	}while(false);
@@ -1558,7 +2255,16 @@ void PDFParser::MovePositionInStream(LongFilePositionType inPosition)
 	mObjectParser.ResetReadState();
 }
 
-EStatusCode PDFParser::ReadXrefStreamSegment(XrefEntryInput* inXrefTable,
+#define XREF_STREAM_READ_BATCH_SIZE 4096
+static unsigned long long ReadXrefSegmentValue(const Byte* inBuffer,int inEntrySize)
+{
+	unsigned long long value = 0;
+	for(int i=0;i<inEntrySize;++i)
+		value = (value<<8) + inBuffer[i];
+	return value;
+}
+
+EStatusCode PDFParser::ReadXrefStreamSegment(ParsedXrefTable& ioXrefTable,
 											 ObjectIDType inSegmentStartObject,
 											 ObjectIDType inSegmentCount,
 											 IByteReader* inReadFrom,
@@ -1572,75 +2278,88 @@ EStatusCode PDFParser::ReadXrefStreamSegment(XrefEntryInput* inXrefTable,
 		TRACE_LOG("PDFParser::ReadXrefStreamSegment, can handle only 3 length entries");
 		return PDFHummus::eFailure;
 	}
+	if(inEntryWidths[0] < 0 || inEntryWidths[1] < 0 || inEntryWidths[2] < 0 || inEntryWidths[0] + inEntryWidths[1] + inEntryWidths[2] == 0)
+	{
+		TRACE_LOG("PDFParser::ReadXrefStreamSegment, bad entry widths");
+		return PDFHummus::eFailure;
+	}
+
+	// read entries in batches, rather than a byte at a time. never read past the segment, as the next segment follows
+	size_t entrySize = inEntryWidths[0] + inEntryWidths[1] + inEntryWidths[2];
+	ObjectIDType batchMaxEntries = XREF_STREAM_READ_BATCH_SIZE;
+	std::vector<Byte> entriesBuffer(entrySize*batchMaxEntries + 1);
 
 	// Note - i'm also checking that the stream is not ended. in non-finite segments, it could be that the particular
 	// stream does no define all objects...just the "updated" ones
-	for(; (objectToRead < inSegmentStartObject + inSegmentCount) && PDFHummus::eSuccess == status && inReadFrom->NotEnded();++objectToRead)
+	while((objectToRead < inSegmentStartObject + inSegmentCount) && PDFHummus::eSuccess == status && inReadFrom->NotEnded())
 	{
-		long long entryType;
-		status = ReadXrefSegmentValue(inReadFrom,inEntryWidths[0],entryType);
-		if(status != PDFHummus::eSuccess)
-			break;
-		status = ReadXrefSegmentValue(inReadFrom,inEntryWidths[1],inXrefTable[objectToRead].mObjectPosition);
-		if(status != PDFHummus::eSuccess)
-			break;
-		status = ReadXrefSegmentValue(inReadFrom,inEntryWidths[2],inXrefTable[objectToRead].mRivision);
-		if(status != PDFHummus::eSuccess)
-			break;
-
-		if(0 == entryType)
-		{
-			inXrefTable[objectToRead].mType = eXrefEntryDelete;
-		}
-		else if (1 == entryType)
-		{
-			inXrefTable[objectToRead].mType = eXrefEntryExisting;
-		}
-		else if(2 == entryType)
+		ObjectIDType batchEntries = std::min<ObjectIDType>(batchMaxEntries,inSegmentStartObject + inSegmentCount - objectToRead);
+		size_t batchSize = batchEntries * entrySize;
+		size_t readSize = 0;
+		while(readSize < batchSize)
 		{
-			inXrefTable[objectToRead].mType = eXrefEntryStreamObject;
+			size_t readNow = inReadFrom->Read(&entriesBuffer[readSize],batchSize - readSize);
+			if(0 == readNow)
+				break;
+			readSize += readNow;
 		}
-		else
+		// a partial entry at the end is a failure, same as a partial read of it
+		if(readSize % entrySize != 0)
 		{
-			TRACE_LOG("PDFParser::ReadXrefStreamSegment, unfamiliar entry type. must be either 0,1 or 2");
+			TRACE_LOG("PDFParser::ReadXrefStreamSegment, xref stream ended in the middle of an entry");
 			status = PDFHummus::eFailure;
+			break;
 		}
-	}
-	return status;
-}
 
-EStatusCode PDFParser::ReadXrefSegmentValue(IByteReader* inSource,int inEntrySize,long long& outValue)
-{
-	outValue = 0;
-	Byte buffer;
-	EStatusCode status = PDFHummus::eSuccess;
+		const Byte* entry = &entriesBuffer[0];
+		for(ObjectIDType i=0; i < readSize / entrySize; ++i, ++objectToRead, entry += entrySize)
+		{
+			unsigned long long entryType = ReadXrefSegmentValue(entry,inEntryWidths[0]);
+			LongFilePositionType objectPosition = (LongFilePositionType)ReadXrefSegmentValue(entry + inEntryWidths[0],inEntryWidths[1]);
+			unsigned long revision = (unsigned long)ReadXrefSegmentValue(entry + inEntryWidths[0] + inEntryWidths[1],inEntryWidths[2]);
 
-	for(int i=0;i<inEntrySize && PDFHummus::eSuccess == status;++i)
-	{
-		status = (inSource->Read(&buffer,1) == 1 ? PDFHummus::eSuccess : PDFHummus::eFailure);
-		if(status != PDFHummus::eFailure)
-			outValue = (outValue<<8) + buffer;
+			if(0 == entryType)
+			{
+				ioXrefTable.SetEntry(objectToRead,objectPosition,revision,eXrefEntryDelete);
+			}
+			else if (1 == entryType)
+			{
+				ioXrefTable.SetEntry(objectToRead,objectPosition,revision,eXrefEntryExisting);
+			}
+			else if(2 == entryType)
+			{
+				ioXrefTable.SetEntry(objectToRead,objectPosition,revision,eXrefEntryStreamObject);
+			}
+			else
+			{
+				TRACE_LOG("PDFParser::ReadXrefStreamSegment, unfamiliar entry type. must be either 0,1 or 2");
+				status = PDFHummus::eFailure;
+				break;
+			}
+		}
+		if(readSize < batchSize)
+			break;
 	}
 	return status;
 }
 
-EStatusCode PDFParser::ReadXrefSegmentValue(IByteReader* inSource,int inEntrySize,ObjectIDType& outValue)
+PDFObject* PDFParser::ParseExistingInDirectStreamObject(ObjectIDType inObjectId)
 {
-	outValue = 0;
-	Byte buffer;
-	EStatusCode status = PDFHummus::eSuccess;
-
-	for(int i=0;i<inEntrySize && PDFHummus::eSuccess == status;++i)
+	// with flate checkpoints, object streams that are not kept decoded are decoded from the checkpoint nearest to the object
+	if(mFlateCheckpointsInterval > 0 &&
+		(0 == mDecodedObjectStreams.GetBudget() ||
+		mOversizedObjectStreams.find((ObjectIDType)mXrefTable->GetPosition(inObjectId)) != mOversizedObjectStreams.end()))
 	{
-		status = (inSource->Read(&buffer,1) == 1 ? PDFHummus::eSuccess : PDFHummus::eFailure);
-		if(status != PDFHummus::eFailure)
-			outValue = (outValue<<8) + buffer;
+		bool indexable;
+		PDFObject* anIndexedObject = ParseExistingInDirectStreamObjectFromIndexedStream(inObjectId,indexable);
+		if(indexable)
+			return anIndexedObject;
 	}
-	return status;
-}
 
-PDFObject* PDFParser::ParseExistingInDirectStreamObject(ObjectIDType inObjectId)
-{
+	// when there's a budget for decoded object streams, decode the object stream once and parse its objects from memory
+	if(mDecodedObjectStreams.GetBudget() > 0)
+		return ParseExistingInDirectStreamObjectFromDecodedStream(inObjectId);
+
 	// parsing an object in an object stream requires the following:
 	// 1. Setting the position to this object stream
 	// 2. Reading the stream First and N. store.
@@ -1659,12 +2378,12 @@ PDFObject* PDFParser::ParseExistingInDirectStreamObject(ObjectIDType inObjectId)
 
 	do
 	{
-		objectStreamID = (ObjectIDType)mXrefTable[inObjectId].mObjectPosition;
+		objectStreamID = (ObjectIDType)mXrefTable->GetPosition(inObjectId);
 		PDFObjectCastPtr<PDFStreamInput> objectStream(ParseNewObject(objectStreamID));
 		if(!objectStream)
 		{
 			TRACE_LOG2("PDFParser::ParseExistingInDirectStreamObject, failed to parse object %ld. failed to find object stream for it, which should be %ld",
-						inObjectId,mXrefTable[inObjectId].mObjectPosition);
+						inObjectId,mXrefTable->GetPosition(inObjectId));
 			status = PDFHummus::eFailure;
 			break;
 		}
@@ -1706,26 +2425,36 @@ PDFObject* PDFParser::ParseExistingInDirectStreamObject(ObjectIDType inObjectId)
 				break;
 			}
 			it = mObjectStreamsCache.insert(ObjectIDTypeToObjectStreamHeaderEntryMap::value_type(objectStreamID,objectStreamHeader)).first;
+			RecordObjectStreamHeader(objectStreamID,objectStreamHeader,objectsCount);
 		}
 		objectStreamHeader = it->second;
 
 		// verify that i got the right object ID
-		if(objectsCount <= mXrefTable[inObjectId].mRivision || objectStreamHeader[mXrefTable[inObjectId].mRivision].mObjectNumber != inObjectId)
+		if(objectsCount <= mXrefTable->GetRevision(inObjectId) || objectStreamHeader[mXrefTable->GetRevision(inObjectId)].mObjectNumber != inObjectId)
 		{
 			TRACE_LOG2("PDFParser::ParseXrefFromXrefStream, wrong object. expecting to find object ID %ld, and found %ld",
 						inObjectId,
-						objectsCount <= mXrefTable[inObjectId].mRivision ?
+						objectsCount <= mXrefTable->GetRevision(inObjectId) ?
 							-1 :
-							objectStreamHeader[mXrefTable[inObjectId].mRivision].mObjectNumber);
+							objectStreamHeader[mXrefTable->GetRevision(inObjectId)].mObjectNumber);
 			status = PDFHummus::eFailure;
 			break;
 		}
 
 		// when parsing the header, should be at position already..so don't skip if already there [using GetCurrentPosition to see if parsed some]
-		if(mXrefTable[inObjectId].mRivision != 0 || skipperStream.GetCurrentPosition() == 0)
+		if(mXrefTable->GetRevision(inObjectId) != 0 || skipperStream.GetCurrentPosition() == 0)
 		{
-			LongFilePositionType objectPositionInStream = objectStreamHeader[mXrefTable[inObjectId].mRivision].mObjectOffset +
+			LongFilePositionType objectPositionInStream = objectStreamHeader[mXrefTable->GetRevision(inObjectId)].mObjectOffset +
 														  firstStreamObjectPosition->GetValue();
+			if(!skipperStream.CanSkipTo(objectPositionInStream))
+			{
+				// reading the header may look ahead beyond a short first object, so restart the stream to get back to it
+				skipperStream.Assign(NULL);
+				delete objectSource;
+				objectSource = CreateInputStreamReader(objectStream.GetPtr());
+				skipperStream.Assign(objectSource);
+				MovePositionInStream(objectStream->GetStreamContentStart());
+			}
 			skipperStream.SkipTo(objectPositionInStream);
 			mObjectParser.ResetReadState();
 		}
@@ -1743,6 +2472,272 @@ PDFObject* PDFParser::ParseExistingInDirectStreamObject(ObjectIDType inObjectId)
 	return anObject;
 }
 
+PDFObject* PDFParser::ParseExistingInDirectStreamObjectFromDecodedStream(ObjectIDType inObjectId)
+{
+	// same as ParseExistingInDirectStreamObject, only the object stream is decoded in full once, and kept
+	// in the decoded streams cache. objects are then parsed directly from the decoded bytes, jumping right to their position
+
+	EStatusCode status = PDFHummus::eSuccess;
+	ObjectIDType objectStreamID = (ObjectIDType)mXrefTable->GetPosition(inObjectId);
+	ObjectStreamHeaderEntry* objectStreamHeader;
+	PDFObject* anObject = NULL;
+	bool ownsDecodedStream = false;
+
+	DecodedObjectStream* decodedStream = mDecodedObjectStreams.Find(objectStreamID);
+	if(!decodedStream)
+	{
+		decodedStream = DecodeObjectStream(objectStreamID);
+		if(!decodedStream)
+			return NULL;
+		// if too large to be cached, use just for this object. with flate checkpoints, its next objects will be decoded from checkpoints
+		ownsDecodedStream = !mDecodedObjectStreams.Insert(objectStreamID,decodedStream);
+		if(ownsDecodedStream && mFlateCheckpointsInterval > 0)
+			mOversizedObjectStreams.insert(objectStreamID);
+	}
+
+	InputByteArrayStream decodedStreamReader(decodedStream->mData.size() > 0 ? &(decodedStream->mData[0]) : NULL,decodedStream->mData.size());
+	AdapterIByteReaderWithPositionToIReadPositionProvider decodedStreamPositionProvider(&decodedStreamReader);
+	mObjectParser.SetReadStream(&decodedStreamReader,&decodedStreamPositionProvider);
+
+	do
+	{
+		ObjectIDTypeToObjectStreamHeaderEntryMap::iterator it = mObjectStreamsCache.find(objectStreamID);
+
+		if(it == mObjectStreamsCache.end())
+		{
+			objectStreamHeader = new ObjectStreamHeaderEntry[decodedStream->mObjectsCount];
+			status = ParseObjectStreamHeader(objectStreamHeader,decodedStream->mObjectsCount);
+			if(status != PDFHummus::eSuccess)
+			{
+				delete[] objectStreamHeader;
+				break;
+			}
+			it = mObjectStreamsCache.insert(ObjectIDTypeToObjectStreamHeaderEntryMap::value_type(objectStreamID,objectStreamHeader)).first;
+			RecordObjectStreamHeader(objectStreamID,objectStreamHeader,decodedStream->mObjectsCount);
+		}
+		objectStreamHeader = it->second;
+
+		// verify that i got the right object ID
+		if(decodedStream->mObjectsCount <= mXrefTable->GetRevision(inObjectId) || objectStreamHeader[mXrefTable->GetRevision(inObjectId)].mObjectNumber != inObjectId)
+		{
+			TRACE_LOG2("PDFParser::ParseExistingInDirectStreamObjectFromDecodedStream, wrong object. expecting to find object ID %ld, and found %ld",
+						inObjectId,
+						decodedStream->mObjectsCount <= mXrefTable->GetRevision(inObjectId) ?
+							-1 :
+							objectStreamHeader[mXrefTable->GetRevision(inObjectId)].mObjectNumber);
+			status = PDFHummus::eFailure;
+			break;
+		}
+
+		decodedStreamReader.SetPosition(objectStreamHeader[mXrefTable->GetRevision(inObjectId)].mObjectOffset + decodedStream->mFirstObjectPosition);
+		mObjectParser.ResetReadState();
+
+		mDecryptionHelper.PauseDecryption(); // objects within objects stream already enjoy the object stream protection, and so are no longer encrypted
+		NotifyIndirectObjectStart(inObjectId,0);
+		anObject = mObjectParser.ParseNewObject();
+		NotifyIndirectObjectEnd(anObject);
+		mDecryptionHelper.ReleaseDecryption();
+	}while(false);
+
+	mObjectParser.SetReadStream(mStream,&mCurrentPositionProvider);
+	if(ownsDecodedStream)
+		delete decodedStream;
+
+	return anObject;
+}
+
+PDFObject* PDFParser::ParseExistingInDirectStreamObjectFromIndexedStream(ObjectIDType inObjectId,bool& outIndexable)
+{
+	// same as ParseExistingInDirectStreamObject, only the object stream is decoded with InputFlateDecodeSeekableStream, that records
+	// checkpoints in an index kept per object stream. reaching an object then decodes from the nearest checkpoint before it.
+	// only for plain flate streams of non encrypted files. outIndexable is false for others, for the caller to use the other methods
+
+	EStatusCode status = PDFHummus::eSuccess;
+	ObjectIDType objectStreamID = (ObjectIDType)mXrefTable->GetPosition(inObjectId);
+	ObjectStreamHeaderEntry* objectStreamHeader;
+	PDFObject* anObject = NULL;
+
+	outIndexable = false;
+	ObjectIDTypeToFlateDecodeIndexMap::iterator itIndex = mFlateDecodeIndexes.find(objectStreamID);
+	if(itIndex != mFlateDecodeIndexes.end() && !itIndex->second)
+		return NULL;
+
+	PDFObjectCastPtr<PDFStreamInput> objectStream(ParseNewObject(objectStreamID));
+	if(!objectStream)
+		return NULL;
+
+	RefCountPtr<PDFDictionary> streamDictionary(objectStream->QueryStreamDictionary());
+	LongBufferSizeType encodedLength;
+	bool plainFlateStream = IsPlainFlateStream(streamDictionary.GetPtr(),encodedLength);
+	if(itIndex == mFlateDecodeIndexes.end())
+		itIndex = mFlateDecodeIndexes.insert(ObjectIDTypeToFlateDecodeIndexMap::value_type(objectStreamID,
+							plainFlateStream ? new FlateDecodeIndex(mFlateCheckpointsInterval) : NULL)).first;
+	if(!plainFlateStream)
+		return NULL;
+
+	PDFObjectCastPtr<PDFInteger> streamObjectsCount(QueryDictionaryObject(streamDictionary.GetPtr(),"N"));
+	PDFObjectCastPtr<PDFInteger> firstStreamObjectPosition(QueryDictionaryObject(streamDictionary.GetPtr(),"First"));
+	if(!streamObjectsCount || !firstStreamObjectPosition)
+		return NULL;
+	ObjectIDType objectsCount = (ObjectIDType)streamObjectsCount->GetValue();
+	outIndexable = true;
+
+	InputFlateDecodeSeekableStream decodedStreamReader(mStream,objectStream->GetStreamContentStart(),encodedLength,itIndex->second);
+	AdapterIByteReaderWithPositionToIReadPositionProvider decodedStreamPositionProvider(&decodedStreamReader);
+	mObjectParser.SetReadStream(&decodedStreamReader,&decodedStreamPositionProvider);
+
+	do
+	{
+		ObjectIDTypeToObjectStreamHeaderEntryMap::iterator it = mObjectStreamsCache.find(objectStreamID);
+
+		if(it == mObjectStreamsCache.end())
+		{
+			objectStreamHeader = new ObjectStreamHeaderEntry[objectsCount];
+			status = ParseObjectStreamHeader(objectStreamHeader,objectsCount);
+			if(status != PDFHummus::eSuccess)
+			{
+				delete[] objectStreamHeader;
+				break;
+			}
+			it = mObjectStreamsCache.insert(ObjectIDTypeToObjectStreamHeaderEntryMap::value_type(objectStreamID,objectStreamHeader)).first;
+			RecordObjectStreamHeader(objectStreamID,objectStreamHeader,objectsCount);
+		}
+		objectStreamHeader = it->second;
+
+		// verify that i got the right object ID
+		if(objectsCount <= mXrefTable->GetRevision(inObjectId) || objectStreamHeader[mXrefTable->GetRevision(inObjectId)].mObjectNumber != inObjectId)
+		{
+			TRACE_LOG2("PDFParser::ParseExistingInDirectStreamObjectFromIndexedStream, wrong object. expecting to find object ID %ld, and found %ld",
+						inObjectId,
+						objectsCount <= mXrefTable->GetRevision(inObjectId) ?
+							-1 :
+							objectStreamHeader[mXrefTable->GetRevision(inObjectId)].mObjectNumber);
+			status = PDFHummus::eFailure;
+			break;
+		}
+
+		decodedStreamReader.SetPosition(objectStreamHeader[mXrefTable->GetRevision(inObjectId)].mObjectOffset + firstStreamObjectPosition->GetValue());
+		mObjectParser.ResetReadState();
+
+		mDecryptionHelper.PauseDecryption(); // objects within objects stream already enjoy the object stream protection, and so are no longer encrypted
+		NotifyIndirectObjectStart(inObjectId,0);
+		anObject = mObjectParser.ParseNewObject();
+		NotifyIndirectObjectEnd(anObject);
+		mDecryptionHelper.ReleaseDecryption();
+	}while(false);
+
+	mObjectParser.SetReadStream(mStream,&mCurrentPositionProvider);
+
+	return anObject;
+}
+
+DecodedObjectStream* PDFParser::DecodeObjectStream(ObjectIDType inObjectStreamID)
+{
+	DecodedObjectStream* decodedStream = NULL;
+	IByteReader* objectSource = NULL;
+
+	do
+	{
+		PDFObjectCastPtr<PDFStreamInput> objectStream(ParseNewObject(inObjectStreamID));
+		if(!objectStream)
+		{
+			TRACE_LOG1("PDFParser::DecodeObjectStream, failed to parse object stream %ld",inObjectStreamID);
+			break;
+		}
+
+		RefCountPtr<PDFDictionary> streamDictionary(objectStream->QueryStreamDictionary());
+
+		PDFObjectCastPtr<PDFInteger> streamObjectsCount(QueryDictionaryObject(streamDictionary.GetPtr(),"N"));
+		if(!streamObjectsCount)
+		{
+			TRACE_LOG1("PDFParser::DecodeObjectStream, no N key in stream dictionary %ld",inObjectStreamID);
+			break;
+		}
+
+		PDFObjectCastPtr<PDFInteger> firstStreamObjectPosition(QueryDictionaryObject(streamDictionary.GetPtr(),"First"));
+		if(!firstStreamObjectPosition)
+		{
+			TRACE_LOG1("PDFParser::DecodeObjectStream, no First key in stream dictionary %ld",inObjectStreamID);
+			break;
+		}
+
+		decodedStream = new DecodedObjectStream();
+		decodedStream->mObjectsCount = (ObjectIDType)streamObjectsCount->GetValue();
+		decodedStream->mFirstObjectPosition = firstStreamObjectPosition->GetValue();
+
+		if(DecodeFlateStreamInPlace(objectStream.GetPtr(),streamDictionary.GetPtr(),decodedStream->mData))
+			break;
+
+		objectSource = StartReadingFromStream(objectStream.GetPtr());
+		if(!objectSource)
+		{
+			TRACE_LOG1("PDFParser::DecodeObjectStream, failed to create reader for object stream %ld",inObjectStreamID);
+			delete decodedStream;
+			decodedStream = NULL;
+			break;
+		}
+
+		Byte buffer[LINE_BUFFER_SIZE*16];
+		while(objectSource->NotEnded())
+		{
+			LongBufferSizeType readAmount = objectSource->Read(buffer,LINE_BUFFER_SIZE*16);
+			if(0 == readAmount)
+				break;
+			decodedStream->mData.insert(decodedStream->mData.end(),buffer,buffer + readAmount);
+		}
+	}while(false);
+
+	delete objectSource;
+	return decodedStream;
+}
+
+// stream dictionary keys and filter names, interned once as they're looked up for every stream read
+static const PDFNameAtom scLengthKey = PDFNameAtoms::Intern("Length");
+static const PDFNameAtom scFilterKey = PDFNameAtoms::Intern("Filter");
+static const PDFNameAtom scDecodeParmsKey = PDFNameAtoms::Intern("DecodeParms");
+static const PDFNameAtom scFlateDecodeName = PDFNameAtoms::Intern("FlateDecode");
+
+bool PDFParser::IsPlainFlateStream(PDFDictionary* inStreamDictionary,LongBufferSizeType& outLength)
+{
+	// flate with no parameters, in a non encrypted file, with a known length. the stream content can be inflated as is
+	if(IsEncrypted() || inStreamDictionary->Exists(scDecodeParmsKey))
+		return false;
+
+	PDFObjectCastPtr<PDFName> filterName(QueryDictionaryObject(inStreamDictionary,scFilterKey));
+	if(!filterName || filterName->GetAtom() != scFlateDecodeName)
+		return false;
+
+	PDFObjectCastPtr<PDFInteger> lengthObject(QueryDictionaryObject(inStreamDictionary,scLengthKey));
+	if(!lengthObject || lengthObject->GetValue() < 0)
+		return false;
+
+	outLength = (LongBufferSizeType)lengthObject->GetValue();
+	return true;
+}
+
+bool PDFParser::DecodeFlateStreamInPlace(PDFStreamInput* inStream,PDFDictionary* inStreamDictionary,std::vector<IOBasicTypes::Byte>& outDecoded)
+{
+	// only for plain [no parameters] flate streams of non encrypted files, whose source provides direct access to its content. 
+	// these can be inflated straight from the source, with no intermediate copies
+	LongBufferSizeType length;
+	if(!IsPlainFlateStream(inStreamDictionary,length))
+		return false;
+
+	LongBufferSizeType spanSize;
+	mStream->SetPosition(inStream->GetStreamContentStart());
+	const Byte* span = mStream->GetContiguousSpan(spanSize);
+	if(!span || spanSize < length)
+		return false;
+
+	if(InputFlateDecodeStream::DecodeBuffer(span,length,outDecoded) != eSuccess)
+	{
+		// let the regular path try
+		outDecoded.clear();
+		return false;
+	}
+	return true;
+}
+
 void PDFParser::NotifyIndirectObjectStart(long long inObjectID, long long inGenerationNumber) {
 	if (mParserExtender)
 		mParserExtender->OnObjectStart(inObjectID, inGenerationNumber);
@@ -1819,7 +2814,7 @@ IByteReader* PDFParser::CreateInputStreamReader(PDFStreamInput* inStream)
 	{
 
 		// setup stream according to length and possible filter
-		PDFObjectCastPtr<PDFInteger> lengthObject(QueryDictionaryObject(streamDictionary.GetPtr(),"Length"));
+		PDFObjectCastPtr<PDFInteger> lengthObject(QueryDictionaryObject(streamDictionary.GetPtr(),scLengthKey));
 		if(!lengthObject)
 		{
 			TRACE_LOG("PDFParser::CreateInputStreamReader, stream does not have length, failing");
@@ -1831,7 +2826,7 @@ IByteReader* PDFParser::CreateInputStreamReader(PDFStreamInput* inStream)
 
 		result = WrapWithDecryptionFilter(inStream,result);
 
-		RefCountPtr<PDFObject> filterObject(QueryDictionaryObject(streamDictionary.GetPtr(),"Filter"));
+		RefCountPtr<PDFObject> filterObject(QueryDictionaryObject(streamDictionary.GetPtr(),scFilterKey));
 		if(!filterObject)
 		{
 			// no filter, so stop here
@@ -1841,7 +2836,7 @@ IByteReader* PDFParser::CreateInputStreamReader(PDFStreamInput* inStream)
 		if(filterObject->GetType() == PDFObject::ePDFObjectArray)
 		{
 			PDFArray* filterObjectArray = (PDFArray*)filterObject.GetPtr();
-			PDFObjectCastPtr<PDFArray> decodeParams(QueryDictionaryObject(streamDictionary.GetPtr(),"DecodeParms"));
+			PDFObjectCastPtr<PDFArray> decodeParams(QueryDictionaryObject(streamDictionary.GetPtr(),scDecodeParmsKey));
 			for(unsigned long i=0; i < filterObjectArray->GetLength() && eSuccess == status;++i)
 			{
 				PDFObjectCastPtr<PDFName> filterObjectItem(filterObjectArray->QueryObject(i));
@@ -1875,7 +2870,7 @@ IByteReader* PDFParser::CreateInputStreamReader(PDFStreamInput* inStream)
 		}
 		else if(filterObject->GetType() == PDFObject::ePDFObjectName)
 		{
-			PDFObjectCastPtr<PDFDictionary> decodeParams(QueryDictionaryObject(streamDictionary.GetPtr(),"DecodeParms"));
+			PDFObjectCastPtr<PDFDictionary> decodeParams(QueryDictionaryObject(streamDictionary.GetPtr(),scDecodeParmsKey));
 
 			EStatusCodeAndIByteReader createStatus = CreateFilterForStream(result,(PDFName*)filterObject.GetPtr(), !decodeParams ? NULL: decodeParams.GetPtr(), inStream);
 			if(createStatus.first != eSuccess)
@@ -1913,7 +2908,7 @@ EStatusCodeAndIByteReader PDFParser::CreateFilterForStream(IByteReader* inStream
 	do
 	{
 
-		if(inFilterName->GetValue() == "FlateDecode")
+		if(inFilterName->GetAtom() == scFlateDecodeName)
 		{
 			InputFlateDecodeStream* flateStream;
 			flateStream = new InputFlateDecodeStream(NULL); // assigning null, so later delete, if failure occurs won't delete the input stream
@@ -2065,6 +3060,24 @@ PDFObjectParser* PDFParser::StartReadingObjectsFromStreams(PDFArray* inArrayOfSt
 	return objectsParser;
 }
 
+PDFContentStreamReader* PDFParser::StartReadingContentFromStream(PDFStreamInput* inStream) {
+	IByteReader* readStream = StartReadingFromStream(inStream);
+	if(!readStream)
+		return NULL;
+
+	PDFContentStreamReader* contentReader = new PDFContentStreamReader();
+	contentReader->SetReadStream(readStream,true);
+
+	return contentReader;
+}
+
+PDFContentStreamReader* PDFParser::StartReadingContentFromStreams(PDFArray* inArrayOfStreams) {
+	PDFContentStreamReader* contentReader = new PDFContentStreamReader();
+	contentReader->SetReadStream(new ArrayOfInputStreamsStream(inArrayOfStreams,this),true);
+
+	return contentReader;
+}
+
 IByteReader* PDFParser::CreateInputStreamReaderForPlainCopying(PDFStreamInput* inStream) {
 	RefCountPtr<PDFDictionary> streamDictionary(inStream->QueryStreamDictionary());
 	IByteReader* result = NULL;
@@ -2074,7 +3087,7 @@ IByteReader* PDFParser::CreateInputStreamReaderForPlainCopying(PDFStreamInput* i
 	{
 
 		// setup stream according to length and possible filter
-		PDFObjectCastPtr<PDFInteger> lengthObject(QueryDictionaryObject(streamDictionary.GetPtr(), "Length"));
+		PDFObjectCastPtr<PDFInteger> lengthObject(QueryDictionaryObject(streamDictionary.GetPtr(), scLengthKey));
 		if (!lengthObject)
 		{
 			TRACE_LOG("PDFParser::CreateInputStreamReaderForPlainCopying, stream does not have length, failing");
@@ -2119,7 +3132,7 @@ EStatusCode PDFParser::StartStateFileParsing(IByteReaderWithPosition* inSourceSt
 		// initialize reading from end
 		mLastReadPositionFromEnd = 0;
 		mEncounteredFileStart = false;
-		mLastAvailableIndex = mCurrentBufferIndex = mLinesBuffer;
+		mCurrentBufferStart = mLastAvailableIndex = mCurrentBufferIndex = mLinesBuffer;
 
 		status = ParseEOFLine();
 		if(status != PDFHummus::eSuccess)
@@ -2156,12 +3169,12 @@ bool PDFParser::IsEncryptionSupported()
 
 ObjectIDType PDFParser::GetXrefSize()
 {
-    return mXrefSize;
+    return mXrefTable->GetSize();
 }
 
-XrefEntryInput* PDFParser::GetXrefEntry(ObjectIDType inObjectID)
+XrefEntryInput PDFParser::GetXrefEntry(ObjectIDType inObjectID)
 {
-    return (inObjectID < mXrefSize) ? mXrefTable+inObjectID : NULL;
+    return mXrefTable->GetEntry(inObjectID);
 }
 
 LongFilePositionType PDFParser::GetXrefPosition()
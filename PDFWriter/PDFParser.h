@@ -30,8 +30,16 @@
 #include "AdapterIByteReaderWithPositionToIReadPositionProvider.h"
 #include "DecryptionHelper.h"
 #include "PDFParsingOptions.h"
+#include "DecodedObjectStreamsCache.h"
+#include "ParsedObjectsCache.h"
+#include "ParsedXrefTable.h"
+#include "XrefReconstructionScanner.h"
+#include "ParseIndexCache.h"
 
 #include <map>
+#include <memory>
+#include <set>
+#include <vector>
 #include <utility>
 
 class PDFArray;
@@ -39,37 +47,47 @@ class PDFStreamInput;
 class PDFDictionary;
 class PDFName;
 class IPDFParserExtender;
+class InputByteArrayStream;
+class PDFContentStreamReader;
+class FlateDecodeIndex;
 
 typedef std::pair<PDFHummus::EStatusCode,IByteReader*> EStatusCodeAndIByteReader;
 
 #define LINE_BUFFER_SIZE 1024
 
-enum EXrefEntryType
-{
-	eXrefEntryExisting,
-	eXrefEntryDelete,
-	eXrefEntryStreamObject,
-	eXrefEntryUndefined
-};
+typedef std::map<ObjectIDType,ObjectStreamHeaderEntry*> ObjectIDTypeToObjectStreamHeaderEntryMap;
+typedef std::map<ObjectIDType,FlateDecodeIndex*> ObjectIDTypeToFlateDecodeIndexMap;
+typedef std::set<ObjectIDType> ObjectIDTypeSet;
 
-struct XrefEntryInput
+// a kid of a pages tree node, as recorded by lazy pages indexing
+struct PageTreeKid
 {
-	XrefEntryInput(){mObjectPosition = 0;mRivision=0;mType = eXrefEntryUndefined;}
-
-	// well...it's more like...the first number in a pair on an xref, and the second one. the names
-	// are true only for "n" type of entries
-	LongFilePositionType mObjectPosition;
-	unsigned long mRivision;
-	EXrefEntryType mType;	
+	// 0 for null kids [which count as empty pages]
+	ObjectIDType mObjectID;
+	// index of the first page under this kid, relative to the first page of the parent node
+	unsigned long mFirstPageIndex;
+	unsigned long mPagesCount;
+	bool mIsPagesNode;
+	// false till the kid object is parsed. till then its type and pages count are assumed
+	bool mIsResolved;
 };
 
-struct ObjectStreamHeaderEntry
+typedef std::vector<PageTreeKid> PageTreeKidVector;
+
+// a pages tree node, as recorded by lazy pages indexing. kids are resolved [parsed] only as pages are located
+struct PageTreeNode
 {
-	ObjectIDType mObjectNumber;
-	LongFilePositionType mObjectOffset;
+	PageTreeKidVector mKids;
+	// kids are normally resolved in order, up to the one holding the located page, as that's what tells their page
+	// ranges. mResolvedKidsCount is the count of kids resolved so far, and mResolvedPagesCount the pages count under them
+	size_t mResolvedKidsCount;
+	unsigned long mResolvedPagesCount;
+	// when the node pages count equals its kids count [as with flat trees], each kid is assumed to be a single page, and only
+	// the located kid is resolved. if this turns out to be wrong, kids are resolved in order
+	bool mKidsArePages;
 };
 
-typedef std::map<ObjectIDType,ObjectStreamHeaderEntry*> ObjectIDTypeToObjectStreamHeaderEntryMap;
+typedef std::map<ObjectIDType,PageTreeNode> ObjectIDTypeToPageTreeNodeMap;
 
 class PDFParser
 {
@@ -104,6 +122,7 @@ public:
 	// Query a dictinary object, if indirect, go and fetch the indirect object and return it instead
 	// [if you want the direct dictionary value, use PDFDictionary::QueryDirectObject [will AddRef automatically]
 	PDFObject* QueryDictionaryObject(PDFDictionary* inDictionary,const std::string& inName);
+	PDFObject* QueryDictionaryObject(PDFDictionary* inDictionary,PDFNameAtom inName);
 	
 	// Query an array object, if indirect, go and fetch the indirect object and return it instead
 	// [if you want the direct array value, use the PDFArray direct access to the vector [and use AddRef, cause it won't]
@@ -139,6 +158,12 @@ public:
 	// same, but for an array of streams, in case of page contents that are arrays. need to count as one
 	PDFObjectParser* StartReadingObjectsFromStreams(PDFArray* inArrayOfStreams);
 
+	// creates a PDFContentStreamReader for reading the operations of a content stream. much lighter than reading
+	// objects, when only operators and operands are needed [see PDFContentStreamReader]. delete the result when done
+	PDFContentStreamReader* StartReadingContentFromStream(PDFStreamInput* inStream);
+	// same, but for an array of streams, in case of page contents that are arrays. need to count as one
+	PDFContentStreamReader* StartReadingContentFromStreams(PDFArray* inArrayOfStreams);
+
 	/*
 		Same as above, but reading only decrypts, but does not defiler. ideal for copying
 	*/
@@ -160,10 +185,37 @@ public:
 
     // advanced, direct xref access
     ObjectIDType GetXrefSize();
-    XrefEntryInput* GetXrefEntry(ObjectIDType inObjectID);   
+    // returns an undefined entry for objects out of range
+    XrefEntryInput GetXrefEntry(ObjectIDType inObjectID);   
     LongFilePositionType GetXrefPosition();
     
     IByteReaderWithPosition* GetParserStream();
+
+	// parsed objects cache, for statistics [hits, misses etc.] or for changing its budget after parsing started
+	ParsedObjectsCache& GetParsedObjectsCache();
+
+	// the parsed xref, for statistics [e.g. its memory use]
+	const ParsedXrefTable& GetXrefTable();
+
+	/*
+		Concurrent readers. After StartPDFParsing, a parser may serve as the source for cursors - parsers that share its xref
+		[without copying it] and take its trailer position, pages object IDs and password, so starting them costs next to nothing.
+		Each cursor reads the file through its own stream, with its own tokenizer, caches and decryption state, so cursors of the
+		same source may be used on different threads at the same time [one thread per cursor], and alongside the source itself.
+
+		inSourceStream should have the same content as the source parser stream [say, another InputFile on the same file].
+		pass NULL when the source parser stream provides direct access to its content [memory mapped InputFile, byte arrays],
+		and the cursor reads straight from it. inOptions is for the cursor caches [the password is taken from the source].
+		Create cursors on the thread that uses the source parser, and keep the source stream alive while cursors are in use.
+		Not available for files with a reconstructed xref.
+	*/
+	PDFHummus::EStatusCode StartPDFParsingCursor(PDFParser* inSourceParser,
+												IByteReaderWithPosition* inSourceStream = NULL,
+												const PDFParsingOptions& inOptions = PDFParsingOptions::DefaultPDFParsingOptions());
+
+	// true if the xref and trailer were rebuilt by scanning the file [see PDFParsingOptions::ReconstructBrokenXref].
+	// the trailer then holds only Size, Root, and Info, ID and Encrypt if found, and GetXrefPosition returns 0
+	bool IsXrefReconstructed();
     
 private:
 	PDFObjectParser mObjectParser;
@@ -173,72 +225,106 @@ private:
 	
 	// we'll use this items for bacwkards reading. might turns this into a proper stream object
 	IOBasicTypes::Byte mLinesBuffer[LINE_BUFFER_SIZE];
-	IOBasicTypes::Byte* mCurrentBufferIndex;
-	IOBasicTypes::Byte* mLastAvailableIndex;
+	// start of current backwards reading buffer. either mLinesBuffer, or the stream content itself when it provides direct access to it
+	const IOBasicTypes::Byte* mCurrentBufferStart;
+	const IOBasicTypes::Byte* mCurrentBufferIndex;
+	const IOBasicTypes::Byte* mLastAvailableIndex;
 	LongBufferSizeType mLastReadPositionFromEnd;
 	bool mEncounteredFileStart;
 	ObjectIDTypeToObjectStreamHeaderEntryMap mObjectStreamsCache;
+	DecodedObjectStreamsCache mDecodedObjectStreams;
+	ParsedObjectsCache mParsedObjects;
+	// decoding checkpoints of object streams that are not kept decoded [see PDFParsingOptions::FlateCheckpointsInterval].
+	// NULL for object streams that can't be decoded from checkpoints. object streams too large for the decoded streams cache are
+	// marked in mOversizedObjectStreams, to use checkpoints for them instead of decoding them again for each object
+	LongBufferSizeType mFlateCheckpointsInterval;
+	ObjectIDTypeToFlateDecodeIndexMap mFlateDecodeIndexes;
+	ObjectIDTypeSet mOversizedObjectStreams;
 
 	double mPDFLevel;
 	LongFilePositionType mLastXrefPosition;
 	RefCountPtr<PDFDictionary> mTrailer;
-	ObjectIDType mXrefSize;
-	XrefEntryInput* mXrefTable;
+	// shared with cursors [see StartPDFParsingCursor]. not modified once parsing started
+	std::shared_ptr<ParsedXrefTable> mXrefTable;
 	unsigned long mPagesCount;
 	ObjectIDType* mPagesObjectIDs;
+	bool mLazyPagesIndexing;
+	std::string mPassword;
+	// stream over the source stream content, for cursors that read straight from it
+	InputByteArrayStream* mCursorStream;
+	// where the trailer was read from, for storing in a parse index and starting cursors
+	LongFilePositionType mTrailerPosition;
+	bool mTrailerIsXrefStream;
+	// parse index cache in use [see PDFParsingOptions::SharedParseIndexCache], the key of this file in it, and object streams
+	// headers read since the index was stored, to add to it when done. the key is empty when the index is not stored [reconstructed xref]
+	ParseIndexCache* mParseIndexCache;
+	std::string mParseIndexKey;
+	ObjectIDTypeToObjectStreamHeaderEntryVectorMap mNewObjectStreamsHeaders;
+	ObjectIDType mPagesRootObjectID;
+	ObjectIDTypeToPageTreeNodeMap mPageTreeNodes;
+	bool mXrefReconstructed;
+	// object streams found when reconstructing the xref, by their position in the file
+	ObjectIDTypeVector mReconstructedObjectStreams;
 	IPDFParserExtender* mParserExtender;
     bool mAllowExtendingSegments;
 
 	PDFHummus::EStatusCode ParseHeaderLine();
+	std::string ComputeParseIndexKey();
+	bool LoadParseIndex();
+	bool ReadTrailerAt(LongFilePositionType inTrailerPosition,bool inIsXrefStream);
+	void StoreParseIndex();
+	std::string GetTrailerDocumentID();
+	void RecordObjectStreamHeader(ObjectIDType inObjectStreamID,const ObjectStreamHeaderEntry* inHeader,ObjectIDType inObjectsCount);
 	PDFHummus::EStatusCode ParseEOFLine();
 	PDFHummus::EStatusCode ParseLastXrefPosition();
 	PDFHummus::EStatusCode ParseTrailerDictionary();
 	PDFHummus::EStatusCode BuildXrefTableFromTable();
-	PDFHummus::EStatusCode DetermineXrefSize();
 	PDFHummus::EStatusCode InitializeXref();
-	PDFHummus::EStatusCode ParseXrefFromXrefTable(XrefEntryInput* inXrefTable,
-                                                  ObjectIDType inXrefSize,
-                                                  LongFilePositionType inXrefPosition,
-                                                  XrefEntryInput** outExtendedTable,
-                                                  ObjectIDType* outExtendedTableSize);
-    XrefEntryInput* ExtendXrefTableToSize(XrefEntryInput* inXrefTable,ObjectIDType inOldSize,ObjectIDType inNewSize);
+	LongFilePositionType GetStreamSize();
+	PDFHummus::EStatusCode ParseXrefFromXrefTable(ParsedXrefTable& ioXrefTable,
+                                                  LongFilePositionType inXrefPosition);
 	PDFHummus::EStatusCode ReadNextXrefEntry(Byte inBuffer[20]);
+	// parse an object from the file (or object stream), skipping the parsed objects cache
+	PDFObject*  ParseNewObjectFromFile(ObjectIDType inObjectId);
 	PDFObject*  ParseExistingInDirectObject(ObjectIDType inObjectID);
 	PDFHummus::EStatusCode SetupDecryptionHelper(const std::string& inPassword);
+	PDFHummus::EStatusCode SetupDocumentStructure(const PDFParsingOptions& inOptions);
+	PDFHummus::EStatusCode ReconstructXref(unsigned int inThreadsCount);
+	PDFHummus::EStatusCode ReconstructTrailer(const XrefReconstructionScanResults& inScanResults);
+	ObjectIDType FindReconstructedObjectAt(const ScannedObjectHeaderVector& inObjectHeaders,LongFilePositionType inPosition);
+	void AddReconstructedObjectStreamsEntries();
 	PDFHummus::EStatusCode ParsePagesObjectIDs();
 	PDFHummus::EStatusCode ParsePagesIDs(PDFDictionary* inPageNode,ObjectIDType inNodeObjectID);
 	PDFHummus::EStatusCode ParsePagesIDs(PDFDictionary* inPageNode,ObjectIDType inNodeObjectID,unsigned long& ioCurrentPageIndex);
+	ObjectIDType LocatePageObjectID(unsigned long inPageIndex);
+	PageTreeNode* GetPageTreeNode(ObjectIDType inNodeObjectID);
+	const PageTreeKid* LocatePageTreeKid(PageTreeNode* inNode,unsigned long inPageIndexInNode);
+	PDFHummus::EStatusCode ResolvePageTreeKid(PageTreeKid& ioKid);
 	PDFHummus::EStatusCode ParsePreviousXrefs(PDFDictionary* inTrailer);
-	void MergeXrefWithMainXref(XrefEntryInput* inTableToMerge,ObjectIDType inMergedTableSize);
 	PDFHummus::EStatusCode ParseFileDirectory();
 	PDFHummus::EStatusCode BuildXrefTableAndTrailerFromXrefStream(long long inXrefStreamObjectID);
 	// an overload for cases where the xref stream object is already parsed
-	PDFHummus::EStatusCode ParseXrefFromXrefStream(XrefEntryInput* inXrefTable,
-                                                   ObjectIDType inXrefSize,
-                                                   PDFStreamInput* inXrefStream,
-                                                   XrefEntryInput** outExtendedTable,
-                                                   ObjectIDType* outExtendedTableSize);
+	PDFHummus::EStatusCode ParseXrefFromXrefStream(ParsedXrefTable& ioXrefTable,
+                                                   PDFStreamInput* inXrefStream);
 	// an overload for cases where the position should hold a stream object, and it should be parsed
-	PDFHummus::EStatusCode ParseXrefFromXrefStream(XrefEntryInput* inXrefTable,
-                                                   ObjectIDType inXrefSize,
-                                                   LongFilePositionType inXrefPosition,
-                                                   XrefEntryInput** outExtendedTable,
-                                                   ObjectIDType* outExtendedTableSize);
-	PDFHummus::EStatusCode ReadXrefStreamSegment(XrefEntryInput* inXrefTable,
+	PDFHummus::EStatusCode ParseXrefFromXrefStream(ParsedXrefTable& ioXrefTable,
+                                                   LongFilePositionType inXrefPosition);
+	PDFHummus::EStatusCode ReadXrefStreamSegment(ParsedXrefTable& ioXrefTable,
 									 ObjectIDType inSegmentStartObject,
 									 ObjectIDType inSegmentCount,
 									 IByteReader* inReadFrom,
 									 int* inEntryWidths,
 									 unsigned long inEntryWidthsSize);
-	PDFHummus::EStatusCode ReadXrefSegmentValue(IByteReader* inSource,int inEntrySize,long long& outValue);
-	PDFHummus::EStatusCode ReadXrefSegmentValue(IByteReader* inSource,int inEntrySize,ObjectIDType& outValue);
 	PDFHummus::EStatusCode ParseDirectory(LongFilePositionType inXrefPosition,
-                                          XrefEntryInput* inXrefTable,
-                                          ObjectIDType inXrefSize,
-                                          PDFDictionary** outTrailer,
-                                          XrefEntryInput** outExtendedTable,
-                                          ObjectIDType* outExtendedTableSize);
+                                          ParsedXrefTable& ioXrefTable,
+                                          PDFDictionary** outTrailer);
 	PDFObject* ParseExistingInDirectStreamObject(ObjectIDType inObjectId);
+	PDFObject* ParseExistingInDirectStreamObjectFromDecodedStream(ObjectIDType inObjectId);
+	PDFObject* ParseExistingInDirectStreamObjectFromIndexedStream(ObjectIDType inObjectId,bool& outIndexable);
+	void ResetFlateDecodeIndexes();
+	bool IsPlainFlateStream(PDFDictionary* inStreamDictionary,LongBufferSizeType& outLength);
+	DecodedObjectStream* DecodeObjectStream(ObjectIDType inObjectStreamID);
+	bool DecodeFlateStreamInPlace(PDFStreamInput* inStream,PDFDictionary* inStreamDictionary,std::vector<IOBasicTypes::Byte>& outDecoded);
 	PDFHummus::EStatusCode ParseObjectStreamHeader(ObjectStreamHeaderEntry* inHeaderInfo,ObjectIDType inObjectsCount);
 	void MovePositionInStream(LongFilePositionType inPosition);
 	EStatusCodeAndIByteReader CreateFilterForStream(IByteReader* inStream,PDFName* inFilterName,PDFDictionary* inDecodeParams, PDFStreamInput* inPDFStream);
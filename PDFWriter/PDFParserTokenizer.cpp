@@ -20,14 +20,43 @@
 */
 #include "PDFParserTokenizer.h"
 #include "IByteReader.h"
-#include "OutputStringBufferStream.h"
+#include "IByteReaderWithPosition.h"
 
 using namespace PDFHummus;
 using namespace IOBasicTypes;
 
+// character classification table, so that deciding on token boundaries is a single lookup per byte
+enum ECharacterClass
+{
+	eCharacterRegular,
+	eCharacterWhiteSpace,
+	eCharacterEntityBreaker
+};
+
+static const Byte scWhiteSpaces[] = {0,0x9,0xA,0xC,0xD,0x20};
+static const Byte scEntityBreakers[] = {'(',')','<','>',']','[','{','}','/','%'};
+
+struct CharacterClassTable
+{
+	Byte mClasses[256];
+
+	CharacterClassTable()
+	{
+		for(int i=0; i < 256; ++i)
+			mClasses[i] = eCharacterRegular;
+		for(int i=0; i < 6; ++i)
+			mClasses[scWhiteSpaces[i]] = eCharacterWhiteSpace;
+		for(int i=0; i < 10; ++i)
+			mClasses[scEntityBreakers[i]] = eCharacterEntityBreaker;
+	}
+};
+
+static const CharacterClassTable scCharacterClasses;
+
 PDFParserTokenizer::PDFParserTokenizer(void)
 {
 	mStream = NULL;
+	mPositionedStream = NULL;
 	ResetReadState();
 }
 
@@ -38,6 +67,14 @@ PDFParserTokenizer::~PDFParserTokenizer(void)
 void PDFParserTokenizer::SetReadStream(IByteReader* inSourceStream)
 {
 	mStream = inSourceStream;
+	mPositionedStream = NULL;
+	ResetReadState();
+}
+
+void PDFParserTokenizer::SetReadStream(IByteReaderWithPosition* inSourceStream)
+{
+	mStream = inSourceStream;
+	mPositionedStream = inSourceStream;
 	ResetReadState();
 }
 
@@ -57,7 +94,6 @@ void PDFParserTokenizer::ResetReadState(const PDFParserTokenizer& inExternalToke
 	mRecentTokenPosition = inExternalTokenizer.mRecentTokenPosition;
 }
 
-static const Byte scBackSlash[] = {'\\'};
 static const std::string scStream = "stream";
 static const char scCR = '\r';
 static const char scLF = '\n';
@@ -65,7 +101,6 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 {
 	BoolAndString result;
 	Byte buffer;
-	OutputStringBufferStream tokenBuffer;
 	
 	if(!mStream || (!mStream->NotEnded() && !mHasTokenBuffer))
 	{
@@ -73,10 +108,20 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 		return result;
 	}
 
+	// fast path, when the stream content is directly accessible. a byte put back by the regular path must be consumed first
+	if(mPositionedStream && !mHasTokenBuffer)
+	{
+		if(GetNextTokenFromSpan(result))
+			return result;
+		result.second.clear();
+	}
+
+	std::string& tokenBuffer = result.second;
+
 	do
 	{
 		SkipTillToken();
-		if(!mStream->NotEnded())
+		if(!mStream->NotEnded() && !mHasTokenBuffer)
 		{
 			result.first = false;
 			break;
@@ -92,7 +137,7 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 			result.first = false;
 			break;
 		}
-		tokenBuffer.Write(&buffer,1);
+		tokenBuffer.push_back(buffer);
 
 		result.first = true; // will only be changed to false in case of read error
 
@@ -112,9 +157,8 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 					}
 					if(0xD == buffer|| 0xA == buffer)
 						break;
-					tokenBuffer.Write(&buffer,1);
+					tokenBuffer.push_back(buffer);
 				}
-				result.second = tokenBuffer.ToString();
 				break;
 			}
 
@@ -151,8 +195,8 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 						}
 						else
 						{
-							tokenBuffer.Write(scBackSlash,1);					
-							tokenBuffer.Write(&buffer,1);
+							tokenBuffer.push_back('\\');					
+							tokenBuffer.push_back(buffer);
 						}
 					}
 					else
@@ -166,11 +210,9 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 							++balanceLevel;
 						else if(')' == buffer)
 							--balanceLevel;
-						tokenBuffer.Write(&buffer,1);
+						tokenBuffer.push_back(buffer);
 					}
 				}
-				if(result.first)
-					result.second = tokenBuffer.ToString();
 				break;
 			}
 
@@ -181,7 +223,6 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 				// Hex string, read till end of hex string marker
 				if(!mStream->NotEnded())
 				{
-					result.second = tokenBuffer.ToString();
 					break;
 				}
 
@@ -194,15 +235,14 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 				if('<' == buffer)
 				{
 					// Dictionary start marker
-					tokenBuffer.Write(&buffer,1);
-					result.second = tokenBuffer.ToString();
+					tokenBuffer.push_back(buffer);
 					break;
 				}
 				else
 				{
 					// Hex string 
 
-					tokenBuffer.Write(&buffer,1);
+					tokenBuffer.push_back(buffer);
 
 					while(mStream->NotEnded() && buffer != '>')
 					{
@@ -213,23 +253,20 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 						}
 
 						if(!IsPDFWhiteSpace(buffer))
-							tokenBuffer.Write(&buffer,1);
+							tokenBuffer.push_back(buffer);
 					}
 				}
-				result.second = tokenBuffer.ToString();
 				break;
 			}
 			case '[': // for all array or executable tokanizers, the tokanizer is just the mark
 			case ']':
 			case '{':
 			case '}':
-				result.second = tokenBuffer.ToString();
 				break;
 			case '>': // parse end dictionary marker as a single entity or a hex string end marker
 			{
 				if(!mStream->NotEnded()) // this means a loose end string marker...wierd
 				{
-					result.second = tokenBuffer.ToString();
 					break;
 				}
 
@@ -241,15 +278,13 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 
 				if('>' == buffer)
 				{
-					tokenBuffer.Write(&buffer,1);
-					result.second = tokenBuffer.ToString();
+					tokenBuffer.push_back(buffer);
 					break;
 				}
 				else
 				{
 					// hex string loose end
 					SaveTokenBuffer(buffer);
-					result.second = tokenBuffer.ToString();
 					break;
 				}
 
@@ -275,9 +310,8 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 						break;
 					}
 					else
-						tokenBuffer.Write(&buffer,1);
+						tokenBuffer.push_back(buffer);
 				}
-				result.second = tokenBuffer.ToString();
 				
 				if(result.first && mStream->NotEnded() && scStream == result.second)
 				{
@@ -328,6 +362,180 @@ BoolAndString PDFParserTokenizer::GetNextToken()
 	return result;
 }
 
+bool PDFParserTokenizer::GetNextTokenFromSpan(BoolAndString& outResult)
+{
+	LongBufferSizeType spanSize;
+	const Byte* span = mPositionedStream->GetTransientSpan(spanSize);
+	if(!span || 0 == spanSize)
+		return false;
+
+	const Byte* spanEnd = span + spanSize;
+	const Byte* current = span;
+	std::string& token = outResult.second;
+
+	// same token rules as GetNextToken, only with pointers. any time the content ends before the token does, give up
+	// and let the regular path handle it. it knows how to deal with the stream end, and with reading beyond this span
+
+	while(current < spanEnd && eCharacterWhiteSpace == scCharacterClasses.mClasses[*current])
+		++current;
+	if(current == spanEnd)
+		return false;
+
+	const Byte* tokenStart = current;
+
+	switch(*current)
+	{
+		case '%':
+		{
+			// comment, till end of line marker [which is consumed, but not included]
+			++current;
+			while(current < spanEnd && *current != 0xD && *current != 0xA)
+				++current;
+			if(current == spanEnd)
+				return false;
+			token.assign((const char*)tokenStart,current - tokenStart);
+			++current;
+			break;
+		}
+
+		case '(':
+		{
+			// literal string, till the balanced closing paranthesis. escaped line ends are dropped, other escapes are kept as is
+			int balanceLevel = 1;
+			const Byte* chunkStart = current;
+			++current;
+			while(balanceLevel > 0)
+			{
+				if(current == spanEnd)
+					return false;
+
+				if('\\' == *current)
+				{
+					if(current + 1 == spanEnd)
+						return false;
+					if(0xA == current[1] || 0xD == current[1])
+					{
+						token.append((const char*)chunkStart,current - chunkStart);
+						current+=2;
+						if(0xD == current[-1])
+						{
+							if(current == spanEnd)
+								return false;
+							if(0xA == *current)
+								++current;
+						}
+						chunkStart = current;
+					}
+					else
+						current+=2;
+					continue;
+				}
+
+				if('(' == *current)
+					++balanceLevel;
+				else if(')' == *current)
+					--balanceLevel;
+				++current;
+			}
+			token.append((const char*)chunkStart,current - chunkStart);
+			break;
+		}
+
+		case '<':
+		{
+			if(current + 1 == spanEnd)
+				return false;
+
+			if('<' == current[1])
+			{
+				// dictionary start marker
+				current+=2;
+				token.assign((const char*)tokenStart,2);
+			}
+			else
+			{
+				// hex string. first char is taken as is, then whitespaces are dropped, till the end marker
+				Byte buffer = current[1];
+				current+=2;
+				token.assign((const char*)tokenStart,2);
+				while(buffer != '>')
+				{
+					if(current == spanEnd)
+						return false;
+					buffer = *current;
+					++current;
+					if(eCharacterWhiteSpace != scCharacterClasses.mClasses[buffer])
+						token.push_back((char)buffer);
+				}
+			}
+			break;
+		}
+
+		case '[':
+		case ']':
+		case '{':
+		case '}':
+			++current;
+			token.assign((const char*)tokenStart,1);
+			break;
+
+		case '>':
+		{
+			// dictionary end marker, or a loose hex string end marker
+			if(current + 1 == spanEnd)
+				return false;
+			current+= ('>' == current[1]) ? 2 : 1;
+			token.assign((const char*)tokenStart,current - tokenStart);
+			break;
+		}
+
+		default:
+		{
+			// regular token, till whitespace [consumed] or breaker [left for next token]
+			++current;
+			while(current < spanEnd && eCharacterRegular == scCharacterClasses.mClasses[*current])
+				++current;
+			if(current == spanEnd)
+				return false;
+			token.assign((const char*)tokenStart,current - tokenStart);
+
+			if(eCharacterWhiteSpace != scCharacterClasses.mClasses[*current])
+			{
+				// a stream keyword should be followed by an end of line. leave this odd case to the regular path
+				if(scStream == token)
+					return false;
+				break;
+			}
+
+			if(scStream == token)
+			{
+				// stream content starts after the CR-LF or LF following the keyword [or a lone CR], skipping other whitespaces before
+				while(*current != scCR && *current != scLF)
+				{
+					++current;
+					if(current == spanEnd || eCharacterWhiteSpace != scCharacterClasses.mClasses[*current])
+						return false;
+				}
+				if(scCR == *current)
+				{
+					if(current + 1 == spanEnd)
+						return false;
+					if(scLF == current[1])
+						++current;
+				}
+			}
+			++current;
+			break;
+		}
+	}
+
+	mRecentTokenPosition = mStreamPositionTracker + (tokenStart - span);
+	mStreamPositionTracker+= (current - span);
+	mPositionedStream->Skip(current - span);
+	outResult.first = true;
+	return true;
+}
+
 void PDFParserTokenizer::SkipTillToken()
 {
 	Byte buffer = 0;
@@ -335,8 +543,8 @@ void PDFParserTokenizer::SkipTillToken()
 	if(!mStream)
 		return;
 
-	// skip till hitting first non space, or segment end
-	while(mStream->NotEnded())
+	// skip till hitting first non space, or segment end. a byte put back from the previous token counts too, even if the stream already ended
+	while(mHasTokenBuffer || mStream->NotEnded())
 	{
 		if(GetNextByteForToken(buffer) != PDFHummus::eSuccess)
 			break;
@@ -362,13 +570,9 @@ EStatusCode PDFParserTokenizer::GetNextByteForToken(Byte& outByte)
 		return (mStream->Read(&outByte,1) != 1) ? PDFHummus::eFailure:PDFHummus::eSuccess;
 }
 
-static const Byte scWhiteSpaces[] = {0,0x9,0xA,0xC,0xD,0x20};
 bool PDFParserTokenizer::IsPDFWhiteSpace(Byte inCharacter)
 {
-	bool isWhiteSpace = false;
-	for(int i=0; i < 6 && !isWhiteSpace; ++i)
-		isWhiteSpace =  (scWhiteSpaces[i] == inCharacter);
-	return isWhiteSpace;
+	return eCharacterWhiteSpace == scCharacterClasses.mClasses[inCharacter];
 }
 
 void PDFParserTokenizer::SaveTokenBuffer(Byte inToSave)
@@ -383,13 +587,9 @@ IOBasicTypes::LongFilePositionType PDFParserTokenizer::GetReadBufferSize()
 	return mHasTokenBuffer ? 1 : 0;
 }
 
-static const Byte scEntityBreakers[] = {'(',')','<','>',']','[','{','}','/','%'};
 bool PDFParserTokenizer::IsPDFEntityBreaker(Byte inCharacter)
 {
-	bool isEntityBreak = false;
-	for(int i=0; i < 10 && !isEntityBreak; ++i)
-		isEntityBreak =  (scEntityBreakers[i] == inCharacter);
-	return isEntityBreak;
+	return eCharacterEntityBreaker == scCharacterClasses.mClasses[inCharacter];
 }
 
 LongFilePositionType PDFParserTokenizer::GetRecentTokenPosition()
@@ -29,6 +29,7 @@
 
 
 class IByteReader;
+class IByteReaderWithPosition;
 
 typedef std::pair<bool,std::string> BoolAndString;
 
@@ -42,6 +43,9 @@ public:
 
 	// Assign the stream to read from (does not take ownership of the stream)
 	void SetReadStream(IByteReader* inSourceStream);
+	// Same, for streams with position. if the stream provides direct access to its content [see IByteReaderWithPosition::GetTransientSpan]
+	// tokens are scanned straight from it, rather than reading byte by byte
+	void SetReadStream(IByteReaderWithPosition* inSourceStream);
 
 	// Get the next avialable PDF token. return result returns whether
 	// token retreive was successful and the token. Token retrieval may be unsuccesful if
@@ -75,6 +79,8 @@ public:
 private:
 
 	IByteReader* mStream;
+	// same as mStream, when it's a stream with position, for direct content scanning
+	IByteReaderWithPosition* mPositionedStream;
 	bool mHasTokenBuffer;
 	IOBasicTypes::Byte mTokenBuffer;
 	IOBasicTypes::LongFilePositionType mStreamPositionTracker;
@@ -83,6 +89,10 @@ private:
 
 	void SkipTillToken();
 
+	// scan the next token directly from the stream content. returns false if content is not available directly,
+	// or if the token does not end within the available content. in which case nothing is consumed, and regular reading should be used
+	bool GetNextTokenFromSpan(BoolAndString& outResult);
+
 	// failure in GetNextByteForToken actually marks a true read failure, if you checked end of file before calling it...
 	PDFHummus::EStatusCode GetNextByteForToken(IOBasicTypes::Byte& outByte);
 
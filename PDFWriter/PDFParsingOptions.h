@@ -20,14 +20,71 @@ limitations under the License.
 */
 #pragma once
 
+#include "IOBasicTypes.h"
+#include "ParsedObjectsCache.h"
+
 #include <string>
 
+#define SUGGESTED_DECODED_OBJECT_STREAMS_CACHE_BUDGET (8*1024*1024)
+
+class ParseIndexCache;
+
 struct PDFParsingOptions
 {
 	std::string Password;
+	// Memory budget (in bytes) for keeping decoded object streams, so that objects stored in them are parsed
+	// without decoding the object stream again. 0 [the default] disables. SUGGESTED_DECODED_OBJECT_STREAMS_CACHE_BUDGET
+	// is a good start for documents that keep their objects in object streams
+	IOBasicTypes::LongBufferSizeType DecodedObjectStreamsCacheBudget;
+	// Memory budget (in bytes, estimated) for keeping parsed indirect objects, so that fetching the same object again
+	// returns the already parsed object instead of parsing it again. Cached objects are shared, so don't modify
+	// objects returned from the parser when using it. 0 [the default] disables
+	IOBasicTypes::LongBufferSizeType ParsedObjectsCacheBudget;
+	// which objects to drop when the parsed objects cache budget is used up
+	EParsedObjectsCacheEvictionPolicy ParsedObjectsCacheEvictionPolicy;
+	// when the library opens the parsed file by path [copying contexts, appending and merging pages from files],
+	// map it to memory instead of reading it through a buffered file stream. recommended for large files
+	bool MemoryMapInputFile;
+	// don't index all pages when starting to parse. only read the pages count from the pages tree root, and locate pages
+	// by descending the tree on request (remembering visited tree nodes). much faster for documents with many pages when
+	// only some of them are accessed. note that with this option page tree errors are only found when reaching the
+	// faulty node, rather than failing StartPDFParsing
+	bool LazyPagesIndexing;
+	// when the xref or trailer can't be read [or the pages can't be read through them], rebuild them by scanning the whole file
+	// for objects, instead of failing. the scan is split between XrefReconstructionThreads threads [0 for the hardware concurrency].
+	// faster with MemoryMapInputFile, or any source that provides direct access to its content, otherwise the file is read to memory
+	bool ReconstructBrokenXref;
+	unsigned int XrefReconstructionThreads;
+	// cache of parse indexes [xref, trailer position, pages object IDs and object streams headers], for files that are opened
+	// repeatedly. when the file was parsed before with the same cache, starting to parse skips reading the xref sections and the
+	// pages tree. the cache is not owned, and may be shared between parsers [see ParseIndexCache]. NULL [the default] disables
+	ParseIndexCache* SharedParseIndexCache;
+	// when copying pages [appending, merging or creating form xobjects from pages], parse the objects of each page in a
+	// parse session [see ParseSession], so they are allocated from an arena that's released in bulk when done with the page.
+	// saves lots of small allocations for pages with many objects
+	bool UseParseSessions;
+	// for flate encoded object streams that are not kept decoded [no decoded object streams budget, or too large for it], record
+	// decoding checkpoints every this many decoded bytes, so that reaching an object resumes decoding from the nearest checkpoint
+	// rather than from the stream start [see InputFlateDecodeSeekableStream]. each checkpoint takes up to 32KB. 0 [the default] disables
+	IOBasicTypes::LongBufferSizeType FlateCheckpointsInterval;
 
-	PDFParsingOptions() {}
-	PDFParsingOptions(std::string inPassword) { Password = inPassword; }
+	PDFParsingOptions() { SetDefaultCacheOptions(); }
+	PDFParsingOptions(std::string inPassword) { Password = inPassword; SetDefaultCacheOptions(); }
 
 	static const PDFParsingOptions& DefaultPDFParsingOptions();
+
+private:
+	void SetDefaultCacheOptions()
+	{
+		DecodedObjectStreamsCacheBudget = 0;
+		ParsedObjectsCacheBudget = 0;
+		ParsedObjectsCacheEvictionPolicy = eParsedObjectsCacheEvictLeastRecentlyUsed;
+		MemoryMapInputFile = false;
+		LazyPagesIndexing = false;
+		ReconstructBrokenXref = false;
+		XrefReconstructionThreads = 0;
+		SharedParseIndexCache = NULL;
+		UseParseSessions = false;
+		FlateCheckpointsInterval = 0;
+	}
 };
\ No newline at end of file
@@ -23,20 +23,43 @@
 #include "InputStringBufferStream.h"
 #include "OutputStreamTraits.h"
 #include "EncryptionHelper.h"
+#include "OutputDeferredCompressionStream.h"
 
 PDFStream::PDFStream(bool inCompressStream,
 					 IByteWriterWithPosition* inOutputStream,
 					 EncryptionHelper* inEncryptionHelper,
 					 ObjectIDType inExtentObjectID,
-					 IObjectsContextExtender* inObjectsContextExtender)
+					 IObjectsContextExtender* inObjectsContextExtender,
+					 OutputDeferredCompressionStream* inDeferredOutputStream,
+					 const FlateEncodingOptions& inFlateEncodingOptions)
 {
 	mExtender = inObjectsContextExtender;
 	mCompressStream = inCompressStream;
+	// the extender may adjust the document compression parameters per stream
+	mFlateEncodingOptions = mExtender ? mExtender->GetStreamFlateEncodingOptions(inFlateEncodingOptions) : inFlateEncodingOptions;
 	mExtendObjectID = inExtentObjectID;	
-	mStreamStartPosition = inOutputStream->GetCurrentPosition();
 	mOutputStream = inOutputStream;
+	mDeferredOutputStream = inDeferredOutputStream;
+	mIsLengthDeferred = false;
+	mDeferredEncodingID = 0;
+
+	// with deferred output, the stream is collected in memory, so as not to wait on pending output for positions.
+	// if it's to be flate compressed, leave the compression to the deferred output stream workers
+	IByteWriterWithPosition* targetStream;
+	if(mDeferredOutputStream)
+	{
+		mStreamStartPosition = 0;
+		mTemporaryOutputStream.Assign(&mTemporaryStream);
+		targetStream = &mTemporaryOutputStream;
+	}
+	else
+	{
+		mStreamStartPosition = inOutputStream->GetCurrentPosition();
+		targetStream = inOutputStream;
+	}
+
 	if (inEncryptionHelper && inEncryptionHelper->IsEncrypting()) {
-		mEncryptionStream = inEncryptionHelper->CreateEncryptionStream(inOutputStream);
+		mEncryptionStream = inEncryptionHelper->CreateEncryptionStream(targetStream);
 	}
 	else {
 		mEncryptionStream = NULL;
@@ -50,16 +73,22 @@ PDFStream::PDFStream(bool inCompressStream,
 	{
 		if(mExtender && mExtender->OverridesStreamCompression())
 		{
-			mWriteStream = mExtender->GetCompressionWriteStream(mEncryptionStream ? mEncryptionStream:inOutputStream);
+			mWriteStream = mExtender->GetCompressionWriteStream(mEncryptionStream ? mEncryptionStream:targetStream);
+		}
+		else if(mDeferredOutputStream && !mEncryptionStream)
+		{
+			mIsLengthDeferred = true;
+			mWriteStream = targetStream;
 		}
 		else
 		{
-			mFlateEncodingStream.Assign(mEncryptionStream ? mEncryptionStream : inOutputStream);
+			mFlateEncodingStream.SetEncodingOptions(mFlateEncodingOptions);
+			mFlateEncodingStream.Assign(mEncryptionStream ? mEncryptionStream : targetStream);
 			mWriteStream = &mFlateEncodingStream;
 		}
 	}
 	else
-		mWriteStream = mEncryptionStream ? mEncryptionStream : inOutputStream;
+		mWriteStream = mEncryptionStream ? mEncryptionStream : targetStream;
 
 }
 
@@ -68,15 +97,21 @@ PDFStream::PDFStream(
           IByteWriterWithPosition* inOutputStream,
 			EncryptionHelper* inEncryptionHelper,
 			DictionaryContext* inStreamDictionaryContextForDirectExtentStream,
-          IObjectsContextExtender* inObjectsContextExtender)
+          IObjectsContextExtender* inObjectsContextExtender,
+			const FlateEncodingOptions& inFlateEncodingOptions)
 {
 	mExtender = inObjectsContextExtender;
 	mCompressStream = inCompressStream;
+	// the extender may adjust the document compression parameters per stream
+	mFlateEncodingOptions = mExtender ? mExtender->GetStreamFlateEncodingOptions(inFlateEncodingOptions) : inFlateEncodingOptions;
 	mExtendObjectID = 0;	
 	mStreamStartPosition = 0;
 	mOutputStream = inOutputStream;
 	mStreamLength = 0;
     mStreamDictionaryContextForDirectExtentStream = inStreamDictionaryContextForDirectExtentStream;
+	mDeferredOutputStream = NULL;
+	mIsLengthDeferred = false;
+	mDeferredEncodingID = 0;
     
     mTemporaryOutputStream.Assign(&mTemporaryStream);
 	if (inEncryptionHelper && inEncryptionHelper->IsEncrypting()) {
@@ -96,6 +131,7 @@ PDFStream::PDFStream(
 		}
 		else
 		{
+			mFlateEncodingStream.SetEncodingOptions(mFlateEncodingOptions);
 			mFlateEncodingStream.Assign(mEncryptionStream ? mEncryptionStream : &mTemporaryOutputStream);
 			mWriteStream = &mFlateEncodingStream;
 		}
@@ -121,7 +157,7 @@ void PDFStream::FinalizeStreamWrite()
 	if(mExtender && mExtender->OverridesStreamCompression() && mCompressStream)
 		mExtender->FinalizeCompressedStreamWrite(mWriteStream);
 	mWriteStream = NULL;
-	if(mCompressStream)
+	if(mCompressStream && !mIsLengthDeferred)
 		mFlateEncodingStream.Assign(NULL);  // this both finished encoding any left buffers and releases ownership from mFlateEncodingStream
 
 	if (mEncryptionStream) {
@@ -136,6 +172,20 @@ void PDFStream::FinalizeStreamWrite()
     {
         mStreamLength = mTemporaryStream.GetCurrentWritePosition();
     }
+	else if(mIsLengthDeferred)
+	{
+		std::string content = mTemporaryStream.str();
+		ByteVector data(content.begin(),content.end());
+		content.clear();
+		mTemporaryStream.str(std::string());
+		mDeferredEncodingID = mDeferredOutputStream->QueueFlateEncoding(data,mFlateEncodingOptions);
+		mOutputStream = NULL;
+	}
+	else if(mDeferredOutputStream)
+	{
+		mStreamLength = mTemporaryStream.GetCurrentWritePosition();
+		CopyTemporaryStreamToOutput();
+	}
     else 
     {
         mStreamLength = mOutputStream->GetCurrentPosition()-mStreamStartPosition;
@@ -164,6 +214,11 @@ DictionaryContext* PDFStream::GetStreamDictionaryForDirectExtentStream()
 }
 
 void PDFStream::FlushStreamContentForDirectExtentStream()
+{
+	CopyTemporaryStreamToOutput();
+}
+
+void PDFStream::CopyTemporaryStreamToOutput()
 {
     mTemporaryStream.pubseekoff(0,std::ios_base::beg);
     
@@ -176,3 +231,13 @@ void PDFStream::FlushStreamContentForDirectExtentStream()
     mOutputStream = NULL;
 }
 
+bool PDFStream::IsLengthDeferred()
+{
+	return mIsLengthDeferred;
+}
+
+unsigned long PDFStream::GetDeferredEncodingID()
+{
+	return mDeferredEncodingID;
+}
+
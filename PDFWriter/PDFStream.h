@@ -41,6 +41,7 @@ class IByteWriterWithPosition;
 class IObjectsContextExtender;
 class DictionaryContext;
 class EncryptionHelper;
+class OutputDeferredCompressionStream;
 
 class PDFStream
 {
@@ -50,14 +51,17 @@ public:
 		IByteWriterWithPosition* inOutputStream,
 		EncryptionHelper* inEncryptionHelper,
 		ObjectIDType inExtentObjectID,
-		IObjectsContextExtender* inObjectsContextExtender);
+		IObjectsContextExtender* inObjectsContextExtender,
+		OutputDeferredCompressionStream* inDeferredOutputStream = NULL,
+		const FlateEncodingOptions& inFlateEncodingOptions = FlateEncodingOptions::DefaultFlateEncodingOptions());
     
     PDFStream(
         bool inCompressStream,
         IByteWriterWithPosition* inOutputStream,
 		EncryptionHelper* inEncryptionHelper,
 		DictionaryContext* inStreamDictionaryContextForDirectExtentStream,
-        IObjectsContextExtender* inObjectsContextExtender);
+        IObjectsContextExtender* inObjectsContextExtender,
+		const FlateEncodingOptions& inFlateEncodingOptions = FlateEncodingOptions::DefaultFlateEncodingOptions());
     
     
 	~PDFStream(void);
@@ -73,6 +77,11 @@ public:
 	ObjectIDType GetExtentObjectID();
 
 	LongFilePositionType GetLength(); // get the stream extent
+
+	// deferred compression specific. when the stream is compressed by the deferred output stream, its length is not known
+	// on finalize. use the encoding ID to write it when it is, with OutputDeferredCompressionStream::WriteEncodedLength
+	bool IsLengthDeferred();
+	unsigned long GetDeferredEncodingID();
     
     // direct extent specific
     DictionaryContext* GetStreamDictionaryForDirectExtentStream();
@@ -91,4 +100,10 @@ private:
     MyStringBuf mTemporaryStream;
     OutputStringBufferStream mTemporaryOutputStream;
     DictionaryContext* mStreamDictionaryContextForDirectExtentStream;
+	OutputDeferredCompressionStream* mDeferredOutputStream;
+	bool mIsLengthDeferred;
+	unsigned long mDeferredEncodingID;
+	FlateEncodingOptions mFlateEncodingOptions;
+
+	void CopyTemporaryStreamToOutput();
 };
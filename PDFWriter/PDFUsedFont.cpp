@@ -38,8 +38,10 @@ PDFUsedFont::PDFUsedFont(FT_Face inInputFace,
 						 const std::string& inAdditionalMetricsFontFilePath,
                          long inFontIndex,
 						 ObjectsContext* inObjectsContext,
-						 bool inEmbedFont):mFaceWrapper(inInputFace,inFontFilePath,inAdditionalMetricsFontFilePath,inFontIndex)
+						 bool inEmbedFont,
+						 SharedFontsCache* inFontsCache):mFaceWrapper(inInputFace,inFontFilePath,inAdditionalMetricsFontFilePath,inFontIndex)
 {
+	mFaceWrapper.SetFontsCache(inFontsCache);
 	mObjectsContext = inObjectsContext;
 	mWrittenFont = NULL;
 	mEmbedFont = inEmbedFont;
@@ -74,6 +76,26 @@ EStatusCode PDFUsedFont::EncodeStringForShowing(const GlyphUnicodeMappingList& i
 	return PDFHummus::eSuccess;
 }
 
+EStatusCode PDFUsedFont::EncodeStringForShowing(const GlyphRun& inText,
+												ObjectIDType &outFontObjectToUse,
+												UShortVector& outCharactersToUse,
+												bool& outTreatCharactersAsCID)
+{
+	if (inText.IsEmpty()) {
+		outFontObjectToUse = 0;
+		outTreatCharactersAsCID = false;
+		outCharactersToUse.clear();
+		return PDFHummus::eSuccess;
+	}
+
+	if(!mWrittenFont)
+		mWrittenFont = mFaceWrapper.CreateWrittenFontObject(mObjectsContext,mEmbedFont);
+
+	mWrittenFont->AppendGlyphs(inText,outCharactersToUse,outTreatCharactersAsCID,outFontObjectToUse);
+
+	return PDFHummus::eSuccess;
+}
+
 EStatusCode PDFUsedFont::TranslateStringToGlyphs(const std::string& inText,GlyphUnicodeMappingList& outGlyphsUnicodeMapping)
 {
 	UIntList glyphs;
@@ -95,6 +117,26 @@ EStatusCode PDFUsedFont::TranslateStringToGlyphs(const std::string& inText,Glyph
 	return status;
 }
 
+EStatusCode PDFUsedFont::TranslateStringToGlyphs(const std::string& inText,GlyphRun& outGlyphs)
+{
+	outGlyphs.Clear();
+
+	EStatusCode status = UnicodeString::DecodeUTF8(inText,mUnicodeCharacters);
+	if(status != PDFHummus::eSuccess)
+		return status;
+
+	if(mUnicodeCharacters.empty())
+		return PDFHummus::eSuccess;
+
+	mGlyphs.resize(mUnicodeCharacters.size());
+	status = mFaceWrapper.GetGlyphsForUnicodeText(&(mUnicodeCharacters[0]),mUnicodeCharacters.size(),&(mGlyphs[0]));
+
+	for(size_t i=0;i<mUnicodeCharacters.size();++i)
+		outGlyphs.AddGlyph((unsigned short)mGlyphs[i],mUnicodeCharacters[i]);
+
+	return status;
+}
+
 EStatusCode PDFUsedFont::EncodeStringsForShowing(const GlyphUnicodeMappingListList& inText,
 												ObjectIDType &outFontObjectToUse,
 												UShortListList& outCharactersToUse,
@@ -123,6 +165,19 @@ EStatusCode PDFUsedFont::WriteFontDefinition()
         return mWrittenFont->WriteFontDefinition(mFaceWrapper, mEmbedFont);
 }
 
+void PDFUsedFont::ReserveFontPrograms()
+{
+	// nothing to embed if the font is not embedded, or not used
+	if(mWrittenFont && mEmbedFont)
+		mWrittenFont->ReserveFontPrograms(mFaceWrapper);
+}
+
+void PDFUsedFont::PrepareFontPrograms()
+{
+	if(mWrittenFont && mEmbedFont)
+		mWrittenFont->PrepareFontPrograms(mFaceWrapper);
+}
+
 EStatusCode PDFUsedFont::WriteState(ObjectsContext* inStateWriter,ObjectIDType inObjectID)
 {
 	inStateWriter->StartNewIndirectObject(inObjectID);
@@ -182,77 +237,63 @@ void PDFUsedFont::GetUnicodeGlyphs(const std::string& inText, UIntList& glyphs)
 	mFaceWrapper.GetGlyphsForUnicodeText(unicode.GetUnicodeList(),glyphs);
 }
 
+void PDFUsedFont::GetUnicodeGlyphs(const std::string& inText, UIntVector& outGlyphs)
+{
+	ULongVector characters;
+
+	UnicodeString::DecodeUTF8(inText,characters);
+	outGlyphs.resize(characters.size());
+	if(characters.size() > 0)
+		mFaceWrapper.GetGlyphsForUnicodeText(&(characters[0]),characters.size(),&(outGlyphs[0]));
+}
+
 PDFUsedFont::TextMeasures PDFUsedFont::CalculateTextDimensions(const std::string& inText,long inFontSize)
 {
-	UIntList glyphs;
-    UnicodeString unicode;
-        
-    unicode.FromUTF8(inText);
-	mFaceWrapper.GetGlyphsForUnicodeText(unicode.GetUnicodeList(),glyphs);
-	return CalculateTextDimensions(glyphs,inFontSize);
+	UIntVector glyphs;
+
+	GetUnicodeGlyphs(inText,glyphs);
+	return CalculateTextDimensions(glyphs.size() > 0 ? &(glyphs[0]) : NULL,glyphs.size(),inFontSize);
 }
 
 PDFUsedFont::TextMeasures PDFUsedFont::CalculateTextDimensions(const UIntList& inGlyphsList,long inFontSize)
 {
-    // now calculate the placement bounding box. using the algorithm described in the FreeType turtorial part 2, minus the kerning part, and with no scale
+	UIntVector glyphs(inGlyphsList.begin(),inGlyphsList.end());
 
-    // first, calculate the pen advancements
-    int           pen_x, pen_y;
-    std::list<FT_Vector> pos;
-    pen_x = 0;   /* start at (0,0) */
-    pen_y = 0;
-    
-    UIntList::const_iterator it = inGlyphsList.begin();
-    for(; it != inGlyphsList.end();++it)
-    {
-        pos.push_back(FT_Vector());
+	return CalculateTextDimensions(glyphs.size() > 0 ? &(glyphs[0]) : NULL,glyphs.size(),inFontSize);
+}
 
-        pos.back().x = pen_x;
-        pos.back().y = pen_y;
+PDFUsedFont::TextMeasures PDFUsedFont::CalculateTextDimensions(const unsigned int* inGlyphs,size_t inGlyphsCount,long inFontSize)
+{
+    // now calculate the placement bounding box. using the algorithm described in the FreeType turtorial part 2, minus the kerning part, and with no scale.
+	// the glyphs advances and boxes come from the face metrics tables, so glyphs are loaded once per face
 
-        pen_x += mFaceWrapper.GetGlyphWidth(*it);
-    }
-    
-    // now let's combine with the bbox, so we get the nice bbox for the whole string
-    
     FT_BBox  bbox;
     FT_BBox  glyph_bbox;
+    FT_Pos pen_x = 0; /* start at (0,0), and move along x only */
     bbox.xMin = bbox.yMin =  32000;
     bbox.xMax = bbox.yMax = -32000;
     
-    it = inGlyphsList.begin();
-    std::list<FT_Vector>::iterator itPos = pos.begin();
-    
-    for(; it != inGlyphsList.end();++it,++itPos)
+    for(size_t i=0;i<inGlyphsCount;++i)
     {
-		mFaceWrapper.LoadGlyph(mFaceWrapper.GetGlyphIndexInFreeTypeIndexes(*it));
-        FT_Glyph aGlyph;
-        FT_Get_Glyph( mFaceWrapper->glyph,&aGlyph);
-        FT_Glyph_Get_CBox(aGlyph, FT_GLYPH_BBOX_UNSCALED,&glyph_bbox);
-        FT_Done_Glyph(aGlyph);
-        
-        glyph_bbox.xMin = mFaceWrapper.GetInPDFMeasurements(glyph_bbox.xMin);
-        glyph_bbox.xMax = mFaceWrapper.GetInPDFMeasurements(glyph_bbox.xMax);
-        glyph_bbox.yMin = mFaceWrapper.GetInPDFMeasurements(glyph_bbox.yMin);
-        glyph_bbox.yMax = mFaceWrapper.GetInPDFMeasurements(glyph_bbox.yMax);
-        
-        glyph_bbox.xMin += itPos->x;
-        glyph_bbox.xMax += itPos->x;
-        glyph_bbox.yMin += itPos->y;
-        glyph_bbox.yMax += itPos->y;
-    
-        
-        if ( glyph_bbox.xMin < bbox.xMin )
-            bbox.xMin = glyph_bbox.xMin;
-        
-        if ( glyph_bbox.yMin < bbox.yMin )
-            bbox.yMin = glyph_bbox.yMin;
-        
-        if ( glyph_bbox.xMax > bbox.xMax )
-            bbox.xMax = glyph_bbox.xMax;
-        
-        if ( glyph_bbox.yMax > bbox.yMax )
-            bbox.yMax = glyph_bbox.yMax;
+        if(mFaceWrapper.GetGlyphBBox(inGlyphs[i],glyph_bbox))
+        {
+            glyph_bbox.xMin += pen_x;
+            glyph_bbox.xMax += pen_x;
+
+            if ( glyph_bbox.xMin < bbox.xMin )
+                bbox.xMin = glyph_bbox.xMin;
+
+            if ( glyph_bbox.yMin < bbox.yMin )
+                bbox.yMin = glyph_bbox.yMin;
+
+            if ( glyph_bbox.xMax > bbox.xMax )
+                bbox.xMax = glyph_bbox.xMax;
+
+            if ( glyph_bbox.yMax > bbox.yMax )
+                bbox.yMax = glyph_bbox.yMax;
+        }
+
+        pen_x += mFaceWrapper.GetGlyphWidth(inGlyphs[i]);
     }
     if ( bbox.xMin > bbox.xMax )
     {
@@ -276,27 +317,24 @@ PDFUsedFont::TextMeasures PDFUsedFont::CalculateTextDimensions(const UIntList& i
 
 double PDFUsedFont::CalculateTextAdvance(const std::string& inText,double inFontSize)
 {
-	UIntList glyphs;
-	GetUnicodeGlyphs(inText, glyphs);
-	return CalculateTextAdvance(glyphs,inFontSize);
+	UIntVector glyphs;
+
+	GetUnicodeGlyphs(inText,glyphs);
+	return CalculateTextAdvance(glyphs.size() > 0 ? &(glyphs[0]) : NULL,glyphs.size(),inFontSize);
 }
 
 double PDFUsedFont::CalculateTextAdvance(const UIntList& inGlyphsList,double inFontSize)
+{
+	UIntVector glyphs(inGlyphsList.begin(),inGlyphsList.end());
+
+	return CalculateTextAdvance(glyphs.size() > 0 ? &(glyphs[0]) : NULL,glyphs.size(),inFontSize);
+}
+
+double PDFUsedFont::CalculateTextAdvance(const unsigned int* inGlyphs,size_t inGlyphsCount,double inFontSize)
 {
     FT_Pos pen = 0;
-    UIntList::const_iterator it = inGlyphsList.begin();
-    for(; it != inGlyphsList.end();++it)
-    {
-		FT_Pos adv;
-		if (mAdvanceCache.count(*it) > 0) 
-			adv = mAdvanceCache[*it];
-		else {
-			adv = mFaceWrapper.GetGlyphWidth(*it); //potentially very expensive!
-			if (mAdvanceCache.size() <= AdvanceCacheLimit) //dumb limit should cover typical usage, implement LRU if it's a problem
-				mAdvanceCache[*it] = adv;
-		}
-		pen += adv;
-    }
+	for(size_t i=0;i<inGlyphsCount;++i)
+		pen += mFaceWrapper.GetGlyphWidth(inGlyphs[i]);
 	return pen * inFontSize / 1000.0;
 }
 
@@ -27,6 +27,7 @@
 #include <string>
 #include <list>
 #include <map>
+#include <vector>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -42,6 +43,9 @@ typedef std::list<unsigned int> UIntList;
 class IWrittenFont;
 class ObjectsContext;
 class PDFParser;
+class SharedFontsCache;
+
+typedef std::vector<unsigned int> UIntVector;
 
 class PDFUsedFont
 {
@@ -87,7 +91,8 @@ public:
 				const std::string& inAdditionalMetricsFontFilePath,
                 long inFontIndex,
 				ObjectsContext* inObjectsContext,
-				bool inEmbedFont);
+				bool inEmbedFont,
+				SharedFontsCache* inFontsCache = NULL); // pass the cache the face was acquired from, if any
 	virtual ~PDFUsedFont(void);
 
 	bool IsValid();
@@ -105,6 +110,12 @@ public:
 										UShortList& outCharactersToUse,
 										bool& outTreatCharactersAsCID);
 
+	// same, for a glyph run. outCharactersToUse is cleared first
+	PDFHummus::EStatusCode EncodeStringForShowing(const GlyphRun& inText,
+										ObjectIDType &outFontObjectToUse,
+										UShortVector& outCharactersToUse,
+										bool& outTreatCharactersAsCID);
+
 	// encode all strings. make sure that they will use the same font.
 	PDFHummus::EStatusCode EncodeStringsForShowing(const GlyphUnicodeMappingListList& inText,
 										ObjectIDType &outFontObjectToUse,
@@ -112,20 +123,28 @@ public:
 										bool& outTreatCharactersAsCID);
 
 	PDFHummus::EStatusCode WriteFontDefinition();
+	// subset the embedded font programs ahead of WriteFontDefinition. ReserveFontPrograms reserves their subset names, so call it
+	// in the order of writing the fonts definitions. PrepareFontPrograms may then run on a worker thread. see IWrittenFont
+	void ReserveFontPrograms();
+	void PrepareFontPrograms();
 
 	// use this method to translate text to glyphs and unicode mapping, to be later used for EncodeStringForShowing
 	PDFHummus::EStatusCode TranslateStringToGlyphs(const std::string& inText,GlyphUnicodeMappingList& outGlyphsUnicodeMapping);
+	// same, into a glyph run [cleared first]. prefer this when writing many strings, it does not allocate per character
+	PDFHummus::EStatusCode TranslateStringToGlyphs(const std::string& inText,GlyphRun& outGlyphs);
 
 	PDFHummus::EStatusCode WriteState(ObjectsContext* inStateWriter,ObjectIDType inObjectID);
 	PDFHummus::EStatusCode ReadState(PDFParser* inStateReader,ObjectIDType inObjectID);
     
     FreeTypeFaceWrapper* GetFreeTypeFont();
 
-	// text measurements, either pass unicode text or glyphs list
+	// text measurements, either pass unicode text or glyphs list/array
 	PDFUsedFont::TextMeasures CalculateTextDimensions(const std::string& inText,long inFontSize=1);
 	PDFUsedFont::TextMeasures CalculateTextDimensions(const UIntList& inGlyphsList,long inFontSize=1);
+	PDFUsedFont::TextMeasures CalculateTextDimensions(const unsigned int* inGlyphs,size_t inGlyphsCount,long inFontSize=1);
 	double CalculateTextAdvance(const std::string& inText,double inFontSize=1);
 	double CalculateTextAdvance(const UIntList& inGlyphsList,double inFontSize=1);
+	double CalculateTextAdvance(const unsigned int* inGlyphs,size_t inGlyphsCount,double inFontSize=1);
 
 	// character path enumeration, pass unicode text or glyph list
 	bool EnumeratePaths(IOutlineEnumerator& target, const std::string& inText,double inFontSize=1);
@@ -133,14 +152,17 @@ public:
 
 protected:
 	void GetUnicodeGlyphs(const std::string& inText, UIntList& glyphs);
+	void GetUnicodeGlyphs(const std::string& inText, UIntVector& outGlyphs);
 
 private:
-	static const unsigned int AdvanceCacheLimit = 200;
 	FreeTypeFaceWrapper mFaceWrapper;
     IWrittenFont* mWrittenFont;
 	ObjectsContext* mObjectsContext;
-	std::map<unsigned int, FT_Pos> mAdvanceCache;
 	bool mEmbedFont;
 
+	// reused between calls to translate strings to glyph runs
+	ULongVector mUnicodeCharacters;
+	UIntVector mGlyphs;
+
 
 };
@@ -60,6 +60,14 @@ EPDFVersion thisOrDefaultVersion(EPDFVersion inPDFVersion) {
 	return ePDFVersionUndefined == inPDFVersion ? ePDFVersion14 : inPDFVersion;
 }
 
+EPDFVersion newPDFVersion(EPDFVersion inPDFVersion,const PDFCreationSettings& inPDFCreationSettings) {
+	EPDFVersion version = thisOrDefaultVersion(inPDFVersion);
+	// object streams and xref streams require PDF 1.5
+	if(inPDFCreationSettings.WriteObjectStreams && version < ePDFVersion15)
+		version = ePDFVersion15;
+	return version;
+}
+
 EStatusCode PDFWriter::StartPDF(
 							const std::string& inOutputFilePath,
 							EPDFVersion inPDFVersion,
@@ -68,6 +76,7 @@ EStatusCode PDFWriter::StartPDF(
 {
 	SetupLog(inLogConfiguration);
 	SetupCreationSettings(inPDFCreationSettings);
+	mObjectsContext.SetWriteObjectStreams(inPDFCreationSettings.WriteObjectStreams);
 
 	EStatusCode status = mOutputFile.OpenFile(inOutputFilePath);
 	if(status != eSuccess)
@@ -77,7 +86,7 @@ EStatusCode PDFWriter::StartPDF(
 	mDocumentContext.SetOutputFileInformation(&mOutputFile);    
 
 	if (inPDFCreationSettings.DocumentEncryptionOptions.ShouldEncrypt) {
-		mDocumentContext.SetupEncryption(inPDFCreationSettings.DocumentEncryptionOptions, thisOrDefaultVersion(inPDFVersion));
+		mDocumentContext.SetupEncryption(inPDFCreationSettings.DocumentEncryptionOptions, newPDFVersion(inPDFVersion,inPDFCreationSettings));
 		if (!mDocumentContext.SupportsEncryption()) {
 			mOutputFile.CloseFile(); // close the file, to keep things clean
 			return eFailure;
@@ -86,7 +95,7 @@ EStatusCode PDFWriter::StartPDF(
 
 	mIsModified = false;
 	
-	return mDocumentContext.WriteHeader(thisOrDefaultVersion(inPDFVersion));
+	return mDocumentContext.WriteHeader(newPDFVersion(inPDFVersion,inPDFCreationSettings));
 }
 
 EStatusCode PDFWriter::EndPDF()
@@ -173,7 +182,13 @@ void PDFWriter::SetupLog(const LogConfiguration& inLogConfiguration)
 void PDFWriter::SetupCreationSettings(const PDFCreationSettings& inPDFCreationSettings)
 {
 	mObjectsContext.SetCompressStreams(inPDFCreationSettings.CompressStreams);
+	mObjectsContext.SetFlateEncodingOptions(inPDFCreationSettings.StreamsFlateEncodingOptions);
+	mObjectsContext.SetDecimalPlaces(inPDFCreationSettings.DecimalPlaces);
+	mObjectsContext.SetDeduplicateStreams(inPDFCreationSettings.DeduplicateStreams);
+	mObjectsContext.SetDeferredStreamCompression(inPDFCreationSettings.DeferStreamCompression,inPDFCreationSettings.StreamCompressionThreads);
 	mDocumentContext.SetEmbedFonts(inPDFCreationSettings.EmbedFonts);
+	mDocumentContext.SetFontsCache(inPDFCreationSettings.FontsCache);
+	mDocumentContext.SetParallelFontSubsetting(inPDFCreationSettings.ParallelFontSubsetting,inPDFCreationSettings.FontSubsettingThreads);
 }
 
 void PDFWriter::ReleaseLog()
@@ -551,8 +566,9 @@ EStatusCode PDFWriter::StartPDFForStream(IByteWriterWithPosition* inOutputStream
 {
 	SetupLog(inLogConfiguration);
 	SetupCreationSettings(inPDFCreationSettings);
+	mObjectsContext.SetWriteObjectStreams(inPDFCreationSettings.WriteObjectStreams);
 	if (inPDFCreationSettings.DocumentEncryptionOptions.ShouldEncrypt) {
-		mDocumentContext.SetupEncryption(inPDFCreationSettings.DocumentEncryptionOptions, thisOrDefaultVersion(inPDFVersion));
+		mDocumentContext.SetupEncryption(inPDFCreationSettings.DocumentEncryptionOptions, newPDFVersion(inPDFVersion,inPDFCreationSettings));
 		if (!mDocumentContext.SupportsEncryption())
 			return eFailure;
 	}
@@ -560,7 +576,7 @@ EStatusCode PDFWriter::StartPDFForStream(IByteWriterWithPosition* inOutputStream
 	mObjectsContext.SetOutputStream(inOutputStream);
     mIsModified = false;
 	
-	return mDocumentContext.WriteHeader(thisOrDefaultVersion(inPDFVersion));
+	return mDocumentContext.WriteHeader(newPDFVersion(inPDFVersion,inPDFCreationSettings));
 }
 EStatusCode PDFWriter::EndPDFForStream()
 {
@@ -34,6 +34,7 @@
 #include "PDFEmbedParameterTypes.h"
 #include "PDFParsingOptions.h"
 #include "EncryptionOptions.h"
+#include "FlateEncodingOptions.h"
 
 #include <string>
 #include <utility>
@@ -54,15 +55,53 @@ struct LogConfiguration
 	static const LogConfiguration& DefaultLogConfiguration();
 };
 
+class SharedFontsCache;
+
 struct PDFCreationSettings
 {
 	bool CompressStreams;
 	bool EmbedFonts;
 	EncryptionOptions DocumentEncryptionOptions;
-
-	PDFCreationSettings(bool inCompressStreams, bool inEmbedFonts,EncryptionOptions inDocumentEncryptionOptions = EncryptionOptions::DefaultEncryptionOptions()):DocumentEncryptionOptions(inDocumentEncryptionOptions){ 
+	// pack non-stream objects into object streams and write an xref stream instead of an xref table (PDF 1.5 and up).
+	// new documents only, and not used with encryption (the xref stream is still written)
+	bool WriteObjectStreams;
+	// number of decimal places for real numbers in the document, such as coordinates in content streams (trailing zeros are trimmed).
+	// 6 by default. 3-4 are normally enough, and make for smaller content
+	unsigned short DecimalPlaces;
+	// flate compression parameters (level, strategy, memory level) for the document streams. lower levels trade output size for speed.
+	// IObjectsContextExtender::GetStreamFlateEncodingOptions may adjust them per stream
+	FlateEncodingOptions StreamsFlateEncodingOptions;
+	// write identical image streams only once, referring to the first written copy from later uses. applies to image
+	// XObjects created from JPG and PNG files/streams (not when encrypting). streams are merged by content: an image whose
+	// dictionary and data bytes equal those of an earlier one is written as a reference to it (a hash match is verified by comparing
+	// the bytes in full). written images are kept in memory for the comparison, till the document ends
+	bool DeduplicateStreams;
+	// compress streams on worker threads, while the rest of the document is being written. the output is the same as without it
+	// (except that with object streams the streams lengths objects are written outside of them).
+	// streams are held in memory till compressed, and encrypted streams or ones compressed by an extender are not deferred
+	bool DeferStreamCompression;
+	// number of compression threads for DeferStreamCompression. 0 (default) means the machine cores count
+	unsigned int StreamCompressionThreads;
+	// cache to get fonts from, so processes creating many documents load and parse their fonts once, and reuse their subset font programs (see SharedFontsCache).
+	// NULL by default, meaning each document loads its own fonts. not owned, and must outlive the document
+	SharedFontsCache* FontsCache;
+	// subset and convert the embedded fonts on worker threads when finishing the document, instead of one after the other.
+	// the fonts definitions are still written in order, so the output is the same as without it. the fonts programs are held in memory till written
+	bool ParallelFontSubsetting;
+	// number of threads for ParallelFontSubsetting. 0 (default) means the machine cores count
+	unsigned int FontSubsettingThreads;
+
+	PDFCreationSettings(bool inCompressStreams, bool inEmbedFonts,EncryptionOptions inDocumentEncryptionOptions = EncryptionOptions::DefaultEncryptionOptions(),bool inWriteObjectStreams = false):DocumentEncryptionOptions(inDocumentEncryptionOptions){ 
 		CompressStreams = inCompressStreams; 
 		EmbedFonts = inEmbedFonts;
+		WriteObjectStreams = inWriteObjectStreams;
+		DecimalPlaces = PrimitiveObjectsWriter::scDefaultDecimalPlaces;
+		DeduplicateStreams = false;
+		DeferStreamCompression = false;
+		StreamCompressionThreads = 0;
+		FontsCache = NULL;
+		ParallelFontSubsetting = false;
+		FontSubsettingThreads = 0;
 	}
 
 };
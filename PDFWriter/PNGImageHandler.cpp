@@ -73,6 +73,113 @@ static const std::string scDeviceGray = "DeviceGray";
 static const std::string scDeviceRGB = "DeviceRGB";
 static const std::string scBitsPerComponent = "BitsPerComponent";
 static const std::string scSMask = "SMask";
+
+// write a complete image xobject, with the samples in inData
+static void WriteImageXObjectStream(
+	ObjectsContext* inObjectsContext,
+	ObjectIDType inImageObjectID,
+	png_uint_32 inWidth,
+	png_uint_32 inHeight,
+	png_byte inBitDepth,
+	const std::string& inColorSpace,
+	ObjectIDType inSMaskObjectID,
+	MyStringBuf& inData) {
+	inObjectsContext->StartNewIndirectObject(inImageObjectID);
+	DictionaryContext* imageContext = inObjectsContext->StartDictionary();
+
+	// type
+	imageContext->WriteKey(scType);
+	imageContext->WriteNameValue(scXObject);
+
+	// subtype
+	imageContext->WriteKey(scSubType);
+	imageContext->WriteNameValue(scImage);
+
+	// Width
+	imageContext->WriteKey(scWidth);
+	imageContext->WriteIntegerValue(inWidth);
+
+	// Height
+	imageContext->WriteKey(scHeight);
+	imageContext->WriteIntegerValue(inHeight);
+
+	// Bits Per Component
+	imageContext->WriteKey(scBitsPerComponent);
+	imageContext->WriteIntegerValue(inBitDepth);
+
+	// Color Space
+	imageContext->WriteKey(scColorSpace);
+	imageContext->WriteNameValue(inColorSpace);
+
+	// Mask in case of Alpha
+	if (inSMaskObjectID != 0) {
+		imageContext->WriteKey(scSMask);
+		imageContext->WriteNewObjectReferenceValue(inSMaskObjectID);
+	}
+
+	PDFStream* imageStream = inObjectsContext->StartPDFStream(imageContext);
+
+	// write the samples
+	InputStringBufferStream dataStream(&inData);
+	OutputStreamTraits traits(imageStream->GetWriteStream());
+	traits.CopyToOutputStream(&dataStream);
+
+	inObjectsContext->EndPDFStream(imageStream);
+	delete imageStream;
+}
+
+// deduplication variant of CreateImageXObjectForData. reads all samples first, so that the soft mask can be
+// written (and deduplicated) before the image that refers to it
+static PDFImageXObject* CreateDeduplicatedImageXObjectForData(png_structp png_ptr, png_infop info_ptr, png_bytep row, ObjectsContext* inObjectsContext) {
+	MyStringBuf colorComponentsData;
+	MyStringBuf alphaComponentsData;
+
+	png_uint_32 transformed_width = png_get_image_width(png_ptr, info_ptr);
+	png_uint_32 transformed_height = png_get_image_height(png_ptr, info_ptr);
+	png_byte transformed_color_type = png_get_color_type(png_ptr, info_ptr);
+	png_byte transformed_bit_depth = png_get_bit_depth(png_ptr, info_ptr);
+	png_byte channels_count = png_get_channels(png_ptr, info_ptr);
+	bool isAlpha = (transformed_color_type & PNG_COLOR_MASK_ALPHA) != 0;
+	png_byte colorComponents = isAlpha ? (channels_count - 1) : channels_count;
+
+	if (setjmp(png_jmpbuf(png_ptr)))
+		return NULL;
+
+	{
+		OutputStringBufferStream colorWriteStream(&colorComponentsData);
+		OutputStringBufferStream alphaWriteStream(&alphaComponentsData);
+		png_uint_32 y = transformed_height;
+
+		while (y-- > 0) {
+			png_read_row(png_ptr, NULL, row);
+			if (isAlpha) {
+				for (png_uint_32 i = 0; i < transformed_width; ++i) {
+					colorWriteStream.Write((IOBasicTypes::Byte*)(row + i*channels_count), colorComponents);
+					alphaWriteStream.Write((IOBasicTypes::Byte*)(row + i*channels_count + colorComponents), 1);
+				}
+			}
+			else {
+				colorWriteStream.Write((IOBasicTypes::Byte*)(row), transformed_width*colorComponents);
+			}
+		}
+	}
+
+	ObjectIDType imageMaskObjectId = 0;
+	if (isAlpha) {
+		imageMaskObjectId = inObjectsContext->GetInDirectObjectsRegistry().AllocateNewObjectID();
+		inObjectsContext->StartStreamDeduplication(imageMaskObjectId);
+		WriteImageXObjectStream(inObjectsContext, imageMaskObjectId, transformed_width, transformed_height, transformed_bit_depth, scDeviceGray, 0, alphaComponentsData);
+		imageMaskObjectId = inObjectsContext->EndStreamDeduplication(imageMaskObjectId);
+	}
+
+	ObjectIDType imageXObjectObjectId = inObjectsContext->GetInDirectObjectsRegistry().AllocateNewObjectID();
+	inObjectsContext->StartStreamDeduplication(imageXObjectObjectId);
+	WriteImageXObjectStream(inObjectsContext, imageXObjectObjectId, transformed_width, transformed_height, transformed_bit_depth, 1 == colorComponents ? scDeviceGray : scDeviceRGB, imageMaskObjectId, colorComponentsData);
+	imageXObjectObjectId = inObjectsContext->EndStreamDeduplication(imageXObjectObjectId);
+
+	return new PDFImageXObject(imageXObjectObjectId, 1 == colorComponents ? KProcsetImageB : KProcsetImageC);
+}
+
 PDFImageXObject* CreateImageXObjectForData(png_structp png_ptr, png_infop info_ptr, png_bytep row, ObjectsContext* inObjectsContext) {
 	PDFImageXObjectList listOfImages;
 	PDFImageXObject* imageXObject = NULL;
@@ -171,45 +278,8 @@ PDFImageXObject* CreateImageXObjectForData(png_structp png_ptr, png_infop info_p
 		inObjectsContext->EndPDFStream(imageStream);
 
 		// if there's a soft mask, write it now
-		if (isAlpha) {
-			inObjectsContext->StartNewIndirectObject(imageMaskObjectId);
-			DictionaryContext* imageMaskContext = inObjectsContext->StartDictionary();
-
-			// type
-			imageMaskContext->WriteKey(scType);
-			imageMaskContext->WriteNameValue(scXObject);
-
-			// subtype
-			imageMaskContext->WriteKey(scSubType);
-			imageMaskContext->WriteNameValue(scImage);
-
-			// Width
-			imageMaskContext->WriteKey(scWidth);
-			imageMaskContext->WriteIntegerValue(transformed_width);
-
-			// Height
-			imageMaskContext->WriteKey(scHeight);
-			imageMaskContext->WriteIntegerValue(transformed_height);
-
-			// Bits Per Component
-			imageMaskContext->WriteKey(scBitsPerComponent);
-			imageMaskContext->WriteIntegerValue(transformed_bit_depth);
-
-			// Color Space
-			imageMaskContext->WriteKey(scColorSpace);
-			imageMaskContext->WriteNameValue(scDeviceGray);
-
-			PDFStream* imageMaskStream = inObjectsContext->StartPDFStream(imageMaskContext);
-			IByteWriter* writerMaskStream = imageMaskStream->GetWriteStream();
-
-			// write the alpha samples
-			InputStringBufferStream alphaWriteStream(&alphaComponentsData);
-			OutputStreamTraits traits(writerMaskStream);
-			traits.CopyToOutputStream(&alphaWriteStream);
-
-			inObjectsContext->EndPDFStream(imageMaskStream);
-			delete imageMaskStream;
-		}
+		if (isAlpha)
+			WriteImageXObjectStream(inObjectsContext, imageMaskObjectId, transformed_width, transformed_height, transformed_bit_depth, scDeviceGray, 0, alphaComponentsData);
 
 		imageXObject = new PDFImageXObject(imageXObjectObjectId, 1 == colorComponents ? KProcsetImageB : KProcsetImageC);
 	} while (false);
@@ -378,7 +448,9 @@ PDFFormXObject* CreateFormXObjectForPNGStream(IByteReaderWithPosition* inPNGStre
 		}
 
 		while (passes-- > 0) {
-			imageXObject = CreateImageXObjectForData(png_ptr, info_ptr, row, inObjectsContext);
+			imageXObject = inObjectsContext->IsDeduplicatingStreams() ?
+								CreateDeduplicatedImageXObjectForData(png_ptr, info_ptr, row, inObjectsContext) :
+								CreateImageXObjectForData(png_ptr, info_ptr, row, inObjectsContext);
 			if (!imageXObject) {
 				status = eFailure;
 				break;
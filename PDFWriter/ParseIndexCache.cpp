@@ -0,0 +1,332 @@
+/*
+   Source File : ParseIndexCache.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ParseIndexCache.h"
+#include "OutputFile.h"
+#include "InputFile.h"
+#include "IByteWriterWithPosition.h"
+#include "IByteReaderWithPosition.h"
+#include "Trace.h"
+
+using namespace PDFHummus;
+using namespace IOBasicTypes;
+
+ParseIndexCache::ParseIndexCache(void)
+{
+	mHitsCount = 0;
+}
+
+ParseIndexCache::~ParseIndexCache(void)
+{
+}
+
+bool ParseIndexCache::Find(const std::string& inKey,ParseIndex& outIndex)
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	StringToParseIndexMap::iterator it = mIndexes.find(inKey);
+	if(it == mIndexes.end())
+		return false;
+
+	outIndex = it->second;
+	return true;
+}
+
+void ParseIndexCache::RecordHit()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	++mHitsCount;
+}
+
+void ParseIndexCache::Store(const std::string& inKey,const ParseIndex& inIndex)
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	mIndexes[inKey] = inIndex;
+}
+
+void ParseIndexCache::AddObjectStreamsHeaders(const std::string& inKey,const ObjectIDTypeToObjectStreamHeaderEntryVectorMap& inObjectStreamsHeaders)
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	StringToParseIndexMap::iterator it = mIndexes.find(inKey);
+	if(it == mIndexes.end())
+		return;
+
+	// headers that are already there stay. they're the same, having been read from the same file
+	it->second.mObjectStreamsHeaders.insert(inObjectStreamsHeaders.begin(),inObjectStreamsHeaders.end());
+}
+
+void ParseIndexCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	mIndexes.clear();
+	mHitsCount = 0;
+}
+
+size_t ParseIndexCache::GetEntriesCount()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	return mIndexes.size();
+}
+
+unsigned long ParseIndexCache::GetHitsCount()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	return mHitsCount;
+}
+
+/*
+	file format. all numbers are 8 bytes, little endian:
+	[magic][indexes count]
+	per index:
+		[key length][key]
+		[last xref position][trailer position][trailer is xref stream]
+		[xref size][file size][defined entries count] and per defined entry [object id][type][position][revision]
+		[pages count][page object ids]
+		[object streams count] and per object stream [object stream id][objects count] and per object [object number][offset]
+*/
+
+static const std::string scParseIndexCacheMagic = "PDFHummusParseIndex2";
+
+static void WriteNumber(IByteWriter* inStream,unsigned long long inValue)
+{
+	Byte buffer[8];
+	for(int i=0;i<8;++i)
+		buffer[i] = (Byte)((inValue >> (i*8)) & 0xff);
+	inStream->Write(buffer,8);
+}
+
+static bool ReadNumber(IByteReader* inStream,unsigned long long& outValue)
+{
+	Byte buffer[8];
+	if(inStream->Read(buffer,8) != 8)
+		return false;
+	outValue = 0;
+	for(int i=7;i>=0;--i)
+		outValue = (outValue << 8) | buffer[i];
+	return true;
+}
+
+static void WriteIndex(IByteWriter* inStream,const std::string& inKey,const ParseIndex& inIndex)
+{
+	WriteNumber(inStream,inKey.size());
+	inStream->Write((const Byte*)inKey.c_str(),inKey.size());
+
+	WriteNumber(inStream,(unsigned long long)inIndex.mLastXrefPosition);
+	WriteNumber(inStream,(unsigned long long)inIndex.mTrailerPosition);
+	WriteNumber(inStream,inIndex.mTrailerIsXrefStream ? 1 : 0);
+	WriteNumber(inStream,inIndex.mDocumentID.size());
+	inStream->Write((const Byte*)inIndex.mDocumentID.c_str(),inIndex.mDocumentID.size());
+
+	const ParsedXrefTable& xref = inIndex.mXrefTable;
+	unsigned long long definedCount = 0;
+	for(ObjectIDType i=0;i<xref.GetSize();++i)
+		if(xref.GetType(i) != eXrefEntryUndefined)
+			++definedCount;
+	WriteNumber(inStream,xref.GetSize());
+	WriteNumber(inStream,(unsigned long long)xref.GetFileSize());
+	WriteNumber(inStream,definedCount);
+	for(ObjectIDType i=0;i<xref.GetSize();++i)
+	{
+		EXrefEntryType type = xref.GetType(i);
+		if(eXrefEntryUndefined == type)
+			continue;
+		WriteNumber(inStream,i);
+		WriteNumber(inStream,type);
+		WriteNumber(inStream,(unsigned long long)xref.GetPosition(i));
+		WriteNumber(inStream,xref.GetRevision(i));
+	}
+
+	WriteNumber(inStream,inIndex.mPagesObjectIDs.size());
+	for(ObjectIDTypeVector::const_iterator it = inIndex.mPagesObjectIDs.begin(); it != inIndex.mPagesObjectIDs.end(); ++it)
+		WriteNumber(inStream,*it);
+
+	WriteNumber(inStream,inIndex.mObjectStreamsHeaders.size());
+	ObjectIDTypeToObjectStreamHeaderEntryVectorMap::const_iterator itStreams = inIndex.mObjectStreamsHeaders.begin();
+	for(; itStreams != inIndex.mObjectStreamsHeaders.end(); ++itStreams)
+	{
+		WriteNumber(inStream,itStreams->first);
+		WriteNumber(inStream,itStreams->second.size());
+		for(ObjectStreamHeaderEntryVector::const_iterator itEntries = itStreams->second.begin(); itEntries != itStreams->second.end(); ++itEntries)
+		{
+			WriteNumber(inStream,itEntries->mObjectNumber);
+			WriteNumber(inStream,(unsigned long long)itEntries->mObjectOffset);
+		}
+	}
+}
+
+// true if inCount items of inItemSize bytes may still be in the file. counts are read from the file, so check
+// them before allocating anything by them, so that a truncated or corrupt file fails instead of exhausting memory
+static bool HasBytesFor(IByteReaderWithPosition* inStream,LongFilePositionType inStreamSize,unsigned long long inCount,unsigned long long inItemSize)
+{
+	LongFilePositionType position = inStream->GetCurrentPosition();
+	if(position > inStreamSize)
+		return false;
+	return inCount <= (unsigned long long)(inStreamSize - position) / inItemSize;
+}
+
+// largest xref size accepted from a file. object IDs beyond 32 bits don't fit ObjectIDType on all platforms, and this
+// bounds the xref table pages list allocated by it
+static const unsigned long long scMaxXrefSize = 0xffffffffULL;
+
+static bool ReadIndex(IByteReaderWithPosition* inStream,LongFilePositionType inStreamSize,std::string& outKey,ParseIndex& outIndex)
+{
+	unsigned long long value,count;
+
+	if(!ReadNumber(inStream,count) || !HasBytesFor(inStream,inStreamSize,count,1))
+		return false;
+	outKey.resize((size_t)count);
+	if(count > 0 && inStream->Read((Byte*)&outKey[0],(size_t)count) != count)
+		return false;
+
+	if(!ReadNumber(inStream,value))
+		return false;
+	outIndex.mLastXrefPosition = (LongFilePositionType)value;
+	if(!ReadNumber(inStream,value))
+		return false;
+	outIndex.mTrailerPosition = (LongFilePositionType)value;
+	if(!ReadNumber(inStream,value))
+		return false;
+	outIndex.mTrailerIsXrefStream = (value != 0);
+	if(!ReadNumber(inStream,count) || !HasBytesFor(inStream,inStreamSize,count,1))
+		return false;
+	outIndex.mDocumentID.resize((size_t)count);
+	if(count > 0 && inStream->Read((Byte*)&outIndex.mDocumentID[0],(size_t)count) != count)
+		return false;
+
+	unsigned long long xrefSize,fileSize;
+	if(!ReadNumber(inStream,xrefSize) || !ReadNumber(inStream,fileSize) || !ReadNumber(inStream,count))
+		return false;
+	// 4 numbers per defined entry
+	if(xrefSize > scMaxXrefSize || (LongFilePositionType)fileSize < 0 || !HasBytesFor(inStream,inStreamSize,count,32))
+		return false;
+	outIndex.mXrefTable.Reset((ObjectIDType)xrefSize,(LongFilePositionType)fileSize);
+	for(unsigned long long i=0;i<count;++i)
+	{
+		unsigned long long objectID,type,position,revision;
+		if(!ReadNumber(inStream,objectID) || !ReadNumber(inStream,type) || !ReadNumber(inStream,position) || !ReadNumber(inStream,revision))
+			return false;
+		if(objectID >= xrefSize || type >= eXrefEntryUndefined)
+			return false;
+		outIndex.mXrefTable.SetEntry((ObjectIDType)objectID,(LongFilePositionType)position,(unsigned long)revision,(EXrefEntryType)type);
+	}
+
+	if(!ReadNumber(inStream,count) || !HasBytesFor(inStream,inStreamSize,count,8))
+		return false;
+	outIndex.mPagesObjectIDs.reserve((size_t)count);
+	for(unsigned long long i=0;i<count;++i)
+	{
+		if(!ReadNumber(inStream,value) || value >= xrefSize)
+			return false;
+		outIndex.mPagesObjectIDs.push_back((ObjectIDType)value);
+	}
+
+	// 2 numbers per object stream, and per object in it
+	if(!ReadNumber(inStream,count) || !HasBytesFor(inStream,inStreamSize,count,16))
+		return false;
+	for(unsigned long long i=0;i<count;++i)
+	{
+		unsigned long long objectStreamID,objectsCount;
+		if(!ReadNumber(inStream,objectStreamID) || !ReadNumber(inStream,objectsCount))
+			return false;
+		if(objectStreamID >= xrefSize || !HasBytesFor(inStream,inStreamSize,objectsCount,16))
+			return false;
+		ObjectStreamHeaderEntryVector& entries = outIndex.mObjectStreamsHeaders[(ObjectIDType)objectStreamID];
+		entries.reserve((size_t)objectsCount);
+		for(unsigned long long j=0;j<objectsCount;++j)
+		{
+			ObjectStreamHeaderEntry entry;
+			if(!ReadNumber(inStream,value) || value >= xrefSize)
+				return false;
+			entry.mObjectNumber = (ObjectIDType)value;
+			if(!ReadNumber(inStream,value))
+				return false;
+			entry.mObjectOffset = (LongFilePositionType)value;
+			entries.push_back(entry);
+		}
+	}
+
+	return true;
+}
+
+EStatusCode ParseIndexCache::SaveToFile(const std::string& inFilePath)
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	OutputFile outputFile;
+	if(outputFile.OpenFile(inFilePath) != eSuccess)
+	{
+		TRACE_LOG1("ParseIndexCache::SaveToFile, unable to open %s for writing",inFilePath.substr(0, MAX_TRACE_SIZE - 200).c_str());
+		return eFailure;
+	}
+
+	IByteWriter* stream = outputFile.GetOutputStream();
+	stream->Write((const Byte*)scParseIndexCacheMagic.c_str(),scParseIndexCacheMagic.size());
+	WriteNumber(stream,mIndexes.size());
+	for(StringToParseIndexMap::iterator it = mIndexes.begin(); it != mIndexes.end(); ++it)
+		WriteIndex(stream,it->first,it->second);
+
+	return outputFile.CloseFile();
+}
+
+EStatusCode ParseIndexCache::LoadFromFile(const std::string& inFilePath)
+{
+	InputFile inputFile;
+	if(inputFile.OpenFile(inFilePath) != eSuccess)
+	{
+		TRACE_LOG1("ParseIndexCache::LoadFromFile, unable to open %s for reading",inFilePath.substr(0, MAX_TRACE_SIZE - 200).c_str());
+		return eFailure;
+	}
+
+	IByteReaderWithPosition* stream = inputFile.GetInputStream();
+	LongFilePositionType streamSize = inputFile.GetFileSize();
+	std::string magic(scParseIndexCacheMagic.size(),' ');
+	unsigned long long indexesCount;
+	if(stream->Read((Byte*)&magic[0],magic.size()) != magic.size() || magic != scParseIndexCacheMagic || !ReadNumber(stream,indexesCount))
+	{
+		TRACE_LOG1("ParseIndexCache::LoadFromFile, %s is not a parse index cache file",inFilePath.substr(0, MAX_TRACE_SIZE - 200).c_str());
+		return eFailure;
+	}
+
+	// read all before adding anything, so that a bad file doesn't leave a partial load. counts read are checked against
+	// the bytes left in the file, so a truncated or corrupt file fails here
+	StringToParseIndexMap indexes;
+	for(unsigned long long i=0;i<indexesCount;++i)
+	{
+		std::string key;
+		ParseIndex index;
+		if(!ReadIndex(stream,streamSize,key,index))
+		{
+			TRACE_LOG1("ParseIndexCache::LoadFromFile, failed to read index from %s",inFilePath.substr(0, MAX_TRACE_SIZE - 200).c_str());
+			return eFailure;
+		}
+		indexes[key] = index;
+	}
+
+	std::lock_guard<std::mutex> lock(mLock);
+	for(StringToParseIndexMap::iterator it = indexes.begin(); it != indexes.end(); ++it)
+		mIndexes[it->first] = it->second;
+	return eSuccess;
+}
@@ -0,0 +1,102 @@
+/*
+   Source File : ParseIndexCache.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "EStatusCode.h"
+#include "ObjectsBasicTypes.h"
+#include "IOBasicTypes.h"
+#include "ParsedXrefTable.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+	Cache of parse indexes for files that are opened again and again [say, templates that are embedded in many outputs].
+	A parse index holds what PDFParser builds when starting to parse a file - the merged xref, where the trailer is, the pages
+	object IDs - and the object streams headers read while parsing objects. When a file is found in the cache, PDFParser
+	takes these from it, instead of reading the xref sections and the pages tree again.
+	Files are looked up by their size and their last bytes [which hold the startxref position], and an index found this way
+	is used only if the trailer ID of the file is the same as the one stored with the index. so a file that's modified, even
+	by an incremental update, is not matched. files that have no ID are matched by size and last bytes alone.
+	Pass the cache with PDFParsingOptions::ParseIndexCache. A cache may be shared by parsers on multiple threads, and may be saved
+	to a file and loaded back, to keep it between runs.
+*/
+
+struct ObjectStreamHeaderEntry
+{
+	ObjectIDType mObjectNumber;
+	IOBasicTypes::LongFilePositionType mObjectOffset;
+};
+
+typedef std::vector<ObjectStreamHeaderEntry> ObjectStreamHeaderEntryVector;
+typedef std::map<ObjectIDType,ObjectStreamHeaderEntryVector> ObjectIDTypeToObjectStreamHeaderEntryVectorMap;
+typedef std::vector<ObjectIDType> ObjectIDTypeVector;
+
+struct ParseIndex
+{
+	ParsedXrefTable mXrefTable;
+	IOBasicTypes::LongFilePositionType mLastXrefPosition;
+	// position of the trailer dictionary [right after the trailer keyword], or of the xref stream object
+	// when the trailer is an xref stream dictionary
+	IOBasicTypes::LongFilePositionType mTrailerPosition;
+	bool mTrailerIsXrefStream;
+	// the trailer ID strings, concatenated. empty if the trailer has no ID
+	std::string mDocumentID;
+	// empty if pages were not indexed [lazy pages indexing, or no pages]
+	ObjectIDTypeVector mPagesObjectIDs;
+	ObjectIDTypeToObjectStreamHeaderEntryVectorMap mObjectStreamsHeaders;
+
+	ParseIndex(){mLastXrefPosition = 0;mTrailerPosition = 0;mTrailerIsXrefStream = false;}
+};
+
+typedef std::map<std::string,ParseIndex> StringToParseIndexMap;
+
+class ParseIndexCache
+{
+public:
+	ParseIndexCache(void);
+	~ParseIndexCache(void);
+
+	// copy the index stored for inKey to outIndex. returns false if there's none
+	bool Find(const std::string& inKey,ParseIndex& outIndex);
+	// store an index for inKey, replacing any index that's already there
+	void Store(const std::string& inKey,const ParseIndex& inIndex);
+	// add object streams headers to the index stored for inKey. does nothing if there's none
+	void AddObjectStreamsHeaders(const std::string& inKey,const ObjectIDTypeToObjectStreamHeaderEntryVectorMap& inObjectStreamsHeaders);
+
+	void Clear();
+	size_t GetEntriesCount();
+	// statistics. count of indexes that were found and used. parsers verify a found index before using it, and record
+	// a hit with RecordHit when they do
+	void RecordHit();
+	unsigned long GetHitsCount();
+
+	// persist all indexes to a file, and load them back [adding to the indexes already in the cache]
+	PDFHummus::EStatusCode SaveToFile(const std::string& inFilePath);
+	PDFHummus::EStatusCode LoadFromFile(const std::string& inFilePath);
+
+private:
+	std::mutex mLock;
+	StringToParseIndexMap mIndexes;
+	unsigned long mHitsCount;
+};
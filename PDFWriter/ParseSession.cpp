@@ -0,0 +1,271 @@
+/*
+   Source File : ParseSession.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ParseSession.h"
+#include "PDFObject.h"
+#include "PDFBoolean.h"
+#include "PDFLiteralString.h"
+#include "PDFHexString.h"
+#include "PDFNull.h"
+#include "PDFName.h"
+#include "PDFInteger.h"
+#include "PDFReal.h"
+#include "PDFArray.h"
+#include "PDFDictionary.h"
+#include "PDFIndirectObjectReference.h"
+#include "PDFStreamInput.h"
+#include "PDFSymbol.h"
+
+#include <atomic>
+#include <new>
+#include <vector>
+
+using namespace IOBasicTypes;
+
+#define PARSE_SESSION_BLOCK_SIZE (64*1024)
+// larger objects [there shouldn't be any] go to the heap
+#define PARSE_SESSION_MAX_OBJECT_SIZE 1024
+
+// every object is preceded by a header naming the arena it was allocated from, NULL for heap allocated objects.
+// the union keeps the objects following the header aligned
+union ObjectAllocationHeader
+{
+	ParseSessionArena* mArena;
+	double mAlignDouble;
+	long long mAlignLongLong;
+};
+
+class ParseSessionArena
+{
+public:
+	ParseSessionArena()
+	{
+		mReferences = 1; // the session
+		mCurrentBlock = NULL;
+		mCurrentBlockUsed = PARSE_SESSION_BLOCK_SIZE;
+		mObjectsCount = 0;
+		mBytes = 0;
+	}
+
+	~ParseSessionArena()
+	{
+		std::vector<Byte*>::iterator it = mBlocks.begin();
+		for(; it != mBlocks.end(); ++it)
+			delete[] *it;
+	}
+
+	// allocation only happens on the session thread, while the session is active. returns NULL if the object is too large
+	void* Allocate(size_t inSize)
+	{
+		size_t allocationSize = sizeof(ObjectAllocationHeader) + inSize;
+		allocationSize = (allocationSize + sizeof(ObjectAllocationHeader) - 1) / sizeof(ObjectAllocationHeader) * sizeof(ObjectAllocationHeader);
+		if(allocationSize > PARSE_SESSION_MAX_OBJECT_SIZE)
+			return NULL;
+
+		if(mCurrentBlockUsed + allocationSize > PARSE_SESSION_BLOCK_SIZE)
+		{
+			mCurrentBlock = new Byte[PARSE_SESSION_BLOCK_SIZE];
+			mBlocks.push_back(mCurrentBlock);
+			mCurrentBlockUsed = 0;
+		}
+
+		ObjectAllocationHeader* header = (ObjectAllocationHeader*)(mCurrentBlock + mCurrentBlockUsed);
+		mCurrentBlockUsed += allocationSize;
+		header->mArena = this;
+		++mObjectsCount;
+		mBytes += allocationSize;
+
+		// each object holds a reference, so the arena outlives its objects
+		++mReferences;
+		return header + 1;
+	}
+
+	// release may happen on any thread [objects may be released anywhere]. the last release frees the arena
+	void Release()
+	{
+		if(--mReferences == 0)
+			delete this;
+	}
+
+	unsigned long GetObjectsCount() const {return mObjectsCount;}
+	unsigned long GetBlocksCount() const {return (unsigned long)mBlocks.size();}
+	LongBufferSizeType GetBytes() const {return mBytes;}
+
+private:
+	std::atomic<unsigned long> mReferences;
+	std::vector<Byte*> mBlocks;
+	Byte* mCurrentBlock;
+	size_t mCurrentBlockUsed;
+	unsigned long mObjectsCount;
+	LongBufferSizeType mBytes;
+};
+
+static thread_local ParseSessionArena* sActiveArena = NULL;
+
+ParseSession::ParseSession(bool inStart)
+{
+	mEnclosingArena = sActiveArena;
+	if(inStart)
+	{
+		mArena = new ParseSessionArena();
+		sActiveArena = mArena;
+	}
+	else
+	{
+		mArena = NULL;
+	}
+}
+
+ParseSession::~ParseSession(void)
+{
+	if(mArena)
+	{
+		sActiveArena = mEnclosingArena;
+		mArena->Release();
+	}
+}
+
+bool ParseSession::IsActive() const
+{
+	return mArena != NULL;
+}
+
+unsigned long ParseSession::GetAllocatedObjectsCount() const
+{
+	return mArena ? mArena->GetObjectsCount() : 0;
+}
+
+unsigned long ParseSession::GetAllocatedBlocksCount() const
+{
+	return mArena ? mArena->GetBlocksCount() : 0;
+}
+
+LongBufferSizeType ParseSession::GetAllocatedBytes() const
+{
+	return mArena ? mArena->GetBytes() : 0;
+}
+
+void* ParseSession::AllocateObject(size_t inSize)
+{
+	if(sActiveArena)
+	{
+		void* result = sActiveArena->Allocate(inSize);
+		if(result)
+			return result;
+	}
+
+	ObjectAllocationHeader* header = (ObjectAllocationHeader*)::operator new(sizeof(ObjectAllocationHeader) + inSize);
+	header->mArena = NULL;
+	return header + 1;
+}
+
+void ParseSession::FreeObject(void* inMemory)
+{
+	if(!inMemory)
+		return;
+
+	ObjectAllocationHeader* header = (ObjectAllocationHeader*)inMemory - 1;
+	if(header->mArena)
+		header->mArena->Release();
+	else
+		::operator delete(header);
+}
+
+static PDFObject* PromoteObject(PDFObject* inObject)
+{
+	switch(inObject->GetType())
+	{
+		case PDFObject::ePDFObjectBoolean:
+			return new PDFBoolean(((PDFBoolean*)inObject)->GetValue());
+		case PDFObject::ePDFObjectLiteralString:
+			return new PDFLiteralString(((PDFLiteralString*)inObject)->GetValue());
+		case PDFObject::ePDFObjectHexString:
+			return new PDFHexString(((PDFHexString*)inObject)->GetValue());
+		case PDFObject::ePDFObjectNull:
+			return new PDFNull();
+		case PDFObject::ePDFObjectName:
+			return new PDFName(((PDFName*)inObject)->GetValue());
+		case PDFObject::ePDFObjectInteger:
+			return new PDFInteger(((PDFInteger*)inObject)->GetValue());
+		case PDFObject::ePDFObjectReal:
+			return new PDFReal(((PDFReal*)inObject)->GetValue());
+		case PDFObject::ePDFObjectSymbol:
+			return new PDFSymbol(((PDFSymbol*)inObject)->GetValue());
+		case PDFObject::ePDFObjectIndirectObjectReference:
+			return new PDFIndirectObjectReference(((PDFIndirectObjectReference*)inObject)->mObjectID,
+													((PDFIndirectObjectReference*)inObject)->mVersion);
+		case PDFObject::ePDFObjectArray:
+		{
+			PDFArray* result = new PDFArray();
+			SingleValueContainerIterator<PDFObjectVector> it = ((PDFArray*)inObject)->GetIterator();
+			while(it.MoveNext())
+			{
+				PDFObject* item = PromoteObject(it.GetItem());
+				result->AppendObject(item);
+				item->Release();
+			}
+			return result;
+		}
+		case PDFObject::ePDFObjectDictionary:
+		{
+			PDFDictionary* result = new PDFDictionary();
+			MapIterator<PDFNameToPDFObjectMap> it = ((PDFDictionary*)inObject)->GetIterator();
+			while(it.MoveNext())
+			{
+				PDFObject* key = PromoteObject(it.GetKey());
+				PDFObject* value = PromoteObject(it.GetValue());
+				result->Insert((PDFName*)key,value);
+				key->Release();
+				value->Release();
+			}
+			return result;
+		}
+		case PDFObject::ePDFObjectStream:
+		{
+			PDFDictionary* streamDictionary = ((PDFStreamInput*)inObject)->QueryStreamDictionary();
+			PDFObject* dictionary = PromoteObject(streamDictionary);
+			streamDictionary->Release();
+			// stream input takes ownership of the dictionary
+			return new PDFStreamInput((PDFDictionary*)dictionary,((PDFStreamInput*)inObject)->GetStreamContentStart());
+		}
+	}
+	return NULL;
+}
+
+PDFObject* ParseSession::Promote(PDFObject* inObject)
+{
+	if(!inObject)
+		return NULL;
+
+	// suspend the active session, if any, so the copy is allocated from the heap
+	ParseSessionSuspension suspension;
+	return PromoteObject(inObject);
+}
+
+ParseSessionSuspension::ParseSessionSuspension(void)
+{
+	mSuspendedArena = sActiveArena;
+	sActiveArena = NULL;
+}
+
+ParseSessionSuspension::~ParseSessionSuspension(void)
+{
+	sActiveArena = mSuspendedArena;
+}
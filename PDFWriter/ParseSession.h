@@ -0,0 +1,89 @@
+/*
+   Source File : ParseSession.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "IOBasicTypes.h"
+
+#include <stddef.h>
+
+class PDFObject;
+class ParseSessionArena;
+
+/*
+	Parse session. While a session is active on a thread, PDF objects created on that thread [objects parsed by PDFParser and
+	PDFObjectParser, as well as objects created directly] are allocated from the session arena - large blocks from which
+	objects are carved one after the other - instead of each being allocated separately from the heap. The arena blocks are
+	freed in bulk, once the session ended and all objects allocated from it were released.
+	Meant for explicitly scoped, short lived parsing work, such as copying a page [see PDFParsingOptions::UseParseSessions], where
+	many small objects are parsed, used and dropped. Objects kept after the session ended remain valid [they retain the arena blocks
+	until released], so to keep a long lived object without keeping the whole arena, Promote it to a heap allocated copy.
+	Objects that go into long lived caches are allocated with the session suspended [see ParseSessionSuspension]. PDFParser does so
+	for objects that it keeps in its parsed objects cache, so with that cache on, objects fetched via PDFParser::ParseNewObject are
+	not allocated from the session.
+	Sessions are RAII scopes. nested sessions on the same thread take over until they end, where the enclosing session
+	becomes active again. a session that's constructed with inStart = false does nothing, so it's easy to make it optional.
+	Note that only the objects themselves come from the arena. their content [strings, dictionary and array containers] is still
+	heap allocated.
+*/
+
+class ParseSession
+{
+public:
+	ParseSession(bool inStart = true);
+	~ParseSession(void);
+
+	bool IsActive() const;
+
+	// statistics. objects that were allocated from this session arena, and blocks allocated for them
+	unsigned long GetAllocatedObjectsCount() const;
+	unsigned long GetAllocatedBlocksCount() const;
+	IOBasicTypes::LongBufferSizeType GetAllocatedBytes() const;
+
+	// returns a heap allocated deep copy of inObject, independent of any session [also when a session is active].
+	// the returned object is owned by the caller [release when done]. NULL for NULL
+	static PDFObject* Promote(PDFObject* inObject);
+
+	// allocation hooks for PDFObject
+	static void* AllocateObject(size_t inSize);
+	static void FreeObject(void* inMemory);
+
+private:
+	ParseSessionArena* mArena;
+	ParseSessionArena* mEnclosingArena;
+
+	// a session is a scope, not a value
+	ParseSession(const ParseSession&);
+	ParseSession& operator=(const ParseSession&);
+};
+
+// suspends the active parse session of the thread, if any, for its scope. objects created in it are heap allocated
+class ParseSessionSuspension
+{
+public:
+	ParseSessionSuspension(void);
+	~ParseSessionSuspension(void);
+
+private:
+	ParseSessionArena* mSuspendedArena;
+
+	ParseSessionSuspension(const ParseSessionSuspension&);
+	ParseSessionSuspension& operator=(const ParseSessionSuspension&);
+};
@@ -0,0 +1,227 @@
+/*
+   Source File : ParsedObjectsCache.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ParsedObjectsCache.h"
+#include "PDFObject.h"
+#include "PDFArray.h"
+#include "PDFDictionary.h"
+#include "PDFName.h"
+#include "PDFLiteralString.h"
+#include "PDFHexString.h"
+#include "PDFSymbol.h"
+#include "PDFStreamInput.h"
+#include "PDFBoolean.h"
+#include "PDFNull.h"
+#include "PDFInteger.h"
+#include "PDFReal.h"
+#include "PDFIndirectObjectReference.h"
+
+using namespace IOBasicTypes;
+
+ParsedObjectsCache::ParsedObjectsCache(void)
+{
+	mBudget = 0;
+	mEvictionPolicy = eParsedObjectsCacheEvictLeastRecentlyUsed;
+	mCachedSize = 0;
+	mHits = 0;
+	mMisses = 0;
+	mEvictions = 0;
+}
+
+ParsedObjectsCache::~ParsedObjectsCache(void)
+{
+	Reset();
+}
+
+void ParsedObjectsCache::SetBudget(LongBufferSizeType inBudget)
+{
+	mBudget = inBudget;
+	EvictTillSize(mBudget);
+}
+
+LongBufferSizeType ParsedObjectsCache::GetBudget()
+{
+	return mBudget;
+}
+
+void ParsedObjectsCache::SetEvictionPolicy(EParsedObjectsCacheEvictionPolicy inEvictionPolicy)
+{
+	mEvictionPolicy = inEvictionPolicy;
+}
+
+EParsedObjectsCacheEvictionPolicy ParsedObjectsCache::GetEvictionPolicy()
+{
+	return mEvictionPolicy;
+}
+
+LongBufferSizeType ParsedObjectsCache::GetCachedSize()
+{
+	return mCachedSize;
+}
+
+unsigned long ParsedObjectsCache::GetCachedObjectsCount()
+{
+	return (unsigned long)mObjects.size();
+}
+
+PDFObject* ParsedObjectsCache::Find(ObjectIDType inObjectID)
+{
+	ObjectIDTypeToParsedObjectsCacheEntryMap::iterator it = mObjects.find(inObjectID);
+	if(it == mObjects.end())
+	{
+		++mMisses;
+		return NULL;
+	}
+
+	++mHits;
+
+	// only LRU cares about usage. the other policies keep parsing order
+	if(eParsedObjectsCacheEvictLeastRecentlyUsed == mEvictionPolicy)
+		mUsageOrder.splice(mUsageOrder.begin(),mUsageOrder,it->second.mUsagePosition);
+
+	it->second.mObject->AddRef();
+	return it->second.mObject;
+}
+
+bool ParsedObjectsCache::Insert(ObjectIDType inObjectID,PDFObject* inObject)
+{
+	if(!inObject || mObjects.find(inObjectID) != mObjects.end())
+		return false;
+
+	LongBufferSizeType objectSize = EstimateObjectSize(inObject);
+	if(objectSize > mBudget)
+		return false;
+
+	if(eParsedObjectsCacheEvictNone == mEvictionPolicy)
+	{
+		if(mCachedSize + objectSize > mBudget)
+			return false;
+	}
+	else
+		EvictTillSize(mBudget - objectSize);
+
+	ParsedObjectsCacheEntry entry;
+
+	inObject->AddRef();
+	mUsageOrder.push_front(inObjectID);
+	entry.mObject = inObject;
+	entry.mSize = objectSize;
+	entry.mUsagePosition = mUsageOrder.begin();
+	mObjects.insert(ObjectIDTypeToParsedObjectsCacheEntryMap::value_type(inObjectID,entry));
+	mCachedSize+= objectSize;
+	return true;
+}
+
+void ParsedObjectsCache::EvictTillSize(LongBufferSizeType inSize)
+{
+	while(mCachedSize > inSize && mUsageOrder.size() > 0)
+	{
+		ObjectIDTypeToParsedObjectsCacheEntryMap::iterator it = mObjects.find(mUsageOrder.back());
+		mCachedSize-= it->second.mSize;
+		it->second.mObject->Release();
+		mObjects.erase(it);
+		mUsageOrder.pop_back();
+		++mEvictions;
+	}
+}
+
+unsigned long ParsedObjectsCache::GetHits()
+{
+	return mHits;
+}
+
+unsigned long ParsedObjectsCache::GetMisses()
+{
+	return mMisses;
+}
+
+unsigned long ParsedObjectsCache::GetEvictions()
+{
+	return mEvictions;
+}
+
+void ParsedObjectsCache::ResetCounters()
+{
+	mHits = 0;
+	mMisses = 0;
+	mEvictions = 0;
+}
+
+void ParsedObjectsCache::Reset()
+{
+	ObjectIDTypeToParsedObjectsCacheEntryMap::iterator it = mObjects.begin();
+	for(; it != mObjects.end(); ++it)
+		it->second.mObject->Release();
+	mObjects.clear();
+	mUsageOrder.clear();
+	mCachedSize = 0;
+	ResetCounters();
+}
+
+LongBufferSizeType ParsedObjectsCache::EstimateObjectSize(PDFObject* inObject)
+{
+	switch(inObject->GetType())
+	{
+		case PDFObject::ePDFObjectBoolean:
+			return sizeof(PDFBoolean);
+		case PDFObject::ePDFObjectNull:
+			return sizeof(PDFNull);
+		case PDFObject::ePDFObjectInteger:
+			return sizeof(PDFInteger);
+		case PDFObject::ePDFObjectReal:
+			return sizeof(PDFReal);
+		case PDFObject::ePDFObjectIndirectObjectReference:
+			return sizeof(PDFIndirectObjectReference);
+		case PDFObject::ePDFObjectLiteralString:
+			return sizeof(PDFLiteralString) + ((PDFLiteralString*)inObject)->GetValue().size();
+		case PDFObject::ePDFObjectHexString:
+			return sizeof(PDFHexString) + ((PDFHexString*)inObject)->GetValue().size();
+		case PDFObject::ePDFObjectName:
+			return sizeof(PDFName) + ((PDFName*)inObject)->GetValue().size();
+		case PDFObject::ePDFObjectSymbol:
+			return sizeof(PDFSymbol) + ((PDFSymbol*)inObject)->GetValue().size();
+		case PDFObject::ePDFObjectArray:
+		{
+			LongBufferSizeType size = sizeof(PDFArray);
+			SingleValueContainerIterator<PDFObjectVector> it = ((PDFArray*)inObject)->GetIterator();
+			while(it.MoveNext())
+				size+= sizeof(PDFObject*) + EstimateObjectSize(it.GetItem());
+			return size;
+		}
+		case PDFObject::ePDFObjectDictionary:
+		{
+			LongBufferSizeType size = sizeof(PDFDictionary);
+			MapIterator<PDFNameToPDFObjectMap> it = ((PDFDictionary*)inObject)->GetIterator();
+			while(it.MoveNext())
+				// map node overhead is roughly 4 pointers
+				size+= 4*sizeof(void*) + EstimateObjectSize(it.GetKey()) + EstimateObjectSize(it.GetValue());
+			return size;
+		}
+		case PDFObject::ePDFObjectStream:
+		{
+			// stream data is not held in memory, just the stream dictionary
+			PDFDictionary* streamDictionary = ((PDFStreamInput*)inObject)->QueryStreamDictionary();
+			LongBufferSizeType size = sizeof(PDFStreamInput) + EstimateObjectSize(streamDictionary);
+			streamDictionary->Release();
+			return size;
+		}
+	}
+	return sizeof(PDFObject);
+}
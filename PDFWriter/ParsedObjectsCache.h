@@ -0,0 +1,106 @@
+/*
+   Source File : ParsedObjectsCache.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "ObjectsBasicTypes.h"
+#include "IOBasicTypes.h"
+
+#include <list>
+#include <map>
+#include <utility>
+
+class PDFObject;
+
+/*
+	Memory bounded cache of parsed indirect objects, keyed by object ID.
+	PDFParser uses it to return an already parsed object (with AddRef) when the same object is fetched again,
+	instead of seeking and tokenizing it again. objects are shared between all fetchers, so they should be treated as read only.
+	Object sizes are estimated from their content, and do not account for allocator overhead.
+*/
+
+enum EParsedObjectsCacheEvictionPolicy
+{
+	// evict the objects that were not fetched for the longest time
+	eParsedObjectsCacheEvictLeastRecentlyUsed,
+	// evict the objects that were parsed first, regardless of usage
+	eParsedObjectsCacheEvictFirstParsed,
+	// don't evict. once the budget is used up, newly parsed objects are not cached
+	eParsedObjectsCacheEvictNone
+};
+
+typedef std::list<ObjectIDType> ObjectIDTypeList;
+
+struct ParsedObjectsCacheEntry
+{
+	PDFObject* mObject;
+	IOBasicTypes::LongBufferSizeType mSize;
+	ObjectIDTypeList::iterator mUsagePosition;
+};
+
+typedef std::map<ObjectIDType,ParsedObjectsCacheEntry> ObjectIDTypeToParsedObjectsCacheEntryMap;
+
+class ParsedObjectsCache
+{
+public:
+	ParsedObjectsCache(void);
+	~ParsedObjectsCache(void);
+
+	// budget is the total estimated size in bytes of objects that the cache may hold. 0 disables caching.
+	// lowering the budget evicts objects as required (with eParsedObjectsCacheEvictNone as well)
+	void SetBudget(IOBasicTypes::LongBufferSizeType inBudget);
+	IOBasicTypes::LongBufferSizeType GetBudget();
+	void SetEvictionPolicy(EParsedObjectsCacheEvictionPolicy inEvictionPolicy);
+	EParsedObjectsCacheEvictionPolicy GetEvictionPolicy();
+	IOBasicTypes::LongBufferSizeType GetCachedSize();
+	unsigned long GetCachedObjectsCount();
+
+	// returns the cached object after calling AddRef, or NULL if it's not in the cache. counts a hit or a miss
+	PDFObject* Find(ObjectIDType inObjectID);
+
+	// cache a newly parsed object. the cache calls AddRef, so the caller keeps its own reference.
+	// returns false if the object was not cached (too large, or no room with eParsedObjectsCacheEvictNone)
+	bool Insert(ObjectIDType inObjectID,PDFObject* inObject);
+
+	// usage statistics, since creation or last Reset/ResetCounters
+	unsigned long GetHits();
+	unsigned long GetMisses();
+	unsigned long GetEvictions();
+	void ResetCounters();
+
+	// releases all cached objects and resets counters. budget and policy are kept
+	void Reset();
+
+	// estimated memory size of an object, including its direct child objects
+	static IOBasicTypes::LongBufferSizeType EstimateObjectSize(PDFObject* inObject);
+
+private:
+	IOBasicTypes::LongBufferSizeType mBudget;
+	EParsedObjectsCacheEvictionPolicy mEvictionPolicy;
+	IOBasicTypes::LongBufferSizeType mCachedSize;
+	// eviction order. next to evict at the back
+	ObjectIDTypeList mUsageOrder;
+	ObjectIDTypeToParsedObjectsCacheEntryMap mObjects;
+	unsigned long mHits;
+	unsigned long mMisses;
+	unsigned long mEvictions;
+
+	void EvictTillSize(IOBasicTypes::LongBufferSizeType inSize);
+};
@@ -0,0 +1,287 @@
+/*
+   Source File : ParsedXrefTable.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ParsedXrefTable.h"
+
+#include <string.h>
+
+using namespace IOBasicTypes;
+
+static Byte BytesRequiredFor(unsigned long long inValue)
+{
+	Byte result = 1;
+	while(result < 8 && (inValue >> (8*result)) != 0)
+		++result;
+	return result;
+}
+
+static unsigned long long ReadValue(const Byte* inBuffer,Byte inWidth)
+{
+	unsigned long long result = 0;
+	for(Byte i=0;i<inWidth;++i)
+		result |= ((unsigned long long)inBuffer[i]) << (8*i);
+	return result;
+}
+
+static void WriteValue(Byte* inBuffer,Byte inWidth,unsigned long long inValue)
+{
+	for(Byte i=0;i<inWidth;++i)
+	{
+		inBuffer[i] = (Byte)(inValue & 0xff);
+		inValue >>= 8;
+	}
+}
+
+ParsedXrefTable::ParsedXrefTable(void)
+{
+	mSize = 0;
+	mFileSize = 0;
+	mPositionWidth = 4;
+	mRevisionWidth = 1;
+}
+
+ParsedXrefTable::ParsedXrefTable(const ParsedXrefTable& inOther)
+{
+	mSize = 0;
+	Assign(inOther);
+}
+
+ParsedXrefTable::~ParsedXrefTable(void)
+{
+	FreePages();
+}
+
+ParsedXrefTable& ParsedXrefTable::operator=(const ParsedXrefTable& inOther)
+{
+	if(this != &inOther)
+		Assign(inOther);
+	return *this;
+}
+
+void ParsedXrefTable::Assign(const ParsedXrefTable& inOther)
+{
+	FreePages();
+	mSize = inOther.mSize;
+	mFileSize = inOther.mFileSize;
+	mPositionWidth = inOther.mPositionWidth;
+	mRevisionWidth = inOther.mRevisionWidth;
+	mPages.resize(inOther.mPages.size(),NULL);
+	for(size_t i=0;i<inOther.mPages.size();++i)
+	{
+		if(!inOther.mPages[i])
+			continue;
+		mPages[i] = AllocatePage();
+		memcpy(mPages[i],inOther.mPages[i],XREF_TABLE_PAGE_SIZE*(1 + mPositionWidth + mRevisionWidth));
+	}
+}
+
+void ParsedXrefTable::FreePages()
+{
+	BytePointerVector::iterator it = mPages.begin();
+	for(; it != mPages.end(); ++it)
+		delete[] *it;
+	mPages.clear();
+}
+
+void ParsedXrefTable::Reset(ObjectIDType inSize,LongFilePositionType inFileSize)
+{
+	FreePages();
+	mSize = 0;
+	mFileSize = inFileSize;
+	// positions of objects in object streams are object stream IDs, which are smaller than the file size in any sane file
+	mPositionWidth = BytesRequiredFor(inFileSize > 0 ? (unsigned long long)inFileSize : 0);
+	// generation numbers are mostly 0, and object stream indexes are mostly small. widen when required
+	mRevisionWidth = 1;
+	ExtendToSize(inSize);
+}
+
+ObjectIDType ParsedXrefTable::GetSize() const
+{
+	return mSize;
+}
+
+LongFilePositionType ParsedXrefTable::GetFileSize() const
+{
+	return mFileSize;
+}
+
+void ParsedXrefTable::ExtendToSize(ObjectIDType inSize)
+{
+	if(inSize <= mSize)
+		return;
+
+	mSize = inSize;
+	mPages.resize((size_t)((mSize + XREF_TABLE_PAGE_SIZE - 1) >> XREF_TABLE_PAGE_BITS),NULL);
+}
+
+Byte* ParsedXrefTable::AllocatePage() const
+{
+	// [types column][positions column][revisions column]
+	Byte* page = new Byte[XREF_TABLE_PAGE_SIZE*(1 + mPositionWidth + mRevisionWidth)];
+	memset(page,eXrefEntryUndefined,XREF_TABLE_PAGE_SIZE);
+	memset(page + XREF_TABLE_PAGE_SIZE,0,XREF_TABLE_PAGE_SIZE*(mPositionWidth + mRevisionWidth));
+	return page;
+}
+
+Byte* ParsedXrefTable::GetPositionsColumn(Byte* inPage) const
+{
+	return inPage + XREF_TABLE_PAGE_SIZE;
+}
+
+Byte* ParsedXrefTable::GetRevisionsColumn(Byte* inPage) const
+{
+	return inPage + XREF_TABLE_PAGE_SIZE*(1 + mPositionWidth);
+}
+
+EXrefEntryType ParsedXrefTable::GetType(ObjectIDType inObjectID) const
+{
+	if(inObjectID >= mSize)
+		return eXrefEntryUndefined;
+	Byte* page = mPages[(size_t)(inObjectID >> XREF_TABLE_PAGE_BITS)];
+	return page ? (EXrefEntryType)page[inObjectID & (XREF_TABLE_PAGE_SIZE - 1)] : eXrefEntryUndefined;
+}
+
+LongFilePositionType ParsedXrefTable::GetPosition(ObjectIDType inObjectID) const
+{
+	if(inObjectID >= mSize)
+		return 0;
+	Byte* page = mPages[(size_t)(inObjectID >> XREF_TABLE_PAGE_BITS)];
+	if(!page)
+		return 0;
+	return (LongFilePositionType)ReadValue(GetPositionsColumn(page) + (inObjectID & (XREF_TABLE_PAGE_SIZE - 1))*mPositionWidth,mPositionWidth);
+}
+
+unsigned long ParsedXrefTable::GetRevision(ObjectIDType inObjectID) const
+{
+	if(inObjectID >= mSize)
+		return 0;
+	Byte* page = mPages[(size_t)(inObjectID >> XREF_TABLE_PAGE_BITS)];
+	if(!page)
+		return 0;
+	return (unsigned long)ReadValue(GetRevisionsColumn(page) + (inObjectID & (XREF_TABLE_PAGE_SIZE - 1))*mRevisionWidth,mRevisionWidth);
+}
+
+XrefEntryInput ParsedXrefTable::GetEntry(ObjectIDType inObjectID) const
+{
+	XrefEntryInput result;
+	result.mType = GetType(inObjectID);
+	if(result.mType != eXrefEntryUndefined)
+	{
+		result.mObjectPosition = GetPosition(inObjectID);
+		result.mRivision = GetRevision(inObjectID);
+	}
+	return result;
+}
+
+void ParsedXrefTable::SetEntry(ObjectIDType inObjectID,LongFilePositionType inPosition,unsigned long inRevision,EXrefEntryType inType)
+{
+	if(inObjectID >= mSize)
+		return;
+
+	// values that don't fit the current widths [bad positions, or large revisions] require widening the whole table. rare
+	Byte positionWidth = BytesRequiredFor(inPosition > 0 ? (unsigned long long)inPosition : 0);
+	Byte revisionWidth = BytesRequiredFor(inRevision);
+	if(positionWidth > mPositionWidth || revisionWidth > mRevisionWidth)
+		Widen(positionWidth > mPositionWidth ? positionWidth : mPositionWidth,revisionWidth > mRevisionWidth ? revisionWidth : mRevisionWidth);
+
+	Byte*& page = mPages[(size_t)(inObjectID >> XREF_TABLE_PAGE_BITS)];
+	if(!page)
+		page = AllocatePage();
+
+	size_t indexInPage = (size_t)(inObjectID & (XREF_TABLE_PAGE_SIZE - 1));
+	page[indexInPage] = (Byte)inType;
+	WriteValue(GetPositionsColumn(page) + indexInPage*mPositionWidth,mPositionWidth,inPosition > 0 ? (unsigned long long)inPosition : 0);
+	WriteValue(GetRevisionsColumn(page) + indexInPage*mRevisionWidth,mRevisionWidth,inRevision);
+}
+
+void ParsedXrefTable::Widen(Byte inPositionWidth,Byte inRevisionWidth)
+{
+	Byte oldPositionWidth = mPositionWidth;
+	Byte oldRevisionWidth = mRevisionWidth;
+
+	for(BytePointerVector::iterator it = mPages.begin(); it != mPages.end(); ++it)
+	{
+		if(!*it)
+			continue;
+
+		Byte* oldPage = *it;
+		Byte* oldPositions = oldPage + XREF_TABLE_PAGE_SIZE;
+		Byte* oldRevisions = oldPage + XREF_TABLE_PAGE_SIZE*(1 + oldPositionWidth);
+
+		mPositionWidth = inPositionWidth;
+		mRevisionWidth = inRevisionWidth;
+		Byte* newPage = AllocatePage();
+		memcpy(newPage,oldPage,XREF_TABLE_PAGE_SIZE);
+		for(size_t i=0;i<XREF_TABLE_PAGE_SIZE;++i)
+		{
+			WriteValue(GetPositionsColumn(newPage) + i*mPositionWidth,mPositionWidth,ReadValue(oldPositions + i*oldPositionWidth,oldPositionWidth));
+			WriteValue(GetRevisionsColumn(newPage) + i*mRevisionWidth,mRevisionWidth,ReadValue(oldRevisions + i*oldRevisionWidth,oldRevisionWidth));
+		}
+		mPositionWidth = oldPositionWidth;
+		mRevisionWidth = oldRevisionWidth;
+
+		delete[] oldPage;
+		*it = newPage;
+	}
+
+	mPositionWidth = inPositionWidth;
+	mRevisionWidth = inRevisionWidth;
+}
+
+void ParsedXrefTable::Merge(const ParsedXrefTable& inTable)
+{
+	ExtendToSize(inTable.mSize);
+
+	for(size_t pageIndex = 0; pageIndex < inTable.mPages.size(); ++pageIndex)
+	{
+		Byte* page = inTable.mPages[pageIndex];
+		if(!page)
+			continue;
+
+		// common case of merging into an empty part of the table with the same widths. copy the whole page
+		if(!mPages[pageIndex] && mPositionWidth == inTable.mPositionWidth && mRevisionWidth == inTable.mRevisionWidth)
+		{
+			Byte* newPage = AllocatePage();
+			memcpy(newPage,page,XREF_TABLE_PAGE_SIZE*(1 + mPositionWidth + mRevisionWidth));
+			mPages[pageIndex] = newPage;
+			continue;
+		}
+
+		ObjectIDType firstObjectID = ((ObjectIDType)pageIndex) << XREF_TABLE_PAGE_BITS;
+		for(size_t i=0;i<XREF_TABLE_PAGE_SIZE;++i)
+		{
+			if(page[i] == eXrefEntryUndefined)
+				continue;
+			ObjectIDType objectID = firstObjectID + i;
+			SetEntry(objectID,inTable.GetPosition(objectID),inTable.GetRevision(objectID),(EXrefEntryType)page[i]);
+		}
+	}
+}
+
+LongBufferSizeType ParsedXrefTable::GetAllocatedSize() const
+{
+	LongBufferSizeType result = mPages.capacity()*sizeof(Byte*);
+	for(BytePointerVector::const_iterator it = mPages.begin(); it != mPages.end(); ++it)
+	{
+		if(*it)
+			result += XREF_TABLE_PAGE_SIZE*(1 + mPositionWidth + mRevisionWidth);
+	}
+	return result;
+}
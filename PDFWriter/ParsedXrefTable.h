@@ -0,0 +1,107 @@
+/*
+   Source File : ParsedXrefTable.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "ObjectsBasicTypes.h"
+#include "IOBasicTypes.h"
+
+#include <vector>
+
+/*
+	Compact store for the xref of a parsed PDF.
+	Entries are kept in pages of XREF_TABLE_PAGE_SIZE entries, each holding a column of types, a column of positions
+	and a column of revisions. positions are stored with just enough bytes to hold the parsed file size, and revisions
+	with just enough bytes for the largest revision seen, so an entry normally takes 5 to 7 bytes. Pages are allocated only
+	when an entry in them is set, so extending the table, or keeping a sparse table for an incremental update section,
+	costs next to nothing.
+*/
+
+enum EXrefEntryType
+{
+	eXrefEntryExisting,
+	eXrefEntryDelete,
+	eXrefEntryStreamObject,
+	eXrefEntryUndefined
+};
+
+struct XrefEntryInput
+{
+	XrefEntryInput(){mObjectPosition = 0;mRivision=0;mType = eXrefEntryUndefined;}
+
+	// well...it's more like...the first number in a pair on an xref, and the second one. the names
+	// are true only for "n" type of entries
+	IOBasicTypes::LongFilePositionType mObjectPosition;
+	unsigned long mRivision;
+	EXrefEntryType mType;	
+};
+
+#define XREF_TABLE_PAGE_BITS 12
+#define XREF_TABLE_PAGE_SIZE (1<<XREF_TABLE_PAGE_BITS)
+
+typedef std::vector<IOBasicTypes::Byte*> BytePointerVector;
+
+class ParsedXrefTable
+{
+public:
+	ParsedXrefTable(void);
+	ParsedXrefTable(const ParsedXrefTable& inOther);
+	~ParsedXrefTable(void);
+
+	ParsedXrefTable& operator=(const ParsedXrefTable& inOther);
+
+	// drop all entries, and setup for a table of inSize entries, for a file of inFileSize bytes
+	void Reset(ObjectIDType inSize,IOBasicTypes::LongFilePositionType inFileSize);
+	ObjectIDType GetSize() const;
+	IOBasicTypes::LongFilePositionType GetFileSize() const;
+	// grow the table. new entries are undefined. does nothing if the table is already as large
+	void ExtendToSize(ObjectIDType inSize);
+
+	// get an entry. entries that were not set, or are out of range, are undefined
+	XrefEntryInput GetEntry(ObjectIDType inObjectID) const;
+	EXrefEntryType GetType(ObjectIDType inObjectID) const;
+	IOBasicTypes::LongFilePositionType GetPosition(ObjectIDType inObjectID) const;
+	unsigned long GetRevision(ObjectIDType inObjectID) const;
+
+	// set an entry. inObjectID must be lower than the table size
+	void SetEntry(ObjectIDType inObjectID,IOBasicTypes::LongFilePositionType inPosition,unsigned long inRevision,EXrefEntryType inType);
+
+	// set all entries that are defined in inTable (extending this table if inTable is larger). the work is in
+	// proportion to the parts of inTable that have any entries
+	void Merge(const ParsedXrefTable& inTable);
+
+	// bytes allocated for entries
+	IOBasicTypes::LongBufferSizeType GetAllocatedSize() const;
+
+private:
+	ObjectIDType mSize;
+	IOBasicTypes::LongFilePositionType mFileSize;
+	BytePointerVector mPages;
+	// widths, in bytes, of the positions and revisions columns
+	IOBasicTypes::Byte mPositionWidth;
+	IOBasicTypes::Byte mRevisionWidth;
+
+	void FreePages();
+	void Assign(const ParsedXrefTable& inOther);
+	IOBasicTypes::Byte* AllocatePage() const;
+	void Widen(IOBasicTypes::Byte inPositionWidth,IOBasicTypes::Byte inRevisionWidth);
+	IOBasicTypes::Byte* GetPositionsColumn(IOBasicTypes::Byte* inPage) const;
+	IOBasicTypes::Byte* GetRevisionsColumn(IOBasicTypes::Byte* inPage) const;
+};
@@ -0,0 +1,110 @@
+/*
+   Source File : PreparedFontProgram.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "PreparedFontProgram.h"
+#include "ObjectsContext.h"
+#include "DictionaryContext.h"
+#include "PDFStream.h"
+#include "InputStringBufferStream.h"
+#include "InputByteArrayStream.h"
+#include "OutputStreamTraits.h"
+#include "Trace.h"
+
+using namespace PDFHummus;
+
+bool PreparedFontProgram::GetFromFontsCache(SharedFontsCache* inFontsCache,const FontProgramKey& inKey)
+{
+	SharedCachedFontProgram cachedFontProgram = inFontsCache->GetFontProgram(inKey);
+	if(!cachedFontProgram)
+		return false;
+
+	mStatus = eSuccess;
+	mNotEmbedded = cachedFontProgram->mNotEmbedded;
+	mCachedFontProgram = cachedFontProgram;
+	mFontsCache = inFontsCache;
+	return true;
+}
+
+void PreparedFontProgram::AddToFontsCache(SharedFontsCache* inFontsCache,const FontProgramKey& inKey)
+{
+	if(mStatus != eSuccess)
+		return;
+
+	// write from the cache from now on, so the program gets encoded once
+	mCachedFontProgram = inFontsCache->AddFontProgram(inKey,mNotEmbedded,mFontProgram.str());
+	mFontsCache = inFontsCache;
+	mFontProgram.str(std::string());
+}
+
+IOBasicTypes::LongBufferSizeType PreparedFontProgram::GetFontProgramLength()
+{
+	return mCachedFontProgram ? mCachedFontProgram->mFontProgram.size() : (IOBasicTypes::LongBufferSizeType)mFontProgram.GetCurrentWritePosition();
+}
+
+static const std::string scFilter = "Filter";
+static const std::string scFlateDecode = "FlateDecode";
+
+EStatusCode PreparedFontProgram::WriteFontProgramStream(ObjectsContext* inObjectsContext,DictionaryContext* inStreamDictionary)
+{
+	SharedFontProgramContent content;
+	PDFStream* pdfStream;
+
+	if(mCachedFontProgram && inObjectsContext->IsFlateEncodingStreams())
+		content = mFontsCache->GetFlateEncodedFontProgram(mCachedFontProgram,inObjectsContext->GetFlateEncodingOptions());
+
+	if(content)
+	{
+		// already encoded, so write as is with the filter that StartPDFStream would have written
+		inStreamDictionary->WriteKey(scFilter);
+		inStreamDictionary->WriteNameValue(scFlateDecode);
+		pdfStream = inObjectsContext->StartUnfilteredPDFStream(inStreamDictionary);
+	}
+	else
+	{
+		if(mCachedFontProgram)
+			content = SharedFontProgramContent(mCachedFontProgram,&(mCachedFontProgram->mFontProgram));
+		pdfStream = inObjectsContext->StartPDFStream(inStreamDictionary);
+	}
+
+	// now copy the font program to the output stream
+	OutputStreamTraits streamCopier(pdfStream->GetWriteStream());
+	EStatusCode status;
+	if(content)
+	{
+		InputByteArrayStream fontProgramStream(content->size() > 0 ? (IOBasicTypes::Byte*)content->data() : NULL,content->size());
+		status = streamCopier.CopyToOutputStream(&fontProgramStream);
+	}
+	else
+	{
+		mFontProgram.pubseekoff(0,std::ios_base::beg);
+		InputStringBufferStream fontProgramStream(&mFontProgram);
+		status = streamCopier.CopyToOutputStream(&fontProgramStream);
+	}
+	if(status != eSuccess)
+	{
+		TRACE_LOG("PreparedFontProgram::WriteFontProgramStream, failed to copy font program into pdf stream");
+		delete pdfStream;
+		return status;
+	}
+
+	inObjectsContext->EndPDFStream(pdfStream);
+	delete pdfStream;
+	return status;
+}
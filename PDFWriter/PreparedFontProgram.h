@@ -0,0 +1,69 @@
+/*
+   Source File : PreparedFontProgram.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+/*
+	An embedded font program subset ahead of writing the font definitions. Subsetting a font does not involve the objects context,
+	so the used fonts programs may be prepared on worker threads, and then written in order, with the same result as
+	writing them one by one [see UsedFontsRepository::WriteUsedFontsDefinitions].
+	The subset font name is reserved when the program is created, on the writing thread, since it's part of CFF programs.
+	With a fonts cache, programs are kept in the cache after subsetting, and later documents take them from there [see SharedFontsCache].
+*/
+
+#include "EStatusCode.h"
+#include "MyStringBuf.h"
+#include "SharedFontsCache.h"
+
+#include <string>
+
+class ObjectsContext;
+class DictionaryContext;
+
+struct PreparedFontProgram
+{
+	PreparedFontProgram(const std::string& inSubsetFontName)
+	{
+		mSubsetFontName = inSubsetFontName;
+		mStatus = PDFHummus::eFailure;
+		mNotEmbedded = false;
+		mFontsCache = NULL;
+	}
+
+	std::string mSubsetFontName;
+
+	// result of subsetting. eFailure till prepared
+	PDFHummus::EStatusCode mStatus;
+	// font may not be embedded, per its license
+	bool mNotEmbedded;
+	MyStringBuf mFontProgram;
+	// program kept in a fonts cache. when set, the program is there and not in mFontProgram
+	SharedCachedFontProgram mCachedFontProgram;
+	SharedFontsCache* mFontsCache;
+
+	// take the program from the cache, if it has it. returns whether it did
+	bool GetFromFontsCache(SharedFontsCache* inFontsCache,const FontProgramKey& inKey);
+	// keep a successfully prepared program in the cache, for later documents
+	void AddToFontsCache(SharedFontsCache* inFontsCache,const FontProgramKey& inKey);
+
+	IOBasicTypes::LongBufferSizeType GetFontProgramLength();
+	// write the program as a stream, with inStreamDictionary holding the font file keys. a cached program that's already
+	// flate encoded per the document settings is written as is
+	PDFHummus::EStatusCode WriteFontProgramStream(ObjectsContext* inObjectsContext,DictionaryContext* inStreamDictionary);
+};
@@ -24,12 +24,18 @@
 #include <locale>
 #include <sstream>
 #include <iomanip>
+#include <math.h>
+#include <float.h>
 
 using namespace IOBasicTypes;
 
+const unsigned short PrimitiveObjectsWriter::scDefaultDecimalPlaces;
+static const unsigned short scMaxDecimalPlaces = 10;
+
 PrimitiveObjectsWriter::PrimitiveObjectsWriter(IByteWriter* inStreamForWriting)
 {
 	mStreamForWriting = inStreamForWriting;
+	mDecimalPlaces = scDefaultDecimalPlaces;
 }
 
 PrimitiveObjectsWriter::~PrimitiveObjectsWriter(void)
@@ -90,12 +96,30 @@ it is recommended but not required for characters whose codes are outside the ra
 	WriteTokenSeparator(inSeparate);
 }
 
+// writes the decimal digits of inValue to the end of the buffer ending at inBufferEnd, returning the first digit position
+static IOBasicTypes::Byte* FormatUnsignedBackwards(unsigned long long inValue,IOBasicTypes::Byte* inBufferEnd)
+{
+	IOBasicTypes::Byte* position = inBufferEnd;
+	do
+	{
+		*(--position) = (IOBasicTypes::Byte)('0' + inValue % 10);
+		inValue /= 10;
+	} while(inValue != 0);
+	return position;
+}
+
 void PrimitiveObjectsWriter::WriteInteger(long long inIntegerToken,ETokenSeparator inSeparate)
 {
-	char buffer[512];
+	// sign + 20 digits + separator
+	IOBasicTypes::Byte buffer[24];
+	IOBasicTypes::Byte* bufferEnd = buffer + sizeof(buffer);
 
-	SAFE_SPRINTF_1(buffer,512,"%lld",inIntegerToken);
-	mStreamForWriting->Write((const IOBasicTypes::Byte *)buffer,strlen(buffer));
+	// unsigned negation, so that LLONG_MIN is fine too
+	IOBasicTypes::Byte* start = FormatUnsignedBackwards(inIntegerToken < 0 ? 0ULL - (unsigned long long)inIntegerToken : (unsigned long long)inIntegerToken,bufferEnd);
+	if(inIntegerToken < 0)
+		*(--start) = '-';
+
+	mStreamForWriting->Write(start,bufferEnd - start);
 	WriteTokenSeparator(inSeparate);
 }
 
@@ -141,19 +165,81 @@ void PrimitiveObjectsWriter::WriteLiteralString(const std::string& inString,ETok
 	WriteTokenSeparator(inSeparate);
 }
 
+static const double scPowersOf10[] = {1.0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10};
+// largest scaled value that is still safe to round into an integer (2^53)
+static const double scMaxScaledValue = 9007199254740992.0;
+
 void PrimitiveObjectsWriter::WriteDouble(double inDoubleToken,ETokenSeparator inSeparate)
+{
+	// scale to an integer with the required decimal places, and write its digits directly. this avoids the locale
+	// and allocations of a stream based formatting. values too large for that (or nan/inf) use the stream path.
+	double scaled = (inDoubleToken < 0 ? -inDoubleToken : inDoubleToken) * scPowersOf10[mDecimalPlaces];
+	if(!(scaled < scMaxScaledValue))
+	{
+		WriteDoubleWithStream(inDoubleToken);
+		WriteTokenSeparator(inSeparate);
+		return;
+	}
+
+	// the stream path rounds the exact value of the double. scaling may be off by half a unit in the last place, so
+	// when the fraction is that close to a half (or is exactly a half, which the stream rounds to even) the rounding
+	// direction is not known here, and the stream path decides it
+	double floorValue = floor(scaled);
+	double fraction = scaled - floorValue;
+	if(fabs(fraction - 0.5) <= scaled * DBL_EPSILON)
+	{
+		WriteDoubleWithStream(inDoubleToken);
+		WriteTokenSeparator(inSeparate);
+		return;
+	}
+
+	unsigned long long rounded = (unsigned long long)floorValue + (fraction > 0.5 ? 1 : 0);
+	unsigned long long divisor = (unsigned long long)scPowersOf10[mDecimalPlaces];
+	unsigned long long integerPart = rounded / divisor;
+	unsigned long long fractionPart = rounded % divisor;
+
+	// sign + 16 digits + decimal point
+	IOBasicTypes::Byte buffer[32];
+	IOBasicTypes::Byte* bufferEnd = buffer + sizeof(buffer);
+	IOBasicTypes::Byte* start = bufferEnd;
+
+	if(fractionPart != 0)
+	{
+		// trim trailing zeros, then write the remaining decimal places, with leading zeros
+		unsigned short decimalPlaces = mDecimalPlaces;
+		while(fractionPart % 10 == 0)
+		{
+			fractionPart /= 10;
+			--decimalPlaces;
+		}
+		for(unsigned short i=0; i < decimalPlaces; ++i)
+		{
+			*(--start) = (IOBasicTypes::Byte)('0' + fractionPart % 10);
+			fractionPart /= 10;
+		}
+		*(--start) = '.';
+	}
+	start = FormatUnsignedBackwards(integerPart,start);
+	// no negative zeros
+	if(inDoubleToken < 0 && rounded != 0)
+		*(--start) = '-';
+
+	mStreamForWriting->Write(start,bufferEnd - start);
+	WriteTokenSeparator(inSeparate);
+}
+
+void PrimitiveObjectsWriter::WriteDoubleWithStream(double inDoubleToken)
 {
 	// make sure we get proper decimal point writing
 	std::stringstream s;
 	// use classic locale for no worries writing
 	s.imbue(std::locale::classic());
-	s<<std::fixed<<inDoubleToken;
+	s<<std::fixed<<std::setprecision(mDecimalPlaces)<<inDoubleToken;
 	std::string result = s.str();
 
 	LongBufferSizeType sizeToWrite = DetermineDoubleTrimmedLength(result);
 
 	mStreamForWriting->Write((const IOBasicTypes::Byte *)(result.c_str()),sizeToWrite);
-	WriteTokenSeparator(inSeparate);
 }
 
 size_t PrimitiveObjectsWriter::DetermineDoubleTrimmedLength(const std::string& inString)
@@ -205,6 +291,16 @@ void PrimitiveObjectsWriter::SetStreamForWriting(IByteWriter* inStreamForWriting
 	mStreamForWriting = inStreamForWriting;
 }
 
+void PrimitiveObjectsWriter::SetDecimalPlaces(unsigned short inDecimalPlaces)
+{
+	mDecimalPlaces = inDecimalPlaces > scMaxDecimalPlaces ? scMaxDecimalPlaces : inDecimalPlaces;
+}
+
+unsigned short PrimitiveObjectsWriter::GetDecimalPlaces()
+{
+	return mDecimalPlaces;
+}
+
 static const IOBasicTypes::Byte scOpenBracketSpace[2] = {'[',' '};
 void PrimitiveObjectsWriter::StartArray()
 {
@@ -32,10 +32,17 @@ class PrimitiveObjectsWriter
 {
 public:
 	PrimitiveObjectsWriter(IByteWriter* inStreamForWriting = NULL);
+
+	static const unsigned short scDefaultDecimalPlaces = 6;
 	~PrimitiveObjectsWriter(void);
 
 	void SetStreamForWriting(IByteWriter* inStreamForWriting);
 
+	// number of decimal places used when writing real numbers. trailing zeros are trimmed anyways.
+	// default is 6, max is 10. PDF coordinates rarely require more than 3-4.
+	void SetDecimalPlaces(unsigned short inDecimalPlaces);
+	unsigned short GetDecimalPlaces();
+
 	// Token Writing
 	void WriteTokenSeparator(ETokenSeparator inSeparate);
 	void EndLine();
@@ -58,6 +65,8 @@ public:
 
 private:
 	IByteWriter* mStreamForWriting;
+	unsigned short mDecimalPlaces;
 
+	void WriteDoubleWithStream(double inDoubleToken);
 	size_t DetermineDoubleTrimmedLength(const std::string& inString);
 };
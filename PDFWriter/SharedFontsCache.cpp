@@ -0,0 +1,344 @@
+/*
+   Source File : SharedFontsCache.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "SharedFontsCache.h"
+#include "FreeTypeWrapper.h"
+#include "OpenTypeFileInput.h"
+#include "InputFile.h"
+#include "InputByteArrayStream.h"
+#include "OutputFlateEncodeStream.h"
+#include "OutputStringBufferStream.h"
+#include "OutputStreamTraits.h"
+#include "Trace.h"
+
+using namespace PDFHummus;
+
+bool FontFaceKey::operator<(const FontFaceKey& inOther) const
+{
+	if(mFontFilePath != inOther.mFontFilePath)
+		return mFontFilePath < inOther.mFontFilePath;
+	if(mOptionalMetricsFilePath != inOther.mOptionalMetricsFilePath)
+		return mOptionalMetricsFilePath < inOther.mOptionalMetricsFilePath;
+	return mFontIndex < inOther.mFontIndex;
+}
+
+bool FontProgramKey::operator<(const FontProgramKey& inOther) const
+{
+	if(mFontFilePath != inOther.mFontFilePath)
+		return mFontFilePath < inOther.mFontFilePath;
+	if(mFontIndex != inOther.mFontIndex)
+		return mFontIndex < inOther.mFontIndex;
+	if(mSubsetFontName != inOther.mSubsetFontName)
+		return mSubsetFontName < inOther.mSubsetFontName;
+	if(mGlyphIDs != inOther.mGlyphIDs)
+		return mGlyphIDs < inOther.mGlyphIDs;
+	return mCIDMapping < inOther.mCIDMapping;
+}
+
+SharedFontsCache::SharedFontsCache(void)
+{
+	mFreeType = NULL;
+	mLoadedFacesCount = 0;
+	mReusedFacesCount = 0;
+	mReadFontFilesCount = 0;
+	mParsedFontsCount = 0;
+	mFontProgramsSize = 0;
+	mFontProgramsSizeLimit = 32*1024*1024;
+	mKeptFontProgramsCount = 0;
+	mReusedFontProgramsCount = 0;
+}
+
+SharedFontsCache::~SharedFontsCache(void)
+{
+	DoneIdleFaces();
+	if(mAcquiredFaces.size() > 0)
+		TRACE_LOG1("SharedFontsCache::~SharedFontsCache, %ld faces are still in use. make sure the cache outlives the documents using it",(long)mAcquiredFaces.size());
+	delete mFreeType;
+}
+
+void SharedFontsCache::DoneIdleFaces()
+{
+	FontFaceKeyToFTFaceVectorMap::iterator it = mIdleFaces.begin();
+	for(; it != mIdleFaces.end(); ++it)
+	{
+		FTFaceVector::iterator itFaces = it->second.begin();
+		for(; itFaces != it->second.end(); ++itFaces)
+			mFreeType->DoneFace(*itFaces);
+	}
+	mIdleFaces.clear();
+}
+
+FT_Face SharedFontsCache::AcquireFace(const std::string& inFontFilePath,const std::string& inOptionalMetricsFilePath,long inFontIndex)
+{
+	std::lock_guard<std::mutex> lock(mLock);
+	FontFaceKey key(inFontFilePath,inOptionalMetricsFilePath,inFontIndex);
+	FT_Face face = NULL;
+
+	FontFaceKeyToFTFaceVectorMap::iterator it = mIdleFaces.find(key);
+	if(it != mIdleFaces.end() && it->second.size() > 0)
+	{
+		face = it->second.back();
+		it->second.pop_back();
+		++mReusedFacesCount;
+	}
+	else
+	{
+		// FreeType faces are loaded and released under the lock, as these are not thread safe for a shared library
+		if(!mFreeType)
+			mFreeType = new FreeTypeWrapper();
+
+		if(inOptionalMetricsFilePath.size() > 0)
+			face = mFreeType->NewFace(inFontFilePath,inOptionalMetricsFilePath,inFontIndex);
+		else
+			face = mFreeType->NewFace(inFontFilePath,inFontIndex);
+		if(!face)
+			return NULL;
+		++mLoadedFacesCount;
+	}
+
+	mAcquiredFaces.insert(FTFaceToFontFaceKeyMap::value_type(face,key));
+	return face;
+}
+
+void SharedFontsCache::ReleaseFace(FT_Face inFace)
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	FTFaceToFontFaceKeyMap::iterator it = mAcquiredFaces.find(inFace);
+	if(it == mAcquiredFaces.end())
+	{
+		TRACE_LOG("SharedFontsCache::ReleaseFace, face was not acquired from this cache");
+		return;
+	}
+
+	mIdleFaces[it->second].push_back(inFace);
+	mAcquiredFaces.erase(it);
+}
+
+SharedFontFileContent SharedFontsCache::GetFontFileContent(const std::string& inFontFilePath)
+{
+	std::lock_guard<std::mutex> lock(mLock);
+	return GetFontFileContentLocked(inFontFilePath);
+}
+
+SharedFontFileContent SharedFontsCache::GetFontFileContentLocked(const std::string& inFontFilePath)
+{
+	StringToSharedFontFileContentMap::iterator it = mFontFilesContent.find(inFontFilePath);
+	if(it != mFontFilesContent.end())
+		return it->second;
+
+	InputFile fontFile;
+	if(fontFile.OpenFile(inFontFilePath) != eSuccess)
+	{
+		TRACE_LOG1("SharedFontsCache::GetFontFileContent, cannot open font file at %s",inFontFilePath.c_str());
+		return SharedFontFileContent();
+	}
+
+	std::shared_ptr<FontFileContent> content(new FontFileContent((size_t)fontFile.GetFileSize()));
+	if(content->size() > 0 && fontFile.GetInputStream()->Read(&((*content)[0]),content->size()) != content->size())
+	{
+		TRACE_LOG1("SharedFontsCache::GetFontFileContent, failed to read font file at %s",inFontFilePath.c_str());
+		return SharedFontFileContent();
+	}
+	++mReadFontFilesCount;
+
+	return mFontFilesContent.insert(StringToSharedFontFileContentMap::value_type(inFontFilePath,content)).first->second;
+}
+
+SharedOpenTypeFileInput SharedFontsCache::GetTrueTypeInput(const std::string& inFontFilePath,unsigned short inFontIndex)
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	StringAndUShortToSharedOpenTypeFileInputMap::iterator it = mTrueTypeInputs.find(StringAndUShort(inFontFilePath,inFontIndex));
+	if(it != mTrueTypeInputs.end())
+		return it->second;
+
+	SharedFontFileContent content = GetFontFileContentLocked(inFontFilePath);
+	if(!content)
+		return SharedOpenTypeFileInput();
+
+	// only the tables are used once parsed, so the stream may go away
+	InputByteArrayStream contentStream(content->size() > 0 ? (IOBasicTypes::Byte*)&((*content)[0]) : NULL,content->size());
+	SharedOpenTypeFileInput trueTypeInput(new OpenTypeFileInput());
+	if(trueTypeInput->ReadOpenTypeFile(&contentStream,inFontIndex) != eSuccess || trueTypeInput->GetOpenTypeFontType() != EOpenTypeTrueType)
+	{
+		TRACE_LOG1("SharedFontsCache::GetTrueTypeInput, failed to read true type font at %s",inFontFilePath.c_str());
+		return SharedOpenTypeFileInput();
+	}
+	++mParsedFontsCount;
+
+	return mTrueTypeInputs.insert(StringAndUShortToSharedOpenTypeFileInputMap::value_type(StringAndUShort(inFontFilePath,inFontIndex),trueTypeInput)).first->second;
+}
+
+SharedCachedFontProgram SharedFontsCache::GetFontProgram(const FontProgramKey& inKey)
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	FontProgramKeyToSharedCachedFontProgramMap::iterator it = mFontPrograms.find(inKey);
+	if(it == mFontPrograms.end())
+		return SharedCachedFontProgram();
+
+	++mReusedFontProgramsCount;
+	return it->second;
+}
+
+SharedCachedFontProgram SharedFontsCache::AddFontProgram(const FontProgramKey& inKey,bool inNotEmbedded,const std::string& inFontProgram)
+{
+	SharedCachedFontProgram fontProgram(new CachedFontProgram(inNotEmbedded,inFontProgram));
+	std::lock_guard<std::mutex> lock(mLock);
+
+	if(inFontProgram.size() > mFontProgramsSizeLimit)
+		return fontProgram;
+
+	std::pair<FontProgramKeyToSharedCachedFontProgramMap::iterator,bool> result =
+		mFontPrograms.insert(FontProgramKeyToSharedCachedFontProgramMap::value_type(inKey,fontProgram));
+	if(!result.second)
+		return result.first->second;
+
+	fontProgram->mIsKept = true;
+	mFontProgramsOrder.push_back(inKey);
+	mFontProgramsSize += inFontProgram.size();
+	++mKeptFontProgramsCount;
+	DropFontProgramsOverLimit();
+	return fontProgram;
+}
+
+static SharedFontProgramContent FlateEncode(const std::string& inFontProgram,const FlateEncodingOptions& inOptions)
+{
+	// same as writing the program to a compressed PDF stream, for the same result
+	MyStringBuf encodedBuffer;
+	OutputStringBufferStream encodedStream(&encodedBuffer);
+	OutputFlateEncodeStream flateEncodeStream;
+	InputByteArrayStream fontProgramStream(inFontProgram.size() > 0 ? (IOBasicTypes::Byte*)inFontProgram.data() : NULL,inFontProgram.size());
+
+	flateEncodeStream.SetEncodingOptions(inOptions);
+	flateEncodeStream.Assign(&encodedStream);
+	OutputStreamTraits streamCopier(&flateEncodeStream);
+	EStatusCode status = streamCopier.CopyToOutputStream(&fontProgramStream);
+	flateEncodeStream.Assign(NULL);
+	if(status != eSuccess)
+	{
+		TRACE_LOG("SharedFontsCache::GetFlateEncodedFontProgram, failed to encode font program");
+		return SharedFontProgramContent();
+	}
+
+	return SharedFontProgramContent(new std::string(encodedBuffer.str()));
+}
+
+SharedFontProgramContent SharedFontsCache::GetFlateEncodedFontProgram(const SharedCachedFontProgram& inFontProgram,const FlateEncodingOptions& inOptions)
+{
+	{
+		std::lock_guard<std::mutex> lock(mLock);
+		if(inFontProgram->mFlateEncodedFontProgram && inFontProgram->mFlateEncodingOptions == inOptions)
+			return inFontProgram->mFlateEncodedFontProgram;
+	}
+
+	// encode outside of the lock. the raw program doesn't change
+	SharedFontProgramContent encodedFontProgram = FlateEncode(inFontProgram->mFontProgram,inOptions);
+	if(!encodedFontProgram)
+		return encodedFontProgram;
+
+	std::lock_guard<std::mutex> lock(mLock);
+	if(inFontProgram->mIsKept)
+	{
+		if(inFontProgram->mFlateEncodedFontProgram)
+			mFontProgramsSize -= inFontProgram->mFlateEncodedFontProgram->size();
+		mFontProgramsSize += encodedFontProgram->size();
+	}
+	inFontProgram->mFlateEncodedFontProgram = encodedFontProgram;
+	inFontProgram->mFlateEncodingOptions = inOptions;
+	DropFontProgramsOverLimit();
+	return encodedFontProgram;
+}
+
+void SharedFontsCache::SetFontProgramsSizeLimit(unsigned long long inSizeLimit)
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	mFontProgramsSizeLimit = inSizeLimit;
+	DropFontProgramsOverLimit();
+}
+
+void SharedFontsCache::DropFontProgramsOverLimit()
+{
+	// documents still using a dropped program keep it till they're done with it
+	while(mFontProgramsSize > mFontProgramsSizeLimit && mFontProgramsOrder.size() > 0)
+	{
+		FontProgramKeyToSharedCachedFontProgramMap::iterator it = mFontPrograms.find(mFontProgramsOrder.front());
+		mFontProgramsSize -= it->second->mFontProgram.size();
+		if(it->second->mFlateEncodedFontProgram)
+			mFontProgramsSize -= it->second->mFlateEncodedFontProgram->size();
+		it->second->mIsKept = false;
+		mFontPrograms.erase(it);
+		mFontProgramsOrder.pop_front();
+	}
+}
+
+void SharedFontsCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+
+	DoneIdleFaces();
+	mFontFilesContent.clear();
+	mTrueTypeInputs.clear();
+
+	FontProgramKeyToSharedCachedFontProgramMap::iterator it = mFontPrograms.begin();
+	for(; it != mFontPrograms.end(); ++it)
+		it->second->mIsKept = false;
+	mFontPrograms.clear();
+	mFontProgramsOrder.clear();
+	mFontProgramsSize = 0;
+}
+
+unsigned long SharedFontsCache::GetLoadedFacesCount()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+	return mLoadedFacesCount;
+}
+
+unsigned long SharedFontsCache::GetReusedFacesCount()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+	return mReusedFacesCount;
+}
+
+unsigned long SharedFontsCache::GetReadFontFilesCount()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+	return mReadFontFilesCount;
+}
+
+unsigned long SharedFontsCache::GetParsedFontsCount()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+	return mParsedFontsCount;
+}
+
+unsigned long SharedFontsCache::GetKeptFontProgramsCount()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+	return mKeptFontProgramsCount;
+}
+
+unsigned long SharedFontsCache::GetReusedFontProgramsCount()
+{
+	std::lock_guard<std::mutex> lock(mLock);
+	return mReusedFontProgramsCount;
+}
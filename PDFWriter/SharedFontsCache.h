@@ -0,0 +1,174 @@
+/*
+   Source File : SharedFontsCache.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "IOBasicTypes.h"
+#include "FlateEncodingOptions.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+class FreeTypeWrapper;
+class OpenTypeFileInput;
+
+/*
+	Cache of loaded fonts, for processes that create many documents with the same fonts.
+	Without it, each document loads its fonts with FreeType when they're first used, and reads and parses the font files
+	again when embedding them at the end. With it, these are kept between documents:
+	1. FreeType faces. a face is used by one document at a time, so faces are acquired by documents and returned to the cache
+	   when the documents are done with them, for later documents to use. concurrent documents using the same font each get their own face
+	2. font files content, so embedding reads them from memory
+	3. parsed TrueType tables, for TrueType subsetting. these are shared by all documents, and only read once parsed
+	4. embedded font programs, as subset for earlier documents, and their flate encoded form. a later document that embeds the same
+	   glyphs of a font (with the same subset font name, for CFF programs) writes the kept program, instead of subsetting and encoding
+	   the font again. programs are kept up to a total size [see SetFontProgramsSizeLimit], dropping the oldest ones first
+	Pass the cache with PDFCreationSettings::FontsCache. A cache may be shared by documents on multiple threads, and must
+	outlive the documents that use it.
+*/
+
+typedef std::vector<IOBasicTypes::Byte> FontFileContent;
+typedef std::shared_ptr<const FontFileContent> SharedFontFileContent;
+typedef std::shared_ptr<OpenTypeFileInput> SharedOpenTypeFileInput;
+
+struct FontFaceKey
+{
+	std::string mFontFilePath;
+	std::string mOptionalMetricsFilePath;
+	long mFontIndex;
+
+	FontFaceKey(const std::string& inFontFilePath,const std::string& inOptionalMetricsFilePath,long inFontIndex):
+		mFontFilePath(inFontFilePath),mOptionalMetricsFilePath(inOptionalMetricsFilePath),mFontIndex(inFontIndex){}
+
+	bool operator<(const FontFaceKey& inOther) const;
+};
+
+// an embedded font program is identified by the font, the subset glyphs in order, the CID mapping for CID CFF fonts,
+// and the subset font name for CFF programs, which include it. TrueType programs don't include the name, so have it empty
+struct FontProgramKey
+{
+	std::string mFontFilePath;
+	long mFontIndex;
+	std::string mSubsetFontName;
+	std::vector<unsigned int> mGlyphIDs;
+	std::vector<unsigned short> mCIDMapping;
+
+	FontProgramKey(const std::string& inFontFilePath,long inFontIndex,const std::string& inSubsetFontName,const std::vector<unsigned int>& inGlyphIDs):
+		mFontFilePath(inFontFilePath),mFontIndex(inFontIndex),mSubsetFontName(inSubsetFontName),mGlyphIDs(inGlyphIDs){}
+
+	bool operator<(const FontProgramKey& inOther) const;
+};
+
+typedef std::shared_ptr<const std::string> SharedFontProgramContent;
+
+struct CachedFontProgram
+{
+	// font may not be embedded, per its license. the program is then empty
+	bool mNotEmbedded;
+	std::string mFontProgram;
+	// the program flate encoded with mFlateEncodingOptions, once written to a compressed document. guarded by the cache lock
+	SharedFontProgramContent mFlateEncodedFontProgram;
+	FlateEncodingOptions mFlateEncodingOptions;
+	// whether the program is still kept by the cache, and counts for its size. guarded by the cache lock
+	bool mIsKept;
+
+	CachedFontProgram(bool inNotEmbedded,const std::string& inFontProgram):mNotEmbedded(inNotEmbedded),mFontProgram(inFontProgram),mIsKept(false){}
+};
+
+typedef std::shared_ptr<CachedFontProgram> SharedCachedFontProgram;
+
+typedef std::vector<FT_Face> FTFaceVector;
+typedef std::map<FontFaceKey,FTFaceVector> FontFaceKeyToFTFaceVectorMap;
+typedef std::map<FT_Face,FontFaceKey> FTFaceToFontFaceKeyMap;
+typedef std::map<std::string,SharedFontFileContent> StringToSharedFontFileContentMap;
+typedef std::pair<std::string,unsigned short> StringAndUShort;
+typedef std::map<StringAndUShort,SharedOpenTypeFileInput> StringAndUShortToSharedOpenTypeFileInputMap;
+typedef std::map<FontProgramKey,SharedCachedFontProgram> FontProgramKeyToSharedCachedFontProgramMap;
+typedef std::list<FontProgramKey> FontProgramKeyList;
+
+class SharedFontsCache
+{
+public:
+	SharedFontsCache(void);
+	~SharedFontsCache(void);
+
+	// get a face for the font, either one returned to the cache earlier or a newly loaded one. NULL if the font can't be loaded.
+	// the face is for the caller only, till returned with ReleaseFace [don't FT_Done_Face it]
+	FT_Face AcquireFace(const std::string& inFontFilePath,const std::string& inOptionalMetricsFilePath,long inFontIndex);
+	void ReleaseFace(FT_Face inFace);
+
+	// the font file content, read once. empty pointer if the file can't be read
+	SharedFontFileContent GetFontFileContent(const std::string& inFontFilePath);
+
+	// the font parsed as TrueType, parsed once. empty pointer if it can't be parsed. the tables are shared, so read only
+	SharedOpenTypeFileInput GetTrueTypeInput(const std::string& inFontFilePath,unsigned short inFontIndex);
+
+	// an embedded font program kept from an earlier document. empty pointer if there's none
+	SharedCachedFontProgram GetFontProgram(const FontProgramKey& inKey);
+	// keep a font program, after subsetting. returns the kept program, which is the one kept earlier if another document got there first
+	SharedCachedFontProgram AddFontProgram(const FontProgramKey& inKey,bool inNotEmbedded,const std::string& inFontProgram);
+	// the font program flate encoded with inOptions, encoding it if not done already. empty pointer if encoding fails
+	SharedFontProgramContent GetFlateEncodedFontProgram(const SharedCachedFontProgram& inFontProgram,const FlateEncodingOptions& inOptions);
+	// total size of the kept font programs, raw and encoded. 32MB by default. 0 means font programs are not kept
+	void SetFontProgramsSizeLimit(unsigned long long inSizeLimit);
+
+	// drop all that's kept. faces in use remain with their users, and are released when they return them
+	void Clear();
+
+	// statistics. faces loaded with FreeType and faces reused, font files read and fonts parsed
+	unsigned long GetLoadedFacesCount();
+	unsigned long GetReusedFacesCount();
+	unsigned long GetReadFontFilesCount();
+	unsigned long GetParsedFontsCount();
+	// font programs kept after subsetting, and font programs written from the cache instead of subsetting
+	unsigned long GetKeptFontProgramsCount();
+	unsigned long GetReusedFontProgramsCount();
+
+private:
+	std::mutex mLock;
+	FreeTypeWrapper* mFreeType;
+	FontFaceKeyToFTFaceVectorMap mIdleFaces;
+	FTFaceToFontFaceKeyMap mAcquiredFaces;
+	StringToSharedFontFileContentMap mFontFilesContent;
+	StringAndUShortToSharedOpenTypeFileInputMap mTrueTypeInputs;
+	unsigned long mLoadedFacesCount;
+	unsigned long mReusedFacesCount;
+	unsigned long mReadFontFilesCount;
+	unsigned long mParsedFontsCount;
+	FontProgramKeyToSharedCachedFontProgramMap mFontPrograms;
+	// kept programs keys, oldest first
+	FontProgramKeyList mFontProgramsOrder;
+	unsigned long long mFontProgramsSize;
+	unsigned long long mFontProgramsSizeLimit;
+	unsigned long mKeptFontProgramsCount;
+	unsigned long mReusedFontProgramsCount;
+
+	SharedFontFileContent GetFontFileContentLocked(const std::string& inFontFilePath);
+	void DoneIdleFaces();
+	void DropFontProgramsOverLimit();
+};
@@ -44,6 +44,8 @@ Trace::~Trace(void)
 
 void Trace::SetLogSettings(const std::string& inLogFilePath,bool inShouldLog,bool inPlaceUTF8Bom)
 {
+	std::lock_guard<std::mutex> lock(mLock);
+
 	mShouldLog = inShouldLog;
 	mPlaceUTF8Bom = inPlaceUTF8Bom;
 	mLogFilePath = inLogFilePath;
@@ -59,6 +61,8 @@ void Trace::SetLogSettings(const std::string& inLogFilePath,bool inShouldLog,boo
 
 void Trace::SetLogSettings(IByteWriter* inLogStream,bool inShouldLog)
 {
+	std::lock_guard<std::mutex> lock(mLock);
+
 	mShouldLog = inShouldLog;
 	mLogStream = inLogStream;
 	mPlaceUTF8Bom = false;
@@ -74,28 +78,17 @@ void Trace::SetLogSettings(IByteWriter* inLogStream,bool inShouldLog)
 
 void Trace::TraceToLog(const char* inFormat,...)
 {
-	if(mShouldLog)
-	{
-		if(NULL == mLog)
-		{
-			if(mLogStream)
-				mLog = new Log(mLogStream);
-			else
-				mLog = new Log(mLogFilePath,mPlaceUTF8Bom);
-		}
-
-		va_list argptr;
-		va_start(argptr, inFormat);
+	va_list argptr;
+	va_start(argptr, inFormat);
 
-		SAFE_VSPRINTF(mBuffer, MAX_TRACE_SIZE,inFormat,argptr);
-		va_end(argptr);
-
-		mLog->LogEntry(std::string(mBuffer));
-	}
+	TraceToLog(inFormat,argptr);
+	va_end(argptr);
 }
 
 void Trace::TraceToLog(const char* inFormat,va_list inList)
 {
+	std::lock_guard<std::mutex> lock(mLock);
+
 	if(mShouldLog)
 	{
 		if(NULL == mLog)
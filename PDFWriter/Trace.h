@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include <string>
+#include <mutex>
 
 
 
@@ -58,8 +59,8 @@ private:
 	bool mShouldLog;
 	bool mPlaceUTF8Bom;
 
-	// use the log
-	// make it lock safe
+	// tracing may happen from worker threads [e.g. when subsetting fonts], so it's serialized
+	std::mutex mLock;
 };
 
 
@@ -62,11 +62,24 @@ EStatusCode TrueTypeANSIFontWriter::WriteFont(	FreeTypeFaceWrapper& inFontInfo,
 
 	if (inEmbedFont)
 	{
-		fontName = inObjectsContext->GenerateSubsetFontPrefix() + scPlus + postscriptFontName;
-		EStatusCode status = embeddedFontWriter.WriteEmbeddedFont(inFontInfo,
-																	inFontOccurrence->GetGlyphIDsAsOrderedVector(),
-																	inObjectsContext,
-																	mEmbeddedFontFileObjectID);
+		EStatusCode status;
+
+		// the font program may have been subset ahead, with its name reserved then
+		if(inFontOccurrence->mPreparedFontProgram)
+		{
+			fontName = inFontOccurrence->mPreparedFontProgram->mSubsetFontName;
+			status = embeddedFontWriter.WriteEmbeddedFont(*(inFontOccurrence->mPreparedFontProgram),
+															inObjectsContext,
+															mEmbeddedFontFileObjectID);
+		}
+		else
+		{
+			fontName = inObjectsContext->GenerateSubsetFontPrefix() + scPlus + postscriptFontName;
+			status = embeddedFontWriter.WriteEmbeddedFont(inFontInfo,
+															inFontOccurrence->GetGlyphIDsAsOrderedVector(),
+															inObjectsContext,
+															mEmbeddedFontFileObjectID);
+		}
 		if (PDFHummus::eFailure == status)
 			return status;
 	}
@@ -78,6 +91,13 @@ EStatusCode TrueTypeANSIFontWriter::WriteFont(	FreeTypeFaceWrapper& inFontInfo,
 	return fontWriter.WriteFont(inFontInfo, inFontOccurrence, inObjectsContext, this, fontName);
 }
 
+void TrueTypeANSIFontWriter::PrepareEmbeddedFont(FreeTypeFaceWrapper& inFontInfo,WrittenFontRepresentation* inFontOccurrence)
+{
+	TrueTypeEmbeddedFontWriter embeddedFontWriter;
+
+	embeddedFontWriter.PrepareEmbeddedFont(inFontInfo,inFontOccurrence->GetGlyphIDsAsOrderedVector(),*(inFontOccurrence->mPreparedFontProgram));
+}
+
 static const std::string scTrueType = "TrueType";
 
 void TrueTypeANSIFontWriter::WriteSubTypeValue(DictionaryContext* inDictionary)
@@ -27,8 +27,9 @@
 
 using namespace PDFHummus;
 
-TrueTypeDescendentFontWriter::TrueTypeDescendentFontWriter(void)
+TrueTypeDescendentFontWriter::TrueTypeDescendentFontWriter(PreparedFontProgram* inPreparedFontProgram)
 {
+	mPreparedFontProgram = inPreparedFontProgram;
 }
 
 TrueTypeDescendentFontWriter::~TrueTypeDescendentFontWriter(void)
@@ -45,6 +46,15 @@ static UIntVector GetOrderedKeys(const UIntAndGlyphEncodingInfoVector& inMap)
 }
 
 
+void TrueTypeDescendentFontWriter::PrepareEmbeddedFont(FreeTypeFaceWrapper& inFontInfo,
+														const UIntAndGlyphEncodingInfoVector& inEncodedGlyphs,
+														PreparedFontProgram& outFontProgram)
+{
+	TrueTypeEmbeddedFontWriter embeddedFontWriter;
+
+	embeddedFontWriter.PrepareEmbeddedFont(inFontInfo, GetOrderedKeys(inEncodedGlyphs), outFontProgram);
+}
+
 EStatusCode TrueTypeDescendentFontWriter::WriteFont(	ObjectIDType inDecendentObjectID, 
 														const std::string& inFontName,
 														FreeTypeFaceWrapper& inFontInfo,
@@ -59,7 +69,9 @@ EStatusCode TrueTypeDescendentFontWriter::WriteFont(	ObjectIDType inDecendentObj
 	if (inEmbedFont)
 	{
 		TrueTypeEmbeddedFontWriter embeddedFontWriter;
-		EStatusCode status = embeddedFontWriter.WriteEmbeddedFont(inFontInfo, GetOrderedKeys(inEncodedGlyphs), inObjectsContext, mEmbeddedFontFileObjectID);
+		EStatusCode status = mPreparedFontProgram ?
+								embeddedFontWriter.WriteEmbeddedFont(*mPreparedFontProgram, inObjectsContext, mEmbeddedFontFileObjectID) :
+								embeddedFontWriter.WriteEmbeddedFont(inFontInfo, GetOrderedKeys(inEncodedGlyphs), inObjectsContext, mEmbeddedFontFileObjectID);
 
 		if (PDFHummus::eFailure == status)
 			return status;
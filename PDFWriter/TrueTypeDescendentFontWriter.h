@@ -25,9 +25,15 @@
 class TrueTypeDescendentFontWriter: public IDescendentFontWriter
 {
 public:
-	TrueTypeDescendentFontWriter(void);
+	// pass a font program prepared with PrepareEmbeddedFont, to write it instead of subsetting the font when writing
+	TrueTypeDescendentFontWriter(PreparedFontProgram* inPreparedFontProgram = NULL);
 	~TrueTypeDescendentFontWriter(void);
 
+	// subset the embedded font program ahead of writing. inEncodedGlyphs are as passed to WriteFont
+	static void PrepareEmbeddedFont(FreeTypeFaceWrapper& inFontInfo,
+									const UIntAndGlyphEncodingInfoVector& inEncodedGlyphs,
+									PreparedFontProgram& outFontProgram);
+
 	// IDescendentFontWriter implementation [used also as helper for the DescendentFontWriter]
 	virtual PDFHummus::EStatusCode WriteFont(	ObjectIDType inDecendentObjectID, 
 									const std::string& inFontName,
@@ -41,6 +47,7 @@ public:
 										ObjectsContext* inObjectsContext);
 
 private:
+	PreparedFontProgram* mPreparedFontProgram;
 
 	ObjectIDType mEmbeddedFontFileObjectID;
 };
@@ -37,6 +37,8 @@ using namespace PDFHummus;
 
 TrueTypeEmbeddedFontWriter::TrueTypeEmbeddedFontWriter(void):mFontFileReaderStream(NULL)
 {
+	mTrueTypeInput = &mTrueTypeFileInput;
+	mTrueTypeStream = NULL;
 }
 
 TrueTypeEmbeddedFontWriter::~TrueTypeEmbeddedFontWriter(void)
@@ -50,20 +52,44 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteEmbeddedFont(
 								ObjectsContext* inObjectsContext,
 								ObjectIDType& outEmbeddedFontObjectID)
 {
-	MyStringBuf rawFontProgram;
-	bool notEmbedded;
+	PreparedFontProgram fontProgram("");
+
+	PrepareEmbeddedFont(inFontInfo,inSubsetGlyphIDs,fontProgram);
+	return WriteEmbeddedFont(fontProgram,inObjectsContext,outEmbeddedFontObjectID);
+}
+
+void TrueTypeEmbeddedFontWriter::PrepareEmbeddedFont(	FreeTypeFaceWrapper& inFontInfo,
+														const UIntVector& inSubsetGlyphIDs,
+														PreparedFontProgram& outFontProgram)
+{
+	// true type subsets don't include the subset font name, so the same glyphs make the same program whatever the name
+	SharedFontsCache* fontsCache = inFontInfo.GetFontsCache();
+	FontProgramKey key(inFontInfo.GetFontFilePath(),inFontInfo.GetFontIndex(),"",inSubsetGlyphIDs);
+	if(fontsCache && outFontProgram.GetFromFontsCache(fontsCache,key))
+		return;
+
+	outFontProgram.mStatus = CreateTrueTypeSubset(inFontInfo,inSubsetGlyphIDs,outFontProgram.mNotEmbedded,outFontProgram.mFontProgram);
+	if(fontsCache)
+		outFontProgram.AddToFontsCache(fontsCache,key);
+}
+
+EStatusCode TrueTypeEmbeddedFontWriter::WriteEmbeddedFont(	
+								PreparedFontProgram& inFontProgram,
+								ObjectsContext* inObjectsContext,
+								ObjectIDType& outEmbeddedFontObjectID)
+{
 	EStatusCode status;
 
 	do
 	{
-		status = CreateTrueTypeSubset(inFontInfo,inSubsetGlyphIDs,notEmbedded,rawFontProgram);
+		status = inFontProgram.mStatus;
 		if(status != PDFHummus::eSuccess)
 		{
 			TRACE_LOG("TrueTypeEmbeddedFontWriter::WriteEmbeddedFont, failed to write embedded font program");
 			break;
 		}	
 
-		if(notEmbedded)
+		if(inFontProgram.mNotEmbedded)
 		{
 			// can't embed. mark succesful, and go back empty
 			outEmbeddedFontObjectID = 0;
@@ -78,24 +104,14 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteEmbeddedFont(
 		// Length1 (decompressed true type program length)
 
 		fontProgramDictionaryContext->WriteKey(scLength1);
-		fontProgramDictionaryContext->WriteIntegerValue(rawFontProgram.GetCurrentWritePosition());
-		rawFontProgram.pubseekoff(0,std::ios_base::beg);
-		PDFStream* pdfStream = inObjectsContext->StartPDFStream(fontProgramDictionaryContext);
+		fontProgramDictionaryContext->WriteIntegerValue(inFontProgram.GetFontProgramLength());
 
-
-		// now copy the created font program to the output stream
-		InputStringBufferStream fontProgramStream(&rawFontProgram);
-		OutputStreamTraits streamCopier(pdfStream->GetWriteStream());
-		status = streamCopier.CopyToOutputStream(&fontProgramStream);
+		status = inFontProgram.WriteFontProgramStream(inObjectsContext,fontProgramDictionaryContext);
 		if(status != PDFHummus::eSuccess)
 		{
 			TRACE_LOG("TrueTypeEmbeddedFontWriter::WriteEmbeddedFont, failed to copy font program into pdf stream");
 			break;
 		}
-
-
-		inObjectsContext->EndPDFStream(pdfStream);
-		delete pdfStream;
 	}while(false);
 
 	return status;
@@ -113,28 +129,18 @@ EStatusCode TrueTypeEmbeddedFontWriter::CreateTrueTypeSubset(	FreeTypeFaceWrappe
 	{
 		UIntVector subsetGlyphIDs = inSubsetGlyphIDs;
 
-		status = mTrueTypeFile.OpenFile(inFontInfo.GetFontFilePath());
-		if(status != PDFHummus::eSuccess)
-		{
-			TRACE_LOG1("TrueTypeEmbeddedFontWriter::CreateTrueTypeSubset, cannot open true type font file at %s",inFontInfo.GetFontFilePath().c_str());
-			break;
-		}
-
-		status = mTrueTypeInput.ReadOpenTypeFile(mTrueTypeFile.GetInputStream(),(unsigned short)inFontInfo.GetFontIndex());
+		status = OpenTrueTypeInput(inFontInfo);
 		if(status != PDFHummus::eSuccess)
-		{
-			TRACE_LOG("TrueTypeEmbeddedFontWriter::CreateTrueTypeSubset, failed to read true type file");
 			break;
-		}
 
-		if(mTrueTypeInput.GetOpenTypeFontType() != EOpenTypeTrueType)
+		if(mTrueTypeInput->GetOpenTypeFontType() != EOpenTypeTrueType)
 		{
 			TRACE_LOG("TrueTypeEmbeddedFontWriter::CreateTrueTypeSubset, font file is not true type, so there is an exceptions here. expecting true types only");
 			break;
 		}
 	
 		// see if font may be embedded
-		if(mTrueTypeInput.mOS2Exists && !FSType(mTrueTypeInput.mOS2.fsType).CanEmbed())
+		if(mTrueTypeInput->mOS2Exists && !FSType(mTrueTypeInput->mOS2.fsType).CanEmbed())
 		{
 			outNotEmbedded = true;
 			return PDFHummus::eSuccess;
@@ -199,7 +205,7 @@ EStatusCode TrueTypeEmbeddedFontWriter::CreateTrueTypeSubset(	FreeTypeFaceWrappe
 			break;
 		}
 
-		if(mTrueTypeInput.mCVTExists)
+		if(mTrueTypeInput->mCVTExists)
 		{
 			status = WriteCVT();
 			if(status != PDFHummus::eSuccess)
@@ -209,7 +215,7 @@ EStatusCode TrueTypeEmbeddedFontWriter::CreateTrueTypeSubset(	FreeTypeFaceWrappe
 			}
 		}
 
-		if(mTrueTypeInput.mFPGMExists)
+		if(mTrueTypeInput->mFPGMExists)
 		{
 			status = WriteFPGM();
 			if(status != PDFHummus::eSuccess)
@@ -219,7 +225,7 @@ EStatusCode TrueTypeEmbeddedFontWriter::CreateTrueTypeSubset(	FreeTypeFaceWrappe
 			}
 		}
 
-		if(mTrueTypeInput.mPREPExists)
+		if(mTrueTypeInput->mPREPExists)
 		{
 			status = WritePREP();
 			if(status != PDFHummus::eSuccess)
@@ -236,7 +242,7 @@ EStatusCode TrueTypeEmbeddedFontWriter::CreateTrueTypeSubset(	FreeTypeFaceWrappe
 			break;	
 		}
 
-        if(mTrueTypeInput.mOS2Exists)
+        if(mTrueTypeInput->mOS2Exists)
         {
             status = WriteOS2();
             if(status != PDFHummus::eSuccess)
@@ -273,10 +279,55 @@ EStatusCode TrueTypeEmbeddedFontWriter::CreateTrueTypeSubset(	FreeTypeFaceWrappe
 	}while(false);
 
 	delete[] locaTable;
-	mTrueTypeFile.CloseFile();
+	CloseTrueTypeInput();
 	return status;
 }
 
+EStatusCode TrueTypeEmbeddedFontWriter::OpenTrueTypeInput(FreeTypeFaceWrapper& inFontInfo)
+{
+	SharedFontsCache* fontsCache = inFontInfo.GetFontsCache();
+
+	if(fontsCache)
+	{
+		// with a cache, the font is read from memory, and its tables are parsed once for all documents
+		mTrueTypeFileContent = fontsCache->GetFontFileContent(inFontInfo.GetFontFilePath());
+		mSharedTrueTypeInput = fontsCache->GetTrueTypeInput(inFontInfo.GetFontFilePath(),(unsigned short)inFontInfo.GetFontIndex());
+		if(mTrueTypeFileContent && mSharedTrueTypeInput)
+		{
+			mTrueTypeFileContentStream.Assign(mTrueTypeFileContent->size() > 0 ? (IOBasicTypes::Byte*)&((*mTrueTypeFileContent)[0]) : NULL,mTrueTypeFileContent->size());
+			mTrueTypeStream = &mTrueTypeFileContentStream;
+			mTrueTypeInput = mSharedTrueTypeInput.get();
+			return PDFHummus::eSuccess;
+		}
+		mTrueTypeFileContent.reset();
+		mSharedTrueTypeInput.reset();
+	}
+
+	EStatusCode status = mTrueTypeFile.OpenFile(inFontInfo.GetFontFilePath());
+	if(status != PDFHummus::eSuccess)
+	{
+		TRACE_LOG1("TrueTypeEmbeddedFontWriter::OpenTrueTypeInput, cannot open true type font file at %s",inFontInfo.GetFontFilePath().c_str());
+		return status;
+	}
+	mTrueTypeStream = mTrueTypeFile.GetInputStream();
+	mTrueTypeInput = &mTrueTypeFileInput;
+
+	status = mTrueTypeInput->ReadOpenTypeFile(mTrueTypeStream,(unsigned short)inFontInfo.GetFontIndex());
+	if(status != PDFHummus::eSuccess)
+		TRACE_LOG("TrueTypeEmbeddedFontWriter::OpenTrueTypeInput, failed to read true type file");
+	return status;
+}
+
+void TrueTypeEmbeddedFontWriter::CloseTrueTypeInput()
+{
+	mTrueTypeFile.CloseFile();
+	mTrueTypeFileContentStream.Assign(NULL,0);
+	mTrueTypeFileContent.reset();
+	mSharedTrueTypeInput.reset();
+	mTrueTypeInput = &mTrueTypeFileInput;
+	mTrueTypeStream = NULL;
+}
+
 void TrueTypeEmbeddedFontWriter::AddDependentGlyphs(UIntVector& ioSubsetGlyphIDs)
 {
 	UIntSet glyphsSet;
@@ -307,13 +358,13 @@ bool TrueTypeEmbeddedFontWriter::AddComponentGlyphs(unsigned int inGlyphID,UIntS
 	UIntList::iterator itComponentGlyphs;
 	bool isComposite = false;
 
-	if(inGlyphID >= mTrueTypeInput.mMaxp.NumGlyphs)
+	if(inGlyphID >= mTrueTypeInput->mMaxp.NumGlyphs)
 	{
-		TRACE_LOG2("TrueTypeEmbeddedFontWriter::AddComponentGlyphs, error, requested glyph index %ld is larger than the maximum glyph index for this font which is %ld. ",inGlyphID,mTrueTypeInput.mMaxp.NumGlyphs-1);
+		TRACE_LOG2("TrueTypeEmbeddedFontWriter::AddComponentGlyphs, error, requested glyph index %ld is larger than the maximum glyph index for this font which is %ld. ",inGlyphID,mTrueTypeInput->mMaxp.NumGlyphs-1);
 		return false;
 	}
 
-	glyfTableEntry = mTrueTypeInput.mGlyf[inGlyphID];
+	glyfTableEntry = mTrueTypeInput->mGlyf[inGlyphID];
 	if(glyfTableEntry != NULL && glyfTableEntry->mComponentGlyphs.size() > 0)
 	{
 		isComposite = true;
@@ -353,9 +404,9 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteTrueTypeHeader()
 	unsigned short tableCount = 
 		9	// needs - cmap, glyf, head, hhea, hmtx, loca, maxp, name, OS/2
 		+
-		(mTrueTypeInput.mCVTExists ? 1:0) + // cvt
-		(mTrueTypeInput.mPREPExists ? 1:0) + // prep
-		(mTrueTypeInput.mFPGMExists ? 1:0); // fpgm
+		(mTrueTypeInput->mCVTExists ? 1:0) + // cvt
+		(mTrueTypeInput->mPREPExists ? 1:0) + // prep
+		(mTrueTypeInput->mFPGMExists ? 1:0); // fpgm
 
 	// here we go....
 	mPrimitivesWriter.WriteULONG(0x10000);
@@ -365,12 +416,12 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteTrueTypeHeader()
 	mPrimitivesWriter.WriteUSHORT(smallerPowerTwo);
 	mPrimitivesWriter.WriteUSHORT((tableCount - (1<<smallerPowerTwo)) << 4);
 
-	if (mTrueTypeInput.mOS2Exists)
+	if (mTrueTypeInput->mOS2Exists)
 		WriteEmptyTableEntry("OS/2", mOS2EntryWritingOffset);
 	WriteEmptyTableEntry("cmap", mCMAPEntryWritingOffset);
-	if(mTrueTypeInput.mCVTExists)
+	if(mTrueTypeInput->mCVTExists)
 		WriteEmptyTableEntry("cvt ",mCVTEntryWritingOffset);
-	if(mTrueTypeInput.mFPGMExists)
+	if(mTrueTypeInput->mFPGMExists)
 		WriteEmptyTableEntry("fpgm",mFPGMEntryWritingOffset);
 	WriteEmptyTableEntry("glyf",mGLYFEntryWritingOffset);
 	WriteEmptyTableEntry("head",mHEADEntryWritingOffset);
@@ -379,7 +430,7 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteTrueTypeHeader()
 	WriteEmptyTableEntry("loca",mLOCAEntryWritingOffset);
 	WriteEmptyTableEntry("maxp",mMAXPEntryWritingOffset);
 	WriteEmptyTableEntry("name",mNAMEEntryWritingOffset);
-	if(mTrueTypeInput.mPREPExists)
+	if(mTrueTypeInput->mPREPExists)
 		WriteEmptyTableEntry("prep",mPREPEntryWritingOffset);
 
 	mPrimitivesWriter.PadTo4();
@@ -415,7 +466,7 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteHead()
 	// set the checksum
 	// and store the offset to the checksum
 
-	TableEntry* tableEntry = mTrueTypeInput.GetTableEntry("head");
+	TableEntry* tableEntry = mTrueTypeInput->GetTableEntry("head");
 	LongFilePositionType startTableOffset;
 	OutputStreamTraits streamCopier(&mFontFileStream);
 	LongFilePositionType endOfStream;
@@ -423,8 +474,8 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteHead()
 	startTableOffset = mFontFileStream.GetCurrentPosition();
 
 	// copy and save the current position
-	mTrueTypeFile.GetInputStream()->SetPosition(tableEntry->Offset);
-	streamCopier.CopyToOutputStream(mTrueTypeFile.GetInputStream(),tableEntry->Length);
+	mTrueTypeStream->SetPosition(tableEntry->Offset);
+	streamCopier.CopyToOutputStream(mTrueTypeStream,tableEntry->Length);
 	mPrimitivesWriter.PadTo4();
 	endOfStream = mFontFileStream.GetCurrentPosition();
 
@@ -484,7 +535,7 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteHHea()
 	// copy as is, then possibly adjust the hmtx NumberOfHMetrics field, if the glyphs
 	// count is lower
 
-	TableEntry* tableEntry = mTrueTypeInput.GetTableEntry("hhea");
+	TableEntry* tableEntry = mTrueTypeInput->GetTableEntry("hhea");
 	LongFilePositionType startTableOffset;
 	OutputStreamTraits streamCopier(&mFontFileStream);
 	LongFilePositionType endOfStream;
@@ -492,13 +543,13 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteHHea()
 	startTableOffset = mFontFileStream.GetCurrentPosition();
 
 	// copy and save the current position
-	mTrueTypeFile.GetInputStream()->SetPosition(tableEntry->Offset);
-	streamCopier.CopyToOutputStream(mTrueTypeFile.GetInputStream(),tableEntry->Length);
+	mTrueTypeStream->SetPosition(tableEntry->Offset);
+	streamCopier.CopyToOutputStream(mTrueTypeStream,tableEntry->Length);
 	mPrimitivesWriter.PadTo4();
 	endOfStream = mFontFileStream.GetCurrentPosition();
 
 	// adjust the NumberOfHMetrics if necessary
-	if(mTrueTypeInput.mHHea.NumberOfHMetrics > mSubsetFontGlyphsCount)
+	if(mTrueTypeInput->mHHea.NumberOfHMetrics > mSubsetFontGlyphsCount)
 	{
 		mFontFileStream.SetPosition(startTableOffset + tableEntry->Length - 2);
 		mPrimitivesWriter.WriteUSHORT(mSubsetFontGlyphsCount);
@@ -526,15 +577,15 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteHMtx()
 
 	// write the table. write pairs until min(numberofhmetrics,mSubsetFontGlyphsCount)
 	// then if mSubsetFontGlyphsCount > numberofhmetrics writh the width metrics as well
-	unsigned numberOfHMetrics = std::min(mTrueTypeInput.mHHea.NumberOfHMetrics,mSubsetFontGlyphsCount);
+	unsigned numberOfHMetrics = std::min(mTrueTypeInput->mHHea.NumberOfHMetrics,mSubsetFontGlyphsCount);
 	unsigned short i=0;
 	for(;i<numberOfHMetrics;++i)
 	{
-		mPrimitivesWriter.WriteUSHORT(mTrueTypeInput.mHMtx[i].AdvanceWidth);
-		mPrimitivesWriter.WriteSHORT(mTrueTypeInput.mHMtx[i].LeftSideBearing);
+		mPrimitivesWriter.WriteUSHORT(mTrueTypeInput->mHMtx[i].AdvanceWidth);
+		mPrimitivesWriter.WriteSHORT(mTrueTypeInput->mHMtx[i].LeftSideBearing);
 	}
 	for(;i<mSubsetFontGlyphsCount;++i)
-		mPrimitivesWriter.WriteSHORT(mTrueTypeInput.mHMtx[i].LeftSideBearing);
+		mPrimitivesWriter.WriteSHORT(mTrueTypeInput->mHMtx[i].LeftSideBearing);
 
 	LongFilePositionType endOfTable = mFontFileStream.GetCurrentPosition();
 	mPrimitivesWriter.PadTo4();
@@ -555,7 +606,7 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteMaxp()
 {
 	// copy as is, then adjust the glyphs count
 
-	TableEntry* tableEntry = mTrueTypeInput.GetTableEntry("maxp");
+	TableEntry* tableEntry = mTrueTypeInput->GetTableEntry("maxp");
 	LongFilePositionType startTableOffset;
 	OutputStreamTraits streamCopier(&mFontFileStream);
 	LongFilePositionType endOfStream;
@@ -563,8 +614,8 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteMaxp()
 	startTableOffset = mFontFileStream.GetCurrentPosition();
 
 	// copy and save the current position
-	mTrueTypeFile.GetInputStream()->SetPosition(tableEntry->Offset);
-	streamCopier.CopyToOutputStream(mTrueTypeFile.GetInputStream(),tableEntry->Length);
+	mTrueTypeStream->SetPosition(tableEntry->Offset);
+	streamCopier.CopyToOutputStream(mTrueTypeStream,tableEntry->Length);
 	mPrimitivesWriter.PadTo4();
 	endOfStream = mFontFileStream.GetCurrentPosition();
 
@@ -601,7 +652,7 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteGlyf(const UIntVector& inSubsetGlyp
 	// k. write the glyphs table. you only need to write the glyphs you are actually using.
 	// while at it...update the locaTable
 
-	TableEntry* tableEntry = mTrueTypeInput.GetTableEntry("glyf");
+	TableEntry* tableEntry = mTrueTypeInput->GetTableEntry("glyf");
 	LongFilePositionType startTableOffset = mFontFileStream.GetCurrentPosition();
 	UIntVector::const_iterator it = inSubsetGlyphIDs.begin();
 	OutputStreamTraits streamCopier(&mFontFileStream);
@@ -612,21 +663,21 @@ EStatusCode TrueTypeEmbeddedFontWriter::WriteGlyf(const UIntVector& inSubsetGlyp
 	for(;it != inSubsetGlyphIDs.end() && eSuccess == status; ++it)
 	{
 		glyphIndex = *it;
-		if(glyphIndex >= mTrueTypeInput.mMaxp.NumGlyphs)
+		if(glyphIndex >= mTrueTypeInput->mMaxp.NumGlyphs)
 		{
-			TRACE_LOG2("TrueTypeEmbeddedFontWriter::WriteGlyf, error, requested glyph index %ld is larger than the maximum glyph index for this font which is %ld. ",glyphIndex,mTrueTypeInput.mMaxp.NumGlyphs-1);
+			TRACE_LOG2("TrueTypeEmbeddedFontWriter::WriteGlyf, error, requested glyph index %ld is larger than the maximum glyph index for this font which is %ld. ",glyphIndex,mTrueTypeInput->mMaxp.NumGlyphs-1);
 			status = eFailure;
 			break;
 		}
 
 		for(unsigned short i= previousGlyphIndexEnd + 1; i<=glyphIndex;++i)
 			inLocaTable[i] = inLocaTable[previousGlyphIndexEnd];
-		if(mTrueTypeInput.mGlyf[glyphIndex] != NULL)
+		if(mTrueTypeInput->mGlyf[glyphIndex] != NULL)
 		{
-			mTrueTypeFile.GetInputStream()->SetPosition(tableEntry->Offset + 
-															mTrueTypeInput.mLoca[glyphIndex]);
-			streamCopier.CopyToOutputStream(mTrueTypeFile.GetInputStream(),
-				mTrueTypeInput.mLoca[(glyphIndex) + 1] - mTrueTypeInput.mLoca[glyphIndex]);
+			mTrueTypeStream->SetPosition(tableEntry->Offset + 
+															mTrueTypeInput->mLoca[glyphIndex]);
+			streamCopier.CopyToOutputStream(mTrueTypeStream,
+				mTrueTypeInput->mLoca[(glyphIndex) + 1] - mTrueTypeInput->mLoca[glyphIndex]);
 		}
 		inLocaTable[glyphIndex + 1] = (unsigned long)(mFontFileStream.GetCurrentPosition() - startTableOffset);
 		previousGlyphIndexEnd = glyphIndex + 1;
@@ -705,7 +756,7 @@ EStatusCode TrueTypeEmbeddedFontWriter::CreateTableCopy(const char* inTableName,
 {
 	// copy as is, no adjustments required
 
-	TableEntry* tableEntry = mTrueTypeInput.GetTableEntry(inTableName);
+	TableEntry* tableEntry = mTrueTypeInput->GetTableEntry(inTableName);
 	LongFilePositionType startTableOffset;
 	OutputStreamTraits streamCopier(&mFontFileStream);
 	LongFilePositionType endOfStream;
@@ -713,8 +764,8 @@ EStatusCode TrueTypeEmbeddedFontWriter::CreateTableCopy(const char* inTableName,
 	startTableOffset = mFontFileStream.GetCurrentPosition();
 
 	// copy and save the current position
-	mTrueTypeFile.GetInputStream()->SetPosition(tableEntry->Offset);
-	streamCopier.CopyToOutputStream(mTrueTypeFile.GetInputStream(),tableEntry->Length);
+	mTrueTypeStream->SetPosition(tableEntry->Offset);
+	streamCopier.CopyToOutputStream(mTrueTypeStream,tableEntry->Length);
 	mPrimitivesWriter.PadTo4();
 	endOfStream = mFontFileStream.GetCurrentPosition();
 
@@ -25,10 +25,13 @@
 #include "OpenTypeFileInput.h"
 #include "OutputStringBufferStream.h"
 #include "InputFile.h"
+#include "InputByteArrayStream.h"
+#include "SharedFontsCache.h"
 #include "TrueTypePrimitiveWriter.h"
 #include "InputStringBufferStream.h"
 #include "OpenTypePrimitiveReader.h"
 #include "MyStringBuf.h"
+#include "PreparedFontProgram.h"
 
 #include <vector>
 #include <set>
@@ -52,9 +55,25 @@ public:
 									ObjectsContext* inObjectsContext,
 									ObjectIDType& outEmbeddedFontObjectID);
 
+	// same, in two steps. PrepareEmbeddedFont subsets the font into outFontProgram, and may run on a worker thread (as long as the
+	// font is not used elsewhere meanwhile). WriteEmbeddedFont then writes it
+	void PrepareEmbeddedFont(	FreeTypeFaceWrapper& inFontInfo,
+								const UIntVector& inSubsetGlyphIDs,
+								PreparedFontProgram& outFontProgram);
+	PDFHummus::EStatusCode WriteEmbeddedFont(	PreparedFontProgram& inFontProgram,
+									ObjectsContext* inObjectsContext,
+									ObjectIDType& outEmbeddedFontObjectID);
+
 private:
-	OpenTypeFileInput mTrueTypeInput;
+	// the font tables, either read here or shared from the fonts cache of the font
+	OpenTypeFileInput* mTrueTypeInput;
+	OpenTypeFileInput mTrueTypeFileInput;
+	SharedOpenTypeFileInput mSharedTrueTypeInput;
+	// the font file, either the file itself or its content in the fonts cache
+	IByteReaderWithPosition* mTrueTypeStream;
 	InputFile mTrueTypeFile;
+	SharedFontFileContent mTrueTypeFileContent;
+	InputByteArrayStream mTrueTypeFileContentStream;
 	OutputStringBufferStream mFontFileStream;
 	TrueTypePrimitiveWriter mPrimitivesWriter;
 	InputStringBufferStream mFontFileReaderStream; // now this might be confusing - i'm using a reader
@@ -82,6 +101,8 @@ private:
 										const UIntVector& inSubsetGlyphIDs,
 										bool& outNotEmbedded,
 										MyStringBuf& outFontProgram);
+	PDFHummus::EStatusCode OpenTrueTypeInput(FreeTypeFaceWrapper& inFontInfo);
+	void CloseTrueTypeInput();
 
 	void AddDependentGlyphs(UIntVector& ioSubsetGlyphIDs);
 	bool AddComponentGlyphs(unsigned int inGlyphID,UIntSet& ioComponents);
@@ -143,22 +143,46 @@ EStatusCode Type1ToCFFEmbeddedFontWriter::WriteEmbeddedFont(
 															ObjectsContext* inObjectsContext,
 															ObjectIDType& outEmbeddedFontObjectID)
 {
-	MyStringBuf rawFontProgram; 
-	bool notEmbedded;
+	PreparedFontProgram fontProgram(inSubsetFontName);
+
+	PrepareEmbeddedFont(inFontInfo,inSubsetGlyphIDs,fontProgram);
+	return WriteEmbeddedFont(fontProgram,inFontFile3SubType,inObjectsContext,outEmbeddedFontObjectID);
+}
+
+void Type1ToCFFEmbeddedFontWriter::PrepareEmbeddedFont(	FreeTypeFaceWrapper& inFontInfo,
+														const UIntVector& inSubsetGlyphIDs,
+														PreparedFontProgram& outFontProgram)
+{
+	SharedFontsCache* fontsCache = inFontInfo.GetFontsCache();
+	FontProgramKey key(inFontInfo.GetFontFilePath(),inFontInfo.GetFontIndex(),outFontProgram.mSubsetFontName,inSubsetGlyphIDs);
+	if(fontsCache && outFontProgram.GetFromFontsCache(fontsCache,key))
+		return;
+
 		// as oppose to true type, the reason for using a memory stream here is mainly peformance - i don't want to start
 		// setting file pointers and move in a file stream
+	outFontProgram.mStatus = CreateCFFSubset(inFontInfo,inSubsetGlyphIDs,outFontProgram.mSubsetFontName,outFontProgram.mNotEmbedded,outFontProgram.mFontProgram);
+	if(fontsCache)
+		outFontProgram.AddToFontsCache(fontsCache,key);
+}
+
+EStatusCode Type1ToCFFEmbeddedFontWriter::WriteEmbeddedFont(	
+															PreparedFontProgram& inFontProgram,
+															const std::string& inFontFile3SubType,
+															ObjectsContext* inObjectsContext,
+															ObjectIDType& outEmbeddedFontObjectID)
+{
 	EStatusCode status;
 
 	do
 	{
-		status = CreateCFFSubset(inFontInfo,inSubsetGlyphIDs,inSubsetFontName,notEmbedded,rawFontProgram);
+		status = inFontProgram.mStatus;
 		if(status != PDFHummus::eSuccess)
 		{
 			TRACE_LOG("Type1ToCFFEmbeddedFontWriter::WriteEmbeddedFont, failed to write embedded font program");
 			break;
 		}	
 
-		if(notEmbedded)
+		if(inFontProgram.mNotEmbedded)
 		{
 			// can't embed. mark succesful, and go back empty
 			outEmbeddedFontObjectID = 0;
@@ -170,26 +194,15 @@ EStatusCode Type1ToCFFEmbeddedFontWriter::WriteEmbeddedFont(
 		
 		DictionaryContext* fontProgramDictionaryContext = inObjectsContext->StartDictionary();
 
-		rawFontProgram.pubseekoff(0,std::ios_base::beg);
-
 		fontProgramDictionaryContext->WriteKey(scSubtype);
 		fontProgramDictionaryContext->WriteNameValue(inFontFile3SubType);
-		PDFStream* pdfStream = inObjectsContext->StartPDFStream(fontProgramDictionaryContext);
-
 
-		// now copy the created font program to the output stream
-		InputStringBufferStream fontProgramStream(&rawFontProgram);
-		OutputStreamTraits streamCopier(pdfStream->GetWriteStream());
-		status = streamCopier.CopyToOutputStream(&fontProgramStream);
+		status = inFontProgram.WriteFontProgramStream(inObjectsContext,fontProgramDictionaryContext);
 		if(status != PDFHummus::eSuccess)
 		{
 			TRACE_LOG("Type1ToCFFEmbeddedFontWriter::WriteEmbeddedFont, failed to copy font program into pdf stream");
 			break;
 		}
-
-
-		inObjectsContext->EndPDFStream(pdfStream);
-		delete pdfStream;
 	}while(false);
 
 	return status;		
@@ -26,6 +26,7 @@
 #include "CFFPrimitiveWriter.h"
 #include "OutputStringBufferStream.h"
 #include "MyStringBuf.h"
+#include "PreparedFontProgram.h"
 
 
 #include <vector>
@@ -60,6 +61,16 @@ public:
 									ObjectsContext* inObjectsContext,
 									ObjectIDType& outEmbeddedFontObjectID);
 
+	// same, in two steps. PrepareEmbeddedFont converts the font subset into outFontProgram, named per its subset font name, and
+	// may run on a worker thread (as long as the font is not used elsewhere meanwhile). WriteEmbeddedFont then writes it
+	void PrepareEmbeddedFont(	FreeTypeFaceWrapper& inFontInfo,
+								const UIntVector& inSubsetGlyphIDs,
+								PreparedFontProgram& outFontProgram);
+	PDFHummus::EStatusCode WriteEmbeddedFont(	PreparedFontProgram& inFontProgram,
+									const std::string& inFontFile3SubType,
+									ObjectsContext* inObjectsContext,
+									ObjectIDType& outEmbeddedFontObjectID);
+
 private:
 	Type1Input mType1Input;
 	InputFile mType1File;
@@ -70,9 +70,10 @@ ULongList& UnicodeString::GetUnicodeList()
 	return mUnicodeCharacters;
 }
 
-EStatusCode UnicodeString::FromUTF8(const std::string& inString)
+template <class T>
+static EStatusCode DecodeUTF8ToContainer(const std::string& inString,T& outUnicodeCharacters)
 {
-	mUnicodeCharacters.clear();
+	outUnicodeCharacters.clear();
 	std::string::const_iterator it = inString.begin();
 	EStatusCode status = PDFHummus::eSuccess;
 	unsigned long unicodeCharacter;
@@ -134,12 +135,22 @@ EStatusCode UnicodeString::FromUTF8(const std::string& inString)
 			break;
 		}
 
-		mUnicodeCharacters.push_back(unicodeCharacter);
+		outUnicodeCharacters.push_back(unicodeCharacter);
 	}
 
 	return status;
 }
 
+EStatusCode UnicodeString::FromUTF8(const std::string& inString)
+{
+	return DecodeUTF8ToContainer(inString,mUnicodeCharacters);
+}
+
+EStatusCode UnicodeString::DecodeUTF8(const std::string& inString,ULongVector& outUnicodeCharacters)
+{
+	return DecodeUTF8ToContainer(inString,outUnicodeCharacters);
+}
+
 EStatusCodeAndString UnicodeString::ToUTF8() const
 {
 	ULongList::const_iterator it = mUnicodeCharacters.begin();
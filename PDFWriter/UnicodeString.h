@@ -24,11 +24,13 @@
 
 #include <string>
 #include <list>
+#include <vector>
 
 
 
 typedef std::pair<PDFHummus::EStatusCode,std::string> EStatusCodeAndString;
 typedef std::list<unsigned long> ULongList;
+typedef std::vector<unsigned long> ULongVector;
 typedef std::list<unsigned short> UShortList;
 typedef std::pair<PDFHummus::EStatusCode,UShortList> EStatusCodeAndUShortList;
 
@@ -46,6 +48,8 @@ public:
 	bool operator==(const UnicodeString& inOtherString) const;
 
 	PDFHummus::EStatusCode FromUTF8(const std::string& inString);
+	// decode to a vector [cleared first], for when a UnicodeString object is not required
+	static PDFHummus::EStatusCode DecodeUTF8(const std::string& inString,ULongVector& outUnicodeCharacters);
 	EStatusCodeAndString ToUTF8() const;
 
 	// convert from UTF16 string, requires BOM
@@ -21,6 +21,7 @@
 #include "UsedFontsRepository.h"
 #include "FreeTypeWrapper.h"
 #include "PDFUsedFont.h"
+#include "SharedFontsCache.h"
 #include "Trace.h"
 #include "ObjectsContext.h"
 #include "DictionaryContext.h"
@@ -36,17 +37,25 @@
 
 
 #include <list>
+#include <vector>
+#include <thread>
+#include <atomic>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 
 using namespace PDFHummus;
 
+typedef std::vector<PDFUsedFont*> PDFUsedFontVector;
+
 UsedFontsRepository::UsedFontsRepository(void)
 {
 	mInputFontsInformation = NULL;
 	mObjectsContext = NULL;
 	mEmbedFonts = true;
+	mFontsCache = NULL;
+	mParallelFontSubsetting = false;
+	mFontSubsettingThreads = 0;
 }
 
 UsedFontsRepository::~UsedFontsRepository(void)
@@ -63,6 +72,31 @@ void UsedFontsRepository::SetEmbedFonts(bool inEmbedFonts) {
 	mEmbedFonts = inEmbedFonts;
 }
 
+void UsedFontsRepository::SetFontsCache(SharedFontsCache* inFontsCache)
+{
+	mFontsCache = inFontsCache;
+}
+
+void UsedFontsRepository::SetParallelFontSubsetting(bool inParallelFontSubsetting,unsigned int inThreadsCount)
+{
+	mParallelFontSubsetting = inParallelFontSubsetting;
+	mFontSubsettingThreads = inThreadsCount;
+}
+
+FT_Face UsedFontsRepository::NewFace(const std::string& inFontFilePath,const std::string& inOptionalMetricsFile,long inFontIndex)
+{
+	if(mFontsCache)
+		return mFontsCache->AcquireFace(inFontFilePath,inOptionalMetricsFile,inFontIndex);
+
+	if(!mInputFontsInformation)
+		mInputFontsInformation = new FreeTypeWrapper();
+
+	if(inOptionalMetricsFile.size() > 0)
+		return mInputFontsInformation->NewFace(inFontFilePath,inOptionalMetricsFile,inFontIndex);
+	else
+		return mInputFontsInformation->NewFace(inFontFilePath,inFontIndex);
+}
+
 PDFUsedFont* UsedFontsRepository::GetFontForFile(const std::string& inFontFilePath,const std::string& inOptionalMetricsFile,long inFontIndex)
 {
 	if(!mObjectsContext)
@@ -74,18 +108,9 @@ PDFUsedFont* UsedFontsRepository::GetFontForFile(const std::string& inFontFilePa
 	StringAndLongToPDFUsedFontMap::iterator it = mUsedFonts.find(StringAndLong(inFontFilePath,inFontIndex));
 	if(it == mUsedFonts.end())
 	{
-		if(!mInputFontsInformation)
-			mInputFontsInformation = new FreeTypeWrapper();
-
-
-		FT_Face face;
+		FT_Face face = NewFace(inFontFilePath,inOptionalMetricsFile,inFontIndex);
 		if(inOptionalMetricsFile.size() > 0)
-		{
-			face = mInputFontsInformation->NewFace(inFontFilePath,inOptionalMetricsFile,inFontIndex);
 			mOptionaMetricsFiles.insert(StringToStringMap::value_type(inFontFilePath,inOptionalMetricsFile));
-		}
-		else
-			face = mInputFontsInformation->NewFace(inFontFilePath,inFontIndex);
 		if(!face)
 		{
 			TRACE_LOG1("UsedFontsRepository::GetFontForFile, Failed to load font from %s",inFontFilePath.c_str());
@@ -95,7 +120,7 @@ PDFUsedFont* UsedFontsRepository::GetFontForFile(const std::string& inFontFilePa
 		else
 		{
 
-			PDFUsedFont* usedFont = new PDFUsedFont(face,inFontFilePath,inOptionalMetricsFile,inFontIndex,mObjectsContext,mEmbedFonts);
+			PDFUsedFont* usedFont = new PDFUsedFont(face,inFontFilePath,inOptionalMetricsFile,inFontIndex,mObjectsContext,mEmbedFonts,mFontsCache);
 			if(!usedFont->IsValid())
 			{
 				TRACE_LOG1("UsedFontsRepository::GetFontForFile, Unreckognized font format for font in %s",inFontFilePath.c_str());
@@ -111,6 +136,9 @@ PDFUsedFont* UsedFontsRepository::GetFontForFile(const std::string& inFontFilePa
 
 EStatusCode UsedFontsRepository::WriteUsedFontsDefinitions()
 {
+	if(mParallelFontSubsetting)
+		PrepareFontPrograms();
+
 	StringAndLongToPDFUsedFontMap::iterator it = mUsedFonts.begin();
 	EStatusCode status = PDFHummus::eSuccess;
 
@@ -122,6 +150,47 @@ EStatusCode UsedFontsRepository::WriteUsedFontsDefinitions()
 	return status;
 }
 
+static void PrepareFontProgramsLoop(PDFUsedFontVector* inFonts,std::atomic<size_t>* ioNextFont)
+{
+	size_t fontIndex;
+
+	while((fontIndex = (*ioNextFont)++) < inFonts->size())
+		(*inFonts)[fontIndex]->PrepareFontPrograms();
+}
+
+void UsedFontsRepository::PrepareFontPrograms()
+{
+	PDFUsedFontVector fonts;
+	StringAndLongToPDFUsedFontMap::iterator it = mUsedFonts.begin();
+
+	// reserve the subset names in the order of writing. each font is then subset by one worker, as fonts faces may be used by one thread at a time
+	for(; it != mUsedFonts.end(); ++it)
+	{
+		if(it->second)
+		{
+			it->second->ReserveFontPrograms();
+			fonts.push_back(it->second);
+		}
+	}
+
+	unsigned int threadsCount = mFontSubsettingThreads > 0 ? mFontSubsettingThreads : std::thread::hardware_concurrency();
+	if(0 == threadsCount)
+		threadsCount = 1;
+	if(threadsCount > fonts.size())
+		threadsCount = (unsigned int)fonts.size();
+
+	std::atomic<size_t> nextFont(0);
+	std::vector<std::thread> threads;
+
+	// this thread works too
+	for(unsigned int i = 1; i < threadsCount; ++i)
+		threads.push_back(std::thread(PrepareFontProgramsLoop,&fonts,&nextFont));
+	PrepareFontProgramsLoop(&fonts,&nextFont);
+
+	for(std::vector<std::thread>::iterator itThreads = threads.begin(); itThreads != threads.end(); ++itThreads)
+		itThreads->join();
+}
+
 PDFUsedFont* UsedFontsRepository::GetFontForFile(const std::string& inFontFilePath,long inFontIndex)
 {
 	return GetFontForFile(inFontFilePath,"",inFontIndex);
@@ -236,9 +305,6 @@ EStatusCode UsedFontsRepository::ReadState(PDFParser* inStateReader,ObjectIDType
     PDFObjectCastPtr<PDFInteger> keyIndexItem;
 	PDFObjectCastPtr<PDFIndirectObjectReference> valueItem;
 
-	if(!mInputFontsInformation)
-		mInputFontsInformation = new FreeTypeWrapper();
-
 	while(it.MoveNext() && PDFHummus::eSuccess == status)
 	{
 		keyStringItem = it.GetItem();
@@ -252,7 +318,7 @@ EStatusCode UsedFontsRepository::ReadState(PDFParser* inStateReader,ObjectIDType
         long fontIndex = (long)keyIndexItem->GetValue();
 
 		FT_Face face;
-		face = mInputFontsInformation->NewFace(filePath,fontIndex);
+		face = NewFace(filePath,"",fontIndex);
 		
 		if(!face)
 		{
@@ -266,9 +332,9 @@ EStatusCode UsedFontsRepository::ReadState(PDFParser* inStateReader,ObjectIDType
 		
 		StringToStringMap::iterator itOptionlMetricsFile = mOptionaMetricsFiles.find(filePath);
 		if(itOptionlMetricsFile != mOptionaMetricsFiles.end())
-			usedFont = new PDFUsedFont(face,filePath,itOptionlMetricsFile->second,fontIndex,mObjectsContext,mEmbedFonts);
+			usedFont = new PDFUsedFont(face,filePath,itOptionlMetricsFile->second,fontIndex,mObjectsContext,mEmbedFonts,mFontsCache);
 		else
-			usedFont = new PDFUsedFont(face,filePath,"",fontIndex,mObjectsContext, mEmbedFonts);
+			usedFont = new PDFUsedFont(face,filePath,"",fontIndex,mObjectsContext,mEmbedFonts,mFontsCache);
 		if(!usedFont->IsValid())
 		{
 			TRACE_LOG2("UsedFontsRepository::ReadState, Unreckognized font format for font in %s at index %ld",filePath.c_str(),fontIndex);
@@ -296,4 +362,7 @@ void UsedFontsRepository::Reset()
 	mInputFontsInformation = NULL;
 	mOptionaMetricsFiles.clear();
 	mEmbedFonts = true;
+	mFontsCache = NULL;
+	mParallelFontSubsetting = false;
+	mFontSubsettingThreads = 0;
 }
\ No newline at end of file
@@ -27,12 +27,16 @@
 #include <map>
 #include <utility>
 
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
 
 
 class FreeTypeWrapper;
 class PDFUsedFont;
 class ObjectsContext;
 class PDFParser;
+class SharedFontsCache;
 
 typedef std::pair<std::string,long> StringAndLong;
 typedef std::map<StringAndLong,PDFUsedFont*> StringAndLongToPDFUsedFontMap;
@@ -46,6 +50,11 @@ public:
 
 	void SetObjectsContext(ObjectsContext* inObjectsContext);
 	void SetEmbedFonts(bool inEmbedFonts);
+	// optional cache to get fonts from, instead of loading them for this document. not owned
+	void SetFontsCache(SharedFontsCache* inFontsCache);
+	// subset the embedded fonts on worker threads when writing the fonts definitions. the definitions are still written
+	// in order, so the result is the same. inThreadsCount of 0 means the machine cores count
+	void SetParallelFontSubsetting(bool inParallelFontSubsetting,unsigned int inThreadsCount = 0);
 
 
 	PDFUsedFont* GetFontForFile(const std::string& inFontFilePath,long inFontIndex);
@@ -66,4 +75,10 @@ private:
 	StringAndLongToPDFUsedFontMap mUsedFonts;
 	StringToStringMap mOptionaMetricsFiles;
 	bool mEmbedFonts;
+	SharedFontsCache* mFontsCache;
+	bool mParallelFontSubsetting;
+	unsigned int mFontSubsettingThreads;
+
+	void PrepareFontPrograms();
+	FT_Face NewFace(const std::string& inFontFilePath,const std::string& inOptionalMetricsFile,long inFontIndex);
 };
@@ -86,7 +86,7 @@ unsigned short WrittenFontCFF::EncodeGlyph(unsigned int inGlyph,const ULongVecto
 	// for the first time, add also 0,0 mapping
 	if(mANSIRepresentation->mGlyphIDToEncodedChar.size() == 0)
 	{
-		mANSIRepresentation->mGlyphIDToEncodedChar.insert(UIntToGlyphEncodingInfoMap::value_type(0,GlyphEncodingInfo(0,0)));
+		mANSIRepresentation->AddGlyph(0,GlyphEncodingInfo(0,0));
 		RemoveFromFreeList(0);
 		mAssignedPositions[0] = 0;
 		mAssignedPositionsAvailable[0] = false;
@@ -108,8 +108,7 @@ unsigned short WrittenFontCFF::EncodeGlyph(unsigned int inGlyph,const ULongVecto
 			encoding = AllocateFromFreeList(inGlyph);
 		mAssignedPositions[encoding] = inGlyph;
 		mAssignedPositionsAvailable[encoding] = false;
-		it = mANSIRepresentation->mGlyphIDToEncodedChar.insert(
-				UIntToGlyphEncodingInfoMap::value_type(inGlyph,GlyphEncodingInfo(encoding,inCharacters))).first;			
+		it = mANSIRepresentation->AddGlyph(inGlyph,GlyphEncodingInfo(encoding,inCharacters));			
 		--mAvailablePositionsCount;
 	}
 	return it->second.mEncodedCharacter;
@@ -182,7 +181,7 @@ EStatusCode WrittenFontCFF::WriteFontDefinition(FreeTypeFaceWrapper& inFontInfo,
 		if(mCIDRepresentation && !mCIDRepresentation->isEmpty()  && mCIDRepresentation->mWrittenObjectID != 0)
 		{
 			CIDFontWriter fontWriter;
-			CFFDescendentFontWriter descendentFontWriter;
+			CFFDescendentFontWriter descendentFontWriter(mCIDRepresentation->mPreparedFontProgram);
 
 			status = fontWriter.WriteFont(inFontInfo, mCIDRepresentation, mObjectsContext, &descendentFontWriter, inEmbedFont);
 			if(status != PDFHummus::eSuccess)
@@ -194,9 +193,24 @@ EStatusCode WrittenFontCFF::WriteFontDefinition(FreeTypeFaceWrapper& inFontInfo,
 
 	} while(false);
 
+	ReleasePreparedFontPrograms();
 	return status;
 }
 
+void WrittenFontCFF::PrepareFontPrograms(FreeTypeFaceWrapper& inFontInfo)
+{
+	if(mANSIRepresentation && mANSIRepresentation->mPreparedFontProgram)
+		CFFANSIFontWriter::PrepareEmbeddedFont(inFontInfo,mANSIRepresentation);
+
+	if(mCIDRepresentation && mCIDRepresentation->mPreparedFontProgram)
+	{
+		UIntAndGlyphEncodingInfoVector encodedGlyphs;
+
+		CIDFontWriter::CalculateCharacterEncodingArray(mCIDRepresentation,encodedGlyphs);
+		CFFDescendentFontWriter::PrepareEmbeddedFont(inFontInfo,encodedGlyphs,*(mCIDRepresentation->mPreparedFontProgram));
+	}
+}
+
 bool WrittenFontCFF::AddToANSIRepresentation(	const GlyphUnicodeMappingListList& inGlyphsList,
 												UShortListList& outEncodedCharacters)
 {
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "ObjectsBasicTypes.h"
+#include "PreparedFontProgram.h"
 
 #include <map>
 #include <algorithm>
@@ -59,10 +60,56 @@ static UIntVector GetOrderedKeys(const UIntToGlyphEncodingInfoMap& inMap)
 
 struct WrittenFontRepresentation
 {	
-	WrittenFontRepresentation(){mWrittenObjectID = 0;}
+	WrittenFontRepresentation(){mWrittenObjectID = 0;mPreparedFontProgram = NULL;}
+	~WrittenFontRepresentation(){delete mPreparedFontProgram;}
 
+	// glyphs are added with AddGlyph, which also keeps the encoded characters lookup
 	UIntToGlyphEncodingInfoMap mGlyphIDToEncodedChar;
 	ObjectIDType mWrittenObjectID;
+	// embedded font program, when subset ahead of writing the font definition. owned
+	PreparedFontProgram* mPreparedFontProgram;
+
+	// adds a glyph, unless already there. returns the glyph entry
+	UIntToGlyphEncodingInfoMap::iterator AddGlyph(unsigned int inGlyphID,const GlyphEncodingInfo& inGlyphEncodingInfo)
+	{
+		std::pair<UIntToGlyphEncodingInfoMap::iterator,bool> result =
+			mGlyphIDToEncodedChar.insert(UIntToGlyphEncodingInfoMap::value_type(inGlyphID,inGlyphEncodingInfo));
+		if(result.second && inGlyphID <= 0xFFFF)
+		{
+			if(inGlyphID >= mEncodedCharsLookup.size())
+				mEncodedCharsLookup.resize(inGlyphID + 1,(unsigned int)scNoEncodedChar);
+			mEncodedCharsLookup[inGlyphID] = result.first->second.mEncodedCharacter;
+		}
+		return result.first;
+	}
+
+	void ClearGlyphs()
+	{
+		mGlyphIDToEncodedChar.clear();
+		mEncodedCharsLookup.clear();
+	}
+
+	// encoded character for a glyph, false if the glyph is not in the representation. text writing looks up every glyph,
+	// so this uses a dense table of the glyphs added so far
+	bool FindEncodedChar(unsigned int inGlyphID,unsigned short& outEncodedCharacter)
+	{
+		if(inGlyphID < mEncodedCharsLookup.size())
+		{
+			if(mEncodedCharsLookup[inGlyphID] == scNoEncodedChar)
+				return false;
+			outEncodedCharacter = (unsigned short)mEncodedCharsLookup[inGlyphID];
+			return true;
+		}
+		else if(inGlyphID <= 0xFFFF)
+			return false;
+
+		// glyph IDs beyond 16 bits are not in the table
+		UIntToGlyphEncodingInfoMap::iterator it = mGlyphIDToEncodedChar.find(inGlyphID);
+		if(it == mGlyphIDToEncodedChar.end())
+			return false;
+		outEncodedCharacter = it->second.mEncodedCharacter;
+		return true;
+	}
 
 	bool isEmpty() {
 		return mGlyphIDToEncodedChar.empty();
@@ -72,4 +119,10 @@ struct WrittenFontRepresentation
 		{
 			return GetOrderedKeys(mGlyphIDToEncodedChar);
 		}
+
+private:
+	static const unsigned int scNoEncodedChar = 0xFFFFFFFF;
+
+	// encoded character per glyph ID, for glyph IDs up to 0xFFFF
+	std::vector<unsigned int> mEncodedCharsLookup;
 };
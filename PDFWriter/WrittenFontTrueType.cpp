@@ -89,7 +89,7 @@ bool WrittenFontTrueType::AddToANSIRepresentation(	const GlyphUnicodeMappingList
 	{
 		// for the first time, add also 0,0 mapping
 		if(mANSIRepresentation->mGlyphIDToEncodedChar.size() == 0)
-			mANSIRepresentation->mGlyphIDToEncodedChar.insert(UIntToGlyphEncodingInfoMap::value_type(0,GlyphEncodingInfo(0,0)));
+			mANSIRepresentation->AddGlyph(0,GlyphEncodingInfo(0,0));
 
 
 		GlyphUnicodeMappingList::const_iterator itGlyphs = inGlyphsList.begin();
@@ -97,8 +97,7 @@ bool WrittenFontTrueType::AddToANSIRepresentation(	const GlyphUnicodeMappingList
 		for(; itGlyphs != inGlyphsList.end(); ++ itGlyphs,++itEncoded)
 		{
 			if(mANSIRepresentation->mGlyphIDToEncodedChar.find(itGlyphs->mGlyphCode) == mANSIRepresentation->mGlyphIDToEncodedChar.end())
-				mANSIRepresentation->mGlyphIDToEncodedChar.insert(
-					UIntToGlyphEncodingInfoMap::value_type(itGlyphs->mGlyphCode,GlyphEncodingInfo(*itEncoded,itGlyphs->mUnicodeValues)));
+				mANSIRepresentation->AddGlyph(itGlyphs->mGlyphCode,GlyphEncodingInfo(*itEncoded,itGlyphs->mUnicodeValues));
 		}
 
 		outEncodedCharacters = candidates;
@@ -129,7 +128,7 @@ EStatusCode WrittenFontTrueType::WriteFontDefinition(FreeTypeFaceWrapper& inFont
 		if(mCIDRepresentation && !mCIDRepresentation->isEmpty()  && mCIDRepresentation->mWrittenObjectID != 0)
 		{
 			CIDFontWriter fontWriter;
-			TrueTypeDescendentFontWriter descendentFontWriter;
+			TrueTypeDescendentFontWriter descendentFontWriter(mCIDRepresentation->mPreparedFontProgram);
 
 			status = fontWriter.WriteFont(inFontInfo, mCIDRepresentation, mObjectsContext, &descendentFontWriter, inEmbedFont);
 			if(status != PDFHummus::eSuccess)
@@ -141,9 +140,24 @@ EStatusCode WrittenFontTrueType::WriteFontDefinition(FreeTypeFaceWrapper& inFont
 
 	} while(false);
 
+	ReleasePreparedFontPrograms();
 	return status;
 }
 
+void WrittenFontTrueType::PrepareFontPrograms(FreeTypeFaceWrapper& inFontInfo)
+{
+	if(mANSIRepresentation && mANSIRepresentation->mPreparedFontProgram)
+		TrueTypeANSIFontWriter::PrepareEmbeddedFont(inFontInfo,mANSIRepresentation);
+
+	if(mCIDRepresentation && mCIDRepresentation->mPreparedFontProgram)
+	{
+		UIntAndGlyphEncodingInfoVector encodedGlyphs;
+
+		CIDFontWriter::CalculateCharacterEncodingArray(mCIDRepresentation,encodedGlyphs);
+		TrueTypeDescendentFontWriter::PrepareEmbeddedFont(inFontInfo,encodedGlyphs,*(mCIDRepresentation->mPreparedFontProgram));
+	}
+}
+
 bool WrittenFontTrueType::AddToANSIRepresentation(	const GlyphUnicodeMappingListList& inGlyphsList,
 													UShortListList& outEncodedCharacters)
 {
@@ -193,7 +207,7 @@ bool WrittenFontTrueType::AddToANSIRepresentation(	const GlyphUnicodeMappingList
 	{
 		// for the first time, add also 0,0 mapping
 		if(mANSIRepresentation->mGlyphIDToEncodedChar.size() == 0)
-			mANSIRepresentation->mGlyphIDToEncodedChar.insert(UIntToGlyphEncodingInfoMap::value_type(0,GlyphEncodingInfo(0,0)));
+			mANSIRepresentation->AddGlyph(0,GlyphEncodingInfo(0,0));
 
 
 		GlyphUnicodeMappingListList::const_iterator itGlyphsList = inGlyphsList.begin();
@@ -208,8 +222,7 @@ bool WrittenFontTrueType::AddToANSIRepresentation(	const GlyphUnicodeMappingList
 			for(; itGlyphs != itGlyphsList->end(); ++ itGlyphs,++itEncoded)
 			{
 				if(mANSIRepresentation->mGlyphIDToEncodedChar.find(itGlyphs->mGlyphCode) == mANSIRepresentation->mGlyphIDToEncodedChar.end())
-					mANSIRepresentation->mGlyphIDToEncodedChar.insert(
-					UIntToGlyphEncodingInfoMap::value_type(itGlyphs->mGlyphCode,GlyphEncodingInfo(*itEncoded,itGlyphs->mUnicodeValues)));
+					mANSIRepresentation->AddGlyph(itGlyphs->mGlyphCode,GlyphEncodingInfo(*itEncoded,itGlyphs->mUnicodeValues));
 			}
 		}
 
@@ -28,6 +28,7 @@ public:
 	~WrittenFontTrueType(void);
 
 	virtual PDFHummus::EStatusCode WriteFontDefinition(FreeTypeFaceWrapper& inFontInfo,bool inEmbedFont);
+	virtual void PrepareFontPrograms(FreeTypeFaceWrapper& inFontInfo);
 
 	virtual PDFHummus::EStatusCode WriteState(ObjectsContext* inStateWriter,ObjectIDType inObjectId);
 	virtual PDFHummus::EStatusCode ReadState(PDFParser* inStateReader,ObjectIDType inObjectID);
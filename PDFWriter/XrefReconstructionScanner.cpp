@@ -0,0 +1,196 @@
+/*
+   Source File : XrefReconstructionScanner.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "XrefReconstructionScanner.h"
+
+#include <string.h>
+#include <thread>
+
+using namespace IOBasicTypes;
+
+// no point in spreading small files between threads
+#define MIN_SCAN_CHUNK_SIZE (1024*1024)
+#define MAX_OBJECT_NUMBER_DIGITS 10
+
+void XrefReconstructionScanResults::Append(const XrefReconstructionScanResults& inOther)
+{
+	mObjectHeaders.insert(mObjectHeaders.end(),inOther.mObjectHeaders.begin(),inOther.mObjectHeaders.end());
+	mTrailers.insert(mTrailers.end(),inOther.mTrailers.begin(),inOther.mTrailers.end());
+	mXrefStreamMarkers.insert(mXrefStreamMarkers.end(),inOther.mXrefStreamMarkers.begin(),inOther.mXrefStreamMarkers.end());
+	mObjectStreamMarkers.insert(mObjectStreamMarkers.end(),inOther.mObjectStreamMarkers.begin(),inOther.mObjectStreamMarkers.end());
+	mCatalogMarkers.insert(mCatalogMarkers.end(),inOther.mCatalogMarkers.begin(),inOther.mCatalogMarkers.end());
+}
+
+static bool IsWhiteSpace(Byte inCharacter)
+{
+	return	0 == inCharacter || 0x9 == inCharacter || 0xA == inCharacter ||
+			0xC == inCharacter || 0xD == inCharacter || 0x20 == inCharacter;
+}
+
+static bool IsDelimiter(Byte inCharacter)
+{
+	return	'(' == inCharacter || ')' == inCharacter || '<' == inCharacter || '>' == inCharacter ||
+			'[' == inCharacter || ']' == inCharacter || '{' == inCharacter || '}' == inCharacter ||
+			'/' == inCharacter || '%' == inCharacter;
+}
+
+static bool IsDigit(Byte inCharacter)
+{
+	return inCharacter >= '0' && inCharacter <= '9';
+}
+
+// keyword at position, ending at the end of data or before a whitespace or a delimiter
+static bool IsKeywordAt(const Byte* inData,LongBufferSizeType inDataSize,LongBufferSizeType inPosition,const char* inKeyword,LongBufferSizeType inKeywordLength)
+{
+	if(inPosition + inKeywordLength > inDataSize || memcmp(inData + inPosition,inKeyword,inKeywordLength) != 0)
+		return false;
+	return inPosition + inKeywordLength == inDataSize ||
+			IsWhiteSpace(inData[inPosition + inKeywordLength]) ||
+			IsDelimiter(inData[inPosition + inKeywordLength]);
+}
+
+// reads digits backwards from inPosition [inclusive]. returns the position of the first digit, or -1 if no digits
+static long long ReadNumberBackwards(const Byte* inData,long long inPosition,unsigned long long& outValue)
+{
+	long long start = inPosition;
+	while(start >= 0 && IsDigit(inData[start]) && inPosition - start < MAX_OBJECT_NUMBER_DIGITS)
+		--start;
+	if(start == inPosition || (start >= 0 && IsDigit(inData[start])))
+		return -1;
+
+	outValue = 0;
+	for(long long i = start + 1; i <= inPosition; ++i)
+		outValue = outValue*10 + (inData[i] - '0');
+	return start + 1;
+}
+
+// with "obj" at inPosition, look back for "N G ", and fill the object header if found
+static bool ReadObjectHeaderBackwards(const Byte* inData,LongBufferSizeType inPosition,ScannedObjectHeader& outHeader)
+{
+	long long position = (long long)inPosition - 1;
+	if(position < 0 || !IsWhiteSpace(inData[position]))
+		return false;
+	while(position >= 0 && IsWhiteSpace(inData[position]))
+		--position;
+	if(position < 0)
+		return false;
+
+	unsigned long long generation;
+	position = ReadNumberBackwards(inData,position,generation);
+	if(position <= 0 || !IsWhiteSpace(inData[position - 1]))
+		return false;
+
+	--position;
+	while(position >= 0 && IsWhiteSpace(inData[position]))
+		--position;
+	if(position < 0)
+		return false;
+
+	unsigned long long objectID;
+	position = ReadNumberBackwards(inData,position,objectID);
+	if(position < 0)
+		return false;
+	if(position > 0 && !IsWhiteSpace(inData[position - 1]) && !IsDelimiter(inData[position - 1]))
+		return false;
+
+	outHeader.mObjectID = (ObjectIDType)objectID;
+	outHeader.mGeneration = (unsigned long)generation;
+	outHeader.mPosition = position;
+	return true;
+}
+
+static void ScanChunk(const Byte* inData,LongBufferSizeType inDataSize,LongBufferSizeType inChunkStart,LongBufferSizeType inChunkEnd,XrefReconstructionScanResults* outResults)
+{
+	// matches are recorded by their start position, which should be in the chunk. the match itself may go beyond the chunk end
+	for(LongBufferSizeType i = inChunkStart; i < inChunkEnd; ++i)
+	{
+		switch(inData[i])
+		{
+			case 'o':
+			{
+				ScannedObjectHeader header;
+				if(IsKeywordAt(inData,inDataSize,i,"obj",3) && ReadObjectHeaderBackwards(inData,i,header))
+					outResults->mObjectHeaders.push_back(header);
+				break;
+			}
+			case 't':
+			{
+				if((0 == i || IsWhiteSpace(inData[i-1])) && IsKeywordAt(inData,inDataSize,i,"trailer",7))
+					outResults->mTrailers.push_back(i);
+				break;
+			}
+			case '/':
+			{
+				if(IsKeywordAt(inData,inDataSize,i,"/XRef",5))
+					outResults->mXrefStreamMarkers.push_back(i);
+				else if(IsKeywordAt(inData,inDataSize,i,"/ObjStm",7))
+					outResults->mObjectStreamMarkers.push_back(i);
+				else if(IsKeywordAt(inData,inDataSize,i,"/Catalog",8))
+					outResults->mCatalogMarkers.push_back(i);
+				break;
+			}
+		}
+	}
+}
+
+XrefReconstructionScanner::XrefReconstructionScanner(void)
+{
+	mThreadsCount = 0;
+}
+
+XrefReconstructionScanner::~XrefReconstructionScanner(void)
+{
+}
+
+void XrefReconstructionScanner::SetThreadsCount(unsigned int inThreadsCount)
+{
+	mThreadsCount = inThreadsCount;
+}
+
+void XrefReconstructionScanner::Scan(const Byte* inData,LongBufferSizeType inDataSize,XrefReconstructionScanResults& outResults)
+{
+	unsigned int threadsCount = mThreadsCount > 0 ? mThreadsCount : std::thread::hardware_concurrency();
+	if(0 == threadsCount)
+		threadsCount = 1;
+
+	LongBufferSizeType chunksCount = inDataSize / MIN_SCAN_CHUNK_SIZE;
+	if(chunksCount > threadsCount)
+		chunksCount = threadsCount;
+	if(chunksCount <= 1)
+	{
+		ScanChunk(inData,inDataSize,0,inDataSize,&outResults);
+		return;
+	}
+
+	std::vector<XrefReconstructionScanResults> chunksResults((size_t)chunksCount);
+	std::vector<std::thread> threads;
+	LongBufferSizeType chunkSize = inDataSize / chunksCount;
+
+	// this thread scans the last chunk
+	for(LongBufferSizeType i = 0; i < chunksCount - 1; ++i)
+		threads.push_back(std::thread(ScanChunk,inData,inDataSize,i*chunkSize,(i+1)*chunkSize,&chunksResults[(size_t)i]));
+	ScanChunk(inData,inDataSize,(chunksCount - 1)*chunkSize,inDataSize,&chunksResults[(size_t)(chunksCount - 1)]);
+
+	for(std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+		it->join();
+
+	for(size_t i = 0; i < chunksResults.size(); ++i)
+		outResults.Append(chunksResults[i]);
+}
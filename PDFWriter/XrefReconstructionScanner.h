@@ -0,0 +1,74 @@
+/*
+   Source File : XrefReconstructionScanner.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "ObjectsBasicTypes.h"
+#include "IOBasicTypes.h"
+
+#include <vector>
+
+/*
+	Scanner for rebuilding the xref of files whose xref or trailer are broken.
+	Scans the raw file bytes for object headers ("N G obj"), trailer keywords, and for names that mark interesting objects -
+	xref streams [/XRef], object streams [/ObjStm] and catalogs [/Catalog]. The file is split to chunks that are scanned in
+	parallel, and the chunks results are concatenated in file order, so results are the same regardless of threads count.
+	PDFParser uses the results to rebuild the xref and the trailer.
+*/
+
+struct ScannedObjectHeader
+{
+	ObjectIDType mObjectID;
+	unsigned long mGeneration;
+	// position of the object number
+	IOBasicTypes::LongFilePositionType mPosition;
+};
+
+typedef std::vector<ScannedObjectHeader> ScannedObjectHeaderVector;
+typedef std::vector<IOBasicTypes::LongFilePositionType> LongFilePositionTypeVector;
+
+struct XrefReconstructionScanResults
+{
+	// all lists are sorted by position
+	ScannedObjectHeaderVector mObjectHeaders;
+	// positions of "trailer" keywords
+	LongFilePositionTypeVector mTrailers;
+	// positions of /XRef, /ObjStm and /Catalog names
+	LongFilePositionTypeVector mXrefStreamMarkers;
+	LongFilePositionTypeVector mObjectStreamMarkers;
+	LongFilePositionTypeVector mCatalogMarkers;
+
+	void Append(const XrefReconstructionScanResults& inOther);
+};
+
+class XrefReconstructionScanner
+{
+public:
+	XrefReconstructionScanner(void);
+	~XrefReconstructionScanner(void);
+
+	// threads count of 0 uses the hardware concurrency
+	void SetThreadsCount(unsigned int inThreadsCount);
+
+	void Scan(const IOBasicTypes::Byte* inData,IOBasicTypes::LongBufferSizeType inDataSize,XrefReconstructionScanResults& outResults);
+
+private:
+	unsigned int mThreadsCount;
+};
@@ -0,0 +1,254 @@
+/*
+   Source File : ConcurrentParsingTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ConcurrentParsingTest.h"
+#include "TestFiles.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFObjectParser.h"
+#include "PDFObject.h"
+#include "PDFDictionary.h"
+#include "PDFArray.h"
+#include "PDFStreamInput.h"
+#include "PDFObjectCast.h"
+#include "RefCountPtr.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using namespace PDFHummus;
+
+ConcurrentParsingTest::ConcurrentParsingTest(void)
+{
+}
+
+ConcurrentParsingTest::~ConcurrentParsingTest(void)
+{
+}
+
+static const unsigned int scCursorsCount = 4;
+static const unsigned long scManyPagesCount = 500;
+
+EStatusCode ConcurrentParsingTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+	string manyPagesPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ConcurrentParsingManyPages.pdf");
+
+	const char* materials[] = {
+		"TestMaterials/Original.pdf",
+		"TestMaterials/AddedPage.pdf",
+		"TestMaterials/ObjectStreams.pdf",
+		"TestMaterials/XObjectContent.pdf",
+		"TestMaterials/Linearized.pdf"
+	};
+
+	for(size_t i=0;i<sizeof(materials)/sizeof(const char*) && eSuccess == status;++i)
+	{
+		// cursors reading straight from a memory mapped file, and cursors with their own file streams
+		status = CompareWithSingleThread(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,materials[i]),true);
+		if(eSuccess == status)
+			status = CompareWithSingleThread(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,materials[i]),false);
+	}
+	if(status != eSuccess)
+		return status;
+
+	status = WriteManyPagesDocument(manyPagesPath,scManyPagesCount,true);
+	if(status != eSuccess)
+		return status;
+
+	status = CompareWithSingleThread(manyPagesPath,true);
+	if(status != eSuccess)
+		return status;
+
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ConcurrentParsingBenchmark.txt"),true,true);
+	status = RunBenchmark(manyPagesPath);
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+// parse a page and its content, and describe what was found
+static string DescribePage(PDFParser* inParser,unsigned long inPageIndex)
+{
+	stringstream description;
+	RefCountPtr<PDFDictionary> page(inParser->ParsePage(inPageIndex));
+	if(!page)
+		return "missing page";
+	description<<inParser->GetPageObjectID(inPageIndex)<<":";
+
+	RefCountPtr<PDFObject> contents(inParser->QueryDictionaryObject(page.GetPtr(),"Contents"));
+	PDFObjectParser* contentParser = NULL;
+	if(!!contents && contents->GetType() == PDFObject::ePDFObjectStream)
+		contentParser = inParser->StartReadingObjectsFromStream((PDFStreamInput*)contents.GetPtr());
+	else if(!!contents && contents->GetType() == PDFObject::ePDFObjectArray)
+		contentParser = inParser->StartReadingObjectsFromStreams((PDFArray*)contents.GetPtr());
+
+	unsigned long objectsCount = 0;
+	if(contentParser)
+	{
+		PDFObject* anObject;
+		while((anObject = contentParser->ParseNewObject()) != NULL)
+		{
+			++objectsCount;
+			anObject->Release();
+		}
+		delete contentParser;
+	}
+	description<<objectsCount;
+	return description.str();
+}
+
+static void DescribePages(PDFParser* inParser,unsigned long inFirstPage,unsigned long inStep,vector<string>* outDescriptions)
+{
+	for(unsigned long i=inFirstPage;i<outDescriptions->size();i+=inStep)
+		(*outDescriptions)[i] = DescribePage(inParser,i);
+}
+
+EStatusCode ConcurrentParsingTest::CompareWithSingleThread(const string& inFilePath,bool inMemoryMap)
+{
+	EStatusCode status;
+	InputFile sourceFile;
+	PDFParser sourceParser;
+	InputFile cursorsFiles[scCursorsCount];
+	PDFParser cursors[scCursorsCount];
+
+	do
+	{
+		status = sourceFile.OpenFile(inFilePath,inMemoryMap);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		status = sourceParser.StartPDFParsing(sourceFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		vector<string> expected(sourceParser.GetPagesCount());
+		DescribePages(&sourceParser,0,1,&expected);
+
+		for(unsigned int i=0;i<scCursorsCount && eSuccess == status;++i)
+		{
+			IByteReaderWithPosition* cursorStream = NULL;
+			if(!inMemoryMap)
+			{
+				status = cursorsFiles[i].OpenFile(inFilePath);
+				if(status != eSuccess)
+				{
+					cout<<"failed to open "<<inFilePath.c_str()<<" for cursor\n";
+					break;
+				}
+				cursorStream = cursorsFiles[i].GetInputStream();
+			}
+
+			status = cursors[i].StartPDFParsingCursor(&sourceParser,cursorStream);
+			if(status != eSuccess || cursors[i].GetPagesCount() != sourceParser.GetPagesCount())
+			{
+				cout<<"failed to start cursor for "<<inFilePath.c_str()<<"\n";
+				status = eFailure;
+			}
+		}
+		if(status != eSuccess)
+			break;
+
+		// cursors split the pages between them, while the source parser goes over all pages again
+		vector<string> actual(sourceParser.GetPagesCount());
+		vector<string> sourceActual(sourceParser.GetPagesCount());
+		vector<thread> threads;
+		for(unsigned int i=0;i<scCursorsCount;++i)
+			threads.push_back(thread(DescribePages,&cursors[i],i,scCursorsCount,&actual));
+		DescribePages(&sourceParser,0,1,&sourceActual);
+		for(vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+			it->join();
+
+		for(size_t i=0;i<expected.size() && eSuccess == status;++i)
+		{
+			if(expected[i] != actual[i] || expected[i] != sourceActual[i])
+			{
+				cout<<"page "<<i<<" mismatch for "<<inFilePath.c_str()<<", expected "<<expected[i].c_str()<<" got "<<actual[i].c_str()<<"\n";
+				status = eFailure;
+			}
+		}
+	}while(false);
+
+	return status;
+}
+
+EStatusCode ConcurrentParsingTest::RunBenchmark(const string& inFilePath)
+{
+	// going over all pages content with one parser, and with a cursor per thread
+	EStatusCode status;
+	TimersRegistry timers;
+	InputFile sourceFile;
+	PDFParser sourceParser;
+	PDFParser cursors[scCursorsCount];
+
+	do
+	{
+		status = sourceFile.OpenFile(inFilePath,true);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+		status = sourceParser.StartPDFParsing(sourceFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		vector<string> descriptions(sourceParser.GetPagesCount());
+		timers.StartMeasure("SingleParser");
+		DescribePages(&sourceParser,0,1,&descriptions);
+		timers.StopMeasureAndAccumulate("SingleParser");
+
+		timers.StartMeasure("Cursors");
+		for(unsigned int i=0;i<scCursorsCount && eSuccess == status;++i)
+			status = cursors[i].StartPDFParsingCursor(&sourceParser);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start cursors for "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+		vector<thread> threads;
+		for(unsigned int i=0;i<scCursorsCount;++i)
+			threads.push_back(thread(DescribePages,&cursors[i],i,scCursorsCount,&descriptions));
+		for(vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+			it->join();
+		timers.StopMeasureAndAccumulate("Cursors");
+
+		cout<<"Reading content of "<<sourceParser.GetPagesCount()<<" pages, single parser: "<<timers.GetTotalMiliSeconds("SingleParser")<<
+			"ms, "<<scCursorsCount<<" cursors on "<<thread::hardware_concurrency()<<" cores: "<<timers.GetTotalMiliSeconds("Cursors")<<"ms\n";
+	}while(false);
+
+	timers.TraceAndReleaseAll();
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(ConcurrentParsingTest,"Parsing")
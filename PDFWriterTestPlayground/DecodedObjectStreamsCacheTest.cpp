@@ -0,0 +1,177 @@
+/*
+   Source File : DecodedObjectStreamsCacheTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "DecodedObjectStreamsCacheTest.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFObject.h"
+#include "PDFObjectCast.h"
+#include "PDFDictionary.h"
+#include "PDFArray.h"
+#include "PDFInteger.h"
+#include "PDFName.h"
+#include "PDFIndirectObjectReference.h"
+#include "RefCountPtr.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace PDFHummus;
+
+DecodedObjectStreamsCacheTest::DecodedObjectStreamsCacheTest(void)
+{
+}
+
+DecodedObjectStreamsCacheTest::~DecodedObjectStreamsCacheTest(void)
+{
+}
+
+static const char* scObjectStreamsFiles[] = {
+	"TestMaterials/ObjectStreams.pdf",
+	"TestMaterials/ObjectStreamsModified.pdf",
+	"TestMaterials/1.unfamiliar.entry.type.pdf",
+	"TestMaterials/china.pdf",
+	NULL
+};
+
+EStatusCode DecodedObjectStreamsCacheTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+
+	for(int i=0; scObjectStreamsFiles[i] && eSuccess == status;++i)
+	{
+		status = CompareParsing(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,scObjectStreamsFiles[i]));
+		if(status != eSuccess)
+			cout<<"Parsing with decoded object streams cache differs from parsing without it for "<<scObjectStreamsFiles[i]<<"\n";
+	}
+
+	return status;
+}
+
+// suggested budget where everything fits, a small one that forces evictions, and one that can't keep any decoded stream
+static const IOBasicTypes::LongBufferSizeType scBudgets[] = {SUGGESTED_DECODED_OBJECT_STREAMS_CACHE_BUDGET,2048,1};
+#define BUDGETS_COUNT 3
+
+EStatusCode DecodedObjectStreamsCacheTest::CompareParsing(const string& inFilePath)
+{
+	InputFile uncachedFile;
+	PDFParser uncachedParser;
+	PDFParsingOptions uncachedOptions;
+	InputFile cachedFiles[BUDGETS_COUNT];
+	PDFParser cachedParsers[BUDGETS_COUNT];
+
+	uncachedOptions.DecodedObjectStreamsCacheBudget = 0;
+	if(uncachedFile.OpenFile(inFilePath) != eSuccess || uncachedParser.StartPDFParsing(uncachedFile.GetInputStream(),uncachedOptions) != eSuccess)
+	{
+		cout<<"Failed to start parsing "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	for(int i=0; i < BUDGETS_COUNT; ++i)
+	{
+		PDFParsingOptions cachedOptions;
+		cachedOptions.DecodedObjectStreamsCacheBudget = scBudgets[i];
+
+		if(cachedFiles[i].OpenFile(inFilePath) != eSuccess || cachedParsers[i].StartPDFParsing(cachedFiles[i].GetInputStream(),cachedOptions) != eSuccess)
+		{
+			cout<<"Failed to start parsing "<<inFilePath<<" with decoded object streams budget "<<scBudgets[i]<<"\n";
+			return eFailure;
+		}
+
+		if(uncachedParser.GetPagesCount() != cachedParsers[i].GetPagesCount())
+		{
+			cout<<"Different page count. without cache: "<<uncachedParser.GetPagesCount()<<", with cache: "<<cachedParsers[i].GetPagesCount()<<"\n";
+			return eFailure;
+		}
+	}
+
+	// going backwards, so that objects are not fetched in the object streams order
+	for(ObjectIDType objectID = uncachedParser.GetObjectsCount(); objectID > 0; --objectID)
+	{
+		RefCountPtr<PDFObject> uncachedObject(uncachedParser.ParseNewObject(objectID-1));
+
+		for(int i=0; i < BUDGETS_COUNT; ++i)
+		{
+			RefCountPtr<PDFObject> cachedObject(cachedParsers[i].ParseNewObject(objectID-1));
+
+			if(!AreSameObjects(uncachedObject.GetPtr(),cachedObject.GetPtr()))
+			{
+				cout<<"Object "<<objectID-1<<" is parsed differently when decoded object streams are cached with budget "<<scBudgets[i]<<"\n";
+				return eFailure;
+			}
+		}
+	}
+
+	return eSuccess;
+}
+
+bool DecodedObjectStreamsCacheTest::AreSameObjects(PDFObject* inLeft,PDFObject* inRight)
+{
+	if(!inLeft || !inRight)
+		return !inLeft && !inRight;
+
+	if(inLeft->GetType() != inRight->GetType())
+		return false;
+
+	switch(inLeft->GetType())
+	{
+		case PDFObject::ePDFObjectInteger:
+			return ((PDFInteger*)inLeft)->GetValue() == ((PDFInteger*)inRight)->GetValue();
+		case PDFObject::ePDFObjectName:
+			return ((PDFName*)inLeft)->GetValue() == ((PDFName*)inRight)->GetValue();
+		case PDFObject::ePDFObjectIndirectObjectReference:
+			return ((PDFIndirectObjectReference*)inLeft)->mObjectID == ((PDFIndirectObjectReference*)inRight)->mObjectID;
+		case PDFObject::ePDFObjectArray:
+		{
+			PDFArray* leftArray = (PDFArray*)inLeft;
+			PDFArray* rightArray = (PDFArray*)inRight;
+			if(leftArray->GetLength() != rightArray->GetLength())
+				return false;
+			for(unsigned long i=0;i<leftArray->GetLength();++i)
+			{
+				RefCountPtr<PDFObject> leftItem(leftArray->QueryObject(i));
+				RefCountPtr<PDFObject> rightItem(rightArray->QueryObject(i));
+				if(!AreSameObjects(leftItem.GetPtr(),rightItem.GetPtr()))
+					return false;
+			}
+			return true;
+		}
+		case PDFObject::ePDFObjectDictionary:
+		{
+			MapIterator<PDFNameToPDFObjectMap> leftIt = ((PDFDictionary*)inLeft)->GetIterator();
+			MapIterator<PDFNameToPDFObjectMap> rightIt = ((PDFDictionary*)inRight)->GetIterator();
+			bool leftHasMore = leftIt.MoveNext();
+			bool rightHasMore = rightIt.MoveNext();
+			while(leftHasMore && rightHasMore)
+			{
+				if(leftIt.GetKey()->GetValue() != rightIt.GetKey()->GetValue() || !AreSameObjects(leftIt.GetValue(),rightIt.GetValue()))
+					return false;
+				leftHasMore = leftIt.MoveNext();
+				rightHasMore = rightIt.MoveNext();
+			}
+			return !leftHasMore && !rightHasMore;
+		}
+		default:
+			// other types are compared by type alone
+			return true;
+	}
+}
+
+ADD_CATEGORIZED_TEST(DecodedObjectStreamsCacheTest,"PDFEmbedding")
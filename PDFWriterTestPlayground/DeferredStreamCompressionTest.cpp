@@ -0,0 +1,296 @@
+/*
+   Source File : DeferredStreamCompressionTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "DeferredStreamCompressionTest.h"
+#include "TestFiles.h"
+#include "PDFWriter.h"
+#include "PDFPage.h"
+#include "PDFRectangle.h"
+#include "PageContentContext.h"
+#include "InputFile.h"
+#include "IByteReaderWithPosition.h"
+#include "PDFParser.h"
+#include "OutputDeferredCompressionStream.h"
+#include "OutputStringBufferStream.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace PDFHummus;
+
+DeferredStreamCompressionTest::DeferredStreamCompressionTest(void)
+{
+}
+
+DeferredStreamCompressionTest::~DeferredStreamCompressionTest(void)
+{
+}
+
+static const int scPagesCount = 100;
+static const int scPathsPerPage = 2000;
+
+EStatusCode DeferredStreamCompressionTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status;
+	string plainPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"DeferredStreamCompressionPlain.pdf");
+	string deferredPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"DeferredStreamCompression.pdf");
+	string deferredObjectStreamsPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"DeferredStreamCompressionObjectStreams.pdf");
+
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"DeferredStreamCompressionBenchmark.txt"),true,true);
+	TimersRegistry timers;
+
+	do
+	{
+		status = TestPositions();
+		if(status != eSuccess)
+			break;
+
+		timers.StartMeasure("Plain");
+		status = WriteDocument(inTestConfiguration,plainPath,false,false);
+		timers.StopMeasureAndAccumulate("Plain");
+		if(status != eSuccess)
+		{
+			cout<<"failed to write document without deferred compression\n";
+			break;
+		}
+
+		timers.StartMeasure("Deferred");
+		status = WriteDocument(inTestConfiguration,deferredPath,true,false);
+		timers.StopMeasureAndAccumulate("Deferred");
+		if(status != eSuccess)
+		{
+			cout<<"failed to write document with deferred compression\n";
+			break;
+		}
+
+		// deferred compression should produce the very same document (save for the time based ID)
+		status = CompareDocuments(plainPath,deferredPath);
+		if(status != eSuccess)
+			break;
+
+		// with object streams, streams lengths are written as regular objects (they are not known in time
+		// to get into an object stream), so just make sure that the result is readable
+		status = WriteDocument(inTestConfiguration,deferredObjectStreamsPath,true,true);
+		if(status != eSuccess)
+		{
+			cout<<"failed to write document with object streams and deferred compression\n";
+			break;
+		}
+
+		InputFile pdfFile;
+		status = pdfFile.OpenFile(deferredObjectStreamsPath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<deferredObjectStreamsPath.c_str()<<"\n";
+			break;
+		}
+		PDFParser parser;
+		status = parser.StartPDFParsing(pdfFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<deferredObjectStreamsPath.c_str()<<"\n";
+			break;
+		}
+		if(parser.GetPagesCount() != scPagesCount)
+		{
+			cout<<"wrong pages count for "<<deferredObjectStreamsPath.c_str()<<". expected "<<scPagesCount<<" got "<<parser.GetPagesCount()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		cout<<"Writing without deferred compression: "<<timers.GetTotalMiliSeconds("Plain")<<"ms\n";
+		cout<<"Writing with deferred compression: "<<timers.GetTotalMiliSeconds("Deferred")<<"ms\n";
+	}while(false);
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+EStatusCode DeferredStreamCompressionTest::WriteDocument(const TestConfiguration& inTestConfiguration,const string& inOutputPath,bool inDeferStreamCompression,bool inWriteObjectStreams)
+{
+	EStatusCode status;
+	string statePath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"DeferredStreamCompressionState.txt");
+
+	PDFCreationSettings creationSettings(true,true,EncryptionOptions::DefaultEncryptionOptions(),inWriteObjectStreams);
+	creationSettings.DeferStreamCompression = inDeferStreamCompression;
+
+	do
+	{
+		// write the document in two sessions, to make sure pending compressions are completed on shutdown
+		{
+			PDFWriter pdfWriter;
+			status = pdfWriter.StartPDF(inOutputPath,ePDFVersion15,LogConfiguration::DefaultLogConfiguration(),creationSettings);
+			if(status != eSuccess)
+			{
+				cout<<"failed to start PDF\n";
+				break;
+			}
+
+			status = WritePages(pdfWriter,inTestConfiguration,0,scPagesCount/2);
+			if(status != eSuccess)
+				break;
+
+			status = pdfWriter.Shutdown(statePath);
+			if(status != eSuccess)
+			{
+				cout<<"failed to shutdown PDF writing\n";
+				break;
+			}
+		}
+		{
+			PDFWriter pdfWriter;
+			status = pdfWriter.ContinuePDF(inOutputPath,statePath);
+			if(status != eSuccess)
+			{
+				cout<<"failed to continue PDF writing\n";
+				break;
+			}
+
+			status = WritePages(pdfWriter,inTestConfiguration,scPagesCount/2,scPagesCount - scPagesCount/2);
+			if(status != eSuccess)
+				break;
+
+			status = pdfWriter.EndPDF();
+			if(status != eSuccess)
+			{
+				cout<<"failed to end PDF\n";
+				break;
+			}
+		}
+	}while(false);
+
+	return status;
+}
+
+EStatusCode DeferredStreamCompressionTest::WritePages(PDFWriter& inPDFWriter,const TestConfiguration& inTestConfiguration,int inFirstPage,int inPagesCount)
+{
+	EStatusCode status = eSuccess;
+
+	PDFUsedFont* font = inPDFWriter.GetFontForFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"TestMaterials/fonts/arial.ttf"));
+	if(!font)
+	{
+		cout<<"failed to create font object for arial.ttf\n";
+		return eFailure;
+	}
+
+	// some pseudo random drawing, so there's enough content to compress
+	unsigned long seed = 1;
+	for(int i=inFirstPage; i < inFirstPage + inPagesCount && eSuccess == status;++i)
+	{
+		PDFPage* page = new PDFPage();
+		page->SetMediaBox(PDFRectangle(0,0,595,842));
+
+		PageContentContext* contentContext = inPDFWriter.StartPageContentContext(page);
+		if(!contentContext)
+		{
+			cout<<"failed to create content context for page "<<i<<"\n";
+			delete page;
+			status = eFailure;
+			break;
+		}
+
+		for(int j=0; j < scPathsPerPage; ++j)
+		{
+			seed = seed * 1103515245 + 12345;
+			double x = (seed >> 8) % 5950 / 10.0;
+			seed = seed * 1103515245 + 12345;
+			double y = (seed >> 8) % 8420 / 10.0;
+			contentContext->m(x,y);
+			contentContext->l(y * 595 / 842,x * 842 / 595);
+			contentContext->S();
+		}
+
+		stringstream text;
+		text<<"Deferred compression page "<<i + 1;
+
+		contentContext->BT();
+		contentContext->k(0,0,0,1);
+		contentContext->Tf(font,1);
+		contentContext->Tm(30,0,0,30,78.4252,662.8997);
+		contentContext->Tj(text.str());
+		contentContext->ET();
+
+		status = inPDFWriter.EndPageContentContext(contentContext);
+		if(status != eSuccess)
+		{
+			cout<<"failed to end content context for page "<<i<<"\n";
+			delete page;
+			break;
+		}
+
+		status = inPDFWriter.WritePageAndRelease(page);
+		if(status != eSuccess)
+			cout<<"failed to write page "<<i<<"\n";
+	}
+
+	return status;
+}
+
+EStatusCode DeferredStreamCompressionTest::TestPositions()
+{
+	EStatusCode status = eSuccess;
+	OutputStringBufferStream targetStream;
+	OutputDeferredCompressionStream deferredStream;
+	string literal = "some literal content ";
+
+	deferredStream.Assign(&targetStream,NULL,2);
+
+	// positions are expected to account for the queued encodings and lengths
+	for(int i=0; i < 20 && eSuccess == status; ++i)
+	{
+		ByteVector data;
+		for(int j=0; j < 1000 * (i + 1); ++j)
+			data.push_back((IOBasicTypes::Byte)('a' + (j * (i + 1)) % 26));
+		deferredStream.QueueFlateEncoding(data);
+		deferredStream.Write((const IOBasicTypes::Byte*)literal.c_str(),literal.size());
+		deferredStream.WriteEncodedLength(i + 1);
+		deferredStream.Write((const IOBasicTypes::Byte*)literal.c_str(),literal.size());
+
+		IOBasicTypes::LongFilePositionType position = deferredStream.GetCurrentPosition();
+		deferredStream.Flush();
+		if(position != targetStream.GetCurrentPosition())
+		{
+			cout<<"wrong deferred stream position. expected "<<targetStream.GetCurrentPosition()<<" got "<<position<<"\n";
+			status = eFailure;
+		}
+	}
+
+	return status;
+}
+
+EStatusCode DeferredStreamCompressionTest::CompareDocuments(const string& inExpectedPath,const string& inActualPath)
+{
+	string expected = ReadFileWithoutID(inExpectedPath);
+	string actual = ReadFileWithoutID(inActualPath);
+
+	if(expected.size() == 0 || expected != actual)
+	{
+		cout<<"document "<<inActualPath.c_str()<<" is different than "<<inExpectedPath.c_str()<<"\n";
+		return eFailure;
+	}
+	return eSuccess;
+}
+
+ADD_CATEGORIZED_TEST(DeferredStreamCompressionTest,"PDF")
@@ -0,0 +1,42 @@
+/*
+   Source File : DeferredStreamCompressionTest.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "TestsRunner.h"
+
+class PDFWriter;
+
+#include <string>
+
+class DeferredStreamCompressionTest : public ITestUnit
+{
+public:
+	DeferredStreamCompressionTest(void);
+	~DeferredStreamCompressionTest(void);
+
+	virtual PDFHummus::EStatusCode Run(const TestConfiguration& inTestConfiguration);
+
+private:
+	PDFHummus::EStatusCode WriteDocument(const TestConfiguration& inTestConfiguration,const std::string& inOutputPath,bool inDeferStreamCompression,bool inWriteObjectStreams);
+	PDFHummus::EStatusCode WritePages(PDFWriter& inPDFWriter,const TestConfiguration& inTestConfiguration,int inFirstPage,int inPagesCount);
+	PDFHummus::EStatusCode TestPositions();
+	PDFHummus::EStatusCode CompareDocuments(const std::string& inExpectedPath,const std::string& inActualPath);
+};
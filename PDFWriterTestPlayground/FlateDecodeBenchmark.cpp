@@ -0,0 +1,176 @@
+/*
+   Source File : FlateDecodeBenchmark.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "FlateDecodeBenchmark.h"
+#include "InputFile.h"
+#include "InputFlateDecodeStream.h"
+#include "PDFParser.h"
+#include "PDFObjectCast.h"
+#include "PDFStreamInput.h"
+#include "PDFDictionary.h"
+#include "PDFName.h"
+#include "RefCountPtr.h"
+#include "TimersRegistry.h"
+#include "Trace.h"
+
+#include <iostream>
+#include <list>
+
+using namespace std;
+using namespace PDFHummus;
+
+/*
+	Compares the two flate decoding paths over the flate streams of the test materials PDFs:
+	1. streaming - InputFlateDecodeStream reading blocks from the parser stream, the way the parser reads streams
+	2. one shot - reading the whole encoded stream (by its /Length) into memory, and decoding with InputFlateDecodeStream::DecodeBuffer
+	Both are expected to provide the exact same decoded content. timings are written to the trace file.
+*/
+
+#define ROUNDS 10
+#define READ_CHUNK_SIZE 4096
+
+FlateDecodeBenchmark::FlateDecodeBenchmark(void)
+{
+}
+
+FlateDecodeBenchmark::~FlateDecodeBenchmark(void)
+{
+}
+
+static const char* scBenchmarkFiles[] = {
+	"TestMaterials/XObjectContent.pdf",
+	"TestMaterials/ObjectStreams.pdf",
+	"TestMaterials/Linearized.pdf",
+	"TestMaterials/test3.pdf",
+	"TestMaterials/2.unfamiliar.entry.type.pdf",
+	"TestMaterials/1.unfamiliar.entry.type.pdf",
+	"TestMaterials/wrong.rotation.pdf",
+	NULL
+};
+
+EStatusCode FlateDecodeBenchmark::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+	TimersRegistry timers;
+
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"FlateDecodeBenchmark.txt"),true,true);
+
+	for(int i=0; scBenchmarkFiles[i] && eSuccess == status;++i)
+	{
+		status = BenchmarkFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,scBenchmarkFiles[i]),timers);
+		if(status != eSuccess)
+			cout<<"Flate decode benchmark failed for "<<scBenchmarkFiles[i]<<"\n";
+	}
+
+	if(eSuccess == status)
+		cout<<"Flate decoding of test materials streams, "<<ROUNDS<<" rounds. streaming: "<<timers.GetTotalMiliSeconds("Streaming")<<
+			"ms, one shot: "<<timers.GetTotalMiliSeconds("OneShot")<<"ms\n";
+	timers.TraceAndReleaseAll();
+
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+typedef list<RefCountPtr<PDFStreamInput> > PDFStreamInputList;
+
+EStatusCode FlateDecodeBenchmark::BenchmarkFile(const string& inFilePath,TimersRegistry& inTimers)
+{
+	EStatusCode status = eSuccess;
+	InputFile pdfFile;
+	PDFParser parser;
+	PDFStreamInputList flateStreams;
+
+	do
+	{
+		status = pdfFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+			break;
+
+		status = parser.StartPDFParsing(pdfFile.GetInputStream());
+		if(status != eSuccess)
+			break;
+
+		// collect simple flate streams (no predictors, no filter chains), those are the ones that the two paths can both decode
+		for(ObjectIDType i=1; i < parser.GetObjectsCount(); ++i)
+		{
+			PDFObjectCastPtr<PDFStreamInput> aStream(parser.ParseNewObject(i));
+			if(!aStream)
+				continue;
+			RefCountPtr<PDFDictionary> streamDictionary(aStream->QueryStreamDictionary());
+			PDFObjectCastPtr<PDFName> filterName(streamDictionary->QueryDirectObject("Filter"));
+			if(!filterName || filterName->GetValue() != "FlateDecode" || streamDictionary->Exists("DecodeParms"))
+				continue;
+			flateStreams.push_back(aStream);
+		}
+
+		IOBasicTypes::Byte buffer[READ_CHUNK_SIZE];
+		for(int round = 0; round < ROUNDS && eSuccess == status; ++round)
+		{
+			PDFStreamInputList::iterator it = flateStreams.begin();
+			for(; it != flateStreams.end() && eSuccess == status; ++it)
+			{
+				ByteVector streamed;
+				ByteVector oneShot;
+				ByteVector encoded;
+
+				inTimers.StartMeasure("Streaming");
+				IByteReader* streamReader = parser.StartReadingFromStream(it->GetPtr());
+				while(streamReader->NotEnded())
+				{
+					LongBufferSizeType readAmount = streamReader->Read(buffer,READ_CHUNK_SIZE);
+					if(0 == readAmount)
+						break;
+					streamed.insert(streamed.end(),buffer,buffer + readAmount);
+				}
+				delete streamReader;
+				inTimers.StopMeasureAndAccumulate("Streaming");
+
+				inTimers.StartMeasure("OneShot");
+				IByteReader* encodedReader = parser.StartReadingFromStreamForPlainCopying(it->GetPtr());
+				while(encodedReader->NotEnded())
+				{
+					LongBufferSizeType readAmount = encodedReader->Read(buffer,READ_CHUNK_SIZE);
+					if(0 == readAmount)
+						break;
+					encoded.insert(encoded.end(),buffer,buffer + readAmount);
+				}
+				delete encodedReader;
+				status = encoded.size() > 0 ? InputFlateDecodeStream::DecodeBuffer(&encoded[0],encoded.size(),oneShot) : eSuccess;
+				inTimers.StopMeasureAndAccumulate("OneShot");
+				if(status != eSuccess)
+				{
+					cout<<"One shot flate decoding failed\n";
+					break;
+				}
+
+				if(streamed != oneShot)
+				{
+					cout<<"Streaming and one shot flate decoding provided different results. streamed "<<streamed.size()<<" bytes, one shot "<<oneShot.size()<<" bytes\n";
+					status = eFailure;
+				}
+			}
+		}
+	}while(false);
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(FlateDecodeBenchmark,"PDFEmbedding")
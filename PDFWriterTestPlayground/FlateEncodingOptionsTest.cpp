@@ -0,0 +1,284 @@
+/*
+   Source File : FlateEncodingOptionsTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "FlateEncodingOptionsTest.h"
+#include "OutputFlateEncodeStream.h"
+#include "InputFlateDecodeStream.h"
+#include "OutputStringBufferStream.h"
+#include "InputStringBufferStream.h"
+#include "MyStringBuf.h"
+#include "IObjectsContextExtender.h"
+#include "PDFWriter.h"
+#include "PDFPage.h"
+#include "PDFRectangle.h"
+#include "PageContentContext.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+using namespace std;
+using namespace PDFHummus;
+
+FlateEncodingOptionsTest::FlateEncodingOptionsTest(void)
+{
+}
+
+FlateEncodingOptionsTest::~FlateEncodingOptionsTest(void)
+{
+}
+
+// extender that uses no compression for all streams, regardless of the document options
+class NoCompressionExtender : public IObjectsContextExtender
+{
+public:
+	virtual bool OverridesStreamCompression() {return false;}
+	virtual IByteWriter* GetCompressionWriteStream(IByteWriterWithPosition* inOutputStream) {return inOutputStream;}
+	virtual void FinalizeCompressedStreamWrite(IByteWriter* inCompressedStream) {}
+	virtual FlateEncodingOptions GetStreamFlateEncodingOptions(const FlateEncodingOptions& inDocumentOptions) {return FlateEncodingOptions(0);}
+};
+
+EStatusCode FlateEncodingOptionsTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+
+	// sample data. small (deflated in one go) and big (deflated as written)
+	string smallData = "hello world";
+	stringstream bigDataStream;
+	for(int i=0;i<100000;++i)
+		bigDataStream<<i * 7<<" "<<i % 13<<" m "<<(i * 31) % 1000<<" l S\n";
+	string bigData = bigDataStream.str();
+
+	FlateEncodingOptions optionsList[] = {
+		FlateEncodingOptions::DefaultFlateEncodingOptions(),
+		FlateEncodingOptions(0),
+		FlateEncodingOptions(1),
+		FlateEncodingOptions(9,1,9),
+		FlateEncodingOptions(6,2,1)
+	};
+
+	for(size_t i=0; i < sizeof(optionsList)/sizeof(FlateEncodingOptions) && eSuccess == status; ++i)
+	{
+		status = TestRoundTrip(smallData,optionsList[i]);
+		if(eSuccess == status)
+			status = TestRoundTrip(bigData,optionsList[i]);
+		if(status != eSuccess)
+			cout<<"failed round trip with level "<<optionsList[i].Level<<" strategy "<<optionsList[i].Strategy<<" memory level "<<optionsList[i].MemoryLevel<<"\n";
+	}
+	if(status != eSuccess)
+		return status;
+
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"FlateEncodingOptionsBenchmark.txt"),true,true);
+	TimersRegistry timers;
+
+	do
+	{
+		string defaultPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"FlateEncodingOptionsDefault.pdf");
+		string fastPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"FlateEncodingOptionsFast.pdf");
+		string storedPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"FlateEncodingOptionsStored.pdf");
+		string extenderPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"FlateEncodingOptionsExtender.pdf");
+
+		timers.StartMeasure("Default");
+		status = WriteDocument(defaultPath,FlateEncodingOptions::DefaultFlateEncodingOptions(),false);
+		timers.StopMeasureAndAccumulate("Default");
+		if(status != eSuccess)
+			break;
+
+		timers.StartMeasure("Fast");
+		status = WriteDocument(fastPath,FlateEncodingOptions(1),false);
+		timers.StopMeasureAndAccumulate("Fast");
+		if(status != eSuccess)
+			break;
+
+		status = WriteDocument(storedPath,FlateEncodingOptions(0),false);
+		if(status != eSuccess)
+			break;
+
+		// extender overrides the document level options
+		status = WriteDocument(extenderPath,FlateEncodingOptions(9),true);
+		if(status != eSuccess)
+			break;
+
+		InputFile defaultFile,fastFile,storedFile,extenderFile;
+		defaultFile.OpenFile(defaultPath);
+		fastFile.OpenFile(fastPath);
+		storedFile.OpenFile(storedPath);
+		extenderFile.OpenFile(extenderPath);
+
+		if(storedFile.GetFileSize() <= defaultFile.GetFileSize() || storedFile.GetFileSize() <= fastFile.GetFileSize())
+		{
+			cout<<"document with no compression is not bigger than compressed documents. "<<storedFile.GetFileSize()<<" vs. "<<defaultFile.GetFileSize()<<" and "<<fastFile.GetFileSize()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		if(extenderFile.GetFileSize() != storedFile.GetFileSize())
+		{
+			cout<<"document compressed with extender options has different size than expected. "<<extenderFile.GetFileSize()<<" vs. "<<storedFile.GetFileSize()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		cout<<"Writing with default compression level: "<<timers.GetTotalMiliSeconds("Default")<<"ms, "<<defaultFile.GetFileSize()<<" bytes\n";
+		cout<<"Writing with compression level 1: "<<timers.GetTotalMiliSeconds("Fast")<<"ms, "<<fastFile.GetFileSize()<<" bytes\n";
+	}while(false);
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+EStatusCode FlateEncodingOptionsTest::TestRoundTrip(const string& inData,const FlateEncodingOptions& inOptions)
+{
+	// encode in small writes, like the library does
+	MyStringBuf encodedBuffer;
+	OutputStringBufferStream encodedStream(&encodedBuffer);
+	OutputFlateEncodeStream encoder;
+	encoder.SetEncodingOptions(inOptions);
+	encoder.Assign(&encodedStream);
+	for(size_t i=0; i < inData.size(); i+=1000)
+		encoder.Write((const IOBasicTypes::Byte*)inData.c_str() + i,std::min<size_t>(1000,inData.size() - i));
+	encoder.Assign(NULL);
+
+	// and in one go
+	ByteVector oneShotEncoded;
+	if(OutputFlateEncodeStream::EncodeBuffer((const IOBasicTypes::Byte*)inData.c_str(),inData.size(),oneShotEncoded,inOptions) != eSuccess)
+	{
+		cout<<"failed one shot encoding\n";
+		return eFailure;
+	}
+
+	EStatusCode status = DecodeAndCompare(encodedStream.ToString(),inData);
+	if(status != eSuccess)
+	{
+		cout<<"failed to decode stream encoding\n";
+		return status;
+	}
+
+	status = DecodeAndCompare(string(oneShotEncoded.begin(),oneShotEncoded.end()),inData);
+	if(status != eSuccess)
+		cout<<"failed to decode one shot encoding\n";
+	return status;
+}
+
+EStatusCode FlateEncodingOptionsTest::DecodeAndCompare(const string& inEncoded,const string& inExpected)
+{
+	MyStringBuf encodedBuffer;
+	encodedBuffer.str(inEncoded);
+	InputStringBufferStream encodedInput(&encodedBuffer);
+	InputFlateDecodeStream decoder;
+	decoder.Assign(&encodedInput);
+
+	string decoded;
+	IOBasicTypes::Byte buffer[4096];
+	IOBasicTypes::LongBufferSizeType readAmount;
+	do
+	{
+		readAmount = decoder.Read(buffer,sizeof(buffer));
+		decoded.append((const char*)buffer,readAmount);
+	}while(readAmount > 0);
+	decoder.Assign(NULL);
+
+	if(decoded != inExpected)
+	{
+		cout<<"decoded data is different than the original. got "<<decoded.size()<<" bytes, expected "<<inExpected.size()<<"\n";
+		return eFailure;
+	}
+	return eSuccess;
+}
+
+EStatusCode FlateEncodingOptionsTest::WriteDocument(const string& inOutputPath,const FlateEncodingOptions& inOptions,bool inUseExtender)
+{
+	EStatusCode status;
+	PDFWriter pdfWriter;
+	NoCompressionExtender extender;
+
+	PDFCreationSettings creationSettings(true,true);
+	creationSettings.StreamsFlateEncodingOptions = inOptions;
+
+	do
+	{
+		status = pdfWriter.StartPDF(inOutputPath,ePDFVersion13,LogConfiguration::DefaultLogConfiguration(),creationSettings);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start PDF\n";
+			break;
+		}
+		if(inUseExtender)
+			pdfWriter.GetObjectsContext().SetObjectsContextExtender(&extender);
+
+		unsigned long seed = 1;
+		for(int i=0; i < 50 && eSuccess == status; ++i)
+		{
+			PDFPage* page = new PDFPage();
+			page->SetMediaBox(PDFRectangle(0,0,595,842));
+
+			PageContentContext* contentContext = pdfWriter.StartPageContentContext(page);
+			for(int j=0; j < 1000; ++j)
+			{
+				seed = seed * 1103515245 + 12345;
+				contentContext->re((seed >> 8) % 595,(seed >> 12) % 842,10,10);
+				contentContext->f();
+			}
+			status = pdfWriter.EndPageContentContext(contentContext);
+			if(status != eSuccess)
+			{
+				cout<<"failed to end content context for page "<<i<<"\n";
+				delete page;
+				break;
+			}
+
+			status = pdfWriter.WritePageAndRelease(page);
+			if(status != eSuccess)
+				cout<<"failed to write page "<<i<<"\n";
+		}
+		if(status != eSuccess)
+			break;
+
+		status = pdfWriter.EndPDF();
+		if(status != eSuccess)
+		{
+			cout<<"failed to end PDF\n";
+			break;
+		}
+
+		// make sure the result is readable
+		InputFile pdfFile;
+		status = pdfFile.OpenFile(inOutputPath);
+		if(status != eSuccess)
+			break;
+		PDFParser parser;
+		status = parser.StartPDFParsing(pdfFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inOutputPath.c_str()<<"\n";
+			break;
+		}
+	}while(false);
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(FlateEncodingOptionsTest,"IO")
@@ -0,0 +1,40 @@
+/*
+   Source File : FlateEncodingOptionsTest.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "TestsRunner.h"
+#include "FlateEncodingOptions.h"
+
+#include <string>
+
+class FlateEncodingOptionsTest : public ITestUnit
+{
+public:
+	FlateEncodingOptionsTest(void);
+	~FlateEncodingOptionsTest(void);
+
+	virtual PDFHummus::EStatusCode Run(const TestConfiguration& inTestConfiguration);
+
+private:
+	PDFHummus::EStatusCode TestRoundTrip(const std::string& inData,const FlateEncodingOptions& inOptions);
+	PDFHummus::EStatusCode DecodeAndCompare(const std::string& inEncoded,const std::string& inExpected);
+	PDFHummus::EStatusCode WriteDocument(const std::string& inOutputPath,const FlateEncodingOptions& inOptions,bool inUseExtender);
+};
@@ -0,0 +1,269 @@
+/*
+   Source File : GlyphLookupTablesTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "GlyphLookupTablesTest.h"
+#include "FreeTypeWrapper.h"
+#include "FreeTypeFaceWrapper.h"
+#include "PDFWriter.h"
+#include "PDFUsedFont.h"
+#include "UnicodeString.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <vector>
+
+#include FT_GLYPH_H
+
+using namespace std;
+using namespace PDFHummus;
+
+static const int scBenchmarkRounds = 2000;
+
+GlyphLookupTablesTest::GlyphLookupTablesTest(void)
+{
+}
+
+GlyphLookupTablesTest::~GlyphLookupTablesTest(void)
+{
+}
+
+EStatusCode GlyphLookupTablesTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = TestFont(inTestConfiguration,"TestMaterials/fonts/arial.ttf","");
+
+	if(eSuccess == status)
+		status = TestFont(inTestConfiguration,"TestMaterials/fonts/couri.ttf","");
+
+	if(eSuccess == status)
+		status = TestFont(inTestConfiguration,"TestMaterials/fonts/BrushScriptStd.otf","");
+
+	if(eSuccess == status)
+		status = TestFont(inTestConfiguration,"TestMaterials/fonts/HLB_____.PFB","TestMaterials/fonts/HLB_____.PFM");
+
+	if(eSuccess == status)
+		status = RunBenchmark(inTestConfiguration);
+
+	return status;
+}
+
+// the glyph width and box as read by loading the glyph, in pdf measurements. false if the glyph can't be loaded
+static bool LoadGlyphMetrics(FreeTypeFaceWrapper& inFace,unsigned int inGlyphIndex,FT_Pos& outWidth,FT_BBox& outBBox)
+{
+	FT_Glyph aGlyph;
+
+	if(inFace.LoadGlyph(inGlyphIndex) != 0 || FT_Get_Glyph(inFace->glyph,&aGlyph) != 0)
+		return false;
+	outWidth = inFace.GetInPDFMeasurements(inFace->glyph->metrics.horiAdvance);
+	FT_Glyph_Get_CBox(aGlyph,FT_GLYPH_BBOX_UNSCALED,&outBBox);
+	FT_Done_Glyph(aGlyph);
+	outBBox.xMin = inFace.GetInPDFMeasurements(outBBox.xMin);
+	outBBox.xMax = inFace.GetInPDFMeasurements(outBBox.xMax);
+	outBBox.yMin = inFace.GetInPDFMeasurements(outBBox.yMin);
+	outBBox.yMax = inFace.GetInPDFMeasurements(outBBox.yMax);
+	return true;
+}
+
+EStatusCode GlyphLookupTablesTest::TestFont(const TestConfiguration& inTestConfiguration,const string& inFontPath,const string& inMetricsPath)
+{
+	FreeTypeWrapper freeType;
+	string fontPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,inFontPath);
+	string metricsPath = inMetricsPath.size() > 0 ? RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,inMetricsPath) : "";
+	FT_Face face = metricsPath.size() > 0 ? freeType.NewFace(fontPath,metricsPath,0) : freeType.NewFace(fontPath,0);
+	FT_Face referenceFace = metricsPath.size() > 0 ? freeType.NewFace(fontPath,metricsPath,0) : freeType.NewFace(fontPath,0);
+	if(!face || !referenceFace)
+	{
+		cout<<"failed to load "<<inFontPath<<"\n";
+		return eFailure;
+	}
+
+	// the tables face, and a face used for loading glyphs directly
+	FreeTypeFaceWrapper tablesFace(face,fontPath,metricsPath,0);
+	FreeTypeFaceWrapper referenceFaceWrapper(referenceFace,fontPath,metricsPath,0);
+
+	// characters, twice so the second time is from the table. also some missing ones and one out of the unicode range
+	vector<unsigned long> characters;
+	for(int i=0;i<2;++i)
+	{
+		for(unsigned long c=0x20;c<0x180;++c)
+			characters.push_back(c);
+		characters.push_back(0x4E2D);
+		characters.push_back(0x1F600);
+		characters.push_back(0x110000);
+	}
+	vector<unsigned int> glyphs(characters.size());
+	tablesFace.GetGlyphsForUnicodeText(&(characters[0]),characters.size(),&(glyphs[0]));
+
+	for(size_t i=0;i<characters.size();++i)
+	{
+		ULongList character;
+		UIntList referenceGlyph;
+		character.push_back(characters[i]);
+		EStatusCode tablesStatus = tablesFace.GetGlyphsForUnicodeText(&(characters[i]),1,&(glyphs[i]));
+		EStatusCode referenceStatus = referenceFaceWrapper.GetGlyphsForUnicodeText(character,referenceGlyph);
+		if(glyphs[i] != referenceGlyph.front() || tablesStatus != referenceStatus)
+		{
+			cout<<inFontPath<<": character 0x"<<hex<<characters[i]<<dec<<" mapped to "<<glyphs[i]<<", expected "<<referenceGlyph.front()<<"\n";
+			return eFailure;
+		}
+	}
+
+	// widths and boxes of all glyphs, same as loading them. widths asked first for half of them, and boxes first for the other half
+	unsigned int glyphsCount = (unsigned int)face->num_glyphs;
+	vector<unsigned int> allGlyphs;
+	for(unsigned int g=0;g<glyphsCount;++g)
+		allGlyphs.push_back(g);
+	vector<FT_Pos> widths(glyphsCount);
+
+	for(unsigned int g=0;g<glyphsCount;++g)
+	{
+		FT_Pos referenceWidth = 0;
+		FT_BBox referenceBBox;
+		FT_BBox tablesBBox;
+		bool referenceLoaded = LoadGlyphMetrics(referenceFaceWrapper,g,referenceWidth,referenceBBox);
+		bool tablesLoaded;
+		FT_Pos tablesWidth;
+
+		if(g % 2 == 0)
+		{
+			tablesWidth = tablesFace.GetGlyphWidth(g);
+			tablesLoaded = tablesFace.GetGlyphBBox(g,tablesBBox);
+		}
+		else
+		{
+			tablesLoaded = tablesFace.GetGlyphBBox(g,tablesBBox);
+			tablesWidth = tablesFace.GetGlyphWidth(g);
+		}
+
+		if(tablesWidth != referenceWidth || tablesLoaded != referenceLoaded ||
+			(referenceLoaded && (tablesBBox.xMin != referenceBBox.xMin || tablesBBox.yMin != referenceBBox.yMin ||
+								tablesBBox.xMax != referenceBBox.xMax || tablesBBox.yMax != referenceBBox.yMax)))
+		{
+			cout<<inFontPath<<": glyph "<<g<<" width "<<tablesWidth<<", expected "<<referenceWidth<<", or different box\n";
+			return eFailure;
+		}
+	}
+
+	tablesFace.GetGlyphsWidths(&(allGlyphs[0]),allGlyphs.size(),&(widths[0]));
+	for(unsigned int g=0;g<glyphsCount;++g)
+	{
+		if(widths[g] != referenceFaceWrapper.GetGlyphWidth(g))
+		{
+			cout<<inFontPath<<": glyphs widths differ at glyph "<<g<<"\n";
+			return eFailure;
+		}
+	}
+
+	return eSuccess;
+}
+
+EStatusCode GlyphLookupTablesTest::RunBenchmark(const TestConfiguration& inTestConfiguration)
+{
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"GlyphLookupTablesBenchmark.txt"),true,true);
+	TimersRegistry timers;
+	EStatusCode status = eSuccess;
+	FreeTypeWrapper freeType;
+	string fontPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"TestMaterials/fonts/arial.ttf");
+	string text = "The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs! 0123456789";
+	FT_Face face = freeType.NewFace(fontPath,0);
+	PDFWriter pdfWriter;
+	PDFUsedFont* font = NULL;
+
+	do
+	{
+		if(!face)
+		{
+			cout<<"failed to load font\n";
+			status = eFailure;
+			break;
+		}
+		FreeTypeFaceWrapper faceWrapper(face,fontPath,0);
+
+		status = pdfWriter.StartPDF(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"GlyphLookupTablesBenchmark.pdf"),ePDFVersion13);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start PDF\n";
+			break;
+		}
+		font = pdfWriter.GetFontForFile(fontPath);
+		if(!font)
+		{
+			cout<<"failed to create font\n";
+			status = eFailure;
+			break;
+		}
+
+		// layout of a line per round: map to glyphs, and measure advance and box. first mapping a character and loading a glyph at a time
+		double directWidth = 0;
+		timers.StartMeasure("Direct");
+		for(int i=0;i<scBenchmarkRounds;++i)
+		{
+			UnicodeString unicode;
+			UIntList glyphs;
+			FT_Pos pen = 0;
+			FT_Pos xMax = 0;
+
+			unicode.FromUTF8(text);
+			for(ULongList::iterator it = unicode.GetUnicodeList().begin(); it != unicode.GetUnicodeList().end(); ++it)
+				glyphs.push_back(FT_Get_Char_Index(face,*it));
+			for(UIntList::iterator it = glyphs.begin(); it != glyphs.end(); ++it)
+			{
+				FT_Pos width;
+				FT_BBox bbox;
+				if(LoadGlyphMetrics(faceWrapper,*it,width,bbox))
+				{
+					if(pen + bbox.xMax > xMax)
+						xMax = pen + bbox.xMax;
+					pen += width;
+				}
+			}
+			directWidth = pen * 14 / 1000.0;
+		}
+		timers.StopMeasureAndAccumulate("Direct");
+
+		// and with the tables
+		double tablesWidth = 0;
+		timers.StartMeasure("Tables");
+		for(int i=0;i<scBenchmarkRounds;++i)
+		{
+			tablesWidth = font->CalculateTextAdvance(text,14);
+			font->CalculateTextDimensions(text,14);
+		}
+		timers.StopMeasureAndAccumulate("Tables");
+
+		if(directWidth != tablesWidth)
+		{
+			cout<<"text advance with tables is "<<tablesWidth<<", expected "<<directWidth<<"\n";
+			status = eFailure;
+		}
+
+		cout<<"Laying out "<<scBenchmarkRounds<<" lines of "<<text.size()<<" characters. loading glyphs: "<<timers.GetTotalMiliSeconds("Direct")<<
+			"ms, with lookup tables: "<<timers.GetTotalMiliSeconds("Tables")<<"ms\n";
+
+		status = pdfWriter.EndPDF();
+	}while(false);
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(GlyphLookupTablesTest,"Text")
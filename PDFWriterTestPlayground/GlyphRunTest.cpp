@@ -0,0 +1,323 @@
+/*
+   Source File : GlyphRunTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "GlyphRunTest.h"
+#include "TestFiles.h"
+#include "PDFWriter.h"
+#include "PDFPage.h"
+#include "PageContentContext.h"
+#include "PDFUsedFont.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace PDFHummus;
+
+static const int scBenchmarkStrings = 20000;
+
+GlyphRunTest::GlyphRunTest(void)
+{
+}
+
+GlyphRunTest::~GlyphRunTest(void)
+{
+}
+
+EStatusCode GlyphRunTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = TestSameGlyphs(inTestConfiguration);
+
+	if(eSuccess == status)
+		status = TestSameOutput(inTestConfiguration);
+
+	if(eSuccess == status)
+		status = RunBenchmark(inTestConfiguration);
+
+	return status;
+}
+
+// latin text is written with a simple font, the rest moves to a CID font. the last string is empty
+static const char* scTexts[] = {
+	"Hello World",
+	"abc",
+	"\xD7\xA9\xD7\x9C\xD7\x95\xD7\x9D \xCE\xB1\xCE\xB2\xCE\xB3",
+	"\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF\xE4\xB8\x96\xE7\x95\x8C",
+	""
+};
+
+static const char* scFonts[] = {
+	"TestMaterials/fonts/arial.ttf",
+	"TestMaterials/fonts/KozGoPro-Regular.otf"
+};
+
+EStatusCode GlyphRunTest::TestSameGlyphs(const TestConfiguration& inTestConfiguration)
+{
+	PDFWriter pdfWriter;
+	EStatusCode status = pdfWriter.StartPDF(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"GlyphRunGlyphs.pdf"),ePDFVersion13);
+	if(status != eSuccess)
+	{
+		cout<<"failed to start PDF\n";
+		return status;
+	}
+
+	GlyphRun run;
+	for(size_t i=0;i<sizeof(scFonts)/sizeof(const char*) && eSuccess == status;++i)
+	{
+		PDFUsedFont* font = pdfWriter.GetFontForFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,scFonts[i]));
+		if(!font)
+		{
+			cout<<"failed to create font for "<<scFonts[i]<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		for(size_t j=0;j<sizeof(scTexts)/sizeof(const char*) && eSuccess == status;++j)
+		{
+			GlyphUnicodeMappingList glyphsList;
+			GlyphUnicodeMappingList runAsList;
+
+			// the run is reused, so it should not keep glyphs of the previous string
+			EStatusCode listStatus = font->TranslateStringToGlyphs(scTexts[j],glyphsList);
+			EStatusCode runStatus = font->TranslateStringToGlyphs(scTexts[j],run);
+			run.ToList(runAsList);
+
+			bool same = listStatus == runStatus && runAsList.size() == glyphsList.size();
+			GlyphUnicodeMappingList::iterator itList = glyphsList.begin();
+			GlyphUnicodeMappingList::iterator itRun = runAsList.begin();
+			for(; same && itList != glyphsList.end(); ++itList,++itRun)
+				same = itList->mGlyphCode == itRun->mGlyphCode && itList->mUnicodeValues == itRun->mUnicodeValues;
+			if(!same)
+			{
+				cout<<scFonts[i]<<": glyph run for string "<<j<<" is different than the glyphs list\n";
+				status = eFailure;
+			}
+		}
+	}
+
+	// a glyph with several unicode values
+	GlyphUnicodeMapping ligature(0x1F,ULongVector());
+	ligature.mUnicodeValues.push_back('f');
+	ligature.mUnicodeValues.push_back('i');
+	run.Clear();
+	run.AddGlyph(3,' ');
+	run.AddGlyph(ligature);
+	run.AddGlyph(4,'!');
+	if(eSuccess == status &&
+		(run.GetGlyphsCount() != 3 || run.GetUnicodeValues(1) != ligature.mUnicodeValues || run.GetUnicodeValues(2) != ULongVector(1,'!')))
+	{
+		cout<<"unexpected unicode values for glyph run with a ligature\n";
+		status = eFailure;
+	}
+
+	if(pdfWriter.EndPDF() != eSuccess)
+	{
+		cout<<"failed to end PDF\n";
+		status = eFailure;
+	}
+	return status;
+}
+
+// write all texts with all fonts, and all text commands. either with glyphs lists, or with glyph runs and strings
+static EStatusCode WriteTexts(PDFWriter& inPDFWriter,const TestConfiguration& inTestConfiguration,bool inUseRuns)
+{
+	EStatusCode status = eSuccess;
+	PDFPage* page = new PDFPage();
+	page->SetMediaBox(PDFRectangle(0,0,595,842));
+	PageContentContext* contentContext = inPDFWriter.StartPageContentContext(page);
+	GlyphRun run;
+	double y = 800;
+
+	contentContext->BT();
+	for(size_t i=0;i<sizeof(scFonts)/sizeof(const char*) && eSuccess == status;++i)
+	{
+		PDFUsedFont* font = inPDFWriter.GetFontForFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,scFonts[i]));
+		if(!font)
+		{
+			cout<<"failed to create font for "<<scFonts[i]<<"\n";
+			status = eFailure;
+			break;
+		}
+		contentContext->Tf(font,20);
+		contentContext->TL(24);
+
+		// each text twice, so the second time uses glyphs that are already encoded
+		for(size_t j=0;j<2*sizeof(scTexts)/sizeof(const char*) && eSuccess == status;++j)
+		{
+			const char* text = scTexts[j % (sizeof(scTexts)/sizeof(const char*))];
+			int command = j % 3;
+
+			contentContext->Tm(1,0,0,1,50,y);
+			y -= 30;
+			if(inUseRuns)
+			{
+				// odd strings go through the UTF8 variants, which use a run internally
+				if(j % 2 == 1)
+				{
+					if(0 == command)
+						status = contentContext->Tj(text);
+					else if(1 == command)
+						status = contentContext->Quote(text);
+					else
+						status = contentContext->DoubleQuote(1,1,text);
+				}
+				else
+				{
+					font->TranslateStringToGlyphs(text,run);
+					if(0 == command)
+						status = contentContext->Tj(run);
+					else if(1 == command)
+						status = contentContext->Quote(run);
+					else
+						status = contentContext->DoubleQuote(1,1,run);
+				}
+			}
+			else
+			{
+				GlyphUnicodeMappingList glyphs;
+				font->TranslateStringToGlyphs(text,glyphs);
+				if(0 == command)
+					status = contentContext->Tj(glyphs);
+				else if(1 == command)
+					status = contentContext->Quote(glyphs);
+				else
+					status = contentContext->DoubleQuote(1,1,glyphs);
+			}
+			if(status != eSuccess)
+				cout<<"failed to write string "<<j<<" with "<<scFonts[i]<<"\n";
+		}
+	}
+	contentContext->ET();
+
+	if(eSuccess == status)
+		status = inPDFWriter.EndPageContentContext(contentContext);
+	if(eSuccess == status)
+		status = inPDFWriter.WritePageAndRelease(page);
+	else
+		delete page;
+	return status;
+}
+
+EStatusCode GlyphRunTest::TestSameOutput(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+	const char* outputs[] = {"GlyphRunLists.pdf","GlyphRunRuns.pdf"};
+
+	for(int i=0;i<2 && eSuccess == status;++i)
+	{
+		PDFWriter pdfWriter;
+		status = pdfWriter.StartPDF(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,outputs[i]),ePDFVersion13);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start "<<outputs[i]<<"\n";
+			break;
+		}
+		status = WriteTexts(pdfWriter,inTestConfiguration,i == 1);
+		if(eSuccess == status)
+			status = pdfWriter.EndPDF();
+	}
+	if(status != eSuccess)
+		return status;
+
+	if(ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,outputs[0])) !=
+		ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,outputs[1])))
+	{
+		cout<<"text written with glyph runs is different than text written with glyphs lists\n";
+		status = eFailure;
+	}
+	return status;
+}
+
+EStatusCode GlyphRunTest::RunBenchmark(const TestConfiguration& inTestConfiguration)
+{
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"GlyphRunBenchmark.txt"),true,true);
+	TimersRegistry timers;
+	EStatusCode status = eSuccess;
+	const char* outputs[] = {"GlyphRunBenchmarkLists.pdf","GlyphRunBenchmarkRuns.pdf"};
+	const char* timerNames[] = {"Lists","Runs"};
+
+	// many short strings, like a table. first with glyphs lists, then with strings, which use a glyph run
+	for(int i=0;i<2 && eSuccess == status;++i)
+	{
+		PDFWriter pdfWriter;
+		status = pdfWriter.StartPDF(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,outputs[i]),ePDFVersion13);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start "<<outputs[i]<<"\n";
+			break;
+		}
+		PDFUsedFont* font = pdfWriter.GetFontForFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"TestMaterials/fonts/arial.ttf"));
+		if(!font)
+		{
+			cout<<"failed to create font\n";
+			status = eFailure;
+			break;
+		}
+		PDFPage* page = new PDFPage();
+		page->SetMediaBox(PDFRectangle(0,0,595,842));
+		PageContentContext* contentContext = pdfWriter.StartPageContentContext(page);
+
+		timers.StartMeasure(timerNames[i]);
+		contentContext->BT();
+		contentContext->Tf(font,4);
+		for(int j=0;j<scBenchmarkStrings && eSuccess == status;++j)
+		{
+			stringstream cell;
+			cell<<"Item "<<j;
+			contentContext->Tm(1,0,0,1,10 + 40*(j % 14),830 - 4*((j / 14) % 200));
+			if(0 == i)
+			{
+				GlyphUnicodeMappingList glyphs;
+				font->TranslateStringToGlyphs(cell.str(),glyphs);
+				status = contentContext->Tj(glyphs);
+			}
+			else
+			{
+				status = contentContext->Tj(cell.str());
+			}
+		}
+		contentContext->ET();
+		timers.StopMeasureAndAccumulate(timerNames[i]);
+
+		if(eSuccess == status)
+			status = pdfWriter.EndPageContentContext(contentContext);
+		if(eSuccess == status)
+			status = pdfWriter.WritePageAndRelease(page);
+		else
+			delete page;
+		if(eSuccess == status)
+			status = pdfWriter.EndPDF();
+		if(status != eSuccess)
+			cout<<"failed to write "<<outputs[i]<<"\n";
+	}
+
+	if(eSuccess == status)
+		cout<<"Writing "<<scBenchmarkStrings<<" short strings. glyphs lists: "<<timers.GetTotalMiliSeconds("Lists")<<
+			"ms, glyph runs: "<<timers.GetTotalMiliSeconds("Runs")<<"ms\n";
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(GlyphRunTest,"Text")
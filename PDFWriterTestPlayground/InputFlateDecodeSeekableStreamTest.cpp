@@ -0,0 +1,306 @@
+/*
+   Source File : InputFlateDecodeSeekableStreamTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "InputFlateDecodeSeekableStreamTest.h"
+#include "InputFlateDecodeSeekableStream.h"
+#include "OutputFlateEncodeStream.h"
+#include "InputByteArrayStream.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFObject.h"
+#include "PDFDictionary.h"
+#include "PDFArray.h"
+#include "PDFInteger.h"
+#include "PDFName.h"
+#include "PDFIndirectObjectReference.h"
+#include "RefCountPtr.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace PDFHummus;
+
+static const unsigned long scDataLinesCount = 60000;
+static const IOBasicTypes::LongBufferSizeType scCheckpointsInterval = 64*1024;
+static const unsigned long scRandomReadsCount = 200;
+static const IOBasicTypes::LongBufferSizeType scRandomReadSize = 256;
+
+InputFlateDecodeSeekableStreamTest::InputFlateDecodeSeekableStreamTest(void)
+{
+}
+
+InputFlateDecodeSeekableStreamTest::~InputFlateDecodeSeekableStreamTest(void)
+{
+}
+
+static unsigned long NextRandom(unsigned long& ioSeed)
+{
+	ioSeed = ioSeed * 1103515245 + 12345;
+	return (ioSeed >> 16) & 0x7fff;
+}
+
+EStatusCode InputFlateDecodeSeekableStreamTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	const char* materials[] = {
+		"TestMaterials/ObjectStreams.pdf",
+		"TestMaterials/2.unfamiliar.entry.type.pdf",
+		"TestMaterials/china.pdf"
+	};
+
+	// a few MBs of object-like text, compressed as a PDF stream would be
+	stringstream decodedStream;
+	unsigned long seed = 1;
+	for(unsigned long i=0;i<scDataLinesCount;++i)
+		decodedStream<<i<<" 0 obj << /Type /Example /Index "<<i<<" /Value "<<NextRandom(seed)<<" >> endobj\n";
+	string decoded = decodedStream.str();
+
+	ByteVector encodedBytes;
+	if(OutputFlateEncodeStream::EncodeBuffer((const IOBasicTypes::Byte*)decoded.c_str(),decoded.size(),encodedBytes) != eSuccess)
+	{
+		cout<<"failed to encode test data\n";
+		return eFailure;
+	}
+	string encoded(encodedBytes.begin(),encodedBytes.end());
+
+	EStatusCode status = TestRandomAccess(decoded,encoded);
+
+	for(size_t i=0;i<sizeof(materials)/sizeof(const char*) && eSuccess == status;++i)
+		status = CompareParsing(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,materials[i]));
+
+	if(eSuccess == status)
+		status = RunBenchmark(inTestConfiguration,decoded,encoded);
+
+	return status;
+}
+
+EStatusCode InputFlateDecodeSeekableStreamTest::TestRandomAccess(const string& inDecoded,const string& inEncoded)
+{
+	// the encoded data is placed after some prefix, as a stream would be in a file
+	string source = string("prefix") + inEncoded + string("suffix");
+	InputByteArrayStream sourceStream((IOBasicTypes::Byte*)source.c_str(),source.size());
+	FlateDecodeIndex index(scCheckpointsInterval);
+	IOBasicTypes::Byte buffer[scRandomReadSize];
+
+	// sequential read, recording checkpoints
+	{
+		InputFlateDecodeSeekableStream decoder(&sourceStream,6,inEncoded.size(),&index);
+		string readData;
+		while(decoder.NotEnded())
+		{
+			IOBasicTypes::LongBufferSizeType readAmount = decoder.Read(buffer,scRandomReadSize);
+			readData.append((const char*)buffer,readAmount);
+		}
+		if(readData != inDecoded)
+		{
+			cout<<"sequential read differs from the decoded data. read "<<readData.size()<<" bytes, expected "<<inDecoded.size()<<"\n";
+			return eFailure;
+		}
+		// checkpoints are at deflate blocks boundaries, so they may be further apart than the interval
+		if(index.GetCheckpointsCount() < 2)
+		{
+			cout<<"expected checkpoints every "<<scCheckpointsInterval<<" bytes, got "<<index.GetCheckpointsCount()<<" for "<<inDecoded.size()<<" bytes\n";
+			return eFailure;
+		}
+	}
+
+	// random access, with the index and without it. also moving the source in between, as a parser would
+	FlateDecodeIndex* indexes[] = {&index,NULL};
+	for(int i=0;i<2;++i)
+	{
+		InputFlateDecodeSeekableStream decoder(&sourceStream,6,inEncoded.size(),indexes[i]);
+		unsigned long seed = 7;
+		for(unsigned long j=0;j<scRandomReadsCount / 4;++j)
+		{
+			IOBasicTypes::LongFilePositionType position = (NextRandom(seed) * 32768 + NextRandom(seed)) % inDecoded.size();
+			decoder.SetPosition(position);
+			sourceStream.SetPosition(0);
+			IOBasicTypes::LongBufferSizeType readAmount = decoder.Read(buffer,scRandomReadSize);
+			if(inDecoded.compare((size_t)position,(size_t)readAmount,(const char*)buffer,(size_t)readAmount) != 0 ||
+				(readAmount < scRandomReadSize && position + (IOBasicTypes::LongFilePositionType)readAmount != (IOBasicTypes::LongFilePositionType)inDecoded.size()))
+			{
+				cout<<"random read at "<<position<<" differs from the decoded data, "<<(indexes[i] ? "with" : "without")<<" index\n";
+				return eFailure;
+			}
+			if(decoder.GetCurrentPosition() != position + (IOBasicTypes::LongFilePositionType)readAmount)
+			{
+				cout<<"wrong position after random read at "<<position<<"\n";
+				return eFailure;
+			}
+		}
+
+		// reading back a little stays in the decoding window
+		unsigned long restartsCount = decoder.GetRestartsCount();
+		decoder.SetPosition(1000);
+		decoder.Read(buffer,scRandomReadSize);
+		decoder.SetPosition(900);
+		decoder.Read(buffer,scRandomReadSize);
+		if(inDecoded.compare(900,scRandomReadSize,(const char*)buffer,scRandomReadSize) != 0 || decoder.GetRestartsCount() > restartsCount + 1)
+		{
+			cout<<"reading back within the window failed\n";
+			return eFailure;
+		}
+
+		decoder.SetPositionFromEnd(10);
+		IOBasicTypes::LongBufferSizeType readAmount = decoder.Read(buffer,scRandomReadSize);
+		if(readAmount != 10 || inDecoded.compare(inDecoded.size() - 10,10,(const char*)buffer,10) != 0 || decoder.NotEnded())
+		{
+			cout<<"reading from end failed\n";
+			return eFailure;
+		}
+	}
+
+	return eSuccess;
+}
+
+EStatusCode InputFlateDecodeSeekableStreamTest::CompareParsing(const string& inFilePath)
+{
+	// object streams are not kept decoded [no budget, and a budget too small for any] so they're decoded for every object.
+	// with checkpoints every 1KB, objects are parsed from the nearest checkpoint
+	InputFile files[3];
+	PDFParser parsers[3];
+	PDFParsingOptions options[3];
+
+	options[0].DecodedObjectStreamsCacheBudget = 0;
+	options[1].DecodedObjectStreamsCacheBudget = 0;
+	options[1].FlateCheckpointsInterval = 1024;
+	options[2].DecodedObjectStreamsCacheBudget = 1;
+	options[2].FlateCheckpointsInterval = 1024;
+
+	for(int i=0;i<3;++i)
+	{
+		if(files[i].OpenFile(inFilePath) != eSuccess || parsers[i].StartPDFParsing(files[i].GetInputStream(),options[i]) != eSuccess)
+		{
+			cout<<"Failed to start parsing "<<inFilePath<<"\n";
+			return eFailure;
+		}
+	}
+
+	// going backwards, so that objects are not fetched in the object streams order
+	for(ObjectIDType objectID = parsers[0].GetObjectsCount(); objectID > 0; --objectID)
+	{
+		RefCountPtr<PDFObject> expectedObject(parsers[0].ParseNewObject(objectID-1));
+
+		for(int i=1;i<3;++i)
+		{
+			RefCountPtr<PDFObject> anObject(parsers[i].ParseNewObject(objectID-1));
+			if(!AreSameObjects(expectedObject.GetPtr(),anObject.GetPtr()))
+			{
+				cout<<"Object "<<objectID-1<<" of "<<inFilePath<<" is parsed differently with flate checkpoints\n";
+				return eFailure;
+			}
+		}
+	}
+
+	return eSuccess;
+}
+
+bool InputFlateDecodeSeekableStreamTest::AreSameObjects(PDFObject* inLeft,PDFObject* inRight)
+{
+	if(!inLeft || !inRight)
+		return !inLeft && !inRight;
+
+	if(inLeft->GetType() != inRight->GetType())
+		return false;
+
+	switch(inLeft->GetType())
+	{
+		case PDFObject::ePDFObjectInteger:
+			return ((PDFInteger*)inLeft)->GetValue() == ((PDFInteger*)inRight)->GetValue();
+		case PDFObject::ePDFObjectName:
+			return ((PDFName*)inLeft)->GetValue() == ((PDFName*)inRight)->GetValue();
+		case PDFObject::ePDFObjectIndirectObjectReference:
+			return ((PDFIndirectObjectReference*)inLeft)->mObjectID == ((PDFIndirectObjectReference*)inRight)->mObjectID;
+		case PDFObject::ePDFObjectArray:
+		{
+			PDFArray* leftArray = (PDFArray*)inLeft;
+			PDFArray* rightArray = (PDFArray*)inRight;
+			if(leftArray->GetLength() != rightArray->GetLength())
+				return false;
+			for(unsigned long i=0;i<leftArray->GetLength();++i)
+			{
+				RefCountPtr<PDFObject> leftItem(leftArray->QueryObject(i));
+				RefCountPtr<PDFObject> rightItem(rightArray->QueryObject(i));
+				if(!AreSameObjects(leftItem.GetPtr(),rightItem.GetPtr()))
+					return false;
+			}
+			return true;
+		}
+		case PDFObject::ePDFObjectDictionary:
+		{
+			MapIterator<PDFNameToPDFObjectMap> leftIt = ((PDFDictionary*)inLeft)->GetIterator();
+			MapIterator<PDFNameToPDFObjectMap> rightIt = ((PDFDictionary*)inRight)->GetIterator();
+			bool leftHasMore = leftIt.MoveNext();
+			bool rightHasMore = rightIt.MoveNext();
+			while(leftHasMore && rightHasMore)
+			{
+				if(leftIt.GetKey()->GetValue() != rightIt.GetKey()->GetValue() || !AreSameObjects(leftIt.GetValue(),rightIt.GetValue()))
+					return false;
+				leftHasMore = leftIt.MoveNext();
+				rightHasMore = rightIt.MoveNext();
+			}
+			return !leftHasMore && !rightHasMore;
+		}
+		default:
+			// other types are compared by type alone
+			return true;
+	}
+}
+
+EStatusCode InputFlateDecodeSeekableStreamTest::RunBenchmark(const TestConfiguration& inTestConfiguration,const string& inDecoded,const string& inEncoded)
+{
+	// random reads over the data, decoding from the stream start for each [as done without checkpoints] vs from the nearest checkpoint
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"InputFlateDecodeSeekableStreamBenchmark.txt"),true,true);
+	TimersRegistry timers;
+	InputByteArrayStream sourceStream((IOBasicTypes::Byte*)inEncoded.c_str(),inEncoded.size());
+	FlateDecodeIndex index(scCheckpointsInterval);
+	IOBasicTypes::Byte buffer[scRandomReadSize];
+	IOBasicTypes::LongBufferSizeType decodedBytes[2];
+	const char* timerNames[] = {"FromStart","FromCheckpoint"};
+
+	for(int i=0;i<2;++i)
+	{
+		unsigned long seed = 11;
+		decodedBytes[i] = 0;
+		timers.StartMeasure(timerNames[i]);
+		for(unsigned long j=0;j<scRandomReadsCount;++j)
+		{
+			IOBasicTypes::LongFilePositionType position = (NextRandom(seed) * 32768 + NextRandom(seed)) % inDecoded.size();
+			InputFlateDecodeSeekableStream decoder(&sourceStream,0,inEncoded.size(),0 == i ? NULL : &index);
+			decoder.SetPosition(position);
+			decoder.Read(buffer,scRandomReadSize);
+			decodedBytes[i] += decoder.GetDecodedBytesCount();
+		}
+		timers.StopMeasureAndAccumulate(timerNames[i]);
+	}
+
+	cout<<scRandomReadsCount<<" random reads from "<<inDecoded.size()<<" bytes of flate data. decoding from the start: "<<timers.GetTotalMiliSeconds(timerNames[0])<<
+		"ms ("<<decodedBytes[0]<<" bytes decoded), from checkpoints: "<<timers.GetTotalMiliSeconds(timerNames[1])<<"ms ("<<decodedBytes[1]<<
+		" bytes decoded, "<<index.GetCheckpointsCount()<<" checkpoints taking "<<index.GetMemorySize()<<" bytes)\n";
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return decodedBytes[1] < decodedBytes[0] ? eSuccess : eFailure;
+}
+
+ADD_CATEGORIZED_TEST(InputFlateDecodeSeekableStreamTest,"Parsing")
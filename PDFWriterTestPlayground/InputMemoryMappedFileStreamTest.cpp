@@ -0,0 +1,216 @@
+/*
+   Source File : InputMemoryMappedFileStreamTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "InputMemoryMappedFileStreamTest.h"
+#include "InputMemoryMappedFileStream.h"
+#include "InputFile.h"
+#include "OutputFile.h"
+#include "PDFParser.h"
+#include "PDFObject.h"
+#include "ParsedObjectsCache.h"
+#include "RefCountPtr.h"
+
+#include <iostream>
+#include <string.h>
+
+using namespace std;
+using namespace PDFHummus;
+
+InputMemoryMappedFileStreamTest::InputMemoryMappedFileStreamTest(void)
+{
+}
+
+InputMemoryMappedFileStreamTest::~InputMemoryMappedFileStreamTest(void)
+{
+}
+
+static const char* scTestFiles[] = {
+	"TestMaterials/XObjectContent.pdf",
+	"TestMaterials/ObjectStreams.pdf",
+	"TestMaterials/Linearized.pdf",
+	"TestMaterials/china.pdf",
+	NULL
+};
+
+EStatusCode InputMemoryMappedFileStreamTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+
+	for(int i=0; scTestFiles[i] && eSuccess == status;++i)
+	{
+		string filePath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,scTestFiles[i]);
+
+		status = CompareReading(filePath);
+		if(status != eSuccess)
+			break;
+
+		status = CompareParsing(filePath);
+	}
+
+	if(eSuccess == status)
+		status = TestEmptyFileFallback(inTestConfiguration);
+
+	return status;
+}
+
+EStatusCode InputMemoryMappedFileStreamTest::CompareReading(const string& inFilePath)
+{
+	InputFile regularFile;
+	InputMemoryMappedFileStream mappedStream;
+
+	if(regularFile.OpenFile(inFilePath) != eSuccess || mappedStream.Open(inFilePath) != eSuccess)
+	{
+		cout<<"Failed to open "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	if(regularFile.GetFileSize() != mappedStream.GetFileSize())
+	{
+		cout<<"Wrong mapped file size for "<<inFilePath<<". expected "<<regularFile.GetFileSize()<<", got "<<mappedStream.GetFileSize()<<"\n";
+		return eFailure;
+	}
+
+	// full read, in odd size chunks
+	IOBasicTypes::Byte regularBuffer[1000];
+	IOBasicTypes::Byte mappedBuffer[1000];
+	while(regularFile.GetInputStream()->NotEnded())
+	{
+		LongBufferSizeType regularRead = regularFile.GetInputStream()->Read(regularBuffer,1000);
+		LongBufferSizeType mappedRead = mappedStream.Read(mappedBuffer,1000);
+		if(regularRead != mappedRead || memcmp(regularBuffer,mappedBuffer,regularRead) != 0)
+		{
+			cout<<"Mapped read differs from regular read for "<<inFilePath<<" at position "<<mappedStream.GetCurrentPosition()<<"\n";
+			return eFailure;
+		}
+	}
+	if(mappedStream.NotEnded())
+	{
+		cout<<"Mapped stream not ended at end of file for "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	// positioning, and direct access
+	mappedStream.SetPositionFromEnd(100);
+	regularFile.GetInputStream()->SetPositionFromEnd(100);
+	if(mappedStream.GetCurrentPosition() != regularFile.GetInputStream()->GetCurrentPosition())
+	{
+		cout<<"Mapped stream position differs after setting position from end for "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	LongBufferSizeType spanSize;
+	const IOBasicTypes::Byte* span = mappedStream.GetContiguousSpan(spanSize);
+	LongBufferSizeType regularRead = regularFile.GetInputStream()->Read(regularBuffer,1000);
+	if(!span || spanSize != 100 || regularRead != 100 || memcmp(span,regularBuffer,100) != 0 || mappedStream.GetCurrentPosition() != mappedStream.GetFileSize() - 100)
+	{
+		cout<<"Wrong contiguous span at end of "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	mappedStream.SetPositionFromEnd(mappedStream.GetFileSize() + 10);
+	if(mappedStream.GetCurrentPosition() != 0)
+	{
+		cout<<"Setting position before file start should place the stream at its start for "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	mappedStream.Skip((LongBufferSizeType)mappedStream.GetFileSize() + 10);
+	if(mappedStream.NotEnded() || mappedStream.Read(mappedBuffer,1) != 0)
+	{
+		cout<<"Skipping beyond file end should end the stream for "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	return mappedStream.Close();
+}
+
+EStatusCode InputMemoryMappedFileStreamTest::CompareParsing(const string& inFilePath)
+{
+	InputFile regularFile;
+	InputFile mappedFile;
+	PDFParser regularParser;
+	PDFParser mappedParser;
+
+	if(regularFile.OpenFile(inFilePath) != eSuccess || mappedFile.OpenFile(inFilePath,true) != eSuccess)
+	{
+		cout<<"Failed to open "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	if(regularParser.StartPDFParsing(regularFile.GetInputStream()) != eSuccess || mappedParser.StartPDFParsing(mappedFile.GetInputStream()) != eSuccess)
+	{
+		cout<<"Failed to start parsing "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	if(regularParser.GetObjectsCount() != mappedParser.GetObjectsCount() || 
+		regularParser.GetPagesCount() != mappedParser.GetPagesCount() ||
+		regularParser.GetXrefPosition() != mappedParser.GetXrefPosition())
+	{
+		cout<<"Parsing memory mapped file yields different structure for "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	for(ObjectIDType objectID = 0; objectID < regularParser.GetObjectsCount(); ++objectID)
+	{
+		RefCountPtr<PDFObject> regularObject(regularParser.ParseNewObject(objectID));
+		RefCountPtr<PDFObject> mappedObject(mappedParser.ParseNewObject(objectID));
+
+		// size estimate goes over the whole object, so it's good enough for comparing the two
+		if(!regularObject != !mappedObject ||
+			(!!regularObject && ParsedObjectsCache::EstimateObjectSize(regularObject.GetPtr()) != ParsedObjectsCache::EstimateObjectSize(mappedObject.GetPtr())))
+		{
+			cout<<"Object "<<objectID<<" in "<<inFilePath<<" is parsed differently from a memory mapped file\n";
+			return eFailure;
+		}
+	}
+
+	return eSuccess;
+}
+
+EStatusCode InputMemoryMappedFileStreamTest::TestEmptyFileFallback(const TestConfiguration& inTestConfiguration)
+{
+	string emptyFilePath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"MemoryMappedEmpty.txt");
+	OutputFile emptyFile;
+
+	if(emptyFile.OpenFile(emptyFilePath) != eSuccess || emptyFile.CloseFile() != eSuccess)
+	{
+		cout<<"Failed to create empty file\n";
+		return eFailure;
+	}
+
+	InputMemoryMappedFileStream mappedStream;
+	if(mappedStream.Open(emptyFilePath) == eSuccess)
+	{
+		cout<<"Mapping an empty file is expected to fail\n";
+		return eFailure;
+	}
+
+	InputFile inputFile;
+	if(inputFile.OpenFile(emptyFilePath,true) != eSuccess || inputFile.GetFileSize() != 0)
+	{
+		cout<<"Opening an empty file for memory mapping should fall back to a regular file\n";
+		return eFailure;
+	}
+
+	return eSuccess;
+}
+
+ADD_CATEGORIZED_TEST(InputMemoryMappedFileStreamTest,"IO")
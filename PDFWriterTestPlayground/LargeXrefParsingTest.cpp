@@ -0,0 +1,278 @@
+/*
+   Source File : LargeXrefParsingTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "LargeXrefParsingTest.h"
+#include "OutputFile.h"
+#include "OutputFlateEncodeStream.h"
+#include "OutputStringBufferStream.h"
+#include "InputStringBufferStream.h"
+#include "OutputStreamTraits.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFDictionary.h"
+#include "PDFInteger.h"
+#include "PDFObjectCast.h"
+#include "RefCountPtr.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace PDFHummus;
+
+LargeXrefParsingTest::LargeXrefParsingTest(void)
+{
+}
+
+LargeXrefParsingTest::~LargeXrefParsingTest(void)
+{
+}
+
+/*
+	A synthetic file with 10M objects, as in large archival exports. Objects 1-3 are a real catalog, pages and page.
+	The rest are xref entries only - mostly objects in object streams, with some free entries. an incremental
+	update replaces the page, so that parsing the file also merges the 10M entries section with the update section.
+*/
+
+static const ObjectIDType scObjectsCount = 10000000;
+static const ObjectIDType scFirstSyntheticObject = 4;
+
+static void GetSyntheticEntry(ObjectIDType inObjectID,int& outType,ObjectIDType& outPosition,unsigned long& outRevision)
+{
+	if(inObjectID % 101 == 0)
+	{
+		outType = 0;
+		outPosition = 0;
+		outRevision = 1;
+	}
+	else
+	{
+		outType = 2;
+		outPosition = (inObjectID / 101) * 101;
+		outRevision = (inObjectID % 101) - 1;
+	}
+}
+
+static void WriteString(IByteWriter* inStream,const string& inString)
+{
+	inStream->Write((const IOBasicTypes::Byte*)inString.c_str(),inString.size());
+}
+
+static void WriteXrefRow(IOBasicTypes::Byte* inRow,int inType,LongFilePositionType inPosition,unsigned long inRevision)
+{
+	// W [1 4 2]
+	inRow[0] = (IOBasicTypes::Byte)inType;
+	inRow[1] = (IOBasicTypes::Byte)((inPosition >> 24) & 0xff);
+	inRow[2] = (IOBasicTypes::Byte)((inPosition >> 16) & 0xff);
+	inRow[3] = (IOBasicTypes::Byte)((inPosition >> 8) & 0xff);
+	inRow[4] = (IOBasicTypes::Byte)(inPosition & 0xff);
+	inRow[5] = (IOBasicTypes::Byte)((inRevision >> 8) & 0xff);
+	inRow[6] = (IOBasicTypes::Byte)(inRevision & 0xff);
+}
+
+EStatusCode LargeXrefParsingTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status;
+	string syntheticPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"LargeXrefParsing.pdf");
+
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"LargeXrefParsingBenchmark.txt"),true,true);
+
+	do
+	{
+		status = WriteSyntheticFile(syntheticPath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to write synthetic file\n";
+			break;
+		}
+
+		status = CheckSyntheticFile(syntheticPath);
+	}while(false);
+
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+EStatusCode LargeXrefParsingTest::WriteSyntheticFile(const string& inFilePath)
+{
+	OutputFile pdfFile;
+	EStatusCode status = pdfFile.OpenFile(inFilePath);
+	if(status != eSuccess)
+		return status;
+
+	IByteWriterWithPosition* stream = pdfFile.GetOutputStream();
+	LongFilePositionType objectPositions[4];
+
+	WriteString(stream,"%PDF-1.5\r\n%\xBD\xBE\xBC\r\n");
+	objectPositions[1] = stream->GetCurrentPosition();
+	WriteString(stream,"1 0 obj\r\n<< /Type /Catalog /Pages 2 0 R >>\r\nendobj\r\n");
+	objectPositions[2] = stream->GetCurrentPosition();
+	WriteString(stream,"2 0 obj\r\n<< /Type /Pages /Kids [ 3 0 R ] /Count 1 >>\r\nendobj\r\n");
+	objectPositions[3] = stream->GetCurrentPosition();
+	WriteString(stream,"3 0 obj\r\n<< /Type /Page /Parent 2 0 R /MediaBox [ 0 0 595 842 ] >>\r\nendobj\r\n");
+
+	// first section. xref stream for all objects, which is the last object
+	MyStringBuf encodedXref;
+	{
+		OutputStringBufferStream encodedXrefStream(&encodedXref);
+		OutputFlateEncodeStream flateStream(&encodedXrefStream);
+		vector<IOBasicTypes::Byte> rows(7*4096);
+		size_t rowsCount = 0;
+		LongFilePositionType xrefPosition = stream->GetCurrentPosition();
+
+		for(ObjectIDType i=0;i<scObjectsCount;++i)
+		{
+			if(0 == i)
+				WriteXrefRow(&rows[7*rowsCount],0,0,65535);
+			else if(i < scFirstSyntheticObject)
+				WriteXrefRow(&rows[7*rowsCount],1,objectPositions[i],0);
+			else if(i == scObjectsCount - 1)
+				WriteXrefRow(&rows[7*rowsCount],1,xrefPosition,0);
+			else
+			{
+				int type;
+				ObjectIDType position;
+				unsigned long revision;
+				GetSyntheticEntry(i,type,position,revision);
+				WriteXrefRow(&rows[7*rowsCount],type,position,revision);
+			}
+			if(++rowsCount == 4096)
+			{
+				flateStream.Write(&rows[0],rows.size());
+				rowsCount = 0;
+			}
+		}
+		if(rowsCount > 0)
+			flateStream.Write(&rows[0],7*rowsCount);
+		flateStream.Assign(NULL);
+	}
+
+	LongFilePositionType firstXrefPosition = stream->GetCurrentPosition();
+	stringstream xrefHeader;
+	xrefHeader<<(scObjectsCount-1)<<" 0 obj\r\n<< /Type /XRef /Size "<<scObjectsCount<<" /W [ 1 4 2 ] /Root 1 0 R /Filter /FlateDecode /Length "<<
+		encodedXref.GetCurrentWritePosition()<<" >>\r\nstream\r\n";
+	WriteString(stream,xrefHeader.str());
+	{
+		InputStringBufferStream encodedXrefReader(&encodedXref);
+		OutputStreamTraits traits(stream);
+		traits.CopyToOutputStream(&encodedXrefReader);
+	}
+	WriteString(stream,"\r\nendstream\r\nendobj\r\n");
+	stringstream firstTrailer;
+	firstTrailer<<"startxref\r\n"<<firstXrefPosition<<"\r\n%%EOF\r\n";
+	WriteString(stream,firstTrailer.str());
+
+	// update section. replaces the page, and adds its own xref stream
+	LongFilePositionType newPagePosition = stream->GetCurrentPosition();
+	WriteString(stream,"3 0 obj\r\n<< /Type /Page /Parent 2 0 R /MediaBox [ 0 0 595 842 ] /Rotate 90 >>\r\nendobj\r\n");
+
+	LongFilePositionType secondXrefPosition = stream->GetCurrentPosition();
+	IOBasicTypes::Byte rows[14];
+	WriteXrefRow(rows,1,newPagePosition,0);
+	WriteXrefRow(rows + 7,1,secondXrefPosition,0);
+	stringstream secondXrefHeader;
+	secondXrefHeader<<scObjectsCount<<" 0 obj\r\n<< /Type /XRef /Size "<<(scObjectsCount+1)<<" /Index [ 3 1 "<<scObjectsCount<<" 1 ] /W [ 1 4 2 ] /Root 1 0 R /Prev "<<
+		firstXrefPosition<<" /Length 14 >>\r\nstream\r\n";
+	WriteString(stream,secondXrefHeader.str());
+	stream->Write(rows,14);
+	WriteString(stream,"\r\nendstream\r\nendobj\r\n");
+	stringstream secondTrailer;
+	secondTrailer<<"startxref\r\n"<<secondXrefPosition<<"\r\n%%EOF\r\n";
+	WriteString(stream,secondTrailer.str());
+
+	return pdfFile.CloseFile();
+}
+
+EStatusCode LargeXrefParsingTest::CheckSyntheticFile(const string& inFilePath)
+{
+	EStatusCode status;
+	InputFile pdfFile;
+	PDFParser parser;
+	TimersRegistry timers;
+
+	do
+	{
+		status = pdfFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		timers.StartMeasure("ParseXref");
+		status = parser.StartPDFParsing(pdfFile.GetInputStream());
+		timers.StopMeasureAndAccumulate("ParseXref");
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		if(parser.GetObjectsCount() != scObjectsCount + 1)
+		{
+			cout<<"wrong objects count. expected "<<(scObjectsCount + 1)<<" got "<<parser.GetObjectsCount()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		// the page should be the one from the update
+		RefCountPtr<PDFDictionary> page(parser.ParsePage(0));
+		PDFObjectCastPtr<PDFInteger> rotate(!page ? NULL : page->QueryDirectObject("Rotate"));
+		if(!rotate || rotate->GetValue() != 90)
+		{
+			cout<<"page was not taken from the update section\n";
+			status = eFailure;
+			break;
+		}
+
+		for(ObjectIDType i=scFirstSyntheticObject;i<scObjectsCount - 1 && eSuccess == status;i+=997)
+		{
+			int type;
+			ObjectIDType position;
+			unsigned long revision;
+			GetSyntheticEntry(i,type,position,revision);
+
+			XrefEntryInput entry = parser.GetXrefEntry(i);
+			if(entry.mType != (type == 0 ? eXrefEntryDelete : eXrefEntryStreamObject) ||
+				entry.mObjectPosition != (LongFilePositionType)position ||
+				entry.mRivision != revision)
+			{
+				cout<<"wrong xref entry for object "<<i<<"\n";
+				status = eFailure;
+			}
+		}
+		if(status != eSuccess)
+			break;
+
+		cout<<"Parsing xref of "<<scObjectsCount<<" objects: "<<timers.GetTotalMiliSeconds("ParseXref")<<"ms\n";
+		cout<<"Xref memory: "<<parser.GetXrefTable().GetAllocatedSize()<<" bytes. As an XrefEntryInput array: "<<
+			((unsigned long long)parser.GetObjectsCount())*sizeof(XrefEntryInput)<<" bytes\n";
+	}while(false);
+
+	timers.TraceAndReleaseAll();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(LargeXrefParsingTest,"Parsing")
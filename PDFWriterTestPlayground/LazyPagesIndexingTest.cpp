@@ -0,0 +1,296 @@
+/*
+   Source File : LazyPagesIndexingTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "LazyPagesIndexingTest.h"
+#include "TestFiles.h"
+#include "InputFile.h"
+#include "OutputFile.h"
+#include "IByteWriterWithPosition.h"
+#include "PDFParser.h"
+#include "PDFDictionary.h"
+#include "RefCountPtr.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace std;
+using namespace PDFHummus;
+
+LazyPagesIndexingTest::LazyPagesIndexingTest(void)
+{
+}
+
+LazyPagesIndexingTest::~LazyPagesIndexingTest(void)
+{
+}
+
+static const unsigned long scManyPagesCount = 20000;
+
+EStatusCode LazyPagesIndexingTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+	string manyPagesPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"LazyPagesIndexingManyPages.pdf");
+	string flatTreePath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"LazyPagesIndexingFlatTree.pdf");
+	string brokenFlatTreePath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"LazyPagesIndexingBrokenFlatTree.pdf");
+
+	const char* materials[] = {
+		"TestMaterials/Original.pdf",
+		"TestMaterials/AddedPage.pdf",
+		"TestMaterials/ObjectStreams.pdf",
+		"TestMaterials/XObjectContent.pdf",
+		"TestMaterials/kids-as-reference.pdf",
+		"TestMaterials/china.pdf",
+		"TestMaterials/Linearized.pdf"
+	};
+
+	for(size_t i=0;i<sizeof(materials)/sizeof(const char*) && eSuccess == status;++i)
+		status = CompareWithFullIndexing(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,materials[i]));
+	if(status != eSuccess)
+		return status;
+
+	status = WriteManyPagesDocument(manyPagesPath,scManyPagesCount,false);
+	if(status != eSuccess)
+		return status;
+
+	status = CompareWithFullIndexing(manyPagesPath);
+	if(status != eSuccess)
+		return status;
+
+	// a flat pages tree, with all pages directly under the root
+	status = WriteFlatPagesTreeDocument(flatTreePath,false);
+	if(status != eSuccess)
+		return status;
+
+	status = CompareWithFullIndexing(flatTreePath);
+	if(status != eSuccess)
+		return status;
+
+	status = WriteFlatPagesTreeDocument(brokenFlatTreePath,true);
+	if(status != eSuccess)
+		return status;
+
+	status = TestFlatPagesTreeIsNotFullyParsed(brokenFlatTreePath);
+	if(status != eSuccess)
+		return status;
+
+	// benchmark the common case of opening a large document to get to its first page
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"LazyPagesIndexingBenchmark.txt"),true,true);
+
+	status = BenchmarkFirstPage(manyPagesPath);
+	if(eSuccess == status)
+		status = BenchmarkFirstPage(flatTreePath);
+
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+EStatusCode LazyPagesIndexingTest::BenchmarkFirstPage(const string& inFilePath)
+{
+	EStatusCode status = eSuccess;
+	TimersRegistry timers;
+
+	for(int i=0;i<2 && eSuccess == status;++i)
+	{
+		bool lazy = (i == 1);
+		string timerName = lazy ? "LazyIndexing" : "FullIndexing";
+		PDFParsingOptions options;
+		options.LazyPagesIndexing = lazy;
+
+		InputFile pdfFile;
+		PDFParser parser;
+		status = pdfFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		timers.StartMeasure(timerName);
+		status = parser.StartPDFParsing(pdfFile.GetInputStream(),options);
+		RefCountPtr<PDFDictionary> firstPage(parser.ParsePage(0));
+		timers.StopMeasureAndAccumulate(timerName);
+		if(status != eSuccess || !firstPage)
+		{
+			cout<<"failed to parse first page of "<<inFilePath.c_str()<<"\n";
+			status = eFailure;
+			break;
+		}
+		cout<<"Opening "<<inFilePath.c_str()<<" and parsing its first page, "<<(lazy ? "lazy indexing: " : "full indexing: ")<<timers.GetTotalMiliSeconds(timerName)<<"ms\n";
+	}
+
+	timers.TraceAndReleaseAll();
+	return status;
+}
+
+EStatusCode LazyPagesIndexingTest::WriteFlatPagesTreeDocument(const string& inOutputPath,bool inBreakLastKid)
+{
+	// PDFWriter writes balanced pages trees, so write this one directly. object 1 is the catalog, 2 the pages
+	// root, and pages follow. when breaking the last kid, it refers to an object that does not exist
+	EStatusCode status;
+	OutputFile outputFile;
+	stringstream content;
+	vector<long long> positions;
+	unsigned long objectsCount = scManyPagesCount + 2;
+
+	content<<"%PDF-1.3\n";
+	positions.push_back((long long)content.tellp());
+	content<<"1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n";
+	positions.push_back((long long)content.tellp());
+	content<<"2 0 obj\n<< /Type /Pages /Count "<<scManyPagesCount<<" /Kids [";
+	for(unsigned long i=0;i<scManyPagesCount;++i)
+		content<<" "<<(inBreakLastKid && i == scManyPagesCount - 1 ? objectsCount + 1 : i + 3)<<" 0 R";
+	content<<" ] >>\nendobj\n";
+	for(unsigned long i=0;i<scManyPagesCount;++i)
+	{
+		positions.push_back((long long)content.tellp());
+		content<<i + 3<<" 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [ 0 0 595 842 ] >>\nendobj\n";
+	}
+
+	long long xrefPosition = (long long)content.tellp();
+	content<<"xref\n0 "<<objectsCount + 1<<"\n0000000000 65535 f\r\n";
+	for(vector<long long>::iterator it = positions.begin(); it != positions.end(); ++it)
+	{
+		content.width(10);
+		content.fill('0');
+		content<<*it<<" 00000 n\r\n";
+	}
+	content<<"trailer\n<< /Size "<<objectsCount + 1<<" /Root 1 0 R >>\nstartxref\n"<<xrefPosition<<"\n%%EOF\n";
+
+	status = outputFile.OpenFile(inOutputPath);
+	if(status != eSuccess)
+	{
+		cout<<"failed to open "<<inOutputPath.c_str()<<" for writing\n";
+		return status;
+	}
+	string contentString = content.str();
+	outputFile.GetOutputStream()->Write((const IOBasicTypes::Byte*)contentString.c_str(),contentString.size());
+	return outputFile.CloseFile();
+}
+
+EStatusCode LazyPagesIndexingTest::TestFlatPagesTreeIsNotFullyParsed(const string& inFilePath)
+{
+	// the last kid of this flat tree is broken. with lazy indexing, only the located kid is parsed, so
+	// the first page can be parsed, and just the last one fails
+	EStatusCode status;
+	InputFile pdfFile;
+	PDFParser parser;
+	PDFParsingOptions options;
+	options.LazyPagesIndexing = true;
+
+	do
+	{
+		status = pdfFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		status = parser.StartPDFParsing(pdfFile.GetInputStream(),options);
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<" with lazy pages indexing\n";
+			break;
+		}
+
+		RefCountPtr<PDFDictionary> firstPage(parser.ParsePage(0));
+		if(!firstPage)
+		{
+			cout<<"failed to parse first page of "<<inFilePath.c_str()<<". flat tree kids are probably all parsed\n";
+			status = eFailure;
+			break;
+		}
+
+		if(parser.GetPageObjectID(scManyPagesCount - 1) != 0)
+		{
+			cout<<"expected the broken last page of "<<inFilePath.c_str()<<" not to be found\n";
+			status = eFailure;
+			break;
+		}
+	}while(false);
+
+	return status;
+}
+
+EStatusCode LazyPagesIndexingTest::CompareWithFullIndexing(const string& inFilePath)
+{
+	EStatusCode status;
+	InputFile fullFile,lazyFile;
+	PDFParser fullParser,lazyParser;
+	PDFParsingOptions lazyOptions;
+	lazyOptions.LazyPagesIndexing = true;
+
+	do
+	{
+		status = fullFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+		status = lazyFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		status = fullParser.StartPDFParsing(fullFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<" with full pages indexing\n";
+			break;
+		}
+
+		status = lazyParser.StartPDFParsing(lazyFile.GetInputStream(),lazyOptions);
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<" with lazy pages indexing\n";
+			break;
+		}
+
+		if(fullParser.GetPagesCount() != lazyParser.GetPagesCount())
+		{
+			cout<<"pages count mismatch for "<<inFilePath.c_str()<<". full indexing "<<fullParser.GetPagesCount()<<", lazy indexing "<<lazyParser.GetPagesCount()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		// go backwards, so that lazy indexing gets to the pages in a different order than the one the tree is built with
+		unsigned long i = fullParser.GetPagesCount();
+		while(i-- > 0)
+		{
+			if(fullParser.GetPageObjectID(i) != lazyParser.GetPageObjectID(i))
+			{
+				cout<<"page object ID mismatch for "<<inFilePath.c_str()<<" at page "<<i<<". full indexing "<<fullParser.GetPageObjectID(i)<<", lazy indexing "<<lazyParser.GetPageObjectID(i)<<"\n";
+				status = eFailure;
+				break;
+			}
+		}
+	}while(false);
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(LazyPagesIndexingTest,"Parsing")
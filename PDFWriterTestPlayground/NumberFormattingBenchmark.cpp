@@ -0,0 +1,279 @@
+/*
+   Source File : NumberFormattingBenchmark.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "NumberFormattingBenchmark.h"
+#include "PrimitiveObjectsWriter.h"
+#include "OutputStringBufferStream.h"
+#include "SafeBufferMacrosDefs.h"
+#include "TimersRegistry.h"
+#include "Trace.h"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <locale>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+using namespace PDFHummus;
+
+/*
+	Compares PrimitiveObjectsWriter numbers writing with the previous implementation - a classic locale stringstream
+	for real numbers (trimming trailing zeros), and sprintf for integers. Both are expected to provide the same text.
+	timings are written to the trace file.
+*/
+
+#define VALUES_COUNT 1000000
+
+NumberFormattingBenchmark::NumberFormattingBenchmark(void)
+{
+}
+
+NumberFormattingBenchmark::~NumberFormattingBenchmark(void)
+{
+}
+
+EStatusCode NumberFormattingBenchmark::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status;
+
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"NumberFormattingBenchmark.txt"),true,true);
+
+	do
+	{
+		status = TestSamples();
+		if(status != eSuccess)
+			break;
+
+		status = BenchmarkDoubles();
+		if(status != eSuccess)
+			break;
+
+		status = BenchmarkIntegers();
+	}while(false);
+
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+static string WriteDouble(double inValue,unsigned short inDecimalPlaces)
+{
+	OutputStringBufferStream stream;
+	PrimitiveObjectsWriter writer(&stream);
+
+	writer.SetDecimalPlaces(inDecimalPlaces);
+	writer.WriteDouble(inValue,eTokenSepratorNone);
+	return stream.ToString();
+}
+
+static void LegacyWriteDouble(double inValue,string& outResult)
+{
+	stringstream s;
+	s.imbue(locale::classic());
+	s<<fixed<<inValue;
+	outResult = s.str();
+
+	if(outResult.find('.') == string::npos)
+		return;
+	size_t length = outResult.length();
+	while(length > 0 && outResult[length-1] == '0')
+		--length;
+	if(length > 0 && outResult[length-1] == '.')
+		--length;
+	outResult.resize(length);
+}
+
+struct DoubleSample
+{
+	double mValue;
+	unsigned short mDecimalPlaces;
+	const char* mExpected;
+};
+
+static const DoubleSample scDoubleSamples[] = {
+	{0,6,"0"},
+	{1,6,"1"},
+	{-1,6,"-1"},
+	{0.5,6,"0.5"},
+	{-0.25,6,"-0.25"},
+	{595.276,6,"595.276"},
+	{841.89,6,"841.89"},
+	{0.000001,6,"0.000001"},
+	{0.0000004,6,"0"},
+	{-0.0000004,6,"0"},
+	{0.1,6,"0.1"},
+	{123456789.125,6,"123456789.125"},
+	{78.4252,2,"78.43"},
+	{78.4252,0,"78"},
+	{-662.8997,3,"-662.9"},
+	{0.99999,3,"1"},
+	{1.0/3,10,"0.3333333333"},
+	{1e20,6,"100000000000000000000"},
+	// half way values are rounded like the stream does - by the exact value of the double, and ties to even
+	{58.5305645,6,"58.530564"},
+	{-58.5305645,6,"-58.530564"},
+	{0.0000005,6,"0"},
+	{2.5,0,"2"},
+	{3.5,0,"4"},
+	{0.125,2,"0.12"},
+	{0.375,2,"0.38"},
+	{-1e20,2,"-100000000000000000000"},
+	{0,0,NULL}
+};
+
+EStatusCode NumberFormattingBenchmark::TestSamples()
+{
+	EStatusCode status = eSuccess;
+
+	for(int i=0; scDoubleSamples[i].mExpected; ++i)
+	{
+		string result = WriteDouble(scDoubleSamples[i].mValue,scDoubleSamples[i].mDecimalPlaces);
+		if(result != scDoubleSamples[i].mExpected)
+		{
+			cout<<"Wrong double formatting with "<<scDoubleSamples[i].mDecimalPlaces<<" decimal places. expected "<<
+				scDoubleSamples[i].mExpected<<" got "<<result<<"\n";
+			status = eFailure;
+		}
+	}
+
+	// values half way between two 6 decimal places values, compared with the legacy implementation
+	srand(0);
+	string legacyResult;
+	for(int i=0; i < 100000; ++i)
+	{
+		double aValue = ((rand() % 2000000000) + 0.5) / 1000000.0 - 1000.0;
+		LegacyWriteDouble(aValue,legacyResult);
+		string result = WriteDouble(aValue,6);
+		if(result != legacyResult)
+		{
+			cout<<"Half way value written differently than the legacy implementation. expected "<<legacyResult<<" got "<<result<<"\n";
+			status = eFailure;
+			break;
+		}
+	}
+
+	// decimal places are capped
+	OutputStringBufferStream stream;
+	PrimitiveObjectsWriter writer(&stream);
+	writer.SetDecimalPlaces(100);
+	if(writer.GetDecimalPlaces() != 10)
+	{
+		cout<<"Expected decimal places to be capped at 10, got "<<writer.GetDecimalPlaces()<<"\n";
+		status = eFailure;
+	}
+
+	return status;
+}
+
+EStatusCode NumberFormattingBenchmark::BenchmarkDoubles()
+{
+	EStatusCode status = eSuccess;
+	TimersRegistry timers;
+	vector<double> values;
+
+	// coordinates like values, with varying precision
+	srand(0);
+	for(int i=0; i < VALUES_COUNT; ++i)
+	{
+		double aValue = (rand() % 2000000) / 1000.0 - 1000.0;
+		if(i % 3 == 0)
+			aValue += (rand() % 1000) / 1000000.0;
+		values.push_back(aValue);
+	}
+
+	OutputStringBufferStream legacyStream;
+	string aValueString;
+	timers.StartMeasure("Legacy");
+	for(vector<double>::iterator it = values.begin(); it != values.end(); ++it)
+	{
+		LegacyWriteDouble(*it,aValueString);
+		legacyStream.Write((const IOBasicTypes::Byte*)aValueString.c_str(),aValueString.size());
+		legacyStream.Write((const IOBasicTypes::Byte*)" ",1);
+	}
+	timers.StopMeasureAndAccumulate("Legacy");
+
+	OutputStringBufferStream writerStream;
+	PrimitiveObjectsWriter writer(&writerStream);
+	timers.StartMeasure("PrimitiveObjectsWriter");
+	for(vector<double>::iterator it = values.begin(); it != values.end(); ++it)
+		writer.WriteDouble(*it);
+	timers.StopMeasureAndAccumulate("PrimitiveObjectsWriter");
+
+	if(legacyStream.ToString() != writerStream.ToString())
+	{
+		cout<<"Real numbers written differently than the legacy implementation\n";
+		status = eFailure;
+	}
+
+	cout<<"Writing "<<VALUES_COUNT<<" real numbers. legacy: "<<timers.GetTotalMiliSeconds("Legacy")<<
+		"ms, PrimitiveObjectsWriter: "<<timers.GetTotalMiliSeconds("PrimitiveObjectsWriter")<<"ms\n";
+	timers.TraceAndReleaseAll();
+
+	return status;
+}
+
+EStatusCode NumberFormattingBenchmark::BenchmarkIntegers()
+{
+	EStatusCode status = eSuccess;
+	TimersRegistry timers;
+	vector<long long> values;
+
+	srand(0);
+	for(int i=0; i < VALUES_COUNT; ++i)
+		values.push_back(((long long)rand() << (i % 32)) * (i % 2 == 0 ? 1 : -1));
+	values.push_back(0);
+	values.push_back(9223372036854775807LL);
+	values.push_back(-9223372036854775807LL - 1);
+
+	OutputStringBufferStream legacyStream;
+	char buffer[512];
+	timers.StartMeasure("Legacy");
+	for(vector<long long>::iterator it = values.begin(); it != values.end(); ++it)
+	{
+		SAFE_SPRINTF_1(buffer,512,"%lld",*it);
+		legacyStream.Write((const IOBasicTypes::Byte*)buffer,strlen(buffer));
+		legacyStream.Write((const IOBasicTypes::Byte*)" ",1);
+	}
+	timers.StopMeasureAndAccumulate("Legacy");
+
+	OutputStringBufferStream writerStream;
+	PrimitiveObjectsWriter writer(&writerStream);
+	timers.StartMeasure("PrimitiveObjectsWriter");
+	for(vector<long long>::iterator it = values.begin(); it != values.end(); ++it)
+		writer.WriteInteger(*it);
+	timers.StopMeasureAndAccumulate("PrimitiveObjectsWriter");
+
+	if(legacyStream.ToString() != writerStream.ToString())
+	{
+		cout<<"Integers written differently than the legacy implementation\n";
+		status = eFailure;
+	}
+
+	cout<<"Writing "<<values.size()<<" integers. legacy: "<<timers.GetTotalMiliSeconds("Legacy")<<
+		"ms, PrimitiveObjectsWriter: "<<timers.GetTotalMiliSeconds("PrimitiveObjectsWriter")<<"ms\n";
+	timers.TraceAndReleaseAll();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(NumberFormattingBenchmark,"ObjectContext")
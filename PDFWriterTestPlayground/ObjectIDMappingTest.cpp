@@ -0,0 +1,317 @@
+/*
+   Source File : ObjectIDMappingTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ObjectIDMappingTest.h"
+#include "ObjectIDTypeToObjectIDTypeMap.h"
+#include "PDFWriter.h"
+#include "PDFDocumentCopyingContext.h"
+#include "PDFParser.h"
+#include "MapIterator.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <map>
+
+using namespace std;
+using namespace PDFHummus;
+
+static const int scBenchmarkMergesCount = 10;
+static const int scBenchmarkLookupRounds = 50;
+
+ObjectIDMappingTest::ObjectIDMappingTest(void)
+{
+}
+
+ObjectIDMappingTest::~ObjectIDMappingTest(void)
+{
+}
+
+EStatusCode ObjectIDMappingTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = TestMap();
+
+	if(eSuccess == status)
+		status = TestCopiedObjectsMapping(inTestConfiguration);
+
+	if(eSuccess == status)
+		status = RunBenchmark(inTestConfiguration);
+
+	return status;
+}
+
+EStatusCode ObjectIDMappingTest::TestMap()
+{
+	// same behavior as std::map, for the operations copying uses. the dense range covers some of the IDs, so both dense and sparse
+	// mappings are used
+	ObjectIDTypeToObjectIDTypeMap denseMap;
+	map<ObjectIDType,ObjectIDType> treeMap;
+	unsigned long seed = 3;
+
+	denseMap.SetDenseRange(2000);
+
+	for(int i=0;i<1000;++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		ObjectIDType sourceID = (seed >> 16) % 5000;
+		bool denseInserted = denseMap.insert(ObjectIDTypeToObjectIDTypeMap::value_type(sourceID,i + 1)).second;
+		bool treeInserted = treeMap.insert(map<ObjectIDType,ObjectIDType>::value_type(sourceID,i + 1)).second;
+		if(denseInserted != treeInserted)
+		{
+			cout<<"insert of "<<sourceID<<" differs from std::map\n";
+			return eFailure;
+		}
+	}
+	denseMap[7000] = 1;
+	treeMap[7000] = 1;
+	denseMap.erase(7000);
+	treeMap.erase(7000);
+
+	// IDs way beyond the dense range [say, from a broken reference] don't allocate dense storage for all IDs below them
+	ObjectIDType hugeID = (ObjectIDType)-2;
+	denseMap[hugeID] = 2;
+	treeMap[hugeID] = 2;
+
+	// growing the dense range moves sparse mappings into it
+	denseMap.SetDenseRange(4000);
+
+	if(denseMap.size() != treeMap.size() || denseMap.find(5001) != denseMap.end() || denseMap.count(7000) != 0)
+	{
+		cout<<"map has "<<denseMap.size()<<" mappings, expected "<<treeMap.size()<<"\n";
+		return eFailure;
+	}
+
+	MapIterator<ObjectIDTypeToObjectIDTypeMap> it(denseMap);
+	map<ObjectIDType,ObjectIDType>::iterator itTree = treeMap.begin();
+	while(it.MoveNext())
+	{
+		if(itTree == treeMap.end() || it.GetKey() != itTree->first || it.GetValue() != itTree->second ||
+			denseMap.find(itTree->first)->second != itTree->second)
+		{
+			cout<<"iteration differs from std::map at "<<it.GetKey()<<"\n";
+			return eFailure;
+		}
+		++itTree;
+	}
+	if(itTree != treeMap.end())
+	{
+		cout<<"iteration ended early\n";
+		return eFailure;
+	}
+
+	ObjectIDTypeBitmap bitmap(100);
+	if(!bitmap.Insert(5) || bitmap.Insert(5) || !bitmap.Insert(hugeID) || bitmap.Insert(hugeID) ||
+		!bitmap.Contains(5) || !bitmap.Contains(hugeID) || bitmap.Contains(6) || bitmap.Contains(hugeID - 1))
+	{
+		cout<<"bitmap differs from std::set\n";
+		return eFailure;
+	}
+
+	return eSuccess;
+}
+
+EStatusCode ObjectIDMappingTest::TestCopiedObjectsMapping(const TestConfiguration& inTestConfiguration)
+{
+	PDFWriter pdfWriter;
+	PDFDocumentCopyingContext* copyingContext = NULL;
+	EStatusCode status;
+
+	do
+	{
+		status = pdfWriter.StartPDF(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ObjectIDMappingTest.pdf"),ePDFVersion13);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start PDF\n";
+			break;
+		}
+
+		copyingContext = pdfWriter.CreatePDFCopyingContext(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"TestMaterials/XObjectContent.pdf"));
+		if(!copyingContext)
+		{
+			cout<<"failed to create copying context\n";
+			status = eFailure;
+			break;
+		}
+
+		// replace object 1 with a new object, and copy the pages
+		ObjectIDTypeToObjectIDTypeMap replacements;
+		ObjectIDType replacementID = pdfWriter.GetObjectsContext().GetInDirectObjectsRegistry().AllocateNewObjectID();
+		replacements[1] = replacementID;
+		copyingContext->ReplaceSourceObjects(replacements);
+
+		for(unsigned long i=0;i<copyingContext->GetSourceDocumentParser()->GetPagesCount() && eSuccess == status;++i)
+			status = copyingContext->AppendPDFPageFromPDF(i).first;
+		if(status != eSuccess)
+		{
+			cout<<"failed to append pages\n";
+			break;
+		}
+
+		// the copied objects mapping agrees with single lookups, goes by source ID order, and has the replacement
+		MapIterator<ObjectIDTypeToObjectIDTypeMap> it = copyingContext->GetCopiedObjectsMappingIterator();
+		unsigned long mappingsCount = 0;
+		ObjectIDType lastSourceID = 0;
+		while(it.MoveNext() && eSuccess == status)
+		{
+			EStatusCodeAndObjectIDType copiedID = copyingContext->GetCopiedObjectID(it.GetKey());
+			if(copiedID.first != eSuccess || copiedID.second != it.GetValue() || (mappingsCount > 0 && it.GetKey() <= lastSourceID))
+			{
+				cout<<"copied objects mapping is wrong for source object "<<it.GetKey()<<"\n";
+				status = eFailure;
+			}
+			lastSourceID = it.GetKey();
+			++mappingsCount;
+		}
+		if(eSuccess == status && (mappingsCount < 2 || copyingContext->GetCopiedObjectID(1).second != replacementID))
+		{
+			cout<<"expected the copied pages objects and the replacement in the copied objects mapping, got "<<mappingsCount<<" mappings\n";
+			status = eFailure;
+		}
+		if(status != eSuccess)
+			break;
+
+		// object 1 was replaced rather than copied, so it has to be written here
+		pdfWriter.GetObjectsContext().StartNewIndirectObject(replacementID);
+		pdfWriter.GetObjectsContext().WriteKeyword("null");
+		pdfWriter.GetObjectsContext().EndIndirectObject();
+
+		delete copyingContext;
+		copyingContext = NULL;
+
+		status = pdfWriter.EndPDF();
+		if(status != eSuccess)
+			cout<<"failed to end PDF\n";
+	}while(false);
+
+	delete copyingContext;
+	return status;
+}
+
+EStatusCode ObjectIDMappingTest::RunBenchmark(const TestConfiguration& inTestConfiguration)
+{
+	const char* materials[] = {
+		"TestMaterials/china.pdf",
+		"TestMaterials/2.unfamiliar.entry.type.pdf",
+		"TestMaterials/XObjectContent.pdf"
+	};
+
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ObjectIDMappingBenchmark.txt"),true,true);
+	TimersRegistry timers;
+	EStatusCode status = eSuccess;
+	PDFWriter pdfWriter;
+	ObjectIDType maxXrefSize = 0;
+
+	// merging the same files over and over, each into a new mapping
+	timers.StartMeasure("Merge");
+	do
+	{
+		status = pdfWriter.StartPDF(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ObjectIDMappingBenchmark.pdf"),ePDFVersion13);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start PDF\n";
+			break;
+		}
+
+		for(int i=0;i<scBenchmarkMergesCount && eSuccess == status;++i)
+		{
+			for(size_t j=0;j<sizeof(materials)/sizeof(const char*) && eSuccess == status;++j)
+			{
+				PDFDocumentCopyingContext* copyingContext = pdfWriter.CreatePDFCopyingContext(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,materials[j]));
+				if(!copyingContext)
+				{
+					cout<<"failed to create copying context for "<<materials[j]<<"\n";
+					status = eFailure;
+					break;
+				}
+				if(copyingContext->GetSourceDocumentParser()->GetXrefSize() > maxXrefSize)
+					maxXrefSize = copyingContext->GetSourceDocumentParser()->GetXrefSize();
+				for(unsigned long k=0;k<copyingContext->GetSourceDocumentParser()->GetPagesCount() && eSuccess == status;++k)
+					status = copyingContext->AppendPDFPageFromPDF(k).first;
+				delete copyingContext;
+			}
+		}
+		if(status != eSuccess)
+		{
+			cout<<"failed to merge pages\n";
+			break;
+		}
+
+		status = pdfWriter.EndPDF();
+		if(status != eSuccess)
+			cout<<"failed to end PDF\n";
+	}while(false);
+	timers.StopMeasureAndAccumulate("Merge");
+
+	// the mapping traffic of copying on its own. each source object is looked up a few times [once per reference], and added once
+	unsigned long found = 0;
+	timers.StartMeasure("TreeMap");
+	for(int i=0;i<scBenchmarkLookupRounds;++i)
+	{
+		map<ObjectIDType,ObjectIDType> treeMap;
+		for(ObjectIDType j=1;j<maxXrefSize;++j)
+		{
+			ObjectIDType sourceID = (j * 7919) % maxXrefSize;
+			for(int k=0;k<4;++k)
+			{
+				if(treeMap.find(sourceID) == treeMap.end())
+					treeMap.insert(map<ObjectIDType,ObjectIDType>::value_type(sourceID,j));
+				else
+					++found;
+			}
+		}
+	}
+	timers.StopMeasureAndAccumulate("TreeMap");
+
+	timers.StartMeasure("DenseMap");
+	for(int i=0;i<scBenchmarkLookupRounds;++i)
+	{
+		ObjectIDTypeToObjectIDTypeMap denseMap;
+		denseMap.SetDenseRange(maxXrefSize);
+		for(ObjectIDType j=1;j<maxXrefSize;++j)
+		{
+			ObjectIDType sourceID = (j * 7919) % maxXrefSize;
+			for(int k=0;k<4;++k)
+			{
+				if(denseMap.find(sourceID) == denseMap.end())
+					denseMap.insert(ObjectIDTypeToObjectIDTypeMap::value_type(sourceID,j));
+				else
+					--found;
+			}
+		}
+	}
+	timers.StopMeasureAndAccumulate("DenseMap");
+
+	if(eSuccess == status && found != 0)
+	{
+		cout<<"dense map and std::map lookups found different objects\n";
+		status = eFailure;
+	}
+
+	cout<<"Merging "<<scBenchmarkMergesCount<<" times "<<sizeof(materials)/sizeof(const char*)<<" files: "<<timers.GetTotalMiliSeconds("Merge")<<
+		"ms. mapping lookups for "<<scBenchmarkLookupRounds<<" files of "<<maxXrefSize<<" objects with std::map: "<<timers.GetTotalMiliSeconds("TreeMap")<<
+		"ms, with dense map: "<<timers.GetTotalMiliSeconds("DenseMap")<<"ms\n";
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(ObjectIDMappingTest,"PDFEmbedding")
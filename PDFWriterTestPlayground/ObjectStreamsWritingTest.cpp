@@ -0,0 +1,274 @@
+/*
+   Source File : ObjectStreamsWritingTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ObjectStreamsWritingTest.h"
+#include "PDFWriter.h"
+#include "PDFPage.h"
+#include "PDFRectangle.h"
+#include "PageContentContext.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFObject.h"
+#include "PDFDictionary.h"
+#include "PDFName.h"
+#include "PDFObjectCast.h"
+#include "RefCountPtr.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace PDFHummus;
+
+ObjectStreamsWritingTest::ObjectStreamsWritingTest(void)
+{
+}
+
+ObjectStreamsWritingTest::~ObjectStreamsWritingTest(void)
+{
+}
+
+static const int scPagesCount = 150;
+
+EStatusCode ObjectStreamsWritingTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status;
+	string plainPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ObjectStreamsWritingPlain.pdf");
+	string compactPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ObjectStreamsWriting.pdf");
+
+	do
+	{
+		status = WriteDocument(inTestConfiguration,plainPath,false);
+		if(status != eSuccess)
+		{
+			cout<<"failed to write document without object streams\n";
+			break;
+		}
+
+		status = WriteDocument(inTestConfiguration,compactPath,true);
+		if(status != eSuccess)
+		{
+			cout<<"failed to write document with object streams\n";
+			break;
+		}
+
+		status = VerifyDocument(plainPath,false);
+		if(status != eSuccess)
+			break;
+
+		status = VerifyDocument(compactPath,true);
+		if(status != eSuccess)
+			break;
+
+		InputFile plainFile,compactFile;
+		plainFile.OpenFile(plainPath);
+		compactFile.OpenFile(compactPath);
+		if(compactFile.GetFileSize() >= plainFile.GetFileSize())
+		{
+			cout<<"document with object streams is not smaller than plain document. "<<compactFile.GetFileSize()<<" vs. "<<plainFile.GetFileSize()<<"\n";
+			status = eFailure;
+			break;
+		}
+	}while(false);
+
+	return status;
+}
+
+EStatusCode ObjectStreamsWritingTest::WriteDocument(const TestConfiguration& inTestConfiguration,const string& inOutputPath,bool inWriteObjectStreams)
+{
+	EStatusCode status;
+	string statePath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ObjectStreamsWritingState.txt");
+
+	do
+	{
+		// write the document in two sessions, to make sure pending object streams survive shutdown and restart
+		{
+			PDFWriter pdfWriter;
+			status = pdfWriter.StartPDF(inOutputPath,ePDFVersion13,LogConfiguration::DefaultLogConfiguration(),
+										PDFCreationSettings(true,true,EncryptionOptions::DefaultEncryptionOptions(),inWriteObjectStreams));
+			if(status != eSuccess)
+			{
+				cout<<"failed to start PDF\n";
+				break;
+			}
+
+			status = WritePages(pdfWriter,inTestConfiguration,0,scPagesCount/2);
+			if(status != eSuccess)
+				break;
+
+			status = pdfWriter.Shutdown(statePath);
+			if(status != eSuccess)
+			{
+				cout<<"failed to shutdown PDF writing\n";
+				break;
+			}
+		}
+		{
+			PDFWriter pdfWriter;
+			status = pdfWriter.ContinuePDF(inOutputPath,statePath);
+			if(status != eSuccess)
+			{
+				cout<<"failed to continue PDF writing\n";
+				break;
+			}
+
+			status = WritePages(pdfWriter,inTestConfiguration,scPagesCount/2,scPagesCount - scPagesCount/2);
+			if(status != eSuccess)
+				break;
+
+			status = pdfWriter.EndPDF();
+			if(status != eSuccess)
+			{
+				cout<<"failed to end PDF\n";
+				break;
+			}
+		}
+	}while(false);
+
+	return status;
+}
+
+EStatusCode ObjectStreamsWritingTest::WritePages(PDFWriter& inPDFWriter,const TestConfiguration& inTestConfiguration,int inFirstPage,int inPagesCount)
+{
+	EStatusCode status = eSuccess;
+
+	PDFUsedFont* font = inPDFWriter.GetFontForFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"TestMaterials/fonts/arial.ttf"));
+	if(!font)
+	{
+		cout<<"failed to create font object for arial.ttf\n";
+		return eFailure;
+	}
+
+	for(int i=inFirstPage; i < inFirstPage + inPagesCount && eSuccess == status;++i)
+	{
+		PDFPage* page = new PDFPage();
+		page->SetMediaBox(PDFRectangle(0,0,595,842));
+
+		PageContentContext* contentContext = inPDFWriter.StartPageContentContext(page);
+		if(!contentContext)
+		{
+			cout<<"failed to create content context for page "<<i<<"\n";
+			delete page;
+			status = eFailure;
+			break;
+		}
+
+		stringstream text;
+		text<<"Statement page "<<i + 1;
+
+		contentContext->BT();
+		contentContext->k(0,0,0,1);
+		contentContext->Tf(font,1);
+		contentContext->Tm(30,0,0,30,78.4252,662.8997);
+		contentContext->Tj(text.str());
+		contentContext->ET();
+
+		status = inPDFWriter.EndPageContentContext(contentContext);
+		if(status != eSuccess)
+		{
+			cout<<"failed to end content context for page "<<i<<"\n";
+			delete page;
+			break;
+		}
+
+		status = inPDFWriter.WritePageAndRelease(page);
+		if(status != eSuccess)
+			cout<<"failed to write page "<<i<<"\n";
+	}
+
+	return status;
+}
+
+EStatusCode ObjectStreamsWritingTest::VerifyDocument(const string& inFilePath,bool inExpectObjectStreams)
+{
+	EStatusCode status = eSuccess;
+	InputFile pdfFile;
+	PDFParser parser;
+
+	do
+	{
+		status = pdfFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		status = parser.StartPDFParsing(pdfFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		if(parser.GetPagesCount() != scPagesCount)
+		{
+			cout<<"wrong pages count for "<<inFilePath.c_str()<<". expected "<<scPagesCount<<" got "<<parser.GetPagesCount()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		if(inExpectObjectStreams && parser.GetPDFLevel() < 1.5)
+		{
+			cout<<"expected PDF level of at least 1.5 with object streams, got "<<parser.GetPDFLevel()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		PDFObjectCastPtr<PDFName> trailerType(parser.GetTrailer()->QueryDirectObject("Type"));
+		if(inExpectObjectStreams != (!!trailerType && trailerType->GetValue() == "XRef"))
+		{
+			cout<<"unexpected xref form for "<<inFilePath.c_str()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		// all used objects should parse, and stream objects entries appear only when object streams are written
+		ObjectIDType compressedObjectsCount = 0;
+		for(ObjectIDType i = 1; i < parser.GetObjectsCount() && eSuccess == status;++i)
+		{
+			XrefEntryInput entry = parser.GetXrefEntry(i);
+			if(entry.mType == eXrefEntryDelete)
+				continue;
+			if(entry.mType == eXrefEntryStreamObject)
+				++compressedObjectsCount;
+
+			RefCountPtr<PDFObject> anObject(parser.ParseNewObject(i));
+			if(!anObject)
+			{
+				cout<<"failed to parse object "<<i<<" of "<<inFilePath.c_str()<<"\n";
+				status = eFailure;
+			}
+		}
+		if(status != eSuccess)
+			break;
+
+		if(inExpectObjectStreams != (compressedObjectsCount > 0))
+		{
+			cout<<"unexpected count of objects in object streams for "<<inFilePath.c_str()<<": "<<compressedObjectsCount<<"\n";
+			status = eFailure;
+			break;
+		}
+	}while(false);
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(ObjectStreamsWritingTest,"PDF")
@@ -0,0 +1,485 @@
+/*
+   Source File : PDFContentStreamReaderTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "PDFContentStreamReaderTest.h"
+#include "PDFContentStreamReader.h"
+#include "PDFObjectParser.h"
+#include "PDFParser.h"
+#include "PDFWriter.h"
+#include "PDFPage.h"
+#include "PDFRectangle.h"
+#include "PageContentContext.h"
+#include "InputFile.h"
+#include "InputStringStream.h"
+#include "PDFObject.h"
+#include "PDFSymbol.h"
+#include "PDFArray.h"
+#include "PDFDictionary.h"
+#include "PDFStreamInput.h"
+#include "RefCountPtr.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using namespace PDFHummus;
+
+static const unsigned long scBenchmarkPagesCount = 50;
+static const unsigned long scBenchmarkLinesPerPage = 200;
+static const int scBenchmarkReadsCount = 2;
+
+PDFContentStreamReaderTest::PDFContentStreamReaderTest(void)
+{
+}
+
+PDFContentStreamReaderTest::~PDFContentStreamReaderTest(void)
+{
+}
+
+EStatusCode PDFContentStreamReaderTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	const char* materials[] = {
+		"TestMaterials/XObjectContent.pdf",
+		"TestMaterials/china.pdf",
+		"TestMaterials/Linearized.pdf"
+	};
+	EStatusCode status = TestSyntax();
+	if(eSuccess == status)
+		status = TestInlineImageLengths();
+
+	for(size_t i=0;i<sizeof(materials)/sizeof(const char*) && eSuccess == status;++i)
+		status = CompareWithObjectParser(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,materials[i]));
+
+	if(eSuccess == status)
+		status = RunBenchmark(inTestConfiguration);
+
+	return status;
+}
+
+struct ExpectedOperation
+{
+	EContentStreamOperator mOperator;
+	const char* mOperatorName;
+	size_t mOperandsCount;
+};
+
+EStatusCode PDFContentStreamReaderTest::TestSyntax()
+{
+	// inline images, one with binary data that contains EI, and one with a specified length
+	string inlineImageData("\x00" "EIx\x01\xFF", 6);
+	string content = string(
+		"q 1 0 0 1 72.5 -720 cm\n"
+		"/F1 12 Tf BT [(Hel\\(lo\\)) -20.5 <48656C6C6F7> (\\101\\102\r\nC)] TJ ET\n"
+		"/Name#20With#23Hash gs %comment 1 2 3 m\n"
+		"BI /W 6 /H 1 /BPC 8 /CS /G ID ") + inlineImageData + string(" EI\n"
+		"BI /W 2 /H 1 /BPC 8 /CS /G /L 2 ID EI EI\r"
+		"/P <</MCID 0 /Flag true>> BDC EMC -.5 +3 --2 null false d0 unknownop Q\n"
+		"1 2 3");
+
+	ExpectedOperation expected[] = {
+		{eContentStreamOperatorSave,"q",0},
+		{eContentStreamOperatorConcatMatrix,"cm",6},
+		{eContentStreamOperatorSetFont,"Tf",2},
+		{eContentStreamOperatorBeginText,"BT",0},
+		{eContentStreamOperatorShowTextArray,"TJ",6},
+		{eContentStreamOperatorEndText,"ET",0},
+		{eContentStreamOperatorSetGraphicsState,"gs",1},
+		{eContentStreamOperatorInlineImage,"BI",8},
+		{eContentStreamOperatorInlineImage,"BI",10},
+		{eContentStreamOperatorBeginMarkedContentWithProperties,"BDC",7},
+		{eContentStreamOperatorEndMarkedContent,"EMC",0},
+		{eContentStreamOperatorSetCharWidth,"d0",5},
+		{eContentStreamOperatorUnknown,"unknownop",0},
+		{eContentStreamOperatorRestore,"Q",0}
+	};
+	const size_t expectedCount = sizeof(expected)/sizeof(ExpectedOperation);
+
+	InputStringStream contentStream(content);
+	PDFContentStreamReader reader;
+	reader.SetReadStream(&contentStream);
+
+	for(size_t i=0;i<expectedCount;++i)
+	{
+		if(!reader.ReadNextOperation())
+		{
+			cout<<"content ended early, at operation "<<i<<"\n";
+			return eFailure;
+		}
+		if(reader.GetOperator() != expected[i].mOperator || reader.GetOperatorName() != expected[i].mOperatorName ||
+			reader.GetOperandsCount() != expected[i].mOperandsCount)
+		{
+			cout<<"operation "<<i<<" mismatch. expected "<<expected[i].mOperatorName<<" with "<<expected[i].mOperandsCount<<" operands, got "<<
+				reader.GetOperatorName().c_str()<<" with "<<reader.GetOperandsCount()<<" operands\n";
+			return eFailure;
+		}
+
+		// check operand values of some of the operations
+		bool valuesOK = true;
+		switch(i)
+		{
+			case 1:
+				valuesOK = reader.GetOperand(4).mNumber == 72.5 && !reader.GetOperand(4).mIsInteger &&
+							reader.GetOperand(5).mNumber == -720 && reader.GetOperand(5).mIsInteger;
+				break;
+			case 2:
+				valuesOK = reader.GetOperand(0).mType == eContentStreamOperandName && reader.GetOperandText(0) == "F1";
+				break;
+			case 4:
+				valuesOK = reader.GetOperand(0).mType == eContentStreamOperandArrayStart &&
+							reader.GetOperand(1).mType == eContentStreamOperandLiteralString && reader.GetOperandText(1) == "Hel(lo)" &&
+							reader.GetOperand(2).mNumber == -20.5 &&
+							reader.GetOperand(3).mType == eContentStreamOperandHexString && reader.GetOperandText(3) == "Hello\x70" &&
+							reader.GetOperandText(4) == "AB\nC" &&
+							reader.GetOperand(5).mType == eContentStreamOperandArrayEnd;
+				break;
+			case 6:
+				valuesOK = reader.GetOperandText(0) == "Name With#Hash";
+				break;
+			case 7:
+				valuesOK = reader.GetInlineImageDataLength() == inlineImageData.size() &&
+							string((const char*)reader.GetInlineImageData(),(size_t)reader.GetInlineImageDataLength()) == inlineImageData &&
+							reader.GetOperandText(6) == "CS" && reader.GetOperandText(7) == "G";
+				break;
+			case 8:
+				valuesOK = reader.GetInlineImageDataLength() == 2 && string((const char*)reader.GetInlineImageData(),2) == "EI";
+				break;
+			case 9:
+				valuesOK = reader.GetOperand(1).mType == eContentStreamOperandDictionaryStart &&
+							reader.GetOperand(5).mType == eContentStreamOperandBoolean && reader.GetOperand(5).mNumber == 1 &&
+							reader.GetOperand(6).mType == eContentStreamOperandDictionaryEnd;
+				break;
+			case 11:
+				valuesOK = reader.GetOperand(0).mNumber == -0.5 && reader.GetOperand(1).mNumber == 3 && reader.GetOperand(2).mNumber == -2 &&
+							reader.GetOperand(3).mType == eContentStreamOperandNull &&
+							reader.GetOperand(4).mType == eContentStreamOperandBoolean && reader.GetOperand(4).mNumber == 0;
+				break;
+		}
+		if(!valuesOK)
+		{
+			cout<<"operation "<<i<<" ["<<expected[i].mOperatorName<<"] operands mismatch\n";
+			return eFailure;
+		}
+	}
+
+	// trailing operands with no operator
+	if(reader.ReadNextOperation())
+	{
+		cout<<"expected content end, got "<<reader.GetOperatorName().c_str()<<"\n";
+		return eFailure;
+	}
+
+	return eSuccess;
+}
+
+EStatusCode PDFContentStreamReaderTest::TestInlineImageLengths()
+{
+	// lengths come from the content, so they may be anything. a length that's too large to be a length is ignored, and the
+	// data is read up to EI. a length that's larger than the content just reads up to its end
+	string content = string(
+		"BI /W 2 /H 1 /BPC 8 /CS /G /L 99999999999999999999999999 ID \x01\x02 EI\n"
+		"BI /W 2 /H 1 /BPC 8 /CS /G /L -2 ID \x03\x04 EI\n"
+		"BI /W 2 /H 1 /BPC 8 /CS /G /Length 4000000000000 ID \x05\x06");
+	const char* expectedData[] = {"\x01\x02","\x03\x04","\x05\x06"};
+
+	InputStringStream contentStream(content);
+	PDFContentStreamReader reader;
+	reader.SetReadStream(&contentStream);
+
+	for(size_t i=0;i<sizeof(expectedData)/sizeof(const char*);++i)
+	{
+		if(!reader.ReadNextOperation() || reader.GetOperator() != eContentStreamOperatorInlineImage)
+		{
+			cout<<"expected inline image "<<i<<"\n";
+			return eFailure;
+		}
+		if(reader.GetInlineImageDataLength() != 2 || string((const char*)reader.GetInlineImageData(),2) != expectedData[i])
+		{
+			cout<<"inline image "<<i<<" data mismatch\n";
+			return eFailure;
+		}
+	}
+
+	return eSuccess;
+}
+
+PDFObject* PDFContentStreamReaderTest::QueryPageContents(PDFParser& inParser,unsigned long inPageIndex)
+{
+	RefCountPtr<PDFDictionary> page(inParser.ParsePage(inPageIndex));
+	if(!page)
+		return NULL;
+	return inParser.QueryDictionaryObject(page.GetPtr(),"Contents");
+}
+
+static size_t CountTopLevelOperands(PDFContentStreamReader* inContentReader)
+{
+	size_t result = 0;
+	int depth = 0;
+
+	for(size_t i=0;i<inContentReader->GetOperandsCount();++i)
+	{
+		EContentStreamOperandType type = inContentReader->GetOperand(i).mType;
+		if(type == eContentStreamOperandArrayStart || type == eContentStreamOperandDictionaryStart)
+		{
+			if(depth++ == 0)
+				++result;
+		}
+		else if(type == eContentStreamOperandArrayEnd || type == eContentStreamOperandDictionaryEnd)
+			--depth;
+		else if(depth == 0)
+			++result;
+	}
+	return result;
+}
+
+EStatusCode PDFContentStreamReaderTest::CompareOperations(PDFParser& inParser,PDFObject* inContents,const string& inDescription)
+{
+	// readers of the same parser share its stream, so read first with the objects parser, and then with the content reader
+	vector<pair<string,size_t> > operations;
+	bool isArray = (inContents->GetType() == PDFObject::ePDFObjectArray);
+
+	PDFObjectParser* objectParser = isArray ? inParser.StartReadingObjectsFromStreams((PDFArray*)inContents) :
+												inParser.StartReadingObjectsFromStream((PDFStreamInput*)inContents);
+	if(!objectParser)
+	{
+		cout<<inDescription.c_str()<<", failed to start reading objects\n";
+		return eFailure;
+	}
+	size_t operandsCount = 0;
+	for(;;)
+	{
+		RefCountPtr<PDFObject> anObject(objectParser->ParseNewObject());
+		if(!anObject)
+			break;
+		if(anObject->GetType() == PDFObject::ePDFObjectSymbol)
+		{
+			operations.push_back(pair<string,size_t>(((PDFSymbol*)anObject.GetPtr())->GetValue(),operandsCount));
+			operandsCount = 0;
+		}
+		else
+			++operandsCount;
+	}
+	delete objectParser;
+
+	PDFContentStreamReader* contentReader = isArray ? inParser.StartReadingContentFromStreams((PDFArray*)inContents) :
+														inParser.StartReadingContentFromStream((PDFStreamInput*)inContents);
+	if(!contentReader)
+	{
+		cout<<inDescription.c_str()<<", failed to start reading content\n";
+		return eFailure;
+	}
+
+	EStatusCode status = eSuccess;
+	size_t i = 0;
+	for(;i<operations.size() && eSuccess == status;++i)
+	{
+		if(!contentReader->ReadNextOperation())
+		{
+			cout<<inDescription.c_str()<<", content reader ended early, at operation "<<i<<"\n";
+			status = eFailure;
+			break;
+		}
+		if(contentReader->GetOperatorName() != operations[i].first || CountTopLevelOperands(contentReader) != operations[i].second)
+		{
+			cout<<inDescription.c_str()<<", operation "<<i<<" mismatch. objects parser read "<<operations[i].first.c_str()<<" with "<<
+				operations[i].second<<" operands, content reader read "<<contentReader->GetOperatorName().c_str()<<" with "<<
+				CountTopLevelOperands(contentReader)<<" operands\n";
+			status = eFailure;
+			break;
+		}
+		// the objects parser doesn't know about inline images, stop here
+		if(contentReader->GetOperator() == eContentStreamOperatorInlineImage)
+			break;
+	}
+	if(eSuccess == status && i == operations.size() && contentReader->ReadNextOperation())
+	{
+		cout<<inDescription.c_str()<<", content reader read more operations than the objects parser\n";
+		status = eFailure;
+	}
+	delete contentReader;
+
+	return status;
+}
+
+EStatusCode PDFContentStreamReaderTest::CompareWithObjectParser(const string& inFilePath)
+{
+	EStatusCode status;
+	InputFile pdfFile;
+	PDFParser parser;
+
+	do
+	{
+		status = pdfFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		status = parser.StartPDFParsing(pdfFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		for(unsigned long i=0;i<parser.GetPagesCount() && eSuccess == status;++i)
+		{
+			RefCountPtr<PDFObject> contents(QueryPageContents(parser,i));
+			if(!contents)
+				continue;
+
+			if(contents->GetType() != PDFObject::ePDFObjectStream && contents->GetType() != PDFObject::ePDFObjectArray)
+				continue;
+
+			stringstream description;
+			description<<inFilePath<<" page "<<i;
+			status = CompareOperations(parser,contents.GetPtr(),description.str());
+		}
+	}while(false);
+
+	return status;
+}
+
+EStatusCode PDFContentStreamReaderTest::WriteContentDocument(const string& inOutputPath)
+{
+	EStatusCode status;
+	PDFWriter pdfWriter;
+
+	// pages with text and paths content, as it's typically generated
+	stringstream pageContent;
+	for(unsigned long i=0;i<scBenchmarkLinesPerPage;++i)
+	{
+		pageContent<<"q 0.5 0 0 rg 1 0 0 1 "<<(i % 7)<<" "<<(800 - i*3)<<" cm\n";
+		pageContent<<"BT /F1 10 Tf 12 TL 1 0 0 1 36 0 Tm [(Line )-12.5(number )"<<i<<"(, with some kerning) -250 (and more text)] TJ T* (next) Tj ET\n";
+		pageContent<<"0.2 w 36 -2 m 300.25 -2 l 310 -2 315 -5 320 -10 c S 36 -20 100 10 re f Q\n";
+	}
+
+	do
+	{
+		status = pdfWriter.StartPDF(inOutputPath,ePDFVersion13);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start PDF\n";
+			break;
+		}
+
+		for(unsigned long i=0;i<scBenchmarkPagesCount && eSuccess == status;++i)
+		{
+			PDFPage* page = new PDFPage();
+			page->SetMediaBox(PDFRectangle(0,0,595,842));
+			PageContentContext* contentContext = pdfWriter.StartPageContentContext(page);
+			contentContext->WriteFreeCode(pageContent.str());
+			status = pdfWriter.EndPageContentContext(contentContext);
+			if(eSuccess == status)
+				status = pdfWriter.WritePageAndRelease(page);
+			if(status != eSuccess)
+				cout<<"failed to write page "<<i<<"\n";
+		}
+		if(status != eSuccess)
+			break;
+
+		status = pdfWriter.EndPDF();
+		if(status != eSuccess)
+			cout<<"failed to end PDF\n";
+	}while(false);
+
+	return status;
+}
+
+EStatusCode PDFContentStreamReaderTest::RunBenchmark(const TestConfiguration& inTestConfiguration)
+{
+	string documentPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"PDFContentStreamReaderBenchmark.pdf");
+	EStatusCode status = WriteContentDocument(documentPath);
+	if(status != eSuccess)
+		return status;
+
+	// same results first
+	status = CompareWithObjectParser(documentPath);
+	if(status != eSuccess)
+		return status;
+
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"PDFContentStreamReaderBenchmark.txt"),true,true);
+	TimersRegistry timers;
+	InputFile pdfFile;
+	PDFParser parser;
+	unsigned long objectParserOperators = 0;
+	unsigned long contentReaderOperators = 0;
+
+	do
+	{
+		status = pdfFile.OpenFile(documentPath);
+		if(status == eSuccess)
+			status = parser.StartPDFParsing(pdfFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<documentPath.c_str()<<"\n";
+			break;
+		}
+
+		for(int j=0;j<scBenchmarkReadsCount;++j)
+		{
+			for(unsigned long i=0;i<parser.GetPagesCount();++i)
+			{
+				RefCountPtr<PDFObject> contents(QueryPageContents(parser,i));
+
+				timers.StartMeasure("ObjectsParser");
+				PDFObjectParser* objectParser = parser.StartReadingObjectsFromStream((PDFStreamInput*)contents.GetPtr());
+				for(;;)
+				{
+					RefCountPtr<PDFObject> anObject(objectParser->ParseNewObject());
+					if(!anObject)
+						break;
+					if(anObject->GetType() == PDFObject::ePDFObjectSymbol)
+						++objectParserOperators;
+				}
+				delete objectParser;
+				timers.StopMeasureAndAccumulate("ObjectsParser");
+
+				timers.StartMeasure("ContentReader");
+				PDFContentStreamReader* contentReader = parser.StartReadingContentFromStream((PDFStreamInput*)contents.GetPtr());
+				while(contentReader->ReadNextOperation())
+					++contentReaderOperators;
+				delete contentReader;
+				timers.StopMeasureAndAccumulate("ContentReader");
+			}
+		}
+
+		if(objectParserOperators != contentReaderOperators)
+		{
+			cout<<"objects parser read "<<objectParserOperators<<" operators, content reader read "<<contentReaderOperators<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		cout<<"Reading "<<contentReaderOperators<<" content operations with objects parser: "<<timers.GetTotalMiliSeconds("ObjectsParser")<<
+			"ms, with content stream reader: "<<timers.GetTotalMiliSeconds("ContentReader")<<"ms\n";
+	}while(false);
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(PDFContentStreamReaderTest,"Parsing")
@@ -0,0 +1,340 @@
+/*
+   Source File : PDFNameAtomsTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "PDFNameAtomsTest.h"
+#include "PDFNameAtoms.h"
+#include "PDFName.h"
+#include "PDFInteger.h"
+#include "PDFDictionary.h"
+#include "PDFObjectCast.h"
+#include "RefCountPtr.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace PDFHummus;
+
+static const unsigned long scConcurrentThreadsCount = 4;
+static const unsigned long scConcurrentNamesCount = 2000;
+static const unsigned long scBenchmarkLookupsCount = 1000000;
+
+PDFNameAtomsTest::PDFNameAtomsTest(void)
+{
+}
+
+PDFNameAtomsTest::~PDFNameAtomsTest(void)
+{
+}
+
+EStatusCode PDFNameAtomsTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = TestInterning();
+
+	if(eSuccess == status)
+		status = TestConcurrentInterning();
+	if(eSuccess == status)
+		status = TestReleasing();
+	if(eSuccess == status)
+		status = TestConcurrentReleasing();
+	// small dictionaries are scanned, large ones binary searched
+	if(eSuccess == status)
+		status = TestDictionary(5);
+	if(eSuccess == status)
+		status = TestDictionary(100);
+	if(eSuccess == status)
+		status = RunBenchmark(inTestConfiguration);
+
+	return status;
+}
+
+EStatusCode PDFNameAtomsTest::TestInterning()
+{
+	PDFNameAtom typeAtom = PDFNameAtoms::Intern("Type");
+	string typeValue = "Ty";
+	typeValue.append("pe");
+
+	if(PDFNameAtoms::Intern(typeValue) != typeAtom || *typeAtom != "Type" || PDFNameAtoms::Find("Type") != typeAtom)
+	{
+		cout<<"expected equal values to intern to the same atom\n";
+		return eFailure;
+	}
+
+	if(PDFNameAtoms::Intern("Subtype") == typeAtom)
+	{
+		cout<<"expected different values to intern to different atoms\n";
+		return eFailure;
+	}
+
+	if(PDFNameAtoms::Find("PDFNameAtomsTestNeverInterned") != NULL)
+	{
+		cout<<"expected a value that was never interned not to be found\n";
+		return eFailure;
+	}
+
+	// names share interned values
+	RefCountPtr<PDFName> aName(new PDFName("Type"));
+	RefCountPtr<PDFName> anotherName(new PDFName(typeValue));
+	if(aName->GetAtom() != typeAtom || anotherName->GetAtom() != typeAtom || &(aName->GetValue()) != &(anotherName->GetValue()))
+	{
+		cout<<"expected names with equal values to share the interned value\n";
+		return eFailure;
+	}
+
+	return eSuccess;
+}
+
+static void InternNames(unsigned long inThreadIndex,vector<PDFNameAtom>* outAtoms)
+{
+	// each thread goes through the names in a different order
+	outAtoms->resize(scConcurrentNamesCount);
+	for(unsigned long i=0;i<scConcurrentNamesCount;++i)
+	{
+		unsigned long nameIndex = (i + inThreadIndex * scConcurrentNamesCount / scConcurrentThreadsCount) % scConcurrentNamesCount;
+		stringstream name;
+		name<<"ConcurrentName"<<nameIndex;
+		(*outAtoms)[nameIndex] = PDFNameAtoms::Intern(name.str());
+	}
+}
+
+EStatusCode PDFNameAtomsTest::TestConcurrentInterning()
+{
+	vector<vector<PDFNameAtom> > atoms(scConcurrentThreadsCount);
+	vector<thread> threads;
+
+	for(unsigned long i=0;i<scConcurrentThreadsCount;++i)
+		threads.push_back(thread(InternNames,i,&atoms[i]));
+	for(unsigned long i=0;i<scConcurrentThreadsCount;++i)
+		threads[i].join();
+
+	for(unsigned long i=1;i<scConcurrentThreadsCount;++i)
+	{
+		if(atoms[i] != atoms[0])
+		{
+			cout<<"threads interning the same names got different atoms\n";
+			return eFailure;
+		}
+	}
+	return eSuccess;
+}
+
+EStatusCode PDFNameAtomsTest::TestReleasing()
+{
+	unsigned long atomsCount = PDFNameAtoms::GetAtomsCount();
+
+	// names values are dropped once no name holds them
+	{
+		RefCountPtr<PDFName> aName(new PDFName("PDFNameAtomsTestReleased"));
+		RefCountPtr<PDFName> anotherName(new PDFName("PDFNameAtomsTestReleased"));
+		if(PDFNameAtoms::GetAtomsCount() != atomsCount + 1 || PDFNameAtoms::Find("PDFNameAtomsTestReleased") != aName->GetAtom())
+		{
+			cout<<"expected names to add their value to the table\n";
+			return eFailure;
+		}
+		aName = NULL;
+		if(PDFNameAtoms::Find("PDFNameAtomsTestReleased") != anotherName->GetAtom())
+		{
+			cout<<"expected a value to be kept while a name holds it\n";
+			return eFailure;
+		}
+	}
+	if(PDFNameAtoms::GetAtomsCount() != atomsCount || PDFNameAtoms::Find("PDFNameAtomsTestReleased") != NULL)
+	{
+		cout<<"expected a value to be dropped once no name holds it\n";
+		return eFailure;
+	}
+
+	// interned values are kept, also once names that hold them are released
+	PDFNameAtom keptAtom = PDFNameAtoms::Intern("PDFNameAtomsTestInterned");
+	{
+		RefCountPtr<PDFName> aName(new PDFName("PDFNameAtomsTestInterned"));
+		if(aName->GetAtom() != keptAtom)
+		{
+			cout<<"expected names to share the interned value\n";
+			return eFailure;
+		}
+	}
+	if(PDFNameAtoms::Find("PDFNameAtomsTestInterned") != keptAtom)
+	{
+		cout<<"expected an interned value to be kept\n";
+		return eFailure;
+	}
+
+	return eSuccess;
+}
+
+static void CreateAndReleaseNames(unsigned long inThreadIndex)
+{
+	// all threads use the same values, so values are added and dropped while other threads hold them
+	for(unsigned long j=0;j<20;++j)
+	{
+		vector<RefCountPtr<PDFName> > names;
+		for(unsigned long i=0;i<scConcurrentNamesCount;++i)
+		{
+			stringstream name;
+			name<<"ReleasedName"<<(i + inThreadIndex) % 100;
+			names.push_back(RefCountPtr<PDFName>(new PDFName(name.str())));
+		}
+	}
+}
+
+EStatusCode PDFNameAtomsTest::TestConcurrentReleasing()
+{
+	unsigned long atomsCount = PDFNameAtoms::GetAtomsCount();
+	vector<thread> threads;
+
+	for(unsigned long i=0;i<scConcurrentThreadsCount;++i)
+		threads.push_back(thread(CreateAndReleaseNames,i));
+	for(unsigned long i=0;i<scConcurrentThreadsCount;++i)
+		threads[i].join();
+
+	if(PDFNameAtoms::GetAtomsCount() != atomsCount || PDFNameAtoms::Find("ReleasedName0") != NULL)
+	{
+		cout<<"expected all values to be dropped once threads released their names. "<<PDFNameAtoms::GetAtomsCount() - atomsCount<<" are kept\n";
+		return eFailure;
+	}
+	return eSuccess;
+}
+
+static string KeyName(unsigned long inIndex)
+{
+	stringstream name;
+	name<<"Key"<<inIndex;
+	return name.str();
+}
+
+EStatusCode PDFNameAtomsTest::TestDictionary(unsigned long inKeysCount)
+{
+	RefCountPtr<PDFDictionary> dictionary(new PDFDictionary());
+
+	// insert in reverse order, iteration should still be ordered by key
+	for(unsigned long i=inKeysCount;i>0;--i)
+	{
+		RefCountPtr<PDFName> key(new PDFName(KeyName(i-1)));
+		RefCountPtr<PDFInteger> value(new PDFInteger(i-1));
+		dictionary->Insert(key.GetPtr(),value.GetPtr());
+	}
+
+	// existing keys are kept
+	{
+		RefCountPtr<PDFName> key(new PDFName(KeyName(0)));
+		RefCountPtr<PDFInteger> value(new PDFInteger(-1));
+		dictionary->Insert(key.GetPtr(),value.GetPtr());
+	}
+
+	MapIterator<PDFNameToPDFObjectMap> it = dictionary->GetIterator();
+	string previousKey;
+	unsigned long count = 0;
+	while(it.MoveNext())
+	{
+		if(count > 0 && !(previousKey < it.GetKey()->GetValue()))
+		{
+			cout<<"dictionary of "<<inKeysCount<<" keys is not iterated in key order\n";
+			return eFailure;
+		}
+		previousKey = it.GetKey()->GetValue();
+		++count;
+	}
+	if(count != inKeysCount)
+	{
+		cout<<"expected "<<inKeysCount<<" entries in dictionary, got "<<count<<"\n";
+		return eFailure;
+	}
+
+	for(unsigned long i=0;i<inKeysCount;++i)
+	{
+		string keyName = KeyName(i);
+		PDFObjectCastPtr<PDFInteger> byName(dictionary->QueryDirectObject(keyName));
+		PDFObjectCastPtr<PDFInteger> byAtom(dictionary->QueryDirectObject(PDFNameAtoms::Intern(keyName)));
+		if(!byName || !byAtom || byName->GetValue() != (long long)i || byAtom.GetPtr() != byName.GetPtr() ||
+			!dictionary->Exists(keyName) || !dictionary->Exists(PDFNameAtoms::Intern(keyName)))
+		{
+			cout<<"failed to find key "<<keyName.c_str()<<" in dictionary of "<<inKeysCount<<" keys\n";
+			return eFailure;
+		}
+	}
+
+	if(dictionary->Exists("PDFNameAtomsTestNeverInterned") || dictionary->Exists(PDFNameAtoms::Intern("Type")) ||
+		dictionary->QueryDirectObject(KeyName(inKeysCount)) != NULL)
+	{
+		cout<<"found missing keys in dictionary of "<<inKeysCount<<" keys\n";
+		return eFailure;
+	}
+
+	return eSuccess;
+}
+
+EStatusCode PDFNameAtomsTest::RunBenchmark(const TestConfiguration& inTestConfiguration)
+{
+	// a typical stream dictionary, looked up by name and by interned key
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"PDFNameAtomsBenchmark.txt"),true,true);
+	TimersRegistry timers;
+	RefCountPtr<PDFDictionary> dictionary(new PDFDictionary());
+	const char* keys[] = {"Type","Subtype","BBox","Resources","Filter","Length","DecodeParms"};
+	for(size_t i=0;i<sizeof(keys)/sizeof(const char*);++i)
+	{
+		RefCountPtr<PDFName> key(new PDFName(keys[i]));
+		RefCountPtr<PDFInteger> value(new PDFInteger(i));
+		dictionary->Insert(key.GetPtr(),value.GetPtr());
+	}
+
+	unsigned long found = 0;
+	timers.StartMeasure("LookupByName");
+	for(unsigned long i=0;i<scBenchmarkLookupsCount;++i)
+	{
+		RefCountPtr<PDFObject> value(dictionary->QueryDirectObject("Length"));
+		if(!!value)
+			++found;
+	}
+	timers.StopMeasureAndAccumulate("LookupByName");
+
+	PDFNameAtom lengthKey = PDFNameAtoms::Intern("Length");
+	timers.StartMeasure("LookupByAtom");
+	for(unsigned long i=0;i<scBenchmarkLookupsCount;++i)
+	{
+		RefCountPtr<PDFObject> value(dictionary->QueryDirectObject(lengthKey));
+		if(!!value)
+			++found;
+	}
+	timers.StopMeasureAndAccumulate("LookupByAtom");
+
+	EStatusCode status = eSuccess;
+	if(found != scBenchmarkLookupsCount * 2)
+	{
+		cout<<"benchmark lookups failed\n";
+		status = eFailure;
+	}
+	else
+	{
+		cout<<scBenchmarkLookupsCount<<" dictionary lookups by name: "<<timers.GetTotalMiliSeconds("LookupByName")<<"ms, by interned key: "<<
+			timers.GetTotalMiliSeconds("LookupByAtom")<<"ms\n";
+	}
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(PDFNameAtomsTest,"Parsing")
@@ -27,6 +27,7 @@ limitations under the License.
 #include "PDFObject.h"
 #include "PDFLiteralString.h"
 #include "PDFHexString.h"
+#include "PDFInteger.h"
 #include "ParsedPrimitiveHelper.h"
 #include "PDFTextString.h"
 
@@ -182,6 +183,10 @@ EStatusCode PDFObjectParserTest::Run(const TestConfiguration& inTestConfiguratio
 		++failures;
 	}
 
+	if (ParseIntegerTokens(pObjectParser,&log) == eFailure){
+		++failures;
+	}
+
 
 
 	if (failures > 0){
@@ -379,3 +384,35 @@ EStatusCode PDFObjectParserTest::ParseLiteralStringTokens(PDFObjectParser* objec
 
 ADD_CATEGORIZED_TEST(PDFObjectParserTest, "Parsing")
 
+EStatusCode PDFObjectParserTest::ParseIntegerTokens(PDFObjectParser* objectParser, PDFObjectParserTestLogHelper* log){
+	int failures = 0;
+	InputInterfaceToStream input;
+
+	// integers up to 18 digits are parsed directly, longer ones fall back to stream parsing, which saturates on overflow
+	const char* integers[][2] = {
+		{"0","0"},
+		{"+17","17"},
+		{"-17","-17"},
+		{"123456789012345678","123456789012345678"},
+		{"-123456789012345678","-123456789012345678"},
+		{"9223372036854775807","9223372036854775807"},
+		{"12345678901234567890","9223372036854775807"},
+		{"-98765432109876543210","-9223372036854775808"},
+		{NULL,NULL}
+	};
+
+	for(int i=0; integers[i][0]; ++i)
+	{
+		input.setInput(integers[i][0]);
+		objectParser->SetReadStream(&input, &input);
+		ExpectedResult<PDFInteger> result(objectParser->ParseNewObject());
+
+		failures += result.setResult(input.getInput(), integers[i][1], *log);
+	}
+
+	if (failures > 0){
+		cout << "Failed tests in PDFObjectParserTest::ParseIntegerTokens: " << failures << endl;
+		return eFailure;
+	}
+	return eSuccess;
+}
@@ -38,6 +38,7 @@ private:
 	PDFHummus::EStatusCode ParseCommentedTokens(PDFObjectParser* objectParser, PDFObjectParserTestLogHelper* log);
 	PDFHummus::EStatusCode ParseHexStringTokens(PDFObjectParser* objectParser, PDFObjectParserTestLogHelper* log);
 	PDFHummus::EStatusCode ParseLiteralStringTokens(PDFObjectParser* objectParser, PDFObjectParserTestLogHelper* log);
+	PDFHummus::EStatusCode ParseIntegerTokens(PDFObjectParser* objectParser, PDFObjectParserTestLogHelper* log);
 	
 	
 	
@@ -0,0 +1,140 @@
+/*
+   Source File : PDFParserTokenizerTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "PDFParserTokenizerTest.h"
+#include "PDFParserTokenizer.h"
+#include "InputByteArrayStream.h"
+#include "InputBufferedStream.h"
+#include "InputFile.h"
+
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace PDFHummus;
+
+PDFParserTokenizerTest::PDFParserTokenizerTest(void)
+{
+}
+
+PDFParserTokenizerTest::~PDFParserTokenizerTest(void)
+{
+}
+
+static const char* scSamples[] = {
+	"1 0 obj\r\n<</Type /Page/Kids[3 0 R 4 0 R]/Count 2>>\r\nendobj",
+	"% a comment\n/Name1/Name2 (literal) <abcd> 12.5 -3 +4 .5",
+	"(nested (parantheses) and \\) escaped \\( ones) (line \\\ncontinued) (cr \\\r\nlf) (lone cr \\\rx)",
+	"<4E 6F\r\n76 65>< 20> <> <<>> >> > ] [ { } <</A<</B[1 2]>>>>",
+	"<</Length 5>>stream\r\nabcde\nendstream",
+	"<</Length 5>>stream\nabcde\nendstream",
+	"<</Length 5>>stream \r\nabcde\nendstream",
+	"<</Length 5>>stream\rabcde\nendstream",
+	"trailing token",
+	"trailing comment % at end",
+	"   \r\n\t  ",
+	"(unbalanced ( string",
+	"12345678901234567890 -98765432109876543210 1 0 R",
+	NULL
+};
+
+static const char* scSampleFiles[] = {
+	"TestMaterials/XObjectContent.pdf",
+	"TestMaterials/Linearized.pdf",
+	NULL
+};
+
+EStatusCode PDFParserTokenizerTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+
+	for(int i=0; scSamples[i] && eSuccess == status; ++i)
+		status = CompareTokenizing(scSamples[i],scSamples[i]);
+
+	for(int i=0; scSampleFiles[i] && eSuccess == status; ++i)
+	{
+		InputFile pdfFile;
+		if(pdfFile.OpenFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,scSampleFiles[i])) != eSuccess)
+		{
+			cout<<"Failed to open "<<scSampleFiles[i]<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		string content;
+		IOBasicTypes::Byte buffer[4096];
+		while(pdfFile.GetInputStream()->NotEnded())
+			content.append((const char*)buffer,pdfFile.GetInputStream()->Read(buffer,4096));
+
+		status = CompareTokenizing(content,scSampleFiles[i]);
+	}
+
+	return status;
+}
+
+EStatusCode PDFParserTokenizerTest::CompareTokenizing(const string& inContent,const string& inLabel)
+{
+	// byte by byte reading serves as reference. then direct scanning of an in memory stream,
+	// and of a buffered stream with a tiny buffer, so tokens keep crossing the buffer ends
+	InputByteArrayStream referenceStream((IOBasicTypes::Byte*)inContent.data(),inContent.size());
+	string expected = Tokenize(&referenceStream,false);
+
+	InputByteArrayStream spanStream((IOBasicTypes::Byte*)inContent.data(),inContent.size());
+	string result = Tokenize(&spanStream,true);
+	if(result != expected)
+	{
+		cout<<"Tokenizing directly from memory differs from regular tokenizing for: "<<inLabel.substr(0,100)<<"\nexpected:\n"<<expected.substr(0,1000)<<"\ngot:\n"<<result.substr(0,1000)<<"\n";
+		return eFailure;
+	}
+
+	InputBufferedStream bufferedStream(new InputByteArrayStream((IOBasicTypes::Byte*)inContent.data(),inContent.size()),7);
+	result = Tokenize(&bufferedStream,true);
+	if(result != expected)
+	{
+		cout<<"Tokenizing directly from buffer differs from regular tokenizing for: "<<inLabel.substr(0,100)<<"\nexpected:\n"<<expected.substr(0,1000)<<"\ngot:\n"<<result.substr(0,1000)<<"\n";
+		return eFailure;
+	}
+
+	return eSuccess;
+}
+
+string PDFParserTokenizerTest::Tokenize(IByteReaderWithPosition* inStream,bool inUseSpan)
+{
+	PDFParserTokenizer tokenizer;
+	stringstream tokens;
+
+	if(inUseSpan)
+		tokenizer.SetReadStream(inStream);
+	else
+		tokenizer.SetReadStream((IByteReader*)inStream);
+
+	// record tokens, their positions, and the position right after each [accounting for a byte kept by the tokenizer], 
+	// which is what stream reading relies on
+	BoolAndString token = tokenizer.GetNextToken();
+	while(token.first)
+	{
+		tokens<<"["<<token.second<<"] at "<<tokenizer.GetRecentTokenPosition()<<" till "<<(inStream->GetCurrentPosition() - tokenizer.GetReadBufferSize())<<"\n";
+		token = tokenizer.GetNextToken();
+	}
+
+	return tokens.str();
+}
+
+ADD_CATEGORIZED_TEST(PDFParserTokenizerTest,"Parsing")
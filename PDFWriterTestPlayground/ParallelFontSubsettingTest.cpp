@@ -0,0 +1,231 @@
+/*
+   Source File : ParallelFontSubsettingTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ParallelFontSubsettingTest.h"
+#include "TestFiles.h"
+#include "PDFWriter.h"
+#include "PDFPage.h"
+#include "PDFRectangle.h"
+#include "PageContentContext.h"
+#include "UnicodeString.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace PDFHummus;
+
+static const int scBenchmarkDocumentsCount = 5;
+
+ParallelFontSubsettingTest::ParallelFontSubsettingTest(void)
+{
+}
+
+ParallelFontSubsettingTest::~ParallelFontSubsettingTest(void)
+{
+}
+
+EStatusCode ParallelFontSubsettingTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = TestSameOutput(inTestConfiguration,true);
+
+	if(eSuccess == status)
+		status = TestSameOutput(inTestConfiguration,false);
+
+	if(eSuccess == status)
+		status = RunBenchmark(inTestConfiguration);
+
+	return status;
+}
+
+struct FontAndText
+{
+	const char* mFontPath;
+	const char* mMetricsPath;
+	const char* mText;
+};
+
+// true type, CFF and type 1 fonts. arial is used for both simple and CID fonts, and KozGo for a CFF CID font
+static const FontAndText scFonts[] = {
+	{"TestMaterials/fonts/arial.ttf",NULL,"Hello World"},
+	{"TestMaterials/fonts/arial.ttf",NULL,"\xD7\xA9\xD7\x9C\xD7\x95\xD7\x9D \xCE\xB1\xCE\xB2\xCE\xB3"},
+	{"TestMaterials/fonts/couri.ttf",NULL,"Hello World"},
+	{"TestMaterials/fonts/BrushScriptStd.otf",NULL,"Hello World"},
+	{"TestMaterials/fonts/HLB_____.PFB","TestMaterials/fonts/HLB_____.PFM","Hello World"},
+	{"TestMaterials/fonts/KozGoPro-Regular.otf",NULL,"\xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF\xE4\xB8\x96\xE7\x95\x8C"},
+	{"TestMaterials/fonts/texgyrepagella-math.otf",NULL,"Hello World"}
+};
+
+static PDFUsedFont* GetFont(PDFWriter& inPDFWriter,const TestConfiguration& inTestConfiguration,const FontAndText& inFont)
+{
+	if(inFont.mMetricsPath)
+		return inPDFWriter.GetFontForFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,inFont.mFontPath),
+											RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,inFont.mMetricsPath));
+	else
+		return inPDFWriter.GetFontForFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,inFont.mFontPath));
+}
+
+// a page with a line per font, showing inText or the font sample text if not provided. type 1 fonts always
+// show their sample text, as they can't be written as CID fonts
+static EStatusCode WriteDocument(	const TestConfiguration& inTestConfiguration,
+									const string& inOutputFilePath,
+									bool inEmbedFonts,
+									bool inParallelFontSubsetting,
+									unsigned int inThreadsCount,
+									const string& inText,
+									TimersRegistry* inTimers)
+{
+	PDFWriter pdfWriter;
+	PDFCreationSettings creationSettings(true,inEmbedFonts);
+	creationSettings.ParallelFontSubsetting = inParallelFontSubsetting;
+	creationSettings.FontSubsettingThreads = inThreadsCount;
+
+	EStatusCode status = pdfWriter.StartPDF(inOutputFilePath,ePDFVersion13,LogConfiguration::DefaultLogConfiguration(),creationSettings);
+	if(status != eSuccess)
+	{
+		cout<<"failed to start PDF "<<inOutputFilePath<<"\n";
+		return status;
+	}
+
+	PDFPage* page = new PDFPage();
+	page->SetMediaBox(PDFRectangle(0,0,595,842));
+
+	do
+	{
+		PageContentContext* contentContext = pdfWriter.StartPageContentContext(page);
+
+		contentContext->BT();
+		for(size_t i=0;i<sizeof(scFonts)/sizeof(FontAndText) && eSuccess == status;++i)
+		{
+			PDFUsedFont* font = GetFont(pdfWriter,inTestConfiguration,scFonts[i]);
+			if(!font)
+			{
+				cout<<"failed to create font for "<<scFonts[i].mFontPath<<"\n";
+				status = eFailure;
+				break;
+			}
+			contentContext->Tf(font,12);
+			contentContext->Tm(1,0,0,1,20,800 - 30*(double)i);
+			status = contentContext->Tj(inText.size() > 0 && !scFonts[i].mMetricsPath ? inText : string(scFonts[i].mText));
+			if(status != eSuccess)
+				cout<<"failed to write text with "<<scFonts[i].mFontPath<<"\n";
+		}
+		contentContext->ET();
+		if(status != eSuccess)
+			break;
+
+		status = pdfWriter.EndPageContentContext(contentContext);
+		if(status != eSuccess)
+			break;
+
+		status = pdfWriter.WritePageAndRelease(page);
+		page = NULL;
+		if(status != eSuccess)
+			break;
+
+		// ending the document writes the fonts
+		if(inTimers)
+			inTimers->StartMeasure(inParallelFontSubsetting ? "Parallel" : "Serial");
+		status = pdfWriter.EndPDF();
+		if(inTimers)
+			inTimers->StopMeasureAndAccumulate(inParallelFontSubsetting ? "Parallel" : "Serial");
+	}while(false);
+
+	delete page;
+	if(status != eSuccess)
+		cout<<"failed to write "<<inOutputFilePath<<"\n";
+	return status;
+}
+
+EStatusCode ParallelFontSubsettingTest::TestSameOutput(const TestConfiguration& inTestConfiguration,bool inEmbedFonts)
+{
+	string prefix = inEmbedFonts ? "ParallelFontSubsetting" : "ParallelFontSubsettingNotEmbedded";
+	string serialPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,prefix + "Serial.pdf");
+	string parallelPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,prefix + "Parallel.pdf");
+	string singleThreadPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,prefix + "SingleThread.pdf");
+
+	EStatusCode status = WriteDocument(inTestConfiguration,serialPath,inEmbedFonts,false,0,"",NULL);
+	if(eSuccess == status)
+		status = WriteDocument(inTestConfiguration,parallelPath,inEmbedFonts,true,4,"",NULL);
+	if(eSuccess == status)
+		status = WriteDocument(inTestConfiguration,singleThreadPath,inEmbedFonts,true,1,"",NULL);
+	if(status != eSuccess)
+		return status;
+
+	string serial = ReadFileWithoutID(serialPath);
+	if(ReadFileWithoutID(parallelPath) != serial || ReadFileWithoutID(singleThreadPath) != serial)
+	{
+		cout<<prefix<<": document written with parallel font subsetting is different than the one written serially\n";
+		status = eFailure;
+	}
+	return status;
+}
+
+EStatusCode ParallelFontSubsettingTest::RunBenchmark(const TestConfiguration& inTestConfiguration)
+{
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParallelFontSubsettingBenchmark.txt"),true,true);
+	TimersRegistry timers;
+	EStatusCode status = eSuccess;
+
+	// many glyphs for each font, latin, greek, cyrillic, hebrew and kana, so each font gets a simple and a CID font with a large subset
+	ULongList characters;
+	for(unsigned long c=0x21;c<0x7F;++c)
+		characters.push_back(c);
+	for(unsigned long c=0xA1;c<0x180;++c)
+		characters.push_back(c);
+	for(unsigned long c=0x391;c<0x530;++c)
+		characters.push_back(c);
+	for(unsigned long c=0x5D0;c<0x5EB;++c)
+		characters.push_back(c);
+	for(unsigned long c=0x3041;c<0x3100;++c)
+		characters.push_back(c);
+	UnicodeString unicode;
+	unicode.GetUnicodeList() = characters;
+	string text = unicode.ToUTF8().second;
+
+	for(int i=0;i<scBenchmarkDocumentsCount && eSuccess == status;++i)
+	{
+		status = WriteDocument(inTestConfiguration,RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParallelFontSubsettingBenchmarkSerial.pdf"),
+								true,false,0,text,&timers);
+		if(eSuccess == status)
+			status = WriteDocument(inTestConfiguration,RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParallelFontSubsettingBenchmarkParallel.pdf"),
+								true,true,0,text,&timers);
+	}
+
+	if(eSuccess == status &&
+		ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParallelFontSubsettingBenchmarkSerial.pdf")) != 
+		ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParallelFontSubsettingBenchmarkParallel.pdf")))
+	{
+		cout<<"benchmark document written with parallel font subsetting is different than the one written serially\n";
+		status = eFailure;
+	}
+
+	if(eSuccess == status)
+		cout<<"Ending "<<scBenchmarkDocumentsCount<<" documents with "<<sizeof(scFonts)/sizeof(FontAndText)<<" fonts. serial subsetting: "<<timers.GetTotalMiliSeconds("Serial")<<
+			"ms, parallel subsetting: "<<timers.GetTotalMiliSeconds("Parallel")<<"ms\n";
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(ParallelFontSubsettingTest,"Text")
@@ -0,0 +1,394 @@
+/*
+   Source File : ParseIndexCacheTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ParseIndexCacheTest.h"
+#include "TestFiles.h"
+#include "ParseIndexCache.h"
+#include "PDFWriter.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFObject.h"
+#include "PDFDictionary.h"
+#include "PDFIndirectObjectReference.h"
+#include "PDFObjectCast.h"
+#include "RefCountPtr.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+
+using namespace std;
+using namespace PDFHummus;
+
+ParseIndexCacheTest::ParseIndexCacheTest(void)
+{
+}
+
+ParseIndexCacheTest::~ParseIndexCacheTest(void)
+{
+}
+
+EStatusCode ParseIndexCacheTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+	ParseIndexCache cache;
+
+	const char* materials[] = {
+		"TestMaterials/Original.pdf",
+		"TestMaterials/AddedPage.pdf",
+		"TestMaterials/ObjectStreams.pdf",
+		"TestMaterials/XObjectContent.pdf",
+		"TestMaterials/Linearized.pdf"
+	};
+	const size_t materialsCount = sizeof(materials)/sizeof(const char*);
+
+	do
+	{
+		// first parse stores the index, second one uses it. third one uses also object streams headers read by the second
+		for(size_t i=0;i<materialsCount && eSuccess == status;++i)
+		{
+			string materialPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,materials[i]);
+			status = CompareWithUncached(materialPath,&cache,false);
+			if(eSuccess == status)
+				status = CompareWithUncached(materialPath,&cache,true);
+			if(eSuccess == status)
+				status = CompareWithUncached(materialPath,&cache,true);
+		}
+		if(status != eSuccess)
+			break;
+
+		if(cache.GetEntriesCount() != materialsCount)
+		{
+			cout<<"expected "<<materialsCount<<" cached indexes, got "<<cache.GetEntriesCount()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		// persist the cache and load it back
+		string cacheFilePath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseIndexCache.idx");
+		status = cache.SaveToFile(cacheFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to save parse index cache\n";
+			break;
+		}
+
+		ParseIndexCache loadedCache;
+		status = loadedCache.LoadFromFile(cacheFilePath);
+		if(status != eSuccess || loadedCache.GetEntriesCount() != materialsCount)
+		{
+			cout<<"failed to load parse index cache\n";
+			status = eFailure;
+			break;
+		}
+		for(size_t i=0;i<materialsCount && eSuccess == status;++i)
+			status = CompareWithUncached(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,materials[i]),&loadedCache,true);
+		if(status != eSuccess)
+			break;
+
+		// truncated and corrupt cache files should fail to load, and not load anything
+		{
+			string content;
+			ReadFile(cacheFilePath,content);
+			string badFilePath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseIndexCacheBad.idx");
+			const size_t magicSize = string("PDFHummusParseIndex2").size();
+
+			for(int i=0;i<3 && eSuccess == status;++i)
+			{
+				string badContent = content;
+				if(0 == i)
+				{
+					// truncated
+					badContent.resize(content.size()/2);
+				}
+				else
+				{
+					// huge first key length, or huge xref size for the first index (following the key length and key, and 5 numbers)
+					size_t numberPosition = magicSize + 8;
+					if(2 == i)
+					{
+						size_t keyLength = 0;
+						for(int j=7;j>=0;--j)
+							keyLength = (keyLength << 8) | (unsigned char)content[numberPosition + j];
+						numberPosition += 8 + keyLength + 3*8;
+						size_t idLength = 0;
+						for(int j=7;j>=0;--j)
+							idLength = (idLength << 8) | (unsigned char)content[numberPosition + j];
+						numberPosition += 8 + idLength;
+					}
+					for(int j=0;j<8;++j)
+						badContent[numberPosition + j] = (char)0xff;
+				}
+				{
+					ofstream badFile(badFilePath.c_str(),ios::binary);
+					badFile<<badContent;
+				}
+
+				ParseIndexCache badCache;
+				if(badCache.LoadFromFile(badFilePath) != eFailure || badCache.GetEntriesCount() != 0)
+				{
+					cout<<"expected loading bad parse index cache file "<<i<<" to fail\n";
+					status = eFailure;
+				}
+			}
+		}
+		if(status != eSuccess)
+			break;
+
+		// a modified file should not use the index of the original
+		string modifiedPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseIndexCacheModified.pdf");
+		{
+			ifstream original(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,materials[0]).c_str(),ios::binary);
+			ofstream modified(modifiedPath.c_str(),ios::binary);
+			modified<<original.rdbuf();
+			modified<<"% appended\n";
+		}
+		status = CompareWithUncached(modifiedPath,&loadedCache,false);
+		if(status != eSuccess)
+			break;
+
+		// the trailer of a file with an xref stream may be out of the last bytes. a file that's different only in its
+		// ID there has the same size and last bytes, and should still not use the index of the original
+		{
+			ParseIndexCache idCache;
+			string idOriginalPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"TestMaterials/2.unfamiliar.entry.type.pdf");
+			string idModifiedPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseIndexCacheModifiedID.pdf");
+			{
+				string content;
+				ReadFile(idOriginalPath,content);
+				string::size_type idPosition = content.rfind("/ID[<");
+				if(idPosition != string::npos)
+					content[idPosition + 5] = (content[idPosition + 5] == '0' ? '1' : '0');
+				ofstream modified(idModifiedPath.c_str(),ios::binary);
+				modified<<content;
+			}
+			status = CompareWithUncached(idOriginalPath,&idCache,false);
+			if(status == eSuccess)
+				status = CompareWithUncached(idModifiedPath,&idCache,false);
+			if(status == eSuccess)
+				status = CompareWithUncached(idOriginalPath,&idCache,false);
+		}
+		if(status != eSuccess)
+			break;
+
+		// through the writer, indexes are used when embedding pages
+		PDFWriter pdfWriter;
+		status = pdfWriter.StartPDF(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseIndexCacheAppend.pdf"),ePDFVersion13);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start PDF\n";
+			break;
+		}
+		PDFParsingOptions options;
+		options.SharedParseIndexCache = &loadedCache;
+		unsigned long hitsBefore = loadedCache.GetHitsCount();
+		for(int i=0;i<2 && eSuccess == status;++i)
+		{
+			EStatusCodeAndObjectIDTypeList result = pdfWriter.AppendPDFPagesFromPDF(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,materials[2]),
+																				 PDFPageRange(),
+																				 ObjectIDTypeList(),
+																				 options);
+			status = result.first;
+		}
+		if(status != eSuccess)
+		{
+			cout<<"failed to append pages using parse index cache\n";
+			break;
+		}
+		status = pdfWriter.EndPDF();
+		if(status != eSuccess)
+		{
+			cout<<"failed to end PDF\n";
+			break;
+		}
+		if(loadedCache.GetHitsCount() != hitsBefore + 2)
+		{
+			cout<<"expected appending pages to use the parse index cache\n";
+			status = eFailure;
+			break;
+		}
+
+		status = RunBenchmark(inTestConfiguration);
+	}while(false);
+
+	return status;
+}
+
+EStatusCode ParseIndexCacheTest::CompareWithUncached(const string& inFilePath,ParseIndexCache* inCache,bool inExpectHit)
+{
+	EStatusCode status;
+	InputFile plainFile,cachedFile;
+	PDFParser plainParser,cachedParser;
+	PDFParsingOptions cachedOptions;
+	cachedOptions.SharedParseIndexCache = inCache;
+	unsigned long hitsBefore = inCache->GetHitsCount();
+
+	do
+	{
+		status = plainFile.OpenFile(inFilePath);
+		if(status == eSuccess)
+			status = cachedFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		status = plainParser.StartPDFParsing(plainFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		status = cachedParser.StartPDFParsing(cachedFile.GetInputStream(),cachedOptions);
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<" with parse index cache\n";
+			break;
+		}
+
+		if((inCache->GetHitsCount() > hitsBefore) != inExpectHit)
+		{
+			cout<<"expected parse index cache "<<(inExpectHit ? "hit":"miss")<<" for "<<inFilePath.c_str()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		PDFObjectCastPtr<PDFIndirectObjectReference> plainRoot(plainParser.GetTrailer()->QueryDirectObject("Root"));
+		PDFObjectCastPtr<PDFIndirectObjectReference> cachedRoot(cachedParser.GetTrailer()->QueryDirectObject("Root"));
+		if(plainParser.GetXrefPosition() != cachedParser.GetXrefPosition() ||
+			!plainRoot || !cachedRoot || plainRoot->mObjectID != cachedRoot->mObjectID)
+		{
+			cout<<"trailer mismatch for "<<inFilePath.c_str()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		if(plainParser.GetXrefSize() != cachedParser.GetXrefSize())
+		{
+			cout<<"xref size mismatch for "<<inFilePath.c_str()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		for(ObjectIDType i=0;i<plainParser.GetXrefSize() && eSuccess == status;++i)
+		{
+			XrefEntryInput plainEntry = plainParser.GetXrefEntry(i);
+			XrefEntryInput cachedEntry = cachedParser.GetXrefEntry(i);
+			if(plainEntry.mType != cachedEntry.mType || plainEntry.mObjectPosition != cachedEntry.mObjectPosition || plainEntry.mRivision != cachedEntry.mRivision)
+			{
+				cout<<"xref entry "<<i<<" mismatch for "<<inFilePath.c_str()<<"\n";
+				status = eFailure;
+				break;
+			}
+
+			// objects should parse the same, including those in object streams [where headers may come from the index]
+			if(plainEntry.mType == eXrefEntryDelete)
+				continue;
+			RefCountPtr<PDFObject> plainObject(plainParser.ParseNewObject(i));
+			RefCountPtr<PDFObject> cachedObject(cachedParser.ParseNewObject(i));
+			if(!plainObject != !cachedObject || (!!plainObject && plainObject->GetType() != cachedObject->GetType()))
+			{
+				cout<<"object "<<i<<" mismatch for "<<inFilePath.c_str()<<"\n";
+				status = eFailure;
+			}
+		}
+		if(status != eSuccess)
+			break;
+
+		if(plainParser.GetPagesCount() != cachedParser.GetPagesCount())
+		{
+			cout<<"pages count mismatch for "<<inFilePath.c_str()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		for(unsigned long i=0;i<plainParser.GetPagesCount() && eSuccess == status;++i)
+		{
+			if(plainParser.GetPageObjectID(i) != cachedParser.GetPageObjectID(i))
+			{
+				cout<<"page "<<i<<" mismatch for "<<inFilePath.c_str()<<"\n";
+				status = eFailure;
+			}
+		}
+	}while(false);
+
+	return status;
+}
+
+static const unsigned long scManyPagesCount = 20000;
+static const int scOpensCount = 5;
+
+EStatusCode ParseIndexCacheTest::RunBenchmark(const TestConfiguration& inTestConfiguration)
+{
+	// the common case of opening the same document again and again to get to its first page
+	string manyPagesPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseIndexCacheManyPages.pdf");
+	EStatusCode status = WriteManyPagesDocument(manyPagesPath,scManyPagesCount,false);
+	if(status != eSuccess)
+		return status;
+
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseIndexCacheBenchmark.txt"),true,true);
+	TimersRegistry timers;
+	ParseIndexCache cache;
+
+	for(int i=0;i<2 && eSuccess == status;++i)
+	{
+		bool cached = (i == 1);
+		string timerName = cached ? "WithParseIndexCache" : "WithoutParseIndexCache";
+		PDFParsingOptions options;
+		if(cached)
+			options.SharedParseIndexCache = &cache;
+
+		for(int j=0;j<scOpensCount && eSuccess == status;++j)
+		{
+			InputFile pdfFile;
+			PDFParser parser;
+			status = pdfFile.OpenFile(manyPagesPath);
+			if(status != eSuccess)
+			{
+				cout<<"failed to open "<<manyPagesPath.c_str()<<"\n";
+				break;
+			}
+
+			timers.StartMeasure(timerName);
+			status = parser.StartPDFParsing(pdfFile.GetInputStream(),options);
+			RefCountPtr<PDFDictionary> firstPage(parser.ParsePage(0));
+			timers.StopMeasureAndAccumulate(timerName);
+			if(status != eSuccess || !firstPage)
+			{
+				cout<<"failed to parse first page of "<<manyPagesPath.c_str()<<"\n";
+				status = eFailure;
+			}
+		}
+		if(status != eSuccess)
+			break;
+		cout<<"Opening a "<<scManyPagesCount<<" pages document "<<scOpensCount<<" times and parsing its first page, "<<(cached ? "with" : "without")<<" parse index cache: "<<timers.GetTotalMiliSeconds(timerName)<<"ms\n";
+	}
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(ParseIndexCacheTest,"Parsing")
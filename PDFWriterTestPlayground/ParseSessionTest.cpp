@@ -0,0 +1,380 @@
+/*
+   Source File : ParseSessionTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ParseSessionTest.h"
+#include "ParseSession.h"
+#include "PDFWriter.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFObject.h"
+#include "PDFBoolean.h"
+#include "PDFLiteralString.h"
+#include "PDFHexString.h"
+#include "PDFName.h"
+#include "PDFInteger.h"
+#include "PDFReal.h"
+#include "PDFSymbol.h"
+#include "PDFArray.h"
+#include "PDFDictionary.h"
+#include "PDFIndirectObjectReference.h"
+#include "PDFStreamInput.h"
+#include "RefCountPtr.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace PDFHummus;
+
+static const char* scMaterials[] =
+{
+	"TestMaterials/XObjectContent.pdf",
+	"TestMaterials/ObjectStreams.pdf",
+	"TestMaterials/china.pdf"
+};
+static const size_t scMaterialsCount = sizeof(scMaterials)/sizeof(const char*);
+
+static const int scBenchmarkCopiesCount = 10;
+
+ParseSessionTest::ParseSessionTest(void)
+{
+}
+
+ParseSessionTest::~ParseSessionTest(void)
+{
+}
+
+EStatusCode ParseSessionTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+
+	for(size_t i=0;i<scMaterialsCount && eSuccess == status;++i)
+	{
+		string materialPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,scMaterials[i]);
+		status = TestSessionObjects(materialPath);
+		if(eSuccess == status)
+			status = TestPagesCopying(inTestConfiguration,materialPath);
+	}
+
+	if(eSuccess == status)
+		status = RunBenchmark(inTestConfiguration,RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"TestMaterials/china.pdf"));
+
+	return status;
+}
+
+EStatusCode ParseSessionTest::TestSessionObjects(const string& inFilePath)
+{
+	EStatusCode status;
+	InputFile pdfFile;
+	PDFParser parser;
+	RefCountPtr<PDFObject> keptObject;
+	RefCountPtr<PDFObject> promotedObject;
+	ObjectIDType keptObjectID = 0;
+
+	do
+	{
+		status = pdfFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		status = parser.StartPDFParsing(pdfFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		{
+			ParseSession session;
+
+			for(ObjectIDType i=0;i<parser.GetXrefSize();++i)
+			{
+				if(parser.GetXrefEntry(i).mType == eXrefEntryDelete)
+					continue;
+				RefCountPtr<PDFObject> anObject(parser.ParseNewObject(i));
+				// keep the first dictionary, and a promoted copy of it
+				if(!keptObject && !!anObject && anObject->GetType() == PDFObject::ePDFObjectDictionary)
+				{
+					keptObject = anObject;
+					keptObjectID = i;
+					promotedObject = ParseSession::Promote(anObject.GetPtr());
+				}
+			}
+
+			if(session.GetAllocatedObjectsCount() == 0 || session.GetAllocatedBlocksCount() == 0 ||
+				session.GetAllocatedBlocksCount() >= session.GetAllocatedObjectsCount())
+			{
+				cout<<"expected parsed objects to be allocated from the session arena for "<<inFilePath.c_str()<<", got "<<
+					session.GetAllocatedObjectsCount()<<" objects in "<<session.GetAllocatedBlocksCount()<<" blocks\n";
+				status = eFailure;
+				break;
+			}
+		}
+
+		if(!keptObject || !promotedObject)
+		{
+			cout<<"no dictionary found in "<<inFilePath.c_str()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		// the kept object outlived its session, and should still be usable. the promoted copy should be identical to it,
+		// and to the same object parsed outside of a session
+		RefCountPtr<PDFObject> heapObject(parser.ParseNewObject(keptObjectID));
+		if(!SameObjects(keptObject.GetPtr(),promotedObject.GetPtr()) || !SameObjects(heapObject.GetPtr(),promotedObject.GetPtr()))
+		{
+			cout<<"promoted object "<<keptObjectID<<" differs from the original in "<<inFilePath.c_str()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		// inactive session should not allocate
+		{
+			ParseSession session(false);
+			RefCountPtr<PDFObject> anObject(parser.ParseNewObject(keptObjectID));
+			if(session.IsActive() || session.GetAllocatedObjectsCount() != 0)
+			{
+				cout<<"inactive session allocated objects\n";
+				status = eFailure;
+				break;
+			}
+		}
+
+		// objects kept in the parsed objects cache should not come from a session
+		parser.GetParsedObjectsCache().SetBudget(16*1024*1024);
+		{
+			ParseSession session;
+			for(ObjectIDType i=0;i<parser.GetXrefSize();++i)
+			{
+				if(parser.GetXrefEntry(i).mType == eXrefEntryDelete)
+					continue;
+				RefCountPtr<PDFObject> anObject(parser.ParseNewObject(i));
+			}
+			if(session.GetAllocatedObjectsCount() != 0 || parser.GetParsedObjectsCache().GetCachedObjectsCount() == 0)
+			{
+				cout<<"expected cached objects to be allocated out of the session for "<<inFilePath.c_str()<<", got "<<
+					session.GetAllocatedObjectsCount()<<" session objects and "<<parser.GetParsedObjectsCache().GetCachedObjectsCount()<<" cached objects\n";
+				status = eFailure;
+				break;
+			}
+		}
+		parser.GetParsedObjectsCache().SetBudget(0);
+	}while(false);
+
+	return status;
+}
+
+bool ParseSessionTest::SameObjects(PDFObject* inLeft,PDFObject* inRight)
+{
+	if(!inLeft || !inRight)
+		return !inLeft && !inRight;
+	if(inLeft->GetType() != inRight->GetType())
+		return false;
+
+	switch(inLeft->GetType())
+	{
+		case PDFObject::ePDFObjectBoolean:
+			return ((PDFBoolean*)inLeft)->GetValue() == ((PDFBoolean*)inRight)->GetValue();
+		case PDFObject::ePDFObjectLiteralString:
+			return ((PDFLiteralString*)inLeft)->GetValue() == ((PDFLiteralString*)inRight)->GetValue();
+		case PDFObject::ePDFObjectHexString:
+			return ((PDFHexString*)inLeft)->GetValue() == ((PDFHexString*)inRight)->GetValue();
+		case PDFObject::ePDFObjectNull:
+			return true;
+		case PDFObject::ePDFObjectName:
+			return ((PDFName*)inLeft)->GetValue() == ((PDFName*)inRight)->GetValue();
+		case PDFObject::ePDFObjectInteger:
+			return ((PDFInteger*)inLeft)->GetValue() == ((PDFInteger*)inRight)->GetValue();
+		case PDFObject::ePDFObjectReal:
+			return ((PDFReal*)inLeft)->GetValue() == ((PDFReal*)inRight)->GetValue();
+		case PDFObject::ePDFObjectSymbol:
+			return ((PDFSymbol*)inLeft)->GetValue() == ((PDFSymbol*)inRight)->GetValue();
+		case PDFObject::ePDFObjectIndirectObjectReference:
+			return ((PDFIndirectObjectReference*)inLeft)->mObjectID == ((PDFIndirectObjectReference*)inRight)->mObjectID &&
+					((PDFIndirectObjectReference*)inLeft)->mVersion == ((PDFIndirectObjectReference*)inRight)->mVersion;
+		case PDFObject::ePDFObjectArray:
+		{
+			PDFArray* left = (PDFArray*)inLeft;
+			PDFArray* right = (PDFArray*)inRight;
+			if(left->GetLength() != right->GetLength())
+				return false;
+			for(unsigned long i=0;i<left->GetLength();++i)
+			{
+				RefCountPtr<PDFObject> leftItem(left->QueryObject(i));
+				RefCountPtr<PDFObject> rightItem(right->QueryObject(i));
+				if(!SameObjects(leftItem.GetPtr(),rightItem.GetPtr()))
+					return false;
+			}
+			return true;
+		}
+		case PDFObject::ePDFObjectDictionary:
+		{
+			MapIterator<PDFNameToPDFObjectMap> leftIt = ((PDFDictionary*)inLeft)->GetIterator();
+			MapIterator<PDFNameToPDFObjectMap> rightIt = ((PDFDictionary*)inRight)->GetIterator();
+			bool leftHasMore = leftIt.MoveNext();
+			bool rightHasMore = rightIt.MoveNext();
+			while(leftHasMore && rightHasMore)
+			{
+				if(!SameObjects(leftIt.GetKey(),rightIt.GetKey()) || !SameObjects(leftIt.GetValue(),rightIt.GetValue()))
+					return false;
+				leftHasMore = leftIt.MoveNext();
+				rightHasMore = rightIt.MoveNext();
+			}
+			return !leftHasMore && !rightHasMore;
+		}
+		case PDFObject::ePDFObjectStream:
+		{
+			RefCountPtr<PDFDictionary> leftDictionary(((PDFStreamInput*)inLeft)->QueryStreamDictionary());
+			RefCountPtr<PDFDictionary> rightDictionary(((PDFStreamInput*)inRight)->QueryStreamDictionary());
+			return ((PDFStreamInput*)inLeft)->GetStreamContentStart() == ((PDFStreamInput*)inRight)->GetStreamContentStart() &&
+					SameObjects(leftDictionary.GetPtr(),rightDictionary.GetPtr());
+		}
+	}
+	return false;
+}
+
+EStatusCode ParseSessionTest::AppendPages(const string& inFilePath,const string& inOutputPath,bool inUseParseSessions)
+{
+	EStatusCode status;
+	PDFWriter pdfWriter;
+
+	do
+	{
+		status = pdfWriter.StartPDF(inOutputPath,ePDFVersion13);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start PDF\n";
+			break;
+		}
+
+		PDFParsingOptions options;
+		options.UseParseSessions = inUseParseSessions;
+		EStatusCodeAndObjectIDTypeList result = pdfWriter.AppendPDFPagesFromPDF(inFilePath,PDFPageRange(),ObjectIDTypeList(),options);
+		if(result.first != eSuccess)
+		{
+			cout<<"failed to append pages from "<<inFilePath.c_str()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		status = pdfWriter.EndPDF();
+		if(status != eSuccess)
+			cout<<"failed to end PDF\n";
+	}while(false);
+
+	return status;
+}
+
+EStatusCode ParseSessionTest::TestPagesCopying(const TestConfiguration& inTestConfiguration,const string& inFilePath)
+{
+	// copy with and without parse sessions, and compare the results
+	string plainPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseSessionPlain.pdf");
+	string sessionsPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseSessionSessions.pdf");
+	EStatusCode status;
+
+	do
+	{
+		status = AppendPages(inFilePath,plainPath,false);
+		if(status != eSuccess)
+			break;
+		status = AppendPages(inFilePath,sessionsPath,true);
+		if(status != eSuccess)
+			break;
+
+		InputFile plainFile,sessionsFile;
+		PDFParser plainParser,sessionsParser;
+		status = plainFile.OpenFile(plainPath);
+		if(status == eSuccess)
+			status = sessionsFile.OpenFile(sessionsPath);
+		if(status == eSuccess)
+			status = plainParser.StartPDFParsing(plainFile.GetInputStream());
+		if(status == eSuccess)
+			status = sessionsParser.StartPDFParsing(sessionsFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse copies of "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		if(plainParser.GetPagesCount() != sessionsParser.GetPagesCount() || plainParser.GetXrefSize() != sessionsParser.GetXrefSize())
+		{
+			cout<<"copying pages with parse sessions differs from copying without for "<<inFilePath.c_str()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		for(unsigned long i=0;i<plainParser.GetPagesCount() && eSuccess == status;++i)
+		{
+			RefCountPtr<PDFDictionary> plainPage(plainParser.ParsePage(i));
+			RefCountPtr<PDFDictionary> sessionsPage(sessionsParser.ParsePage(i));
+			if(!SameObjects(plainPage.GetPtr(),sessionsPage.GetPtr()))
+			{
+				cout<<"page "<<i<<" copied with parse sessions differs from copying without for "<<inFilePath.c_str()<<"\n";
+				status = eFailure;
+			}
+		}
+	}while(false);
+
+	return status;
+}
+
+EStatusCode ParseSessionTest::RunBenchmark(const TestConfiguration& inTestConfiguration,const string& inFilePath)
+{
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseSessionBenchmark.txt"),true,true);
+	TimersRegistry timers;
+	string outputPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"ParseSessionBenchmark.pdf");
+	EStatusCode status = eSuccess;
+
+	// how many separate allocations copying pages makes, vs how many blocks they take in a session
+	{
+		ParseSession session;
+		status = AppendPages(inFilePath,outputPath,false);
+		if(eSuccess == status)
+			cout<<"Copying pages of "<<inFilePath.c_str()<<" allocates "<<session.GetAllocatedObjectsCount()<<" objects, in "<<
+				session.GetAllocatedBlocksCount()<<" session blocks\n";
+	}
+
+	for(int i=0;i<2 && eSuccess == status;++i)
+	{
+		bool useSessions = (i == 1);
+		string timerName = useSessions ? "WithParseSessions" : "WithoutParseSessions";
+
+		for(int j=0;j<scBenchmarkCopiesCount && eSuccess == status;++j)
+		{
+			timers.StartMeasure(timerName);
+			status = AppendPages(inFilePath,outputPath,useSessions);
+			timers.StopMeasureAndAccumulate(timerName);
+		}
+		if(status != eSuccess)
+			break;
+		cout<<"Copying pages of "<<inFilePath.c_str()<<" "<<scBenchmarkCopiesCount<<" times, "<<(useSessions ? "with" : "without")<<" parse sessions: "<<timers.GetTotalMiliSeconds(timerName)<<"ms\n";
+	}
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(ParseSessionTest,"PDFEmbedding")
@@ -0,0 +1,195 @@
+/*
+   Source File : ParsedObjectsCacheTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "ParsedObjectsCacheTest.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFObject.h"
+#include "RefCountPtr.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace PDFHummus;
+
+ParsedObjectsCacheTest::ParsedObjectsCacheTest(void)
+{
+}
+
+ParsedObjectsCacheTest::~ParsedObjectsCacheTest(void)
+{
+}
+
+static const char* scTestFiles[] = {
+	"TestMaterials/XObjectContent.pdf",
+	"TestMaterials/ObjectStreams.pdf",
+	"TestMaterials/china.pdf",
+	NULL
+};
+
+EStatusCode ParsedObjectsCacheTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+
+	for(int i=0; scTestFiles[i] && eSuccess == status;++i)
+	{
+		string filePath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,scTestFiles[i]);
+
+		status = TestSharing(filePath);
+		if(status != eSuccess)
+			break;
+
+		status = TestEviction(filePath,eParsedObjectsCacheEvictLeastRecentlyUsed);
+		if(status != eSuccess)
+			break;
+
+		status = TestEviction(filePath,eParsedObjectsCacheEvictFirstParsed);
+		if(status != eSuccess)
+			break;
+
+		status = TestEviction(filePath,eParsedObjectsCacheEvictNone);
+	}
+
+	return status;
+}
+
+typedef vector<PDFObject*> PDFObjectVector;
+
+EStatusCode ParsedObjectsCacheTest::TestSharing(const string& inFilePath)
+{
+	EStatusCode status = eSuccess;
+	InputFile pdfFile;
+	PDFParser parser;
+	PDFParsingOptions options;
+	PDFObjectVector firstPass;
+
+	options.ParsedObjectsCacheBudget = 64*1024*1024;
+
+	do
+	{
+		if(pdfFile.OpenFile(inFilePath) != eSuccess || parser.StartPDFParsing(pdfFile.GetInputStream(),options) != eSuccess)
+		{
+			cout<<"Failed to start parsing "<<inFilePath<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		// only count what's fetched here, not the pages tree parsing
+		parser.GetParsedObjectsCache().ResetCounters();
+
+		for(ObjectIDType objectID = 0; objectID < parser.GetObjectsCount(); ++objectID)
+			firstPass.push_back(parser.ParseNewObject(objectID));
+
+		// pages tree objects were cached while starting to parse, so those should count as hits already
+		if(parser.GetParsedObjectsCache().GetHits() == 0)
+		{
+			cout<<"Unexpected counters after first pass on "<<inFilePath<<". hits = "<<parser.GetParsedObjectsCache().GetHits()<<", misses = "<<parser.GetParsedObjectsCache().GetMisses()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		parser.GetParsedObjectsCache().ResetCounters();
+		for(ObjectIDType objectID = 0; objectID < parser.GetObjectsCount() && eSuccess == status; ++objectID)
+		{
+			RefCountPtr<PDFObject> anObject(parser.ParseNewObject(objectID));
+			if(anObject.GetPtr() != firstPass[objectID])
+			{
+				cout<<"Object "<<objectID<<" in "<<inFilePath<<" was not shared from the first fetch\n";
+				status = eFailure;
+			}
+		}
+		if(status != eSuccess)
+			break;
+
+		// everything is cached now, so only free entries should be misses
+		if(parser.GetParsedObjectsCache().GetHits() != parser.GetParsedObjectsCache().GetCachedObjectsCount() || 
+			parser.GetParsedObjectsCache().GetMisses() != parser.GetObjectsCount() - parser.GetParsedObjectsCache().GetCachedObjectsCount() ||
+			parser.GetParsedObjectsCache().GetEvictions() != 0)
+		{
+			cout<<"Unexpected counters after second pass on "<<inFilePath<<". hits = "<<parser.GetParsedObjectsCache().GetHits()<<
+				", cached objects = "<<parser.GetParsedObjectsCache().GetCachedObjectsCount()<<", evictions = "<<parser.GetParsedObjectsCache().GetEvictions()<<"\n";
+			status = eFailure;
+			break;
+		}
+	}while(false);
+
+	PDFObjectVector::iterator it = firstPass.begin();
+	for(; it != firstPass.end(); ++it)
+		if(*it)
+			(*it)->Release();
+
+	return status;
+}
+
+EStatusCode ParsedObjectsCacheTest::TestEviction(const string& inFilePath,EParsedObjectsCacheEvictionPolicy inEvictionPolicy)
+{
+	InputFile uncachedFile;
+	PDFParser uncachedParser;
+	PDFParsingOptions uncachedOptions;
+	InputFile cachedFile;
+	PDFParser cachedParser;
+	PDFParsingOptions cachedOptions;
+
+	// small enough to make the cache fill up
+	cachedOptions.ParsedObjectsCacheBudget = 4096;
+	cachedOptions.ParsedObjectsCacheEvictionPolicy = inEvictionPolicy;
+
+	if(uncachedFile.OpenFile(inFilePath) != eSuccess || uncachedParser.StartPDFParsing(uncachedFile.GetInputStream(),uncachedOptions) != eSuccess ||
+		cachedFile.OpenFile(inFilePath) != eSuccess || cachedParser.StartPDFParsing(cachedFile.GetInputStream(),cachedOptions) != eSuccess)
+	{
+		cout<<"Failed to start parsing "<<inFilePath<<"\n";
+		return eFailure;
+	}
+
+	// two passes, second one getting mixed results of cached and evicted objects
+	for(int i=0; i < 2; ++i)
+	{
+		for(ObjectIDType objectID = 0; objectID < uncachedParser.GetObjectsCount(); ++objectID)
+		{
+			RefCountPtr<PDFObject> uncachedObject(uncachedParser.ParseNewObject(objectID));
+			RefCountPtr<PDFObject> cachedObject(cachedParser.ParseNewObject(objectID));
+
+			// size estimate goes over the whole object, so it's good enough for comparing the two
+			if(!uncachedObject != !cachedObject ||
+				(!!uncachedObject && ParsedObjectsCache::EstimateObjectSize(uncachedObject.GetPtr()) != ParsedObjectsCache::EstimateObjectSize(cachedObject.GetPtr())))
+			{
+				cout<<"Object "<<objectID<<" in "<<inFilePath<<" differs when parsed with a parsed objects cache, policy "<<inEvictionPolicy<<"\n";
+				return eFailure;
+			}
+
+			if(cachedParser.GetParsedObjectsCache().GetCachedSize() > cachedOptions.ParsedObjectsCacheBudget)
+			{
+				cout<<"Parsed objects cache exceeded its budget for "<<inFilePath<<", policy "<<inEvictionPolicy<<"\n";
+				return eFailure;
+			}
+		}
+	}
+
+	if((eParsedObjectsCacheEvictNone == inEvictionPolicy) != (0 == cachedParser.GetParsedObjectsCache().GetEvictions()))
+	{
+		cout<<"Unexpected evictions count for "<<inFilePath<<", policy "<<inEvictionPolicy<<". evictions = "<<cachedParser.GetParsedObjectsCache().GetEvictions()<<"\n";
+		return eFailure;
+	}
+
+	return eSuccess;
+}
+
+ADD_CATEGORIZED_TEST(ParsedObjectsCacheTest,"PDFEmbedding")
@@ -0,0 +1,356 @@
+/*
+   Source File : SharedFontsCacheTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "SharedFontsCacheTest.h"
+#include "TestFiles.h"
+#include "SharedFontsCache.h"
+#include "PDFWriter.h"
+#include "PDFPage.h"
+#include "PDFRectangle.h"
+#include "PageContentContext.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+#include "BoxingBase.h"
+
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace PDFHummus;
+
+static const int scThreadsCount = 4;
+static const int scDocumentsPerThread = 5;
+static const int scBenchmarkDocumentsCount = 50;
+
+SharedFontsCacheTest::SharedFontsCacheTest(void)
+{
+}
+
+SharedFontsCacheTest::~SharedFontsCacheTest(void)
+{
+}
+
+EStatusCode SharedFontsCacheTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = TestSameOutput(inTestConfiguration);
+
+	if(eSuccess == status)
+		status = TestFontPrograms(inTestConfiguration);
+
+	if(eSuccess == status)
+		status = TestConcurrentDocuments(inTestConfiguration);
+
+	if(eSuccess == status)
+		status = RunBenchmark(inTestConfiguration);
+
+	return status;
+}
+
+static EStatusCode StartDocument(PDFWriter& inPDFWriter,const string& inOutputFilePath,SharedFontsCache* inFontsCache,bool inCompressStreams = true)
+{
+	PDFCreationSettings creationSettings(inCompressStreams,true);
+	creationSettings.FontsCache = inFontsCache;
+
+	EStatusCode status = inPDFWriter.StartPDF(inOutputFilePath,ePDFVersion13,LogConfiguration::DefaultLogConfiguration(),creationSettings);
+	if(status != eSuccess)
+		cout<<"failed to start PDF "<<inOutputFilePath<<"\n";
+	return status;
+}
+
+// a page with text in a true type, CFF and type 1 font, and end of the document
+static EStatusCode WriteDocument(PDFWriter* inPDFWriter,const TestConfiguration* inTestConfiguration,const string& inText = "Hello World")
+{
+	EStatusCode status = eSuccess;
+	PDFPage* page = new PDFPage();
+	page->SetMediaBox(PDFRectangle(0,0,595,842));
+
+	do
+	{
+		PageContentContext* contentContext = inPDFWriter->StartPageContentContext(page);
+		if(!contentContext)
+		{
+			cout<<"failed to create content context for page\n";
+			status = eFailure;
+			break;
+		}
+
+		PDFUsedFont* fonts[] = {
+			inPDFWriter->GetFontForFile(RelativeURLToLocalPath(inTestConfiguration->mSampleFileBase,"TestMaterials/fonts/arial.ttf")),
+			inPDFWriter->GetFontForFile(RelativeURLToLocalPath(inTestConfiguration->mSampleFileBase,"TestMaterials/fonts/BrushScriptStd.otf")),
+			inPDFWriter->GetFontForFile(RelativeURLToLocalPath(inTestConfiguration->mSampleFileBase,"TestMaterials/fonts/HLB_____.PFB"),
+										RelativeURLToLocalPath(inTestConfiguration->mSampleFileBase,"TestMaterials/fonts/HLB_____.PFM"))
+		};
+
+		contentContext->BT();
+		for(size_t i=0;i<sizeof(fonts)/sizeof(PDFUsedFont*) && eSuccess == status;++i)
+		{
+			if(!fonts[i])
+			{
+				cout<<"failed to create font object "<<i<<"\n";
+				status = eFailure;
+				break;
+			}
+			contentContext->Tf(fonts[i],30);
+			contentContext->Tm(1,0,0,1,50,700 - 50*(double)i);
+			status = contentContext->Tj(inText);
+			if(status != eSuccess)
+				cout<<"failed to write text with font "<<i<<"\n";
+		}
+		contentContext->ET();
+		if(status != eSuccess)
+			break;
+
+		status = inPDFWriter->EndPageContentContext(contentContext);
+		if(status != eSuccess)
+		{
+			cout<<"failed to end page content context\n";
+			break;
+		}
+
+		status = inPDFWriter->WritePageAndRelease(page);
+		page = NULL;
+		if(status != eSuccess)
+		{
+			cout<<"failed to write page\n";
+			break;
+		}
+
+		status = inPDFWriter->EndPDF();
+		if(status != eSuccess)
+			cout<<"failed to end PDF\n";
+	}while(false);
+
+	delete page;
+	return status;
+}
+
+EStatusCode SharedFontsCacheTest::TestSameOutput(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+	SharedFontsCache fontsCache;
+	const char* outputs[] = {"SharedFontsCacheNoCache.pdf","SharedFontsCacheFirst.pdf","SharedFontsCacheSecond.pdf"};
+
+	// one document loading its own fonts, and two getting them from the cache. the second reuses what the first loaded
+	for(int i=0;i<3 && eSuccess == status;++i)
+	{
+		PDFWriter pdfWriter;
+		status = StartDocument(pdfWriter,RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,outputs[i]),i == 0 ? NULL : &fontsCache);
+		if(eSuccess == status)
+			status = WriteDocument(&pdfWriter,&inTestConfiguration);
+	}
+	if(status != eSuccess)
+		return status;
+
+	string withoutCache = ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,outputs[0]));
+	for(int i=1;i<3 && eSuccess == status;++i)
+	{
+		if(ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,outputs[i])) != withoutCache)
+		{
+			cout<<outputs[i]<<" is different than the document written without a cache\n";
+			status = eFailure;
+		}
+	}
+
+	// three faces loaded once and reused once, true type and CFF files read once, and the true type font parsed once.
+	// the three font programs are subset once, and the second document writes them from the cache
+	if(eSuccess == status &&
+		(fontsCache.GetLoadedFacesCount() != 3 || fontsCache.GetReusedFacesCount() != 3 ||
+		fontsCache.GetReadFontFilesCount() != 2 || fontsCache.GetParsedFontsCount() != 1 ||
+		fontsCache.GetKeptFontProgramsCount() != 3 || fontsCache.GetReusedFontProgramsCount() != 3))
+	{
+		cout<<"unexpected cache use. loaded faces "<<fontsCache.GetLoadedFacesCount()<<", reused faces "<<fontsCache.GetReusedFacesCount()<<
+			", read files "<<fontsCache.GetReadFontFilesCount()<<", parsed fonts "<<fontsCache.GetParsedFontsCount()<<
+			", kept font programs "<<fontsCache.GetKeptFontProgramsCount()<<", reused font programs "<<fontsCache.GetReusedFontProgramsCount()<<"\n";
+		status = eFailure;
+	}
+
+	return status;
+}
+
+static EStatusCode WriteDocumentToFile(const TestConfiguration& inTestConfiguration,const string& inFileName,SharedFontsCache* inFontsCache,
+											bool inCompressStreams,const string& inText)
+{
+	PDFWriter pdfWriter;
+	EStatusCode status = StartDocument(pdfWriter,RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,inFileName),inFontsCache,inCompressStreams);
+	if(eSuccess == status)
+		status = WriteDocument(&pdfWriter,&inTestConfiguration,inText);
+	return status;
+}
+
+EStatusCode SharedFontsCacheTest::TestFontPrograms(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+	SharedFontsCache fontsCache;
+	const string texts[] = {"Hello World","Hello"};
+
+	// documents with different glyphs and compression share the cache. font programs are kept once per glyphs set, and reused by documents
+	// with either compression. each document is the same as one written without a cache
+	for(int i=0;i<2 && eSuccess == status;++i)
+	{
+		for(int j=0;j<2 && eSuccess == status;++j)
+		{
+			bool compressStreams = (0 == j);
+			string suffix = Int(i).ToString() + (compressStreams ? "Compressed.pdf" : "Uncompressed.pdf");
+
+			status = WriteDocumentToFile(inTestConfiguration,"SharedFontsCacheProgramsNoCache" + suffix,NULL,compressStreams,texts[i]);
+			if(eSuccess == status)
+				status = WriteDocumentToFile(inTestConfiguration,"SharedFontsCachePrograms" + suffix,&fontsCache,compressStreams,texts[i]);
+			if(eSuccess == status &&
+				ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"SharedFontsCachePrograms" + suffix)) !=
+				ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"SharedFontsCacheProgramsNoCache" + suffix)))
+			{
+				cout<<"SharedFontsCachePrograms"<<suffix<<" is different than the document written without a cache\n";
+				status = eFailure;
+			}
+		}
+	}
+
+	if(eSuccess == status && (fontsCache.GetKeptFontProgramsCount() != 6 || fontsCache.GetReusedFontProgramsCount() != 6))
+	{
+		cout<<"unexpected font programs cache use. kept font programs "<<fontsCache.GetKeptFontProgramsCount()<<
+			", reused font programs "<<fontsCache.GetReusedFontProgramsCount()<<"\n";
+		status = eFailure;
+	}
+
+	// with no room for programs, they are written but not kept
+	fontsCache.SetFontProgramsSizeLimit(0);
+	if(eSuccess == status)
+		status = WriteDocumentToFile(inTestConfiguration,"SharedFontsCacheProgramsNoRoom.pdf",&fontsCache,true,texts[0]);
+	if(eSuccess == status &&
+		ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"SharedFontsCacheProgramsNoRoom.pdf")) !=
+		ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"SharedFontsCacheProgramsNoCache0Compressed.pdf")))
+	{
+		cout<<"SharedFontsCacheProgramsNoRoom.pdf is different than the document written without a cache\n";
+		status = eFailure;
+	}
+	if(eSuccess == status && (fontsCache.GetKeptFontProgramsCount() != 6 || fontsCache.GetReusedFontProgramsCount() != 6))
+	{
+		cout<<"unexpected font programs cache use with no room. kept font programs "<<fontsCache.GetKeptFontProgramsCount()<<
+			", reused font programs "<<fontsCache.GetReusedFontProgramsCount()<<"\n";
+		status = eFailure;
+	}
+
+	return status;
+}
+
+static void WriteDocuments(vector<PDFWriter*>* inPDFWriters,const TestConfiguration* inTestConfiguration,EStatusCode* outStatus)
+{
+	*outStatus = eSuccess;
+	for(vector<PDFWriter*>::iterator it = inPDFWriters->begin(); it != inPDFWriters->end() && eSuccess == *outStatus; ++it)
+		*outStatus = WriteDocument(*it,inTestConfiguration);
+}
+
+EStatusCode SharedFontsCacheTest::TestConcurrentDocuments(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+	SharedFontsCache fontsCache;
+	vector<PDFWriter*> pdfWriters[scThreadsCount];
+	EStatusCode threadsStatus[scThreadsCount];
+
+	// documents are started here, as starting sets up the [process wide] log. the pages and fonts are then written by the threads
+	for(int i=0;i<scThreadsCount && eSuccess == status;++i)
+	{
+		for(int j=0;j<scDocumentsPerThread && eSuccess == status;++j)
+		{
+			PDFWriter* pdfWriter = new PDFWriter();
+			pdfWriters[i].push_back(pdfWriter);
+			status = StartDocument(*pdfWriter,RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,
+				"SharedFontsCacheThread" + Int(i).ToString() + "_" + Int(j).ToString() + ".pdf"),&fontsCache);
+		}
+	}
+
+	if(eSuccess == status)
+	{
+		vector<thread> threads;
+		for(int i=0;i<scThreadsCount;++i)
+			threads.push_back(thread(WriteDocuments,&pdfWriters[i],&inTestConfiguration,&threadsStatus[i]));
+		for(vector<thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+			it->join();
+
+		for(int i=0;i<scThreadsCount && eSuccess == status;++i)
+			status = threadsStatus[i];
+	}
+
+	string expected = ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"SharedFontsCacheNoCache.pdf"));
+	for(int i=0;i<scThreadsCount && eSuccess == status;++i)
+	{
+		if(ReadFileWithoutID(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"SharedFontsCacheThread" + Int(i).ToString() + "_0.pdf")) != expected)
+		{
+			cout<<"document written on thread "<<i<<" is different than the document written without a cache\n";
+			status = eFailure;
+		}
+	}
+
+	// at most a face per font per thread is loaded, and all the rest are reused
+	if(eSuccess == status &&
+		(fontsCache.GetLoadedFacesCount() > 3*scThreadsCount ||
+		fontsCache.GetLoadedFacesCount() + fontsCache.GetReusedFacesCount() != 3*scThreadsCount*scDocumentsPerThread ||
+		fontsCache.GetParsedFontsCount() != 1))
+	{
+		cout<<"unexpected cache use with threads. loaded faces "<<fontsCache.GetLoadedFacesCount()<<", reused faces "<<fontsCache.GetReusedFacesCount()<<
+			", parsed fonts "<<fontsCache.GetParsedFontsCount()<<"\n";
+		status = eFailure;
+	}
+
+	for(int i=0;i<scThreadsCount;++i)
+		for(vector<PDFWriter*>::iterator it = pdfWriters[i].begin(); it != pdfWriters[i].end(); ++it)
+			delete *it;
+
+	return status;
+}
+
+EStatusCode SharedFontsCacheTest::RunBenchmark(const TestConfiguration& inTestConfiguration)
+{
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"SharedFontsCacheBenchmark.txt"),true,true);
+	TimersRegistry timers;
+	EStatusCode status = eSuccess;
+	SharedFontsCache fontsCache;
+	SharedFontsCache fontsCacheNoPrograms;
+	fontsCacheNoPrograms.SetFontProgramsSizeLimit(0);
+
+	// many short documents with the same fonts, as a server creating documents would. with a cache keeping only the
+	// loaded fonts, and with one keeping the subset font programs as well
+	const char* timerNames[] = {"NoCache","CacheNoPrograms","Cache"};
+	SharedFontsCache* fontsCaches[] = {NULL,&fontsCacheNoPrograms,&fontsCache};
+	for(int j=0;j<3 && eSuccess == status;++j)
+	{
+		timers.StartMeasure(timerNames[j]);
+		for(int i=0;i<scBenchmarkDocumentsCount && eSuccess == status;++i)
+		{
+			PDFWriter pdfWriter;
+			status = StartDocument(pdfWriter,RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"SharedFontsCacheBenchmark.pdf"),fontsCaches[j]);
+			if(eSuccess == status)
+				status = WriteDocument(&pdfWriter,&inTestConfiguration);
+		}
+		timers.StopMeasureAndAccumulate(timerNames[j]);
+	}
+
+	cout<<"Writing "<<scBenchmarkDocumentsCount<<" documents with 3 fonts. without fonts cache: "<<timers.GetTotalMiliSeconds("NoCache")<<
+		"ms, with fonts cache keeping no font programs: "<<timers.GetTotalMiliSeconds("CacheNoPrograms")<<
+		"ms, with fonts cache: "<<timers.GetTotalMiliSeconds("Cache")<<"ms\n";
+
+	timers.TraceAndReleaseAll();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(SharedFontsCacheTest,"Text")
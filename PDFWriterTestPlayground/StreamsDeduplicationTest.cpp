@@ -0,0 +1,245 @@
+/*
+   Source File : StreamsDeduplicationTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "StreamsDeduplicationTest.h"
+#include "PDFWriter.h"
+#include "PDFPage.h"
+#include "PDFRectangle.h"
+#include "PageContentContext.h"
+#include "PDFImageXObject.h"
+#include "PDFFormXObject.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFDictionary.h"
+#include "PDFObjectCast.h"
+#include "PDFIndirectObjectReference.h"
+#include "RefCountPtr.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace PDFHummus;
+
+StreamsDeduplicationTest::StreamsDeduplicationTest(void)
+{
+}
+
+StreamsDeduplicationTest::~StreamsDeduplicationTest(void)
+{
+}
+
+static const int scPagesCount = 10;
+
+EStatusCode StreamsDeduplicationTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status;
+	string plainPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"StreamsDeduplicationPlain.pdf");
+	string deduplicatedPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"StreamsDeduplication.pdf");
+
+	do
+	{
+		status = WriteDocument(inTestConfiguration,plainPath,false);
+		if(status != eSuccess)
+		{
+			cout<<"failed to write document without streams deduplication\n";
+			break;
+		}
+
+		status = WriteDocument(inTestConfiguration,deduplicatedPath,true);
+		if(status != eSuccess)
+		{
+			cout<<"failed to write document with streams deduplication\n";
+			break;
+		}
+
+		status = CheckDocument(deduplicatedPath);
+		if(status != eSuccess)
+			break;
+
+		// the same images are placed on every page, so the deduplicated file should hold just one copy of them
+		InputFile plainFile,deduplicatedFile;
+		plainFile.OpenFile(plainPath);
+		deduplicatedFile.OpenFile(deduplicatedPath);
+		LongFilePositionType plainSize = plainFile.GetFileSize();
+		LongFilePositionType deduplicatedSize = deduplicatedFile.GetFileSize();
+		if(deduplicatedSize * (scPagesCount/2) > plainSize)
+		{
+			cout<<"deduplicated file is not small enough. plain file size is "<<plainSize<<", deduplicated file size is "<<deduplicatedSize<<"\n";
+			status = eFailure;
+			break;
+		}
+	}while(false);
+
+	return status;
+}
+
+EStatusCode StreamsDeduplicationTest::WriteDocument(const TestConfiguration& inTestConfiguration,const string& inOutputPath,bool inDeduplicateStreams)
+{
+	EStatusCode status;
+	PDFWriter pdfWriter;
+	PDFCreationSettings creationSettings(true,true);
+	creationSettings.DeduplicateStreams = inDeduplicateStreams;
+
+	do
+	{
+		status = pdfWriter.StartPDF(inOutputPath,ePDFVersion14,LogConfiguration::DefaultLogConfiguration(),creationSettings);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start PDF\n";
+			break;
+		}
+
+		for(int i=0;i<scPagesCount && eSuccess == status;++i)
+		{
+			PDFPage* page = new PDFPage();
+			page->SetMediaBox(PDFRectangle(0,0,595,842));
+
+			// image objects are recreated per page, as a naive user would
+			PDFImageXObject* jpgImage = pdfWriter.CreateImageXObjectFromJPGFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"TestMaterials/images/otherStage.JPG"));
+			if(!jpgImage)
+			{
+				cout<<"failed to create image xobject from otherStage.JPG\n";
+				status = eFailure;
+				delete page;
+				break;
+			}
+
+#ifndef PDFHUMMUS_NO_PNG
+			PDFFormXObject* pngForm = pdfWriter.CreateFormXObjectFromPNGFile(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"TestMaterials/images/png/original_transparent.png"));
+			if(!pngForm)
+			{
+				cout<<"failed to create form xobject from original_transparent.png\n";
+				status = eFailure;
+				delete jpgImage;
+				delete page;
+				break;
+			}
+#endif
+
+			PageContentContext* contentContext = pdfWriter.StartPageContentContext(page);
+
+			contentContext->q();
+			contentContext->cm(0.2,0,0,0.2,10,400);
+			contentContext->Do(page->GetResourcesDictionary().AddImageXObjectMapping(jpgImage));
+			contentContext->Q();
+			delete jpgImage;
+
+#ifndef PDFHUMMUS_NO_PNG
+			contentContext->q();
+			contentContext->cm(1,0,0,1,10,10);
+			contentContext->Do(page->GetResourcesDictionary().AddFormXObjectMapping(pngForm->GetObjectID()));
+			contentContext->Q();
+			delete pngForm;
+#endif
+
+			status = pdfWriter.EndPageContentContext(contentContext);
+			if(status != eSuccess)
+			{
+				cout<<"failed to end page content context\n";
+				delete page;
+				break;
+			}
+
+			status = pdfWriter.WritePageAndRelease(page);
+			if(status != eSuccess)
+				cout<<"failed to write page\n";
+		}
+		if(status != eSuccess)
+			break;
+
+		status = pdfWriter.EndPDF();
+		if(status != eSuccess)
+			cout<<"failed to end PDF\n";
+	}while(false);
+
+	return status;
+}
+
+EStatusCode StreamsDeduplicationTest::CheckDocument(const string& inFilePath)
+{
+	EStatusCode status;
+	InputFile pdfFile;
+	PDFParser parser;
+
+	do
+	{
+		status = pdfFile.OpenFile(inFilePath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		status = parser.StartPDFParsing(pdfFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inFilePath.c_str()<<"\n";
+			break;
+		}
+
+		if(parser.GetPagesCount() != scPagesCount)
+		{
+			cout<<"wrong pages count. expected "<<scPagesCount<<" got "<<parser.GetPagesCount()<<"\n";
+			status = eFailure;
+			break;
+		}
+
+		// all pages should point at the very same image object
+		ObjectIDType firstImageID = 0;
+		for(unsigned long i=0;i<parser.GetPagesCount() && eSuccess == status;++i)
+		{
+			RefCountPtr<PDFDictionary> page(parser.ParsePage(i));
+			PDFObjectCastPtr<PDFDictionary> resources(parser.QueryDictionaryObject(page.GetPtr(),"Resources"));
+			PDFObjectCastPtr<PDFDictionary> xobjects(!resources ? NULL : parser.QueryDictionaryObject(resources.GetPtr(),"XObject"));
+			if(!xobjects)
+			{
+				cout<<"missing xobjects dictionary in page "<<i<<"\n";
+				status = eFailure;
+				break;
+			}
+
+			MapIterator<PDFNameToPDFObjectMap> it = xobjects->GetIterator();
+			while(it.MoveNext())
+			{
+				if(it.GetKey()->GetValue().compare(0,2,"Im") != 0)
+					continue;
+				PDFObjectCastPtr<PDFIndirectObjectReference> imageReference(it.GetValue());
+				if(!imageReference)
+				{
+					cout<<"image in page "<<i<<" is not an indirect reference\n";
+					status = eFailure;
+					break;
+				}
+				if(0 == firstImageID)
+					firstImageID = imageReference->mObjectID;
+				else if(imageReference->mObjectID != firstImageID)
+				{
+					cout<<"image in page "<<i<<" was not deduplicated. expected object "<<firstImageID<<" got "<<imageReference->mObjectID<<"\n";
+					status = eFailure;
+					break;
+				}
+			}
+		}
+	}while(false);
+
+	return status;
+}
+
+ADD_CATEGORIZED_TEST(StreamsDeduplicationTest,"PDF")
@@ -0,0 +1,108 @@
+/*
+   Source File : TestFiles.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "TestFiles.h"
+#include "PDFWriter.h"
+#include "PDFPage.h"
+#include "PDFRectangle.h"
+#include "PageContentContext.h"
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+
+using namespace std;
+using namespace PDFHummus;
+
+EStatusCode WriteManyPagesDocument(const string& inOutputPath,unsigned long inPagesCount,bool inWithContent)
+{
+	EStatusCode status;
+	PDFWriter pdfWriter;
+
+	do
+	{
+		status = pdfWriter.StartPDF(inOutputPath,ePDFVersion13);
+		if(status != eSuccess)
+		{
+			cout<<"failed to start PDF\n";
+			break;
+		}
+
+		for(unsigned long i=0;i<inPagesCount && eSuccess == status;++i)
+		{
+			PDFPage* page = new PDFPage();
+			page->SetMediaBox(PDFRectangle(0,0,595,842));
+
+			if(inWithContent)
+			{
+				PageContentContext* contentContext = pdfWriter.StartPageContentContext(page);
+				for(unsigned long j=0;j<(i%50)+50;++j)
+				{
+					contentContext->k((j%4)*25,0,0,0);
+					contentContext->re((double)(j%20)*25,(double)(j/20)*25,20,20);
+					contentContext->f();
+				}
+				status = pdfWriter.EndPageContentContext(contentContext);
+				if(status != eSuccess)
+				{
+					cout<<"failed to end content of page "<<i<<"\n";
+					delete page;
+					break;
+				}
+			}
+
+			status = pdfWriter.WritePageAndRelease(page);
+			if(status != eSuccess)
+				cout<<"failed to write page "<<i<<"\n";
+		}
+		if(status != eSuccess)
+			break;
+
+		status = pdfWriter.EndPDF();
+		if(status != eSuccess)
+			cout<<"failed to end PDF\n";
+	}while(false);
+
+	return status;
+}
+
+bool ReadFile(const string& inFilePath,string& outContent)
+{
+	ifstream file(inFilePath.c_str(),ios::binary);
+	if(!file)
+		return false;
+	outContent.assign(istreambuf_iterator<char>(file),istreambuf_iterator<char>());
+	return true;
+}
+
+string ReadFileWithoutID(const string& inFilePath)
+{
+	string content;
+	if(!ReadFile(inFilePath,content))
+		return content;
+
+	string::size_type idStart = content.rfind("/ID");
+	if(idStart != string::npos)
+	{
+		string::size_type idEnd = content.find(']',idStart);
+		content.erase(idStart,idEnd == string::npos ? string::npos : idEnd - idStart);
+	}
+	return content;
+}
@@ -0,0 +1,40 @@
+/*
+   Source File : TestFiles.h
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#pragma once
+
+#include "EStatusCode.h"
+
+#include <string>
+
+/*
+	Files that several tests write or read
+*/
+
+// writes a document with inPagesCount pages. the pages are empty, unless inWithContent, in which case they have some
+// filled rectangles, more on some pages than others
+PDFHummus::EStatusCode WriteManyPagesDocument(const std::string& inOutputPath,unsigned long inPagesCount,bool inWithContent);
+
+// reads the whole file into outContent. returns false if the file can't be opened
+bool ReadFile(const std::string& inFilePath,std::string& outContent);
+
+// the content of a written document without its trailer ID, which is different per writing. for comparing documents
+// that are expected to be written the same. empty if the file can't be opened
+std::string ReadFileWithoutID(const std::string& inFilePath);
@@ -0,0 +1,279 @@
+/*
+   Source File : XrefReconstructionTest.cpp
+
+
+   Copyright 2011 Gal Kahana PDFWriter
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+   
+*/
+#include "XrefReconstructionTest.h"
+#include "TestFiles.h"
+#include "InputFile.h"
+#include "PDFParser.h"
+#include "PDFDictionary.h"
+#include "RefCountPtr.h"
+#include "XrefReconstructionScanner.h"
+#include "Trace.h"
+#include "TimersRegistry.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using namespace PDFHummus;
+
+XrefReconstructionTest::XrefReconstructionTest(void)
+{
+}
+
+XrefReconstructionTest::~XrefReconstructionTest(void)
+{
+}
+
+EStatusCode XrefReconstructionTest::Run(const TestConfiguration& inTestConfiguration)
+{
+	EStatusCode status = eSuccess;
+
+	const char* materials[] = {
+		"Original.pdf",
+		"AddedPage.pdf",
+		"ObjectStreams.pdf",
+		"XObjectContent.pdf"
+	};
+
+	for(size_t i=0;i<sizeof(materials)/sizeof(const char*) && eSuccess == status;++i)
+		status = TestDamagedCopies(inTestConfiguration,materials[i]);
+	if(status != eSuccess)
+		return status;
+
+	Singleton<Trace>::GetInstance()->SetLogSettings(RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,"XrefReconstructionBenchmark.txt"),true,true);
+	status = TestParallelScan();
+	Singleton<Trace>::Reset();
+
+	return status;
+}
+
+static bool WriteFileContent(const string& inFilePath,const string& inContent)
+{
+	ofstream file(inFilePath.c_str(),ios::binary);
+	if(!file)
+		return false;
+	file.write(inContent.c_str(),inContent.size());
+	return !!file;
+}
+
+EStatusCode XrefReconstructionTest::TestDamagedCopies(const TestConfiguration& inTestConfiguration,const string& inMaterialName)
+{
+	string originalPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,string("TestMaterials/") + inMaterialName);
+	string content;
+	if(!ReadFile(originalPath,content))
+	{
+		cout<<"failed to read "<<originalPath.c_str()<<"\n";
+		return eFailure;
+	}
+
+	size_t startxrefPosition = content.rfind("startxref");
+	if(string::npos == startxrefPosition)
+	{
+		cout<<"no startxref in "<<originalPath.c_str()<<"\n";
+		return eFailure;
+	}
+
+	// 1. startxref pointing beyond the file
+	string badStartxref = content;
+	for(size_t i = startxrefPosition + 9; i < badStartxref.size() && badStartxref[i] != '%'; ++i)
+		if(badStartxref[i] >= '0' && badStartxref[i] <= '9')
+			badStartxref[i] = '9';
+
+	// 2. file cut at the last startxref
+	string truncated = content.substr(0,startxrefPosition);
+
+	// 3. junk added after the header, so all offsets are wrong
+	string shifted = content;
+	shifted.insert(shifted.find('\n') + 1,"% some junk that pushes all objects away from where the xref expects them\n");
+
+	// 4. trailers without a Root, so that the catalog has to be found by its type
+	string noRoot = content;
+	for(size_t position = noRoot.find("/Root"); position != string::npos; position = noRoot.find("/Root",position))
+		noRoot.replace(position,5,"/Rout");
+
+	const char* damageNames[] = {"BadStartxref","Truncated","Shifted","NoRoot"};
+	const string* damagedContents[] = {&badStartxref,&truncated,&shifted,&noRoot};
+
+	EStatusCode status = eSuccess;
+	for(size_t i=0;i<4 && eSuccess == status;++i)
+	{
+		// a truncated incrementally updated file is still readable, as its previous version
+		if(damagedContents[i] == &truncated && content.rfind("%%EOF",startxrefPosition) != string::npos)
+			continue;
+
+		string damagedPath = RelativeURLToLocalPath(inTestConfiguration.mSampleFileBase,string("XrefReconstruction") + damageNames[i] + inMaterialName);
+		if(!WriteFileContent(damagedPath,*damagedContents[i]))
+		{
+			cout<<"failed to write "<<damagedPath.c_str()<<"\n";
+			return eFailure;
+		}
+
+		status = CompareWithOriginal(originalPath,damagedPath);
+	}
+	return status;
+}
+
+EStatusCode XrefReconstructionTest::CompareWithOriginal(const string& inOriginalPath,const string& inDamagedPath)
+{
+	EStatusCode status = eSuccess;
+	InputFile originalFile;
+	PDFParser originalParser;
+
+	do
+	{
+		status = originalFile.OpenFile(inOriginalPath);
+		if(status != eSuccess)
+		{
+			cout<<"failed to open "<<inOriginalPath.c_str()<<"\n";
+			break;
+		}
+		status = originalParser.StartPDFParsing(originalFile.GetInputStream());
+		if(status != eSuccess)
+		{
+			cout<<"failed to parse "<<inOriginalPath.c_str()<<"\n";
+			break;
+		}
+
+		// without reconstruction the damaged file can't be parsed
+		{
+			InputFile damagedFile;
+			PDFParser damagedParser;
+			damagedFile.OpenFile(inDamagedPath);
+			if(damagedParser.StartPDFParsing(damagedFile.GetInputStream()) == eSuccess)
+			{
+				cout<<"expected parsing of "<<inDamagedPath.c_str()<<" to fail without xref reconstruction\n";
+				status = eFailure;
+				break;
+			}
+		}
+
+		// with it, it should look the same as the original, when scanning a memory mapped file or a regular one, with one or more threads
+		for(int i=0;i<3 && eSuccess == status;++i)
+		{
+			InputFile damagedFile;
+			PDFParser damagedParser;
+			PDFParsingOptions options;
+			options.ReconstructBrokenXref = true;
+			options.XrefReconstructionThreads = (i == 2) ? 4 : 1;
+
+			status = damagedFile.OpenFile(inDamagedPath,i != 0);
+			if(status != eSuccess)
+			{
+				cout<<"failed to open "<<inDamagedPath.c_str()<<"\n";
+				break;
+			}
+			status = damagedParser.StartPDFParsing(damagedFile.GetInputStream(),options);
+			if(status != eSuccess || !damagedParser.IsXrefReconstructed())
+			{
+				cout<<"failed to parse "<<inDamagedPath.c_str()<<" with xref reconstruction\n";
+				status = eFailure;
+				break;
+			}
+
+			if(damagedParser.GetPagesCount() != originalParser.GetPagesCount())
+			{
+				cout<<"pages count mismatch for "<<inDamagedPath.c_str()<<", expected "<<originalParser.GetPagesCount()<<" got "<<damagedParser.GetPagesCount()<<"\n";
+				status = eFailure;
+				break;
+			}
+
+			for(unsigned long j=0;j<originalParser.GetPagesCount() && eSuccess == status;++j)
+			{
+				RefCountPtr<PDFDictionary> page(damagedParser.ParsePage(j));
+				if(!page || damagedParser.GetPageObjectID(j) != originalParser.GetPageObjectID(j))
+				{
+					cout<<"page "<<j<<" mismatch for "<<inDamagedPath.c_str()<<"\n";
+					status = eFailure;
+				}
+			}
+		}
+	}while(false);
+
+	return status;
+}
+
+static bool AreSameResults(const XrefReconstructionScanResults& inLeft,const XrefReconstructionScanResults& inRight)
+{
+	if(inLeft.mObjectHeaders.size() != inRight.mObjectHeaders.size())
+		return false;
+	for(size_t i=0;i<inLeft.mObjectHeaders.size();++i)
+		if(inLeft.mObjectHeaders[i].mObjectID != inRight.mObjectHeaders[i].mObjectID ||
+			inLeft.mObjectHeaders[i].mGeneration != inRight.mObjectHeaders[i].mGeneration ||
+			inLeft.mObjectHeaders[i].mPosition != inRight.mObjectHeaders[i].mPosition)
+			return false;
+	return	inLeft.mTrailers == inRight.mTrailers &&
+			inLeft.mXrefStreamMarkers == inRight.mXrefStreamMarkers &&
+			inLeft.mObjectStreamMarkers == inRight.mObjectStreamMarkers &&
+			inLeft.mCatalogMarkers == inRight.mCatalogMarkers;
+}
+
+static const unsigned long scScannedObjectsCount = 500000;
+
+EStatusCode XrefReconstructionTest::TestParallelScan()
+{
+	// objects of varying sizes, so that some of them cross the chunks boundaries, with markers spread between them
+	string content = "%PDF-1.7\n";
+	for(unsigned long i=1;i<=scScannedObjectsCount;++i)
+	{
+		stringstream object;
+		object<<i<<" "<<(i%3)<<" obj\n<< /Type "<<((i%1000 == 0) ? "/ObjStm" : ((i%777 == 0) ? "/XRef" : "/Page"))<<" /Length "<<(i%50)<<" >>\nendobj\n";
+		if(i%10000 == 0)
+			object<<"trailer\n<< /Root 1 0 R >>\n";
+		content.append(object.str());
+	}
+
+	TimersRegistry timers;
+	XrefReconstructionScanResults singleThreadResults;
+	XrefReconstructionScanner singleThreadScanner;
+	singleThreadScanner.SetThreadsCount(1);
+	timers.StartMeasure("SingleThreadScan");
+	singleThreadScanner.Scan((const IOBasicTypes::Byte*)content.c_str(),content.size(),singleThreadResults);
+	timers.StopMeasureAndAccumulate("SingleThreadScan");
+
+	if(singleThreadResults.mObjectHeaders.size() != scScannedObjectsCount ||
+		singleThreadResults.mTrailers.size() != scScannedObjectsCount/10000 ||
+		singleThreadResults.mObjectStreamMarkers.size() != scScannedObjectsCount/1000)
+	{
+		cout<<"unexpected scan results, found "<<singleThreadResults.mObjectHeaders.size()<<" objects and "<<singleThreadResults.mTrailers.size()<<" trailers\n";
+		return eFailure;
+	}
+
+	XrefReconstructionScanResults multiThreadResults;
+	XrefReconstructionScanner multiThreadScanner;
+	multiThreadScanner.SetThreadsCount(4);
+	timers.StartMeasure("MultiThreadScan");
+	multiThreadScanner.Scan((const IOBasicTypes::Byte*)content.c_str(),content.size(),multiThreadResults);
+	timers.StopMeasureAndAccumulate("MultiThreadScan");
+
+	if(!AreSameResults(singleThreadResults,multiThreadResults))
+	{
+		cout<<"scanning with multiple threads has different results than with a single thread\n";
+		return eFailure;
+	}
+
+	cout<<"Scanning "<<content.size()<<" bytes, 1 thread: "<<timers.GetTotalMiliSeconds("SingleThreadScan")<<"ms, 4 threads: "<<timers.GetTotalMiliSeconds("MultiThreadScan")<<"ms\n";
+	timers.TraceAndReleaseAll();
+
+	return eSuccess;
+}
+
+ADD_CATEGORIZED_TEST(XrefReconstructionTest,"Parsing")